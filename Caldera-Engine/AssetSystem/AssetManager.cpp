@@ -11,6 +11,7 @@ bool AssetManager::LoadModel(const std::string& path) {
     // TODO: Implement actual model loading (e.g., using Assimp)
     Mesh mesh;
     // Load mesh data here...
+    mesh.BuildBvh();
 
     loadedMeshes[path] = std::move(mesh);
     std::cout << "Loaded model: " << path << std::endl;
@@ -1,22 +1,20 @@
 #include "Mesh.h"
+#include "../Rendering/GpuMemory.h"
 #include <cassert>
 
-void Mesh::UploadToGPU(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList) {
-    assert(device && "Device is null");
+void Mesh::UploadToGPU(GpuMemory& memory, ID3D12GraphicsCommandList* cmdList) {
     assert(cmdList && "Command list is null");
 
     if (vertices.empty() || indices.empty()) {
         return;
     }
 
+    // Re-uploading replaces the previous buffers
+    ReleaseGPU(memory);
+
     // Create vertex buffer
     const UINT vbSize = static_cast<UINT>(vertices.size() * sizeof(Vertex));
 
-    D3D12_HEAP_PROPERTIES heapProps = {};
-    heapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
-    heapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-    heapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-
     D3D12_RESOURCE_DESC resourceDesc = {};
     resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
     resourceDesc.Width = vbSize;
@@ -27,13 +25,12 @@ void Mesh::UploadToGPU(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList)
     resourceDesc.SampleDesc.Count = 1;
     resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
 
-    HRESULT hr = device->CreateCommittedResource(
-        &heapProps,
-        D3D12_HEAP_FLAG_NONE,
+    HRESULT hr = memory.CreateResource(
+        D3D12_HEAP_TYPE_UPLOAD,
         &resourceDesc,
         D3D12_RESOURCE_STATE_GENERIC_READ,
         nullptr,
-        IID_PPV_ARGS(&vertexBuffer)
+        vertexBuffer
     );
     assert(SUCCEEDED(hr) && "Failed to create vertex buffer");
 
@@ -54,13 +51,12 @@ void Mesh::UploadToGPU(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList)
 
     resourceDesc.Width = ibSize;
 
-    hr = device->CreateCommittedResource(
-        &heapProps,
-        D3D12_HEAP_FLAG_NONE,
+    hr = memory.CreateResource(
+        D3D12_HEAP_TYPE_UPLOAD,
         &resourceDesc,
         D3D12_RESOURCE_STATE_GENERIC_READ,
         nullptr,
-        IID_PPV_ARGS(&indexBuffer)
+        indexBuffer
     );
     assert(SUCCEEDED(hr) && "Failed to create index buffer");
 
@@ -74,4 +70,20 @@ void Mesh::UploadToGPU(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList)
     ibView.BufferLocation = indexBuffer->GetGPUVirtualAddress();
     ibView.Format = DXGI_FORMAT_R32_UINT;
     ibView.SizeInBytes = ibSize;
-}
\ No newline at end of file
+}
+
+void Mesh::ReleaseGPU(GpuMemory& memory) {
+    memory.ReleaseResource(vertexBuffer);
+    memory.ReleaseResource(indexBuffer);
+}
+
+void Mesh::BuildBvh() {
+    if (vertices.empty() || indices.empty()) {
+        bvh.Clear();
+        return;
+    }
+    // Bad indices leave the hierarchy empty rather than reading past the vertices
+    if (!bvh.Build(&vertices[0].position.x, sizeof(Vertex), static_cast<uint32_t>(vertices.size()),
+            indices.data(), static_cast<uint32_t>(indices.size())))
+        assert(false && "Mesh index out of range");
+}
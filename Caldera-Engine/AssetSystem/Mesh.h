@@ -4,6 +4,9 @@
 #include <DirectXMath.h>
 #include <d3d12.h>
 #include <wrl/client.h>
+#include "../Scene/MeshBvh.h"
+
+class GpuMemory;
 
 struct Vertex {
     DirectX::XMFLOAT3 position;
@@ -21,5 +24,11 @@ public:
     D3D12_VERTEX_BUFFER_VIEW vbView;
     D3D12_INDEX_BUFFER_VIEW ibView;
 
-    void UploadToGPU(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList);
+    // Triangle hierarchy over the CPU copy above, for picking
+    MeshBvh bvh;
+
+    void UploadToGPU(GpuMemory& memory, ID3D12GraphicsCommandList* cmdList);
+    // Rebuilds 'bvh' from vertices and indices; call after changing them.
+    void BuildBvh();
+    void ReleaseGPU(GpuMemory& memory);
 };
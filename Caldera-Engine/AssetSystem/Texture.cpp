@@ -1,8 +1,9 @@
 #include "Texture.h"
 #include <cassert>
 #include "../include/d3dx12.h"
+#include "../Rendering/GpuMemory.h"
 
-bool Texture::LoadFromFile(const std::string& path, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList) {
+bool Texture::LoadFromFile(const std::string& path, ID3D12Device* device, GpuMemory& memory, ID3D12GraphicsCommandList* cmdList) {
     assert(device && "Device is null");
     assert(cmdList && "Command list is null");
 
@@ -27,16 +28,13 @@ bool Texture::LoadFromFile(const std::string& path, ID3D12Device* device, ID3D12
     textureDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
     textureDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-    D3D12_HEAP_PROPERTIES heapProps = {};
-    heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
-
-    HRESULT hr = device->CreateCommittedResource(
-        &heapProps,
-        D3D12_HEAP_FLAG_NONE,
+    memory.ReleaseResource(textureResource);
+    HRESULT hr = memory.CreateResource(
+        D3D12_HEAP_TYPE_DEFAULT,
         &textureDesc,
         D3D12_RESOURCE_STATE_COPY_DEST,
         nullptr,
-        IID_PPV_ARGS(&textureResource)
+        textureResource
     );
 
     if (FAILED(hr)) {
@@ -46,8 +44,6 @@ bool Texture::LoadFromFile(const std::string& path, ID3D12Device* device, ID3D12
     // Create upload buffer
     const UINT64 uploadBufferSize = GetRequiredIntermediateSize(textureResource.Get(), 0, 1);
 
-    heapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
-
     D3D12_RESOURCE_DESC uploadDesc = {};
     uploadDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
     uploadDesc.Width = uploadBufferSize;
@@ -59,13 +55,12 @@ bool Texture::LoadFromFile(const std::string& path, ID3D12Device* device, ID3D12
     uploadDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
 
     Microsoft::WRL::ComPtr<ID3D12Resource> uploadBuffer;
-    hr = device->CreateCommittedResource(
-        &heapProps,
-        D3D12_HEAP_FLAG_NONE,
+    hr = memory.CreateResource(
+        D3D12_HEAP_TYPE_UPLOAD,
         &uploadDesc,
         D3D12_RESOURCE_STATE_GENERIC_READ,
         nullptr,
-        IID_PPV_ARGS(&uploadBuffer)
+        uploadBuffer
     );
 
     if (FAILED(hr)) {
@@ -74,6 +69,8 @@ bool Texture::LoadFromFile(const std::string& path, ID3D12Device* device, ID3D12
 
     // TODO: Map and copy actual texture data to upload buffer
     // For now, just transition the texture to shader resource state
+    // (nothing reads the staging buffer yet, so hand its range straight back)
+    memory.ReleaseResource(uploadBuffer);
 
     D3D12_RESOURCE_BARRIER barrier = {};
     barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
@@ -3,13 +3,16 @@
 #include <string>
 #include <d3d12.h>
 #include <wrl/client.h>
+#include "../Rendering/BindlessTable.h"
+
+class GpuMemory;
 
 class Texture {
 public:
     std::string name;
     Microsoft::WRL::ComPtr<ID3D12Resource> textureResource;
-    D3D12_CPU_DESCRIPTOR_HANDLE srvHandleCPU;
-    D3D12_GPU_DESCRIPTOR_HANDLE srvHandleGPU;
+    // Stable slot in the bindless table (Renderer::RegisterBindlessTexture)
+    BindlessHandle bindlessHandle;
 
-    bool LoadFromFile(const std::string& path, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList);
+    bool LoadFromFile(const std::string& path, ID3D12Device* device, GpuMemory& memory, ID3D12GraphicsCommandList* cmdList);
 };
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit FNV-1a, chained through 'seed'. Stable across runs and builds, so it
+// can key files on disk.
+constexpr uint64_t HASH_SEED = 0xcbf29ce484222325ull;
+
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = HASH_SEED)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
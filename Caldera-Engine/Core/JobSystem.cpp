@@ -0,0 +1,455 @@
+#include "JobSystem.h"
+#include <algorithm>
+#include <cassert>
+
+// Free jobs move between a thread's cache and the shared list in batches of this many
+static constexpr uint32_t FREE_BATCH = 64;
+// Attempts to find work before an idle worker goes to sleep
+static constexpr uint32_t IDLE_SPINS = 64;
+
+static constexpr size_t PRIORITY_COUNT = static_cast<size_t>(JobPriority::Count);
+
+// The system and thread state of the calling thread, if it belongs to one
+static thread_local const void* currentSystem = nullptr;
+static thread_local void* currentThread = nullptr;
+
+bool WorkStealingDeque::Push(uint32_t job)
+{
+    const int64_t b = bottom.load(std::memory_order_relaxed);
+    const int64_t t = top.load(std::memory_order_acquire);
+    if (b - t >= static_cast<int64_t>(CAPACITY))
+        return false;
+    buffer[b & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+    // Publishes the slot, and the job it names, to thieves that acquire 'bottom'
+    bottom.store(b + 1, std::memory_order_release);
+    return true;
+}
+
+bool WorkStealingDeque::Pop(uint32_t& outJob)
+{
+    const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+    if (t > b) {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    outJob = buffer[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (t == b) {
+        // Last job: race the thieves for it
+        const bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+bool WorkStealingDeque::Steal(uint32_t& outJob)
+{
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b)
+        return false;
+    outJob = buffer[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+bool JobSystem::Initialize(uint32_t workerCount)
+{
+    assert(threads.empty() && "JobSystem already initialized");
+    if (workerCount == 0) {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        // Even on one core, so Background jobs run without anyone waiting on them
+        workerCount = hardwareThreads > 2 ? hardwareThreads - 1 : 1;
+    }
+
+    jobs = std::make_unique<Job[]>(MAX_JOBS);
+    freeJobs.resize(MAX_JOBS);
+    // Popped from the back, so low indices go out first
+    for (uint32_t i = 0; i < MAX_JOBS; ++i)
+        freeJobs[i] = MAX_JOBS - 1 - i;
+
+    epoch = std::chrono::steady_clock::now();
+    quit.store(false);
+    sharedQueued.store(0);
+    for (uint32_t i = 0; i <= workerCount; ++i) {
+        threads.push_back(std::make_unique<ThreadState>());
+        threads.back()->index = i;
+        threads.back()->stealSeed = i * 0x9e3779b9u + 1;
+    }
+
+    currentSystem = this;
+    currentThread = threads[MAIN_THREAD].get();
+    for (uint32_t i = 1; i <= workerCount; ++i) {
+        ThreadState* state = threads[i].get();
+        state->thread = std::thread(&JobSystem::WorkerMain, this, state);
+    }
+    return true;
+}
+
+void JobSystem::Shutdown()
+{
+    if (threads.empty())
+        return;
+
+    // Jobs pinned to the main thread only run here
+    ThreadState* self = GetCurrentThread();
+    while (RunOne(self, JobPriority::Background)) {
+    }
+
+    quit.store(true);
+    Wake(true);
+    for (size_t i = 1; i < threads.size(); ++i)
+        threads[i]->thread.join();
+    threads.clear();
+    jobs.reset();
+    freeJobs.clear();
+    for (std::deque<uint32_t>& queue : injected)
+        queue.clear();
+    injectedCount.store(0);
+    if (currentSystem == this) {
+        currentSystem = nullptr;
+        currentThread = nullptr;
+    }
+}
+
+JobId JobSystem::Create(std::function<void()> fn, JobPriority priority, const char* name)
+{
+    assert(IsInitialized() && "JobSystem not initialized");
+    ThreadState* self = GetCurrentThread();
+    uint32_t index;
+    while (!AllocateJob(self, index)) {
+        // Every job is in use: help finish some
+        if (!RunOne(self, GetLowestHelped(self)))
+            std::this_thread::yield();
+    }
+
+    Job& job = jobs[index];
+    job.fn = std::move(fn);
+    job.name = name;
+    job.priority = priority;
+    job.affinity = -1;
+    job.finished = false;
+    job.pending.store(1, std::memory_order_relaxed);
+    return { index, job.generation.load(std::memory_order_relaxed), priority };
+}
+
+void JobSystem::AddDependency(JobId job, JobId dependency)
+{
+    Job& target = jobs[job.index];
+    Job& source = jobs[dependency.index];
+    while (source.lock.test_and_set(std::memory_order_acquire)) {
+    }
+    if (source.generation.load(std::memory_order_relaxed) == dependency.generation && !source.finished) {
+        target.pending.fetch_add(1, std::memory_order_relaxed);
+        source.continuations.push_back(job.index);
+    }
+    source.lock.clear(std::memory_order_release);
+}
+
+void JobSystem::SetAffinity(JobId job, uint32_t thread)
+{
+    assert(thread < threads.size() && "Affinity names a thread the system doesn't have");
+    jobs[job.index].affinity = static_cast<int32_t>(thread);
+}
+
+void JobSystem::Submit(JobId job)
+{
+    if (jobs[job.index].pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        Enqueue(GetCurrentThread(), job.index);
+}
+
+JobId JobSystem::Run(std::function<void()> fn, JobPriority priority, const char* name)
+{
+    const JobId job = Create(std::move(fn), priority, name);
+    Submit(job);
+    return job;
+}
+
+JobId JobSystem::Then(JobId job, std::function<void()> fn, JobPriority priority, const char* name)
+{
+    const JobId continuation = Create(std::move(fn), priority, name);
+    AddDependency(continuation, job);
+    Submit(continuation);
+    return continuation;
+}
+
+bool JobSystem::IsDone(JobId job) const
+{
+    return jobs[job.index].generation.load(std::memory_order_acquire) != job.generation;
+}
+
+void JobSystem::Wait(JobId job)
+{
+    ThreadState* self = GetCurrentThread();
+    // Nothing less urgent than the job itself, so a worker waiting inside
+    // frame-critical work never picks up a long Background drain
+    const JobPriority lowest = std::min(job.priority, GetLowestHelped(self));
+    while (!IsDone(job)) {
+        if (!RunOne(self, lowest))
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& fn, JobPriority priority)
+{
+    if (count == 0)
+        return;
+    if (count == 1 || threads.size() <= 1) {
+        for (uint32_t i = 0; i < count; ++i)
+            fn(i);
+        return;
+    }
+
+    // One job per other thread, all pulling indices from a shared counter; the caller pulls too
+    std::atomic<uint32_t> next{ 0 };
+    auto body = [&] {
+        for (uint32_t i = next.fetch_add(1, std::memory_order_relaxed); i < count; i = next.fetch_add(1, std::memory_order_relaxed))
+            fn(i);
+    };
+    const uint32_t helperCount = std::min<uint32_t>(count, static_cast<uint32_t>(threads.size())) - 1;
+    JobId helpers[64];
+    const uint32_t submitted = std::min<uint32_t>(helperCount, 64);
+    for (uint32_t h = 0; h < submitted; ++h)
+        helpers[h] = Run(body, priority, "ParallelFor");
+    body();
+    for (uint32_t h = 0; h < submitted; ++h)
+        Wait(helpers[h]);
+}
+
+void JobSystem::CollectTimings(std::vector<JobTiming>& out)
+{
+    for (const std::unique_ptr<ThreadState>& thread : threads) {
+        std::lock_guard<std::mutex> lock(thread->timingMutex);
+        out.insert(out.end(), thread->timings.begin(), thread->timings.end());
+        thread->timings.clear();
+    }
+}
+
+JobSystemStats JobSystem::GetStats() const
+{
+    JobSystemStats stats;
+    for (const std::unique_ptr<ThreadState>& thread : threads) {
+        for (size_t p = 0; p < PRIORITY_COUNT; ++p)
+            stats.jobsRun[p] += thread->jobsRun[p].load(std::memory_order_relaxed);
+        stats.steals += thread->steals.load(std::memory_order_relaxed);
+        stats.busyNs += thread->busyNs.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+JobPriority JobSystem::GetLowestHelped(const ThreadState* self) const
+{
+    // There is always a worker to run them instead
+    if (self && self->index == MAIN_THREAD)
+        return JobPriority::Normal;
+    return JobPriority::Background;
+}
+
+JobSystem::ThreadState* JobSystem::GetCurrentThread() const
+{
+    return currentSystem == this ? static_cast<ThreadState*>(currentThread) : nullptr;
+}
+
+bool JobSystem::AllocateJob(ThreadState* self, uint32_t& outJob)
+{
+    if (self && self->freeJobs.empty()) {
+        std::lock_guard<std::mutex> lock(freeMutex);
+        const size_t take = std::min<size_t>(FREE_BATCH, freeJobs.size());
+        self->freeJobs.insert(self->freeJobs.end(), freeJobs.end() - take, freeJobs.end());
+        freeJobs.resize(freeJobs.size() - take);
+    }
+    if (self) {
+        if (self->freeJobs.empty())
+            return false;
+        outJob = self->freeJobs.back();
+        self->freeJobs.pop_back();
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(freeMutex);
+    if (freeJobs.empty())
+        return false;
+    outJob = freeJobs.back();
+    freeJobs.pop_back();
+    return true;
+}
+
+void JobSystem::ReleaseJob(ThreadState* self, uint32_t index)
+{
+    Job& job = jobs[index];
+    job.fn = nullptr;
+    job.continuations.clear();
+    // From here on the old handle reads as done
+    job.generation.fetch_add(1, std::memory_order_release);
+
+    if (self) {
+        self->freeJobs.push_back(index);
+        if (self->freeJobs.size() < 2 * FREE_BATCH)
+            return;
+        std::lock_guard<std::mutex> lock(freeMutex);
+        freeJobs.insert(freeJobs.end(), self->freeJobs.end() - FREE_BATCH, self->freeJobs.end());
+        self->freeJobs.resize(self->freeJobs.size() - FREE_BATCH);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(freeMutex);
+    freeJobs.push_back(index);
+}
+
+void JobSystem::Enqueue(ThreadState* self, uint32_t index)
+{
+    const Job& job = jobs[index];
+    const size_t priority = static_cast<size_t>(job.priority);
+    if (job.affinity >= 0) {
+        ThreadState& target = *threads[job.affinity];
+        {
+            std::lock_guard<std::mutex> lock(target.mailboxMutex);
+            target.mailbox[priority].push_back(index);
+        }
+        target.mailboxCount.fetch_add(1, std::memory_order_seq_cst);
+        // Only the target may take it, so make sure it's the one that wakes
+        Wake(true);
+        return;
+    }
+
+    if (!self || !self->deques[priority].Push(index)) {
+        std::lock_guard<std::mutex> lock(injectMutex);
+        injected[priority].push_back(index);
+        injectedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    sharedQueued.fetch_add(1, std::memory_order_seq_cst);
+    Wake(false);
+}
+
+void JobSystem::Wake(bool all)
+{
+    if (sleepingWorkers.load(std::memory_order_seq_cst) == 0)
+        return;
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    if (all)
+        wake.notify_all();
+    else
+        wake.notify_one();
+}
+
+bool JobSystem::FindJob(ThreadState* self, JobPriority lowest, uint32_t& outJob)
+{
+    for (size_t priority = 0; priority <= static_cast<size_t>(lowest); ++priority) {
+        if (self && self->mailboxCount.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(self->mailboxMutex);
+            if (!self->mailbox[priority].empty()) {
+                outJob = self->mailbox[priority].front();
+                self->mailbox[priority].pop_front();
+                self->mailboxCount.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        if (self && self->deques[priority].Pop(outJob)) {
+            sharedQueued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        if (injectedCount.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(injectMutex);
+            if (!injected[priority].empty()) {
+                outJob = injected[priority].front();
+                injected[priority].pop_front();
+                injectedCount.fetch_sub(1, std::memory_order_relaxed);
+                sharedQueued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        // Steal, starting from a different victim each time
+        const uint32_t threadCount = static_cast<uint32_t>(threads.size());
+        uint32_t seed = self ? self->stealSeed : 0;
+        seed = seed * 1664525u + 1013904223u;
+        if (self)
+            self->stealSeed = seed;
+        const uint32_t first = (seed >> 16) % threadCount;
+        for (uint32_t i = 0; i < threadCount; ++i) {
+            ThreadState& victim = *threads[(first + i) % threadCount];
+            if (&victim == self)
+                continue;
+            if (victim.deques[priority].Steal(outJob)) {
+                sharedQueued.fetch_sub(1, std::memory_order_relaxed);
+                if (self)
+                    self->steals.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool JobSystem::RunOne(ThreadState* self, JobPriority lowest)
+{
+    uint32_t job;
+    if (!FindJob(self, lowest, job))
+        return false;
+    Execute(self, job);
+    return true;
+}
+
+void JobSystem::Execute(ThreadState* self, uint32_t index)
+{
+    Job& job = jobs[index];
+    const int64_t start = GetNanoseconds();
+    job.fn();
+    const int64_t end = GetNanoseconds();
+
+    if (self) {
+        self->jobsRun[static_cast<size_t>(job.priority)].fetch_add(1, std::memory_order_relaxed);
+        self->busyNs.fetch_add(static_cast<uint64_t>(end - start), std::memory_order_relaxed);
+        if (job.name && profiling.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(self->timingMutex);
+            self->timings.push_back({ job.name, self->index, job.priority, start, end });
+        }
+    }
+
+    // No continuation can be added once 'finished' is set, so the list is stable after the lock
+    while (job.lock.test_and_set(std::memory_order_acquire)) {
+    }
+    job.finished = true;
+    job.lock.clear(std::memory_order_release);
+    for (uint32_t continuation : job.continuations) {
+        if (jobs[continuation].pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            Enqueue(self, continuation);
+    }
+    ReleaseJob(self, index);
+}
+
+void JobSystem::WorkerMain(ThreadState* self)
+{
+    currentSystem = this;
+    currentThread = self;
+    for (;;) {
+        bool ran = false;
+        for (uint32_t spin = 0; spin < IDLE_SPINS && !ran; ++spin) {
+            ran = RunOne(self, JobPriority::Background);
+            if (!ran)
+                std::this_thread::yield();
+        }
+        if (ran)
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+        wake.wait(lock, [&] {
+            return quit.load() || sharedQueued.load(std::memory_order_seq_cst) > 0 ||
+                self->mailboxCount.load(std::memory_order_seq_cst) > 0;
+        });
+        sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+        if (quit.load() && sharedQueued.load() <= 0 && self->mailboxCount.load() == 0)
+            return;
+    }
+}
+
+int64_t JobSystem::GetNanoseconds() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Priority classes, highest first. Every thread takes the highest class it can
+// find. A thread that waits only runs jobs at least as urgent as the one it
+// waits for, and the main thread never runs Background jobs, so a long load
+// can't stall a frame: Background work is left to idle workers, of which there
+// is always at least one. A job should therefore not depend on jobs of a lower
+// class than its own.
+enum class JobPriority : uint8_t {
+    Critical,    // this frame's work: culling, recording, parallel-for
+    Normal,
+    Background,  // file and asset I/O, anything that may take several frames
+    Count,
+};
+
+struct JobId {
+    uint32_t index = 0xFFFFFFFFu;
+    uint32_t generation = 0;
+    JobPriority priority = JobPriority::Normal;  // what Wait may help with
+
+    bool IsValid() const { return index != 0xFFFFFFFFu; }
+};
+
+// Per-job timing, recorded for named jobs while profiling is on.
+struct JobTiming {
+    const char* name = nullptr;
+    uint32_t thread = 0;
+    JobPriority priority = JobPriority::Normal;
+    int64_t startNs = 0;  // since Initialize
+    int64_t endNs = 0;
+};
+
+struct JobSystemStats {
+    uint64_t jobsRun[static_cast<size_t>(JobPriority::Count)] = {};
+    uint64_t steals = 0;
+    uint64_t busyNs = 0;  // summed over threads
+};
+
+// Lock-free work-stealing deque of job indices (Chase and Lev, with the C11
+// orderings of Le et al.). Only the owning thread pushes and pops, at the
+// bottom; any thread may steal from the top.
+class WorkStealingDeque {
+public:
+    static constexpr uint32_t CAPACITY = 4096;
+
+    // False if full; the caller queues the job elsewhere.
+    bool Push(uint32_t job);
+    bool Pop(uint32_t& outJob);
+    bool Steal(uint32_t& outJob);
+
+private:
+    alignas(64) std::atomic<int64_t> top{ 0 };
+    alignas(64) std::atomic<int64_t> bottom{ 0 };
+    std::atomic<uint32_t> buffer[CAPACITY];
+};
+
+// Work-stealing job scheduler. Each worker owns one deque per priority class
+// and steals from the others when its own run dry. The thread that calls
+// Initialize is thread 0 and takes part whenever it waits.
+//
+// Jobs form a graph: Create a job, give it dependencies, then Submit it; it
+// runs once every dependency has finished. Then() adds a continuation to a
+// job that may already be running. A job can be pinned to one thread with
+// SetAffinity; jobs pinned to thread 0 run while the main thread waits.
+//
+// Job handles are generation-checked, so waiting on or depending on a job that
+// finished long ago is fine.
+class JobSystem {
+public:
+    static constexpr uint32_t MAX_JOBS = 16 * 1024;
+    static constexpr uint32_t MAIN_THREAD = 0;
+
+    ~JobSystem() { Shutdown(); }
+
+    // 0 workers means one per hardware thread, minus the caller's, and at least one.
+    bool Initialize(uint32_t workerCount = 0);
+    // Runs every queued job, then stops the workers.
+    void Shutdown();
+    bool IsInitialized() const { return !threads.empty(); }
+
+    // Threads that run jobs, the main thread included; 1 before Initialize.
+    uint32_t GetThreadCount() const { return threads.empty() ? 1 : static_cast<uint32_t>(threads.size()); }
+
+    // 'name' must be a literal or otherwise outlive the job's timing records.
+    JobId Create(std::function<void()> fn, JobPriority priority = JobPriority::Normal, const char* name = nullptr);
+    // 'job' won't start before 'dependency' finishes. Call before submitting 'job'.
+    void AddDependency(JobId job, JobId dependency);
+    // Call before submitting 'job'. Thread indices go up to GetThreadCount() - 1.
+    void SetAffinity(JobId job, uint32_t thread);
+    void Submit(JobId job);
+    JobId Run(std::function<void()> fn, JobPriority priority = JobPriority::Normal, const char* name = nullptr);
+    // Runs 'fn' after 'job' finishes.
+    JobId Then(JobId job, std::function<void()> fn, JobPriority priority = JobPriority::Normal, const char* name = nullptr);
+
+    bool IsDone(JobId job) const;
+    // Runs other jobs of 'job's priority or higher until 'job' finishes.
+    void Wait(JobId job);
+
+    // Runs fn(index) for every index in [0, count) and returns once all are done.
+    // Indices are handed out one at a time, so uneven work balances itself.
+    // May be called from inside a job.
+    void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& fn,
+        JobPriority priority = JobPriority::Critical);
+
+    void SetProfiling(bool enabled) { profiling.store(enabled, std::memory_order_relaxed); }
+    // Moves the timings recorded since the last call into 'out'.
+    void CollectTimings(std::vector<JobTiming>& out);
+    JobSystemStats GetStats() const;
+
+private:
+    struct Job {
+        std::function<void()> fn;
+        const char* name = nullptr;
+        std::atomic<uint32_t> generation{ 1 };
+        // Unfinished dependencies, plus one until Submit
+        std::atomic<int32_t> pending{ 0 };
+        std::atomic_flag lock = ATOMIC_FLAG_INIT;  // guards 'finished' and 'continuations'
+        bool finished = false;
+        JobPriority priority = JobPriority::Normal;
+        int32_t affinity = -1;
+        std::vector<uint32_t> continuations;
+    };
+
+    struct alignas(64) ThreadState {
+        uint32_t index = 0;
+        WorkStealingDeque deques[static_cast<size_t>(JobPriority::Count)];
+        // Jobs pinned to this thread
+        std::mutex mailboxMutex;
+        std::deque<uint32_t> mailbox[static_cast<size_t>(JobPriority::Count)];
+        std::atomic<uint32_t> mailboxCount{ 0 };
+        std::vector<uint32_t> freeJobs;  // cache in front of the shared free list
+        uint32_t stealSeed = 0;
+
+        std::atomic<uint64_t> jobsRun[static_cast<size_t>(JobPriority::Count)] = {};
+        std::atomic<uint64_t> steals{ 0 };
+        std::atomic<uint64_t> busyNs{ 0 };
+        std::mutex timingMutex;
+        std::vector<JobTiming> timings;
+        std::thread thread;
+    };
+
+    ThreadState* GetCurrentThread() const;
+    // Lowest priority a thread runs while it waits, whatever it waits for
+    JobPriority GetLowestHelped(const ThreadState* self) const;
+    bool AllocateJob(ThreadState* self, uint32_t& outJob);
+    void ReleaseJob(ThreadState* self, uint32_t job);
+    void Enqueue(ThreadState* self, uint32_t job);
+    // Runs one job of at most 'lowest' priority; false if none was found.
+    bool RunOne(ThreadState* self, JobPriority lowest);
+    bool FindJob(ThreadState* self, JobPriority lowest, uint32_t& outJob);
+    void Execute(ThreadState* self, uint32_t job);
+    void WorkerMain(ThreadState* self);
+    void Wake(bool all);
+    int64_t GetNanoseconds() const;
+
+    std::unique_ptr<Job[]> jobs;
+    std::vector<std::unique_ptr<ThreadState>> threads;
+
+    std::mutex freeMutex;
+    std::vector<uint32_t> freeJobs;
+
+    // Jobs from threads outside the system, or from full deques
+    std::mutex injectMutex;
+    std::deque<uint32_t> injected[static_cast<size_t>(JobPriority::Count)];
+    std::atomic<uint32_t> injectedCount{ 0 };
+
+    // Queued jobs any thread may take; workers sleep while it is zero
+    std::atomic<int64_t> sharedQueued{ 0 };
+    std::atomic<uint32_t> sleepingWorkers{ 0 };
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<bool> quit{ false };
+    std::atomic<bool> profiling{ false };
+    std::chrono::steady_clock::time_point epoch;
+};
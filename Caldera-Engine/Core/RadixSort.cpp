@@ -0,0 +1,106 @@
+#include "RadixSort.h"
+#include "TaskPool.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+static constexpr uint32_t RADIX_BITS = 8;
+static constexpr uint32_t RADIX_BUCKETS = 1u << RADIX_BITS;
+static constexpr uint32_t RADIX_PASSES = 64 / RADIX_BITS;
+// Below this many keys per chunk the fork/join overhead outweighs the work
+static constexpr size_t MIN_KEYS_PER_CHUNK = 16 * 1024;
+
+void RadixSort64(uint64_t* keys, uint32_t* values, uint64_t* scratchKeys, uint32_t* scratchValues,
+    size_t count, TaskPool* pool)
+{
+    if (count < 2)
+        return;
+
+    uint32_t chunkCount = 1;
+    if (pool)
+        chunkCount = static_cast<uint32_t>(std::max<size_t>(1, std::min<size_t>(pool->GetThreadCount(), count / MIN_KEYS_PER_CHUNK)));
+    const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    auto forEachChunk = [&](const auto& fn) {
+        if (chunkCount == 1)
+            fn(0u);
+        else
+            pool->ParallelFor(chunkCount, [&](uint32_t chunk) { fn(chunk); });
+    };
+
+    // Which passes do anything: one digit holding every key means the pass is a no-op
+    std::vector<uint32_t> chunkDigitMasks(chunkCount * RADIX_PASSES, 0);
+    std::vector<uint64_t> chunkFirstKey(chunkCount, 0);
+    forEachChunk([&](uint32_t chunk) {
+        size_t begin = chunk * chunkSize;
+        size_t end = std::min(count, begin + chunkSize);
+        if (begin >= end)
+            return;
+        uint64_t first = keys[begin];
+        uint64_t differs = 0;
+        for (size_t i = begin + 1; i < end; ++i)
+            differs |= keys[i] ^ first;
+        chunkFirstKey[chunk] = first;
+        for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+            chunkDigitMasks[chunk * RADIX_PASSES + pass] = static_cast<uint32_t>((differs >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1));
+    });
+    uint64_t differs = 0;
+    for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+        if (chunk * chunkSize >= count)
+            break;
+        differs |= chunkFirstKey[chunk] ^ chunkFirstKey[0];
+        for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+            differs |= uint64_t(chunkDigitMasks[chunk * RADIX_PASSES + pass]) << (pass * RADIX_BITS);
+    }
+
+    std::vector<size_t> histograms(size_t(chunkCount) * RADIX_BUCKETS);
+    uint64_t* srcKeys = keys;
+    uint32_t* srcValues = values;
+    uint64_t* dstKeys = scratchKeys;
+    uint32_t* dstValues = scratchValues;
+
+    for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass) {
+        const uint32_t shift = pass * RADIX_BITS;
+        if (((differs >> shift) & (RADIX_BUCKETS - 1)) == 0)
+            continue;
+
+        forEachChunk([&](uint32_t chunk) {
+            size_t* histogram = &histograms[size_t(chunk) * RADIX_BUCKETS];
+            std::fill(histogram, histogram + RADIX_BUCKETS, size_t(0));
+            size_t begin = chunk * chunkSize;
+            size_t end = std::min(count, begin + chunkSize);
+            for (size_t i = begin; i < end; ++i)
+                ++histogram[(srcKeys[i] >> shift) & (RADIX_BUCKETS - 1)];
+        });
+
+        // Exclusive prefix over (digit, chunk) keeps the sort stable across chunks
+        size_t offset = 0;
+        for (uint32_t digit = 0; digit < RADIX_BUCKETS; ++digit) {
+            for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+                size_t& slot = histograms[size_t(chunk) * RADIX_BUCKETS + digit];
+                size_t bucketCount = slot;
+                slot = offset;
+                offset += bucketCount;
+            }
+        }
+
+        forEachChunk([&](uint32_t chunk) {
+            size_t* offsets = &histograms[size_t(chunk) * RADIX_BUCKETS];
+            size_t begin = chunk * chunkSize;
+            size_t end = std::min(count, begin + chunkSize);
+            for (size_t i = begin; i < end; ++i) {
+                size_t target = offsets[(srcKeys[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+                dstKeys[target] = srcKeys[i];
+                dstValues[target] = srcValues[i];
+            }
+        });
+
+        std::swap(srcKeys, dstKeys);
+        std::swap(srcValues, dstValues);
+    }
+
+    if (srcKeys != keys) {
+        memcpy(keys, srcKeys, count * sizeof(uint64_t));
+        memcpy(values, srcValues, count * sizeof(uint32_t));
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class TaskPool;
+
+// Stable LSD radix sort of 64-bit keys with a 32-bit payload, 8 bits per pass.
+// Passes where every key has the same digit are skipped, so keys that only use
+// a few bit fields cost only those passes. With a task pool, each pass splits
+// the array into chunks that are counted and scattered in parallel.
+// The scratch arrays must hold 'count' elements; results end up in keys/values.
+void RadixSort64(uint64_t* keys, uint32_t* values, uint64_t* scratchKeys, uint32_t* scratchValues,
+    size_t count, TaskPool* pool = nullptr);
@@ -0,0 +1,16 @@
+#include "TaskPool.h"
+
+bool TaskPool::Initialize(uint32_t workerCount)
+{
+    return jobs.Initialize(workerCount);
+}
+
+void TaskPool::Shutdown()
+{
+    jobs.Shutdown();
+}
+
+void TaskPool::ParallelFor(uint32_t taskCount, const std::function<void(uint32_t)>& fn)
+{
+    jobs.ParallelFor(taskCount, fn, JobPriority::Critical);
+}
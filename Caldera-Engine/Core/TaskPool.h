@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include "JobSystem.h"
+
+// Fork/join front end of the JobSystem for code that only needs ParallelFor.
+// The calling thread helps until every task is done, and a task may start a
+// ParallelFor of its own. Use GetJobSystem for task graphs, background work
+// and affinity.
+class TaskPool {
+public:
+    // 0 workers means one per hardware thread, minus the caller's, and at least one.
+    bool Initialize(uint32_t workerCount = 0);
+    void Shutdown();
+
+    // Threads that take part in ParallelFor, the caller included.
+    uint32_t GetThreadCount() const { return jobs.GetThreadCount(); }
+
+    // Runs fn(taskIndex) for every index in [0, taskCount) and returns once all are done.
+    void ParallelFor(uint32_t taskCount, const std::function<void(uint32_t)>& fn);
+
+    JobSystem& GetJobSystem() { return jobs; }
+
+private:
+    JobSystem jobs;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Hands whole values from one writer thread to one reader thread without either
+// of them waiting. The writer fills its buffer and publishes it; the reader
+// takes the newest published buffer, skipping any it never got to. The third
+// buffer sits between the two, so neither ever touches the other's.
+//
+// Buffers are reused rather than rebuilt, so a T holding vectors keeps their
+// capacity from one publish to the next.
+template<typename T>
+class TripleBuffer {
+public:
+    // Writer only. Holds whatever was written there two publishes ago.
+    T& GetWriteBuffer() { return buffers[writeIndex]; }
+    void Publish()
+    {
+        writeIndex = shared.exchange(writeIndex | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Reader only. Takes the newest published buffer; false if nothing was
+    // published since the last call, in which case the read buffer is unchanged.
+    bool Acquire()
+    {
+        // Only the reader clears FRESH, so it is still set at the exchange
+        if ((shared.load(std::memory_order_relaxed) & FRESH) == 0)
+            return false;
+        readIndex = shared.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    const T& GetReadBuffer() const { return buffers[readIndex]; }
+
+private:
+    static constexpr uint32_t INDEX_MASK = 3;
+    static constexpr uint32_t FRESH = 4;  // the shared buffer holds an unread publish
+
+    T buffers[3];
+    std::atomic<uint32_t> shared{ 1 };
+    uint32_t writeIndex = 0;
+    uint32_t readIndex = 2;
+};
@@ -2,11 +2,23 @@
 #include "imgui.h"
 #include "EditorContentBrowser.h"
 #include "Renderer.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
 
 void EditorBase::ConstructEditorLayout()
 {
     CreateWindowMenu();
+    // Never blocks: finished cell loads are picked up and new ones queued
+    if (partition.IsInitialized())
+        partition.Update(cameraPosition);
+    // While playing, the world belongs to the simulation thread; only its snapshots are drawn
+    if (simulation.IsRunning())
+        SubmitSimulationState();
+    else
+        transforms.Update(world);
     CreateEditorViewport();
+    ConstructInspector();
     ConstructContentBrowser();
 }
 
@@ -23,6 +35,12 @@ EditorBase::EditorBase() : renderer(nullptr)
     contentBrowser.SetRootDirectory(std::filesystem::current_path());
 }
 
+void EditorBase::Shutdown()
+{
+    // Streaming runs on the renderer's job system, so it stops before the renderer does
+    partition.Shutdown();
+}
+
 void EditorBase::SetRenderer(Renderer* r)
 {
     renderer = r;
@@ -33,20 +51,78 @@ void EditorBase::CreateWindowMenu()
 {
     if (ImGui::BeginMainMenuBar()) {
         if (ImGui::BeginMenu("File")) {
-            if (ImGui::MenuItem("Open", "Ctrl+O")) {
-                // Action for "Open"
+            const bool editable = !simulation.IsRunning();
+            if (ImGui::MenuItem("Open", "Ctrl+O", false, editable)) {
+                // Loaded entities get new handles
+                if (sceneSerializer.Load(world, scenePath)) {
+                    selectedEntity = NULL_ENTITY;
+                    undoHistory.Clear();
+                    transforms.Sync(world);
+                }
+            }
+            if (ImGui::MenuItem("Save", "Ctrl+S", false, editable)) {
+                sceneSerializer.Save(world, scenePath);
+            }
+            if (ImGui::MenuItem("Export Text")) {
+                ExportSceneText(scenePath, scenePath + ".txt");
             }
-            if (ImGui::MenuItem("Save", "Ctrl+S")) {
-                // Action for "Save"
+            ImGui::Separator();
+            if (ImGui::MenuItem("Partition Scene", NULL, false, editable)) {
+                PartitionLayout layout;
+                PartitionWorld(world, PARTITION_CELL_SIZE, partitionDirectory, {}, layout);
+            }
+            // Cells stream in Background jobs of the renderer's job system
+            if (ImGui::MenuItem("Stream Partition", NULL, false, renderer != nullptr)) {
+                PartitionLayout layout;
+                if (LoadPartitionLayout(partitionDirectory + "/partition.cwp", layout)) {
+                    partition.Shutdown();
+                    partition.Initialize(std::move(layout), StreamingSettings(), renderer->GetJobSystem());
+                }
             }
             ImGui::EndMenu();
         }
         if (ImGui::BeginMenu("Edit")) {
-            if (ImGui::MenuItem("Undo", "Ctrl+Z")) {
-                // Action for "Undo"
+            const bool editable = !simulation.IsRunning();
+            // A step may touch any entity's Transform, so every one is read again
+            if (ImGui::MenuItem("Undo", "Ctrl+Z", false, editable && undoHistory.CanUndo())) {
+                undoHistory.Undo(world);
+                transforms.Sync(world);
+            }
+            if (ImGui::MenuItem("Redo", "Ctrl+Shift+Z", false, editable && undoHistory.CanRedo())) {
+                undoHistory.Redo(world);
+                transforms.Sync(world);
+            }
+            ImGui::EndMenu();
+        }
+        if (ImGui::BeginMenu("Simulation")) {
+            if (ImGui::MenuItem("Play", NULL, false, !simulation.IsRunning())) {
+                // Saved first, so Stop can put the scene back as it was
+                if (playSerializer.Save(world, playScenePath)) {
+                    simulation.Start(world);
+                    // The snapshots replace the default cube, even when they hold nothing
+                    if (renderer)
+                        renderer->SetSceneSubmitted(true);
+                }
+            }
+            if (ImGui::MenuItem("Stop", NULL, false, simulation.IsRunning())) {
+                simulation.Stop();
+                // Loaded entities get new handles
+                if (playSerializer.Load(world, playScenePath)) {
+                    selectedEntity = NULL_ENTITY;
+                    undoHistory.Clear();
+                    transforms.Sync(world);
+                }
+                if (renderer) {
+                    renderer->GetSceneRenderables().clear();
+                    renderer->GetSceneBounds().Clear();
+                    renderer->SetSceneSubmitted(false);
+                }
             }
-            if (ImGui::MenuItem("Redo", "Ctrl+Shift+Z")) {
-                // Action for "Redo"
+            if (simulation.IsRunning()) {
+                ImGui::Separator();
+                ImGui::Text("Tick: %llu", (unsigned long long)simulationStats.ticks);
+                ImGui::Text("Step: %.2f ms (max %.2f)", simulationStats.stepMs, simulationStats.maxStepMs);
+                ImGui::Text("Dropped steps: %llu", (unsigned long long)simulationStats.droppedSteps);
             }
             ImGui::EndMenu();
         }
@@ -60,6 +136,47 @@ void EditorBase::CreateWindowMenu()
             {
                 showContentBrowser = !showContentBrowser;
             }
+            if (ImGui::MenuItem("Inspector", NULL, showInspector))
+            {
+                showInspector = !showInspector;
+            }
+            if (renderer && ImGui::BeginMenu("Frame Latency"))
+            {
+                for (int i = 0; i < static_cast<int>(LatencyMode::Count); ++i)
+                {
+                    LatencyMode mode = static_cast<LatencyMode>(i);
+                    if (ImGui::MenuItem(GetLatencyModeName(mode), NULL, renderer->GetLatencyMode() == mode))
+                        renderer->SetLatencyMode(mode);
+                }
+                const FramePacingStats& pacing = renderer->GetFramePacingStats();
+                ImGui::Separator();
+                ImGui::Text("Input to present: %.1f ms", pacing.averageInputToPresentMs);
+                ImGui::Text("Input to GPU done: %.1f ms", pacing.averageInputToCompleteMs);
+                ImGui::Text("Frames in flight: %u", pacing.framesInFlight);
+                ImGui::EndMenu();
+            }
+            if (renderer && ImGui::BeginMenu("Dynamic Resolution"))
+            {
+                if (ImGui::MenuItem("Enabled", NULL, renderer->IsDynamicResolutionEnabled()))
+                    renderer->SetDynamicResolution(!renderer->IsDynamicResolutionEnabled());
+                const DynamicResolutionStats& resolution = renderer->GetDynamicResolutionStats();
+                ImGui::Separator();
+                ImGui::Text("Render scale: %.0f%%", renderer->GetRenderScale() * 100.0f);
+                ImGui::Text("GPU frame: %.2f ms (avg %.2f)", renderer->GetGpuFrameMs(), resolution.smoothedFrameMs);
+                ImGui::Text("Scale changes: %u down, %u up", resolution.decreases, resolution.increases);
+                ImGui::Text("Target: %.1f ms", DYNAMIC_RESOLUTION_TARGET_MS);
+                ImGui::EndMenu();
+            }
+            if (partition.IsInitialized() && ImGui::BeginMenu("World Partition"))
+            {
+                const StreamingStats streaming = partition.GetStats();
+                ImGui::Text("Cells: %u loaded, %u loading, %u unloading, %u failed", streaming.loadedCells,
+                    streaming.loadingCells, streaming.unloadingCells, streaming.failedCells);
+                ImGui::Text("Resident: %.1f MB", streaming.residentBytes / (1024.0 * 1024.0));
+                ImGui::Text("Evictions: %llu, budget stalls: %llu", (unsigned long long)streaming.evictions,
+                    (unsigned long long)streaming.budgetStalls);
+                ImGui::EndMenu();
+            }
             ImGui::EndMenu();
         }
         ImGui::EndMainMenuBar();
@@ -80,11 +197,12 @@ void EditorBase::CreateEditorViewport()
             // Update the renderer viewport size if needed
             renderer->SetViewportSize(viewportSize.x, viewportSize.y);
 
-            // Get the current back buffer as a texture ID for ImGui
-            ImTextureID textureID = renderer->GetCurrentBackBufferImGui();
-
-            // Display the rendered texture, maintaining aspect ratio
-            ImGui::Image(textureID, viewportSize);
+            // The scene renders into its own target; only its top-left part is this frame's image
+            ImTextureID textureID = renderer->GetSceneTextureID();
+            if (textureID)
+                ImGui::Image(textureID, viewportSize, ImVec2(0.0f, 0.0f), renderer->GetSceneUv());
+            else
+                ImGui::Dummy(viewportSize);
 
             // Handle viewport focusing and input capture
             bool isViewportHovered = ImGui::IsItemHovered();
@@ -92,7 +210,19 @@ void EditorBase::CreateEditorViewport()
 
             // You can use these states to handle input specifically for the viewport
             if (isViewportFocused && isViewportHovered) {
-                // Handle viewport-specific input here if needed
+                // Click to select the entity under the cursor
+                if (ImGui::IsMouseClicked(ImGuiMouseButton_Left) && !simulation.IsRunning()) {
+                    ImVec2 imageMin = ImGui::GetItemRectMin();
+                    ImVec2 imageSize = ImGui::GetItemRectSize();
+                    ImVec2 mouse = ImGui::GetMousePos();
+                    float ndcX = (mouse.x - imageMin.x) / imageSize.x * 2.0f - 1.0f;
+                    float ndcY = 1.0f - (mouse.y - imageMin.y) / imageSize.y * 2.0f;
+
+                    // The scene has no camera yet, so world space is clip space
+                    static const float inverseViewProjection[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+                    spatialIndex.Sync(world);
+                    selectedEntity = spatialIndex.Pick(MakePickRay(inverseViewProjection, ndcX, ndcY));
+                }
             }
         }
         else {
@@ -101,4 +231,76 @@ void EditorBase::CreateEditorViewport()
 
         ImGui::End();
     }
-}
\ No newline at end of file
+}
+
+void EditorBase::ConstructInspector()
+{
+    if (showInspector == false)
+        return;
+
+    ImGui::Begin("Inspector", &showInspector);
+    // While playing, the world belongs to the simulation thread
+    TransformComponent* transform = simulation.IsRunning() ? nullptr : world.Get<TransformComponent>(selectedEntity);
+    if (!transform) {
+        ImGui::TextDisabled(simulation.IsRunning() ? "Editing is paused while playing" : "No entity selected");
+        ImGui::End();
+        return;
+    }
+
+    // Dragged on a copy, so the component is recorded before it changes. Every
+    // frame of one drag commits under the same merge key and folds into one step.
+    auto dragField = [&](const char* label, float (TransformComponent::*field)[3], float speed, const char* stepName) {
+        float values[3];
+        std::copy(std::begin(transform->*field), std::end(transform->*field), values);
+        const bool changed = ImGui::DragFloat3(label, values, speed);
+        if (ImGui::IsItemActivated())
+            ++inspectorMergeKey;
+        if (!changed)
+            return;
+        undoHistory.Begin(stepName, inspectorMergeKey);
+        undoHistory.Record<TransformComponent>(world, selectedEntity);
+        std::copy(values, values + 3, transform->*field);
+        undoHistory.Commit(world);
+        transforms.MarkChanged(selectedEntity);
+    };
+
+    ImGui::Text("Transform");
+    dragField("Position", &TransformComponent::position, 0.05f, "Move");
+    dragField("Scale", &TransformComponent::scale, 0.01f, "Scale");
+    // Position and Scale are relative to the parent; this is where the entity ends up
+    if (const WorldTransformComponent* worldTransform = world.Get<WorldTransformComponent>(selectedEntity))
+        ImGui::TextDisabled("World position: %.2f, %.2f, %.2f", worldTransform->rows[3], worldTransform->rows[7], worldTransform->rows[11]);
+    ImGui::End();
+}
+
+void EditorBase::SubmitSimulationState()
+{
+    float alpha;
+    const SimulationSnapshot& snapshot = simulation.AcquireSnapshot(alpha);
+    simulationStats = snapshot.stats;
+    if (!renderer)
+        return;
+    InterpolateSnapshot(snapshot, alpha, interpolatedTransforms);
+
+    std::vector<Renderable>& renderables = renderer->GetSceneRenderables();
+    CullingBounds& bounds = renderer->GetSceneBounds();
+    renderables.clear();
+    bounds.Clear();
+    for (size_t i = 0; i < interpolatedTransforms.size(); ++i) {
+        const RenderableComponent& source = snapshot.renderables[i];
+        if (source.mesh >= renderer->GetSceneMeshCount())
+            continue;
+        Renderable renderable;
+        renderable.pipeline = source.pipeline;
+        renderable.material = source.material;
+        renderable.mesh = source.mesh;
+        GetTransformMatrix(interpolatedTransforms[i], renderable.instance.world);
+
+        float center[3], extents[3];
+        GetWorldBounds(interpolatedTransforms[i], snapshot.bounds[i], center, extents);
+        // The scene has no camera yet, so world z is already the view depth
+        renderable.depth = std::min(std::max(center[2], 0.0f), 1.0f);
+        bounds.Add(center, extents, std::sqrt(extents[0] * extents[0] + extents[1] * extents[1] + extents[2] * extents[2]));
+        renderables.push_back(renderable);
+    }
+}
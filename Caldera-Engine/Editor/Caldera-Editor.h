@@ -1,6 +1,18 @@
 #pragma once
 
 #include "EditorContentBrowser.h"
+#include "../Scene/World.h"
+#include "../Scene/SceneSpatialIndex.h"
+#include "../Scene/SceneTransforms.h"
+#include "../Scene/SceneSerializer.h"
+#include "../Scene/Simulation.h"
+#include "../Scene/UndoHistory.h"
+#include "../Scene/WorldPartition.h"
+
+// Edge length of the cells File > Partition Scene splits the scene into
+constexpr float PARTITION_CELL_SIZE = 64.0f;
+// Most memory the editor's undo steps may take; nothing is allocated until the first edit
+constexpr size_t EDITOR_UNDO_CAPACITY = 8 * 1024 * 1024;
 
 // Forward declaration to avoid circular dependency
 class Renderer;
@@ -11,6 +23,27 @@ public:
 
 	EditorContentBrowser contentBrowser;
 
+	// The scene being edited
+	World world;
+	// World matrices of the scene's entities, from their Transforms and parents
+	SceneTransforms transforms;
+	// World boxes of the scene's entities, for picking in the viewport
+	SceneSpatialIndex spatialIndex;
+	Entity selectedEntity;
+	// Component edits made in the editor, for Edit > Undo and Redo
+	UndoHistory undoHistory{ EDITOR_UNDO_CAPACITY };
+	// File > Open and Save read and write this file
+	std::string scenePath = "Scene.cscene";
+	SceneSerializer sceneSerializer;
+	// Cells streamed around the camera; the scene has no camera yet, so it sits at the origin
+	std::string partitionDirectory = "Partition";
+	WorldPartition partition;
+	float cameraPosition[3] = { 0.0f, 0.0f, 0.0f };
+	// Simulation > Play steps the scene on its own thread; Stop puts back the scene saved at Play
+	Simulation simulation;
+	std::string playScenePath = "PlaySession.cscene";
+	SceneSerializer playSerializer;
+
 	// Remove the Renderer instance - use external renderer instead
 	// Renderer renderer;
 
@@ -19,12 +52,23 @@ public:
 	void CreateEditorViewport();
 	void ConstructEditorLayout();
 	void ConstructContentBrowser();
+	void ConstructInspector();
 	void SetRenderer(Renderer* r); // Add method to set renderer
+	// Call before the renderer shuts down
+	void Shutdown();
 
 public:
 	bool showViewport = true;
 	bool showContentBrowser = true;
+	bool showInspector = true;
 
 private:
+	// Hands the newest simulation snapshot, interpolated to this frame, to the renderer
+	void SubmitSimulationState();
+
 	Renderer* renderer = nullptr; // Store pointer instead
+	std::vector<TransformComponent> interpolatedTransforms;
+	SimulationStats simulationStats;
+	// Bumped when an inspector drag starts, so each drag folds into one undo step
+	uint64_t inspectorMergeKey = 0;
 };
\ No newline at end of file
@@ -329,15 +329,14 @@ ImTextureID EditorContentBrowser::CreateTextureFromFile(
     textureDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
     textureDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-    D3D12_HEAP_PROPERTIES heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+    GpuMemory& gpuMemory = renderer->GetGpuMemory();
 
-    HRESULT hr = device->CreateCommittedResource(
-        &heapProps,
-        D3D12_HEAP_FLAG_NONE,
+    HRESULT hr = gpuMemory.CreateResource(
+        D3D12_HEAP_TYPE_DEFAULT,
         &textureDesc,
-        D3D12_RESOURCE_STATE_COPY_DEST,
+        D3D12_RESOURCE_STATE_COMMON,
         nullptr,
-        IID_PPV_ARGS(&outTexture)
+        outTexture
     );
 
     if (FAILED(hr)) {
@@ -348,16 +347,14 @@ ImTextureID EditorContentBrowser::CreateTextureFromFile(
     // Create upload buffer
     const UINT64 uploadBufferSize = width * height * 4; // 4 bytes per pixel (RGBA)
     ComPtr<ID3D12Resource> uploadBuffer;
-    heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
     auto uploadDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
 
-    hr = device->CreateCommittedResource(
-        &heapProps,
-        D3D12_HEAP_FLAG_NONE,
+    hr = gpuMemory.CreateResource(
+        D3D12_HEAP_TYPE_UPLOAD,
         &uploadDesc,
         D3D12_RESOURCE_STATE_GENERIC_READ,
         nullptr,
-        IID_PPV_ARGS(&uploadBuffer)
+        uploadBuffer
     );
 
     if (FAILED(hr)) {
@@ -377,22 +374,10 @@ ImTextureID EditorContentBrowser::CreateTextureFromFile(
     memcpy(mappedData, imageData, uploadBufferSize);
     uploadBuffer->Unmap(0, nullptr);
 
-    // Create command allocator and list
-    ComPtr<ID3D12CommandAllocator> commandAllocator;
-    ComPtr<ID3D12GraphicsCommandList> commandList;
-
-    hr = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator));
-    if (FAILED(hr)) {
-        stbi_image_free(imageData);
-        return NULL;
-    }
-
-    hr = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator.Get(),
-        nullptr, IID_PPV_ARGS(&commandList));
-    if (FAILED(hr)) {
-        stbi_image_free(imageData);
-        return NULL;
-    }
+    // Record the copy on the copy queue so it overlaps with rendering. The texture
+    // decays to COMMON after the copy and is promoted to a shader resource on first
+    // use by the graphics queue, so no transition barrier is needed here.
+    ID3D12GraphicsCommandList* copyList = renderer->BeginUploadBatch();
 
     // Copy data to texture
     D3D12_TEXTURE_COPY_LOCATION dst = {};
@@ -410,56 +395,23 @@ ImTextureID EditorContentBrowser::CreateTextureFromFile(
     src.PlacedFootprint.Footprint.Depth = 1;
     src.PlacedFootprint.Footprint.RowPitch = width * 4;
 
-    commandList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
-
-    // Transition texture to shader resource
-    D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-        outTexture.Get(),
-        D3D12_RESOURCE_STATE_COPY_DEST,
-        D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
-    );
-    commandList->ResourceBarrier(1, &barrier);
+    copyList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
 
-    // Execute command list
-    hr = commandList->Close();
-    if (SUCCEEDED(hr)) {
-        ID3D12CommandQueue* commandQueue = renderer->GetCommandQueue();
-        ID3D12CommandList* ppCommandLists[] = { commandList.Get() };
-        commandQueue->ExecuteCommandLists(1, ppCommandLists);
-
-        // Wait for GPU
-        renderer->WaitForGPU();
-    }
+    // Staging memory is released once the copy queue is done with it
+    renderer->KeepUploadAlive(uploadBuffer);
+    renderer->WaitOnGraphics(renderer->SubmitUploadBatch());
 
-    // Create SRV
+    // Create SRV in the bindless table; its slot doubles as the ImGui texture ID
     D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
     srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
     srvDesc.Format = textureDesc.Format;
     srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
     srvDesc.Texture2D.MipLevels = 1;
 
-    // Get descriptor handle
-    UINT descriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-    UINT descriptorIndex = renderer->AllocateDescriptor();
-
-    D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = srvHeap->GetCPUDescriptorHandleForHeapStart();
-    D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = srvHeap->GetGPUDescriptorHandleForHeapStart();
-
-    cpuHandle.ptr += descriptorIndex * descriptorSize;
-    gpuHandle.ptr += descriptorIndex * descriptorSize;
-
-    device->CreateShaderResourceView(outTexture.Get(), &srvDesc, cpuHandle);
+    BindlessHandle handle = renderer->RegisterBindlessTexture(outTexture.Get(), &srvDesc);
 
     // Cleanup
     stbi_image_free(imageData);
-    commandAllocator.Reset();
-    commandList.Reset();
-    uploadBuffer.Reset();
-
-    // Convert GPU handle to ImTextureID
-    #ifdef _WIN64
-        return (ImTextureID)gpuHandle.ptr;
-    #else
-        return (ImTextureID)(UINT32)gpuHandle.ptr;
-    #endif
+
+    return renderer->GetBindlessTextureID(handle);
 }
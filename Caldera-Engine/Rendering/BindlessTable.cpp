@@ -0,0 +1,77 @@
+#include "BindlessTable.h"
+#include <cassert>
+
+void BindlessTable::Initialize(DescriptorIndexAllocator* indices)
+{
+    assert(indices && "Bindless table needs an index allocator");
+    this->indices = indices;
+    slotCount = indices->GetCapacity();
+    slots.reset(new Slot[slotCount]);
+    for (auto& count : liveCounts)
+        count.store(0, std::memory_order_relaxed);
+}
+
+void BindlessTable::Shutdown()
+{
+    slots.reset();
+    slotCount = 0;
+    indices = nullptr;
+}
+
+BindlessHandle BindlessTable::Allocate(BindlessResourceType type)
+{
+    assert(type != BindlessResourceType::None && "Bindless slots need a resource type");
+
+    const uint32_t index = indices->Allocate();
+    if (index == INVALID_DESCRIPTOR_INDEX)
+        return BindlessHandle();
+
+    // The index allocator hands each slot to one owner, so no other thread touches it now
+    Slot& slot = slots[index];
+    slot.type.store(static_cast<uint8_t>(type), std::memory_order_relaxed);
+    liveCounts[static_cast<int>(type)].fetch_add(1, std::memory_order_relaxed);
+
+    BindlessHandle handle;
+    handle.index = index;
+    handle.generation = slot.generation.load(std::memory_order_acquire);
+    return handle;
+}
+
+bool BindlessTable::Release(BindlessHandle handle, uint64_t retireValue)
+{
+    if (handle.index >= slotCount)
+        return false;
+
+    // Bumping the generation claims the release; stale handles fail IsValid from here on
+    Slot& slot = slots[handle.index];
+    uint32_t generation = handle.generation;
+    if (!slot.generation.compare_exchange_strong(generation, generation + 1, std::memory_order_acq_rel))
+        return false;
+
+    const int type = slot.type.exchange(static_cast<uint8_t>(BindlessResourceType::None), std::memory_order_relaxed);
+    liveCounts[type].fetch_sub(1, std::memory_order_relaxed);
+    // The slot itself waits for the GPU
+    indices->FreeDeferred(handle.index, retireValue);
+    return true;
+}
+
+bool BindlessTable::IsValid(BindlessHandle handle) const
+{
+    if (handle.index >= slotCount)
+        return false;
+    const Slot& slot = slots[handle.index];
+    return slot.generation.load(std::memory_order_acquire) == handle.generation &&
+        slot.type.load(std::memory_order_relaxed) != static_cast<uint8_t>(BindlessResourceType::None);
+}
+
+uint32_t BindlessTable::GetShaderIndex(BindlessHandle handle) const
+{
+    return IsValid(handle) ? handle.index : INVALID_DESCRIPTOR_INDEX;
+}
+
+BindlessResourceType BindlessTable::GetType(BindlessHandle handle) const
+{
+    if (!IsValid(handle))
+        return BindlessResourceType::None;
+    return static_cast<BindlessResourceType>(slots[handle.index].type.load(std::memory_order_relaxed));
+}
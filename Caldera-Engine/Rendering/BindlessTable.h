@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "DescriptorAllocator.h"
+
+// What a bindless slot holds. Shaders pick the matching array for the index.
+enum class BindlessResourceType : uint8_t {
+    None = 0,
+    Texture,
+    Buffer,
+    Count
+};
+
+// Stable reference to a bindless slot. 'index' is what shaders see; the
+// generation catches handles that outlived their resource.
+struct BindlessHandle {
+    uint32_t index = INVALID_DESCRIPTOR_INDEX;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return index != INVALID_DESCRIPTOR_INDEX; }
+    bool operator==(const BindlessHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const BindlessHandle& other) const { return !(*this == other); }
+};
+
+// Slot bookkeeping for the bindless descriptor table. Slots come from the shared
+// descriptor index space, so a shader index is also a heap index. Releasing a
+// handle invalidates it at once but only recycles the slot after 'retireValue',
+// so frames still in flight keep reading a live descriptor.
+//
+// Allocate/Release are thread-safe. Writing the actual descriptor is left to the
+// backend (see Renderer::RegisterBindlessTexture).
+class BindlessTable {
+public:
+    void Initialize(DescriptorIndexAllocator* indices);
+    void Shutdown();
+
+    BindlessHandle Allocate(BindlessResourceType type);
+    // Returns false, changing nothing, for a null handle or one that was already
+    // released; of several threads releasing the same handle, exactly one succeeds.
+    bool Release(BindlessHandle handle, uint64_t retireValue);
+
+    bool IsValid(BindlessHandle handle) const;
+    // Index to hand to shaders, or INVALID_DESCRIPTOR_INDEX for stale handles.
+    uint32_t GetShaderIndex(BindlessHandle handle) const;
+    BindlessResourceType GetType(BindlessHandle handle) const;
+
+    uint32_t GetLiveCount(BindlessResourceType type) const { return liveCounts[static_cast<int>(type)].load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> generation{ 1 };
+        std::atomic<uint8_t> type{ 0 };
+    };
+
+    DescriptorIndexAllocator* indices = nullptr;
+    std::unique_ptr<Slot[]> slots;  // sized to the index space's max capacity
+    uint32_t slotCount = 0;
+    std::atomic<uint32_t> liveCounts[static_cast<int>(BindlessResourceType::Count)] = {};
+};
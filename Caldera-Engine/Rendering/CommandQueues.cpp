@@ -0,0 +1,162 @@
+#include "CommandQueues.h"
+#include "GpuMemory.h"
+#include <cassert>
+
+static D3D12_COMMAND_LIST_TYPE ToCommandListType(QueueType queue)
+{
+    switch (queue) {
+    case QueueType::Compute: return D3D12_COMMAND_LIST_TYPE_COMPUTE;
+    case QueueType::Copy:    return D3D12_COMMAND_LIST_TYPE_COPY;
+    default:                 return D3D12_COMMAND_LIST_TYPE_DIRECT;
+    }
+}
+
+bool D3D12GpuTimeline::Create(ID3D12Device* device)
+{
+    for (int i = 0; i < NUM_QUEUE_TYPES; ++i) {
+        D3D12_COMMAND_QUEUE_DESC desc = {};
+        desc.Type = ToCommandListType(static_cast<QueueType>(i));
+        desc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+        desc.NodeMask = 1;
+        if (device->CreateCommandQueue(&desc, IID_PPV_ARGS(&queues[i])) != S_OK)
+            return false;
+
+        if (device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fences[i])) != S_OK)
+            return false;
+        fenceValues[i] = 0;
+    }
+
+    queues[static_cast<int>(QueueType::Graphics)]->SetName(L"Graphics Queue");
+    queues[static_cast<int>(QueueType::Compute)]->SetName(L"Async Compute Queue");
+    queues[static_cast<int>(QueueType::Copy)]->SetName(L"Copy Queue");
+
+    waitEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    return waitEvent != nullptr;
+}
+
+void D3D12GpuTimeline::Destroy()
+{
+    for (int i = 0; i < NUM_QUEUE_TYPES; ++i) {
+        queues[i].Reset();
+        fences[i].Reset();
+    }
+    if (waitEvent) {
+        CloseHandle(waitEvent);
+        waitEvent = nullptr;
+    }
+}
+
+SyncPoint D3D12GpuTimeline::Signal(QueueType queue)
+{
+    const int i = static_cast<int>(queue);
+    queues[i]->Signal(fences[i].Get(), ++fenceValues[i]);
+    return { queue, fenceValues[i] };
+}
+
+void D3D12GpuTimeline::QueueWait(QueueType waiter, SyncPoint point)
+{
+    queues[static_cast<int>(waiter)]->Wait(fences[static_cast<int>(point.queue)].Get(), point.value);
+}
+
+uint64_t D3D12GpuTimeline::GetCompletedValue(QueueType queue) const
+{
+    return fences[static_cast<int>(queue)]->GetCompletedValue();
+}
+
+void D3D12GpuTimeline::CpuWait(SyncPoint point)
+{
+    ID3D12Fence* fence = fences[static_cast<int>(point.queue)].Get();
+    if (fence->GetCompletedValue() >= point.value)
+        return;
+
+    fence->SetEventOnCompletion(point.value, waitEvent);
+    WaitForSingleObject(waitEvent, INFINITE);
+}
+
+bool UploadQueue::Create(ID3D12Device* device, D3D12GpuTimeline* timeline, QueueScheduler* scheduler, GpuMemory* memory)
+{
+    this->device = device;
+    this->timeline = timeline;
+    this->scheduler = scheduler;
+    this->memory = memory;
+
+    ComPtr<ID3D12CommandAllocator> allocator;
+    if (device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&allocator)) != S_OK)
+        return false;
+
+    if (device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, allocator.Get(), nullptr, IID_PPV_ARGS(&commandList)) != S_OK ||
+        commandList->Close() != S_OK)
+        return false;
+
+    freeAllocators.push_back(allocator);
+    return true;
+}
+
+void UploadQueue::Destroy()
+{
+    if (isOpen)
+        Submit();
+
+    for (Batch& batch : inFlight)
+        scheduler->CpuWait(batch.syncPoint);
+    Collect();
+    freeAllocators.clear();
+    commandList.Reset();
+}
+
+ID3D12GraphicsCommandList* UploadQueue::Begin()
+{
+    if (isOpen)
+        return commandList.Get();
+
+    Collect();
+    if (freeAllocators.empty()) {
+        ComPtr<ID3D12CommandAllocator> allocator;
+        HRESULT hr = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&allocator));
+        assert(SUCCEEDED(hr) && "Failed to create copy allocator");
+        freeAllocators.push_back(allocator);
+    }
+
+    current.allocator = freeAllocators.back();
+    freeAllocators.pop_back();
+    current.allocator->Reset();
+    commandList->Reset(current.allocator.Get(), nullptr);
+    isOpen = true;
+    return commandList.Get();
+}
+
+void UploadQueue::KeepAlive(ComPtr<ID3D12Resource> resource)
+{
+    assert(isOpen && "No upload batch is open");
+    current.staging.push_back(std::move(resource));
+}
+
+SyncPoint UploadQueue::Submit()
+{
+    assert(isOpen && "No upload batch is open");
+    commandList->Close();
+
+    scheduler->FlushWaits(QueueType::Copy);
+    ID3D12CommandList* lists[] = { commandList.Get() };
+    timeline->GetQueue(QueueType::Copy)->ExecuteCommandLists(1, lists);
+
+    current.syncPoint = scheduler->Submit(QueueType::Copy);
+    SyncPoint result = current.syncPoint;
+
+    inFlight.push_back(std::move(current));
+    current = Batch();
+    isOpen = false;
+    return result;
+}
+
+void UploadQueue::Collect()
+{
+    size_t retired = 0;
+    while (retired < inFlight.size() && scheduler->IsComplete(inFlight[retired].syncPoint)) {
+        for (ComPtr<ID3D12Resource>& staging : inFlight[retired].staging)
+            memory->ReleaseResource(staging);
+        freeAllocators.push_back(inFlight[retired].allocator);
+        ++retired;
+    }
+    inFlight.erase(inFlight.begin(), inFlight.begin() + retired);
+}
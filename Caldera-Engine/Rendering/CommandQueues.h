@@ -0,0 +1,71 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <windows.h>
+#include <vector>
+#include "QueueSync.h"
+
+class GpuMemory;
+
+using namespace Microsoft::WRL;
+
+// One command queue and fence per QueueType.
+class D3D12GpuTimeline : public IGpuTimeline {
+public:
+    bool Create(ID3D12Device* device);
+    void Destroy();
+
+    ID3D12CommandQueue* GetQueue(QueueType queue) const { return queues[static_cast<int>(queue)].Get(); }
+    ID3D12Fence* GetFence(QueueType queue) const { return fences[static_cast<int>(queue)].Get(); }
+
+    SyncPoint Signal(QueueType queue) override;
+    void QueueWait(QueueType waiter, SyncPoint point) override;
+    uint64_t GetCompletedValue(QueueType queue) const override;
+    void CpuWait(SyncPoint point) override;
+
+private:
+    ComPtr<ID3D12CommandQueue> queues[NUM_QUEUE_TYPES];
+    ComPtr<ID3D12Fence> fences[NUM_QUEUE_TYPES];
+    UINT64 fenceValues[NUM_QUEUE_TYPES] = {};
+    HANDLE waitEvent = nullptr;
+};
+
+// Records asset uploads on the copy queue. Staging buffers and allocators of a
+// submitted batch stay alive until its sync point completes, so callers never
+// have to block on the GPU after a copy.
+class UploadQueue {
+public:
+    bool Create(ID3D12Device* device, D3D12GpuTimeline* timeline, QueueScheduler* scheduler, GpuMemory* memory);
+    void Destroy();
+
+    // Opens a batch (or returns the one already open) and its COPY command list.
+    ID3D12GraphicsCommandList* Begin();
+    // Keeps a staging resource alive until the open batch has executed, then
+    // returns it to GpuMemory.
+    void KeepAlive(ComPtr<ID3D12Resource> resource);
+    // Closes and submits the open batch on the copy queue.
+    SyncPoint Submit();
+    // Recycles allocators and releases staging memory of completed batches.
+    void Collect();
+
+    bool IsOpen() const { return isOpen; }
+
+private:
+    struct Batch {
+        ComPtr<ID3D12CommandAllocator> allocator;
+        std::vector<ComPtr<ID3D12Resource>> staging;
+        SyncPoint syncPoint;
+    };
+
+    ID3D12Device* device = nullptr;
+    D3D12GpuTimeline* timeline = nullptr;
+    QueueScheduler* scheduler = nullptr;
+    GpuMemory* memory = nullptr;
+
+    ComPtr<ID3D12GraphicsCommandList> commandList;
+    Batch current;
+    bool isOpen = false;
+
+    std::vector<Batch> inFlight;
+    std::vector<ComPtr<ID3D12CommandAllocator>> freeAllocators;
+};
@@ -0,0 +1,137 @@
+#include "DescriptorAllocator.h"
+#include <algorithm>
+#include <cassert>
+
+void DescriptorIndexAllocator::Initialize(uint32_t capacity)
+{
+    assert(capacity > 0 && capacity < NIL && "Invalid descriptor capacity");
+
+    this->capacity = capacity;
+    nextFree.reset(new std::atomic<uint32_t>[capacity]);
+    for (uint32_t i = 0; i < capacity; ++i)
+        nextFree[i].store(NIL, std::memory_order_relaxed);
+
+    freeHead.store(NIL, std::memory_order_relaxed);
+    highWater.store(0, std::memory_order_relaxed);
+    liveCount.store(0, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(deferredMutex);
+    deferredFrees.clear();
+}
+
+uint32_t DescriptorIndexAllocator::Allocate()
+{
+    for (;;) {
+        uint32_t index = PopFree();
+        if (index != NIL) {
+            liveCount.fetch_add(1, std::memory_order_relaxed);
+            return index;
+        }
+
+        uint32_t hw = highWater.load(std::memory_order_relaxed);
+        while (hw < capacity) {
+            if (highWater.compare_exchange_weak(hw, hw + 1, std::memory_order_relaxed)) {
+                liveCount.fetch_add(1, std::memory_order_relaxed);
+                return hw;
+            }
+        }
+
+        // Another thread may have freed a slot while we raced for the bump pointer
+        if ((freeHead.load(std::memory_order_acquire) & 0xFFFFFFFFull) != NIL)
+            continue;
+
+        assert(false && "Descriptor heap exhausted");
+        return INVALID_DESCRIPTOR_INDEX;
+    }
+}
+
+void DescriptorIndexAllocator::Free(uint32_t index)
+{
+    assert(index < highWater.load(std::memory_order_relaxed) && "Freeing a descriptor that was never allocated");
+    liveCount.fetch_sub(1, std::memory_order_relaxed);
+    PushFree(index);
+}
+
+void DescriptorIndexAllocator::FreeDeferred(uint32_t index, uint64_t retireValue)
+{
+    std::lock_guard<std::mutex> lock(deferredMutex);
+    deferredFrees.push_back({ index, retireValue });
+}
+
+uint32_t DescriptorIndexAllocator::ProcessDeferredFrees(uint64_t completedValue)
+{
+    std::vector<uint32_t> ready;
+    {
+        std::lock_guard<std::mutex> lock(deferredMutex);
+        auto split = std::partition(deferredFrees.begin(), deferredFrees.end(), [completedValue](const DeferredFree& entry) {
+            return entry.retireValue > completedValue;
+        });
+        for (auto it = split; it != deferredFrees.end(); ++it)
+            ready.push_back(it->index);
+        deferredFrees.erase(split, deferredFrees.end());
+    }
+
+    for (uint32_t index : ready)
+        Free(index);
+    return static_cast<uint32_t>(ready.size());
+}
+
+size_t DescriptorIndexAllocator::GetPendingFreeCount() const
+{
+    std::lock_guard<std::mutex> lock(deferredMutex);
+    return deferredFrees.size();
+}
+
+uint32_t DescriptorIndexAllocator::PopFree()
+{
+    uint64_t head = freeHead.load(std::memory_order_acquire);
+    for (;;) {
+        const uint32_t index = static_cast<uint32_t>(head & 0xFFFFFFFFull);
+        if (index == NIL)
+            return NIL;
+
+        const uint32_t next = nextFree[index].load(std::memory_order_relaxed);
+        const uint64_t newHead = (((head >> 32) + 1) << 32) | next;
+        if (freeHead.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire))
+            return index;
+    }
+}
+
+void DescriptorIndexAllocator::PushFree(uint32_t index)
+{
+    uint64_t head = freeHead.load(std::memory_order_relaxed);
+    for (;;) {
+        nextFree[index].store(static_cast<uint32_t>(head & 0xFFFFFFFFull), std::memory_order_relaxed);
+        const uint64_t newHead = (((head >> 32) + 1) << 32) | index;
+        if (freeHead.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed))
+            return;
+    }
+}
+
+void TransientDescriptorRing::Initialize(uint32_t baseIndex, uint32_t descriptorsPerFrame, uint32_t frameCount)
+{
+    this->baseIndex = baseIndex;
+    this->descriptorsPerFrame = descriptorsPerFrame;
+    this->frameCount = frameCount;
+    frameBase = baseIndex;
+    peakUsage = 0;
+    offset.store(0, std::memory_order_relaxed);
+}
+
+void TransientDescriptorRing::BeginFrame(uint32_t frameSlot)
+{
+    assert(frameSlot < frameCount && "Frame slot out of range");
+    peakUsage = std::max(peakUsage, offset.load(std::memory_order_relaxed));
+    frameBase = baseIndex + frameSlot * descriptorsPerFrame;
+    offset.store(0, std::memory_order_relaxed);
+}
+
+uint32_t TransientDescriptorRing::Allocate(uint32_t count)
+{
+    const uint32_t first = offset.fetch_add(count, std::memory_order_relaxed);
+    if (first + count > descriptorsPerFrame) {
+        assert(false && "Transient descriptor window exhausted for this frame");
+        return INVALID_DESCRIPTOR_INDEX;
+    }
+    return frameBase + first;
+}
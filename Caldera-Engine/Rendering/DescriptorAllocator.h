@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+constexpr uint32_t INVALID_DESCRIPTOR_INDEX = ~0u;
+
+// Thread-safe allocator for persistent descriptor slots. Freed slots go onto a
+// lock-free (tagged Treiber) stack; untouched slots are handed out by a bump
+// pointer. The capacity is fixed: the heap behind it is created at full size
+// and never grows, so size it for the worst case. The high-water mark shows
+// how much of it a session actually needed.
+// Knows nothing about the device, so the index logic can be exercised without one.
+class DescriptorIndexAllocator {
+public:
+    void Initialize(uint32_t capacity);
+
+    // Returns INVALID_DESCRIPTOR_INDEX only when every slot is live.
+    uint32_t Allocate();
+    // Immediate free. Only safe when no in-flight GPU work references the slot.
+    void Free(uint32_t index);
+
+    // Returns the slot once the frame fence reaches 'retireValue'.
+    void FreeDeferred(uint32_t index, uint64_t retireValue);
+    // Recycles every deferred slot whose retire value is <= 'completedValue'.
+    uint32_t ProcessDeferredFrees(uint64_t completedValue);
+
+    uint32_t GetCapacity() const { return capacity; }
+    uint32_t GetLiveCount() const { return liveCount.load(std::memory_order_relaxed); }
+    // Slots ever handed out by the bump pointer
+    uint32_t GetHighWater() const { return highWater.load(std::memory_order_relaxed); }
+    size_t GetPendingFreeCount() const;
+
+private:
+    static constexpr uint32_t NIL = ~0u;
+
+    uint32_t PopFree();
+    void PushFree(uint32_t index);
+
+    struct DeferredFree {
+        uint32_t index;
+        uint64_t retireValue;
+    };
+
+    uint32_t capacity = 0;
+    std::unique_ptr<std::atomic<uint32_t>[]> nextFree;
+    std::atomic<uint64_t> freeHead{ NIL };  // (ABA tag << 32) | index
+    std::atomic<uint32_t> highWater{ 0 };
+    std::atomic<uint32_t> liveCount{ 0 };
+
+    mutable std::mutex deferredMutex;
+    std::vector<DeferredFree> deferredFrees;
+};
+
+// Per-frame linear allocator for descriptors that only live for one frame.
+// Each frame slot owns a fixed window of the heap; BeginFrame rewinds it once
+// the GPU is done with the frame that last used that slot.
+class TransientDescriptorRing {
+public:
+    void Initialize(uint32_t baseIndex, uint32_t descriptorsPerFrame, uint32_t frameCount);
+    void BeginFrame(uint32_t frameSlot);
+
+    // Returns the first of 'count' contiguous slots, or INVALID_DESCRIPTOR_INDEX if
+    // this frame's window is full.
+    uint32_t Allocate(uint32_t count = 1);
+
+    uint32_t GetUsedThisFrame() const { return offset.load(std::memory_order_relaxed); }
+    uint32_t GetPeakUsage() const { return peakUsage; }
+    uint32_t GetDescriptorsPerFrame() const { return descriptorsPerFrame; }
+
+private:
+    uint32_t baseIndex = 0;
+    uint32_t descriptorsPerFrame = 0;
+    uint32_t frameCount = 0;
+    uint32_t frameBase = 0;
+    uint32_t peakUsage = 0;
+    std::atomic<uint32_t> offset{ 0 };
+};
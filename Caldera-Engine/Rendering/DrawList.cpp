@@ -0,0 +1,165 @@
+#include "DrawList.h"
+#include "../Core/RadixSort.h"
+#include <cassert>
+#include <cstring>
+
+static constexpr uint32_t DRAW_KEY_MESH_SHIFT = 0;
+static constexpr uint32_t DRAW_KEY_MATERIAL_SHIFT = DRAW_KEY_MESH_SHIFT + DRAW_KEY_MESH_BITS;
+static constexpr uint32_t DRAW_KEY_PIPELINE_SHIFT = DRAW_KEY_MATERIAL_SHIFT + DRAW_KEY_MATERIAL_BITS;
+static constexpr uint32_t DRAW_KEY_PASS_SHIFT = 64 - DRAW_KEY_PASS_BITS;
+
+static uint64_t FieldMask(uint32_t bits) { return (1ull << bits) - 1; }
+
+uint64_t MakeDrawKey(DrawPass pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+{
+    if (!(depth > 0.0f))
+        depth = 0.0f;
+    if (depth > 1.0f)
+        depth = 1.0f;
+    uint64_t quantizedDepth = static_cast<uint64_t>(depth * float(FieldMask(DRAW_KEY_DEPTH_BITS)) + 0.5f);
+
+    uint64_t state = ((uint64_t(pipeline) & FieldMask(DRAW_KEY_PIPELINE_BITS)) << DRAW_KEY_PIPELINE_SHIFT)
+        | ((uint64_t(material) & FieldMask(DRAW_KEY_MATERIAL_BITS)) << DRAW_KEY_MATERIAL_SHIFT)
+        | ((uint64_t(mesh) & FieldMask(DRAW_KEY_MESH_BITS)) << DRAW_KEY_MESH_SHIFT);
+    uint64_t key = (uint64_t(pass) & FieldMask(DRAW_KEY_PASS_BITS)) << DRAW_KEY_PASS_SHIFT;
+
+    if (pass == DrawPass::Transparent) {
+        // Blending needs far to near, so depth outranks state
+        uint64_t farFirst = FieldMask(DRAW_KEY_DEPTH_BITS) - quantizedDepth;
+        return key | (farFirst << (DRAW_KEY_PASS_SHIFT - DRAW_KEY_DEPTH_BITS)) | state;
+    }
+    return key | (state << DRAW_KEY_DEPTH_BITS) | quantizedDepth;
+}
+
+void InstanceRing::Initialize(uint8_t* memory, uint64_t bytesPerFrame, uint32_t frameCount)
+{
+    assert(memory && frameCount > 0 && "Instance ring needs memory for at least one frame");
+    this->memory = memory;
+    this->bytesPerFrame = bytesPerFrame;
+    this->frameCount = frameCount;
+    windowStart = 0;
+    head = 0;
+}
+
+void InstanceRing::BeginFrame(uint32_t frameSlot)
+{
+    assert(frameSlot < frameCount && "Frame slot out of range");
+    windowStart = uint64_t(frameSlot) * bytesPerFrame;
+    head = windowStart;
+}
+
+uint64_t InstanceRing::Allocate(uint64_t size, uint64_t alignment)
+{
+    uint64_t offset = alignment > 1 ? (head + alignment - 1) / alignment * alignment : head;
+    if (offset + size > windowStart + bytesPerFrame)
+        return INVALID_OFFSET;
+    head = offset + size;
+    return offset;
+}
+
+void DrawListBuilder::Begin()
+{
+    renderables.clear();
+    draws.clear();
+    stats = DrawListStats();
+}
+
+void DrawListBuilder::Reserve(uint32_t count)
+{
+    renderables.reserve(count);
+}
+
+void DrawListBuilder::Add(const Renderable& renderable)
+{
+    renderables.push_back(renderable);
+}
+
+void DrawListBuilder::Build(InstanceRing& ring)
+{
+    const uint32_t count = static_cast<uint32_t>(renderables.size());
+    stats = DrawListStats();
+    stats.renderables = count;
+    draws.clear();
+    if (count == 0)
+        return;
+
+    keys.resize(count);
+    order.resize(count);
+    scratchKeys.resize(count);
+    scratchOrder.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const Renderable& renderable = renderables[i];
+        keys[i] = MakeDrawKey(renderable.pass, renderable.pipeline, renderable.material, renderable.mesh, renderable.depth);
+        order[i] = i;
+    }
+    RadixSort64(keys.data(), order.data(), scratchKeys.data(), scratchOrder.data(), count, pool);
+
+    // Sorted neighbours with the same pass, pipeline, material and mesh become one
+    // instanced draw. Transparent neighbours only match when nothing sorts between them,
+    // so merging never reorders blending.
+    const Renderable* previous = nullptr;
+    uint32_t i = 0;
+    while (i < count) {
+        const Renderable& first = renderables[order[i]];
+        uint32_t runEnd = i + 1;
+        while (runEnd < count) {
+            const Renderable& next = renderables[order[runEnd]];
+            if (next.pass != first.pass || next.pipeline != first.pipeline || next.material != first.material || next.mesh != first.mesh)
+                break;
+            ++runEnd;
+        }
+
+        // A run larger than what is left of the ring is cut short
+        uint64_t fitting = ring.GetRemainingBytes() / sizeof(DrawInstanceData);
+        uint32_t runLength = static_cast<uint32_t>(fitting < runEnd - i ? fitting : runEnd - i);
+        uint64_t offset = runLength ? ring.Allocate(uint64_t(runLength) * sizeof(DrawInstanceData), sizeof(DrawInstanceData)) : InstanceRing::INVALID_OFFSET;
+        if (offset == InstanceRing::INVALID_OFFSET) {
+            stats.droppedRenderables += count - i;
+            break;
+        }
+
+        DrawInstanceData* instances = reinterpret_cast<DrawInstanceData*>(ring.GetMemory() + offset);
+        for (uint32_t j = 0; j < runLength; ++j)
+            memcpy(&instances[j], &renderables[order[i + j]].instance, sizeof(DrawInstanceData));
+
+        InstancedDraw draw;
+        draw.pass = first.pass;
+        draw.pipeline = first.pipeline;
+        draw.material = first.material;
+        draw.mesh = first.mesh;
+        draw.firstInstance = static_cast<uint32_t>(offset / sizeof(DrawInstanceData));
+        draw.instanceCount = runLength;
+        draws.push_back(draw);
+
+        if (!previous || previous->pipeline != first.pipeline)
+            ++stats.pipelineChanges;
+        if (!previous || previous->material != first.material)
+            ++stats.materialChanges;
+        if (!previous || previous->mesh != first.mesh)
+            ++stats.meshChanges;
+        previous = &first;
+        i += runLength;
+    }
+    stats.drawCalls = static_cast<uint32_t>(draws.size());
+}
+
+void DrawListBuilder::ToSceneDraws(const DrawMesh* meshes, uint32_t meshCount, std::vector<SceneDraw>& outDraws) const
+{
+    outDraws.clear();
+    outDraws.reserve(draws.size());
+    for (const InstancedDraw& draw : draws) {
+        if (draw.mesh >= meshCount) {
+            assert(false && "Draw references a mesh outside the mesh table");
+            continue;
+        }
+        const DrawMesh& mesh = meshes[draw.mesh];
+        SceneDraw sceneDraw;
+        sceneDraw.indexCount = mesh.indexCount;
+        sceneDraw.firstIndex = mesh.firstIndex;
+        sceneDraw.baseVertex = mesh.baseVertex;
+        sceneDraw.materialIndex = draw.material;
+        sceneDraw.instanceCount = draw.instanceCount;
+        sceneDraw.firstInstance = draw.firstInstance;
+        outDraws.push_back(sceneDraw);
+    }
+}
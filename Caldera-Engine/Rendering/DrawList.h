@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "FramePasses.h"
+
+class TaskPool;
+
+// Scene draw submission. Renderables are sorted by a packed 64-bit key so draws
+// sharing pipeline, material and mesh end up next to each other, then runs of the
+// same mesh and material are merged into one instanced draw whose per-instance
+// data is written to a frame ring buffer.
+
+enum class DrawPass : uint32_t {
+    Opaque = 0,      // front to back, grouped by state
+    Transparent = 1, // back to front; state only breaks depth ties
+    Count
+};
+
+constexpr uint32_t DRAW_KEY_PASS_BITS = 4;
+constexpr uint32_t DRAW_KEY_PIPELINE_BITS = 12;
+constexpr uint32_t DRAW_KEY_MATERIAL_BITS = 16;
+constexpr uint32_t DRAW_KEY_MESH_BITS = 16;
+constexpr uint32_t DRAW_KEY_DEPTH_BITS = 16;
+static_assert(DRAW_KEY_PASS_BITS + DRAW_KEY_PIPELINE_BITS + DRAW_KEY_MATERIAL_BITS + DRAW_KEY_MESH_BITS + DRAW_KEY_DEPTH_BITS == 64,
+    "Draw key fields must fill 64 bits");
+
+// Opaque: pass | pipeline | material | mesh | depth.
+// Transparent: pass | inverted depth | pipeline | material | mesh.
+// 'depth' is normalized view depth, clamped to [0, 1]; ids are masked to their field.
+uint64_t MakeDrawKey(DrawPass pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+
+// Per-instance data written to the ring: a row-major 3x4 world matrix.
+struct DrawInstanceData {
+    float world[12] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0 };
+};
+static_assert(sizeof(DrawInstanceData) == 48, "DrawInstanceData is uploaded as three float4 rows");
+
+struct Renderable {
+    DrawPass pass = DrawPass::Opaque;
+    uint32_t pipeline = 0;
+    uint32_t material = 0;
+    uint32_t mesh = 0;    // index into the mesh table passed to ToSceneDraws
+    float depth = 0.0f;   // normalized view depth
+    DrawInstanceData instance;
+};
+
+// Index range of one mesh in the scene's shared vertex/index buffers.
+struct DrawMesh {
+    uint32_t indexCount = 0;
+    uint32_t firstIndex = 0;
+    int32_t baseVertex = 0;
+};
+
+struct InstancedDraw {
+    DrawPass pass = DrawPass::Opaque;
+    uint32_t pipeline = 0;
+    uint32_t material = 0;
+    uint32_t mesh = 0;
+    uint32_t firstInstance = 0;  // in DrawInstanceData elements from the ring's start
+    uint32_t instanceCount = 0;
+};
+
+struct DrawListStats {
+    uint32_t renderables = 0;
+    uint32_t drawCalls = 0;
+    uint32_t pipelineChanges = 0;
+    uint32_t materialChanges = 0;
+    uint32_t meshChanges = 0;
+    uint32_t droppedRenderables = 0; // ring buffer was full
+
+    // Fraction of draw calls saved by instancing, 0 when nothing was submitted.
+    float GetDrawCallReduction() const { return renderables ? 1.0f - float(drawCalls) / float(renderables) : 0.0f; }
+};
+
+// Linear allocator over caller-owned memory split into one window per frame in
+// flight. A window is reused once its frame slot comes around again, so the
+// caller must have waited for the GPU to finish with it before BeginFrame.
+class InstanceRing {
+public:
+    static constexpr uint64_t INVALID_OFFSET = ~0ull;
+
+    void Initialize(uint8_t* memory, uint64_t bytesPerFrame, uint32_t frameCount);
+    void BeginFrame(uint32_t frameSlot);
+    // Byte offset from GetMemory(), or INVALID_OFFSET if this frame's window is full.
+    uint64_t Allocate(uint64_t size, uint64_t alignment);
+
+    uint8_t* GetMemory() const { return memory; }
+    uint64_t GetBytesPerFrame() const { return bytesPerFrame; }
+    uint64_t GetUsedBytes() const { return head - windowStart; }
+    uint64_t GetRemainingBytes() const { return windowStart + bytesPerFrame - head; }
+
+private:
+    uint8_t* memory = nullptr;
+    uint64_t bytesPerFrame = 0;
+    uint32_t frameCount = 0;
+    uint64_t windowStart = 0;
+    uint64_t head = 0;
+};
+
+// Collects renderables for a frame and turns them into a sorted, instanced draw list.
+// Add is not thread-safe; Build sorts on the task pool when one is given.
+class DrawListBuilder {
+public:
+    void Initialize(TaskPool* pool = nullptr) { this->pool = pool; }
+
+    void Begin();
+    void Add(const Renderable& renderable);
+    void Reserve(uint32_t count);
+
+    // Sorts, merges and writes instance data into 'ring'. Once the ring is full the
+    // remaining renderables, in sort order, are dropped and counted in the stats.
+    void Build(InstanceRing& ring);
+
+    // Draw calls for the scene pass, resolving mesh ids through 'meshes'.
+    void ToSceneDraws(const DrawMesh* meshes, uint32_t meshCount, std::vector<SceneDraw>& outDraws) const;
+
+    const std::vector<InstancedDraw>& GetDraws() const { return draws; }
+    const DrawListStats& GetStats() const { return stats; }
+
+private:
+    TaskPool* pool = nullptr;
+    std::vector<Renderable> renderables;
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> order;
+    std::vector<uint64_t> scratchKeys;
+    std::vector<uint32_t> scratchOrder;
+    std::vector<InstancedDraw> draws;
+    DrawListStats stats;
+};
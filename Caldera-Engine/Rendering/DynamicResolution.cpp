@@ -0,0 +1,77 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+// Most steps a single increase may take, since raising the scale on an estimate overshoots more often
+static constexpr float MAX_INCREASE_STEPS = 2.0f;
+
+void DynamicResolutionController::Initialize(const DynamicResolutionSettings& settings)
+{
+    assert(settings.targetFrameMs > 0.0f && "Target frame time must be positive");
+    assert(settings.minScale > 0.0f && settings.minScale <= settings.maxScale && "Scale range is empty");
+    assert(settings.scaleStep > 0.0f && "Scale step must be positive");
+    assert(settings.increaseThreshold < settings.decreaseThreshold && "Thresholds leave no hysteresis band");
+    this->settings = settings;
+    Reset();
+}
+
+void DynamicResolutionController::Reset()
+{
+    scale = settings.maxScale;
+    stats = {};
+    settleRemaining = 0;
+    samplesSinceChange = 0;
+}
+
+float DynamicResolutionController::Quantize(float value) const
+{
+    // Rounded down so a drop always lands under the estimate; the bounds themselves are always reachable
+    const float stepped = std::floor(value / settings.scaleStep + 1e-3f) * settings.scaleStep;
+    return std::clamp(stepped, settings.minScale, settings.maxScale);
+}
+
+bool DynamicResolutionController::Update(float gpuFrameMs)
+{
+    if (!(gpuFrameMs > 0.0f))
+        return false;
+    stats.lastFrameMs = gpuFrameMs;
+    ++stats.samples;
+
+    // Frames queued before the change still report the old scale's cost
+    if (settleRemaining > 0) {
+        --settleRemaining;
+        return false;
+    }
+
+    // A plain mean until the average holds more history than the smoothing would keep,
+    // so the first noisy sample after a change doesn't decide the next one
+    ++samplesSinceChange;
+    const float weight = std::max(settings.smoothing, 1.0f / static_cast<float>(samplesSinceChange));
+    stats.smoothedFrameMs += (gpuFrameMs - stats.smoothedFrameMs) * weight;
+    if (samplesSinceChange < settings.minSamples)
+        return false;
+
+    const float target = settings.targetFrameMs;
+    const bool overBudget = stats.smoothedFrameMs > target * settings.decreaseThreshold;
+    const bool underBudget = stats.smoothedFrameMs < target * settings.increaseThreshold;
+    if (!overBudget && !underBudget)
+        return false;
+
+    // Cost scales with area, so the linear scale moves by the square root of the ratio
+    float wanted = scale * std::sqrt(target * settings.aimFraction / stats.smoothedFrameMs);
+    if (underBudget)
+        wanted = std::min(wanted, scale + settings.scaleStep * MAX_INCREASE_STEPS);
+    const float next = Quantize(wanted);
+    if ((overBudget && next >= scale) || (underBudget && next <= scale))
+        return false;
+
+    if (next < scale)
+        ++stats.decreases;
+    else
+        ++stats.increases;
+    scale = next;
+    settleRemaining = settings.settleFrames;
+    samplesSinceChange = 0;
+    return true;
+}
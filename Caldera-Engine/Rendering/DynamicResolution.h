@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+// Picks the scene's render scale from measured GPU frame times. GPU cost is
+// assumed to follow the pixel count, so the scale moves by the square root of
+// the budget ratio. Samples are smoothed, the scale only drops once the budget
+// is exceeded and only rises once there is clear headroom, and after each change
+// the controller waits for frames rendered at the new scale before judging again.
+
+struct DynamicResolutionSettings {
+    float targetFrameMs = 16.0f;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    float scaleStep = 0.05f;           // scales are multiples of this, so tiny corrections are ignored
+    float smoothing = 0.15f;           // weight of the newest sample in the running average
+    float decreaseThreshold = 1.0f;    // drop the scale above targetFrameMs * this
+    float increaseThreshold = 0.8f;    // raise it below targetFrameMs * this
+    float aimFraction = 0.9f;          // a new scale aims for targetFrameMs * this
+    uint32_t settleFrames = 8;         // samples ignored after a change, covering frames still in flight
+    uint32_t minSamples = 4;           // samples averaged before the first decision after a change
+};
+
+struct DynamicResolutionStats {
+    float lastFrameMs = 0.0f;
+    float smoothedFrameMs = 0.0f;
+    uint64_t samples = 0;
+    uint32_t decreases = 0;
+    uint32_t increases = 0;
+};
+
+class DynamicResolutionController {
+public:
+    void Initialize(const DynamicResolutionSettings& settings);
+    // Back to the maximum scale with no history.
+    void Reset();
+
+    // Feeds the GPU time of one frame rendered at the current scale. Non-positive
+    // samples (timer not ready) are skipped. Returns true when the scale changed.
+    bool Update(float gpuFrameMs);
+
+    float GetScale() const { return scale; }
+    const DynamicResolutionSettings& GetSettings() const { return settings; }
+    const DynamicResolutionStats& GetStats() const { return stats; }
+
+private:
+    float Quantize(float value) const;
+
+    DynamicResolutionSettings settings;
+    DynamicResolutionStats stats;
+    float scale = 1.0f;
+    uint32_t settleRemaining = 0;
+    uint32_t samplesSinceChange = 0;
+};
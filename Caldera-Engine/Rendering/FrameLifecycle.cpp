@@ -0,0 +1,87 @@
+#include "FrameLifecycle.h"
+#include <cassert>
+
+void FrameLifecycle::Initialize(QueueScheduler* scheduler, const IFrameClock* clock, uint32_t slotCount)
+{
+    assert(scheduler && clock && "Scheduler or clock is null");
+    assert(slotCount > 0 && slotCount <= MAX_FRAME_SLOTS && "Frame slot count out of range");
+    this->scheduler = scheduler;
+    this->clock = clock;
+    this->slotCount = slotCount;
+
+    for (Slot& slot : slots)
+        slot = {};
+    frameNumber = 0;
+    frameOpen = false;
+    stats = {};
+}
+
+void FrameLifecycle::Shutdown()
+{
+    if (!scheduler)
+        return;
+    for (uint32_t i = 0; i < slotCount; ++i)
+        scheduler->CpuWait({ QueueType::Graphics, slots[i].fenceValue });
+    // Releases may queue more into a slot already run; the GPU is idle, so go round until none are left
+    while (GetPendingReleaseCount() > 0)
+        for (uint32_t i = 0; i < slotCount; ++i)
+            RunReleases(slots[i]);
+    frameOpen = false;
+}
+
+uint32_t FrameLifecycle::BeginFrame()
+{
+    assert(!frameOpen && "BeginFrame called twice without EndFrame");
+    ++frameNumber;
+    frameOpen = true;
+    Slot& slot = slots[GetFrameSlot()];
+
+    if (!scheduler->IsComplete({ QueueType::Graphics, slot.fenceValue })) {
+        const uint64_t start = clock->NowMicroseconds();
+        scheduler->CpuWait({ QueueType::Graphics, slot.fenceValue });
+        stats.lastWaitMs = static_cast<float>(clock->NowMicroseconds() - start) / 1000.0f;
+        ++stats.blockedFrames;
+    } else {
+        stats.lastWaitMs = 0.0f;
+    }
+    if (stats.lastWaitMs > stats.maxWaitMs)
+        stats.maxWaitMs = stats.lastWaitMs;
+    stats.averageWaitMs += (stats.lastWaitMs - stats.averageWaitMs) / static_cast<float>(frameNumber);
+
+    // Everything queued while the slot's previous frame was current is now unreferenced
+    RunReleases(slot);
+    return GetFrameSlot();
+}
+
+void FrameLifecycle::EndFrame(SyncPoint frameDone)
+{
+    assert(frameOpen && "EndFrame called without BeginFrame");
+    assert(frameDone.queue == QueueType::Graphics && "Frames retire on the graphics queue");
+    slots[GetFrameSlot()].fenceValue = frameDone.value;
+    frameOpen = false;
+}
+
+void FrameLifecycle::DeferRelease(std::function<void()> release)
+{
+    // Between frames the last ended frame is the newest one that can reference it
+    slots[GetFrameSlot()].releases.push_back(std::move(release));
+    ++stats.releasesQueued;
+}
+
+size_t FrameLifecycle::GetPendingReleaseCount() const
+{
+    size_t count = 0;
+    for (uint32_t i = 0; i < slotCount; ++i)
+        count += slots[i].releases.size();
+    return count;
+}
+
+void FrameLifecycle::RunReleases(Slot& slot)
+{
+    // Releases may queue further releases, which land in the current slot's fresh list
+    std::vector<std::function<void()>> releases;
+    releases.swap(slot.releases);
+    for (std::function<void()>& release : releases)
+        release();
+    stats.releasesRun += releases.size();
+}
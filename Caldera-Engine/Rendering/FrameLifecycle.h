@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "QueueSync.h"
+#include "FramePacer.h"
+
+// Numbers frames monotonically and owns the graphics fence of each frame slot.
+// Frame N records into slot N % slotCount; BeginFrame waits for the fence of
+// the frame that last used the slot, so per-slot resources (command allocators,
+// upload rings, transient descriptors) are never overwritten while the GPU
+// reads them. Releases queued during a frame run once that frame has retired.
+
+struct FrameLifecycleStats {
+    float lastWaitMs = 0.0f;     // time the last BeginFrame spent on the slot fence
+    float averageWaitMs = 0.0f;
+    float maxWaitMs = 0.0f;
+    uint64_t blockedFrames = 0;  // frames whose slot was still in use by the GPU
+    uint64_t releasesQueued = 0;
+    uint64_t releasesRun = 0;
+};
+
+class FrameLifecycle {
+public:
+    static constexpr uint32_t MAX_FRAME_SLOTS = 8;
+
+    void Initialize(QueueScheduler* scheduler, const IFrameClock* clock, uint32_t slotCount);
+    // Waits for the GPU and runs every queued release.
+    void Shutdown();
+
+    // Starts the next frame: waits until its slot has retired, then runs the
+    // releases queued by the frame that used it before. Returns the slot.
+    uint32_t BeginFrame();
+    // Call after submitting the frame's last graphics work.
+    void EndFrame(SyncPoint frameDone);
+
+    // Runs 'release' once the GPU has finished every frame submitted so far,
+    // including the one being recorded.
+    void DeferRelease(std::function<void()> release);
+
+    // The frame being recorded, or the last one ended between frames. Starts at 1.
+    uint64_t GetFrameNumber() const { return frameNumber; }
+    uint32_t GetFrameSlot() const { return static_cast<uint32_t>(frameNumber % slotCount); }
+    uint32_t GetSlotCount() const { return slotCount; }
+    bool IsFrameOpen() const { return frameOpen; }
+    // Graphics fence value of the slot's last frame; 0 if it never ran.
+    uint64_t GetSlotFenceValue(uint32_t slot) const { return slots[slot].fenceValue; }
+    size_t GetPendingReleaseCount() const;
+
+    const FrameLifecycleStats& GetStats() const { return stats; }
+
+private:
+    struct Slot {
+        uint64_t fenceValue = 0;
+        std::vector<std::function<void()>> releases;
+    };
+
+    void RunReleases(Slot& slot);
+
+    QueueScheduler* scheduler = nullptr;
+    const IFrameClock* clock = nullptr;
+    uint32_t slotCount = 1;
+    Slot slots[MAX_FRAME_SLOTS];
+    uint64_t frameNumber = 0;
+    bool frameOpen = false;
+    FrameLifecycleStats stats;
+};
@@ -0,0 +1,147 @@
+#include "FramePacer.h"
+#include <cassert>
+
+// Weight of the newest sample in the running latency averages
+static constexpr float LATENCY_SMOOTHING = 0.1f;
+
+static float ToMilliseconds(uint64_t microseconds)
+{
+    return static_cast<float>(microseconds) / 1000.0f;
+}
+
+static void Smooth(float& average, float sample, bool first)
+{
+    average = first ? sample : average + (sample - average) * LATENCY_SMOOTHING;
+}
+
+const char* GetLatencyModeName(LatencyMode mode)
+{
+    switch (mode) {
+    case LatencyMode::LowLatency: return "Low latency";
+    case LatencyMode::Throughput: return "Throughput";
+    case LatencyMode::Uncapped: return "Uncapped";
+    default: return "Unknown";
+    }
+}
+
+LatencyModeSettings GetLatencyModeSettings(LatencyMode mode, uint32_t frameCapacity, bool tearingSupported)
+{
+    LatencyModeSettings settings;
+    switch (mode) {
+    case LatencyMode::LowLatency:
+        settings.maxFramesInFlight = 1;
+        break;
+    case LatencyMode::Uncapped:
+        settings.maxFramesInFlight = frameCapacity;
+        settings.syncInterval = 0;
+        settings.allowTearing = tearingSupported;
+        break;
+    default:
+        settings.maxFramesInFlight = frameCapacity;
+        break;
+    }
+    return settings;
+}
+
+uint64_t SteadyFrameClock::NowMicroseconds() const
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void FramePacer::Initialize(QueueScheduler* scheduler, const IFrameClock* clock, IPresentLatencyWaiter* waiter,
+    uint32_t frameCapacity, bool tearingSupported, LatencyMode mode)
+{
+    assert(scheduler && clock && "Scheduler or clock is null");
+    assert(frameCapacity > 0 && frameCapacity <= MAX_TRACKED_FRAMES && "Frame capacity out of range");
+    this->scheduler = scheduler;
+    this->clock = clock;
+    this->waiter = waiter;
+    this->frameCapacity = frameCapacity;
+    this->tearingSupported = tearingSupported;
+
+    for (FrameRecord& record : records)
+        record = {};
+    frameNumber = 0;
+    frameOpen = false;
+    completedFrames = 0;
+    stats = {};
+    requestedMode = mode;
+    ApplyMode(mode);
+}
+
+void FramePacer::ApplyMode(LatencyMode newMode)
+{
+    mode = newMode;
+    settings = GetLatencyModeSettings(newMode, frameCapacity, tearingSupported);
+    if (waiter)
+        waiter->SetMaximumLatency(settings.maxFramesInFlight);
+}
+
+void FramePacer::BeginFrame()
+{
+    assert(!frameOpen && "BeginFrame called twice without EndFrame");
+    if (requestedMode != mode)
+        ApplyMode(requestedMode);
+
+    const uint64_t start = clock->NowMicroseconds();
+
+    // The swap chain first, so the fence wait below rarely has anything left to wait for
+    if (waiter && !waiter->Wait(PRESENT_WAIT_TIMEOUT_MS))
+        ++stats.waitTimeouts;
+
+    // The frame that drops out of the cap must have finished on the GPU
+    frameNumber = stats.frameNumber + 1;
+    if (frameNumber > settings.maxFramesInFlight) {
+        const FrameRecord& oldest = GetRecord(frameNumber - settings.maxFramesInFlight);
+        if (oldest.submitted && oldest.frameNumber == frameNumber - settings.maxFramesInFlight)
+            scheduler->CpuWait({ QueueType::Graphics, oldest.fenceValue });
+    }
+
+    const uint64_t now = clock->NowMicroseconds();
+    stats.waitMs = ToMilliseconds(now - start);
+    CollectCompleted(now);
+
+    stats.framesInFlight = 0;
+    for (const FrameRecord& record : records)
+        stats.framesInFlight += record.submitted && !record.completed ? 1 : 0;
+
+    // Input is sampled from here on, so this is where the frame's latency starts
+    FrameRecord& record = GetRecord(frameNumber);
+    record = {};
+    record.frameNumber = frameNumber;
+    record.inputTime = now;
+    stats.frameNumber = frameNumber;
+    frameOpen = true;
+}
+
+void FramePacer::EndFrame(SyncPoint frameDone)
+{
+    assert(frameOpen && "EndFrame called without BeginFrame");
+    assert(frameDone.queue == QueueType::Graphics && "Frames are paced on the graphics queue");
+    FrameRecord& record = GetRecord(frameNumber);
+    record.fenceValue = frameDone.value;
+    record.submitted = frameDone.IsValid();
+
+    const float latency = ToMilliseconds(clock->NowMicroseconds() - record.inputTime);
+    Smooth(stats.averageInputToPresentMs, latency, frameNumber == 1);
+    stats.inputToPresentMs = latency;
+    frameOpen = false;
+}
+
+void FramePacer::CollectCompleted(uint64_t now)
+{
+    uint64_t newest = 0;
+    for (FrameRecord& record : records) {
+        if (!record.submitted || record.completed || !scheduler->IsComplete({ QueueType::Graphics, record.fenceValue }))
+            continue;
+
+        record.completed = true;
+        const float latency = ToMilliseconds(now - record.inputTime);
+        Smooth(stats.averageInputToCompleteMs, latency, completedFrames++ == 0);
+        if (record.frameNumber > newest) {
+            newest = record.frameNumber;
+            stats.inputToCompleteMs = latency;
+        }
+    }
+}
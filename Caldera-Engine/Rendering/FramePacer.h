@@ -0,0 +1,131 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include "QueueSync.h"
+
+// Decides when the CPU may start a frame and how it is presented. Each latency
+// mode caps the frames queued ahead of the GPU and the display; the pacer blocks
+// on the swap chain's latency waitable and then on the graphics fence of the
+// frame that falls out of the cap. Input-to-present latency is measured from
+// the moment a frame is allowed to start, which is when it samples input.
+
+enum class LatencyMode : uint8_t {
+    LowLatency = 0,  // one frame in flight, vsync
+    Throughput,      // every frame slot in flight, vsync
+    Uncapped,        // every frame slot in flight, no vsync, tearing when supported
+    Count
+};
+
+const char* GetLatencyModeName(LatencyMode mode);
+
+struct LatencyModeSettings {
+    uint32_t maxFramesInFlight = 1;
+    uint32_t syncInterval = 1;
+    bool allowTearing = false;
+};
+
+// 'frameCapacity' is how many frames the renderer has resources for.
+LatencyModeSettings GetLatencyModeSettings(LatencyMode mode, uint32_t frameCapacity, bool tearingSupported);
+
+// Time source in microseconds. Pacing logic never reads the system clock directly.
+class IFrameClock {
+public:
+    virtual ~IFrameClock() = default;
+    virtual uint64_t NowMicroseconds() const = 0;
+};
+
+class SteadyFrameClock : public IFrameClock {
+public:
+    uint64_t NowMicroseconds() const override;
+};
+
+// Clock that only moves when told to, for driving the pacer in simulation.
+class ManualFrameClock : public IFrameClock {
+public:
+    uint64_t NowMicroseconds() const override { return now; }
+    void Advance(uint64_t microseconds) { now += microseconds; }
+
+private:
+    uint64_t now = 0;
+};
+
+// The swap chain side of pacing: DXGI's frame latency waitable object.
+class IPresentLatencyWaiter {
+public:
+    virtual ~IPresentLatencyWaiter() = default;
+
+    virtual void SetMaximumLatency(uint32_t frames) = 0;
+    // Blocks until the swap chain can queue another present. False on timeout.
+    virtual bool Wait(uint32_t timeoutMs) = 0;
+};
+
+struct PresentParams {
+    uint32_t syncInterval = 1;
+    bool allowTearing = false;
+};
+
+struct FramePacingStats {
+    uint64_t frameNumber = 0;           // frames begun so far
+    uint32_t framesInFlight = 0;        // submitted frames the GPU had not finished at the last BeginFrame
+    float waitMs = 0.0f;                // time BeginFrame spent blocked for the last frame
+    float inputToPresentMs = 0.0f;      // last frame, CPU side only
+    float averageInputToPresentMs = 0.0f;
+    float inputToCompleteMs = 0.0f;     // last frame seen finished on the GPU, as observed at BeginFrame
+    float averageInputToCompleteMs = 0.0f;
+    uint32_t waitTimeouts = 0;
+};
+
+class FramePacer {
+public:
+    // At most this many frames are tracked for latency and fence waits.
+    static constexpr uint32_t MAX_TRACKED_FRAMES = 8;
+    // A latency waitable that stays unsignaled this long is given up on for the frame.
+    static constexpr uint32_t PRESENT_WAIT_TIMEOUT_MS = 1000;
+
+    // 'waiter' may be null, in which case only the graphics fence paces frames.
+    void Initialize(QueueScheduler* scheduler, const IFrameClock* clock, IPresentLatencyWaiter* waiter,
+        uint32_t frameCapacity, bool tearingSupported, LatencyMode mode = LatencyMode::Throughput);
+
+    // Takes effect at the next BeginFrame.
+    void SetMode(LatencyMode mode) { requestedMode = mode; }
+    LatencyMode GetMode() const { return mode; }
+    const LatencyModeSettings& GetSettings() const { return settings; }
+
+    // Blocks until the current mode allows another frame to start.
+    void BeginFrame();
+    PresentParams GetPresentParams() const { return { settings.syncInterval, settings.allowTearing }; }
+    // Call right after Present with the graphics sync point of the frame's work.
+    void EndFrame(SyncPoint frameDone);
+
+    const FramePacingStats& GetStats() const { return stats; }
+
+private:
+    struct FrameRecord {
+        uint64_t frameNumber = 0;
+        uint64_t fenceValue = 0;
+        uint64_t inputTime = 0;
+        bool submitted = false;
+        bool completed = false;
+    };
+
+    void ApplyMode(LatencyMode newMode);
+    void CollectCompleted(uint64_t now);
+    FrameRecord& GetRecord(uint64_t frameNumber) { return records[frameNumber % MAX_TRACKED_FRAMES]; }
+
+    QueueScheduler* scheduler = nullptr;
+    const IFrameClock* clock = nullptr;
+    IPresentLatencyWaiter* waiter = nullptr;
+    uint32_t frameCapacity = 1;
+    bool tearingSupported = false;
+
+    LatencyMode mode = LatencyMode::Throughput;
+    LatencyMode requestedMode = LatencyMode::Throughput;
+    LatencyModeSettings settings;
+
+    FrameRecord records[MAX_TRACKED_FRAMES];
+    uint64_t frameNumber = 0;  // the frame between BeginFrame and EndFrame
+    bool frameOpen = false;
+    uint64_t completedFrames = 0;
+    FramePacingStats stats;
+};
@@ -0,0 +1,30 @@
+#include "FramePacerD3D12.h"
+
+bool D3D12SwapChainLatencyWaiter::Create(IDXGISwapChain3* swapChain)
+{
+    Destroy();
+    this->swapChain = swapChain;
+    waitableObject = swapChain->GetFrameLatencyWaitableObject();
+    return waitableObject != nullptr;
+}
+
+void D3D12SwapChainLatencyWaiter::Destroy()
+{
+    if (waitableObject)
+        CloseHandle(waitableObject);
+    waitableObject = nullptr;
+    swapChain.Reset();
+}
+
+void D3D12SwapChainLatencyWaiter::SetMaximumLatency(uint32_t frames)
+{
+    if (swapChain)
+        swapChain->SetMaximumFrameLatency(frames);
+}
+
+bool D3D12SwapChainLatencyWaiter::Wait(uint32_t timeoutMs)
+{
+    if (!waitableObject)
+        return true;
+    return WaitForSingleObjectEx(waitableObject, timeoutMs, TRUE) == WAIT_OBJECT_0;
+}
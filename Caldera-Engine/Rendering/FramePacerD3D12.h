@@ -0,0 +1,24 @@
+#pragma once
+#include <windows.h>
+#include <dxgi1_5.h>
+#include <wrl/client.h>
+#include "FramePacer.h"
+
+using namespace Microsoft::WRL;
+
+// Paces frames on the swap chain's frame latency waitable object. The swap
+// chain must be created with DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT.
+class D3D12SwapChainLatencyWaiter : public IPresentLatencyWaiter {
+public:
+    ~D3D12SwapChainLatencyWaiter() { Destroy(); }
+
+    bool Create(IDXGISwapChain3* swapChain);
+    void Destroy();
+
+    void SetMaximumLatency(uint32_t frames) override;
+    bool Wait(uint32_t timeoutMs) override;
+
+private:
+    ComPtr<IDXGISwapChain3> swapChain;
+    HANDLE waitableObject = nullptr;
+};
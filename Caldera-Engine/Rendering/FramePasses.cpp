@@ -0,0 +1,168 @@
+#include "FramePasses.h"
+#include <cstring>
+
+void AddFramePasses(RenderGraph& graph, IRHICommandList& cmd, const FrameSetup& setup)
+{
+    RGResourceHandle backBuffer = graph.ImportTexture("BackBuffer", setup.backBufferDesc,
+        RGState::Present, RGState::Present, setup.backBuffer);
+
+    const bool offscreen = setup.sceneColor != nullptr;
+    const RGTextureDesc& sceneDesc = offscreen ? setup.sceneColorDesc : setup.backBufferDesc;
+    RGResourceHandle sceneColor = offscreen
+        ? graph.ImportTexture("SceneColor", sceneDesc, RGState::ShaderResource, RGState::ShaderResource, setup.sceneColor)
+        : backBuffer;
+
+    // Without a persistent depth target, depth only lives for the scene pass as a transient
+    RGTextureDesc depthDesc = sceneDesc;
+    depthDesc.format = setup.depthFormat;
+    depthDesc.isDepth = true;
+    depthDesc.clearValue[0] = 1.0f;
+    RGResourceHandle sceneDepth = setup.sceneDepth
+        ? graph.ImportTexture("SceneDepth", depthDesc, RGState::DepthWrite, RGState::DepthWrite, setup.sceneDepth)
+        : graph.CreateTexture("SceneDepth", depthDesc);
+
+    const RHIViewport viewport = setup.viewport;
+    const SceneDrawParams scene = setup.scene;
+    ParallelRecorder* recorder = setup.recorder;
+    float clearColor[4];
+    for (int i = 0; i < 4; ++i)
+        clearColor[i] = setup.clearColor[i];
+
+    RHIRect scissor;
+    scissor.left = static_cast<int32_t>(viewport.x);
+    scissor.top = static_cast<int32_t>(viewport.y);
+    scissor.right = static_cast<int32_t>(viewport.x + viewport.width);
+    scissor.bottom = static_cast<int32_t>(viewport.y + viewport.height);
+
+    const bool gpuDriven = setup.indirect != nullptr;
+    IndirectSceneParams indirect;
+    if (gpuDriven) {
+        indirect = *setup.indirect;
+        graph.AddPass("GpuCull",
+            [](RGPassBuilder& builder) {
+                // Writes buffers the graph doesn't track; the scene pass after it consumes them
+                builder.SetSideEffects();
+            },
+            [&cmd, indirect](const RGPassContext&) {
+                RHIBarrier toWrite[2];
+                toWrite[0].resource = indirect.countBuffer;
+                toWrite[0].before = RGState::IndirectArgument;
+                toWrite[0].after = RGState::CopyDest;
+                toWrite[1].resource = indirect.commandBuffer;
+                toWrite[1].before = RGState::IndirectArgument;
+                toWrite[1].after = RGState::UnorderedAccess;
+                cmd.Barriers(toWrite, 2);
+                cmd.CopyBuffer(indirect.countBuffer, 0, indirect.countResetBuffer, 0, sizeof(uint32_t));
+
+                RHIBarrier countToUav;
+                countToUav.resource = indirect.countBuffer;
+                countToUav.before = RGState::CopyDest;
+                countToUav.after = RGState::UnorderedAccess;
+                cmd.Barriers(&countToUav, 1);
+
+                uint32_t constants[CULL_CONSTANT_COUNT];
+                memcpy(constants, &indirect.constants, sizeof(constants));
+                cmd.SetDescriptorHeap();
+                cmd.SetPipeline(indirect.cullPipeline);
+                cmd.SetRootConstants(CULL_ROOT_CONSTANTS, constants, CULL_CONSTANT_COUNT);
+                cmd.SetRootShaderResource(CULL_ROOT_OBJECTS, indirect.objectBuffer);
+                cmd.SetRootUnorderedAccess(CULL_ROOT_COMMANDS, indirect.commandBuffer);
+                cmd.SetRootUnorderedAccess(CULL_ROOT_DRAW_COUNT, indirect.countBuffer);
+                cmd.SetDescriptorTable(CULL_ROOT_BINDLESS_TABLE, 0);
+                cmd.Dispatch((indirect.constants.objectCount + CULL_THREAD_GROUP_SIZE - 1) / CULL_THREAD_GROUP_SIZE, 1, 1);
+
+                RHIBarrier toIndirect[2];
+                toIndirect[0].resource = indirect.commandBuffer;
+                toIndirect[0].before = RGState::UnorderedAccess;
+                toIndirect[0].after = RGState::IndirectArgument;
+                toIndirect[1].resource = indirect.countBuffer;
+                toIndirect[1].before = RGState::UnorderedAccess;
+                toIndirect[1].after = RGState::IndirectArgument;
+                cmd.Barriers(toIndirect, 2);
+            });
+    }
+
+    graph.AddPass("Scene",
+        [&](RGPassBuilder& builder) {
+            builder.Write(sceneColor, RGState::RenderTarget);
+            builder.Write(sceneDepth, RGState::DepthWrite);
+        },
+        [&cmd, sceneColor, sceneDepth, viewport, scissor, scene, recorder, clearColor, gpuDriven, indirect](const RGPassContext& ctx) {
+            RHIResourceId color = ctx.backend->GetResourceId(*ctx.graph, sceneColor);
+            RHIResourceId depth = ctx.backend->GetResourceId(*ctx.graph, sceneDepth);
+            cmd.SetRenderTargets(&color, 1, depth);
+            cmd.ClearRenderTarget(color, clearColor);
+            cmd.ClearDepth(depth, 1.0f);
+            cmd.SetViewport(viewport);
+            cmd.SetScissor(scissor);
+
+            // The bindless table lives in this heap; it stays bound for the whole frame
+            cmd.SetDescriptorHeap();
+
+            if (scene.pipeline == RHI_NULL_PIPELINE)
+                return;
+
+            const bool hasGeometry = scene.vertexBuffer != RHI_NULL_RESOURCE && scene.indexBuffer != RHI_NULL_RESOURCE && scene.materialBuffer != ~0u;
+            ParallelRecorder::RecordFn recordDraws = [&](IRHICommandList& list, DrawRange range, bool secondary) {
+                // Secondaries inherit nothing from the primary list
+                if (secondary) {
+                    list.SetRenderTargets(&color, 1, depth);
+                    list.SetViewport(viewport);
+                    list.SetScissor(scissor);
+                    list.SetDescriptorHeap();
+                }
+                list.SetPipeline(scene.pipeline);
+                list.SetDescriptorTable(SCENE_ROOT_BINDLESS_TABLE, 0);
+                list.SetVertexBuffer(scene.vertexBuffer, scene.vertexStride, scene.vertexBufferSize);
+                list.SetIndexBuffer(scene.indexBuffer, scene.indexBufferSize, true);
+
+                // Per draw only the material indices change
+                for (uint32_t i = range.first; i < range.first + range.count; ++i) {
+                    const SceneDraw& draw = scene.draws[i];
+                    const uint32_t drawConstants[2] = { scene.materialBuffer, draw.materialIndex };
+                    list.SetRootConstants(SCENE_ROOT_DRAW_CONSTANTS, drawConstants, 2);
+                    list.DrawIndexed(draw.indexCount, draw.instanceCount, draw.firstIndex, draw.baseVertex, draw.firstInstance);
+                }
+            };
+
+            if (hasGeometry && gpuDriven) {
+                // One call for every object that survived culling; each command sets its material index
+                cmd.SetPipeline(scene.pipeline);
+                cmd.SetDescriptorTable(SCENE_ROOT_BINDLESS_TABLE, 0);
+                cmd.SetVertexBuffer(scene.vertexBuffer, scene.vertexStride, scene.vertexBufferSize);
+                cmd.SetIndexBuffer(scene.indexBuffer, scene.indexBufferSize, true);
+                const uint32_t drawConstants[2] = { scene.materialBuffer, 0 };
+                cmd.SetRootConstants(SCENE_ROOT_DRAW_CONSTANTS, drawConstants, 2);
+                cmd.DrawIndexedIndirect(indirect.commandBuffer, 0, indirect.maxObjects, indirect.countBuffer, 0);
+            }
+            else if (!hasGeometry || scene.drawCount == 0) {
+                cmd.SetPipeline(scene.pipeline);
+                cmd.SetDescriptorTable(SCENE_ROOT_BINDLESS_TABLE, 0);
+            }
+            else if (recorder) {
+                recorder->Record(cmd, scene.drawCount, recordDraws);
+            }
+            else {
+                recordDraws(cmd, { 0, scene.drawCount }, false);
+            }
+        });
+
+    if (!setup.recordUi)
+        return;
+
+    std::function<void(IRHICommandList&)> recordUi = setup.recordUi;
+    graph.AddPass("UI",
+        [&](RGPassBuilder& builder) {
+            // The UI draws the offscreen scene as an image
+            if (offscreen)
+                builder.Read(sceneColor, RGState::ShaderResource);
+            builder.Write(backBuffer, RGState::RenderTarget);
+        },
+        [&cmd, backBuffer, recordUi, offscreen, clearColor](const RGPassContext& ctx) {
+            RHIResourceId color = ctx.backend->GetResourceId(*ctx.graph, backBuffer);
+            cmd.SetRenderTargets(&color, 1, RHI_NULL_RESOURCE);
+            if (offscreen)
+                cmd.ClearRenderTarget(color, clearColor);
+            recordUi(cmd);
+        });
+}
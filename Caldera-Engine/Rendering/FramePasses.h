@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include "RHI.h"
+#include "RenderGraph.h"
+#include "ParallelRecorder.h"
+#include "GpuCulling.h"
+
+// Root parameter slots of the scene pipeline's root signature.
+constexpr uint32_t SCENE_ROOT_DRAW_CONSTANTS = 0;
+constexpr uint32_t SCENE_ROOT_BINDLESS_TABLE = 1;
+
+// Root parameter slots of the culling compute shader.
+constexpr uint32_t CULL_ROOT_CONSTANTS = 0;
+constexpr uint32_t CULL_ROOT_OBJECTS = 1;
+constexpr uint32_t CULL_ROOT_COMMANDS = 2;
+constexpr uint32_t CULL_ROOT_DRAW_COUNT = 3;
+constexpr uint32_t CULL_ROOT_BINDLESS_TABLE = 4;
+
+struct SceneDraw {
+    uint32_t indexCount = 0;
+    uint32_t firstIndex = 0;
+    int32_t baseVertex = 0;
+    uint32_t materialIndex = 0;
+    uint32_t instanceCount = 1;
+    uint32_t firstInstance = 0;
+};
+
+// Indexed draws of the scene sharing one mesh buffer pair. Skipped while 'pipeline' is null.
+struct SceneDrawParams {
+    RHIPipelineId pipeline = RHI_NULL_PIPELINE;
+    RHIResourceId vertexBuffer = RHI_NULL_RESOURCE;
+    RHIResourceId indexBuffer = RHI_NULL_RESOURCE;
+    uint32_t vertexStride = 0;
+    uint32_t vertexBufferSize = 0;
+    uint32_t indexBufferSize = 0;
+    uint32_t materialBuffer = ~0u;  // bindless index of the material buffer
+    const SceneDraw* draws = nullptr; // must stay valid until the graph has executed
+    uint32_t drawCount = 0;
+};
+
+// GPU-driven scene. A compute pass culls 'objectBuffer' (GpuObjectData) into
+// 'commandBuffer' (IndirectDrawCommand) and 'countBuffer', and the scene pass
+// draws them with one DrawIndexedIndirect. Command and count buffers sit in
+// IndirectArgument between frames; 'countResetBuffer' holds a zero uint.
+struct IndirectSceneParams {
+    RHIPipelineId cullPipeline = RHI_NULL_PIPELINE;
+    RHIResourceId objectBuffer = RHI_NULL_RESOURCE;
+    RHIResourceId commandBuffer = RHI_NULL_RESOURCE;
+    RHIResourceId countBuffer = RHI_NULL_RESOURCE;
+    RHIResourceId countResetBuffer = RHI_NULL_RESOURCE;
+    uint32_t maxObjects = 0;
+    CullConstants constants;
+};
+
+// Everything the frame passes need from the renderer that owns the frame.
+struct FrameSetup {
+    RGTextureDesc backBufferDesc;
+    void* backBuffer = nullptr;     // external handle; its id comes from the graph backend
+    uint32_t depthFormat = 0;       // backend format value of the scene depth buffer
+    // Offscreen scene target, e.g. the editor viewport. When set, the scene renders
+    // into it instead of the back buffer and the UI pass samples it. It rests in
+    // ShaderResource between frames; its depth rests in DepthWrite. Without
+    // 'sceneDepth' a transient depth buffer of the same size is used.
+    RGTextureDesc sceneColorDesc;
+    void* sceneColor = nullptr;
+    void* sceneDepth = nullptr;
+    RHIViewport viewport;           // the scene's viewport within its target
+    float clearColor[4] = { 0.1f, 0.1f, 0.1f, 1.0f };
+    SceneDrawParams scene;
+    // Spreads scene draws over worker threads; null records them on the primary list.
+    ParallelRecorder* recorder = nullptr;
+    // When set, scene.draws is ignored and the scene is culled and drawn on the GPU.
+    const IndirectSceneParams* indirect = nullptr;
+    // Records the UI on top of the scene. The pass is left out when empty.
+    std::function<void(IRHICommandList&)> recordUi;
+};
+
+// Adds the scene and UI passes to 'graph'. Both record into 'cmd', which must
+// outlive the graph's Execute. Shared by Renderer and HeadlessRenderer so the
+// headless command stream matches what the editor records.
+void AddFramePasses(RenderGraph& graph, IRHICommandList& cmd, const FrameSetup& setup);
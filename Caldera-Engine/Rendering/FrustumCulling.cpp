@@ -0,0 +1,287 @@
+#include "FrustumCulling.h"
+#include "GpuCulling.h"
+#include "../Core/TaskPool.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// MSVC compiles intrinsics of any instruction set; GCC and Clang need the function opted in
+#if defined(_MSC_VER)
+#define CULL_TARGET_AVX2
+#else
+#define CULL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+Frustum MakeFrustum(const float viewProjection[16])
+{
+    const CullConstants constants = MakeCullConstants(viewProjection, 0);
+    Frustum frustum;
+    std::memcpy(frustum.planes, constants.planes, sizeof(frustum.planes));
+    return frustum;
+}
+
+uint32_t CullingBounds::Add(const float center[3], const float extents[3], float radius)
+{
+    const uint32_t index = GetCount();
+    centerX.push_back(center[0]);
+    centerY.push_back(center[1]);
+    centerZ.push_back(center[2]);
+    extentX.push_back(extents[0]);
+    extentY.push_back(extents[1]);
+    extentZ.push_back(extents[2]);
+    this->radius.push_back(radius);
+    return index;
+}
+
+void CullingBounds::Set(uint32_t index, const float center[3], const float extents[3], float radius)
+{
+    centerX[index] = center[0];
+    centerY[index] = center[1];
+    centerZ[index] = center[2];
+    extentX[index] = extents[0];
+    extentY[index] = extents[1];
+    extentZ[index] = extents[2];
+    this->radius[index] = radius;
+}
+
+uint32_t CullingBounds::RemoveSwap(uint32_t index)
+{
+    const uint32_t last = GetCount() - 1;
+    for (std::vector<float>* array : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ, &radius }) {
+        (*array)[index] = (*array)[last];
+        array->pop_back();
+    }
+    return last;
+}
+
+void CullingBounds::Reserve(uint32_t count)
+{
+    for (std::vector<float>* array : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ, &radius })
+        array->reserve(count);
+}
+
+void CullingBounds::Clear()
+{
+    for (std::vector<float>* array : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ, &radius })
+        array->clear();
+}
+
+bool IsObjectInFrustum(const Frustum& frustum, const CullingBounds& bounds, uint32_t index)
+{
+    const float cx = bounds.GetCenterX()[index];
+    const float cy = bounds.GetCenterY()[index];
+    const float cz = bounds.GetCenterZ()[index];
+    for (const float* plane : frustum.planes) {
+        // The box reaches |n|.extents past its center, the sphere its radius; the smaller one decides
+        const float distance = cx * plane[0] + cy * plane[1] + cz * plane[2] + plane[3];
+        const float boxReach = bounds.GetExtentX()[index] * std::fabs(plane[0]) + bounds.GetExtentY()[index] * std::fabs(plane[1])
+            + bounds.GetExtentZ()[index] * std::fabs(plane[2]);
+        if (distance + std::min(boxReach, bounds.GetRadius()[index]) < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+uint32_t CullFrustumReference(const CullingBounds& bounds, const Frustum& frustum, uint32_t* outVisible)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < bounds.GetCount(); ++i) {
+        if (IsObjectInFrustum(frustum, bounds, i))
+            outVisible[count++] = i;
+    }
+    return count;
+}
+
+// Culls [begin, end) against each view and writes view v's visible indices to out[v].
+// Returns the counts through 'counts'. Only full SIMD groups are handled here.
+using CullRangeFn = void (*)(const CullingBounds& bounds, const Frustum* views, uint32_t viewCount,
+    uint32_t begin, uint32_t end, uint32_t* const* out, uint32_t* counts);
+
+static void CullRangeScalar(const CullingBounds& bounds, const Frustum* views, uint32_t viewCount,
+    uint32_t begin, uint32_t end, uint32_t* const* out, uint32_t* counts)
+{
+    for (uint32_t i = begin; i < end; ++i) {
+        for (uint32_t v = 0; v < viewCount; ++v) {
+            // Branchless append: the slot is overwritten unless the object is visible
+            out[v][counts[v]] = i;
+            counts[v] += IsObjectInFrustum(views[v], bounds, i) ? 1 : 0;
+        }
+    }
+}
+
+static void CullRangeSse(const CullingBounds& bounds, const Frustum* views, uint32_t viewCount,
+    uint32_t begin, uint32_t end, uint32_t* const* out, uint32_t* counts)
+{
+    // Plane normals, their absolute values and distances, splatted once per range
+    __m128 planes[FrustumCuller::MAX_VIEWS][6][7];
+    for (uint32_t v = 0; v < viewCount; ++v) {
+        for (int p = 0; p < 6; ++p) {
+            const float* plane = views[v].planes[p];
+            for (int c = 0; c < 3; ++c) {
+                planes[v][p][c] = _mm_set1_ps(plane[c]);
+                planes[v][p][4 + c] = _mm_set1_ps(std::fabs(plane[c]));
+            }
+            planes[v][p][3] = _mm_set1_ps(plane[3]);
+        }
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    uint32_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        const __m128 cx = _mm_loadu_ps(bounds.GetCenterX() + i);
+        const __m128 cy = _mm_loadu_ps(bounds.GetCenterY() + i);
+        const __m128 cz = _mm_loadu_ps(bounds.GetCenterZ() + i);
+        const __m128 ex = _mm_loadu_ps(bounds.GetExtentX() + i);
+        const __m128 ey = _mm_loadu_ps(bounds.GetExtentY() + i);
+        const __m128 ez = _mm_loadu_ps(bounds.GetExtentZ() + i);
+        const __m128 radius = _mm_loadu_ps(bounds.GetRadius() + i);
+
+        for (uint32_t v = 0; v < viewCount; ++v) {
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p) {
+                const __m128* plane = planes[v][p];
+                const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, plane[0]), _mm_mul_ps(cy, plane[1])),
+                    _mm_mul_ps(cz, plane[2])), plane[3]);
+                const __m128 boxReach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, plane[4]), _mm_mul_ps(ey, plane[5])), _mm_mul_ps(ez, plane[6]));
+                const __m128 reach = _mm_min_ps(boxReach, radius);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, reach), zero));
+            }
+            const int mask = _mm_movemask_ps(inside);
+            uint32_t* dst = out[v];
+            uint32_t count = counts[v];
+            for (uint32_t lane = 0; lane < 4; ++lane) {
+                dst[count] = i + lane;
+                count += (mask >> lane) & 1;
+            }
+            counts[v] = count;
+        }
+    }
+    CullRangeScalar(bounds, views, viewCount, i, end, out, counts);
+}
+
+CULL_TARGET_AVX2
+static void CullRangeAvx2(const CullingBounds& bounds, const Frustum* views, uint32_t viewCount,
+    uint32_t begin, uint32_t end, uint32_t* const* out, uint32_t* counts)
+{
+    __m256 planes[FrustumCuller::MAX_VIEWS][6][7];
+    for (uint32_t v = 0; v < viewCount; ++v) {
+        for (int p = 0; p < 6; ++p) {
+            const float* plane = views[v].planes[p];
+            for (int c = 0; c < 3; ++c) {
+                planes[v][p][c] = _mm256_set1_ps(plane[c]);
+                planes[v][p][4 + c] = _mm256_set1_ps(std::fabs(plane[c]));
+            }
+            planes[v][p][3] = _mm256_set1_ps(plane[3]);
+        }
+    }
+
+    // Same operation order as IsObjectInFrustum and no FMA, so results match the reference bit for bit
+    const __m256 zero = _mm256_setzero_ps();
+    uint32_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        const __m256 cx = _mm256_loadu_ps(bounds.GetCenterX() + i);
+        const __m256 cy = _mm256_loadu_ps(bounds.GetCenterY() + i);
+        const __m256 cz = _mm256_loadu_ps(bounds.GetCenterZ() + i);
+        const __m256 ex = _mm256_loadu_ps(bounds.GetExtentX() + i);
+        const __m256 ey = _mm256_loadu_ps(bounds.GetExtentY() + i);
+        const __m256 ez = _mm256_loadu_ps(bounds.GetExtentZ() + i);
+        const __m256 radius = _mm256_loadu_ps(bounds.GetRadius() + i);
+
+        for (uint32_t v = 0; v < viewCount; ++v) {
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p) {
+                const __m256* plane = planes[v][p];
+                const __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, plane[0]), _mm256_mul_ps(cy, plane[1])),
+                    _mm256_mul_ps(cz, plane[2])), plane[3]);
+                const __m256 boxReach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, plane[4]), _mm256_mul_ps(ey, plane[5])), _mm256_mul_ps(ez, plane[6]));
+                const __m256 reach = _mm256_min_ps(boxReach, radius);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), zero, _CMP_GE_OQ));
+            }
+            const int mask = _mm256_movemask_ps(inside);
+            uint32_t* dst = out[v];
+            uint32_t count = counts[v];
+            for (uint32_t lane = 0; lane < 8; ++lane) {
+                dst[count] = i + lane;
+                count += (mask >> lane) & 1;
+            }
+            counts[v] = count;
+        }
+    }
+    CullRangeScalar(bounds, views, viewCount, i, end, out, counts);
+}
+
+CullPath FrustumCuller::GetBestPath()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return CullPath::Sse;
+    // AVX needs OS support for the YMM state as well as the CPU flag
+    __cpuid(info, 1);
+    const bool osSavesAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesAvx && (info[1] & (1 << 5)) ? CullPath::Avx2 : CullPath::Sse;
+#else
+    return __builtin_cpu_supports("avx2") ? CullPath::Avx2 : CullPath::Sse;
+#endif
+}
+
+void FrustumCuller::Initialize(TaskPool* pool)
+{
+    this->pool = pool;
+    path = GetBestPath();
+}
+
+void FrustumCuller::SetPath(CullPath path)
+{
+    this->path = std::min(path, GetBestPath());
+}
+
+uint32_t FrustumCuller::Cull(const CullingBounds& bounds, const Frustum* views, uint32_t viewCount)
+{
+    assert(viewCount <= MAX_VIEWS && "Too many views in one cull");
+    const uint32_t objectCount = bounds.GetCount();
+    const uint32_t taskCount = (objectCount + OBJECTS_PER_TASK - 1) / OBJECTS_PER_TASK;
+    for (uint32_t v = 0; v < viewCount; ++v) {
+        if (visible[v].size() < objectCount)
+            visible[v].resize(objectCount);
+    }
+    taskCounts.assign(size_t(taskCount) * MAX_VIEWS, 0);
+
+    CullRangeFn cullRange = path == CullPath::Avx2 ? CullRangeAvx2 : path == CullPath::Sse ? CullRangeSse : CullRangeScalar;
+    // Each task writes its visible indices at its own range's offset, then the ranges are packed
+    auto cullTask = [&](uint32_t task) {
+        const uint32_t begin = task * OBJECTS_PER_TASK;
+        const uint32_t end = std::min(objectCount, begin + OBJECTS_PER_TASK);
+        uint32_t* out[MAX_VIEWS];
+        for (uint32_t v = 0; v < viewCount; ++v)
+            out[v] = visible[v].data() + begin;
+        // Written indices are absolute; counts are per task
+        cullRange(bounds, views, viewCount, begin, end, out, &taskCounts[size_t(task) * MAX_VIEWS]);
+    };
+    if (pool && taskCount > 1)
+        pool->ParallelFor(taskCount, cullTask);
+    else
+        for (uint32_t task = 0; task < taskCount; ++task)
+            cullTask(task);
+
+    uint32_t total = 0;
+    for (uint32_t v = 0; v < viewCount; ++v) {
+        uint32_t count = 0;
+        for (uint32_t task = 0; task < taskCount; ++task) {
+            const uint32_t taskVisible = taskCounts[size_t(task) * MAX_VIEWS + v];
+            if (count != task * OBJECTS_PER_TASK)
+                std::memmove(visible[v].data() + count, visible[v].data() + size_t(task) * OBJECTS_PER_TASK, taskVisible * sizeof(uint32_t));
+            count += taskVisible;
+        }
+        visibleCounts[v] = count;
+        total += count;
+    }
+    return total;
+}
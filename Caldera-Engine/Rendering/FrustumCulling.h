@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class TaskPool;
+
+// CPU frustum culling of scene objects. Bounds are kept structure-of-arrays so
+// the SIMD paths test 4 (SSE) or 8 (AVX2) objects per instruction against the
+// six planes of every view, loading each object's bounds once for all views.
+// An object is visible if both its box and its sphere reach the inside of every
+// plane; both tests are conservative, so either may be the tighter one.
+
+// Normalized planes, xyz pointing inward, w distance.
+struct Frustum {
+    float planes[6][4] = {};
+};
+
+// Same conventions as the GPU culling shader: row-major, clip = viewProjection * float4(p, 1).
+Frustum MakeFrustum(const float viewProjection[16]);
+
+// World-space boxes (center and half extents) and bounding spheres around the
+// same center. Indices are the caller's object ids.
+class CullingBounds {
+public:
+    uint32_t Add(const float center[3], const float extents[3], float radius);
+    void Set(uint32_t index, const float center[3], const float extents[3], float radius);
+    // Moves the last object into 'index' and returns its old index.
+    uint32_t RemoveSwap(uint32_t index);
+    void Reserve(uint32_t count);
+    void Clear();
+
+    uint32_t GetCount() const { return static_cast<uint32_t>(centerX.size()); }
+    const float* GetCenterX() const { return centerX.data(); }
+    const float* GetCenterY() const { return centerY.data(); }
+    const float* GetCenterZ() const { return centerZ.data(); }
+    const float* GetExtentX() const { return extentX.data(); }
+    const float* GetExtentY() const { return extentY.data(); }
+    const float* GetExtentZ() const { return extentZ.data(); }
+    const float* GetRadius() const { return radius.data(); }
+
+private:
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    std::vector<float> radius;
+};
+
+bool IsObjectInFrustum(const Frustum& frustum, const CullingBounds& bounds, uint32_t index);
+// Scalar reference the SIMD paths must match exactly. Writes visible indices in
+// ascending order and returns their count.
+uint32_t CullFrustumReference(const CullingBounds& bounds, const Frustum& frustum, uint32_t* outVisible);
+
+enum class CullPath : uint8_t {
+    Scalar = 0,
+    Sse,
+    Avx2
+};
+
+class FrustumCuller {
+public:
+    // Views one Cull call can test, e.g. the editor camera plus shadow cascades.
+    static constexpr uint32_t MAX_VIEWS = 8;
+    // Objects per task; a multiple of 8 so only the last task has a scalar tail.
+    static constexpr uint32_t OBJECTS_PER_TASK = 16384;
+
+    // 'pool' may be null to cull on the calling thread.
+    void Initialize(TaskPool* pool);
+
+    // The widest path this CPU supports; SetPath clamps to it.
+    static CullPath GetBestPath();
+    void SetPath(CullPath path);
+    CullPath GetPath() const { return path; }
+
+    // Tests every object against each view. Returns the total visible count over all views.
+    uint32_t Cull(const CullingBounds& bounds, const Frustum* views, uint32_t viewCount);
+
+    // Visible object indices of a view, in ascending order, as of the last Cull.
+    const uint32_t* GetVisible(uint32_t view) const { return visible[view].data(); }
+    uint32_t GetVisibleCount(uint32_t view) const { return visibleCounts[view]; }
+
+private:
+    TaskPool* pool = nullptr;
+    CullPath path = CullPath::Scalar;
+    std::vector<uint32_t> visible[MAX_VIEWS];
+    uint32_t visibleCounts[MAX_VIEWS] = {};
+    std::vector<uint32_t> taskCounts;  // [task * MAX_VIEWS + view]
+};
@@ -0,0 +1,157 @@
+#include "GpuCulling.h"
+#include <algorithm>
+#include <cmath>
+
+CullConstants MakeCullConstants(const float viewProjection[16], uint32_t objectCount)
+{
+    CullConstants constants;
+    for (int i = 0; i < 16; ++i)
+        constants.viewProjection[i] = viewProjection[i];
+    constants.objectCount = objectCount;
+
+    // Gribb/Hartmann on the rows of the matrix, with D3D's [0, 1] depth range
+    const float* row0 = viewProjection;
+    const float* row1 = viewProjection + 4;
+    const float* row2 = viewProjection + 8;
+    const float* row3 = viewProjection + 12;
+    for (int i = 0; i < 4; ++i) {
+        constants.planes[0][i] = row3[i] + row0[i];  // left
+        constants.planes[1][i] = row3[i] - row0[i];  // right
+        constants.planes[2][i] = row3[i] + row1[i];  // bottom
+        constants.planes[3][i] = row3[i] - row1[i];  // top
+        constants.planes[4][i] = row2[i];            // near
+        constants.planes[5][i] = row3[i] - row2[i];  // far
+    }
+    for (float* plane : constants.planes) {
+        float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (length > 0.0f)
+            for (int i = 0; i < 4; ++i)
+                plane[i] /= length;
+    }
+    return constants;
+}
+
+void BuildHiZPyramid(const float* depth, uint32_t width, uint32_t height, HiZPyramid& out)
+{
+    out.width = width;
+    out.height = height;
+    out.mips.clear();
+    if (width == 0 || height == 0)
+        return;
+
+    out.mips.emplace_back(depth, depth + size_t(width) * height);
+    uint32_t mip = 0;
+    while (out.GetMipWidth(mip) > 1 || out.GetMipHeight(mip) > 1) {
+        const uint32_t srcWidth = out.GetMipWidth(mip);
+        const uint32_t srcHeight = out.GetMipHeight(mip);
+        const uint32_t dstWidth = out.GetMipWidth(mip + 1);
+        const uint32_t dstHeight = out.GetMipHeight(mip + 1);
+        std::vector<float> next(size_t(dstWidth) * dstHeight);
+        const std::vector<float>& src = out.mips[mip];
+
+        for (uint32_t y = 0; y < dstHeight; ++y) {
+            // Odd sources fold their last row/column into the last destination texel
+            uint32_t y0 = y * 2;
+            uint32_t y1 = (y == dstHeight - 1) ? srcHeight - 1 : y0 + 1;
+            for (uint32_t x = 0; x < dstWidth; ++x) {
+                uint32_t x0 = x * 2;
+                uint32_t x1 = (x == dstWidth - 1) ? srcWidth - 1 : x0 + 1;
+                float farthest = 0.0f;
+                for (uint32_t sy = y0; sy <= y1; ++sy)
+                    for (uint32_t sx = x0; sx <= x1; ++sx)
+                        farthest = std::max(farthest, src[size_t(sy) * srcWidth + sx]);
+                next[size_t(y) * dstWidth + x] = farthest;
+            }
+        }
+        out.mips.push_back(std::move(next));
+        ++mip;
+    }
+}
+
+bool IsSphereInFrustum(const CullConstants& constants, const float center[3], float radius)
+{
+    for (const float* plane : constants.planes) {
+        float distance = plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3];
+        if (distance < -radius)
+            return false;
+    }
+    return true;
+}
+
+bool IsScreenRectVisibleHiZ(const HiZPyramid& hiz, float minU, float minV, float maxU, float maxV, float minZ)
+{
+    minU = std::clamp(minU, 0.0f, 1.0f);
+    maxU = std::clamp(maxU, 0.0f, 1.0f);
+    minV = std::clamp(minV, 0.0f, 1.0f);
+    maxV = std::clamp(maxV, 0.0f, 1.0f);
+
+    // Pick the mip where the rectangle covers at most 2x2 texels
+    float extent = std::max((maxU - minU) * hiz.width, (maxV - minV) * hiz.height);
+    int mip = extent > 1.0f ? static_cast<int>(std::ceil(std::log2(extent))) : 0;
+    mip = std::clamp(mip, 0, static_cast<int>(hiz.GetMipCount()) - 1);
+
+    const uint32_t mipWidth = hiz.GetMipWidth(mip);
+    const uint32_t mipHeight = hiz.GetMipHeight(mip);
+    uint32_t x0 = std::min(static_cast<uint32_t>(minU * mipWidth), mipWidth - 1);
+    uint32_t x1 = std::min(static_cast<uint32_t>(maxU * mipWidth), mipWidth - 1);
+    uint32_t y0 = std::min(static_cast<uint32_t>(minV * mipHeight), mipHeight - 1);
+    uint32_t y1 = std::min(static_cast<uint32_t>(maxV * mipHeight), mipHeight - 1);
+
+    float farthest = std::max(std::max(hiz.Load(x0, y0, mip), hiz.Load(x1, y0, mip)),
+                              std::max(hiz.Load(x0, y1, mip), hiz.Load(x1, y1, mip)));
+    return minZ <= farthest;
+}
+
+bool IsSphereVisibleHiZ(const CullConstants& constants, const HiZPyramid& hiz, const float center[3], float radius)
+{
+    if (hiz.GetMipCount() == 0)
+        return true;
+
+    // Screen rectangle and nearest depth of the sphere's bounding box
+    const float* m = constants.viewProjection;
+    float minU = 1.0f, minV = 1.0f, maxU = 0.0f, maxV = 0.0f;
+    float minZ = 1.0f;
+    for (int corner = 0; corner < 8; ++corner) {
+        float p[3] = {
+            center[0] + ((corner & 1) ? radius : -radius),
+            center[1] + ((corner & 2) ? radius : -radius),
+            center[2] + ((corner & 4) ? radius : -radius),
+        };
+        float clip[4];
+        for (int r = 0; r < 4; ++r)
+            clip[r] = m[r * 4 + 0] * p[0] + m[r * 4 + 1] * p[1] + m[r * 4 + 2] * p[2] + m[r * 4 + 3];
+        if (clip[3] <= 0.0f)
+            return true;    // crosses the camera plane, can't be bounded on screen
+
+        float u = clip[0] / clip[3] * 0.5f + 0.5f;
+        float v = clip[1] / clip[3] * -0.5f + 0.5f;
+        minU = std::min(minU, u);
+        maxU = std::max(maxU, u);
+        minV = std::min(minV, v);
+        maxV = std::max(maxV, v);
+        minZ = std::min(minZ, clip[2] / clip[3]);
+    }
+    return IsScreenRectVisibleHiZ(hiz, minU, minV, maxU, maxV, minZ);
+}
+
+uint32_t CullObjectsReference(const GpuObjectData* objects, uint32_t objectCount, const CullConstants& constants,
+    const HiZPyramid* hiz, IndirectDrawCommand* outCommands)
+{
+    uint32_t visible = 0;
+    for (uint32_t i = 0; i < objectCount; ++i) {
+        const GpuObjectData& object = objects[i];
+        if (!IsSphereInFrustum(constants, object.center, object.radius))
+            continue;
+        if (hiz && !IsSphereVisibleHiZ(constants, *hiz, object.center, object.radius))
+            continue;
+
+        IndirectDrawCommand& command = outCommands[visible++];
+        command.materialIndex = object.materialIndex;
+        command.indexCountPerInstance = object.indexCount;
+        command.instanceCount = 1;
+        command.startIndexLocation = object.firstIndex;
+        command.baseVertexLocation = object.baseVertex;
+        command.startInstanceLocation = 0;
+    }
+    return visible;
+}
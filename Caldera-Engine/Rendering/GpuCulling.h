@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Shared definitions of the GPU-driven scene path plus a CPU reference of the
+// culling compute shader (D3D12GpuCuller), so results can be checked and
+// benchmarked without a GPU. Struct layouts match the HLSL side exactly.
+
+constexpr uint32_t CULL_THREAD_GROUP_SIZE = 64;
+constexpr uint32_t CULL_NO_HIZ = ~0u;
+
+// One scene object: a bounding sphere and the draw it turns into when visible.
+struct GpuObjectData {
+    float center[3] = { 0.0f, 0.0f, 0.0f };
+    float radius = 0.0f;
+    uint32_t indexCount = 0;
+    uint32_t firstIndex = 0;
+    int32_t baseVertex = 0;
+    uint32_t materialIndex = 0;
+};
+static_assert(sizeof(GpuObjectData) == 32, "GpuObjectData must match the HLSL ObjectData layout");
+
+// One ExecuteIndirect command: the material root constant, then D3D12_DRAW_INDEXED_ARGUMENTS.
+struct IndirectDrawCommand {
+    uint32_t materialIndex = 0;
+    uint32_t indexCountPerInstance = 0;
+    uint32_t instanceCount = 0;
+    uint32_t startIndexLocation = 0;
+    int32_t baseVertexLocation = 0;
+    uint32_t startInstanceLocation = 0;
+};
+static_assert(sizeof(IndirectDrawCommand) == 24, "IndirectDrawCommand must match the command signature stride");
+
+// Root constants of the culling shader. viewProjection is row-major with
+// clip = viewProjection * float4(position, 1); depth is 0 at the near plane.
+struct CullConstants {
+    float planes[6][4] = {};        // xyz normal pointing inward, w distance
+    float viewProjection[16] = {};
+    uint32_t objectCount = 0;
+    uint32_t hizIndex = CULL_NO_HIZ; // bindless texture index of the Hi-Z pyramid
+    uint32_t hizWidth = 0;
+    uint32_t hizHeight = 0;
+    uint32_t hizMipCount = 0;
+};
+constexpr uint32_t CULL_CONSTANT_COUNT = sizeof(CullConstants) / sizeof(uint32_t);
+static_assert(CULL_CONSTANT_COUNT == 45, "CullConstants must match the HLSL cbuffer");
+
+// Builds frustum planes from 'viewProjection'; Hi-Z testing stays off.
+CullConstants MakeCullConstants(const float viewProjection[16], uint32_t objectCount);
+
+// Max-depth pyramid: mip 0 is the depth buffer, each level keeps the farthest
+// depth of the 2x2 (or 3 at odd edges) texels below it.
+struct HiZPyramid {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<std::vector<float>> mips;
+
+    uint32_t GetMipCount() const { return static_cast<uint32_t>(mips.size()); }
+    uint32_t GetMipWidth(uint32_t mip) const { uint32_t w = width >> mip; return w ? w : 1; }
+    uint32_t GetMipHeight(uint32_t mip) const { uint32_t h = height >> mip; return h ? h : 1; }
+    float Load(uint32_t x, uint32_t y, uint32_t mip) const { return mips[mip][y * GetMipWidth(mip) + x]; }
+};
+
+void BuildHiZPyramid(const float* depth, uint32_t width, uint32_t height, HiZPyramid& out);
+
+// True unless the UV rectangle, whose nearest depth is 'minZ', is certainly behind
+// what 'hiz' recorded. Samples the mip where the rectangle covers at most 2x2 texels.
+bool IsScreenRectVisibleHiZ(const HiZPyramid& hiz, float minU, float minV, float maxU, float maxV, float minZ);
+
+bool IsSphereInFrustum(const CullConstants& constants, const float center[3], float radius);
+// True unless the sphere is certainly behind what 'hiz' recorded.
+bool IsSphereVisibleHiZ(const CullConstants& constants, const HiZPyramid& hiz, const float center[3], float radius);
+
+// CPU reference of the culling shader. Writes one command per visible object,
+// in object order (the GPU appends in any order), and returns the count.
+// Pass a null 'hiz' to cull against the frustum only.
+uint32_t CullObjectsReference(const GpuObjectData* objects, uint32_t objectCount, const CullConstants& constants,
+    const HiZPyramid* hiz, IndirectDrawCommand* outCommands);
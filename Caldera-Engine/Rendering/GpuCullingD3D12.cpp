@@ -0,0 +1,162 @@
+#include "GpuCullingD3D12.h"
+#include "GpuMemory.h"
+#include <cassert>
+#include <cstring>
+
+bool D3D12GpuCuller::Create(ID3D12Device* device, GpuMemory* gpuMemory, D3D12Pipeline& scenePipeline,
+    const std::vector<uint8_t>& cullShader, uint32_t maxObjects, uint32_t frameCount, uint32_t bindlessCapacity)
+{
+    assert(device && gpuMemory && "Device or GPU memory is null");
+    this->gpuMemory = gpuMemory;
+    this->maxObjects = maxObjects;
+
+    if (!CreatePipeline(device, cullShader, bindlessCapacity) || !CreateCommandSignature(device, scenePipeline))
+        return false;
+
+    frames.resize(frameCount);
+    for (FrameObjects& frame : frames) {
+        if (FAILED(CreateBuffer(D3D12_HEAP_TYPE_UPLOAD, UINT64(maxObjects) * sizeof(GpuObjectData), D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_GENERIC_READ, frame.buffer)))
+            return false;
+        frame.buffer->Map(0, nullptr, reinterpret_cast<void**>(&frame.mapped));
+    }
+
+    // Command and count buffers rest in INDIRECT_ARGUMENT between frames
+    if (FAILED(CreateBuffer(D3D12_HEAP_TYPE_DEFAULT, UINT64(maxObjects) * sizeof(IndirectDrawCommand), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, commandBuffer)) ||
+        FAILED(CreateBuffer(D3D12_HEAP_TYPE_DEFAULT, sizeof(uint32_t), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, countBuffer)) ||
+        FAILED(CreateBuffer(D3D12_HEAP_TYPE_UPLOAD, sizeof(uint32_t), D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_GENERIC_READ, countResetBuffer)))
+        return false;
+
+    uint32_t* zero = nullptr;
+    countResetBuffer->Map(0, nullptr, reinterpret_cast<void**>(&zero));
+    *zero = 0;
+    countResetBuffer->Unmap(0, nullptr);
+    return true;
+}
+
+void D3D12GpuCuller::Destroy()
+{
+    // Caller has already waited for the GPU
+    if (!gpuMemory)
+        return;
+    for (FrameObjects& frame : frames)
+        gpuMemory->ReleaseResource(frame.buffer);
+    frames.clear();
+    gpuMemory->ReleaseResource(commandBuffer);
+    gpuMemory->ReleaseResource(countBuffer);
+    gpuMemory->ReleaseResource(countResetBuffer);
+    cullPipeline = {};
+    gpuMemory = nullptr;
+}
+
+void D3D12GpuCuller::UpdateObjects(uint32_t frameSlot, const GpuObjectData* objects, uint32_t count)
+{
+    assert(count <= maxObjects && "Too many objects for the culler");
+    FrameObjects& frame = frames[frameSlot];
+    frame.count = count < maxObjects ? count : maxObjects;
+    memcpy(frame.mapped, objects, frame.count * sizeof(GpuObjectData));
+}
+
+IndirectSceneParams D3D12GpuCuller::GetSceneParams(uint32_t frameSlot, const float viewProjection[16],
+    uint32_t hizIndex, uint32_t hizWidth, uint32_t hizHeight, uint32_t hizMipCount) const
+{
+    IndirectSceneParams params;
+    params.cullPipeline = D3D12CommandList::ToId(&cullPipeline);
+    params.objectBuffer = D3D12CommandList::ToId(frames[frameSlot].buffer.Get());
+    params.commandBuffer = D3D12CommandList::ToId(commandBuffer.Get());
+    params.countBuffer = D3D12CommandList::ToId(countBuffer.Get());
+    params.countResetBuffer = D3D12CommandList::ToId(countResetBuffer.Get());
+    params.maxObjects = maxObjects;
+    params.constants = MakeCullConstants(viewProjection, frames[frameSlot].count);
+    if (hizIndex != CULL_NO_HIZ && hizMipCount > 0) {
+        params.constants.hizIndex = hizIndex;
+        params.constants.hizWidth = hizWidth;
+        params.constants.hizHeight = hizHeight;
+        params.constants.hizMipCount = hizMipCount;
+    }
+    return params;
+}
+
+bool D3D12GpuCuller::CreatePipeline(ID3D12Device* device, const std::vector<uint8_t>& cullShader, uint32_t bindlessCapacity)
+{
+    if (cullShader.empty())
+        return false;
+
+    // Hi-Z pyramids are reached through the bindless texture range, like material textures
+    D3D12_DESCRIPTOR_RANGE range = {};
+    range.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+    range.NumDescriptors = bindlessCapacity;
+    range.BaseShaderRegister = 0;
+    range.RegisterSpace = 1;
+    range.OffsetInDescriptorsFromTableStart = 0;
+
+    D3D12_ROOT_PARAMETER rootParams[5] = {};
+    rootParams[CULL_ROOT_CONSTANTS].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    rootParams[CULL_ROOT_CONSTANTS].Constants.ShaderRegister = 0;
+    rootParams[CULL_ROOT_CONSTANTS].Constants.Num32BitValues = CULL_CONSTANT_COUNT;
+    rootParams[CULL_ROOT_OBJECTS].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
+    rootParams[CULL_ROOT_OBJECTS].Descriptor.ShaderRegister = 0;
+    rootParams[CULL_ROOT_COMMANDS].ParameterType = D3D12_ROOT_PARAMETER_TYPE_UAV;
+    rootParams[CULL_ROOT_COMMANDS].Descriptor.ShaderRegister = 0;
+    rootParams[CULL_ROOT_DRAW_COUNT].ParameterType = D3D12_ROOT_PARAMETER_TYPE_UAV;
+    rootParams[CULL_ROOT_DRAW_COUNT].Descriptor.ShaderRegister = 1;
+    rootParams[CULL_ROOT_BINDLESS_TABLE].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    rootParams[CULL_ROOT_BINDLESS_TABLE].DescriptorTable.NumDescriptorRanges = 1;
+    rootParams[CULL_ROOT_BINDLESS_TABLE].DescriptorTable.pDescriptorRanges = &range;
+    for (D3D12_ROOT_PARAMETER& param : rootParams)
+        param.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+
+    D3D12_ROOT_SIGNATURE_DESC rootSignatureDesc = {};
+    rootSignatureDesc.NumParameters = _countof(rootParams);
+    rootSignatureDesc.pParameters = rootParams;
+
+    ComPtr<ID3DBlob> signature;
+    ComPtr<ID3DBlob> error;
+    if (FAILED(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error))) {
+        if (error)
+            OutputDebugStringA((const char*)error->GetBufferPointer());
+        return false;
+    }
+    if (FAILED(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&cullPipeline.rootSignature))))
+        return false;
+
+    D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+    psoDesc.pRootSignature = cullPipeline.rootSignature.Get();
+    psoDesc.CS = { cullShader.data(), cullShader.size() };
+    if (FAILED(device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&cullPipeline.pipelineState))))
+        return false;
+
+    cullPipeline.compute = true;
+    return true;
+}
+
+bool D3D12GpuCuller::CreateCommandSignature(ID3D12Device* device, D3D12Pipeline& scenePipeline)
+{
+    // Each command overwrites the material index (second draw constant), then draws
+    D3D12_INDIRECT_ARGUMENT_DESC arguments[2] = {};
+    arguments[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+    arguments[0].Constant.RootParameterIndex = SCENE_ROOT_DRAW_CONSTANTS;
+    arguments[0].Constant.DestOffsetIn32BitValues = 1;
+    arguments[0].Constant.Num32BitValuesToSet = 1;
+    arguments[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+    D3D12_COMMAND_SIGNATURE_DESC desc = {};
+    desc.ByteStride = sizeof(IndirectDrawCommand);
+    desc.NumArgumentDescs = _countof(arguments);
+    desc.pArgumentDescs = arguments;
+    return SUCCEEDED(device->CreateCommandSignature(&desc, scenePipeline.rootSignature.Get(), IID_PPV_ARGS(&scenePipeline.drawIndirectSignature)));
+}
+
+HRESULT D3D12GpuCuller::CreateBuffer(D3D12_HEAP_TYPE heapType, UINT64 size, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES state, ComPtr<ID3D12Resource>& out)
+{
+    D3D12_RESOURCE_DESC bufferDesc = {};
+    bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufferDesc.Width = size;
+    bufferDesc.Height = 1;
+    bufferDesc.DepthOrArraySize = 1;
+    bufferDesc.MipLevels = 1;
+    bufferDesc.Format = DXGI_FORMAT_UNKNOWN;
+    bufferDesc.SampleDesc.Count = 1;
+    bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    bufferDesc.Flags = flags;
+    return gpuMemory->CreateResource(heapType, &bufferDesc, state, nullptr, out);
+}
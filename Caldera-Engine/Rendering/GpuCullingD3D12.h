@@ -0,0 +1,53 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <vector>
+#include "GpuCulling.h"
+#include "FramePasses.h"
+#include "RHID3D12.h"
+
+using namespace Microsoft::WRL;
+
+class GpuMemory;
+
+// GPU resources of the GPU-driven scene path: the culling compute pipeline,
+// per-frame object buffers, the indirect command and count buffers, and the
+// command signature the scene pipeline draws them with.
+class D3D12GpuCuller {
+public:
+    // Adds the indirect command signature to 'scenePipeline'. 'cullShader' is the compiled
+    // GpuCull.hlsl; 'bindlessCapacity' is the size of the bindless texture range the Hi-Z
+    // pyramid is looked up in.
+    bool Create(ID3D12Device* device, GpuMemory* gpuMemory, D3D12Pipeline& scenePipeline,
+        const std::vector<uint8_t>& cullShader, uint32_t maxObjects, uint32_t frameCount, uint32_t bindlessCapacity);
+    void Destroy();
+
+    // Uploads this frame's objects; the slot's previous frame must have retired.
+    void UpdateObjects(uint32_t frameSlot, const GpuObjectData* objects, uint32_t count);
+
+    // 'hizIndex' is the bindless index of a max-depth pyramid, or CULL_NO_HIZ.
+    IndirectSceneParams GetSceneParams(uint32_t frameSlot, const float viewProjection[16],
+        uint32_t hizIndex = CULL_NO_HIZ, uint32_t hizWidth = 0, uint32_t hizHeight = 0, uint32_t hizMipCount = 0) const;
+
+    uint32_t GetMaxObjects() const { return maxObjects; }
+
+private:
+    bool CreatePipeline(ID3D12Device* device, const std::vector<uint8_t>& cullShader, uint32_t bindlessCapacity);
+    bool CreateCommandSignature(ID3D12Device* device, D3D12Pipeline& scenePipeline);
+    HRESULT CreateBuffer(D3D12_HEAP_TYPE heapType, UINT64 size, D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES state, ComPtr<ID3D12Resource>& out);
+
+    GpuMemory* gpuMemory = nullptr;
+    D3D12Pipeline cullPipeline;
+
+    struct FrameObjects {
+        ComPtr<ID3D12Resource> buffer;  // upload heap, persistently mapped
+        GpuObjectData* mapped = nullptr;
+        uint32_t count = 0;
+    };
+    std::vector<FrameObjects> frames;
+
+    ComPtr<ID3D12Resource> commandBuffer;
+    ComPtr<ID3D12Resource> countBuffer;
+    ComPtr<ID3D12Resource> countResetBuffer;
+    uint32_t maxObjects = 0;
+};
@@ -0,0 +1,286 @@
+#include "GpuHeapAllocator.h"
+#include <algorithm>
+#include <cassert>
+
+constexpr int NUM_RESOURCE_CLASSES = static_cast<int>(GpuResourceClass::Count);
+
+void GpuHeapAllocator::Initialize(IGpuHeapBackend* backend)
+{
+    assert(backend && "Heap backend is null");
+    this->backend = backend;
+
+    for (int t = 0; t < static_cast<int>(GpuHeapType::Count); ++t) {
+        for (int c = 0; c < NUM_RESOURCE_CLASSES; ++c) {
+            Pool& pool = pools[PoolIndex(static_cast<GpuHeapType>(t), static_cast<GpuResourceClass>(c))];
+            pool.type = static_cast<GpuHeapType>(t);
+            pool.resourceClass = static_cast<GpuResourceClass>(c);
+        }
+    }
+}
+
+void GpuHeapAllocator::Shutdown()
+{
+    for (Pool& pool : pools) {
+        for (auto& heap : pool.heaps)
+            backend->DestroyHeap(heap->id);
+        pool.heaps.clear();
+    }
+    records.clear();
+}
+
+GpuAllocation GpuHeapAllocator::Allocate(GpuHeapType type, GpuResourceClass resourceClass, uint64_t size, uint64_t alignment, bool movable)
+{
+    const uint32_t poolIndex = PoolIndex(type, resourceClass);
+    Pool& pool = pools[poolIndex];
+
+    const uint64_t heapSize = (type == GpuHeapType::Default) ? DEFAULT_HEAP_SIZE : UPLOAD_HEAP_SIZE;
+
+    Heap* heap = nullptr;
+    uint64_t offset = TlsfAllocator::INVALID_OFFSET;
+
+    // Anything over half a heap would mostly waste the rest of it
+    if (size > heapSize / 2) {
+        heap = CreateHeap(pool, (size + alignment - 1) & ~(alignment - 1), true);
+        // Offset 0 of a fresh heap satisfies any alignment, so no padding is reserved
+        if (heap)
+            offset = heap->allocator.Allocate(size, TlsfAllocator::MIN_BLOCK_SIZE);
+    }
+    else {
+        for (auto& candidate : pool.heaps) {
+            if (candidate->dedicated)
+                continue;
+            offset = candidate->allocator.Allocate(size, alignment);
+            if (offset != TlsfAllocator::INVALID_OFFSET) {
+                heap = candidate.get();
+                break;
+            }
+        }
+
+        if (!heap) {
+            heap = CreateHeap(pool, heapSize, false);
+            if (heap)
+                offset = heap->allocator.Allocate(size, alignment);
+        }
+    }
+
+    if (!heap || offset == TlsfAllocator::INVALID_OFFSET)
+        return GpuAllocation();
+
+    Record record;
+    record.allocation.id = nextAllocationId++;
+    record.allocation.heapId = heap->id;
+    record.allocation.offset = offset;
+    record.allocation.size = heap->allocator.GetAllocationSize(offset);
+    record.poolIndex = poolIndex;
+    record.alignment = alignment;
+    record.movable = movable && !heap->dedicated;
+
+    records[record.allocation.id] = record;
+    return record.allocation;
+}
+
+void GpuHeapAllocator::Free(uint32_t allocationId)
+{
+    auto it = records.find(allocationId);
+    if (it == records.end())
+        return;
+
+    const Record record = it->second;
+    assert(!record.moving && "Freeing an allocation with a pending move");
+    records.erase(it);
+
+    Pool& pool = pools[record.poolIndex];
+    for (size_t i = 0; i < pool.heaps.size(); ++i) {
+        Heap& heap = *pool.heaps[i];
+        if (heap.id != record.allocation.heapId)
+            continue;
+
+        heap.allocator.Free(record.allocation.offset);
+        if (heap.dedicated) {
+            backend->DestroyHeap(heap.id);
+            pool.heaps.erase(pool.heaps.begin() + i);
+        }
+        return;
+    }
+}
+
+GpuAllocation GpuHeapAllocator::GetAllocation(uint32_t allocationId) const
+{
+    auto it = records.find(allocationId);
+    return it != records.end() ? it->second.allocation : GpuAllocation();
+}
+
+size_t GpuHeapAllocator::PlanDefragmentation(uint64_t maxBytes, std::vector<GpuDefragMove>& outMoves)
+{
+    const size_t firstMove = outMoves.size();
+    uint64_t budget = maxBytes;
+
+    // (heapId, offset) -> allocation id, for the movable allocations only
+    std::unordered_map<uint32_t, std::unordered_map<uint64_t, uint32_t>> movableByHeap;
+    for (const auto& entry : records)
+        if (entry.second.movable && !entry.second.moving)
+            movableByHeap[entry.second.allocation.heapId][entry.second.allocation.offset] = entry.first;
+
+    std::vector<uint64_t> offsets;
+    for (int c = 0; c < NUM_RESOURCE_CLASSES; ++c) {
+        Pool& pool = pools[PoolIndex(GpuHeapType::Default, static_cast<GpuResourceClass>(c))];
+
+        // Fill the fullest heaps first and drain the emptiest ones into them
+        std::vector<Heap*> order;
+        for (auto& heap : pool.heaps)
+            if (!heap->dedicated)
+                order.push_back(heap.get());
+        std::sort(order.begin(), order.end(), [](const Heap* a, const Heap* b) {
+            return a->allocator.GetUsedBytes() > b->allocator.GetUsedBytes();
+        });
+
+        for (size_t s = order.size(); s-- > 0;) {
+            Heap* source = order[s];
+            auto movable = movableByHeap.find(source->id);
+            if (movable == movableByHeap.end())
+                continue;
+
+            source->allocator.GetAllocationsFromBack(offsets);
+            for (uint64_t offset : offsets) {
+                auto found = movable->second.find(offset);
+                if (found == movable->second.end())
+                    continue;
+
+                Record& record = records[found->second];
+                if (record.allocation.size > budget)
+                    return outMoves.size() - firstMove;
+
+                GpuAllocation target;
+                for (size_t d = 0; d < s && !target.IsValid(); ++d) {
+                    const uint64_t moved = order[d]->allocator.Allocate(record.allocation.size, record.alignment);
+                    if (moved != TlsfAllocator::INVALID_OFFSET)
+                        target = { record.allocation.id, order[d]->id, moved, order[d]->allocator.GetAllocationSize(moved) };
+                }
+
+                // Otherwise compact within the heap, but only towards the front
+                if (!target.IsValid()) {
+                    const uint64_t moved = source->allocator.Allocate(record.allocation.size, record.alignment);
+                    if (moved == TlsfAllocator::INVALID_OFFSET)
+                        continue;
+                    if (moved >= offset) {
+                        source->allocator.Free(moved);
+                        continue;
+                    }
+                    target = { record.allocation.id, source->id, moved, source->allocator.GetAllocationSize(moved) };
+                }
+
+                record.moving = true;
+                budget -= record.allocation.size;
+                outMoves.push_back({ record.allocation.id, record.allocation, target });
+            }
+        }
+    }
+
+    return outMoves.size() - firstMove;
+}
+
+void GpuHeapAllocator::CommitMove(const GpuDefragMove& move)
+{
+    auto it = records.find(move.allocationId);
+    assert(it != records.end() && it->second.moving && "No pending move for allocation");
+    if (it == records.end())
+        return;
+
+    it->second.allocation = move.to;
+    it->second.moving = false;
+}
+
+void GpuHeapAllocator::CancelMove(const GpuDefragMove& move)
+{
+    auto it = records.find(move.allocationId);
+    if (it == records.end())
+        return;
+
+    if (Heap* heap = FindHeap(move.to.heapId))
+        heap->allocator.Free(move.to.offset);
+    it->second.moving = false;
+}
+
+void GpuHeapAllocator::ReleaseMovedRange(const GpuDefragMove& move)
+{
+    if (Heap* heap = FindHeap(move.from.heapId))
+        heap->allocator.Free(move.from.offset);
+}
+
+uint32_t GpuHeapAllocator::ReleaseEmptyHeaps()
+{
+    uint32_t released = 0;
+    for (Pool& pool : pools) {
+        bool keptOne = false;
+        for (size_t i = 0; i < pool.heaps.size();) {
+            Heap& heap = *pool.heaps[i];
+            if (!heap.allocator.IsEmpty() || !keptOne) {
+                keptOne |= heap.allocator.IsEmpty();
+                ++i;
+                continue;
+            }
+            backend->DestroyHeap(heap.id);
+            pool.heaps.erase(pool.heaps.begin() + i);
+            ++released;
+        }
+    }
+    return released;
+}
+
+GpuMemoryStats GpuHeapAllocator::GetStats() const
+{
+    GpuMemoryStats stats;
+    for (const Pool& pool : pools)
+        AccumulateStats(pool, stats);
+    return stats;
+}
+
+GpuMemoryStats GpuHeapAllocator::GetStats(GpuHeapType type, GpuResourceClass resourceClass) const
+{
+    GpuMemoryStats stats;
+    AccumulateStats(pools[PoolIndex(type, resourceClass)], stats);
+    return stats;
+}
+
+uint32_t GpuHeapAllocator::PoolIndex(GpuHeapType type, GpuResourceClass resourceClass)
+{
+    return static_cast<uint32_t>(type) * NUM_RESOURCE_CLASSES + static_cast<uint32_t>(resourceClass);
+}
+
+GpuHeapAllocator::Heap* GpuHeapAllocator::FindHeap(uint32_t heapId)
+{
+    for (Pool& pool : pools)
+        for (auto& heap : pool.heaps)
+            if (heap->id == heapId)
+                return heap.get();
+    return nullptr;
+}
+
+GpuHeapAllocator::Heap* GpuHeapAllocator::CreateHeap(Pool& pool, uint64_t size, bool dedicated)
+{
+    auto heap = std::make_unique<Heap>();
+    heap->id = nextHeapId++;
+    heap->dedicated = dedicated;
+    if (!backend->CreateHeap(heap->id, pool.type, pool.resourceClass, size))
+        return nullptr;
+
+    heap->allocator.Initialize(size);
+    pool.heaps.push_back(std::move(heap));
+    return pool.heaps.back().get();
+}
+
+void GpuHeapAllocator::AccumulateStats(const Pool& pool, GpuMemoryStats& stats) const
+{
+    for (const auto& heap : pool.heaps) {
+        const TlsfAllocator::Stats heapStats = heap->allocator.GetStats();
+        stats.reservedBytes += heapStats.capacity;
+        stats.usedBytes += heapStats.usedBytes;
+        stats.allocationCount += heapStats.allocationCount;
+        stats.freeBlockCount += heapStats.freeBlockCount;
+        stats.largestFreeBlock = std::max(stats.largestFreeBlock, heapStats.largestFreeBlock);
+        ++stats.heapCount;
+    }
+
+    const uint64_t totalFree = stats.reservedBytes - stats.usedBytes;
+    stats.fragmentation = totalFree ? 1.0f - float(stats.largestFreeBlock) / float(totalFree) : 0.0f;
+}
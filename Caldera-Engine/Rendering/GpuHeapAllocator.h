@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "TlsfAllocator.h"
+
+// CPU pages a heap lives in. Mirrors D3D12_HEAP_TYPE without depending on it.
+enum class GpuHeapType : uint8_t {
+    Default = 0,
+    Upload,
+    Readback,
+    Count
+};
+
+// Resource tier 1 hardware cannot mix these in one heap, so each gets its own pools.
+enum class GpuResourceClass : uint8_t {
+    Buffer = 0,
+    Texture,
+    RenderTarget,
+    Count
+};
+
+struct GpuAllocation {
+    uint32_t id = 0;
+    uint32_t heapId = 0;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+
+    bool IsValid() const { return id != 0; }
+};
+
+// A planned relocation. The backend creates a resource at 'to', copies 'from' into
+// it on the GPU, and calls CommitMove once later work is ordered after that copy.
+// 'from' stays reserved until ReleaseMovedRange, as frames already submitted may
+// still read it.
+struct GpuDefragMove {
+    uint32_t allocationId = 0;
+    GpuAllocation from;
+    GpuAllocation to;
+};
+
+struct GpuMemoryStats {
+    uint64_t reservedBytes = 0;
+    uint64_t usedBytes = 0;
+    uint64_t largestFreeBlock = 0;
+    uint32_t heapCount = 0;
+    uint32_t allocationCount = 0;
+    uint32_t freeBlockCount = 0;
+    float fragmentation = 0.0f;
+};
+
+// Creates and destroys the real heaps. The D3D12 backend wraps ID3D12Heap; tests
+// and benchmarks can plug in a backend that only counts.
+class IGpuHeapBackend {
+public:
+    virtual ~IGpuHeapBackend() = default;
+    virtual bool CreateHeap(uint32_t heapId, GpuHeapType type, GpuResourceClass resourceClass, uint64_t size) = 0;
+    virtual void DestroyHeap(uint32_t heapId) = 0;
+};
+
+// Reserves large heaps per (heap type, resource class) and sub-allocates them with
+// TLSF. Allocations keep a stable id across defragmentation moves.
+class GpuHeapAllocator {
+public:
+    static constexpr uint64_t DEFAULT_HEAP_SIZE = 64ull << 20;
+    static constexpr uint64_t UPLOAD_HEAP_SIZE = 16ull << 20;
+
+    void Initialize(IGpuHeapBackend* backend);
+    void Shutdown();
+
+    GpuAllocation Allocate(GpuHeapType type, GpuResourceClass resourceClass, uint64_t size, uint64_t alignment, bool movable = false);
+    void Free(uint32_t allocationId);
+    GpuAllocation GetAllocation(uint32_t allocationId) const;
+
+    // Plans up to 'maxBytes' of moves that compact the most fragmented default
+    // heaps. Destinations are reserved immediately; sources stay reserved until
+    // ReleaseMovedRange. Returns the number of moves appended to 'outMoves'.
+    size_t PlanDefragmentation(uint64_t maxBytes, std::vector<GpuDefragMove>& outMoves);
+    void CommitMove(const GpuDefragMove& move);
+    void CancelMove(const GpuDefragMove& move);
+    void ReleaseMovedRange(const GpuDefragMove& move);
+
+    // Destroys heaps with no allocations, keeping one per pool to avoid churn.
+    uint32_t ReleaseEmptyHeaps();
+
+    GpuMemoryStats GetStats() const;
+    GpuMemoryStats GetStats(GpuHeapType type, GpuResourceClass resourceClass) const;
+
+private:
+    struct Heap {
+        uint32_t id = 0;
+        TlsfAllocator allocator;
+        bool dedicated = false;
+    };
+
+    struct Pool {
+        GpuHeapType type = GpuHeapType::Default;
+        GpuResourceClass resourceClass = GpuResourceClass::Buffer;
+        std::vector<std::unique_ptr<Heap>> heaps;
+    };
+
+    struct Record {
+        GpuAllocation allocation;
+        uint32_t poolIndex = 0;
+        uint64_t alignment = 0;
+        bool movable = false;
+        bool moving = false;
+    };
+
+    static uint32_t PoolIndex(GpuHeapType type, GpuResourceClass resourceClass);
+    Heap* FindHeap(uint32_t heapId);
+    Heap* CreateHeap(Pool& pool, uint64_t size, bool dedicated);
+    void AccumulateStats(const Pool& pool, GpuMemoryStats& stats) const;
+
+    IGpuHeapBackend* backend = nullptr;
+    Pool pools[static_cast<int>(GpuHeapType::Count) * static_cast<int>(GpuResourceClass::Count)];
+    std::unordered_map<uint32_t, Record> records;
+    uint32_t nextAllocationId = 1;
+    uint32_t nextHeapId = 1;
+};
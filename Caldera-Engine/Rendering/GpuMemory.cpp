@@ -0,0 +1,241 @@
+#include "GpuMemory.h"
+#include <cassert>
+
+static GpuHeapType ToGpuHeapType(D3D12_HEAP_TYPE type)
+{
+    switch (type) {
+    case D3D12_HEAP_TYPE_UPLOAD:   return GpuHeapType::Upload;
+    case D3D12_HEAP_TYPE_READBACK: return GpuHeapType::Readback;
+    default:                       return GpuHeapType::Default;
+    }
+}
+
+static D3D12_HEAP_TYPE ToD3D12HeapType(GpuHeapType type)
+{
+    switch (type) {
+    case GpuHeapType::Upload:   return D3D12_HEAP_TYPE_UPLOAD;
+    case GpuHeapType::Readback: return D3D12_HEAP_TYPE_READBACK;
+    default:                    return D3D12_HEAP_TYPE_DEFAULT;
+    }
+}
+
+static GpuResourceClass ClassifyResource(const D3D12_RESOURCE_DESC& desc)
+{
+    if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        return GpuResourceClass::Buffer;
+    if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+        return GpuResourceClass::RenderTarget;
+    return GpuResourceClass::Texture;
+}
+
+bool D3D12HeapBackend::CreateHeap(uint32_t heapId, GpuHeapType type, GpuResourceClass resourceClass, uint64_t size)
+{
+    D3D12_HEAP_DESC desc = {};
+    desc.SizeInBytes = (size + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) & ~UINT64(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1);
+    desc.Properties.Type = ToD3D12HeapType(type);
+    desc.Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    desc.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+    // Resource heap tier 1 cannot mix buffers, textures and render targets
+    switch (resourceClass) {
+    case GpuResourceClass::Buffer:       desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS; break;
+    case GpuResourceClass::Texture:      desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES; break;
+    case GpuResourceClass::RenderTarget: desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES; break;
+    default: break;
+    }
+
+    ComPtr<ID3D12Heap> heap;
+    if (FAILED(device->CreateHeap(&desc, IID_PPV_ARGS(&heap))))
+        return false;
+
+    heaps[heapId] = heap;
+    return true;
+}
+
+void D3D12HeapBackend::DestroyHeap(uint32_t heapId)
+{
+    heaps.erase(heapId);
+}
+
+ID3D12Heap* D3D12HeapBackend::GetHeap(uint32_t heapId) const
+{
+    auto it = heaps.find(heapId);
+    return it != heaps.end() ? it->second.Get() : nullptr;
+}
+
+bool GpuMemory::Create(ID3D12Device* device)
+{
+    assert(device && "Device is null");
+    this->device = device;
+    backend.SetDevice(device);
+    allocator.Initialize(&backend);
+    return true;
+}
+
+void GpuMemory::Destroy()
+{
+    pendingMoves.clear();
+    placements.clear();
+    resourcesByAllocation.clear();
+    allocator.Shutdown();
+    device = nullptr;
+}
+
+HRESULT GpuMemory::CreateResource(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES initialState,
+    const D3D12_CLEAR_VALUE* clearValue, ComPtr<ID3D12Resource>& outResource)
+{
+    GpuAllocation allocation;
+    HRESULT hr = Place(heapType, desc, initialState, clearValue, false, outResource, allocation);
+    if (FAILED(hr))
+        return hr;
+
+    Placement placement;
+    placement.allocationId = allocation.id;
+    placement.usageState = initialState;
+    placements[outResource.Get()] = placement;
+    resourcesByAllocation[allocation.id] = outResource.Get();
+    return S_OK;
+}
+
+HRESULT GpuMemory::CreateMovableResource(const D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES usageState,
+    ComPtr<ID3D12Resource>& outResource, GpuResourceMovedFn onMoved)
+{
+    GpuAllocation allocation;
+    HRESULT hr = Place(D3D12_HEAP_TYPE_DEFAULT, desc, usageState, nullptr, onMoved != nullptr, outResource, allocation);
+    if (FAILED(hr))
+        return hr;
+
+    Placement placement;
+    placement.allocationId = allocation.id;
+    placement.usageState = usageState;
+    placement.onMoved = std::move(onMoved);
+    placements[outResource.Get()] = placement;
+    resourcesByAllocation[allocation.id] = outResource.Get();
+    return S_OK;
+}
+
+void GpuMemory::ReleaseResource(ComPtr<ID3D12Resource>& resource)
+{
+    if (!resource)
+        return;
+
+    // Resources not created here (e.g. swapchain buffers) are simply released
+    auto it = placements.find(resource.Get());
+    if (it != placements.end()) {
+        allocator.Free(it->second.allocationId);
+        resourcesByAllocation.erase(it->second.allocationId);
+        placements.erase(it);
+    }
+    resource.Reset();
+}
+
+size_t GpuMemory::Defragment(ID3D12GraphicsCommandList* cmdList, uint64_t maxBytes)
+{
+    assert(pendingMoves.empty() && "Previous defragmentation pass not finished");
+
+    std::vector<GpuDefragMove> moves;
+    allocator.PlanDefragmentation(maxBytes, moves);
+
+    for (const GpuDefragMove& move : moves) {
+        ID3D12Resource* source = resourcesByAllocation[move.allocationId];
+        const Placement& placement = placements[source];
+        D3D12_RESOURCE_DESC desc = source->GetDesc();
+
+        ComPtr<ID3D12Resource> destination;
+        HRESULT hr = device->CreatePlacedResource(backend.GetHeap(move.to.heapId), move.to.offset, &desc,
+            D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&destination));
+        if (FAILED(hr)) {
+            allocator.CancelMove(move);
+            continue;
+        }
+
+        D3D12_RESOURCE_BARRIER barriers[2] = {};
+        barriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barriers[0].Transition.pResource = source;
+        barriers[0].Transition.StateBefore = placement.usageState;
+        barriers[0].Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_SOURCE;
+        barriers[0].Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+        cmdList->ResourceBarrier(1, barriers);
+
+        cmdList->CopyResource(destination.Get(), source);
+
+        // The source stays usable until FinishDefragmentation swaps owners over
+        barriers[0].Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_SOURCE;
+        barriers[0].Transition.StateAfter = placement.usageState;
+        barriers[1] = barriers[0];
+        barriers[1].Transition.pResource = destination.Get();
+        barriers[1].Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+        cmdList->ResourceBarrier(2, barriers);
+
+        pendingMoves.push_back({ move, source, destination });
+    }
+
+    return pendingMoves.size();
+}
+
+void GpuMemory::FinishDefragmentation(const GpuDeferReleaseFn& deferRelease)
+{
+    for (PendingMove& pending : pendingMoves) {
+        auto it = placements.find(pending.source.Get());
+        if (it == placements.end()) {
+            allocator.CancelMove(pending.move);
+            continue;
+        }
+
+        Placement placement = std::move(it->second);
+        placements.erase(it);
+        allocator.CommitMove(pending.move);
+
+        if (placement.onMoved)
+            placement.onMoved(pending.destination.Get());
+
+        resourcesByAllocation[pending.move.allocationId] = pending.destination.Get();
+        placements[pending.destination.Get()] = std::move(placement);
+
+        // Frames in flight may still draw from the source, so its range is only reused once they retire
+        deferRelease([this, move = pending.move, source = pending.source]() mutable {
+            source.Reset();
+            allocator.ReleaseMovedRange(move);
+            allocator.ReleaseEmptyHeaps();
+        });
+    }
+
+    pendingMoves.clear();
+}
+
+HRESULT GpuMemory::Place(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES initialState,
+    const D3D12_CLEAR_VALUE* clearValue, bool movable, ComPtr<ID3D12Resource>& outResource, GpuAllocation& outAllocation)
+{
+    const GpuResourceClass resourceClass = ClassifyResource(*desc);
+    D3D12_RESOURCE_DESC placedDesc = *desc;
+    D3D12_RESOURCE_ALLOCATION_INFO info = {};
+
+    // Small non-RT textures can use 4KB placement instead of 64KB
+    if (resourceClass == GpuResourceClass::Texture && placedDesc.SampleDesc.Count <= 1) {
+        placedDesc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+        info = device->GetResourceAllocationInfo(0, 1, &placedDesc);
+        if (info.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+            placedDesc.Alignment = 0;
+    }
+    else {
+        placedDesc.Alignment = 0;
+    }
+
+    if (placedDesc.Alignment == 0)
+        info = device->GetResourceAllocationInfo(0, 1, &placedDesc);
+    if (info.SizeInBytes == UINT64_MAX)
+        return E_INVALIDARG;
+
+    outAllocation = allocator.Allocate(ToGpuHeapType(heapType), resourceClass, info.SizeInBytes, info.Alignment, movable);
+    if (!outAllocation.IsValid())
+        return E_OUTOFMEMORY;
+
+    HRESULT hr = device->CreatePlacedResource(backend.GetHeap(outAllocation.heapId), outAllocation.offset, &placedDesc,
+        initialState, clearValue, IID_PPV_ARGS(&outResource));
+    if (FAILED(hr)) {
+        allocator.Free(outAllocation.id);
+        outAllocation = GpuAllocation();
+    }
+    return hr;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "GpuHeapAllocator.h"
+
+using namespace Microsoft::WRL;
+
+// Invoked when defragmentation replaced a resource, so its owner can swap its
+// pointer and recreate any views that referenced the old one.
+using GpuResourceMovedFn = std::function<void(ID3D12Resource* newResource)>;
+
+// Runs 'release' once the GPU has finished every frame submitted so far.
+using GpuDeferReleaseFn = std::function<void(std::function<void()> release)>;
+
+class D3D12HeapBackend : public IGpuHeapBackend {
+public:
+    void SetDevice(ID3D12Device* device) { this->device = device; }
+
+    bool CreateHeap(uint32_t heapId, GpuHeapType type, GpuResourceClass resourceClass, uint64_t size) override;
+    void DestroyHeap(uint32_t heapId) override;
+    ID3D12Heap* GetHeap(uint32_t heapId) const;
+
+private:
+    ID3D12Device* device = nullptr;
+    std::unordered_map<uint32_t, ComPtr<ID3D12Heap>> heaps;
+};
+
+// Places resources into large shared heaps instead of giving every buffer and
+// texture its own committed allocation.
+class GpuMemory {
+public:
+    bool Create(ID3D12Device* device);
+    void Destroy();
+
+    // Drop-in replacement for CreateCommittedResource.
+    HRESULT CreateResource(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES initialState,
+        const D3D12_CLEAR_VALUE* clearValue, ComPtr<ID3D12Resource>& outResource);
+
+    // DEFAULT heap resource that defragmentation may relocate. Its contents must not
+    // change after upload and it must sit in 'usageState' between frames.
+    HRESULT CreateMovableResource(const D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES usageState,
+        ComPtr<ID3D12Resource>& outResource, GpuResourceMovedFn onMoved);
+
+    // Returns the resource's range to its heap. The GPU must be done with it.
+    void ReleaseResource(ComPtr<ID3D12Resource>& resource);
+
+    // Records copies for up to 'maxBytes' of relocations into a DIRECT list.
+    // Call FinishDefragmentation once that list is submitted: owners switch to the
+    // copies, which later work on the queue sees complete, and the old ranges go
+    // back to their heaps through 'deferRelease' once nothing can still read them.
+    size_t Defragment(ID3D12GraphicsCommandList* cmdList, uint64_t maxBytes);
+    void FinishDefragmentation(const GpuDeferReleaseFn& deferRelease);
+    bool IsDefragmenting() const { return !pendingMoves.empty(); }
+
+    GpuMemoryStats GetStats() const { return allocator.GetStats(); }
+
+private:
+    struct Placement {
+        uint32_t allocationId = 0;
+        D3D12_RESOURCE_STATES usageState = D3D12_RESOURCE_STATE_COMMON;
+        GpuResourceMovedFn onMoved;
+    };
+
+    struct PendingMove {
+        GpuDefragMove move;
+        ComPtr<ID3D12Resource> source;
+        ComPtr<ID3D12Resource> destination;
+    };
+
+    HRESULT Place(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES initialState,
+        const D3D12_CLEAR_VALUE* clearValue, bool movable, ComPtr<ID3D12Resource>& outResource, GpuAllocation& outAllocation);
+
+    ID3D12Device* device = nullptr;
+    D3D12HeapBackend backend;
+    GpuHeapAllocator allocator;
+
+    std::unordered_map<ID3D12Resource*, Placement> placements;
+    std::unordered_map<uint32_t, ID3D12Resource*> resourcesByAllocation;
+    std::vector<PendingMove> pendingMoves;
+};
@@ -0,0 +1,83 @@
+#include "GpuTimerD3D12.h"
+#include "GpuMemory.h"
+#include <cassert>
+
+// Begin and end timestamp of a frame
+static constexpr UINT QUERIES_PER_SLOT = 2;
+
+bool D3D12GpuFrameTimer::Create(ID3D12Device* device, ID3D12CommandQueue* queue, GpuMemory* gpuMemory, uint32_t slotCount)
+{
+    assert(device && queue && gpuMemory && slotCount > 0 && "Invalid frame timer arguments");
+    this->gpuMemory = gpuMemory;
+    if (FAILED(queue->GetTimestampFrequency(&frequency)) || frequency == 0)
+        return false;
+
+    D3D12_QUERY_HEAP_DESC heapDesc = {};
+    heapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    heapDesc.Count = slotCount * QUERIES_PER_SLOT;
+    if (FAILED(device->CreateQueryHeap(&heapDesc, IID_PPV_ARGS(&queryHeap))))
+        return false;
+
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    desc.Width = UINT64(heapDesc.Count) * sizeof(UINT64);
+    desc.Height = 1;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 1;
+    desc.SampleDesc.Count = 1;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    if (FAILED(gpuMemory->CreateResource(D3D12_HEAP_TYPE_READBACK, &desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, readback)))
+        return false;
+
+    pending.assign(slotCount, false);
+    return true;
+}
+
+void D3D12GpuFrameTimer::Destroy()
+{
+    if (!gpuMemory)
+        return;
+    gpuMemory->ReleaseResource(readback);
+    queryHeap.Reset();
+    pending.clear();
+}
+
+void D3D12GpuFrameTimer::BeginFrame(ID3D12GraphicsCommandList* cmdList, uint32_t slot)
+{
+    if (!queryHeap)
+        return;
+    cmdList->EndQuery(queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, slot * QUERIES_PER_SLOT);
+}
+
+void D3D12GpuFrameTimer::EndFrame(ID3D12GraphicsCommandList* cmdList, uint32_t slot)
+{
+    if (!queryHeap)
+        return;
+    const UINT first = slot * QUERIES_PER_SLOT;
+    cmdList->EndQuery(queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, first + 1);
+    cmdList->ResolveQueryData(queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, first, QUERIES_PER_SLOT,
+        readback.Get(), UINT64(first) * sizeof(UINT64));
+    pending[slot] = true;
+}
+
+float D3D12GpuFrameTimer::ReadFrameMs(uint32_t slot)
+{
+    if (!queryHeap || !pending[slot])
+        return 0.0f;
+    pending[slot] = false;
+
+    // Only this slot's pair is read, the other slots may still be written by the GPU
+    const SIZE_T offset = SIZE_T(slot) * QUERIES_PER_SLOT * sizeof(UINT64);
+    D3D12_RANGE readRange = { offset, offset + QUERIES_PER_SLOT * sizeof(UINT64) };
+    UINT64* mapped = nullptr;
+    if (FAILED(readback->Map(0, &readRange, reinterpret_cast<void**>(&mapped))))
+        return 0.0f;
+    const UINT64 begin = mapped[slot * QUERIES_PER_SLOT];
+    const UINT64 end = mapped[slot * QUERIES_PER_SLOT + 1];
+    D3D12_RANGE written = { 0, 0 };
+    readback->Unmap(0, &written);
+
+    if (end <= begin)
+        return 0.0f;
+    return static_cast<float>(double(end - begin) * 1000.0 / double(frequency));
+}
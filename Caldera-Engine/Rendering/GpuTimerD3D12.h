@@ -0,0 +1,35 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <vector>
+
+using namespace Microsoft::WRL;
+
+class GpuMemory;
+
+// Measures each frame's GPU time with a pair of timestamp queries per frame
+// slot, from the start of the frame's first command list to the end of its
+// last. The results are resolved into a readback buffer and read back once the
+// slot's frame has retired, so reading never stalls.
+class D3D12GpuFrameTimer {
+public:
+    // 'queue' is the graphics queue the frames execute on.
+    bool Create(ID3D12Device* device, ID3D12CommandQueue* queue, GpuMemory* gpuMemory, uint32_t slotCount);
+    // Caller has already waited for the GPU.
+    void Destroy();
+
+    // Record at the very start and end of the slot's frame.
+    void BeginFrame(ID3D12GraphicsCommandList* cmdList, uint32_t slot);
+    void EndFrame(ID3D12GraphicsCommandList* cmdList, uint32_t slot);
+
+    // GPU milliseconds of the slot's last frame, which must have retired. Each
+    // frame is reported once; 0 if there is nothing new.
+    float ReadFrameMs(uint32_t slot);
+
+private:
+    GpuMemory* gpuMemory = nullptr;
+    ComPtr<ID3D12QueryHeap> queryHeap;
+    ComPtr<ID3D12Resource> readback;
+    UINT64 frequency = 0;
+    std::vector<bool> pending;  // per slot: resolved but not yet read
+};
@@ -0,0 +1,168 @@
+#include "HeadlessRenderer.h"
+#include "../Core/TaskPool.h"
+
+// DXGI_FORMAT values, so headless graphs describe the same textures as on D3D12
+static constexpr uint32_t FORMAT_R8G8B8A8_UNORM = 28;
+static constexpr uint32_t FORMAT_D32_FLOAT = 40;
+
+bool HeadlessRenderer::Initialize(uint32_t width, uint32_t height, TaskPool* taskPool)
+{
+    if (width == 0 || height == 0)
+        return false;
+
+    this->width = width;
+    this->height = height;
+    queueScheduler.Initialize(&gpuTimeline);
+    frameLifecycle.Initialize(&queueScheduler, &frameClock, FRAMES_IN_FLIGHT);
+    recorder.Initialize(taskPool, &secondaryLists);
+    parallel = taskPool != nullptr;
+    drawList.Initialize(taskPool);
+    instanceMemory.assign(size_t(MAX_DRAW_INSTANCES) * sizeof(DrawInstanceData) * FRAMES_IN_FLIGHT, 0);
+    instanceRing.Initialize(instanceMemory.data(), uint64_t(MAX_DRAW_INSTANCES) * sizeof(DrawInstanceData), FRAMES_IN_FLIGHT);
+
+    for (uint32_t i = 0; i < BACK_BUFFER_COUNT; ++i)
+        commandList.RegisterResource(ID_BACK_BUFFER_0 + i, "BackBuffer" + std::to_string(i), RGState::Present);
+
+    // Upload-heap buffers are always readable, like GENERIC_READ on D3D12
+    commandList.RegisterResource(ID_VERTEX_BUFFER, "VertexBuffer", RGState::ShaderResource | RGState::CopySource);
+    commandList.RegisterResource(ID_INDEX_BUFFER, "IndexBuffer", RGState::ShaderResource | RGState::CopySource);
+    commandList.RegisterResource(ID_MATERIAL_BUFFER, "MaterialBuffer", RGState::ShaderResource | RGState::CopySource);
+    commandList.RegisterResource(ID_OBJECT_BUFFER, "ObjectBuffer", RGState::ShaderResource | RGState::CopySource);
+    commandList.RegisterResource(ID_DRAW_COUNT_RESET, "DrawCountReset", RGState::ShaderResource | RGState::CopySource);
+    commandList.RegisterResource(ID_DRAW_COMMANDS, "DrawCommands", RGState::IndirectArgument);
+    commandList.RegisterResource(ID_DRAW_COUNT, "DrawCount", RGState::IndirectArgument);
+    commandList.RegisterResource(ID_SCENE_COLOR, "SceneColor", RGState::ShaderResource);
+    commandList.RegisterResource(ID_SCENE_DEPTH, "SceneDepth", RGState::DepthWrite);
+    commandList.RegisterPipeline(ID_SCENE_PIPELINE, "ScenePipeline");
+    commandList.RegisterPipeline(ID_CULL_PIPELINE, "CullPipeline");
+
+    // Same cube as Renderer::CreateDefaultResources: 8 vertices of position + color, 36 32-bit indices
+    scene.pipeline = ID_SCENE_PIPELINE;
+    scene.vertexBuffer = ID_VERTEX_BUFFER;
+    scene.indexBuffer = ID_INDEX_BUFFER;
+    scene.vertexStride = 6 * sizeof(float);
+    scene.vertexBufferSize = 8 * scene.vertexStride;
+    scene.indexBufferSize = 36 * sizeof(uint32_t);
+    scene.materialBuffer = 0;
+    SetDrawCount(1);
+
+    backBufferIndex = 0;
+    frameCount = 0;
+    return true;
+}
+
+void HeadlessRenderer::SetDrawCount(uint32_t count, uint32_t materialCount)
+{
+    useDrawList = false;
+    draws.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        draws[i].indexCount = 36;
+        draws[i].materialIndex = materialCount > 0 ? i % materialCount : 0;
+    }
+    scene.draws = draws.data();
+    scene.drawCount = count;
+}
+
+void HeadlessRenderer::SetRenderables(std::vector<Renderable> renderables)
+{
+    this->renderables = std::move(renderables);
+    useDrawList = true;
+}
+
+void HeadlessRenderer::SetSceneTarget(uint32_t width, uint32_t height)
+{
+    sceneTargetWidth = width;
+    sceneTargetHeight = height;
+}
+
+void HeadlessRenderer::SetGpuDriven(bool enabled, uint32_t maxObjects)
+{
+    gpuDriven = enabled;
+    maxGpuObjects = maxObjects;
+}
+
+void HeadlessRenderer::SetViewProjection(const float viewProjection[16])
+{
+    for (int i = 0; i < 16; ++i)
+        this->viewProjection[i] = viewProjection[i];
+}
+
+void HeadlessRenderer::Shutdown()
+{
+    queueScheduler.WaitIdle();
+    frameLifecycle.Shutdown();
+    graphBackend.BeginFrame(&commandList);
+    graphBackend.Destroy();
+    frameGraph.Reset();
+    commandList.Reset();
+}
+
+bool HeadlessRenderer::RenderFrame()
+{
+    // Same pacing as the editor: wait until the frame that last used this slot retired
+    const uint32_t slot = frameLifecycle.BeginFrame();
+
+    commandList.Reset();
+    graphBackend.BeginFrame(&commandList);
+    secondaryLists.BeginFrame(&commandList);
+
+    if (useDrawList) {
+        static const DrawMesh cube = { 36, 0, 0 };
+        drawList.Begin();
+        drawList.Reserve(static_cast<uint32_t>(renderables.size()));
+        for (const Renderable& renderable : renderables)
+            drawList.Add(renderable);
+        instanceRing.BeginFrame(slot);
+        drawList.Build(instanceRing);
+        drawList.ToSceneDraws(&cube, 1, draws);
+        scene.draws = draws.data();
+        scene.drawCount = static_cast<uint32_t>(draws.size());
+    }
+
+    FrameSetup setup;
+    setup.backBufferDesc.width = width;
+    setup.backBufferDesc.height = height;
+    setup.backBufferDesc.format = FORMAT_R8G8B8A8_UNORM;
+    setup.backBuffer = reinterpret_cast<void*>(static_cast<uintptr_t>(ID_BACK_BUFFER_0 + backBufferIndex));
+    setup.depthFormat = FORMAT_D32_FLOAT;
+    setup.viewport.width = static_cast<float>(width);
+    setup.viewport.height = static_cast<float>(height);
+    if (sceneTargetWidth > 0 && sceneTargetHeight > 0) {
+        setup.sceneColorDesc = setup.backBufferDesc;
+        setup.sceneColorDesc.width = sceneTargetWidth;
+        setup.sceneColorDesc.height = sceneTargetHeight;
+        setup.sceneColor = reinterpret_cast<void*>(static_cast<uintptr_t>(ID_SCENE_COLOR));
+        setup.sceneDepth = reinterpret_cast<void*>(static_cast<uintptr_t>(ID_SCENE_DEPTH));
+        setup.viewport.width = static_cast<float>(sceneTargetWidth);
+        setup.viewport.height = static_cast<float>(sceneTargetHeight);
+    }
+    setup.scene = scene;
+    setup.recordUi = uiRecorder;
+    setup.recorder = parallel ? &recorder : nullptr;
+
+    IndirectSceneParams indirect;
+    if (gpuDriven) {
+        indirect.cullPipeline = ID_CULL_PIPELINE;
+        indirect.objectBuffer = ID_OBJECT_BUFFER;
+        indirect.commandBuffer = ID_DRAW_COMMANDS;
+        indirect.countBuffer = ID_DRAW_COUNT;
+        indirect.countResetBuffer = ID_DRAW_COUNT_RESET;
+        indirect.maxObjects = maxGpuObjects;
+        uint32_t objectCount = static_cast<uint32_t>(sceneObjects.size());
+        indirect.constants = MakeCullConstants(viewProjection, objectCount < maxGpuObjects ? objectCount : maxGpuObjects);
+        setup.indirect = &indirect;
+    }
+
+    frameGraph.Reset();
+    AddFramePasses(frameGraph, commandList, setup);
+    bool compiled = frameGraph.Compile(&graphBackend);
+    if (compiled)
+        frameGraph.Execute(graphBackend);
+
+    queueScheduler.FlushWaits(QueueType::Graphics);
+    frameLifecycle.EndFrame(queueScheduler.Submit(QueueType::Graphics));
+
+    backBufferIndex = (backBufferIndex + 1) % BACK_BUFFER_COUNT;
+    ++frameCount;
+    return compiled && commandList.GetErrors().empty();
+}
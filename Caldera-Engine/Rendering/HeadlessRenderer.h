@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "QueueSync.h"
+#include "FrameLifecycle.h"
+#include "RenderGraph.h"
+#include "NullRHI.h"
+#include "FramePasses.h"
+#include "ParallelRecorder.h"
+#include "DrawList.h"
+
+class TaskPool;
+
+// Runs the editor's frame loop on the null backend: frame pacing on a simulated
+// GPU timeline, the same frame graph and passes as Renderer, and a recorded,
+// validated command stream per frame. Needs no window, device or GPU, so frame
+// benchmarks and golden command-stream comparisons can run on any build machine.
+class HeadlessRenderer {
+public:
+    static constexpr uint32_t FRAMES_IN_FLIGHT = 2;
+    static constexpr uint32_t BACK_BUFFER_COUNT = 2;
+    static constexpr uint32_t MAX_DRAW_INSTANCES = 65536;
+
+    // With a task pool, scene draws are recorded in parallel into secondary lists.
+    bool Initialize(uint32_t width, uint32_t height, TaskPool* taskPool = nullptr);
+    void Shutdown();
+
+    // Records, validates and "submits" one frame. Returns false if the graph
+    // failed to compile or the command stream broke a state rule.
+    bool RenderFrame();
+
+    // Replaces the UI pass contents; an empty function drops the pass.
+    void SetUiRecorder(std::function<void(IRHICommandList&)> recorder) { uiRecorder = std::move(recorder); }
+    // Scene draw parameters, e.g. to skip the draw. Ids must be registered with GetCommandList.
+    SceneDrawParams& GetScene() { return scene; }
+    // Replaces the scene with 'count' copies of the cube draw, cycling through 'materialCount' materials.
+    void SetDrawCount(uint32_t count, uint32_t materialCount = 1);
+    // Replaces the scene with a draw list built from 'renderables' every frame.
+    // Mesh 0 is the cube; up to MAX_DRAW_INSTANCES instances fit per frame.
+    void SetRenderables(std::vector<Renderable> renderables);
+    const DrawListBuilder& GetDrawList() const { return drawList; }
+
+    // Renders the scene into an offscreen target the UI samples, as the editor
+    // viewport does. A zero size renders into the back buffer again.
+    void SetSceneTarget(uint32_t width, uint32_t height);
+
+    // Switches to the GPU-driven path: a culling dispatch plus one indirect draw.
+    // Nothing executes, so pair it with CullObjectsReference to know what the GPU would draw.
+    void SetGpuDriven(bool enabled, uint32_t maxObjects = 65536);
+    std::vector<GpuObjectData>& GetSceneObjects() { return sceneObjects; }
+    void SetViewProjection(const float viewProjection[16]);
+
+    NullCommandList& GetCommandList() { return commandList; }
+    const RenderGraph& GetFrameGraph() const { return frameGraph; }
+    const RenderGraphStats& GetFrameGraphStats() const { return frameGraph.GetStats(); }
+    const ParallelRecorder& GetRecorder() const { return recorder; }
+    SimulatedGpuTimeline& GetGpuTimeline() { return gpuTimeline; }
+    uint64_t GetFrameCount() const { return frameCount; }
+
+private:
+    // Fake ids for the objects Renderer would own; real pointers never get this low
+    enum : RHIResourceId {
+        ID_BACK_BUFFER_0 = 0x100,
+        ID_VERTEX_BUFFER = 0x200,
+        ID_INDEX_BUFFER,
+        ID_MATERIAL_BUFFER,
+        ID_OBJECT_BUFFER,
+        ID_DRAW_COMMANDS,
+        ID_DRAW_COUNT,
+        ID_DRAW_COUNT_RESET,
+        ID_SCENE_COLOR,
+        ID_SCENE_DEPTH,
+    };
+    static constexpr RHIPipelineId ID_SCENE_PIPELINE = 0x300;
+    static constexpr RHIPipelineId ID_CULL_PIPELINE = 0x301;
+
+    SimulatedGpuTimeline gpuTimeline;
+    QueueScheduler queueScheduler;
+    NullCommandList commandList;
+    NullRenderGraphBackend graphBackend;
+    RenderGraph frameGraph;
+    NullSecondaryLists secondaryLists;
+    ParallelRecorder recorder;
+    bool parallel = false;
+
+    SceneDrawParams scene;
+    std::vector<SceneDraw> draws;
+
+    uint32_t sceneTargetWidth = 0;
+    uint32_t sceneTargetHeight = 0;
+
+    bool useDrawList = false;
+    std::vector<Renderable> renderables;
+    DrawListBuilder drawList;
+    std::vector<uint8_t> instanceMemory;
+    InstanceRing instanceRing;
+
+    bool gpuDriven = false;
+    uint32_t maxGpuObjects = 0;
+    std::vector<GpuObjectData> sceneObjects;
+    float viewProjection[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    std::function<void(IRHICommandList&)> uiRecorder;
+
+    ManualFrameClock frameClock;
+    FrameLifecycle frameLifecycle;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t backBufferIndex = 0;
+    uint64_t frameCount = 0;
+};
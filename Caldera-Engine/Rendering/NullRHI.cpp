@@ -0,0 +1,656 @@
+#include "NullRHI.h"
+#include <cassert>
+#include <cstdio>
+
+static const char* const COMMAND_NAMES[] = {
+    "Barrier",
+    "SetRenderTargets",
+    "ClearRenderTarget",
+    "ClearDepth",
+    "SetViewport",
+    "SetScissor",
+    "SetDescriptorHeap",
+    "SetPipeline",
+    "SetRootConstants",
+    "SetDescriptorTable",
+    "SetRootShaderResource",
+    "SetRootUnorderedAccess",
+    "SetVertexBuffer",
+    "SetIndexBuffer",
+    "DrawIndexed",
+    "Dispatch",
+    "DrawIndexedIndirect",
+    "CopyBuffer",
+    "CopyTexture",
+    "WriteDescriptor",
+};
+static_assert(sizeof(COMMAND_NAMES) / sizeof(COMMAND_NAMES[0]) == static_cast<size_t>(RHICommandType::Count), "Command name table out of date");
+
+const char* ToString(RHICommandType type)
+{
+    return type < RHICommandType::Count ? COMMAND_NAMES[static_cast<int>(type)] : "Unknown";
+}
+
+static std::string StateToString(RGState state)
+{
+    static const char* const names[] = {
+        "Present", "RenderTarget", "DepthWrite", "DepthRead",
+        "ShaderResource", "UnorderedAccess", "CopySource", "CopyDest", "IndirectArgument"
+    };
+    if (state == RGState::Undefined)
+        return "Undefined";
+
+    std::string result;
+    for (uint32_t bit = 0; bit < sizeof(names) / sizeof(names[0]); ++bit) {
+        if ((static_cast<uint32_t>(state) & (1u << bit)) == 0)
+            continue;
+        if (!result.empty())
+            result += '|';
+        result += names[bit];
+    }
+    return result;
+}
+
+void NullCommandList::RegisterResource(RHIResourceId id, const std::string& name, RGState initialState)
+{
+    assert(id != RHI_NULL_RESOURCE && "Null resource id");
+    TrackedResource& resource = resources[id];
+    resource.name = name;
+    resource.state = initialState;
+}
+
+void NullCommandList::UnregisterResource(RHIResourceId id)
+{
+    resources.erase(id);
+}
+
+RGState NullCommandList::GetState(RHIResourceId id) const
+{
+    auto it = resources.find(id);
+    return it != resources.end() ? it->second.state : RGState::Undefined;
+}
+
+void NullCommandList::Reset()
+{
+    commands.clear();
+    errors.clear();
+    boundColorCount = 0;
+    boundDepth = RHI_NULL_RESOURCE;
+    boundPipeline = RHI_NULL_PIPELINE;
+    boundVertexBuffer = RHI_NULL_RESOURCE;
+    boundIndexBuffer = RHI_NULL_RESOURCE;
+    heapBound = false;
+}
+
+void NullCommandList::InheritResources(const NullCommandList& other)
+{
+    resources = other.resources;
+    pipelines = other.pipelines;
+}
+
+void NullCommandList::Append(const NullCommandList& other)
+{
+    commands.insert(commands.end(), other.commands.begin(), other.commands.end());
+    errors.insert(errors.end(), other.errors.begin(), other.errors.end());
+    for (const auto& entry : other.resources) {
+        auto it = resources.find(entry.first);
+        if (it != resources.end())
+            it->second.state = entry.second.state;
+    }
+}
+
+size_t NullCommandList::Count(RHICommandType type) const
+{
+    size_t count = 0;
+    for (const RHICommand& command : commands)
+        if (command.type == type)
+            ++count;
+    return count;
+}
+
+std::string NullCommandList::Serialize() const
+{
+    std::string out;
+    char line[256];
+    for (const RHICommand& c : commands) {
+        out += ToString(c.type);
+        switch (c.type) {
+        case RHICommandType::Barrier:
+            if (c.barrier.type == RHIBarrierType::Transition) {
+                out += " Transition " + NameOf(c.barrier.resource) + " " + StateToString(c.barrier.before) + " -> " + StateToString(c.barrier.after);
+            }
+            else if (c.barrier.type == RHIBarrierType::Aliasing) {
+                out += " Aliasing " + (c.barrier.aliasBefore != RHI_NULL_RESOURCE ? NameOf(c.barrier.aliasBefore) : std::string("-")) + " -> " + NameOf(c.barrier.resource);
+            }
+            else {
+                out += " UAV " + NameOf(c.barrier.resource);
+            }
+            break;
+        case RHICommandType::SetRenderTargets:
+            for (uint64_t i = 0; i < c.args[0] && i < 4; ++i)
+                out += " " + NameOf(c.resources[i]);
+            out += " depth=" + (c.args[1] != RHI_NULL_RESOURCE ? NameOf(c.args[1]) : std::string("-"));
+            break;
+        case RHICommandType::ClearRenderTarget:
+            snprintf(line, sizeof(line), " (%g, %g, %g, %g)", c.values[0], c.values[1], c.values[2], c.values[3]);
+            out += " " + NameOf(c.resources[0]) + line;
+            break;
+        case RHICommandType::ClearDepth:
+            snprintf(line, sizeof(line), " %g", c.values[0]);
+            out += " " + NameOf(c.resources[0]) + line;
+            break;
+        case RHICommandType::SetViewport:
+            snprintf(line, sizeof(line), " %g %g %g %g [%g, %g]", c.values[0], c.values[1], c.values[2], c.values[3], c.values[4], c.values[5]);
+            out += line;
+            break;
+        case RHICommandType::SetScissor:
+            snprintf(line, sizeof(line), " %d %d %d %d", int32_t(c.args[0]), int32_t(c.args[1]), int32_t(c.args[2]), int32_t(c.args[3]));
+            out += line;
+            break;
+        case RHICommandType::SetPipeline:
+            out += " " + PipelineNameOf(c.args[0]);
+            break;
+        case RHICommandType::SetRootConstants:
+            snprintf(line, sizeof(line), " slot=%llu", (unsigned long long)c.args[0]);
+            out += line;
+            for (uint64_t i = 0; i < c.args[1] && i < MAX_RECORDED_ROOT_CONSTANTS; ++i) {
+                snprintf(line, sizeof(line), " %llu", (unsigned long long)c.args[2 + i]);
+                out += line;
+            }
+            break;
+        case RHICommandType::SetDescriptorTable:
+            snprintf(line, sizeof(line), " slot=%llu first=%llu", (unsigned long long)c.args[0], (unsigned long long)c.args[1]);
+            out += line;
+            break;
+        case RHICommandType::SetRootShaderResource:
+        case RHICommandType::SetRootUnorderedAccess:
+            snprintf(line, sizeof(line), " slot=%llu ", (unsigned long long)c.args[0]);
+            out += line + NameOf(c.resources[0]);
+            break;
+        case RHICommandType::SetVertexBuffer:
+        case RHICommandType::SetIndexBuffer:
+            snprintf(line, sizeof(line), " %llu %llu", (unsigned long long)c.args[0], (unsigned long long)c.args[1]);
+            out += " " + NameOf(c.resources[0]) + line;
+            break;
+        case RHICommandType::DrawIndexed:
+            snprintf(line, sizeof(line), " %llu %llu %llu %lld %llu", (unsigned long long)c.args[0], (unsigned long long)c.args[1],
+                (unsigned long long)c.args[2], (long long)(int64_t)c.args[3], (unsigned long long)c.args[4]);
+            out += line;
+            break;
+        case RHICommandType::Dispatch:
+            snprintf(line, sizeof(line), " %llu %llu %llu", (unsigned long long)c.args[0], (unsigned long long)c.args[1], (unsigned long long)c.args[2]);
+            out += line;
+            break;
+        case RHICommandType::DrawIndexedIndirect:
+            snprintf(line, sizeof(line), "+%llu max=%llu count=", (unsigned long long)c.args[0], (unsigned long long)c.args[1]);
+            out += " " + NameOf(c.resources[0]) + line + NameOf(c.resources[1]);
+            snprintf(line, sizeof(line), "+%llu", (unsigned long long)c.args[2]);
+            out += line;
+            break;
+        case RHICommandType::CopyBuffer:
+            snprintf(line, sizeof(line), " +%llu <- ", (unsigned long long)c.args[0]);
+            out += " " + NameOf(c.resources[0]) + line + NameOf(c.resources[1]);
+            snprintf(line, sizeof(line), " +%llu %llu", (unsigned long long)c.args[1], (unsigned long long)c.args[2]);
+            out += line;
+            break;
+        case RHICommandType::CopyTexture:
+            out += " " + NameOf(c.resources[0]) + " <- " + NameOf(c.resources[1]);
+            break;
+        case RHICommandType::WriteDescriptor:
+            snprintf(line, sizeof(line), " %llu ", (unsigned long long)c.args[0]);
+            out += line + NameOf(c.resources[0]) + (c.args[1] == uint64_t(RHIDescriptorType::Texture) ? " Texture" : " Buffer");
+            break;
+        default:
+            break;
+        }
+        out += '\n';
+    }
+    return out;
+}
+
+void NullCommandList::Barriers(const RHIBarrier* barriers, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        const RHIBarrier& barrier = barriers[i];
+        Record(RHICommandType::Barrier).barrier = barrier;
+        if (!Require(barrier.resource, "Barrier"))
+            continue;
+
+        if (barrier.type == RHIBarrierType::Aliasing) {
+            if (barrier.aliasBefore != RHI_NULL_RESOURCE)
+                Require(barrier.aliasBefore, "Barrier");
+            continue;
+        }
+        if (barrier.type != RHIBarrierType::Transition)
+            continue;
+
+        TrackedResource& resource = resources[barrier.resource];
+        if (barrier.before != resource.state)
+            Error("Barrier: " + resource.name + " is in " + StateToString(resource.state) + ", not " + StateToString(barrier.before));
+        if (barrier.after == RGState::Undefined)
+            Error("Barrier: " + resource.name + " transitions to Undefined");
+        resource.state = barrier.after;
+    }
+}
+
+void NullCommandList::SetRenderTargets(const RHIResourceId* colors, uint32_t colorCount, RHIResourceId depth)
+{
+    RHICommand& command = Record(RHICommandType::SetRenderTargets);
+    command.args[0] = colorCount;
+    command.args[1] = depth;
+    for (uint32_t i = 0; i < colorCount && i < 4; ++i)
+        command.resources[i] = colors[i];
+
+    if (colorCount > MAX_RENDER_TARGETS) {
+        Error("SetRenderTargets: too many render targets");
+        colorCount = MAX_RENDER_TARGETS;
+    }
+    for (uint32_t i = 0; i < colorCount; ++i) {
+        RequireState(colors[i], RGState::RenderTarget, "SetRenderTargets");
+        boundColors[i] = colors[i];
+    }
+    boundColorCount = colorCount;
+
+    if (depth != RHI_NULL_RESOURCE && Require(depth, "SetRenderTargets")) {
+        RGState state = GetState(depth);
+        if ((state & (RGState::DepthWrite | RGState::DepthRead)) == RGState::Undefined)
+            Error("SetRenderTargets: " + NameOf(depth) + " is in " + StateToString(state) + ", not a depth state");
+    }
+    boundDepth = depth;
+}
+
+void NullCommandList::ClearRenderTarget(RHIResourceId target, const float color[4])
+{
+    RHICommand& command = Record(RHICommandType::ClearRenderTarget);
+    command.resources[0] = target;
+    for (int i = 0; i < 4; ++i)
+        command.values[i] = color[i];
+    RequireState(target, RGState::RenderTarget, "ClearRenderTarget");
+}
+
+void NullCommandList::ClearDepth(RHIResourceId target, float depth)
+{
+    RHICommand& command = Record(RHICommandType::ClearDepth);
+    command.resources[0] = target;
+    command.values[0] = depth;
+    RequireState(target, RGState::DepthWrite, "ClearDepth");
+}
+
+void NullCommandList::SetViewport(const RHIViewport& viewport)
+{
+    RHICommand& command = Record(RHICommandType::SetViewport);
+    command.values[0] = viewport.x;
+    command.values[1] = viewport.y;
+    command.values[2] = viewport.width;
+    command.values[3] = viewport.height;
+    command.values[4] = viewport.minDepth;
+    command.values[5] = viewport.maxDepth;
+    if (viewport.width <= 0.0f || viewport.height <= 0.0f)
+        Error("SetViewport: empty viewport");
+}
+
+void NullCommandList::SetScissor(const RHIRect& rect)
+{
+    RHICommand& command = Record(RHICommandType::SetScissor);
+    command.args[0] = uint64_t(int64_t(rect.left));
+    command.args[1] = uint64_t(int64_t(rect.top));
+    command.args[2] = uint64_t(int64_t(rect.right));
+    command.args[3] = uint64_t(int64_t(rect.bottom));
+}
+
+void NullCommandList::SetDescriptorHeap()
+{
+    Record(RHICommandType::SetDescriptorHeap);
+    heapBound = true;
+}
+
+void NullCommandList::SetPipeline(RHIPipelineId pipeline)
+{
+    Record(RHICommandType::SetPipeline).args[0] = pipeline;
+    if (pipelines.find(pipeline) == pipelines.end())
+        Error("SetPipeline: unknown pipeline");
+    boundPipeline = pipeline;
+}
+
+void NullCommandList::SetRootConstants(uint32_t slot, const uint32_t* values, uint32_t count)
+{
+    RHICommand& command = Record(RHICommandType::SetRootConstants);
+    command.args[0] = slot;
+    command.args[1] = count;
+    for (uint32_t i = 0; i < count && i < MAX_RECORDED_ROOT_CONSTANTS; ++i)
+        command.args[2 + i] = values[i];
+    if (boundPipeline == RHI_NULL_PIPELINE)
+        Error("SetRootConstants: no pipeline bound");
+}
+
+void NullCommandList::SetDescriptorTable(uint32_t slot, uint32_t firstDescriptor)
+{
+    RHICommand& command = Record(RHICommandType::SetDescriptorTable);
+    command.args[0] = slot;
+    command.args[1] = firstDescriptor;
+    if (boundPipeline == RHI_NULL_PIPELINE)
+        Error("SetDescriptorTable: no pipeline bound");
+    if (!heapBound)
+        Error("SetDescriptorTable: descriptor heap not bound");
+}
+
+void NullCommandList::SetRootShaderResource(uint32_t slot, RHIResourceId buffer)
+{
+    RHICommand& command = Record(RHICommandType::SetRootShaderResource);
+    command.resources[0] = buffer;
+    command.args[0] = slot;
+    if (boundPipeline == RHI_NULL_PIPELINE)
+        Error("SetRootShaderResource: no pipeline bound");
+    RequireState(buffer, RGState::ShaderResource, "SetRootShaderResource");
+}
+
+void NullCommandList::SetRootUnorderedAccess(uint32_t slot, RHIResourceId buffer)
+{
+    RHICommand& command = Record(RHICommandType::SetRootUnorderedAccess);
+    command.resources[0] = buffer;
+    command.args[0] = slot;
+    if (boundPipeline == RHI_NULL_PIPELINE)
+        Error("SetRootUnorderedAccess: no pipeline bound");
+    RequireState(buffer, RGState::UnorderedAccess, "SetRootUnorderedAccess");
+}
+
+void NullCommandList::SetVertexBuffer(RHIResourceId buffer, uint32_t stride, uint32_t size)
+{
+    RHICommand& command = Record(RHICommandType::SetVertexBuffer);
+    command.resources[0] = buffer;
+    command.args[0] = stride;
+    command.args[1] = size;
+    if (Require(buffer, "SetVertexBuffer"))
+        boundVertexBuffer = buffer;
+}
+
+void NullCommandList::SetIndexBuffer(RHIResourceId buffer, uint32_t size, bool use32BitIndices)
+{
+    RHICommand& command = Record(RHICommandType::SetIndexBuffer);
+    command.resources[0] = buffer;
+    command.args[0] = size;
+    command.args[1] = use32BitIndices ? 32 : 16;
+    if (Require(buffer, "SetIndexBuffer"))
+        boundIndexBuffer = buffer;
+}
+
+void NullCommandList::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance)
+{
+    RHICommand& command = Record(RHICommandType::DrawIndexed);
+    command.args[0] = indexCount;
+    command.args[1] = instanceCount;
+    command.args[2] = firstIndex;
+    command.args[3] = uint64_t(int64_t(baseVertex));
+    command.args[4] = firstInstance;
+    ValidateDrawState("DrawIndexed");
+}
+
+void NullCommandList::DrawIndexedIndirect(RHIResourceId argsBuffer, uint64_t argsOffset, uint32_t maxCount, RHIResourceId countBuffer, uint64_t countOffset)
+{
+    RHICommand& command = Record(RHICommandType::DrawIndexedIndirect);
+    command.resources[0] = argsBuffer;
+    command.resources[1] = countBuffer;
+    command.args[0] = argsOffset;
+    command.args[1] = maxCount;
+    command.args[2] = countOffset;
+    ValidateDrawState("DrawIndexedIndirect");
+    RequireState(argsBuffer, RGState::IndirectArgument, "DrawIndexedIndirect");
+    RequireState(countBuffer, RGState::IndirectArgument, "DrawIndexedIndirect");
+}
+
+void NullCommandList::Dispatch(uint32_t x, uint32_t y, uint32_t z)
+{
+    RHICommand& command = Record(RHICommandType::Dispatch);
+    command.args[0] = x;
+    command.args[1] = y;
+    command.args[2] = z;
+    if (boundPipeline == RHI_NULL_PIPELINE)
+        Error("Dispatch: no pipeline bound");
+}
+
+void NullCommandList::CopyBuffer(RHIResourceId dst, uint64_t dstOffset, RHIResourceId src, uint64_t srcOffset, uint64_t size)
+{
+    RHICommand& command = Record(RHICommandType::CopyBuffer);
+    command.resources[0] = dst;
+    command.resources[1] = src;
+    command.args[0] = dstOffset;
+    command.args[1] = srcOffset;
+    command.args[2] = size;
+    RequireState(dst, RGState::CopyDest, "CopyBuffer");
+    RequireState(src, RGState::CopySource, "CopyBuffer");
+}
+
+void NullCommandList::CopyTexture(RHIResourceId dst, RHIResourceId src)
+{
+    RHICommand& command = Record(RHICommandType::CopyTexture);
+    command.resources[0] = dst;
+    command.resources[1] = src;
+    RequireState(dst, RGState::CopyDest, "CopyTexture");
+    RequireState(src, RGState::CopySource, "CopyTexture");
+}
+
+void NullCommandList::WriteDescriptor(uint32_t index, RHIResourceId resource, RHIDescriptorType type)
+{
+    RHICommand& command = Record(RHICommandType::WriteDescriptor);
+    command.resources[0] = resource;
+    command.args[0] = index;
+    command.args[1] = static_cast<uint64_t>(type);
+    Require(resource, "WriteDescriptor");
+}
+
+RHICommand& NullCommandList::Record(RHICommandType type)
+{
+    commands.emplace_back();
+    commands.back().type = type;
+    return commands.back();
+}
+
+void NullCommandList::ValidateDrawState(const char* command)
+{
+    const std::string name = command;
+    if (boundPipeline == RHI_NULL_PIPELINE)
+        Error(name + ": no pipeline bound");
+    if (boundVertexBuffer == RHI_NULL_RESOURCE || boundIndexBuffer == RHI_NULL_RESOURCE)
+        Error(name + ": vertex or index buffer not bound");
+    if (boundColorCount == 0 && boundDepth == RHI_NULL_RESOURCE)
+        Error(name + ": no render targets bound");
+
+    // Targets may have been transitioned away since they were bound
+    for (uint32_t i = 0; i < boundColorCount; ++i)
+        RequireState(boundColors[i], RGState::RenderTarget, command);
+    if (boundDepth != RHI_NULL_RESOURCE && (GetState(boundDepth) & (RGState::DepthWrite | RGState::DepthRead)) == RGState::Undefined)
+        Error(name + ": depth target " + NameOf(boundDepth) + " is not in a depth state");
+}
+
+void NullCommandList::Error(const std::string& message)
+{
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "[%zu] ", commands.empty() ? size_t(0) : commands.size() - 1);
+    errors.push_back(prefix + message);
+}
+
+bool NullCommandList::Require(RHIResourceId id, const char* command)
+{
+    if (IsRegistered(id))
+        return true;
+    Error(std::string(command) + ": unknown resource " + NameOf(id));
+    return false;
+}
+
+bool NullCommandList::RequireState(RHIResourceId id, RGState state, const char* command)
+{
+    if (!Require(id, command))
+        return false;
+    RGState current = GetState(id);
+    if ((current & state) == state)
+        return true;
+    Error(std::string(command) + ": " + NameOf(id) + " is in " + StateToString(current) + ", not " + StateToString(state));
+    return false;
+}
+
+std::string NullCommandList::NameOf(RHIResourceId id) const
+{
+    auto it = resources.find(id);
+    if (it != resources.end())
+        return it->second.name;
+    char name[32];
+    snprintf(name, sizeof(name), "#%llx", (unsigned long long)id);
+    return name;
+}
+
+std::string NullCommandList::PipelineNameOf(RHIPipelineId id) const
+{
+    auto it = pipelines.find(id);
+    if (it != pipelines.end())
+        return it->second;
+    char name[32];
+    snprintf(name, sizeof(name), "#%llx", (unsigned long long)id);
+    return name;
+}
+
+IRHICommandList* NullSecondaryLists::BeginSecondary(uint32_t index)
+{
+    if (!primary || index >= MAX_SECONDARY_LISTS)
+        return nullptr;
+    NullCommandList& list = secondaries[index];
+    list.Reset();
+    list.InheritResources(*primary);
+    return &list;
+}
+
+void NullSecondaryLists::SubmitSecondaries(uint32_t count)
+{
+    assert(primary && count <= MAX_SECONDARY_LISTS && "Bad secondary submission");
+    for (uint32_t i = 0; i < count; ++i)
+        primary->Append(secondaries[i]);
+    submittedCount += count;
+}
+
+void NullRenderGraphBackend::Destroy()
+{
+    if (cmdList)
+        for (const Physical& physical : cache)
+            cmdList->UnregisterResource(physical.id);
+    cache.clear();
+    bindings.clear();
+    cmdList = nullptr;
+}
+
+void NullRenderGraphBackend::GetAllocationInfo(const RGTextureDesc& desc, uint64_t& outSize, uint64_t& outAlignment) const
+{
+    // Same estimate the graph uses without a backend: tightly packed, 64KB aligned
+    const uint64_t alignment = 64 * 1024;
+    outSize = (uint64_t(desc.width) * desc.height * desc.bytesPerPixel + alignment - 1) & ~(alignment - 1);
+    outAlignment = alignment;
+}
+
+bool NullRenderGraphBackend::RealizeTransients(const RenderGraph& graph)
+{
+    assert(cmdList && "BeginFrame before executing the graph");
+
+    for (Physical& physical : cache)
+        physical.usedThisFrame = false;
+    bindings.assign(graph.GetResourceCount(), -1);
+
+    for (uint32_t i = 0; i < graph.GetResourceCount(); ++i) {
+        if (!graph.IsTransientLive(i))
+            continue;
+        for (size_t slot = 0; slot < cache.size(); ++slot) {
+            Physical& physical = cache[slot];
+            if (!physical.usedThisFrame && physical.offset == graph.GetTransientOffset(i) && physical.desc == graph.GetDesc(i)) {
+                physical.usedThisFrame = true;
+                bindings[i] = static_cast<int>(slot);
+                break;
+            }
+        }
+    }
+
+    std::vector<int> remap(cache.size(), -1);
+    size_t kept = 0;
+    for (size_t slot = 0; slot < cache.size(); ++slot) {
+        if (!cache[slot].usedThisFrame) {
+            cmdList->UnregisterResource(cache[slot].id);
+            continue;
+        }
+        remap[slot] = static_cast<int>(kept);
+        if (kept != slot)
+            cache[kept] = cache[slot];
+        ++kept;
+    }
+    cache.resize(kept);
+    for (int& binding : bindings)
+        if (binding >= 0)
+            binding = remap[binding];
+
+    for (uint32_t i = 0; i < graph.GetResourceCount(); ++i) {
+        if (!graph.IsTransientLive(i) || bindings[i] >= 0)
+            continue;
+
+        // Created in the state its first use expects, like the D3D12 placed resources
+        Physical physical;
+        physical.id = nextId++;
+        physical.desc = graph.GetDesc(i);
+        physical.offset = graph.GetTransientOffset(i);
+        physical.usedThisFrame = true;
+        cmdList->RegisterResource(physical.id, graph.GetResourceName(i), physical.desc.isDepth ? RGState::DepthWrite : RGState::RenderTarget);
+        cache.push_back(physical);
+        bindings[i] = static_cast<int>(cache.size() - 1);
+        ++createdCount;
+    }
+    return true;
+}
+
+void NullRenderGraphBackend::SubmitBarriers(const RenderGraph& graph, const RGBarrier* barriers, size_t count)
+{
+    scratch.clear();
+    for (size_t i = 0; i < count; ++i) {
+        const RGBarrier& barrier = barriers[i];
+        RHIBarrier rhiBarrier;
+        rhiBarrier.resource = GetResourceId(graph, { barrier.resource });
+
+        switch (barrier.type) {
+        case RGBarrierType::Transition:
+            rhiBarrier.type = RHIBarrierType::Transition;
+            rhiBarrier.before = barrier.before == RGState::Undefined ? cmdList->GetState(rhiBarrier.resource) : barrier.before;
+            rhiBarrier.after = barrier.after;
+            if (rhiBarrier.before == rhiBarrier.after)
+                continue;
+            break;
+        case RGBarrierType::Aliasing:
+            rhiBarrier.type = RHIBarrierType::Aliasing;
+            rhiBarrier.aliasBefore = barrier.aliasBefore != ~0u ? GetResourceId(graph, { barrier.aliasBefore }) : RHI_NULL_RESOURCE;
+            break;
+        case RGBarrierType::UAV:
+            rhiBarrier.type = RHIBarrierType::UAV;
+            break;
+        }
+        scratch.push_back(rhiBarrier);
+    }
+
+    if (!scratch.empty())
+        cmdList->Barriers(scratch.data(), static_cast<uint32_t>(scratch.size()));
+}
+
+uint64_t NullRenderGraphBackend::GetResourceId(const RenderGraph& graph, RGResourceHandle handle) const
+{
+    if (graph.IsImported(handle.index))
+        return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(graph.GetExternal(handle.index)));
+    if (handle.index >= bindings.size() || bindings[handle.index] < 0)
+        return RHI_NULL_RESOURCE;
+    return cache[bindings[handle.index]].id;
+}
+
+RHIPipelineId NullPipelineCompiler::Compile(const std::string&, const PipelineStateDesc& desc, uint64_t)
+{
+    ++compileCount;
+    if (desc.compute ? desc.cs.empty() : desc.vs.empty())
+        return RHI_NULL_PIPELINE;
+    ++liveCount;
+    return nextId++;
+}
+
+void NullPipelineCompiler::Release(RHIPipelineId pipeline)
+{
+    if (pipeline != RHI_NULL_PIPELINE)
+        --liveCount;
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "RHI.h"
+#include "RenderGraph.h"
+#include "PipelineCache.h"
+
+// Headless backend. NullCommandList records every command into an inspectable
+// stream and checks it against tracked resource states, so frame code can run
+// (and be diffed against golden streams) without a window or GPU.
+
+enum class RHICommandType : uint8_t {
+    Barrier = 0,
+    SetRenderTargets,
+    ClearRenderTarget,
+    ClearDepth,
+    SetViewport,
+    SetScissor,
+    SetDescriptorHeap,
+    SetPipeline,
+    SetRootConstants,
+    SetDescriptorTable,
+    SetRootShaderResource,
+    SetRootUnorderedAccess,
+    SetVertexBuffer,
+    SetIndexBuffer,
+    DrawIndexed,
+    Dispatch,
+    DrawIndexedIndirect,
+    CopyBuffer,
+    CopyTexture,
+    WriteDescriptor,
+    Count
+};
+
+const char* ToString(RHICommandType type);
+
+// Arguments are stored in the order of the IRHICommandList call.
+struct RHICommand {
+    RHICommandType type = RHICommandType::Barrier;
+    RHIBarrier barrier;                             // Barrier only
+    RHIResourceId resources[4] = {};
+    uint64_t args[6] = {};
+    float values[6] = {};
+};
+
+class NullCommandList : public IRHICommandList {
+public:
+    static constexpr uint32_t MAX_RENDER_TARGETS = 8;
+    static constexpr uint32_t MAX_RECORDED_ROOT_CONSTANTS = 4;
+
+    // Resources must be registered before any command refers to them.
+    void RegisterResource(RHIResourceId id, const std::string& name, RGState initialState);
+    void UnregisterResource(RHIResourceId id);
+    bool IsRegistered(RHIResourceId id) const { return resources.find(id) != resources.end(); }
+    RGState GetState(RHIResourceId id) const;
+    void RegisterPipeline(RHIPipelineId id, const std::string& name) { pipelines[id] = name; }
+
+    // Starts a new command stream. Resource states carry over, like on a GPU.
+    void Reset();
+
+    // Copies resource names, states and pipelines from 'other', e.g. when a
+    // secondary list starts recording on a worker.
+    void InheritResources(const NullCommandList& other);
+    // Appends the commands and errors of 'other' as if recorded here, and takes
+    // over the resource states it ended with.
+    void Append(const NullCommandList& other);
+
+    const std::vector<RHICommand>& GetCommands() const { return commands; }
+    const std::vector<std::string>& GetErrors() const { return errors; }
+    size_t Count(RHICommandType type) const;
+
+    // One line per command with resource names instead of ids; stable across runs.
+    std::string Serialize() const;
+
+    void Barriers(const RHIBarrier* barriers, uint32_t count) override;
+
+    void SetRenderTargets(const RHIResourceId* colors, uint32_t colorCount, RHIResourceId depth) override;
+    void ClearRenderTarget(RHIResourceId target, const float color[4]) override;
+    void ClearDepth(RHIResourceId target, float depth) override;
+    void SetViewport(const RHIViewport& viewport) override;
+    void SetScissor(const RHIRect& rect) override;
+
+    void SetDescriptorHeap() override;
+    void SetPipeline(RHIPipelineId pipeline) override;
+    void SetRootConstants(uint32_t slot, const uint32_t* values, uint32_t count) override;
+    void SetDescriptorTable(uint32_t slot, uint32_t firstDescriptor) override;
+    void SetRootShaderResource(uint32_t slot, RHIResourceId buffer) override;
+    void SetRootUnorderedAccess(uint32_t slot, RHIResourceId buffer) override;
+
+    void SetVertexBuffer(RHIResourceId buffer, uint32_t stride, uint32_t size) override;
+    void SetIndexBuffer(RHIResourceId buffer, uint32_t size, bool use32BitIndices) override;
+    void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance) override;
+    void Dispatch(uint32_t x, uint32_t y, uint32_t z) override;
+    void DrawIndexedIndirect(RHIResourceId argsBuffer, uint64_t argsOffset, uint32_t maxCount, RHIResourceId countBuffer, uint64_t countOffset) override;
+
+    void CopyBuffer(RHIResourceId dst, uint64_t dstOffset, RHIResourceId src, uint64_t srcOffset, uint64_t size) override;
+    void CopyTexture(RHIResourceId dst, RHIResourceId src) override;
+
+    void WriteDescriptor(uint32_t index, RHIResourceId resource, RHIDescriptorType type) override;
+
+private:
+    struct TrackedResource {
+        std::string name;
+        RGState state = RGState::Undefined;
+    };
+
+    RHICommand& Record(RHICommandType type);
+    void ValidateDrawState(const char* command);
+    void Error(const std::string& message);
+    bool Require(RHIResourceId id, const char* command);
+    bool RequireState(RHIResourceId id, RGState state, const char* command);
+    std::string NameOf(RHIResourceId id) const;
+    std::string PipelineNameOf(RHIPipelineId id) const;
+
+    std::unordered_map<RHIResourceId, TrackedResource> resources;
+    std::unordered_map<RHIPipelineId, std::string> pipelines;
+    std::vector<RHICommand> commands;
+    std::vector<std::string> errors;
+
+    // Bound state, cleared by Reset
+    RHIResourceId boundColors[MAX_RENDER_TARGETS] = {};
+    uint32_t boundColorCount = 0;
+    RHIResourceId boundDepth = RHI_NULL_RESOURCE;
+    RHIPipelineId boundPipeline = RHI_NULL_PIPELINE;
+    RHIResourceId boundVertexBuffer = RHI_NULL_RESOURCE;
+    RHIResourceId boundIndexBuffer = RHI_NULL_RESOURCE;
+    bool heapBound = false;
+};
+
+// Secondary lists for NullCommandList. Each secondary starts from the primary's
+// resource states; SubmitSecondaries appends them to the primary in index
+// order, so the primary holds the frame's stream in submission order.
+class NullSecondaryLists : public IRHISecondaryLists {
+public:
+    static constexpr uint32_t MAX_SECONDARY_LISTS = 16;
+
+    void BeginFrame(NullCommandList* primary) { this->primary = primary; }
+
+    uint32_t GetMaxSecondaryLists() const override { return MAX_SECONDARY_LISTS; }
+    IRHICommandList* BeginSecondary(uint32_t index) override;
+    void SubmitSecondaries(uint32_t count) override;
+
+    uint64_t GetSubmittedCount() const { return submittedCount; }
+
+private:
+    NullCommandList* primary = nullptr;
+    NullCommandList secondaries[MAX_SECONDARY_LISTS];
+    uint64_t submittedCount = 0;
+};
+
+// Render graph backend for NullCommandList. Transients get fake ids that stay
+// the same while their desc and heap offset do, mirroring the D3D12 placed
+// resource cache; imported resources use their external pointer as the id.
+class NullRenderGraphBackend : public IRenderGraphBackend {
+public:
+    void BeginFrame(NullCommandList* cmdList) { this->cmdList = cmdList; }
+    void Destroy();
+
+    void GetAllocationInfo(const RGTextureDesc& desc, uint64_t& outSize, uint64_t& outAlignment) const override;
+    bool RealizeTransients(const RenderGraph& graph) override;
+    void SubmitBarriers(const RenderGraph& graph, const RGBarrier* barriers, size_t count) override;
+    uint64_t GetResourceId(const RenderGraph& graph, RGResourceHandle handle) const override;
+
+    // Ids created so far; grows only when a transient could not be reused.
+    uint64_t GetCreatedCount() const { return createdCount; }
+
+private:
+    struct Physical {
+        RHIResourceId id = RHI_NULL_RESOURCE;
+        RGTextureDesc desc;
+        uint64_t offset = 0;
+        bool usedThisFrame = false;
+    };
+
+    // Fake ids live in the top half of the id space, away from any real pointer
+    static constexpr RHIResourceId FIRST_TRANSIENT_ID = 1ull << 63;
+
+    NullCommandList* cmdList = nullptr;
+    std::vector<Physical> cache;
+    std::vector<int> bindings;  // graph resource index -> cache slot, -1 if none
+    std::vector<RHIBarrier> scratch;
+    RHIResourceId nextId = FIRST_TRANSIENT_ID;
+    uint64_t createdCount = 0;
+};
+
+// Pipeline compiler for the pipeline cache. Hands out fake ids and fails any
+// description without shaders, like a device rejecting an incomplete PSO.
+class NullPipelineCompiler : public IPipelineCompiler {
+public:
+    RHIPipelineId Compile(const std::string& name, const PipelineStateDesc& desc, uint64_t hash) override;
+    void Release(RHIPipelineId pipeline) override;
+
+    uint32_t GetCompileCount() const { return compileCount.load(); }
+    uint32_t GetLiveCount() const { return liveCount.load(); }
+
+private:
+    // Below the transient ids, above any id HeadlessRenderer assigns by hand
+    static constexpr RHIPipelineId FIRST_PIPELINE_ID = 1ull << 62;
+
+    std::atomic<RHIPipelineId> nextId{ FIRST_PIPELINE_ID };
+    std::atomic<uint32_t> compileCount{ 0 };
+    std::atomic<uint32_t> liveCount{ 0 };
+};
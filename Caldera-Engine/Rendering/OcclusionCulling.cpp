@@ -0,0 +1,259 @@
+#include "OcclusionCulling.h"
+#include "FrustumCulling.h"
+#include "../Core/TaskPool.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+// Vertices closer to the camera plane than this are treated as crossing it
+static constexpr float NEAR_W = 1e-5f;
+// Twice the screen area, in pixels, below which a triangle covers nothing useful
+static constexpr float MIN_DOUBLE_AREA = 1e-6f;
+
+void OcclusionCuller::Initialize(TaskPool* taskPool, uint32_t bufferWidth, uint32_t bufferHeight)
+{
+    assert(bufferWidth % TILE_WIDTH == 0 && bufferHeight % TILE_HEIGHT == 0 && "Occlusion buffer must be whole tiles");
+    pool = taskPool;
+    width = bufferWidth;
+    height = bufferHeight;
+    tilesX = width / TILE_WIDTH;
+    tilesY = height / TILE_HEIGHT;
+    depth.assign(size_t(width) * height, 1.0f);
+    tileBins.assign(size_t(tilesX) * tilesY, {});
+    pyramid = HiZPyramid();
+}
+
+void OcclusionCuller::Begin(const float matrix[16])
+{
+    std::memcpy(viewProjection, matrix, sizeof(viewProjection));
+    triangles.clear();
+    for (std::vector<uint32_t>& bin : tileBins)
+        bin.clear();
+    std::fill(depth.begin(), depth.end(), 1.0f);
+    pyramid = HiZPyramid();
+    stats = OcclusionStats();
+}
+
+void OcclusionCuller::AddOccluder(const Occluder& occluder)
+{
+    // Object to clip space in one matrix: viewProjection * world, world extended to 4x4
+    const float* w = occluder.world;
+    float m[16];
+    for (int r = 0; r < 4; ++r) {
+        const float* v = viewProjection + r * 4;
+        for (int c = 0; c < 4; ++c)
+            m[r * 4 + c] = v[0] * w[c] + v[1] * w[4 + c] + v[2] * w[8 + c] + (c == 3 ? v[3] : 0.0f);
+    }
+
+    clipPositions.resize(size_t(occluder.vertexCount) * 4);
+    const uint8_t* vertex = reinterpret_cast<const uint8_t*>(occluder.positions);
+    for (uint32_t i = 0; i < occluder.vertexCount; ++i, vertex += occluder.positionStride) {
+        const float* p = reinterpret_cast<const float*>(vertex);
+        float* clip = &clipPositions[size_t(i) * 4];
+        for (int r = 0; r < 4; ++r)
+            clip[r] = m[r * 4 + 0] * p[0] + m[r * 4 + 1] * p[1] + m[r * 4 + 2] * p[2] + m[r * 4 + 3];
+    }
+
+    const float halfWidth = width * 0.5f;
+    const float halfHeight = height * 0.5f;
+    for (uint32_t i = 0; i + 2 < occluder.indexCount; i += 3) {
+        ++stats.occluderTriangles;
+        float x[3], y[3], z[3];
+        bool behind = false;
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t index = occluder.indices[i + k];
+            assert(index < occluder.vertexCount && "Occluder index out of range");
+            const float* clip = &clipPositions[size_t(index) * 4];
+            if (clip[3] <= NEAR_W) {
+                behind = true;
+                break;
+            }
+            const float invW = 1.0f / clip[3];
+            x[k] = (clip[0] * invW + 1.0f) * halfWidth;
+            y[k] = (1.0f - clip[1] * invW) * halfHeight;
+            z[k] = clip[2] * invW;
+        }
+        if (behind)
+            continue;
+
+        // Pixels whose centers lie inside the triangle's bounding rectangle
+        Triangle tri;
+        tri.minX = std::max(0, static_cast<int32_t>(std::ceil(std::min({ x[0], x[1], x[2] }) - 0.5f)));
+        tri.minY = std::max(0, static_cast<int32_t>(std::ceil(std::min({ y[0], y[1], y[2] }) - 0.5f)));
+        tri.maxX = std::min(static_cast<int32_t>(width) - 1, static_cast<int32_t>(std::floor(std::max({ x[0], x[1], x[2] }) - 0.5f)));
+        tri.maxY = std::min(static_cast<int32_t>(height) - 1, static_cast<int32_t>(std::floor(std::max({ y[0], y[1], y[2] }) - 0.5f)));
+        if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+            continue;
+
+        const float dx1 = x[1] - x[0], dy1 = y[1] - y[0], dz1 = z[1] - z[0];
+        const float dx2 = x[2] - x[0], dy2 = y[2] - y[0], dz2 = z[2] - z[0];
+        const float doubleArea = dx1 * dy2 - dx2 * dy1;
+        if (std::fabs(doubleArea) < MIN_DOUBLE_AREA)
+            continue;
+
+        // Edge k runs from vertex k to the next; E(p) = A*px + B*py + C is twice the
+        // signed area of (vk, vk+1, p), flipped so the inside is positive
+        const float orientation = doubleArea > 0.0f ? 1.0f : -1.0f;
+        for (int k = 0; k < 3; ++k) {
+            const int n = (k + 1) % 3;
+            tri.edgeA[k] = (y[k] - y[n]) * orientation;
+            tri.edgeB[k] = (x[n] - x[k]) * orientation;
+            tri.edgeC[k] = (x[k] * y[n] - y[k] * x[n]) * orientation;
+        }
+        // Depth after the perspective divide is affine in screen space
+        tri.depthA = (dz1 * dy2 - dz2 * dy1) / doubleArea;
+        tri.depthB = (dx1 * dz2 - dx2 * dz1) / doubleArea;
+        tri.depthC = z[0] - tri.depthA * x[0] - tri.depthB * y[0];
+
+        const uint32_t triangleIndex = static_cast<uint32_t>(triangles.size());
+        triangles.push_back(tri);
+        ++stats.rasterizedTriangles;
+        for (int32_t ty = tri.minY / TILE_HEIGHT; ty <= tri.maxY / static_cast<int32_t>(TILE_HEIGHT); ++ty) {
+            for (int32_t tx = tri.minX / TILE_WIDTH; tx <= tri.maxX / static_cast<int32_t>(TILE_WIDTH); ++tx) {
+                tileBins[size_t(ty) * tilesX + tx].push_back(triangleIndex);
+                ++stats.binnedTriangles;
+            }
+        }
+    }
+}
+
+void OcclusionCuller::RasterizeTile(uint32_t tile)
+{
+    const int32_t tileX0 = static_cast<int32_t>((tile % tilesX) * TILE_WIDTH);
+    const int32_t tileY0 = static_cast<int32_t>((tile / tilesX) * TILE_HEIGHT);
+    const int32_t tileX1 = tileX0 + TILE_WIDTH - 1;
+    const int32_t tileY1 = tileY0 + TILE_HEIGHT - 1;
+    const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (uint32_t triangleIndex : tileBins[tile]) {
+        const Triangle& tri = triangles[triangleIndex];
+        // Blocks of 4 start on 4-aligned columns; lanes outside the triangle fail the edge tests
+        const int32_t startX = std::max(tileX0, tri.minX) & ~3;
+        const int32_t endX = std::min(tileX1, tri.maxX);
+        const int32_t startY = std::max(tileY0, tri.minY);
+        const int32_t endY = std::min(tileY1, tri.maxY);
+
+        const __m128 a0 = _mm_set1_ps(tri.edgeA[0]), a1 = _mm_set1_ps(tri.edgeA[1]), a2 = _mm_set1_ps(tri.edgeA[2]);
+        const __m128 depthA = _mm_set1_ps(tri.depthA);
+        const __m128 firstX = _mm_add_ps(_mm_set1_ps(static_cast<float>(startX)), laneOffsets);
+        for (int32_t y = startY; y <= endY; ++y) {
+            const float py = y + 0.5f;
+            const __m128 rowE0 = _mm_set1_ps(tri.edgeB[0] * py + tri.edgeC[0]);
+            const __m128 rowE1 = _mm_set1_ps(tri.edgeB[1] * py + tri.edgeC[1]);
+            const __m128 rowE2 = _mm_set1_ps(tri.edgeB[2] * py + tri.edgeC[2]);
+            const __m128 rowDepth = _mm_set1_ps(tri.depthB * py + tri.depthC);
+            float* row = &depth[size_t(y) * width];
+
+            __m128 px = firstX;
+            for (int32_t x = startX; x <= endX; x += 4, px = _mm_add_ps(px, _mm_set1_ps(4.0f))) {
+                const __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), rowE0);
+                const __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), rowE1);
+                const __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), rowE2);
+                const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                if (_mm_movemask_ps(inside) == 0)
+                    continue;
+                const __m128 z = _mm_add_ps(_mm_mul_ps(depthA, px), rowDepth);
+                const __m128 old = _mm_loadu_ps(row + x);
+                const __m128 nearest = _mm_min_ps(old, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+            }
+        }
+    }
+}
+
+void OcclusionCuller::Rasterize()
+{
+    // Tiles own disjoint pixels, so they need no synchronization
+    const uint32_t tileCount = tilesX * tilesY;
+    if (pool && stats.rasterizedTriangles > 0)
+        pool->ParallelFor(tileCount, [this](uint32_t tile) { RasterizeTile(tile); });
+    else
+        for (uint32_t tile = 0; tile < tileCount; ++tile)
+            RasterizeTile(tile);
+    BuildHiZPyramid(depth.data(), width, height, pyramid);
+}
+
+bool OcclusionCuller::IsBoxVisible(const float center[3], const float extents[3]) const
+{
+    if (pyramid.GetMipCount() == 0)
+        return true;
+
+    // Corners in clip space as the projected center plus or minus each projected half axis
+    const float* m = viewProjection;
+    float c[4], axes[3][4];
+    for (int r = 0; r < 4; ++r) {
+        c[r] = m[r * 4 + 0] * center[0] + m[r * 4 + 1] * center[1] + m[r * 4 + 2] * center[2] + m[r * 4 + 3];
+        for (int a = 0; a < 3; ++a)
+            axes[a][r] = m[r * 4 + a] * extents[a];
+    }
+
+    float minU = 1.0f, minV = 1.0f, maxU = 0.0f, maxV = 0.0f;
+    float minZ = 1.0f;
+    for (int corner = 0; corner < 8; ++corner) {
+        float clip[4];
+        for (int r = 0; r < 4; ++r) {
+            clip[r] = c[r] + ((corner & 1) ? axes[0][r] : -axes[0][r])
+                           + ((corner & 2) ? axes[1][r] : -axes[1][r])
+                           + ((corner & 4) ? axes[2][r] : -axes[2][r]);
+        }
+        if (clip[3] <= NEAR_W)
+            return true;    // crosses the camera plane, can't be bounded on screen
+
+        const float invW = 1.0f / clip[3];
+        const float u = clip[0] * invW * 0.5f + 0.5f;
+        const float v = clip[1] * invW * -0.5f + 0.5f;
+        minU = std::min(minU, u);
+        maxU = std::max(maxU, u);
+        minV = std::min(minV, v);
+        maxV = std::max(maxV, v);
+        minZ = std::min(minZ, clip[2] * invW);
+    }
+    if (maxU < 0.0f || minU > 1.0f || maxV < 0.0f || minV > 1.0f)
+        return true;        // off screen; frustum culling decides
+    return IsScreenRectVisibleHiZ(pyramid, minU, minV, maxU, maxV, minZ);
+}
+
+uint32_t OcclusionCuller::CullBoxes(const CullingBounds& bounds, const uint32_t* indices, uint32_t count, uint32_t* outVisible)
+{
+    stats.testedBoxes = count;
+    if (!HasOccluders()) {
+        if (outVisible != indices)
+            std::memmove(outVisible, indices, count * sizeof(uint32_t));
+        stats.occludedBoxes = 0;
+        return count;
+    }
+
+    // Each task keeps its survivors at the start of its own range, then the ranges are packed
+    const uint32_t taskCount = (count + BOXES_PER_TASK - 1) / BOXES_PER_TASK;
+    taskCounts.assign(taskCount, 0);
+    auto cullTask = [&](uint32_t task) {
+        const uint32_t begin = task * BOXES_PER_TASK;
+        const uint32_t end = std::min(count, begin + BOXES_PER_TASK);
+        uint32_t visible = 0;
+        for (uint32_t i = begin; i < end; ++i) {
+            const uint32_t index = indices[i];
+            const float center[3] = { bounds.GetCenterX()[index], bounds.GetCenterY()[index], bounds.GetCenterZ()[index] };
+            const float extents[3] = { bounds.GetExtentX()[index], bounds.GetExtentY()[index], bounds.GetExtentZ()[index] };
+            if (IsBoxVisible(center, extents))
+                outVisible[begin + visible++] = index;
+        }
+        taskCounts[task] = visible;
+    };
+    if (pool && taskCount > 1)
+        pool->ParallelFor(taskCount, cullTask);
+    else
+        for (uint32_t task = 0; task < taskCount; ++task)
+            cullTask(task);
+
+    uint32_t visible = 0;
+    for (uint32_t task = 0; task < taskCount; ++task) {
+        if (visible != task * BOXES_PER_TASK)
+            std::memmove(outVisible + visible, outVisible + size_t(task) * BOXES_PER_TASK, taskCounts[task] * sizeof(uint32_t));
+        visible += taskCounts[task];
+    }
+    stats.occludedBoxes = count - visible;
+    return visible;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "GpuCulling.h"
+#include <cstdint>
+#include <vector>
+
+class TaskPool;
+class CullingBounds;
+
+// Software occlusion culling. A few large occluders are rasterized on the CPU
+// into a small depth buffer that keeps the nearest depth per pixel; triangles
+// are set up and binned once, then each screen tile is filled by its own task
+// with SSE edge functions, 4 pixels at a time. The buffer is reduced to a max
+// Hi-Z pyramid (BuildHiZPyramid) and occludee boxes are tested against it the
+// same way the GPU culling shader tests spheres.
+//
+// Conventions match GpuCulling: row-major, clip = viewProjection * float4(p, 1),
+// depth 0 at the near plane. Only triangles fully in front of the camera are
+// drawn, so clipped occluders occlude less, never more.
+
+// Triangle mesh drawn into the depth buffer. Positions and indices are the
+// caller's and must stay valid until Rasterize returns.
+struct Occluder {
+    const float* positions = nullptr;  // xyz at the start of each vertex
+    uint32_t positionStride = 12;      // bytes between vertices
+    uint32_t vertexCount = 0;
+    const uint32_t* indices = nullptr;
+    uint32_t indexCount = 0;
+    float world[12] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0 };  // row-major 3x4
+};
+
+struct OcclusionStats {
+    uint32_t occluderTriangles = 0;   // submitted since Begin
+    uint32_t rasterizedTriangles = 0; // left after near-plane, degenerate and off-screen rejection
+    uint32_t binnedTriangles = 0;     // triangle/tile pairs
+    uint32_t testedBoxes = 0;
+    uint32_t occludedBoxes = 0;
+};
+
+class OcclusionCuller {
+public:
+    // Small enough to fill in well under a millisecond; powers of two keep every
+    // pyramid texel an exact 2x2 of the level below.
+    static constexpr uint32_t DEFAULT_WIDTH = 256;
+    static constexpr uint32_t DEFAULT_HEIGHT = 128;
+    // Tile width is a multiple of 4 so SSE blocks never straddle two tiles.
+    static constexpr uint32_t TILE_WIDTH = 64;
+    static constexpr uint32_t TILE_HEIGHT = 32;
+    static constexpr uint32_t BOXES_PER_TASK = 4096;
+
+    // 'pool' may be null to work on the calling thread. Sizes must be multiples of the tile size.
+    void Initialize(TaskPool* pool, uint32_t width = DEFAULT_WIDTH, uint32_t height = DEFAULT_HEIGHT);
+
+    // Starts a frame: drops last frame's occluders and clears the depth to far.
+    void Begin(const float viewProjection[16]);
+    // Transforms, sets up and bins the occluder's triangles. Both windings are drawn.
+    void AddOccluder(const Occluder& occluder);
+    // Fills the depth buffer tile by tile and builds the pyramid the tests read.
+    void Rasterize();
+    bool HasOccluders() const { return stats.rasterizedTriangles > 0; }
+
+    // True unless the world-space box is certainly hidden behind the occluders.
+    bool IsBoxVisible(const float center[3], const float extents[3]) const;
+    // Keeps the visible ones of 'indices' (into 'bounds'), in order, and returns
+    // their count. 'outVisible' may be 'indices' itself.
+    uint32_t CullBoxes(const CullingBounds& bounds, const uint32_t* indices, uint32_t count, uint32_t* outVisible);
+
+    uint32_t GetWidth() const { return width; }
+    uint32_t GetHeight() const { return height; }
+    // Nearest occluder depth per pixel, 1 where nothing was drawn. Row-major, top row first.
+    const float* GetDepth() const { return depth.data(); }
+    const HiZPyramid& GetPyramid() const { return pyramid; }
+    const OcclusionStats& GetStats() const { return stats; }
+
+private:
+    // Edge functions oriented so inside is >= 0 for either winding, plus the
+    // screen-space depth plane and the pixel rectangle the triangle covers
+    struct Triangle {
+        float edgeA[3], edgeB[3], edgeC[3];
+        float depthA, depthB, depthC;
+        int32_t minX, minY, maxX, maxY;
+    };
+
+    void RasterizeTile(uint32_t tile);
+
+    TaskPool* pool = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t tilesX = 0;
+    uint32_t tilesY = 0;
+    float viewProjection[16] = {};
+
+    std::vector<float> depth;
+    std::vector<Triangle> triangles;
+    std::vector<std::vector<uint32_t>> tileBins;  // triangle indices per tile
+    std::vector<float> clipPositions;             // scratch, xyzw per vertex of one occluder
+    HiZPyramid pyramid;
+    std::vector<uint32_t> taskCounts;
+    OcclusionStats stats;
+};
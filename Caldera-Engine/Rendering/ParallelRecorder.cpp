@@ -0,0 +1,55 @@
+#include "ParallelRecorder.h"
+#include "../Core/TaskPool.h"
+#include <algorithm>
+#include <cassert>
+
+uint32_t PartitionDraws(uint32_t drawCount, uint32_t maxChunks, uint32_t minPerChunk, DrawRange* outRanges)
+{
+    if (drawCount == 0 || maxChunks == 0)
+        return 0;
+
+    uint32_t chunks = std::min(maxChunks, std::max(1u, drawCount / std::max(1u, minPerChunk)));
+    uint32_t base = drawCount / chunks;
+    uint32_t remainder = drawCount % chunks;
+
+    uint32_t first = 0;
+    for (uint32_t i = 0; i < chunks; ++i) {
+        uint32_t count = base + (i < remainder ? 1 : 0);
+        outRanges[i] = { first, count };
+        first += count;
+    }
+    return chunks;
+}
+
+void ParallelRecorder::Initialize(TaskPool* pool, IRHISecondaryLists* lists, uint32_t minDrawsPerList)
+{
+    this->pool = pool;
+    this->lists = lists;
+    this->minDrawsPerList = minDrawsPerList;
+}
+
+uint32_t ParallelRecorder::Record(IRHICommandList& primary, uint32_t drawCount, const RecordFn& record)
+{
+    uint32_t maxChunks = 1;
+    if (pool && lists)
+        maxChunks = std::min(pool->GetThreadCount(), lists->GetMaxSecondaryLists());
+
+    ranges.resize(std::max(1u, maxChunks));
+    lastListCount = PartitionDraws(drawCount, maxChunks, minDrawsPerList, ranges.data());
+    if (lastListCount <= 1) {
+        // Not worth a list of its own; also keeps the single-threaded stream unchanged
+        if (drawCount > 0)
+            record(primary, { 0, drawCount }, false);
+        lastListCount = drawCount > 0 ? 1 : 0;
+        return lastListCount;
+    }
+
+    pool->ParallelFor(lastListCount, [&](uint32_t chunk) {
+        IRHICommandList* list = lists->BeginSecondary(chunk);
+        assert(list && "Secondary command list unavailable");
+        if (list)
+            record(*list, ranges[chunk], true);
+    });
+    lists->SubmitSecondaries(lastListCount);
+    return lastListCount;
+}
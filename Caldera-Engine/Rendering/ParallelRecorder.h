@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "RHI.h"
+
+class TaskPool;
+
+struct DrawRange {
+    uint32_t first = 0;
+    uint32_t count = 0;
+};
+
+// Splits [0, drawCount) into at most 'maxChunks' contiguous ranges of at least
+// 'minPerChunk' draws each (a single range if there are fewer), in draw order
+// and differing in size by at most one. Returns the number of ranges written.
+uint32_t PartitionDraws(uint32_t drawCount, uint32_t maxChunks, uint32_t minPerChunk, DrawRange* outRanges);
+
+// Records a pass's draws in parallel. Draws are partitioned across the task
+// pool, each range records into its own secondary list, and the secondaries
+// are submitted in range order, so the GPU sees the same order as a serial
+// recording. Small batches are recorded straight into the primary list.
+class ParallelRecorder {
+public:
+    static constexpr uint32_t DEFAULT_MIN_DRAWS_PER_LIST = 128;
+
+    // 'secondary' is true when 'list' is a fresh secondary with nothing bound.
+    using RecordFn = std::function<void(IRHICommandList& list, DrawRange range, bool secondary)>;
+
+    void Initialize(TaskPool* pool, IRHISecondaryLists* lists, uint32_t minDrawsPerList = DEFAULT_MIN_DRAWS_PER_LIST);
+
+    // Returns the number of lists the draws were recorded into.
+    uint32_t Record(IRHICommandList& primary, uint32_t drawCount, const RecordFn& record);
+
+    uint32_t GetLastListCount() const { return lastListCount; }
+
+private:
+    TaskPool* pool = nullptr;
+    IRHISecondaryLists* lists = nullptr;
+    uint32_t minDrawsPerList = DEFAULT_MIN_DRAWS_PER_LIST;
+    uint32_t lastListCount = 0;
+    std::vector<DrawRange> ranges;
+};
@@ -0,0 +1,420 @@
+#include "PipelineCache.h"
+#include "../Core/JobSystem.h"
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+static constexpr uint32_t PIPELINE_LIST_MAGIC = 0x4c535043; // "CPSL"
+static constexpr uint32_t PIPELINE_LIST_VERSION = 1;
+// Guards against allocating from a corrupt length field
+static constexpr uint32_t MAX_SERIALIZED_ARRAY = 64 * 1024 * 1024;
+
+// Fixed-width little-endian fields, so the byte form is the same on every build
+static void WriteU32(std::vector<uint8_t>& out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+static void WriteU64(std::vector<uint8_t>& out, uint64_t value)
+{
+    WriteU32(out, static_cast<uint32_t>(value));
+    WriteU32(out, static_cast<uint32_t>(value >> 32));
+}
+
+static void WriteBytes(std::vector<uint8_t>& out, const void* data, size_t size)
+{
+    WriteU32(out, static_cast<uint32_t>(size));
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+static bool ReadU32(const uint8_t*& cursor, const uint8_t* end, uint32_t& value)
+{
+    if (end - cursor < 4)
+        return false;
+    value = 0;
+    for (int i = 0; i < 4; ++i)
+        value |= uint32_t(cursor[i]) << (i * 8);
+    cursor += 4;
+    return true;
+}
+
+static bool ReadU64(const uint8_t*& cursor, const uint8_t* end, uint64_t& value)
+{
+    uint32_t low, high;
+    if (!ReadU32(cursor, end, low) || !ReadU32(cursor, end, high))
+        return false;
+    value = uint64_t(low) | (uint64_t(high) << 32);
+    return true;
+}
+
+static bool ReadBool(const uint8_t*& cursor, const uint8_t* end, bool& value)
+{
+    uint32_t raw;
+    if (!ReadU32(cursor, end, raw) || raw > 1)
+        return false;
+    value = raw != 0;
+    return true;
+}
+
+static bool ReadBytes(const uint8_t*& cursor, const uint8_t* end, std::vector<uint8_t>& out)
+{
+    uint32_t size;
+    if (!ReadU32(cursor, end, size) || size > MAX_SERIALIZED_ARRAY || uint64_t(end - cursor) < size)
+        return false;
+    out.assign(cursor, cursor + size);
+    cursor += size;
+    return true;
+}
+
+static bool ReadString(const uint8_t*& cursor, const uint8_t* end, std::string& out)
+{
+    uint32_t size;
+    if (!ReadU32(cursor, end, size) || size > MAX_SERIALIZED_ARRAY || uint64_t(end - cursor) < size)
+        return false;
+    out.assign(reinterpret_cast<const char*>(cursor), size);
+    cursor += size;
+    return true;
+}
+
+void SerializePipelineDesc(const PipelineStateDesc& desc, std::vector<uint8_t>& out)
+{
+    WriteU32(out, desc.compute);
+    WriteU64(out, desc.rootSignature);
+    WriteBytes(out, desc.vs.data(), desc.vs.size());
+    WriteBytes(out, desc.ps.data(), desc.ps.size());
+    WriteBytes(out, desc.cs.data(), desc.cs.size());
+
+    WriteU32(out, static_cast<uint32_t>(desc.inputLayout.size()));
+    for (const PipelineInputElement& element : desc.inputLayout) {
+        WriteBytes(out, element.semantic.data(), element.semantic.size());
+        WriteU32(out, element.semanticIndex);
+        WriteU32(out, element.format);
+        WriteU32(out, element.slot);
+        WriteU32(out, element.offset);
+        WriteU32(out, element.perInstance);
+    }
+
+    WriteU32(out, desc.fillMode);
+    WriteU32(out, desc.cullMode);
+    WriteU32(out, desc.frontCounterClockwise);
+    WriteU32(out, static_cast<uint32_t>(desc.depthBias));
+    WriteU32(out, desc.depthClip);
+
+    WriteU32(out, desc.blendEnable);
+    WriteU32(out, desc.srcBlend);
+    WriteU32(out, desc.destBlend);
+    WriteU32(out, desc.blendOp);
+    WriteU32(out, desc.srcBlendAlpha);
+    WriteU32(out, desc.destBlendAlpha);
+    WriteU32(out, desc.blendOpAlpha);
+    WriteU32(out, desc.writeMask);
+
+    WriteU32(out, desc.depthEnable);
+    WriteU32(out, desc.depthWrite);
+    WriteU32(out, desc.depthFunc);
+
+    WriteU32(out, desc.topology);
+    WriteU32(out, desc.renderTargetCount);
+    for (uint32_t format : desc.renderTargetFormats)
+        WriteU32(out, format);
+    WriteU32(out, desc.depthFormat);
+    WriteU32(out, desc.sampleCount);
+}
+
+bool DeserializePipelineDesc(const uint8_t*& cursor, const uint8_t* end, PipelineStateDesc& out)
+{
+    out = PipelineStateDesc();
+    uint32_t elementCount = 0;
+    uint32_t depthBias = 0;
+    if (!ReadBool(cursor, end, out.compute) ||
+        !ReadU64(cursor, end, out.rootSignature) ||
+        !ReadBytes(cursor, end, out.vs) ||
+        !ReadBytes(cursor, end, out.ps) ||
+        !ReadBytes(cursor, end, out.cs) ||
+        !ReadU32(cursor, end, elementCount) || elementCount > MAX_SERIALIZED_ARRAY)
+        return false;
+
+    out.inputLayout.resize(elementCount);
+    for (PipelineInputElement& element : out.inputLayout) {
+        if (!ReadString(cursor, end, element.semantic) ||
+            !ReadU32(cursor, end, element.semanticIndex) ||
+            !ReadU32(cursor, end, element.format) ||
+            !ReadU32(cursor, end, element.slot) ||
+            !ReadU32(cursor, end, element.offset) ||
+            !ReadBool(cursor, end, element.perInstance))
+            return false;
+    }
+
+    if (!ReadU32(cursor, end, out.fillMode) ||
+        !ReadU32(cursor, end, out.cullMode) ||
+        !ReadBool(cursor, end, out.frontCounterClockwise) ||
+        !ReadU32(cursor, end, depthBias) ||
+        !ReadBool(cursor, end, out.depthClip) ||
+        !ReadBool(cursor, end, out.blendEnable) ||
+        !ReadU32(cursor, end, out.srcBlend) ||
+        !ReadU32(cursor, end, out.destBlend) ||
+        !ReadU32(cursor, end, out.blendOp) ||
+        !ReadU32(cursor, end, out.srcBlendAlpha) ||
+        !ReadU32(cursor, end, out.destBlendAlpha) ||
+        !ReadU32(cursor, end, out.blendOpAlpha) ||
+        !ReadU32(cursor, end, out.writeMask) ||
+        !ReadBool(cursor, end, out.depthEnable) ||
+        !ReadBool(cursor, end, out.depthWrite) ||
+        !ReadU32(cursor, end, out.depthFunc) ||
+        !ReadU32(cursor, end, out.topology) ||
+        !ReadU32(cursor, end, out.renderTargetCount) || out.renderTargetCount > PIPELINE_MAX_RENDER_TARGETS)
+        return false;
+    out.depthBias = static_cast<int32_t>(depthBias);
+
+    for (uint32_t& format : out.renderTargetFormats)
+        if (!ReadU32(cursor, end, format))
+            return false;
+    return ReadU32(cursor, end, out.depthFormat) && ReadU32(cursor, end, out.sampleCount);
+}
+
+uint64_t HashPipelineDesc(const PipelineStateDesc& desc)
+{
+    std::vector<uint8_t> bytes;
+    SerializePipelineDesc(desc, bytes);
+    return HashBytes(bytes.data(), bytes.size());
+}
+
+bool SavePipelineList(const std::string& path, const std::vector<RecordedPipeline>& pipelines)
+{
+    std::vector<uint8_t> bytes;
+    WriteU32(bytes, PIPELINE_LIST_MAGIC);
+    WriteU32(bytes, PIPELINE_LIST_VERSION);
+    WriteU32(bytes, static_cast<uint32_t>(pipelines.size()));
+    for (const RecordedPipeline& pipeline : pipelines) {
+        WriteBytes(bytes, pipeline.name.data(), pipeline.name.size());
+        SerializePipelineDesc(pipeline.desc, bytes);
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return file.good();
+}
+
+bool LoadPipelineList(const std::string& path, std::vector<RecordedPipeline>& outPipelines)
+{
+    outPipelines.clear();
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    const uint8_t* cursor = bytes.data();
+    const uint8_t* end = cursor + bytes.size();
+    uint32_t magic, version, count;
+    if (!ReadU32(cursor, end, magic) || magic != PIPELINE_LIST_MAGIC ||
+        !ReadU32(cursor, end, version) || version != PIPELINE_LIST_VERSION ||
+        !ReadU32(cursor, end, count))
+        return false;
+
+    // All or nothing: a list cut short by a crash is ignored rather than half-used
+    std::vector<RecordedPipeline> pipelines;
+    for (uint32_t i = 0; i < count; ++i) {
+        RecordedPipeline pipeline;
+        if (!ReadString(cursor, end, pipeline.name) || !DeserializePipelineDesc(cursor, end, pipeline.desc))
+            return false;
+        pipelines.push_back(std::move(pipeline));
+    }
+    outPipelines = std::move(pipelines);
+    return true;
+}
+
+bool PipelineCache::Initialize(IPipelineCompiler* compiler, JobSystem* jobSystem)
+{
+    assert(compiler && "Pipeline cache needs a compiler");
+    assert(!this->compiler && "PipelineCache already initialized");
+    this->compiler = compiler;
+    this->jobSystem = jobSystem;
+    draining = false;
+    return true;
+}
+
+void PipelineCache::Shutdown()
+{
+    if (!compiler)
+        return;
+
+    {
+        // Compiles that have not started are dropped; the job stops after the one in flight
+        std::unique_lock<std::mutex> lock(mutex);
+        queue.clear();
+        compiled.wait(lock, [&] { return !draining; });
+    }
+
+    for (const std::unique_ptr<Entry>& entry : entries)
+        if (entry->pipeline != RHI_NULL_PIPELINE)
+            compiler->Release(entry->pipeline);
+    entries.clear();
+    lookup.clear();
+    queue.clear();
+    stats = PipelineCacheStats();
+    compiler = nullptr;
+}
+
+PipelineHandle PipelineCache::Request(const std::string& name, const PipelineStateDesc& desc)
+{
+    const uint64_t hash = HashPipelineDesc(desc);
+    std::unique_lock<std::mutex> lock(mutex);
+    ++stats.requests;
+    return Enqueue(name, desc, hash, false, lock);
+}
+
+PipelineHandle PipelineCache::Enqueue(const std::string& name, const PipelineStateDesc& desc, uint64_t hash, bool warmup, std::unique_lock<std::mutex>& lock)
+{
+    auto found = lookup.find(hash);
+    if (found != lookup.end()) {
+        Entry& entry = *entries[found->second];
+        if (!warmup)
+            ++stats.deduplicated;
+        // A failed compile may have been missing something it has now, e.g. a root signature
+        if (entry.status == PipelineStatus::Failed && !warmup) {
+            const uint32_t index = found->second;
+            entry.status = PipelineStatus::Pending;
+            queue.push_back(index);
+            Schedule(index, lock);
+            return { index };
+        }
+        return { found->second };
+    }
+
+    std::unique_ptr<Entry> entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->desc = desc;
+    entry->hash = hash;
+    const uint32_t index = static_cast<uint32_t>(entries.size());
+    entries.push_back(std::move(entry));
+    lookup[hash] = index;
+    if (warmup)
+        ++stats.warmedUp;
+
+    queue.push_back(index);
+    Schedule(index, lock);
+    return { index };
+}
+
+void PipelineCache::CompileEntry(uint32_t index, std::unique_lock<std::mutex>& lock)
+{
+    // Callers pushed 'index'; take it off the queue so the order stays FIFO for the rest
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+        if (*it == index) {
+            queue.erase(it);
+            break;
+        }
+    }
+
+    // Entries are heap allocated, so this stays valid while the lock is released
+    Entry* entry = entries[index].get();
+    ++compiling;
+    lock.unlock();
+    RHIPipelineId pipeline = compiler->Compile(entry->name, entry->desc, entry->hash);
+    lock.lock();
+    --compiling;
+
+    entry->pipeline = pipeline;
+    entry->status = pipeline != RHI_NULL_PIPELINE ? PipelineStatus::Ready : PipelineStatus::Failed;
+    if (pipeline != RHI_NULL_PIPELINE)
+        ++stats.compiled;
+    else
+        ++stats.failed;
+    compiled.notify_all();
+}
+
+void PipelineCache::Schedule(uint32_t index, std::unique_lock<std::mutex>& lock)
+{
+    if (!jobSystem) {
+        CompileEntry(index, lock);
+        return;
+    }
+    if (draining)
+        return;
+    draining = true;
+    // Unlocked, as creating a job may run other jobs while the job pool is exhausted
+    lock.unlock();
+    jobSystem->Run([this] { DrainQueue(); }, JobPriority::Background, "PipelineCache compile");
+    lock.lock();
+}
+
+void PipelineCache::DrainQueue()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!queue.empty())
+        CompileEntry(queue.front(), lock);
+    draining = false;
+    compiled.notify_all();
+}
+
+PipelineStatus PipelineCache::GetStatus(PipelineHandle handle) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    assert(handle.index < entries.size() && "Invalid pipeline handle");
+    return entries[handle.index]->status;
+}
+
+RHIPipelineId PipelineCache::Get(PipelineHandle handle) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    assert(handle.index < entries.size() && "Invalid pipeline handle");
+    const Entry& entry = *entries[handle.index];
+    return entry.status == PipelineStatus::Ready ? entry.pipeline : RHI_NULL_PIPELINE;
+}
+
+RHIPipelineId PipelineCache::Wait(PipelineHandle handle)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    assert(handle.index < entries.size() && "Invalid pipeline handle");
+    const Entry& entry = *entries[handle.index];
+    compiled.wait(lock, [&] { return entry.status != PipelineStatus::Pending; });
+    return entry.status == PipelineStatus::Ready ? entry.pipeline : RHI_NULL_PIPELINE;
+}
+
+void PipelineCache::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    compiled.wait(lock, [&] { return queue.empty() && compiling == 0; });
+}
+
+bool PipelineCache::SaveRecordedList(const std::string& path) const
+{
+    std::vector<RecordedPipeline> pipelines;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pipelines.reserve(entries.size());
+        for (const std::unique_ptr<Entry>& entry : entries)
+            if (entry->status != PipelineStatus::Failed)
+                pipelines.push_back({ entry->name, entry->desc });
+    }
+    return SavePipelineList(path, pipelines);
+}
+
+uint32_t PipelineCache::Warmup(const std::string& path)
+{
+    std::vector<RecordedPipeline> pipelines;
+    if (!LoadPipelineList(path, pipelines))
+        return 0;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    const uint32_t before = stats.warmedUp;
+    for (const RecordedPipeline& pipeline : pipelines)
+        Enqueue(pipeline.name, pipeline.desc, HashPipelineDesc(pipeline.desc), true, lock);
+    return stats.warmedUp - before;
+}
+
+uint32_t PipelineCache::GetPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<uint32_t>(queue.size()) + compiling;
+}
+
+PipelineCacheStats PipelineCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
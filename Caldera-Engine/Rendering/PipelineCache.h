@@ -0,0 +1,168 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "RHI.h"
+#include "../Core/Hash.h"
+
+// Pipeline state objects keyed by a hash of their full description. Requests
+// for a description already known share one pipeline; new ones compile in a
+// Background job while the caller keeps rendering without them. Every
+// distinct pipeline is recorded so the next launch can warm them all up front.
+
+class JobSystem;
+
+constexpr uint32_t PIPELINE_MAX_RENDER_TARGETS = 8;
+
+struct PipelineInputElement {
+    std::string semantic;
+    uint32_t semanticIndex = 0;
+    uint32_t format = 0;
+    uint32_t slot = 0;
+    uint32_t offset = 0;
+    bool perInstance = false;
+};
+
+// Backend-neutral pipeline description. Enum and format fields hold the
+// backend's own values (D3D12/DXGI); defaults match the D3D12 default states.
+struct PipelineStateDesc {
+    bool compute = false;
+    uint64_t rootSignature = 0;  // id registered with the compiler
+    std::vector<uint8_t> vs;
+    std::vector<uint8_t> ps;
+    std::vector<uint8_t> cs;
+    std::vector<PipelineInputElement> inputLayout;
+
+    uint32_t fillMode = 3;       // solid
+    uint32_t cullMode = 3;       // back
+    bool frontCounterClockwise = false;
+    int32_t depthBias = 0;
+    bool depthClip = true;
+
+    // Applies to every render target
+    bool blendEnable = false;
+    uint32_t srcBlend = 2;       // one
+    uint32_t destBlend = 1;      // zero
+    uint32_t blendOp = 1;        // add
+    uint32_t srcBlendAlpha = 2;
+    uint32_t destBlendAlpha = 1;
+    uint32_t blendOpAlpha = 1;
+    uint32_t writeMask = 0xF;
+
+    bool depthEnable = true;
+    bool depthWrite = true;
+    uint32_t depthFunc = 2;      // less
+
+    uint32_t topology = 3;       // triangle
+    uint32_t renderTargetCount = 0;
+    uint32_t renderTargetFormats[PIPELINE_MAX_RENDER_TARGETS] = {};
+    uint32_t depthFormat = 0;
+    uint32_t sampleCount = 1;
+};
+
+// Canonical byte form of a description; equal descriptions serialize identically.
+void SerializePipelineDesc(const PipelineStateDesc& desc, std::vector<uint8_t>& out);
+// Reads one description at 'cursor' and advances it. False on truncated or corrupt data.
+bool DeserializePipelineDesc(const uint8_t*& cursor, const uint8_t* end, PipelineStateDesc& out);
+// Hash of the canonical form, used as the cache key and the pipeline library name.
+uint64_t HashPipelineDesc(const PipelineStateDesc& desc);
+
+struct RecordedPipeline {
+    std::string name;
+    PipelineStateDesc desc;
+};
+
+bool SavePipelineList(const std::string& path, const std::vector<RecordedPipeline>& pipelines);
+bool LoadPipelineList(const std::string& path, std::vector<RecordedPipeline>& outPipelines);
+
+// Turns descriptions into backend pipelines. Compile runs in the cache's
+// Background job, one pipeline at a time.
+class IPipelineCompiler {
+public:
+    virtual ~IPipelineCompiler() = default;
+
+    // Returns RHI_NULL_PIPELINE on failure.
+    virtual RHIPipelineId Compile(const std::string& name, const PipelineStateDesc& desc, uint64_t hash) = 0;
+    virtual void Release(RHIPipelineId pipeline) = 0;
+};
+
+enum class PipelineStatus : uint8_t {
+    Pending = 0,
+    Ready,
+    Failed
+};
+
+struct PipelineHandle {
+    uint32_t index = ~0u;
+    bool IsValid() const { return index != ~0u; }
+};
+
+struct PipelineCacheStats {
+    uint32_t requests = 0;
+    uint32_t deduplicated = 0;  // requests answered by an existing entry
+    uint32_t compiled = 0;
+    uint32_t failed = 0;
+    uint32_t warmedUp = 0;      // entries queued from a recorded list
+};
+
+class PipelineCache {
+public:
+    ~PipelineCache() { Shutdown(); }
+
+    // Without a job system, Request compiles before returning. 'jobSystem' must
+    // outlive the cache's Shutdown.
+    bool Initialize(IPipelineCompiler* compiler, JobSystem* jobSystem = nullptr);
+    // Drops compiles that have not started, finishes the one in flight and releases every pipeline.
+    void Shutdown();
+
+    // Failed entries are queued again when requested again.
+    PipelineHandle Request(const std::string& name, const PipelineStateDesc& desc);
+    PipelineStatus GetStatus(PipelineHandle handle) const;
+    // Null while the pipeline is pending or failed.
+    RHIPipelineId Get(PipelineHandle handle) const;
+    // Blocks until the pipeline is compiled or failed.
+    RHIPipelineId Wait(PipelineHandle handle);
+    void WaitIdle();
+
+    // Every distinct pipeline requested or warmed up so far that has not failed, in first request order.
+    bool SaveRecordedList(const std::string& path) const;
+    // Queues every pipeline of a recorded list. Returns how many were new.
+    uint32_t Warmup(const std::string& path);
+
+    uint32_t GetPendingCount() const;
+    PipelineCacheStats GetStats() const;
+
+private:
+    struct Entry {
+        std::string name;
+        PipelineStateDesc desc;
+        uint64_t hash = 0;
+        RHIPipelineId pipeline = RHI_NULL_PIPELINE;
+        PipelineStatus status = PipelineStatus::Pending;
+    };
+
+    PipelineHandle Enqueue(const std::string& name, const PipelineStateDesc& desc, uint64_t hash, bool warmup, std::unique_lock<std::mutex>& lock);
+    void CompileEntry(uint32_t index, std::unique_lock<std::mutex>& lock);
+    // Compiles the queue in a job unless one already is, or right here without a job system
+    void Schedule(uint32_t index, std::unique_lock<std::mutex>& lock);
+    // Body of the compile job: compiles queued entries until there are none
+    void DrainQueue();
+
+    IPipelineCompiler* compiler = nullptr;
+    JobSystem* jobSystem = nullptr;
+    mutable std::mutex mutex;
+    std::condition_variable compiled;
+    bool draining = false;  // a compile job is queued or running
+    uint32_t compiling = 0;
+
+    std::vector<std::unique_ptr<Entry>> entries;
+    std::unordered_map<uint64_t, uint32_t> lookup;  // hash -> entry index
+    std::deque<uint32_t> queue;
+    PipelineCacheStats stats;
+};
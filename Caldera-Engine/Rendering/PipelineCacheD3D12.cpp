@@ -0,0 +1,212 @@
+#include "PipelineCacheD3D12.h"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+
+uint64_t D3D12PipelineCompiler::GetRootSignatureId(ID3DBlob* serializedRootSignature)
+{
+    return HashBytes(serializedRootSignature->GetBufferPointer(), serializedRootSignature->GetBufferSize());
+}
+
+bool D3D12PipelineCompiler::Create(ID3D12Device* device, const std::string& libraryPath)
+{
+    assert(device && "Device is null");
+    this->device = device;
+    this->libraryPath = libraryPath;
+    libraryDirty = false;
+    libraryHits = 0;
+
+    ComPtr<ID3D12Device1> device1;
+    if (FAILED(device->QueryInterface(IID_PPV_ARGS(&device1))))
+        return true;
+
+    std::ifstream file(libraryPath, std::ios::binary);
+    if (file)
+        libraryData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    // A library from another driver or adapter is rejected; start an empty one instead
+    if (libraryData.empty() || FAILED(device1->CreatePipelineLibrary(libraryData.data(), libraryData.size(), IID_PPV_ARGS(&library)))) {
+        libraryData.clear();
+        if (FAILED(device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&library))))
+            library.Reset();
+        libraryDirty = true;
+    }
+    return true;
+}
+
+void D3D12PipelineCompiler::Destroy()
+{
+    SaveLibrary();
+    std::lock_guard<std::mutex> lock(mutex);
+    pipelines.clear();
+    rootSignatures.clear();
+    library.Reset();
+    libraryData.clear();
+    device.Reset();
+}
+
+bool D3D12PipelineCompiler::SaveLibrary()
+{
+    std::vector<uint8_t> bytes;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!library || !libraryDirty)
+            return true;
+        bytes.resize(library->GetSerializedSize());
+        if (FAILED(library->Serialize(bytes.data(), bytes.size())))
+            return false;
+        libraryDirty = false;
+    }
+
+    std::ofstream file(libraryPath, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return file.good();
+}
+
+void D3D12PipelineCompiler::RegisterRootSignature(uint64_t id, ComPtr<ID3D12RootSignature> rootSignature)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    rootSignatures[id] = std::move(rootSignature);
+}
+
+RHIPipelineId D3D12PipelineCompiler::Compile(const std::string& name, const PipelineStateDesc& desc, uint64_t hash)
+{
+    ComPtr<ID3D12RootSignature> rootSignature;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = rootSignatures.find(desc.rootSignature);
+        if (found != rootSignatures.end())
+            rootSignature = found->second;
+    }
+    if (!rootSignature) {
+        OutputDebugStringA(("Pipeline '" + name + "' uses an unregistered root signature\n").c_str());
+        return RHI_NULL_PIPELINE;
+    }
+
+    // The library looks pipelines up by name, so the name is the description hash
+    wchar_t libraryName[32];
+    swprintf(libraryName, _countof(libraryName), L"pso_%016llx", static_cast<unsigned long long>(hash));
+
+    std::unique_ptr<D3D12Pipeline> pipeline = std::make_unique<D3D12Pipeline>();
+    pipeline->rootSignature = rootSignature;
+    pipeline->compute = desc.compute;
+    pipeline->pipelineState = desc.compute
+        ? CompileCompute(desc, rootSignature.Get(), libraryName)
+        : CompileGraphics(desc, rootSignature.Get(), libraryName);
+    if (!pipeline->pipelineState) {
+        OutputDebugStringA(("Failed to create pipeline '" + name + "'\n").c_str());
+        return RHI_NULL_PIPELINE;
+    }
+
+    RHIPipelineId id = D3D12CommandList::ToId(pipeline.get());
+    std::lock_guard<std::mutex> lock(mutex);
+    pipelines[id] = std::move(pipeline);
+    return id;
+}
+
+void D3D12PipelineCompiler::Release(RHIPipelineId pipeline)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    pipelines.erase(pipeline);
+}
+
+ComPtr<ID3D12PipelineState> D3D12PipelineCompiler::CompileGraphics(const PipelineStateDesc& desc, ID3D12RootSignature* rootSignature, const std::wstring& libraryName)
+{
+    std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements(desc.inputLayout.size());
+    for (size_t i = 0; i < desc.inputLayout.size(); ++i) {
+        const PipelineInputElement& element = desc.inputLayout[i];
+        inputElements[i].SemanticName = element.semantic.c_str();
+        inputElements[i].SemanticIndex = element.semanticIndex;
+        inputElements[i].Format = static_cast<DXGI_FORMAT>(element.format);
+        inputElements[i].InputSlot = element.slot;
+        inputElements[i].AlignedByteOffset = element.offset;
+        inputElements[i].InputSlotClass = element.perInstance ? D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA : D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+        inputElements[i].InstanceDataStepRate = element.perInstance ? 1 : 0;
+    }
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+    psoDesc.pRootSignature = rootSignature;
+    psoDesc.VS = { desc.vs.data(), desc.vs.size() };
+    psoDesc.PS = { desc.ps.data(), desc.ps.size() };
+    psoDesc.InputLayout = { inputElements.data(), static_cast<UINT>(inputElements.size()) };
+
+    psoDesc.RasterizerState.FillMode = static_cast<D3D12_FILL_MODE>(desc.fillMode);
+    psoDesc.RasterizerState.CullMode = static_cast<D3D12_CULL_MODE>(desc.cullMode);
+    psoDesc.RasterizerState.FrontCounterClockwise = desc.frontCounterClockwise;
+    psoDesc.RasterizerState.DepthBias = desc.depthBias;
+    psoDesc.RasterizerState.DepthBiasClamp = D3D12_DEFAULT_DEPTH_BIAS_CLAMP;
+    psoDesc.RasterizerState.SlopeScaledDepthBias = D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS;
+    psoDesc.RasterizerState.DepthClipEnable = desc.depthClip;
+    psoDesc.RasterizerState.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+
+    for (D3D12_RENDER_TARGET_BLEND_DESC& target : psoDesc.BlendState.RenderTarget) {
+        target.BlendEnable = desc.blendEnable;
+        target.SrcBlend = static_cast<D3D12_BLEND>(desc.srcBlend);
+        target.DestBlend = static_cast<D3D12_BLEND>(desc.destBlend);
+        target.BlendOp = static_cast<D3D12_BLEND_OP>(desc.blendOp);
+        target.SrcBlendAlpha = static_cast<D3D12_BLEND>(desc.srcBlendAlpha);
+        target.DestBlendAlpha = static_cast<D3D12_BLEND>(desc.destBlendAlpha);
+        target.BlendOpAlpha = static_cast<D3D12_BLEND_OP>(desc.blendOpAlpha);
+        target.LogicOp = D3D12_LOGIC_OP_NOOP;
+        target.RenderTargetWriteMask = static_cast<UINT8>(desc.writeMask);
+    }
+
+    psoDesc.DepthStencilState.DepthEnable = desc.depthEnable;
+    psoDesc.DepthStencilState.DepthWriteMask = desc.depthWrite ? D3D12_DEPTH_WRITE_MASK_ALL : D3D12_DEPTH_WRITE_MASK_ZERO;
+    psoDesc.DepthStencilState.DepthFunc = static_cast<D3D12_COMPARISON_FUNC>(desc.depthFunc);
+
+    psoDesc.SampleMask = UINT_MAX;
+    psoDesc.PrimitiveTopologyType = static_cast<D3D12_PRIMITIVE_TOPOLOGY_TYPE>(desc.topology);
+    psoDesc.NumRenderTargets = desc.renderTargetCount;
+    for (uint32_t i = 0; i < desc.renderTargetCount; ++i)
+        psoDesc.RTVFormats[i] = static_cast<DXGI_FORMAT>(desc.renderTargetFormats[i]);
+    psoDesc.DSVFormat = static_cast<DXGI_FORMAT>(desc.depthFormat);
+    psoDesc.SampleDesc.Count = desc.sampleCount;
+
+    ComPtr<ID3D12PipelineState> pipelineState;
+    if (library) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (SUCCEEDED(library->LoadGraphicsPipeline(libraryName.c_str(), &psoDesc, IID_PPV_ARGS(&pipelineState)))) {
+            ++libraryHits;
+            return pipelineState;
+        }
+    }
+
+    if (FAILED(device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pipelineState))))
+        return nullptr;
+
+    if (library) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (SUCCEEDED(library->StorePipeline(libraryName.c_str(), pipelineState.Get())))
+            libraryDirty = true;
+    }
+    return pipelineState;
+}
+
+ComPtr<ID3D12PipelineState> D3D12PipelineCompiler::CompileCompute(const PipelineStateDesc& desc, ID3D12RootSignature* rootSignature, const std::wstring& libraryName)
+{
+    D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+    psoDesc.pRootSignature = rootSignature;
+    psoDesc.CS = { desc.cs.data(), desc.cs.size() };
+
+    ComPtr<ID3D12PipelineState> pipelineState;
+    if (library) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (SUCCEEDED(library->LoadComputePipeline(libraryName.c_str(), &psoDesc, IID_PPV_ARGS(&pipelineState)))) {
+            ++libraryHits;
+            return pipelineState;
+        }
+    }
+
+    if (FAILED(device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&pipelineState))))
+        return nullptr;
+
+    if (library) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (SUCCEEDED(library->StorePipeline(libraryName.c_str(), pipelineState.Get())))
+            libraryDirty = true;
+    }
+    return pipelineState;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "PipelineCache.h"
+#include "RHID3D12.h"
+
+using namespace Microsoft::WRL;
+
+// Compiles pipeline cache entries into D3D12Pipelines. Every PSO goes through an
+// ID3D12PipelineLibrary loaded from disk, so pipelines built on an earlier run
+// with the same driver skip compilation; new ones are stored and written back
+// by SaveLibrary. Works without a library when the device has no support for one.
+class D3D12PipelineCompiler : public IPipelineCompiler {
+public:
+    static const D3D12Pipeline* ToPipeline(RHIPipelineId id) { return reinterpret_cast<const D3D12Pipeline*>(id); }
+    // Stable id of a serialized root signature, for PipelineStateDesc::rootSignature.
+    static uint64_t GetRootSignatureId(ID3DBlob* serializedRootSignature);
+
+    bool Create(ID3D12Device* device, const std::string& libraryPath);
+    // Saves the library; the GPU must be done with every pipeline.
+    void Destroy();
+    bool SaveLibrary();
+
+    // Descriptions name root signatures by id; they must be registered before they compile.
+    void RegisterRootSignature(uint64_t id, ComPtr<ID3D12RootSignature> rootSignature);
+
+    RHIPipelineId Compile(const std::string& name, const PipelineStateDesc& desc, uint64_t hash) override;
+    void Release(RHIPipelineId pipeline) override;
+
+    uint32_t GetLibraryHits() const { return libraryHits; }
+
+private:
+    ComPtr<ID3D12PipelineState> CompileGraphics(const PipelineStateDesc& desc, ID3D12RootSignature* rootSignature, const std::wstring& libraryName);
+    ComPtr<ID3D12PipelineState> CompileCompute(const PipelineStateDesc& desc, ID3D12RootSignature* rootSignature, const std::wstring& libraryName);
+
+    ComPtr<ID3D12Device> device;
+    ComPtr<ID3D12PipelineLibrary> library;
+    std::vector<uint8_t> libraryData;  // the library reads from this for its whole lifetime
+    std::string libraryPath;
+    bool libraryDirty = false;
+    uint32_t libraryHits = 0;
+
+    std::mutex mutex;
+    std::unordered_map<uint64_t, ComPtr<ID3D12RootSignature>> rootSignatures;
+    std::unordered_map<RHIPipelineId, std::unique_ptr<D3D12Pipeline>> pipelines;
+};
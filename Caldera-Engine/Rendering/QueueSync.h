@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// Hardware queues the renderer submits to. Graphics maps to the DIRECT queue.
+enum class QueueType : uint8_t {
+    Graphics = 0,
+    Compute,
+    Copy,
+    Count
+};
+
+constexpr int NUM_QUEUE_TYPES = static_cast<int>(QueueType::Count);
+
+// A point on one queue's fence timeline. Everything submitted to 'queue' before
+// 'value' was signaled is finished once that queue's fence reaches 'value'.
+struct SyncPoint {
+    QueueType queue = QueueType::Graphics;
+    uint64_t value = 0;
+
+    bool IsValid() const { return value != 0; }
+};
+
+// Queue/fence backend. The D3D12 implementation maps each QueueType to a command
+// queue plus fence; SimulatedGpuTimeline runs the same contract on the CPU.
+class IGpuTimeline {
+public:
+    virtual ~IGpuTimeline() = default;
+
+    // Signals the next fence value on 'queue' after all work submitted so far.
+    virtual SyncPoint Signal(QueueType queue) = 0;
+    // Stalls 'waiter' on the GPU until 'point' is reached. Never blocks the CPU.
+    virtual void QueueWait(QueueType waiter, SyncPoint point) = 0;
+    virtual uint64_t GetCompletedValue(QueueType queue) const = 0;
+    // Blocks the calling thread until 'point' is reached.
+    virtual void CpuWait(SyncPoint point) = 0;
+};
+
+// Tracks cross-queue dependencies on top of an IGpuTimeline. Waits are recorded
+// with WaitOn and only issued (deduplicated) right before the waiting queue's
+// next submission, so many uploads feeding one frame cost a single GPU wait.
+class QueueScheduler {
+public:
+    void Initialize(IGpuTimeline* timeline);
+
+    // Call after ExecuteCommandLists on 'queue'. Returns the sync point of that work.
+    SyncPoint Submit(QueueType queue);
+
+    // Records that the next submission on 'waiter' depends on 'point'.
+    void WaitOn(QueueType waiter, SyncPoint point);
+
+    // Issues all pending waits for 'waiter'. Call right before submitting to it.
+    void FlushWaits(QueueType waiter);
+
+    bool IsComplete(SyncPoint point) const;
+    void CpuWait(SyncPoint point);
+    void WaitIdle();
+
+    SyncPoint GetLastSubmitted(QueueType queue) const { return lastSubmitted[Index(queue)]; }
+    uint64_t GetIssuedWaitCount() const { return issuedWaits; }
+    uint64_t GetSkippedWaitCount() const { return skippedWaits; }
+
+private:
+    static int Index(QueueType queue) { return static_cast<int>(queue); }
+
+    IGpuTimeline* timeline = nullptr;
+    SyncPoint lastSubmitted[NUM_QUEUE_TYPES];
+    // [waiter][source]: highest value already waited on / still to be waited on
+    uint64_t waited[NUM_QUEUE_TYPES][NUM_QUEUE_TYPES] = {};
+    uint64_t pending[NUM_QUEUE_TYPES][NUM_QUEUE_TYPES] = {};
+    uint64_t issuedWaits = 0;
+    uint64_t skippedWaits = 0;
+};
+
+// CPU model of independent GPU queues. Each queue executes its signals and waits
+// in submission order; Step/RunUntilIdle advance execution so tests can check
+// which work may overlap and that no dependency cycle deadlocks the queues.
+class SimulatedGpuTimeline : public IGpuTimeline {
+public:
+    SyncPoint Signal(QueueType queue) override;
+    void QueueWait(QueueType waiter, SyncPoint point) override;
+    uint64_t GetCompletedValue(QueueType queue) const override;
+    void CpuWait(SyncPoint point) override;
+
+    // Executes at most one pending operation on 'queue'. Returns false if the queue
+    // is idle or blocked on another queue.
+    bool Step(QueueType queue);
+    // Steps all queues until nothing can make progress. Returns true if all queues drained.
+    bool RunUntilIdle();
+
+    bool IsBlocked(QueueType queue) const;
+    size_t GetPendingCount(QueueType queue) const { return queues[static_cast<int>(queue)].ops.size(); }
+
+private:
+    struct Op {
+        bool isWait = false;
+        QueueType source = QueueType::Graphics;
+        uint64_t value = 0;
+    };
+
+    struct SimQueue {
+        std::deque<Op> ops;
+        uint64_t nextValue = 0;
+        uint64_t completed = 0;
+    };
+
+    SimQueue queues[NUM_QUEUE_TYPES];
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include "RenderGraph.h"
+
+// Render hardware interface. Frame and pass code records through IRHICommandList
+// so the same code runs on D3D12 (RHID3D12) and on the headless null backend
+// (NullRHI). Ids are opaque to callers; on D3D12 they hold the object pointer.
+using RHIResourceId = uint64_t;
+using RHIPipelineId = uint64_t;
+
+constexpr RHIResourceId RHI_NULL_RESOURCE = 0;
+constexpr RHIPipelineId RHI_NULL_PIPELINE = 0;
+
+struct RHIViewport {
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 0.0f;
+    float height = 0.0f;
+    float minDepth = 0.0f;
+    float maxDepth = 1.0f;
+};
+
+struct RHIRect {
+    int32_t left = 0;
+    int32_t top = 0;
+    int32_t right = 0;
+    int32_t bottom = 0;
+};
+
+enum class RHIBarrierType : uint8_t {
+    Transition = 0,
+    Aliasing,
+    UAV
+};
+
+// Same state flags as the render graph, so graph barriers map one to one.
+struct RHIBarrier {
+    RHIBarrierType type = RHIBarrierType::Transition;
+    RHIResourceId resource = RHI_NULL_RESOURCE;
+    RHIResourceId aliasBefore = RHI_NULL_RESOURCE;
+    RGState before = RGState::Undefined;
+    RGState after = RGState::Undefined;
+};
+
+enum class RHIDescriptorType : uint8_t {
+    Texture = 0,
+    Buffer
+};
+
+class IRHICommandList {
+public:
+    virtual ~IRHICommandList() = default;
+
+    virtual void Barriers(const RHIBarrier* barriers, uint32_t count) = 0;
+
+    virtual void SetRenderTargets(const RHIResourceId* colors, uint32_t colorCount, RHIResourceId depth) = 0;
+    virtual void ClearRenderTarget(RHIResourceId target, const float color[4]) = 0;
+    virtual void ClearDepth(RHIResourceId target, float depth) = 0;
+    virtual void SetViewport(const RHIViewport& viewport) = 0;
+    virtual void SetScissor(const RHIRect& rect) = 0;
+
+    // Binds the shared bindless descriptor heap.
+    virtual void SetDescriptorHeap() = 0;
+    virtual void SetPipeline(RHIPipelineId pipeline) = 0;
+    virtual void SetRootConstants(uint32_t slot, const uint32_t* values, uint32_t count) = 0;
+    // Binds a table starting at 'firstDescriptor' in the shared heap.
+    virtual void SetDescriptorTable(uint32_t slot, uint32_t firstDescriptor) = 0;
+    // Root buffer views, bound by GPU address without a descriptor.
+    virtual void SetRootShaderResource(uint32_t slot, RHIResourceId buffer) = 0;
+    virtual void SetRootUnorderedAccess(uint32_t slot, RHIResourceId buffer) = 0;
+
+    virtual void SetVertexBuffer(RHIResourceId buffer, uint32_t stride, uint32_t size) = 0;
+    virtual void SetIndexBuffer(RHIResourceId buffer, uint32_t size, bool use32BitIndices) = 0;
+    virtual void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance) = 0;
+    virtual void Dispatch(uint32_t x, uint32_t y, uint32_t z) = 0;
+    // Up to 'maxCount' draws read from 'argsBuffer'; the actual count is the uint at
+    // 'countOffset' in 'countBuffer'. Each draw sets one root constant of the bound
+    // pipeline before its DrawIndexed arguments (see IndirectDrawCommand).
+    virtual void DrawIndexedIndirect(RHIResourceId argsBuffer, uint64_t argsOffset, uint32_t maxCount, RHIResourceId countBuffer, uint64_t countOffset) = 0;
+
+    virtual void CopyBuffer(RHIResourceId dst, uint64_t dstOffset, RHIResourceId src, uint64_t srcOffset, uint64_t size) = 0;
+    virtual void CopyTexture(RHIResourceId dst, RHIResourceId src) = 0;
+
+    // Writes a view of 'resource' into slot 'index' of the shared heap.
+    virtual void WriteDescriptor(uint32_t index, RHIResourceId resource, RHIDescriptorType type) = 0;
+};
+
+// Extra command lists recorded on worker threads. Each secondary starts with no
+// state bound. SubmitSecondaries queues secondaries [0, count) in index order
+// after everything recorded on the primary list so far; commands recorded on
+// the primary afterwards execute after them.
+class IRHISecondaryLists {
+public:
+    virtual ~IRHISecondaryLists() = default;
+
+    virtual uint32_t GetMaxSecondaryLists() const = 0;
+    // Safe to call from several threads at once for different indices.
+    virtual IRHICommandList* BeginSecondary(uint32_t index) = 0;
+    virtual void SubmitSecondaries(uint32_t count) = 0;
+};
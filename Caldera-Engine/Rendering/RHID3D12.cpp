@@ -0,0 +1,337 @@
+#include "RHID3D12.h"
+#include <cassert>
+#include <vector>
+
+void D3D12CommandList::Initialize(ID3D12Device* device, ID3D12DescriptorHeap* descriptorHeap)
+{
+    this->device = device;
+    this->descriptorHeap = descriptorHeap;
+    descriptorIncrement = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
+void D3D12CommandList::Begin(ID3D12GraphicsCommandList* list)
+{
+    this->list = list;
+    currentPipeline = nullptr;
+}
+
+void D3D12CommandList::Barriers(const RHIBarrier* barriers, uint32_t count)
+{
+    D3D12_RESOURCE_BARRIER batch[16];
+    std::vector<D3D12_RESOURCE_BARRIER> overflow;
+    D3D12_RESOURCE_BARRIER* out = batch;
+    if (count > _countof(batch)) {
+        overflow.resize(count);
+        out = overflow.data();
+    }
+
+    UINT used = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const RHIBarrier& barrier = barriers[i];
+        D3D12_RESOURCE_BARRIER& d3dBarrier = out[used];
+        d3dBarrier = {};
+
+        switch (barrier.type) {
+        case RHIBarrierType::Transition: {
+            D3D12_RESOURCE_STATES before = ToResourceStates(barrier.before);
+            D3D12_RESOURCE_STATES after = ToResourceStates(barrier.after);
+            if (before == after)
+                continue;
+            d3dBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+            d3dBarrier.Transition.pResource = ToResource(barrier.resource);
+            d3dBarrier.Transition.StateBefore = before;
+            d3dBarrier.Transition.StateAfter = after;
+            d3dBarrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+            break;
+        }
+        case RHIBarrierType::Aliasing:
+            d3dBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+            d3dBarrier.Aliasing.pResourceBefore = ToResource(barrier.aliasBefore);
+            d3dBarrier.Aliasing.pResourceAfter = ToResource(barrier.resource);
+            break;
+        case RHIBarrierType::UAV:
+            d3dBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+            d3dBarrier.UAV.pResource = ToResource(barrier.resource);
+            break;
+        }
+        ++used;
+    }
+
+    if (used > 0)
+        list->ResourceBarrier(used, out);
+}
+
+void D3D12CommandList::SetRenderTargets(const RHIResourceId* colors, uint32_t colorCount, RHIResourceId depth)
+{
+    assert(colorCount <= D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT && "Too many render targets");
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvs[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT];
+    for (uint32_t i = 0; i < colorCount; ++i)
+        rtvs[i] = GetView(colors[i]);
+
+    D3D12_CPU_DESCRIPTOR_HANDLE dsv = {};
+    if (depth != RHI_NULL_RESOURCE)
+        dsv = GetView(depth);
+    list->OMSetRenderTargets(colorCount, rtvs, FALSE, depth != RHI_NULL_RESOURCE ? &dsv : nullptr);
+}
+
+void D3D12CommandList::ClearRenderTarget(RHIResourceId target, const float color[4])
+{
+    list->ClearRenderTargetView(GetView(target), color, 0, nullptr);
+}
+
+void D3D12CommandList::ClearDepth(RHIResourceId target, float depth)
+{
+    list->ClearDepthStencilView(GetView(target), D3D12_CLEAR_FLAG_DEPTH, depth, 0, 0, nullptr);
+}
+
+void D3D12CommandList::SetViewport(const RHIViewport& viewport)
+{
+    D3D12_VIEWPORT d3dViewport = { viewport.x, viewport.y, viewport.width, viewport.height, viewport.minDepth, viewport.maxDepth };
+    list->RSSetViewports(1, &d3dViewport);
+}
+
+void D3D12CommandList::SetScissor(const RHIRect& rect)
+{
+    D3D12_RECT d3dRect = { rect.left, rect.top, rect.right, rect.bottom };
+    list->RSSetScissorRects(1, &d3dRect);
+}
+
+void D3D12CommandList::SetDescriptorHeap()
+{
+    ID3D12DescriptorHeap* heaps[] = { descriptorHeap };
+    list->SetDescriptorHeaps(1, heaps);
+}
+
+void D3D12CommandList::SetPipeline(RHIPipelineId pipeline)
+{
+    const D3D12Pipeline* d3dPipeline = reinterpret_cast<const D3D12Pipeline*>(pipeline);
+    if (d3dPipeline->compute)
+        list->SetComputeRootSignature(d3dPipeline->rootSignature.Get());
+    else
+        list->SetGraphicsRootSignature(d3dPipeline->rootSignature.Get());
+    list->SetPipelineState(d3dPipeline->pipelineState.Get());
+    currentPipeline = d3dPipeline;
+}
+
+void D3D12CommandList::SetRootConstants(uint32_t slot, const uint32_t* values, uint32_t count)
+{
+    assert(currentPipeline && "SetPipeline before setting root arguments");
+    if (currentPipeline->compute)
+        list->SetComputeRoot32BitConstants(slot, count, values, 0);
+    else
+        list->SetGraphicsRoot32BitConstants(slot, count, values, 0);
+}
+
+void D3D12CommandList::SetDescriptorTable(uint32_t slot, uint32_t firstDescriptor)
+{
+    assert(currentPipeline && "SetPipeline before setting root arguments");
+    D3D12_GPU_DESCRIPTOR_HANDLE handle = descriptorHeap->GetGPUDescriptorHandleForHeapStart();
+    handle.ptr += UINT64(firstDescriptor) * descriptorIncrement;
+    if (currentPipeline->compute)
+        list->SetComputeRootDescriptorTable(slot, handle);
+    else
+        list->SetGraphicsRootDescriptorTable(slot, handle);
+}
+
+void D3D12CommandList::SetRootShaderResource(uint32_t slot, RHIResourceId buffer)
+{
+    assert(currentPipeline && "SetPipeline before setting root arguments");
+    D3D12_GPU_VIRTUAL_ADDRESS address = ToResource(buffer)->GetGPUVirtualAddress();
+    if (currentPipeline->compute)
+        list->SetComputeRootShaderResourceView(slot, address);
+    else
+        list->SetGraphicsRootShaderResourceView(slot, address);
+}
+
+void D3D12CommandList::SetRootUnorderedAccess(uint32_t slot, RHIResourceId buffer)
+{
+    assert(currentPipeline && "SetPipeline before setting root arguments");
+    D3D12_GPU_VIRTUAL_ADDRESS address = ToResource(buffer)->GetGPUVirtualAddress();
+    if (currentPipeline->compute)
+        list->SetComputeRootUnorderedAccessView(slot, address);
+    else
+        list->SetGraphicsRootUnorderedAccessView(slot, address);
+}
+
+void D3D12CommandList::SetVertexBuffer(RHIResourceId buffer, uint32_t stride, uint32_t size)
+{
+    D3D12_VERTEX_BUFFER_VIEW view = {};
+    view.BufferLocation = ToResource(buffer)->GetGPUVirtualAddress();
+    view.StrideInBytes = stride;
+    view.SizeInBytes = size;
+    list->IASetVertexBuffers(0, 1, &view);
+    list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+}
+
+void D3D12CommandList::SetIndexBuffer(RHIResourceId buffer, uint32_t size, bool use32BitIndices)
+{
+    D3D12_INDEX_BUFFER_VIEW view = {};
+    view.BufferLocation = ToResource(buffer)->GetGPUVirtualAddress();
+    view.SizeInBytes = size;
+    view.Format = use32BitIndices ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+    list->IASetIndexBuffer(&view);
+}
+
+void D3D12CommandList::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance)
+{
+    list->DrawIndexedInstanced(indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
+}
+
+void D3D12CommandList::Dispatch(uint32_t x, uint32_t y, uint32_t z)
+{
+    list->Dispatch(x, y, z);
+}
+
+void D3D12CommandList::DrawIndexedIndirect(RHIResourceId argsBuffer, uint64_t argsOffset, uint32_t maxCount, RHIResourceId countBuffer, uint64_t countOffset)
+{
+    assert(currentPipeline && currentPipeline->drawIndirectSignature && "Pipeline has no indirect command signature");
+    list->ExecuteIndirect(currentPipeline->drawIndirectSignature.Get(), maxCount,
+        ToResource(argsBuffer), argsOffset, ToResource(countBuffer), countOffset);
+}
+
+void D3D12CommandList::CopyBuffer(RHIResourceId dst, uint64_t dstOffset, RHIResourceId src, uint64_t srcOffset, uint64_t size)
+{
+    list->CopyBufferRegion(ToResource(dst), dstOffset, ToResource(src), srcOffset, size);
+}
+
+void D3D12CommandList::CopyTexture(RHIResourceId dst, RHIResourceId src)
+{
+    list->CopyResource(ToResource(dst), ToResource(src));
+}
+
+void D3D12CommandList::WriteDescriptor(uint32_t index, RHIResourceId resource, RHIDescriptorType type)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE handle = descriptorHeap->GetCPUDescriptorHandleForHeapStart();
+    handle.ptr += SIZE_T(index) * descriptorIncrement;
+
+    ID3D12Resource* d3dResource = ToResource(resource);
+    if (type == RHIDescriptorType::Texture) {
+        device->CreateShaderResourceView(d3dResource, nullptr, handle);
+        return;
+    }
+
+    // Buffers without a known stride are exposed as raw (ByteAddressBuffer) views
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+    srvDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    srvDesc.Buffer.NumElements = static_cast<UINT>(d3dResource->GetDesc().Width / 4);
+    srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_RAW;
+    device->CreateShaderResourceView(d3dResource, &srvDesc, handle);
+}
+
+D3D12_RESOURCE_STATES D3D12CommandList::ToResourceStates(RGState state)
+{
+    D3D12_RESOURCE_STATES states = D3D12_RESOURCE_STATE_COMMON;
+    if ((state & RGState::RenderTarget) != RGState::Undefined)    states |= D3D12_RESOURCE_STATE_RENDER_TARGET;
+    if ((state & RGState::DepthWrite) != RGState::Undefined)      states |= D3D12_RESOURCE_STATE_DEPTH_WRITE;
+    if ((state & RGState::DepthRead) != RGState::Undefined)       states |= D3D12_RESOURCE_STATE_DEPTH_READ;
+    if ((state & RGState::ShaderResource) != RGState::Undefined)  states |= D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+    if ((state & RGState::UnorderedAccess) != RGState::Undefined) states |= D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+    if ((state & RGState::CopySource) != RGState::Undefined)      states |= D3D12_RESOURCE_STATE_COPY_SOURCE;
+    if ((state & RGState::CopyDest) != RGState::Undefined)        states |= D3D12_RESOURCE_STATE_COPY_DEST;
+    if ((state & RGState::IndirectArgument) != RGState::Undefined) states |= D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
+    // Present maps to COMMON (0)
+    return states;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE D3D12CommandList::GetView(RHIResourceId resource) const
+{
+    auto it = views.find(resource);
+    assert(it != views.end() && "No render target or depth view registered for resource");
+    return it != views.end() ? it->second : D3D12_CPU_DESCRIPTOR_HANDLE{ 0 };
+}
+
+bool D3D12SecondaryLists::Create(ID3D12Device* device, ID3D12DescriptorHeap* descriptorHeap, UINT frameCount)
+{
+    frames.resize(frameCount);
+    for (FrameAllocators& frame : frames) {
+        for (ComPtr<ID3D12CommandAllocator>& allocator : frame.secondary)
+            if (device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator)) != S_OK)
+                return false;
+        for (ComPtr<ID3D12CommandAllocator>& allocator : frame.primarySegments)
+            if (device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator)) != S_OK)
+                return false;
+    }
+
+    for (UINT i = 0; i < MAX_SECONDARY_LISTS; ++i) {
+        if (device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, frames[0].secondary[i].Get(), nullptr, IID_PPV_ARGS(&secondaryLists[i])) != S_OK ||
+            secondaryLists[i]->Close() != S_OK)
+            return false;
+        secondaries[i].Initialize(device, descriptorHeap);
+    }
+    for (UINT i = 0; i < MAX_PRIMARY_SEGMENTS; ++i) {
+        if (device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, frames[0].primarySegments[i].Get(), nullptr, IID_PPV_ARGS(&segmentLists[i])) != S_OK ||
+            segmentLists[i]->Close() != S_OK)
+            return false;
+    }
+    return true;
+}
+
+void D3D12SecondaryLists::Destroy()
+{
+    // Caller has already waited for the GPU
+    for (ComPtr<ID3D12GraphicsCommandList>& list : secondaryLists)
+        list.Reset();
+    for (ComPtr<ID3D12GraphicsCommandList>& list : segmentLists)
+        list.Reset();
+    frames.clear();
+    primary = nullptr;
+}
+
+void D3D12SecondaryLists::BeginFrame(UINT frameSlot, D3D12CommandList* primary)
+{
+    this->frameSlot = frameSlot;
+    this->primary = primary;
+    segmentCount = 0;
+    submission.clear();
+
+    FrameAllocators& frame = frames[frameSlot];
+    for (ComPtr<ID3D12CommandAllocator>& allocator : frame.secondary)
+        allocator->Reset();
+    for (ComPtr<ID3D12CommandAllocator>& allocator : frame.primarySegments)
+        allocator->Reset();
+}
+
+void D3D12SecondaryLists::Close(std::vector<ID3D12CommandList*>& outLists)
+{
+    primary->GetNative()->Close();
+    outLists.insert(outLists.end(), submission.begin(), submission.end());
+    outLists.push_back(primary->GetNative());
+}
+
+IRHICommandList* D3D12SecondaryLists::BeginSecondary(uint32_t index)
+{
+    if (index >= MAX_SECONDARY_LISTS)
+        return nullptr;
+
+    ID3D12GraphicsCommandList* list = secondaryLists[index].Get();
+    list->Reset(frames[frameSlot].secondary[index].Get(), nullptr);
+    secondaries[index].InheritViews(*primary);
+    secondaries[index].Begin(list);
+    return &secondaries[index];
+}
+
+void D3D12SecondaryLists::SubmitSecondaries(uint32_t count)
+{
+    assert(count <= MAX_SECONDARY_LISTS && "Too many secondary lists");
+    if (segmentCount >= MAX_PRIMARY_SEGMENTS) {
+        // Out of continuation lists: fall back to submitting nothing new rather than reordering
+        assert(false && "Too many secondary submissions in one frame");
+        return;
+    }
+
+    primary->GetNative()->Close();
+    submission.push_back(primary->GetNative());
+    for (uint32_t i = 0; i < count; ++i) {
+        secondaries[i].GetNative()->Close();
+        submission.push_back(secondaries[i].GetNative());
+    }
+
+    // The primary continues on a fresh list, which starts with nothing bound
+    ID3D12GraphicsCommandList* next = segmentLists[segmentCount].Get();
+    next->Reset(frames[frameSlot].primarySegments[segmentCount].Get(), nullptr);
+    ++segmentCount;
+    primary->Begin(next);
+    primary->SetDescriptorHeap();
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <unordered_map>
+#include <vector>
+#include "RHI.h"
+
+using namespace Microsoft::WRL;
+
+// A pipeline as the RHI sees it. The owner keeps it alive; its address is the id.
+struct D3D12Pipeline {
+    ComPtr<ID3D12PipelineState> pipelineState;
+    ComPtr<ID3D12RootSignature> rootSignature;
+    bool compute = false;
+    // Layout of DrawIndexedIndirect commands; only set for pipelines that draw indirectly.
+    ComPtr<ID3D12CommandSignature> drawIndirectSignature;
+};
+
+// IRHICommandList on top of an ID3D12GraphicsCommandList. Resource ids are the
+// ID3D12Resource pointers; render target and depth views are looked up from
+// whatever was registered with RegisterView this frame.
+class D3D12CommandList : public IRHICommandList {
+public:
+    static RHIResourceId ToId(ID3D12Resource* resource) { return reinterpret_cast<RHIResourceId>(resource); }
+    static RHIPipelineId ToId(const D3D12Pipeline* pipeline) { return reinterpret_cast<RHIPipelineId>(pipeline); }
+    static ID3D12Resource* ToResource(RHIResourceId id) { return reinterpret_cast<ID3D12Resource*>(id); }
+
+    void Initialize(ID3D12Device* device, ID3D12DescriptorHeap* descriptorHeap);
+    void Begin(ID3D12GraphicsCommandList* list);
+    ID3D12GraphicsCommandList* GetNative() const { return list; }
+
+    void RegisterView(RHIResourceId resource, D3D12_CPU_DESCRIPTOR_HANDLE view) { views[resource] = view; }
+    void InheritViews(const D3D12CommandList& other) { views = other.views; }
+
+    void Barriers(const RHIBarrier* barriers, uint32_t count) override;
+
+    void SetRenderTargets(const RHIResourceId* colors, uint32_t colorCount, RHIResourceId depth) override;
+    void ClearRenderTarget(RHIResourceId target, const float color[4]) override;
+    void ClearDepth(RHIResourceId target, float depth) override;
+    void SetViewport(const RHIViewport& viewport) override;
+    void SetScissor(const RHIRect& rect) override;
+
+    void SetDescriptorHeap() override;
+    void SetPipeline(RHIPipelineId pipeline) override;
+    void SetRootConstants(uint32_t slot, const uint32_t* values, uint32_t count) override;
+    void SetDescriptorTable(uint32_t slot, uint32_t firstDescriptor) override;
+    void SetRootShaderResource(uint32_t slot, RHIResourceId buffer) override;
+    void SetRootUnorderedAccess(uint32_t slot, RHIResourceId buffer) override;
+
+    void SetVertexBuffer(RHIResourceId buffer, uint32_t stride, uint32_t size) override;
+    void SetIndexBuffer(RHIResourceId buffer, uint32_t size, bool use32BitIndices) override;
+    void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance) override;
+    void Dispatch(uint32_t x, uint32_t y, uint32_t z) override;
+    void DrawIndexedIndirect(RHIResourceId argsBuffer, uint64_t argsOffset, uint32_t maxCount, RHIResourceId countBuffer, uint64_t countOffset) override;
+
+    void CopyBuffer(RHIResourceId dst, uint64_t dstOffset, RHIResourceId src, uint64_t srcOffset, uint64_t size) override;
+    void CopyTexture(RHIResourceId dst, RHIResourceId src) override;
+
+    void WriteDescriptor(uint32_t index, RHIResourceId resource, RHIDescriptorType type) override;
+
+    static D3D12_RESOURCE_STATES ToResourceStates(RGState state);
+
+private:
+    D3D12_CPU_DESCRIPTOR_HANDLE GetView(RHIResourceId resource) const;
+
+    ID3D12Device* device = nullptr;
+    ID3D12GraphicsCommandList* list = nullptr;
+    ID3D12DescriptorHeap* descriptorHeap = nullptr;
+    UINT descriptorIncrement = 0;
+    const D3D12Pipeline* currentPipeline = nullptr;
+
+    std::unordered_map<RHIResourceId, D3D12_CPU_DESCRIPTOR_HANDLE> views;
+};
+
+// Per-frame secondary lists for parallel recording. Every frame slot owns one
+// allocator per secondary and per primary continuation, so workers never share
+// an allocator. SubmitSecondaries closes the primary's current list, queues it
+// followed by the secondaries, and moves the primary onto a fresh list; Close
+// returns the whole frame in submission order.
+class D3D12SecondaryLists : public IRHISecondaryLists {
+public:
+    static constexpr UINT MAX_SECONDARY_LISTS = 8;
+    static constexpr UINT MAX_PRIMARY_SEGMENTS = 4;
+
+    bool Create(ID3D12Device* device, ID3D12DescriptorHeap* descriptorHeap, UINT frameCount);
+    void Destroy();
+
+    // The GPU must be done with 'frameSlot'. 'primary' has already begun its first list.
+    void BeginFrame(UINT frameSlot, D3D12CommandList* primary);
+    // Closes the primary and appends every list of the frame, in order, to 'outLists'.
+    void Close(std::vector<ID3D12CommandList*>& outLists);
+
+    uint32_t GetMaxSecondaryLists() const override { return MAX_SECONDARY_LISTS; }
+    IRHICommandList* BeginSecondary(uint32_t index) override;
+    void SubmitSecondaries(uint32_t count) override;
+
+private:
+    struct FrameAllocators {
+        ComPtr<ID3D12CommandAllocator> secondary[MAX_SECONDARY_LISTS];
+        ComPtr<ID3D12CommandAllocator> primarySegments[MAX_PRIMARY_SEGMENTS];
+    };
+
+    std::vector<FrameAllocators> frames;
+    ComPtr<ID3D12GraphicsCommandList> secondaryLists[MAX_SECONDARY_LISTS];
+    ComPtr<ID3D12GraphicsCommandList> segmentLists[MAX_PRIMARY_SEGMENTS];
+    D3D12CommandList secondaries[MAX_SECONDARY_LISTS];
+
+    D3D12CommandList* primary = nullptr;
+    UINT frameSlot = 0;
+    UINT segmentCount = 0;
+    std::vector<ID3D12CommandList*> submission;
+};
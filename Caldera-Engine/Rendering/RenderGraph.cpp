@@ -0,0 +1,412 @@
+#include "RenderGraph.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+static constexpr uint64_t RG_DEFAULT_ALIGNMENT = 64 * 1024;
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+bool RGTextureDesc::operator==(const RGTextureDesc& other) const
+{
+    return width == other.width && height == other.height && format == other.format &&
+        bytesPerPixel == other.bytesPerPixel && isDepth == other.isDepth &&
+        memcmp(clearValue, other.clearValue, sizeof(clearValue)) == 0;
+}
+
+RGResourceHandle RGPassBuilder::Read(RGResourceHandle resource, RGState state)
+{
+    graph->AddAccess(passIndex, resource, state, false);
+    return resource;
+}
+
+RGResourceHandle RGPassBuilder::Write(RGResourceHandle resource, RGState state)
+{
+    graph->AddAccess(passIndex, resource, state, true);
+    return resource;
+}
+
+void RGPassBuilder::SetSideEffects()
+{
+    graph->passes[passIndex].sideEffects = true;
+}
+
+RGResourceHandle RenderGraph::CreateTexture(const std::string& name, const RGTextureDesc& desc)
+{
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    resources.push_back(resource);
+    compiled = false;
+    return { static_cast<uint32_t>(resources.size() - 1) };
+}
+
+RGResourceHandle RenderGraph::ImportTexture(const std::string& name, const RGTextureDesc& desc, RGState initialState, RGState finalState, void* external)
+{
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    resource.external = external;
+    resource.initialState = initialState;
+    resource.finalState = finalState;
+    resource.imported = true;
+    resources.push_back(resource);
+    compiled = false;
+    return { static_cast<uint32_t>(resources.size() - 1) };
+}
+
+void RenderGraph::MarkOutput(RGResourceHandle resource)
+{
+    assert(resource.index < resources.size() && "Invalid render graph resource");
+    resources[resource.index].output = true;
+}
+
+uint32_t RenderGraph::AddPass(const std::string& name, const std::function<void(RGPassBuilder&)>& setup, RGExecuteFn execute)
+{
+    Pass pass;
+    pass.name = name;
+    pass.execute = std::move(execute);
+    passes.push_back(std::move(pass));
+
+    const uint32_t index = static_cast<uint32_t>(passes.size() - 1);
+    RGPassBuilder builder(this, index);
+    if (setup)
+        setup(builder);
+
+    compiled = false;
+    return index;
+}
+
+void RenderGraph::AddAccess(uint32_t pass, RGResourceHandle resource, RGState state, bool write)
+{
+    assert(resource.index < resources.size() && "Invalid render graph resource");
+
+    // Several accesses to one resource in a pass collapse into one combined state
+    for (Access& access : passes[pass].accesses) {
+        if (access.resource == resource.index) {
+            access.state = access.state | state;
+            access.read |= !write;
+            access.write |= write;
+            return;
+        }
+    }
+    passes[pass].accesses.push_back({ resource.index, state, !write, write });
+}
+
+bool RenderGraph::Compile(const IRenderGraphBackend* backend)
+{
+    errors.clear();
+    finalBarriers.clear();
+    stats = RenderGraphStats();
+    stats.passCount = static_cast<uint32_t>(passes.size());
+
+    for (Pass& pass : passes) {
+        pass.barriers.clear();
+        pass.culled = false;
+    }
+    for (Resource& resource : resources) {
+        resource.firstPass = ~0u;
+        resource.lastPass = 0;
+        resource.size = 0;
+        resource.heapOffset = 0;
+        resource.aliasBefore = ~0u;
+    }
+
+    CullPasses();
+    if (!ComputeLifetimes()) {
+        compiled = false;
+        return false;
+    }
+    AliasTransients(backend);
+    BuildBarriers();
+
+    compiled = true;
+    return true;
+}
+
+void RenderGraph::Execute(IRenderGraphBackend& backend)
+{
+    assert(compiled && "Render graph must be compiled before it executes");
+
+    if (!backend.RealizeTransients(*this))
+        return;
+
+    RGPassContext context;
+    context.graph = this;
+    context.backend = &backend;
+
+    for (uint32_t i = 0; i < passes.size(); ++i) {
+        Pass& pass = passes[i];
+        if (pass.culled)
+            continue;
+
+        if (!pass.barriers.empty())
+            backend.SubmitBarriers(*this, pass.barriers.data(), pass.barriers.size());
+
+        if (pass.execute) {
+            context.passIndex = i;
+            pass.execute(context);
+        }
+    }
+
+    if (!finalBarriers.empty())
+        backend.SubmitBarriers(*this, finalBarriers.data(), finalBarriers.size());
+}
+
+void RenderGraph::Reset()
+{
+    passes.clear();
+    resources.clear();
+    finalBarriers.clear();
+    errors.clear();
+    stats = RenderGraphStats();
+    compiled = false;
+}
+
+bool RenderGraph::IsTransientLive(uint32_t resource) const
+{
+    return !resources[resource].imported && resources[resource].firstPass != ~0u;
+}
+
+void RenderGraph::CullPasses()
+{
+    for (Pass& pass : passes) {
+        pass.refCount = 0;
+        for (const Access& access : pass.accesses)
+            if (access.write)
+                ++pass.refCount;
+    }
+
+    for (Resource& resource : resources)
+        resource.refCount = (resource.imported || resource.output) ? 1 : 0;
+    for (const Pass& pass : passes)
+        for (const Access& access : pass.accesses)
+            if (access.read)
+                ++resources[access.resource].refCount;
+
+    // Each resource is queued once, when its count reaches zero: the ones nobody
+    // reads to begin with here, the rest when their last reader is culled
+    std::vector<uint32_t> unreferenced;
+    for (uint32_t i = 0; i < resources.size(); ++i)
+        if (resources[i].refCount == 0)
+            unreferenced.push_back(i);
+
+    auto cull = [&](Pass& pass) {
+        pass.culled = true;
+        for (const Access& access : pass.accesses)
+            if (access.read && --resources[access.resource].refCount == 0)
+                unreferenced.push_back(access.resource);
+    };
+
+    for (Pass& pass : passes)
+        if (pass.refCount == 0 && !pass.sideEffects)
+            cull(pass);
+
+    // Walk back from resources nobody reads, dropping producers that end up unused
+    while (!unreferenced.empty()) {
+        const uint32_t resource = unreferenced.back();
+        unreferenced.pop_back();
+
+        for (Pass& pass : passes) {
+            if (pass.culled)
+                continue;
+            for (const Access& access : pass.accesses) {
+                if (access.resource == resource && access.write) {
+                    if (--pass.refCount == 0 && !pass.sideEffects)
+                        cull(pass);
+                    break;
+                }
+            }
+        }
+    }
+
+    for (const Pass& pass : passes)
+        if (pass.culled)
+            ++stats.culledPassCount;
+}
+
+bool RenderGraph::ComputeLifetimes()
+{
+    for (uint32_t i = 0; i < passes.size(); ++i) {
+        const Pass& pass = passes[i];
+        if (pass.culled)
+            continue;
+
+        for (const Access& access : pass.accesses) {
+            Resource& resource = resources[access.resource];
+            if (resource.firstPass == ~0u) {
+                resource.firstPass = i;
+                if (!resource.imported && !access.write)
+                    errors.push_back("Pass '" + pass.name + "' reads transient '" + resource.name + "' before any pass writes it");
+            }
+            resource.lastPass = i;
+        }
+    }
+    return errors.empty();
+}
+
+void RenderGraph::AliasTransients(const IRenderGraphBackend* backend)
+{
+    std::vector<uint32_t> order;
+    for (uint32_t i = 0; i < resources.size(); ++i) {
+        if (!IsTransientLive(i))
+            continue;
+
+        Resource& resource = resources[i];
+        if (backend) {
+            backend->GetAllocationInfo(resource.desc, resource.size, resource.alignment);
+        }
+        else {
+            resource.alignment = RG_DEFAULT_ALIGNMENT;
+            resource.size = AlignUp(uint64_t(resource.desc.width) * resource.desc.height * resource.desc.bytesPerPixel, RG_DEFAULT_ALIGNMENT);
+        }
+        resource.alignment = std::max<uint64_t>(resource.alignment, 1);
+
+        order.push_back(i);
+        ++stats.transientCount;
+        stats.transientBytes += resource.size;
+    }
+
+    // Largest first, each at the lowest offset that does not collide with a
+    // placed resource whose lifetime overlaps
+    std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return resources[a].size > resources[b].size;
+    });
+
+    auto lifetimesOverlap = [](const Resource& a, const Resource& b) {
+        return a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+    };
+    auto memoryOverlaps = [](const Resource& a, const Resource& b) {
+        return a.heapOffset < b.heapOffset + b.size && b.heapOffset < a.heapOffset + a.size;
+    };
+
+    std::vector<uint32_t> placed;
+    for (uint32_t index : order) {
+        Resource& resource = resources[index];
+        resource.heapOffset = 0;
+
+        bool moved = true;
+        while (moved) {
+            moved = false;
+            for (uint32_t other : placed) {
+                const Resource& o = resources[other];
+                if (lifetimesOverlap(resource, o) && memoryOverlaps(resource, o)) {
+                    resource.heapOffset = AlignUp(o.heapOffset + o.size, resource.alignment);
+                    moved = true;
+                }
+            }
+        }
+
+        placed.push_back(index);
+        stats.aliasedHeapBytes = std::max(stats.aliasedHeapBytes, resource.heapOffset + resource.size);
+    }
+
+    // The latest earlier tenant of a resource's memory needs an aliasing barrier
+    for (uint32_t index : placed) {
+        Resource& resource = resources[index];
+        uint32_t bestLastPass = 0;
+        for (uint32_t other : placed) {
+            const Resource& o = resources[other];
+            if (other == index || o.lastPass >= resource.firstPass || !memoryOverlaps(resource, o))
+                continue;
+            if (resource.aliasBefore == ~0u || o.lastPass >= bestLastPass) {
+                resource.aliasBefore = other;
+                bestLastPass = o.lastPass;
+            }
+        }
+    }
+}
+
+RGState RenderGraph::NextReadStates(uint32_t resource, uint32_t fromPass) const
+{
+    RGState combined = RGState::Undefined;
+    for (uint32_t i = fromPass; i < passes.size(); ++i) {
+        if (passes[i].culled)
+            continue;
+
+        for (const Access& access : passes[i].accesses) {
+            if (access.resource != resource)
+                continue;
+            if (access.write || !IsReadOnlyState(access.state))
+                return combined;
+            combined = combined | access.state;
+        }
+    }
+    return combined;
+}
+
+void RenderGraph::BuildBarriers()
+{
+    std::vector<RGState> current(resources.size());
+    for (uint32_t i = 0; i < resources.size(); ++i)
+        current[i] = resources[i].imported ? resources[i].initialState : RGState::Undefined;
+
+    for (uint32_t i = 0; i < passes.size(); ++i) {
+        Pass& pass = passes[i];
+        if (pass.culled)
+            continue;
+
+        for (const Access& access : pass.accesses) {
+            const Resource& resource = resources[access.resource];
+            RGState& state = current[access.resource];
+
+            if (!resource.imported && state == RGState::Undefined && resource.aliasBefore != ~0u) {
+                RGBarrier barrier;
+                barrier.type = RGBarrierType::Aliasing;
+                barrier.resource = access.resource;
+                barrier.aliasBefore = resource.aliasBefore;
+                pass.barriers.push_back(barrier);
+            }
+
+            RGState target = access.state;
+            if (!access.write && IsReadOnlyState(target)) {
+                if (IsReadOnlyState(state) && (state & target) == target)
+                    continue;
+                // Transition once into every state the upcoming run of reads needs
+                target = NextReadStates(access.resource, i);
+            }
+
+            if (state != target) {
+                RGBarrier barrier;
+                barrier.type = RGBarrierType::Transition;
+                barrier.resource = access.resource;
+                barrier.before = state;
+                barrier.after = target;
+                pass.barriers.push_back(barrier);
+                state = target;
+            }
+            else if (access.write && target == RGState::UnorderedAccess) {
+                RGBarrier barrier;
+                barrier.type = RGBarrierType::UAV;
+                barrier.resource = access.resource;
+                pass.barriers.push_back(barrier);
+            }
+        }
+
+        if (!pass.barriers.empty()) {
+            stats.barrierCount += static_cast<uint32_t>(pass.barriers.size());
+            ++stats.barrierBatchCount;
+        }
+    }
+
+    for (uint32_t i = 0; i < resources.size(); ++i) {
+        const Resource& resource = resources[i];
+        if (!resource.imported || resource.finalState == RGState::Undefined || current[i] == resource.finalState)
+            continue;
+
+        RGBarrier barrier;
+        barrier.type = RGBarrierType::Transition;
+        barrier.resource = i;
+        barrier.before = current[i];
+        barrier.after = resource.finalState;
+        finalBarriers.push_back(barrier);
+    }
+
+    if (!finalBarriers.empty()) {
+        stats.barrierCount += static_cast<uint32_t>(finalBarriers.size());
+        ++stats.barrierBatchCount;
+    }
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Resource states the graph tracks. Flags, so read-only states can be combined
+// into one transition when several passes read a resource in different ways.
+enum class RGState : uint32_t {
+    Undefined       = 0,        // transient before its first use this frame
+    Present         = 1u << 0,
+    RenderTarget    = 1u << 1,
+    DepthWrite      = 1u << 2,
+    DepthRead       = 1u << 3,
+    ShaderResource  = 1u << 4,
+    UnorderedAccess = 1u << 5,
+    CopySource      = 1u << 6,
+    CopyDest        = 1u << 7,
+    IndirectArgument = 1u << 8,
+};
+
+inline RGState operator|(RGState a, RGState b) { return static_cast<RGState>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b)); }
+inline RGState operator&(RGState a, RGState b) { return static_cast<RGState>(static_cast<uint32_t>(a) & static_cast<uint32_t>(b)); }
+
+constexpr RGState RG_READ_ONLY_STATES = static_cast<RGState>(
+    static_cast<uint32_t>(RGState::DepthRead) | static_cast<uint32_t>(RGState::ShaderResource) | static_cast<uint32_t>(RGState::CopySource) |
+    static_cast<uint32_t>(RGState::IndirectArgument));
+
+inline bool IsReadOnlyState(RGState state) { return state != RGState::Undefined && (state & RG_READ_ONLY_STATES) == state; }
+
+struct RGResourceHandle {
+    uint32_t index = ~0u;
+
+    bool IsValid() const { return index != ~0u; }
+    bool operator==(const RGResourceHandle& other) const { return index == other.index; }
+};
+
+struct RGTextureDesc {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t format = 0;        // backend format value (DXGI_FORMAT on D3D12)
+    uint32_t bytesPerPixel = 4; // only used when no backend sizes the texture
+    bool isDepth = false;
+    float clearValue[4] = { 0.0f, 0.0f, 0.0f, 0.0f }; // depth uses [0]
+
+    bool operator==(const RGTextureDesc& other) const;
+};
+
+enum class RGBarrierType : uint8_t {
+    Transition = 0,
+    Aliasing,
+    UAV
+};
+
+// 'resource' is the graph resource index. For aliasing barriers 'aliasBefore' is
+// the resource that last used the memory.
+struct RGBarrier {
+    RGBarrierType type = RGBarrierType::Transition;
+    uint32_t resource = ~0u;
+    uint32_t aliasBefore = ~0u;
+    RGState before = RGState::Undefined;
+    RGState after = RGState::Undefined;
+};
+
+struct RenderGraphStats {
+    uint32_t passCount = 0;
+    uint32_t culledPassCount = 0;
+    uint32_t barrierCount = 0;
+    uint32_t barrierBatchCount = 0;
+    uint32_t transientCount = 0;
+    uint64_t transientBytes = 0;    // sum of every transient on its own
+    uint64_t aliasedHeapBytes = 0;  // heap actually needed after aliasing
+    uint64_t GetBytesSaved() const { return transientBytes - aliasedHeapBytes; }
+};
+
+class RenderGraph;
+
+// Everything API-specific the graph needs. The compile step only asks for sizes,
+// so graphs can be compiled and validated headless with no backend at all.
+class IRenderGraphBackend {
+public:
+    virtual ~IRenderGraphBackend() = default;
+
+    virtual void GetAllocationInfo(const RGTextureDesc& desc, uint64_t& outSize, uint64_t& outAlignment) const = 0;
+    // Backs every live transient at its aliased offset (GetTransientOffset).
+    virtual bool RealizeTransients(const RenderGraph& graph) = 0;
+    // One call per batch. 'Undefined' before-states mean "whatever the physical
+    // resource is currently in".
+    virtual void SubmitBarriers(const RenderGraph& graph, const RGBarrier* barriers, size_t count) = 0;
+    // Opaque id (RHIResourceId) of the physical resource behind 'handle'.
+    virtual uint64_t GetResourceId(const RenderGraph& graph, RGResourceHandle handle) const = 0;
+};
+
+struct RGPassContext {
+    const RenderGraph* graph = nullptr;
+    IRenderGraphBackend* backend = nullptr;
+    uint32_t passIndex = 0;
+};
+
+using RGExecuteFn = std::function<void(const RGPassContext&)>;
+
+class RGPassBuilder {
+public:
+    RGResourceHandle Read(RGResourceHandle resource, RGState state = RGState::ShaderResource);
+    RGResourceHandle Write(RGResourceHandle resource, RGState state = RGState::RenderTarget);
+    // Keeps the pass even if nothing reads what it writes (readbacks, queries...).
+    void SetSideEffects();
+
+private:
+    friend class RenderGraph;
+    RGPassBuilder(RenderGraph* graph, uint32_t passIndex) : graph(graph), passIndex(passIndex) {}
+
+    RenderGraph* graph;
+    uint32_t passIndex;
+};
+
+// Frame graph. Passes declare what they read and write; Compile culls passes
+// nobody depends on, places transient textures in one shared heap by lifetime,
+// and works out the barriers each pass needs in a single batch. Passes run in
+// declaration order. The first writer of a transient must fully clear it, since
+// aliased memory holds whatever the previous tenant left behind.
+class RenderGraph {
+public:
+    RGResourceHandle CreateTexture(const std::string& name, const RGTextureDesc& desc);
+    // 'external' is handed back to the backend untouched (an ID3D12Resource* on D3D12).
+    RGResourceHandle ImportTexture(const std::string& name, const RGTextureDesc& desc, RGState initialState, RGState finalState, void* external);
+    void MarkOutput(RGResourceHandle resource);
+
+    uint32_t AddPass(const std::string& name, const std::function<void(RGPassBuilder&)>& setup, RGExecuteFn execute);
+
+    // 'backend' may be null, in which case transient sizes are estimated.
+    bool Compile(const IRenderGraphBackend* backend = nullptr);
+    void Execute(IRenderGraphBackend& backend);
+    void Reset();
+
+    const RenderGraphStats& GetStats() const { return stats; }
+    const std::vector<std::string>& GetErrors() const { return errors; }
+
+    // Inspection, mostly for backends and tools.
+    uint32_t GetPassCount() const { return static_cast<uint32_t>(passes.size()); }
+    const std::string& GetPassName(uint32_t pass) const { return passes[pass].name; }
+    bool IsPassCulled(uint32_t pass) const { return passes[pass].culled; }
+    const std::vector<RGBarrier>& GetPassBarriers(uint32_t pass) const { return passes[pass].barriers; }
+    const std::vector<RGBarrier>& GetFinalBarriers() const { return finalBarriers; }
+
+    uint32_t GetResourceCount() const { return static_cast<uint32_t>(resources.size()); }
+    const std::string& GetResourceName(uint32_t resource) const { return resources[resource].name; }
+    const RGTextureDesc& GetDesc(uint32_t resource) const { return resources[resource].desc; }
+    bool IsImported(uint32_t resource) const { return resources[resource].imported; }
+    void* GetExternal(uint32_t resource) const { return resources[resource].external; }
+    // Transients that survived culling. Offset/size are within the shared heap.
+    bool IsTransientLive(uint32_t resource) const;
+    uint64_t GetTransientOffset(uint32_t resource) const { return resources[resource].heapOffset; }
+    uint64_t GetTransientSize(uint32_t resource) const { return resources[resource].size; }
+    uint64_t GetTransientHeapSize() const { return stats.aliasedHeapBytes; }
+
+private:
+    friend class RGPassBuilder;
+
+    struct Access {
+        uint32_t resource;
+        RGState state;
+        bool read;
+        bool write;
+    };
+
+    struct Pass {
+        std::string name;
+        RGExecuteFn execute;
+        std::vector<Access> accesses;
+        std::vector<RGBarrier> barriers;
+        uint32_t refCount = 0;
+        bool sideEffects = false;
+        bool culled = false;
+    };
+
+    struct Resource {
+        std::string name;
+        RGTextureDesc desc;
+        void* external = nullptr;
+        RGState initialState = RGState::Undefined;
+        RGState finalState = RGState::Undefined;
+        bool imported = false;
+        bool output = false;
+
+        // Filled by Compile
+        uint32_t refCount = 0;
+        uint32_t firstPass = ~0u;
+        uint32_t lastPass = 0;
+        uint64_t size = 0;
+        uint64_t alignment = 0;
+        uint64_t heapOffset = 0;
+        uint32_t aliasBefore = ~0u;
+    };
+
+    void AddAccess(uint32_t pass, RGResourceHandle resource, RGState state, bool write);
+    void CullPasses();
+    bool ComputeLifetimes();
+    void AliasTransients(const IRenderGraphBackend* backend);
+    void BuildBarriers();
+    RGState NextReadStates(uint32_t resource, uint32_t fromPass) const;
+
+    std::vector<Pass> passes;
+    std::vector<Resource> resources;
+    std::vector<RGBarrier> finalBarriers;
+    std::vector<std::string> errors;
+    RenderGraphStats stats;
+    bool compiled = false;
+};
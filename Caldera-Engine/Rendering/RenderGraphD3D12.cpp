@@ -0,0 +1,282 @@
+#include "RenderGraphD3D12.h"
+#include <cassert>
+
+bool D3D12RenderGraphBackend::Create(ID3D12Device* device)
+{
+    assert(device && "Device is null");
+    this->device = device;
+
+    D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+    desc.NumDescriptors = MAX_TRANSIENT_VIEWS;
+    desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+    if (device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&rtvHeap)) != S_OK)
+        return false;
+    desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+    if (device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&dsvHeap)) != S_OK)
+        return false;
+
+    rtvIncrement = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+    dsvIncrement = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+
+    freeViews.clear();
+    for (UINT i = MAX_TRANSIENT_VIEWS; i > 0; --i)
+        freeViews.push_back(i - 1);
+    return true;
+}
+
+void D3D12RenderGraphBackend::Destroy()
+{
+    // Caller has already waited for the GPU
+    cache.clear();
+    bindings.clear();
+    retired.clear();
+    heap.Reset();
+    heapSize = 0;
+    rtvHeap.Reset();
+    dsvHeap.Reset();
+    device = nullptr;
+}
+
+void D3D12RenderGraphBackend::BeginFrame(D3D12CommandList* cmdList, UINT64 completedFenceValue, UINT64 retireFenceValue)
+{
+    this->cmdList = cmdList;
+    this->retireFenceValue = retireFenceValue;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < retired.size(); ++i)
+        if (retired[i].fenceValue > completedFenceValue)
+            retired[kept++] = std::move(retired[i]);
+    retired.resize(kept);
+}
+
+ID3D12Resource* D3D12RenderGraphBackend::GetResource(const RenderGraph& graph, RGResourceHandle handle) const
+{
+    if (graph.IsImported(handle.index))
+        return static_cast<ID3D12Resource*>(graph.GetExternal(handle.index));
+    if (handle.index >= bindings.size() || bindings[handle.index] < 0)
+        return nullptr;
+    return cache[bindings[handle.index]].resource.Get();
+}
+
+uint64_t D3D12RenderGraphBackend::GetResourceId(const RenderGraph& graph, RGResourceHandle handle) const
+{
+    return reinterpret_cast<uint64_t>(GetResource(graph, handle));
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE D3D12RenderGraphBackend::GetRtv(RGResourceHandle handle) const
+{
+    assert(bindings[handle.index] >= 0 && "Transient is not realized");
+    D3D12_CPU_DESCRIPTOR_HANDLE rtv = rtvHeap->GetCPUDescriptorHandleForHeapStart();
+    rtv.ptr += SIZE_T(cache[bindings[handle.index]].viewIndex) * rtvIncrement;
+    return rtv;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE D3D12RenderGraphBackend::GetDsv(RGResourceHandle handle) const
+{
+    assert(bindings[handle.index] >= 0 && "Transient is not realized");
+    D3D12_CPU_DESCRIPTOR_HANDLE dsv = dsvHeap->GetCPUDescriptorHandleForHeapStart();
+    dsv.ptr += SIZE_T(cache[bindings[handle.index]].viewIndex) * dsvIncrement;
+    return dsv;
+}
+
+void D3D12RenderGraphBackend::GetAllocationInfo(const RGTextureDesc& desc, uint64_t& outSize, uint64_t& outAlignment) const
+{
+    D3D12_RESOURCE_DESC resourceDesc = ToResourceDesc(desc);
+    D3D12_RESOURCE_ALLOCATION_INFO info = device->GetResourceAllocationInfo(0, 1, &resourceDesc);
+    outSize = info.SizeInBytes;
+    outAlignment = info.Alignment;
+}
+
+bool D3D12RenderGraphBackend::RealizeTransients(const RenderGraph& graph)
+{
+    if (!EnsureHeap(graph.GetTransientHeapSize()))
+        return false;
+
+    for (Physical& physical : cache)
+        physical.usedThisFrame = false;
+    bindings.assign(graph.GetResourceCount(), -1);
+
+    // Reuse placed resources that still match exactly
+    for (uint32_t i = 0; i < graph.GetResourceCount(); ++i) {
+        if (!graph.IsTransientLive(i))
+            continue;
+        for (size_t slot = 0; slot < cache.size(); ++slot) {
+            Physical& physical = cache[slot];
+            if (!physical.usedThisFrame && physical.offset == graph.GetTransientOffset(i) && physical.desc == graph.GetDesc(i)) {
+                physical.usedThisFrame = true;
+                bindings[i] = static_cast<int>(slot);
+                break;
+            }
+        }
+    }
+
+    // Drop the rest and compact, remapping bindings
+    std::vector<int> remap(cache.size(), -1);
+    size_t kept = 0;
+    for (size_t slot = 0; slot < cache.size(); ++slot) {
+        if (!cache[slot].usedThisFrame) {
+            ReleasePhysical(cache[slot]);
+            continue;
+        }
+        remap[slot] = static_cast<int>(kept);
+        if (kept != slot)
+            cache[kept] = std::move(cache[slot]);
+        ++kept;
+    }
+    cache.resize(kept);
+    for (int& binding : bindings)
+        if (binding >= 0)
+            binding = remap[binding];
+
+    for (uint32_t i = 0; i < graph.GetResourceCount(); ++i) {
+        if (!graph.IsTransientLive(i) || bindings[i] >= 0)
+            continue;
+        bindings[i] = CreatePhysical(graph.GetDesc(i), graph.GetTransientOffset(i));
+        if (bindings[i] < 0)
+            return false;
+    }
+
+    for (uint32_t i = 0; i < graph.GetResourceCount(); ++i) {
+        if (bindings[i] < 0)
+            continue;
+        const Physical& physical = cache[bindings[i]];
+        RHIResourceId id = D3D12CommandList::ToId(physical.resource.Get());
+        cmdList->RegisterView(id, physical.desc.isDepth ? GetDsv({ i }) : GetRtv({ i }));
+    }
+    return true;
+}
+
+void D3D12RenderGraphBackend::SubmitBarriers(const RenderGraph& graph, const RGBarrier* barriers, size_t count)
+{
+    scratch.clear();
+    for (size_t i = 0; i < count; ++i) {
+        const RGBarrier& barrier = barriers[i];
+        RHIBarrier rhiBarrier;
+        rhiBarrier.resource = GetResourceId(graph, { barrier.resource });
+
+        switch (barrier.type) {
+        case RGBarrierType::Transition: {
+            // Transients track their own state across frames; imported resources state it explicitly
+            Physical* physical = graph.IsImported(barrier.resource) ? nullptr : &cache[bindings[barrier.resource]];
+            rhiBarrier.type = RHIBarrierType::Transition;
+            rhiBarrier.before = (barrier.before == RGState::Undefined && physical) ? physical->state : barrier.before;
+            rhiBarrier.after = barrier.after;
+            if (physical)
+                physical->state = barrier.after;
+            if (rhiBarrier.before == rhiBarrier.after)
+                continue;
+            break;
+        }
+        case RGBarrierType::Aliasing:
+            rhiBarrier.type = RHIBarrierType::Aliasing;
+            rhiBarrier.aliasBefore = barrier.aliasBefore != ~0u ? GetResourceId(graph, { barrier.aliasBefore }) : RHI_NULL_RESOURCE;
+            break;
+        case RGBarrierType::UAV:
+            rhiBarrier.type = RHIBarrierType::UAV;
+            break;
+        }
+        scratch.push_back(rhiBarrier);
+    }
+
+    if (!scratch.empty())
+        cmdList->Barriers(scratch.data(), static_cast<uint32_t>(scratch.size()));
+}
+
+D3D12_RESOURCE_DESC D3D12RenderGraphBackend::ToResourceDesc(const RGTextureDesc& desc)
+{
+    D3D12_RESOURCE_DESC resourceDesc = {};
+    resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    resourceDesc.Width = desc.width;
+    resourceDesc.Height = desc.height;
+    resourceDesc.DepthOrArraySize = 1;
+    resourceDesc.MipLevels = 1;
+    resourceDesc.Format = static_cast<DXGI_FORMAT>(desc.format);
+    resourceDesc.SampleDesc.Count = 1;
+    resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    resourceDesc.Flags = desc.isDepth ? D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL : D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+    return resourceDesc;
+}
+
+int D3D12RenderGraphBackend::CreatePhysical(const RGTextureDesc& desc, UINT64 offset)
+{
+    if (freeViews.empty()) {
+        assert(false && "Out of transient render target views");
+        return -1;
+    }
+
+    Physical physical;
+    physical.desc = desc;
+    physical.offset = offset;
+    physical.state = desc.isDepth ? RGState::DepthWrite : RGState::RenderTarget;
+
+    D3D12_RESOURCE_DESC resourceDesc = ToResourceDesc(desc);
+    D3D12_CLEAR_VALUE clearValue = {};
+    clearValue.Format = resourceDesc.Format;
+    if (desc.isDepth) {
+        clearValue.DepthStencil.Depth = desc.clearValue[0];
+    }
+    else {
+        for (int i = 0; i < 4; ++i)
+            clearValue.Color[i] = desc.clearValue[i];
+    }
+
+    if (FAILED(device->CreatePlacedResource(heap.Get(), offset, &resourceDesc, D3D12CommandList::ToResourceStates(physical.state), &clearValue, IID_PPV_ARGS(&physical.resource))))
+        return -1;
+
+    physical.viewIndex = freeViews.back();
+    freeViews.pop_back();
+    if (desc.isDepth) {
+        D3D12_CPU_DESCRIPTOR_HANDLE dsv = dsvHeap->GetCPUDescriptorHandleForHeapStart();
+        dsv.ptr += SIZE_T(physical.viewIndex) * dsvIncrement;
+        device->CreateDepthStencilView(physical.resource.Get(), nullptr, dsv);
+    }
+    else {
+        D3D12_CPU_DESCRIPTOR_HANDLE rtv = rtvHeap->GetCPUDescriptorHandleForHeapStart();
+        rtv.ptr += SIZE_T(physical.viewIndex) * rtvIncrement;
+        device->CreateRenderTargetView(physical.resource.Get(), nullptr, rtv);
+    }
+
+    physical.usedThisFrame = true;
+    cache.push_back(std::move(physical));
+    return static_cast<int>(cache.size() - 1);
+}
+
+void D3D12RenderGraphBackend::ReleasePhysical(Physical& physical)
+{
+    // Views are CPU-only and already copied into recorded lists, so they free immediately
+    freeViews.push_back(physical.viewIndex);
+    Retire(physical.resource);
+    physical.resource.Reset();
+}
+
+void D3D12RenderGraphBackend::Retire(ComPtr<ID3D12Pageable> object)
+{
+    if (object)
+        retired.push_back({ std::move(object), retireFenceValue });
+}
+
+bool D3D12RenderGraphBackend::EnsureHeap(UINT64 size)
+{
+    if (size <= heapSize)
+        return true;
+
+    for (Physical& physical : cache)
+        ReleasePhysical(physical);
+    cache.clear();
+    Retire(heap);
+    heap.Reset();
+
+    D3D12_HEAP_DESC desc = {};
+    desc.SizeInBytes = (size + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) & ~UINT64(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1);
+    desc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+    desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+    if (FAILED(device->CreateHeap(&desc, IID_PPV_ARGS(&heap)))) {
+        heapSize = 0;
+        return false;
+    }
+
+    heapSize = desc.SizeInBytes;
+    return true;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <vector>
+#include "RenderGraph.h"
+#include "RHID3D12.h"
+
+using namespace Microsoft::WRL;
+
+// Backs render graph transients with placed resources in one shared heap and
+// turns graph barriers into RHI barrier batches on the frame's D3D12CommandList.
+// Placed resources are cached across frames while their desc and offset stay the
+// same; anything replaced is kept alive until the frame that last used it retires.
+class D3D12RenderGraphBackend : public IRenderGraphBackend {
+public:
+    static constexpr UINT MAX_TRANSIENT_VIEWS = 32;
+
+    bool Create(ID3D12Device* device);
+    void Destroy();
+
+    // 'retireFenceValue' is the fence the current frame will signal.
+    // Realized transients register their RTV/DSV with 'cmdList' so passes can bind them by id.
+    void BeginFrame(D3D12CommandList* cmdList, UINT64 completedFenceValue, UINT64 retireFenceValue);
+
+    ID3D12Resource* GetResource(const RenderGraph& graph, RGResourceHandle handle) const;
+    D3D12_CPU_DESCRIPTOR_HANDLE GetRtv(RGResourceHandle handle) const;
+    D3D12_CPU_DESCRIPTOR_HANDLE GetDsv(RGResourceHandle handle) const;
+    UINT64 GetHeapSize() const { return heapSize; }
+
+    void GetAllocationInfo(const RGTextureDesc& desc, uint64_t& outSize, uint64_t& outAlignment) const override;
+    bool RealizeTransients(const RenderGraph& graph) override;
+    void SubmitBarriers(const RenderGraph& graph, const RGBarrier* barriers, size_t count) override;
+    uint64_t GetResourceId(const RenderGraph& graph, RGResourceHandle handle) const override;
+
+private:
+    struct Physical {
+        ComPtr<ID3D12Resource> resource;
+        RGTextureDesc desc;
+        UINT64 offset = 0;
+        RGState state = RGState::Undefined;
+        UINT viewIndex = 0;
+        bool usedThisFrame = false;
+    };
+
+    struct Retired {
+        ComPtr<ID3D12Pageable> object;
+        UINT64 fenceValue = 0;
+    };
+
+    static D3D12_RESOURCE_DESC ToResourceDesc(const RGTextureDesc& desc);
+
+    int CreatePhysical(const RGTextureDesc& desc, UINT64 offset);
+    void ReleasePhysical(Physical& physical);
+    void Retire(ComPtr<ID3D12Pageable> object);
+    bool EnsureHeap(UINT64 size);
+
+    ID3D12Device* device = nullptr;
+    D3D12CommandList* cmdList = nullptr;
+    UINT64 retireFenceValue = 0;
+
+    ComPtr<ID3D12Heap> heap;
+    UINT64 heapSize = 0;
+
+    ComPtr<ID3D12DescriptorHeap> rtvHeap;
+    ComPtr<ID3D12DescriptorHeap> dsvHeap;
+    UINT rtvIncrement = 0;
+    UINT dsvIncrement = 0;
+    std::vector<UINT> freeViews;
+
+    std::vector<Physical> cache;
+    std::vector<int> bindings;  // graph resource index -> cache slot, -1 if none
+    std::vector<Retired> retired;
+    std::vector<RHIBarrier> scratch;
+};
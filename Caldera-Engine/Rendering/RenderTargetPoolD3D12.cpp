@@ -0,0 +1,97 @@
+#include "RenderTargetPoolD3D12.h"
+#include "GpuMemory.h"
+#include "RHID3D12.h"
+#include <cassert>
+
+void D3D12RenderTargetPool::Initialize(GpuMemory* gpuMemory)
+{
+    assert(gpuMemory && "GPU memory is null");
+    this->gpuMemory = gpuMemory;
+    entries.clear();
+    completedFenceValue = 0;
+    frameNumber = 0;
+    createdCount = 0;
+    reusedCount = 0;
+}
+
+void D3D12RenderTargetPool::Destroy()
+{
+    if (!gpuMemory)
+        return;
+    for (Entry& entry : entries)
+        gpuMemory->ReleaseResource(entry.texture);
+    entries.clear();
+    gpuMemory = nullptr;
+}
+
+void D3D12RenderTargetPool::BeginFrame(UINT64 completedFenceValue, uint64_t frameNumber)
+{
+    this->completedFenceValue = completedFenceValue;
+    this->frameNumber = frameNumber;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        Entry& entry = entries[i];
+        if (entry.retireFenceValue <= completedFenceValue && frameNumber - entry.releasedFrame > MAX_IDLE_FRAMES) {
+            gpuMemory->ReleaseResource(entry.texture);
+            continue;
+        }
+        if (kept != i)
+            entries[kept] = std::move(entry);
+        ++kept;
+    }
+    entries.resize(kept);
+}
+
+ComPtr<ID3D12Resource> D3D12RenderTargetPool::Acquire(const RGTextureDesc& desc, RGState state)
+{
+    for (size_t i = 0; i < entries.size(); ++i) {
+        Entry& entry = entries[i];
+        if (entry.retireFenceValue > completedFenceValue || entry.state != state || !(entry.desc == desc))
+            continue;
+        ComPtr<ID3D12Resource> texture = std::move(entry.texture);
+        entries.erase(entries.begin() + i);
+        ++reusedCount;
+        return texture;
+    }
+
+    D3D12_RESOURCE_DESC resourceDesc = {};
+    resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    resourceDesc.Width = desc.width;
+    resourceDesc.Height = desc.height;
+    resourceDesc.DepthOrArraySize = 1;
+    resourceDesc.MipLevels = 1;
+    resourceDesc.Format = static_cast<DXGI_FORMAT>(desc.format);
+    resourceDesc.SampleDesc.Count = 1;
+    resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    resourceDesc.Flags = desc.isDepth ? D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL : D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+
+    D3D12_CLEAR_VALUE clearValue = {};
+    clearValue.Format = resourceDesc.Format;
+    if (desc.isDepth) {
+        clearValue.DepthStencil.Depth = desc.clearValue[0];
+    }
+    else {
+        for (int i = 0; i < 4; ++i)
+            clearValue.Color[i] = desc.clearValue[i];
+    }
+
+    ComPtr<ID3D12Resource> texture;
+    if (FAILED(gpuMemory->CreateResource(D3D12_HEAP_TYPE_DEFAULT, &resourceDesc, D3D12CommandList::ToResourceStates(state), &clearValue, texture)))
+        return nullptr;
+    ++createdCount;
+    return texture;
+}
+
+void D3D12RenderTargetPool::Release(ComPtr<ID3D12Resource>& texture, const RGTextureDesc& desc, RGState state, UINT64 retireFenceValue)
+{
+    if (!texture)
+        return;
+    Entry entry;
+    entry.texture = std::move(texture);
+    entry.desc = desc;
+    entry.state = state;
+    entry.retireFenceValue = retireFenceValue;
+    entry.releasedFrame = frameNumber;
+    entries.push_back(std::move(entry));
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <vector>
+#include "RenderGraph.h"
+
+using namespace Microsoft::WRL;
+
+class GpuMemory;
+
+// Render and depth targets that outlive a frame (unlike render graph transients)
+// and are recycled by exact desc. A released texture waits for its retire fence
+// before it can be handed out again, and is freed once it has sat unused for
+// MAX_IDLE_FRAMES, so a panel dragged back and forth reuses its old targets.
+class D3D12RenderTargetPool {
+public:
+    static constexpr uint64_t MAX_IDLE_FRAMES = 240;
+
+    void Initialize(GpuMemory* gpuMemory);
+    // Caller has already waited for the GPU.
+    void Destroy();
+
+    // Retires idle textures. 'completedFenceValue' decides which releases are reusable.
+    void BeginFrame(UINT64 completedFenceValue, uint64_t frameNumber);
+
+    // A pooled texture with exactly 'desc' resting in 'state', or a new one.
+    // Null if the texture could not be created.
+    ComPtr<ID3D12Resource> Acquire(const RGTextureDesc& desc, RGState state);
+    // The texture must be back in 'state' by the time 'retireFenceValue' is reached.
+    void Release(ComPtr<ID3D12Resource>& texture, const RGTextureDesc& desc, RGState state, UINT64 retireFenceValue);
+
+    uint32_t GetPooledCount() const { return static_cast<uint32_t>(entries.size()); }
+    uint32_t GetCreatedCount() const { return createdCount; }
+    uint32_t GetReusedCount() const { return reusedCount; }
+
+private:
+    struct Entry {
+        ComPtr<ID3D12Resource> texture;
+        RGTextureDesc desc;
+        RGState state = RGState::Undefined;
+        UINT64 retireFenceValue = 0;
+        uint64_t releasedFrame = 0;
+    };
+
+    GpuMemory* gpuMemory = nullptr;
+    std::vector<Entry> entries;
+    UINT64 completedFenceValue = 0;
+    uint64_t frameNumber = 0;
+    uint32_t createdCount = 0;
+    uint32_t reusedCount = 0;
+};
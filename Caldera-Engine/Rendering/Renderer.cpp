@@ -2,16 +2,12 @@
 #include "imconfig.h"
 #include <dxgidebug.h>
 #include <cassert>
-#include <d3dcompiler.h>
 #include "d3dx12.h"
-#pragma comment(lib, "d3dcompiler.lib")
 
 using Microsoft::WRL::ComPtr;
 
 Renderer::Renderer()
-    : frameIndex(0),
-    fenceValue(0),
-    swapChainWaitableObject(nullptr)
+    : backBufferIndex(0)
 {
     for (auto& handle : rtvHandles)
         handle.ptr = 0;
@@ -20,8 +16,12 @@ Renderer::Renderer()
 
 bool Renderer::Initialize(HWND hwnd) {
     if (!CreateDevice(hwnd)) return false;
-
-    srvAllocator.Create(device.Get(), srvHeap.Get());
+    rhiCommandList.Initialize(device.Get(), srvAllocator.GetHeap());
+    taskPool.Initialize();
+    parallelRecorder.Initialize(&taskPool, &secondaryLists);
+    drawList.Initialize(&taskPool);
+    frustumCuller.Initialize(&taskPool);
+    occlusionCuller.Initialize(&taskPool);
 
     // ImGui setup
     IMGUI_CHECKVERSION();
@@ -52,10 +52,10 @@ bool Renderer::Initialize(HWND hwnd) {
 
     ImGui_ImplDX12_InitInfo init_info = {};
     init_info.Device = device.Get();
-    init_info.CommandQueue = commandQueue.Get();
+    init_info.CommandQueue = GetCommandQueue();
     init_info.NumFramesInFlight = NUM_FRAMES_IN_FLIGHT;
     init_info.RTVFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
-    init_info.SrvDescriptorHeap = srvHeap.Get();
+    init_info.SrvDescriptorHeap = srvAllocator.GetHeap();
     init_info.UserData = this;
 
     init_info.SrvDescriptorAllocFn = [](ImGui_ImplDX12_InitInfo* info, D3D12_CPU_DESCRIPTOR_HANDLE* cpu, D3D12_GPU_DESCRIPTOR_HANDLE* gpu) {
@@ -65,11 +65,40 @@ bool Renderer::Initialize(HWND hwnd) {
 
     init_info.SrvDescriptorFreeFn = [](ImGui_ImplDX12_InitInfo* info, D3D12_CPU_DESCRIPTOR_HANDLE cpu, D3D12_GPU_DESCRIPTOR_HANDLE gpu) {
         Renderer* self = reinterpret_cast<Renderer*>(info->UserData);
-        self->srvAllocator.Free(cpu, gpu);
+        self->srvAllocator.Free(cpu, gpu, self->GetRetireFenceValue());
         };
 
 	CreateDefaultResources();
 
+    // Pipelines compile on the cache's thread, through the on-disk library
+    pipelineCompiler.Create(device.Get(), PIPELINE_LIBRARY_PATH);
+    pipelineCache.Initialize(&pipelineCompiler, &taskPool.GetJobSystem());
+
+    // Without DXC only shaders already in the cache can load
+    IShaderCompiler* compiler = shaderCompiler.Create() ? &shaderCompiler : nullptr;
+    if (!compiler)
+        OutputDebugStringA("DXC is unavailable; shaders load from the cache only\n");
+    shaderLibrary.Initialize(compiler, SHADER_CACHE_DIRECTORY, { SHADER_SOURCE_DIRECTORY });
+    lastShaderPoll = std::chrono::steady_clock::now();
+    CreateGraphicsPipeline();
+    // Everything the last run used, queued behind the scene pipeline
+    pipelineCache.Warmup(PIPELINE_LIST_PATH);
+
+    // GPU-driven scene path; the scene's renderables become its objects every frame
+    cullShader = shaderLibrary.Load({ std::string(SHADER_SOURCE_DIRECTORY) + "/GpuCull.hlsl", "CSMain", "cs_6_0", {} });
+    if (!cullShader.IsValid())
+        OutputDebugStringA(shaderLibrary.GetLastError().c_str());
+    if (scenePipeline.rootSignature && cullShader.IsValid() &&
+        gpuCuller.Create(device.Get(), &gpuMemory, scenePipeline, shaderLibrary.GetBytecode(cullShader),
+            MAX_GPU_DRIVEN_OBJECTS, NUM_FRAMES_IN_FLIGHT, SRV_HEAP_PERSISTENT_CAPACITY))
+        gpuDrivenScene = true;
+
+    // Shown until the scene submits anything
+    const float center[3] = { 0.0f, 0.0f, 0.0f };
+    const float extents[3] = { 0.5f, 0.5f, 0.5f };
+    defaultBounds.Add(center, extents, 0.8660254f); // half the cube's diagonal
+    defaultRenderables.push_back(Renderable());
+
     ImGui_ImplDX12_Init(&init_info);
     return true;
 }
@@ -77,47 +106,44 @@ bool Renderer::Initialize(HWND hwnd) {
 
 void Renderer::BeginFrame()
 {
-    // Wait for previous frame and reset command allocator
+    // Blocks until the latency mode lets another frame start; input is sampled after this
+    framePacer.BeginFrame();
+
+    // Wait until this frame's slot has retired and reset its command allocator
     FrameContext* frameCtx = WaitForNextFrame();
     frameCtx->commandAllocator->Reset();
 
+    // The slot's previous frame has retired, so its GPU time is readable without stalling
+    const float frameMs = gpuFrameTimer.ReadFrameMs(frameSlot);
+    if (frameMs > 0.0f)
+        gpuFrameMs = frameMs;
+    if (dynamicResolution && resolutionController.Update(frameMs))
+        sceneTargetSizer.SetRenderScale(resolutionController.GetScale());
+
+    // Release staging memory of uploads the copy queue has finished
+    uploadQueue.Collect();
+
+    // Recycle descriptors freed by retired frames and rewind this frame's transient window
+    srvAllocator.BeginFrame(frameSlot, gpuTimeline.GetCompletedValue(QueueType::Graphics));
+
     // Get current back buffer index and reset command list
-    frameIndex = swapChain->GetCurrentBackBufferIndex();
+    backBufferIndex = swapChain->GetCurrentBackBufferIndex();
     commandList->Reset(frameCtx->commandAllocator.Get(), nullptr);
+    rhiCommandList.Begin(commandList.Get());
+    secondaryLists.BeginFrame(frameSlot, &rhiCommandList);
+    gpuFrameTimer.BeginFrame(commandList.Get(), frameSlot);
 
-    // Transition the back buffer from present to render target
-    D3D12_RESOURCE_BARRIER barrier = {};
-    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    barrier.Transition.pResource = renderTargets[frameIndex].Get();
-    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
-    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
-    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-    commandList->ResourceBarrier(1, &barrier);
-
-    // Set render target and clear it
-    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = rtvHandles[frameIndex];
-    D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = {}; // Add depth stencil view handle when implemented
-    commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr); // Replace nullptr with &dsvHandle when depth is added
-
-    // Clear the render target with a dark gray color
-    const float clearColor[] = { 0.1f, 0.1f, 0.1f, 1.0f };
-    commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-
-    if (dsvHandle.ptr != 0)
-    {
-        // Clear depth buffer (when implemented)
-        commandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
-    }
-
-    // Set viewport and scissor rect
-    D3D12_VIEWPORT viewport = { 0.0f, 0.0f, viewportWidth, viewportHeight, 0.0f, 1.0f };
-    D3D12_RECT scissorRect = { 0, 0, (LONG)viewportWidth, (LONG)viewportHeight };
+    // Last frame's relocations are queued ahead of this one, so owners switch now;
+    // then this frame's share of compaction goes at the front of its list
+    if (gpuMemory.IsDefragmenting())
+        gpuMemory.FinishDefragmentation([this](std::function<void()> release) { frameLifecycle.DeferRelease(std::move(release)); });
+    gpuMemory.Defragment(commandList.Get(), DEFRAG_BYTES_PER_FRAME);
 
-    commandList->RSSetViewports(1, &viewport);
-    commandList->RSSetScissorRects(1, &scissorRect);
+    // Transient render targets replaced by the previous graphs can go once their frames retire
+    graphBackend.BeginFrame(&rhiCommandList, gpuTimeline.GetCompletedValue(QueueType::Graphics), GetRetireFenceValue());
+    renderTargetPool.BeginFrame(gpuTimeline.GetCompletedValue(QueueType::Graphics), frameLifecycle.GetFrameNumber());
 
-    // Render 3D scene
-    RenderScene();
+    ReloadChangedShaders();
 
     // Begin ImGui frame
     ImGui_ImplDX12_NewFrame();
@@ -130,80 +156,103 @@ void Renderer::CreateGraphicsPipeline()
 {
     // Create root signature
     {
+        // One table over the whole persistent range of the SRV heap. Textures and
+        // buffers alias the same descriptors from different register spaces.
+        D3D12_DESCRIPTOR_RANGE ranges[2] = {};
+        ranges[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+        ranges[0].NumDescriptors = SRV_HEAP_PERSISTENT_CAPACITY;
+        ranges[0].BaseShaderRegister = 0;
+        ranges[0].RegisterSpace = 1;
+        ranges[0].OffsetInDescriptorsFromTableStart = 0;
+        ranges[1] = ranges[0];
+        ranges[1].RegisterSpace = 2;
+
+        D3D12_ROOT_PARAMETER rootParams[2] = {};
+        rootParams[SCENE_ROOT_DRAW_CONSTANTS].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+        rootParams[SCENE_ROOT_DRAW_CONSTANTS].Constants.ShaderRegister = 0;
+        rootParams[SCENE_ROOT_DRAW_CONSTANTS].Constants.Num32BitValues = 2;
+        rootParams[SCENE_ROOT_DRAW_CONSTANTS].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+        rootParams[SCENE_ROOT_BINDLESS_TABLE].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+        rootParams[SCENE_ROOT_BINDLESS_TABLE].DescriptorTable.NumDescriptorRanges = _countof(ranges);
+        rootParams[SCENE_ROOT_BINDLESS_TABLE].DescriptorTable.pDescriptorRanges = ranges;
+        rootParams[SCENE_ROOT_BINDLESS_TABLE].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+        CD3DX12_STATIC_SAMPLER_DESC sampler(0, D3D12_FILTER_MIN_MAG_MIP_LINEAR);
+        sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
         D3D12_ROOT_SIGNATURE_DESC rootSignatureDesc = {};
-        rootSignatureDesc.NumParameters = 0;  // We'll add parameters later for transformations
-        rootSignatureDesc.NumStaticSamplers = 0;
+        rootSignatureDesc.NumParameters = _countof(rootParams);
+        rootSignatureDesc.pParameters = rootParams;
+        rootSignatureDesc.NumStaticSamplers = 1;
+        rootSignatureDesc.pStaticSamplers = &sampler;
         rootSignatureDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
         ComPtr<ID3DBlob> signature;
         ComPtr<ID3DBlob> error;
-        D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error);
-        device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&rootSignature));
+        if (FAILED(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error))) {
+            if (error)
+                OutputDebugStringA((const char*)error->GetBufferPointer());
+            return;
+        }
+        if (FAILED(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&scenePipeline.rootSignature))))
+            return;
+        sceneRootSignatureId = D3D12PipelineCompiler::GetRootSignatureId(signature.Get());
+        pipelineCompiler.RegisterRootSignature(sceneRootSignatureId, scenePipeline.rootSignature);
     }
 
     // Create the pipeline state
     {
-        // Define the vertex input layout
-        D3D12_INPUT_ELEMENT_DESC inputElementDescs[] = {
-            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-            { "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
-        };
-
-        // Create basic shaders
-        const char* vertexShader = R"(
-            struct VSInput {
-                float3 position : POSITION;
-                float3 color : COLOR;
-            };
-            struct PSInput {
-                float4 position : SV_POSITION;
-                float3 color : COLOR;
-            };
-            PSInput main(VSInput input) {
-                PSInput output;
-                output.position = float4(input.position, 1.0f);
-                output.color = input.color;
-                return output;
-            }
-        )";
-
-        const char* pixelShader = R"(
-            struct PSInput {
-                float4 position : SV_POSITION;
-                float3 color : COLOR;
-            };
-            float4 main(PSInput input) : SV_TARGET {
-                return float4(input.color, 1.0f);
-            }
-        )";
-
-        ComPtr<ID3DBlob> vertexShaderBlob;
-        ComPtr<ID3DBlob> pixelShaderBlob;
-        ComPtr<ID3DBlob> errorBlob;
-
-        D3DCompile(vertexShader, strlen(vertexShader), nullptr, nullptr, nullptr, "main", "vs_5_0", 0, 0, &vertexShaderBlob, &errorBlob);
-        D3DCompile(pixelShader, strlen(pixelShader), nullptr, nullptr, nullptr, "main", "ps_5_0", 0, 0, &pixelShaderBlob, &errorBlob);
-
-        // Create pipeline state object
-        D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
-        psoDesc.InputLayout = { inputElementDescs, _countof(inputElementDescs) };
-        psoDesc.pRootSignature = rootSignature.Get();
-        psoDesc.VS = { vertexShaderBlob->GetBufferPointer(), vertexShaderBlob->GetBufferSize() };
-        psoDesc.PS = { pixelShaderBlob->GetBufferPointer(), pixelShaderBlob->GetBufferSize() };
-        psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
-        psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
-        psoDesc.DepthStencilState.DepthEnable = FALSE;
-        psoDesc.DepthStencilState.StencilEnable = FALSE;
-        psoDesc.SampleMask = UINT_MAX;
-        psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-        psoDesc.NumRenderTargets = 1;
-        psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
-        psoDesc.SampleDesc.Count = 1;
-
-        device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&pipelineState));
+        const std::string sceneShader = std::string(SHADER_SOURCE_DIRECTORY) + "/Scene.hlsl";
+        sceneVertexShader = shaderLibrary.Load({ sceneShader, "VSMain", "vs_6_0", {} });
+        scenePixelShader = shaderLibrary.Load({ sceneShader, "PSMain", "ps_6_0", {} });
+        if (!sceneVertexShader.IsValid() || !scenePixelShader.IsValid()) {
+            OutputDebugStringA(shaderLibrary.GetLastError().c_str());
+            return;
+        }
+        RequestScenePipeline();
     }
 }
 
+void Renderer::RequestScenePipeline()
+{
+    // The cache compiles it in the background; frames keep the current PSO, or
+    // skip the scene, until it is ready
+    PipelineStateDesc psoDesc;
+    psoDesc.rootSignature = sceneRootSignatureId;
+    psoDesc.vs = shaderLibrary.GetBytecode(sceneVertexShader);
+    psoDesc.ps = shaderLibrary.GetBytecode(scenePixelShader);
+    psoDesc.inputLayout = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, false },
+        { "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, false }
+    };
+    psoDesc.depthFormat = DXGI_FORMAT_D32_FLOAT;
+    psoDesc.topology = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    psoDesc.renderTargetCount = 1;
+    psoDesc.renderTargetFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+
+    scenePipelineHandle = pipelineCache.Request("Scene", psoDesc);
+}
+
+void Renderer::ReloadChangedShaders()
+{
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastShaderPoll < std::chrono::milliseconds(SHADER_POLL_INTERVAL_MS))
+        return;
+    lastShaderPoll = now;
+
+    // A shader that fails to rebuild keeps running with its old bytecode
+    uint32_t failures = shaderLibrary.GetStats().failures;
+    bool sceneChanged = false;
+    for (ShaderHandle handle : shaderLibrary.PollChanges())
+        sceneChanged |= handle.index == sceneVertexShader.index || handle.index == scenePixelShader.index;
+    if (shaderLibrary.GetStats().failures != failures)
+        OutputDebugStringA(shaderLibrary.GetLastError().c_str());
+
+    // The culling pipeline is built once by the culler; edits to it apply on the next launch
+    if (sceneChanged && scenePipeline.rootSignature)
+        RequestScenePipeline();
+}
+
 void Renderer::HandleResize(HWND hwnd, UINT width, UINT height) {
     float dpiScale = ImGui_ImplWin32_GetDpiScaleForMonitor(MonitorFromWindow(hwnd, MONITOR_DEFAULTTONEAREST));
 
@@ -224,75 +273,255 @@ void Renderer::HandleResize(HWND hwnd, UINT width, UINT height) {
 
 void Renderer::EndFrame() {
     ImGui::Render();
-    commandList->SetDescriptorHeaps(1, srvHeap.GetAddressOf());
-    ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), commandList.Get());
+
+    // The frame graph records the scene and UI and owns every barrier on the back buffer
+    BuildFrameGraph();
+    bool compiled = frameGraph.Compile(&graphBackend);
+    IM_ASSERT(compiled && "Frame graph failed to compile");
+    if (compiled)
+        frameGraph.Execute(graphBackend);
 
     ImGuiIO& io = ImGui::GetIO();
     if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
         ImGui::UpdatePlatformWindows();
-        ImGui::RenderPlatformWindowsDefault(nullptr, (void*)commandList.Get()); // Must happen before Close()
+        ImGui::RenderPlatformWindowsDefault(nullptr, (void*)rhiCommandList.GetNative()); // Must happen before Close()
     }
 
-    D3D12_RESOURCE_BARRIER barrier = {};
-    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    barrier.Transition.pResource = renderTargets[frameIndex].Get();
-    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
-    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
-    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-    commandList->ResourceBarrier(1, &barrier);
+    // The primary list at this point is the last one the frame submits
+    gpuFrameTimer.EndFrame(rhiCommandList.GetNative(), frameSlot);
+
+    // Primary segments and worker lists, in recording order
+    submitLists.clear();
+    secondaryLists.Close(submitLists);
+
+    // Uploads submitted during this frame must land before the frame executes
+    if (uploadQueue.IsOpen())
+        WaitOnGraphics(uploadQueue.Submit());
+    queueScheduler.FlushWaits(QueueType::Graphics);
 
-    commandList->Close();
-    ID3D12CommandList* lists[] = { commandList.Get() };
-    commandQueue->ExecuteCommandLists(1, lists);
+    GetCommandQueue()->ExecuteCommandLists(static_cast<UINT>(submitLists.size()), submitLists.data());
 
-    swapChain->Present(1, 0);
-    fenceValue++;
-    commandQueue->Signal(fence.Get(), fenceValue);
-    frameContexts[frameIndex].fenceValue = fenceValue;
+    PresentParams present = framePacer.GetPresentParams();
+    swapChain->Present(present.syncInterval, present.allowTearing ? DXGI_PRESENT_ALLOW_TEARING : 0);
+    SyncPoint frameDone = queueScheduler.Submit(QueueType::Graphics);
+    frameLifecycle.EndFrame(frameDone);
+    framePacer.EndFrame(frameDone);
 
 }
 
 void Renderer::Shutdown() {
+    if (device && GetCommandQueue()) {
+        uploadQueue.Destroy();
+        queueScheduler.WaitIdle();
+        frameLifecycle.Shutdown();
+    }
+
     ImGui_ImplDX12_Shutdown();
     ImGui_ImplWin32_Shutdown();
     ImGui::DestroyPlatformWindows();
     ImGui::DestroyContext();
 
     CleanupRenderTargets();
-    CloseHandle(fenceEvent);
+
+    gpuMemory.ReleaseResource(vertexBuffer);
+    gpuMemory.ReleaseResource(indexBuffer);
+    gpuMemory.ReleaseResource(materialBuffer);
+    gpuMemory.ReleaseResource(instanceBuffer);
+    gpuMemory.ReleaseResource(sceneColor);
+    gpuMemory.ReleaseResource(sceneDepth);
+    renderTargetPool.Destroy();
+    gpuFrameTimer.Destroy();
+    pipelineCache.SaveRecordedList(PIPELINE_LIST_PATH);
+    pipelineCache.Shutdown();
+    pipelineCompiler.Destroy();
+    graphBackend.Destroy();
+    gpuCuller.Destroy();
+    secondaryLists.Destroy();
+    taskPool.Shutdown();
+    gpuMemory.Destroy();
+    bindlessTable.Shutdown();
+    srvAllocator.Destroy();
+    latencyWaiter.Destroy();
+    gpuTimeline.Destroy();
+}
+
+ID3D12GraphicsCommandList* Renderer::BeginUploadBatch()
+{
+    return uploadQueue.Begin();
+}
+
+void Renderer::KeepUploadAlive(ComPtr<ID3D12Resource> resource)
+{
+    uploadQueue.KeepAlive(std::move(resource));
+}
+
+SyncPoint Renderer::SubmitUploadBatch()
+{
+    return uploadQueue.Submit();
+}
+
+SyncPoint Renderer::SubmitCompute(ID3D12CommandList* list)
+{
+    queueScheduler.FlushWaits(QueueType::Compute);
+    GetComputeQueue()->ExecuteCommandLists(1, &list);
+    return queueScheduler.Submit(QueueType::Compute);
+}
+
+void Renderer::WaitOnGraphics(SyncPoint point)
+{
+    queueScheduler.WaitOn(QueueType::Graphics, point);
 }
 
 UINT Renderer::AllocateDescriptor()
 {
-    if (currentDescriptorIndex >= maxDescriptors) {
-        // Handle descriptor heap overflow - you might want to create a new heap
-        // For now, wrap around to the beginning
-        currentDescriptorIndex = 0;
-    }
-    return currentDescriptorIndex++;
+    return srvAllocator.Alloc();
+}
+
+void Renderer::FreeDescriptor(UINT index)
+{
+    srvAllocator.Free(index, GetRetireFenceValue());
+}
+
+BindlessHandle Renderer::RegisterBindlessTexture(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc)
+{
+    BindlessHandle handle = bindlessTable.Allocate(BindlessResourceType::Texture);
+    if (handle.IsValid())
+        device->CreateShaderResourceView(resource, srvDesc, srvAllocator.GetCpuHandle(handle.index));
+    return handle;
+}
+
+BindlessHandle Renderer::RegisterBindlessBuffer(ID3D12Resource* resource, UINT numElements, UINT stride)
+{
+    BindlessHandle handle = bindlessTable.Allocate(BindlessResourceType::Buffer);
+    if (!handle.IsValid())
+        return handle;
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+    srvDesc.Buffer.NumElements = numElements;
+    srvDesc.Buffer.StructureByteStride = stride;
+    device->CreateShaderResourceView(resource, &srvDesc, srvAllocator.GetCpuHandle(handle.index));
+    return handle;
+}
+
+void Renderer::ReleaseBindless(BindlessHandle handle)
+{
+    if (!bindlessTable.Release(handle, GetRetireFenceValue()))
+        assert(!handle.IsValid() && "Releasing a stale bindless handle");
 }
 
-ImTextureID Renderer::GetCurrentBackBufferImGui()
+ImTextureID Renderer::GetBindlessTextureID(BindlessHandle handle) const
 {
-    // Get the current back buffer index
-    UINT backBufferIndex = swapChain->GetCurrentBackBufferIndex();
+    if (!bindlessTable.IsValid(handle))
+        return (ImTextureID)0;
+    return (ImTextureID)srvAllocator.GetGpuHandle(handle.index).ptr;
+}
 
-    // Get SRV descriptor handle
-    D3D12_CPU_DESCRIPTOR_HANDLE srvHandle = srvHeap->GetCPUDescriptorHandleForHeapStart();
-    srvHandle.ptr += backBufferIndex * device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+void Renderer::ReleaseResourceDeferred(ComPtr<ID3D12Resource>& resource)
+{
+    if (!resource)
+        return;
+    ComPtr<ID3D12Resource> retired = std::move(resource);
+    frameLifecycle.DeferRelease([this, retired]() mutable { gpuMemory.ReleaseResource(retired); });
+}
+
+UINT64 Renderer::GetRetireFenceValue() const
+{
+    // The frame currently being recorded signals the next graphics fence value
+    return queueScheduler.GetLastSubmitted(QueueType::Graphics).value + 1;
+}
 
-    // Return the descriptor as a texture ID for ImGui
-    return (ImTextureID)srvHeap->GetGPUDescriptorHandleForHeapStart().ptr;
+ImTextureID Renderer::GetSceneTextureID() const
+{
+    return GetBindlessTextureID(sceneColorHandle);
 }
 
 void Renderer::SetViewportSize(float width, float height)
 {
-    if (width != viewportWidth || height != viewportHeight) 
-    {
-        viewportWidth = width;
-        viewportHeight = height;
-        viewportResized = true;
+    // Cheap unless the panel settled on a size the current target can't serve
+    if (sceneTargetSizer.Update(static_cast<UINT>(width), static_cast<UINT>(height)))
+        ResizeSceneTarget();
+    viewportWidth = static_cast<float>(sceneTargetSizer.GetRenderWidth());
+    viewportHeight = static_cast<float>(sceneTargetSizer.GetRenderHeight());
+}
+
+void Renderer::SetDynamicResolution(bool enabled)
+{
+    dynamicResolution = enabled;
+    resolutionController.Reset();
+    sceneTargetSizer.SetRenderScale(resolutionController.GetScale());
+}
+
+void Renderer::ResizeSceneTarget()
+{
+    // The old targets may still be drawn by frames in flight; the pool holds them until they retire
+    const UINT64 retireFenceValue = GetRetireFenceValue();
+    renderTargetPool.Release(sceneColor, sceneColorDesc, RGState::ShaderResource, retireFenceValue);
+    renderTargetPool.Release(sceneDepth, sceneDepthDesc, RGState::DepthWrite, retireFenceValue);
+    if (sceneColorHandle.IsValid())
+        ReleaseBindless(sceneColorHandle);
+    sceneColorHandle = {};
+
+    sceneColorDesc = {};
+    sceneColorDesc.width = sceneTargetSizer.GetTargetWidth();
+    sceneColorDesc.height = sceneTargetSizer.GetTargetHeight();
+    sceneColorDesc.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    for (int i = 0; i < 4; ++i)
+        sceneColorDesc.clearValue[i] = SCENE_CLEAR_COLOR[i];
+    sceneDepthDesc = sceneColorDesc;
+    sceneDepthDesc.format = DXGI_FORMAT_D32_FLOAT;
+    sceneDepthDesc.isDepth = true;
+    sceneDepthDesc.clearValue[0] = 1.0f;
+
+    sceneColor = renderTargetPool.Acquire(sceneColorDesc, RGState::ShaderResource);
+    sceneDepth = renderTargetPool.Acquire(sceneDepthDesc, RGState::DepthWrite);
+    if (!sceneColor || !sceneDepth) {
+        renderTargetPool.Release(sceneColor, sceneColorDesc, RGState::ShaderResource, retireFenceValue);
+        renderTargetPool.Release(sceneDepth, sceneDepthDesc, RGState::DepthWrite, retireFenceValue);
+        return;
+    }
+
+    // RTV/DSV contents are copied when recorded, so the views can be rewritten in place
+    device->CreateRenderTargetView(sceneColor.Get(), nullptr, sceneRtv);
+    device->CreateDepthStencilView(sceneDepth.Get(), nullptr, sceneDsvHeap->GetCPUDescriptorHandleForHeapStart());
+    sceneColorHandle = RegisterBindlessTexture(sceneColor.Get());
+}
+
+// Immutable DEFAULT heap buffer that defragmentation may relocate, filled through
+// the copy queue. 'onMoved' repoints whatever referenced the old buffer.
+bool Renderer::CreateStaticBuffer(const void* data, UINT size, ComPtr<ID3D12Resource>& outBuffer, GpuResourceMovedFn onMoved)
+{
+    D3D12_RESOURCE_DESC bufferDesc = {};
+    bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufferDesc.Width = size;
+    bufferDesc.Height = 1;
+    bufferDesc.DepthOrArraySize = 1;
+    bufferDesc.MipLevels = 1;
+    bufferDesc.Format = DXGI_FORMAT_UNKNOWN;
+    bufferDesc.SampleDesc.Count = 1;
+    bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+    // Buffers in COMMON are promoted to the read state a draw needs and decay back
+    // after each submission, which is where defragmentation expects to find them
+    if (FAILED(gpuMemory.CreateMovableResource(&bufferDesc, D3D12_RESOURCE_STATE_COMMON, outBuffer, std::move(onMoved))))
+        return false;
+
+    ComPtr<ID3D12Resource> staging;
+    if (FAILED(gpuMemory.CreateResource(D3D12_HEAP_TYPE_UPLOAD, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, staging))) {
+        gpuMemory.ReleaseResource(outBuffer);
+        return false;
     }
+    UINT8* mapped;
+    staging->Map(0, nullptr, reinterpret_cast<void**>(&mapped));
+    memcpy(mapped, data, size);
+    staging->Unmap(0, nullptr);
+
+    // The first frame to draw it waits on this batch
+    uploadQueue.Begin()->CopyBufferRegion(outBuffer.Get(), 0, staging.Get(), 0, size);
+    uploadQueue.KeepAlive(std::move(staging));
+    return true;
 }
 
 void Renderer::CreateDefaultResources()
@@ -334,31 +563,10 @@ void Renderer::CreateDefaultResources()
     // Create vertex buffer
     {
         const UINT vertexBufferSize = sizeof(cubeVertices);
-
-        D3D12_HEAP_PROPERTIES heapProps = { D3D12_HEAP_TYPE_UPLOAD };
-        D3D12_RESOURCE_DESC bufferDesc = {};
-        bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-        bufferDesc.Width = vertexBufferSize;
-        bufferDesc.Height = 1;
-        bufferDesc.DepthOrArraySize = 1;
-        bufferDesc.MipLevels = 1;
-        bufferDesc.Format = DXGI_FORMAT_UNKNOWN;
-        bufferDesc.SampleDesc.Count = 1;
-        bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-
-        device->CreateCommittedResource(
-            &heapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &bufferDesc,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&vertexBuffer));
-
-        // Copy vertex data to the buffer
-        UINT8* pVertexDataBegin;
-        vertexBuffer->Map(0, nullptr, reinterpret_cast<void**>(&pVertexDataBegin));
-        memcpy(pVertexDataBegin, cubeVertices, vertexBufferSize);
-        vertexBuffer->Unmap(0, nullptr);
+        CreateStaticBuffer(cubeVertices, vertexBufferSize, vertexBuffer, [this](ID3D12Resource* moved) {
+            vertexBuffer = moved;
+            vertexBufferView.BufferLocation = moved->GetGPUVirtualAddress();
+        });
 
         // Initialize the vertex buffer view
         vertexBufferView.BufferLocation = vertexBuffer->GetGPUVirtualAddress();
@@ -369,11 +577,28 @@ void Renderer::CreateDefaultResources()
     // Create index buffer
     {
         const UINT indexBufferSize = sizeof(cubeIndices);
+        CreateStaticBuffer(cubeIndices, indexBufferSize, indexBuffer, [this](ID3D12Resource* moved) {
+            indexBuffer = moved;
+            indexBufferView.BufferLocation = moved->GetGPUVirtualAddress();
+        });
+
+        // Initialize the index buffer view
+        indexBufferView.BufferLocation = indexBuffer->GetGPUVirtualAddress();
+        indexBufferView.Format = DXGI_FORMAT_R32_UINT;
+        indexBufferView.SizeInBytes = indexBufferSize;
+    }
+
+    // Create the material buffer and publish it in the bindless table
+    {
+        struct Material {
+            UINT albedoTexture;
+            float tint[3];
+        };
+        const Material defaultMaterial = { INVALID_DESCRIPTOR_INDEX, { 1.0f, 1.0f, 1.0f } };
 
-        D3D12_HEAP_PROPERTIES heapProps = { D3D12_HEAP_TYPE_UPLOAD };
         D3D12_RESOURCE_DESC bufferDesc = {};
         bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-        bufferDesc.Width = indexBufferSize;
+        bufferDesc.Width = sizeof(Material);
         bufferDesc.Height = 1;
         bufferDesc.DepthOrArraySize = 1;
         bufferDesc.MipLevels = 1;
@@ -381,109 +606,150 @@ void Renderer::CreateDefaultResources()
         bufferDesc.SampleDesc.Count = 1;
         bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
 
-        device->CreateCommittedResource(
-            &heapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &bufferDesc,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&indexBuffer));
-
-        // Copy index data to the buffer
-        UINT8* pIndexDataBegin;
-        indexBuffer->Map(0, nullptr, reinterpret_cast<void**>(&pIndexDataBegin));
-        memcpy(pIndexDataBegin, cubeIndices, indexBufferSize);
-        indexBuffer->Unmap(0, nullptr);
-
-        // Initialize the index buffer view
-        indexBufferView.BufferLocation = indexBuffer->GetGPUVirtualAddress();
-        indexBufferView.Format = DXGI_FORMAT_R32_UINT;
-        indexBufferView.SizeInBytes = indexBufferSize;
-    }
-}
+        if (SUCCEEDED(gpuMemory.CreateResource(D3D12_HEAP_TYPE_UPLOAD, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, materialBuffer))) {
+            UINT8* pMaterialData;
+            materialBuffer->Map(0, nullptr, reinterpret_cast<void**>(&pMaterialData));
+            memcpy(pMaterialData, &defaultMaterial, sizeof(defaultMaterial));
+            materialBuffer->Unmap(0, nullptr);
 
-void Renderer::RenderScene()
-{
-    if (!pipelineState)
-    {
-        // Skip rendering if pipeline state isn't set up yet
-        return;
+            materialBufferHandle = RegisterBindlessBuffer(materialBuffer.Get(), 1, sizeof(Material));
+        }
     }
 
-    // Set the graphics root signature
-    commandList->SetGraphicsRootSignature(rootSignature.Get());
-
-    // Set the pipeline state
-    commandList->SetPipelineState(pipelineState.Get());
-
-    // Set primitive topology
-    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-    // Set vertex and index buffers
-    if (vertexBuffer && indexBuffer)
+    // Per-instance ring of the draw list; stays mapped for the renderer's lifetime
     {
-        commandList->IASetVertexBuffers(0, 1, &vertexBufferView);
-        commandList->IASetIndexBuffer(&indexBufferView);
+        const UINT64 bytesPerFrame = UINT64(MAX_DRAW_INSTANCES) * sizeof(DrawInstanceData);
 
-        // Update constant buffer with latest camera/transform data
-        // Assuming we're using slot 0 for our constant buffer
-        commandList->SetGraphicsRootConstantBufferView(0, constantBuffer->GetGPUVirtualAddress());
+        D3D12_RESOURCE_DESC bufferDesc = {};
+        bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        bufferDesc.Width = bytesPerFrame * NUM_FRAMES_IN_FLIGHT;
+        bufferDesc.Height = 1;
+        bufferDesc.DepthOrArraySize = 1;
+        bufferDesc.MipLevels = 1;
+        bufferDesc.Format = DXGI_FORMAT_UNKNOWN;
+        bufferDesc.SampleDesc.Count = 1;
+        bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
 
-        // Draw the geometry
-        // Using 36 indices for a cube (6 faces * 2 triangles * 3 vertices)
-        commandList->DrawIndexedInstanced(36, 1, 0, 0, 0);
+        if (SUCCEEDED(gpuMemory.CreateResource(D3D12_HEAP_TYPE_UPLOAD, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, instanceBuffer))) {
+            UINT8* pInstanceData;
+            instanceBuffer->Map(0, nullptr, reinterpret_cast<void**>(&pInstanceData));
+            instanceRing.Initialize(pInstanceData, bytesPerFrame, NUM_FRAMES_IN_FLIGHT);
+        }
     }
 }
 
-
-void Renderer::CreateDepthBuffer()
+void Renderer::BuildFrameGraph()
 {
-    D3D12_HEAP_PROPERTIES heapProps = {};
-    heapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
-    heapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-    heapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-
-    D3D12_RESOURCE_DESC depthDesc = {};
-    depthDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-    depthDesc.Width = (UINT64)viewportWidth;
-    depthDesc.Height = (UINT)viewportHeight;
-    depthDesc.DepthOrArraySize = 1;
-    depthDesc.MipLevels = 1;
-    depthDesc.Format = DXGI_FORMAT_D32_FLOAT;
-    depthDesc.SampleDesc.Count = 1;
-    depthDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-
-    D3D12_CLEAR_VALUE clearValue = {};
-    clearValue.Format = DXGI_FORMAT_D32_FLOAT;
-    clearValue.DepthStencil.Depth = 1.0f;
-
-    device->CreateCommittedResource(
-        &heapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &depthDesc,
-        D3D12_RESOURCE_STATE_DEPTH_WRITE,
-        &clearValue,
-        IID_PPV_ARGS(&depthBuffer)
-    );
-
-    // Create DSV heap and view
-    D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc = {};
-    dsvHeapDesc.NumDescriptors = 1;
-    dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-    device->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&dsvHeap));
-
-    dsvHandle = dsvHeap->GetCPUDescriptorHandleForHeapStart();
-    device->CreateDepthStencilView(depthBuffer.Get(), nullptr, dsvHandle);
-}
+    frameGraph.Reset();
+
+    ID3D12Resource* backBuffer = renderTargets[backBufferIndex].Get();
+    rhiCommandList.RegisterView(D3D12CommandList::ToId(backBuffer), rtvHandles[backBufferIndex]);
+
+    D3D12_RESOURCE_DESC backBufferDesc = backBuffer->GetDesc();
+    FrameSetup setup;
+    setup.backBufferDesc.width = static_cast<uint32_t>(backBufferDesc.Width);
+    setup.backBufferDesc.height = backBufferDesc.Height;
+    setup.backBufferDesc.format = backBufferDesc.Format;
+    setup.backBuffer = backBuffer;
+    setup.depthFormat = DXGI_FORMAT_D32_FLOAT;
+    setup.viewport.width = viewportWidth;
+    setup.viewport.height = viewportHeight;
+    for (int i = 0; i < 4; ++i)
+        setup.clearColor[i] = SCENE_CLEAR_COLOR[i];
+
+    // The viewport panel samples the scene from its own target; before the panel
+    // first reports a size the scene goes to the back buffer under the UI
+    if (sceneColor) {
+        rhiCommandList.RegisterView(D3D12CommandList::ToId(sceneColor.Get()), sceneRtv);
+        rhiCommandList.RegisterView(D3D12CommandList::ToId(sceneDepth.Get()), sceneDsvHeap->GetCPUDescriptorHandleForHeapStart());
+        setup.sceneColorDesc = sceneColorDesc;
+        setup.sceneColor = sceneColor.Get();
+        setup.sceneDepth = sceneDepth.Get();
+    }
 
-void Renderer::UpdateViewport()
-{
-	CleanupRenderTargets();
-    swapChain->ResizeBuffers(0, (UINT)viewportWidth, (UINT)viewportHeight, DXGI_FORMAT_R8G8B8A8_UNORM, 0);
+    IndirectSceneParams indirect;
+    // Skip the draw until the pipeline and default resources exist
+    // A reloaded shader swaps its PSO in here once the cache has compiled it
+    if (scenePipelineHandle.IsValid()) {
+        RHIPipelineId compiled = pipelineCache.Get(scenePipelineHandle);
+        if (compiled != RHI_NULL_PIPELINE && compiled != appliedScenePipeline) {
+            scenePipeline.pipelineState = D3D12PipelineCompiler::ToPipeline(compiled)->pipelineState;
+            appliedScenePipeline = compiled;
+        }
+    }
+    if (scenePipeline.pipelineState) {
+        setup.scene.pipeline = D3D12CommandList::ToId(&scenePipeline);
+        if (vertexBuffer && indexBuffer && instanceBuffer && bindlessTable.IsValid(materialBufferHandle)) {
+            setup.scene.vertexBuffer = D3D12CommandList::ToId(vertexBuffer.Get());
+            setup.scene.indexBuffer = D3D12CommandList::ToId(indexBuffer.Get());
+            setup.scene.vertexStride = vertexBufferView.StrideInBytes;
+            setup.scene.vertexBufferSize = vertexBufferView.SizeInBytes;
+            setup.scene.indexBufferSize = indexBufferView.SizeInBytes;
+            setup.scene.materialBuffer = bindlessTable.GetShaderIndex(materialBufferHandle);
+
+            // The default cube stands in until the scene submits its own renderables
+            defaultMesh.indexCount = indexBufferView.SizeInBytes / sizeof(UINT);
+            const bool useDefault = !sceneSubmitted && sceneRenderables.empty();
+            const std::vector<Renderable>& renderables = useDefault ? defaultRenderables : sceneRenderables;
+            const CullingBounds& bounds = useDefault ? defaultBounds : sceneBounds;
+            assert(bounds.GetCount() == renderables.size() && "Scene bounds and renderables out of step");
+
+            // Without a camera the view is clip space itself
+            static const float clipSpace[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+            visibleRenderables.clear();
+            sceneDraws.clear();
+            if (gpuDrivenScene && renderables.size() <= gpuCuller.GetMaxObjects()) {
+                // Every renderable goes to the GPU, which culls and compacts them into the indirect draws
+                const DrawMesh& mesh = defaultMesh;  // the only mesh so far
+                sceneObjects.resize(renderables.size());
+                for (uint32_t i = 0; i < bounds.GetCount(); ++i) {
+                    GpuObjectData& object = sceneObjects[i];
+                    object.center[0] = bounds.GetCenterX()[i];
+                    object.center[1] = bounds.GetCenterY()[i];
+                    object.center[2] = bounds.GetCenterZ()[i];
+                    object.radius = bounds.GetRadius()[i];
+                    object.indexCount = mesh.indexCount;
+                    object.firstIndex = mesh.firstIndex;
+                    object.baseVertex = mesh.baseVertex;
+                    object.materialIndex = renderables[i].material;
+                }
+                if (!sceneObjects.empty()) {
+                    gpuCuller.UpdateObjects(frameSlot, sceneObjects.data(), static_cast<uint32_t>(sceneObjects.size()));
+                    indirect = gpuCuller.GetSceneParams(frameSlot, clipSpace);
+                    setup.indirect = &indirect;
+                }
+            } else {
+                // Only what the view can see is sorted and drawn
+                const Frustum viewFrustum = MakeFrustum(clipSpace);
+                frustumCuller.Cull(bounds, &viewFrustum, 1);
+                visibleRenderables.assign(frustumCuller.GetVisible(0), frustumCuller.GetVisible(0) + frustumCuller.GetVisibleCount(0));
+                if (!sceneOccluders.empty()) {
+                    occlusionCuller.Begin(clipSpace);
+                    for (const Occluder& occluder : sceneOccluders)
+                        occlusionCuller.AddOccluder(occluder);
+                    occlusionCuller.Rasterize();
+                    const uint32_t count = static_cast<uint32_t>(visibleRenderables.size());
+                    visibleRenderables.resize(occlusionCuller.CullBoxes(bounds, visibleRenderables.data(), count, visibleRenderables.data()));
+                }
+                drawList.Begin();
+                for (uint32_t index : visibleRenderables)
+                    drawList.Add(renderables[index]);
+                instanceRing.BeginFrame(frameSlot);
+                drawList.Build(instanceRing);
+                drawList.ToSceneDraws(&defaultMesh, 1, sceneDraws);
+            }
+            setup.scene.draws = sceneDraws.data();
+            setup.scene.drawCount = static_cast<uint32_t>(sceneDraws.size());
+        }
+    }
+    setup.recorder = &parallelRecorder;
 
-	CreateRenderTargets();
+    // ImGui records straight into the D3D12 list
+    setup.recordUi = [this](IRHICommandList&) {
+        ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), rhiCommandList.GetNative());
+    };
 
-	float aspectRatio = viewportWidth / viewportHeight;
+    AddFramePasses(frameGraph, rhiCommandList, setup);
 }
 
 bool Renderer::CreateDevice(HWND hwnd) {
@@ -536,7 +802,7 @@ bool Renderer::CreateDevice(HWND hwnd) {
     {
         D3D12_DESCRIPTOR_HEAP_DESC desc = {};
         desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-        desc.NumDescriptors = NUM_BACK_BUFFERS;
+        desc.NumDescriptors = NUM_BACK_BUFFERS + 1; // the last one is the scene target's
         desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
         desc.NodeMask = 1;
         if (device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&rtvHeap)) != S_OK)
@@ -549,26 +815,24 @@ bool Renderer::CreateDevice(HWND hwnd) {
             rtvHandles[i] = rtvHandle;
             rtvHandle.ptr += rtvDescriptorSize;
         }
-    }
+        sceneRtv = rtvHandle;
 
-    {
-        D3D12_DESCRIPTOR_HEAP_DESC desc = {};
-        desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-        desc.NumDescriptors = SRV_HEAP_SIZE;
-        desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-        if (device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&srvHeap)) != S_OK)
+        desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+        desc.NumDescriptors = 1;
+        if (device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&sceneDsvHeap)) != S_OK)
             return false;
-        srvAllocator.Create(device.Get(), srvHeap.Get());
     }
 
-    {
-        D3D12_COMMAND_QUEUE_DESC desc = {};
-        desc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
-        desc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
-        desc.NodeMask = 1;
-        if (device->CreateCommandQueue(&desc, IID_PPV_ARGS(&commandQueue)) != S_OK)
-            return false;
-    }
+    if (!srvAllocator.Create(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, true,
+        SRV_HEAP_PERSISTENT_CAPACITY, SRV_HEAP_TRANSIENT_PER_FRAME, NUM_FRAMES_IN_FLIGHT))
+        return false;
+    bindlessTable.Initialize(&srvAllocator.GetPersistent());
+
+    // Graphics, async compute and copy queues, each with its own fence
+    if (!gpuTimeline.Create(device.Get()))
+        return false;
+    queueScheduler.Initialize(&gpuTimeline);
+    frameLifecycle.Initialize(&queueScheduler, &frameClock, NUM_FRAMES_IN_FLIGHT);
 
     for (UINT i = 0; i < NUM_FRAMES_IN_FLIGHT; i++)
         if (device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&frameContexts[i].commandAllocator)) != S_OK)
@@ -578,11 +842,26 @@ bool Renderer::CreateDevice(HWND hwnd) {
         commandList->Close() != S_OK)
         return false;
 
-    if (device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)) != S_OK)
+    if (!gpuMemory.Create(device.Get()))
+        return false;
+    renderTargetPool.Initialize(&gpuMemory);
+    sceneTargetSizer.Initialize();
+
+    // Without timestamps the controller never gets a sample and the scene stays at full resolution
+    if (!gpuFrameTimer.Create(device.Get(), GetCommandQueue(), &gpuMemory, NUM_FRAMES_IN_FLIGHT))
+        OutputDebugStringA("GPU frame timer unavailable, dynamic resolution will keep full resolution\n");
+    DynamicResolutionSettings resolutionSettings;
+    resolutionSettings.targetFrameMs = DYNAMIC_RESOLUTION_TARGET_MS;
+    resolutionSettings.minScale = DYNAMIC_RESOLUTION_MIN_SCALE;
+    resolutionController.Initialize(resolutionSettings);
+
+    if (!uploadQueue.Create(device.Get(), &gpuTimeline, &queueScheduler, &gpuMemory))
         return false;
 
-    fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-    if (fenceEvent == nullptr)
+    if (!graphBackend.Create(device.Get()))
+        return false;
+
+    if (!secondaryLists.Create(device.Get(), srvAllocator.GetHeap(), NUM_FRAMES_IN_FLIGHT))
         return false;
 
     {
@@ -597,7 +876,7 @@ bool Renderer::CreateDevice(HWND hwnd) {
         if (tearingSupported)
             sd.Flags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
 
-        if (dxgiFactory->CreateSwapChainForHwnd(commandQueue.Get(), hwnd, &sd, nullptr, nullptr, &swapChain1) != S_OK)
+        if (dxgiFactory->CreateSwapChainForHwnd(GetCommandQueue(), hwnd, &sd, nullptr, nullptr, &swapChain1) != S_OK)
             return false;
         if (swapChain1->QueryInterface(IID_PPV_ARGS(&swapChain)) != S_OK)
             return false;
@@ -606,8 +885,9 @@ bool Renderer::CreateDevice(HWND hwnd) {
 
         swapChain1->Release();
         dxgiFactory->Release();
-        swapChain->SetMaximumFrameLatency(NUM_BACK_BUFFERS);
-        swapChainWaitableObject = swapChain->GetFrameLatencyWaitableObject();
+        if (!latencyWaiter.Create(swapChain.Get()))
+            return false;
+        framePacer.Initialize(&queueScheduler, &frameClock, &latencyWaiter, NUM_FRAMES_IN_FLIGHT, tearingSupported);
     }
 
     CreateRenderTargets();
@@ -631,56 +911,75 @@ void Renderer::CleanupRenderTargets() {
 }
 
 FrameContext* Renderer::WaitForNextFrame() {
-    FrameContext* ctx = &frameContexts[frameIndex % NUM_FRAMES_IN_FLIGHT];
-    if (fence->GetCompletedValue() < ctx->fenceValue) {
-        fence->SetEventOnCompletion(ctx->fenceValue, fenceEvent);
-        WaitForSingleObject(fenceEvent, INFINITE);
-    }
-    return ctx;
+    // Slots follow the monotonic frame number, not the back buffer index, which
+    // the swap chain may hand out in any order
+    frameSlot = frameLifecycle.BeginFrame();
+    return &frameContexts[frameSlot];
 }
 
 void Renderer::WaitForGPU() {
-    commandQueue->Signal(fence.Get(), ++fenceValue);
-    fence->SetEventOnCompletion(fenceValue, fenceEvent);
-    WaitForSingleObject(fenceEvent, INFINITE);
+    queueScheduler.CpuWait(queueScheduler.Submit(QueueType::Graphics));
 }
 
-DescriptorHeapAllocator::DescriptorHeapAllocator()
-    : heap(nullptr),
-    heapType(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV),
-    startCpu({ 0 }),
-    startGpu({ 0 }),
-    descriptorSize(0)
+bool DescriptorHeapAllocator::Create(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, bool shaderVisible,
+    UINT persistentCapacity, UINT transientPerFrame, UINT frameCount)
 {
+    D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+    desc.Type = type;
+    desc.NumDescriptors = persistentCapacity + transientPerFrame * frameCount;
+    desc.Flags = shaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    if (device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap)) != S_OK)
+        return false;
+
+    handleIncrement = device->GetDescriptorHandleIncrementSize(type);
+    startCpu = heap->GetCPUDescriptorHandleForHeapStart();
+    if (shaderVisible)
+        startGpu = heap->GetGPUDescriptorHandleForHeapStart();
+
+    persistent.Initialize(persistentCapacity);
+    transient.Initialize(persistentCapacity, transientPerFrame, frameCount);
+    return true;
 }
 
+void DescriptorHeapAllocator::Destroy()
+{
+    heap.Reset();
+    startCpu = {};
+    startGpu = {};
+}
 
-void DescriptorHeapAllocator::Create(ID3D12Device* device, ID3D12DescriptorHeap* heap) {
-    this->heap = heap;
-    this->heapType = heap->GetDesc().Type;
-    this->handleIncrement = device->GetDescriptorHandleIncrementSize(heapType);
+UINT DescriptorHeapAllocator::Alloc()
+{
+    return persistent.Allocate();
+}
 
-    this->startCpu = heap->GetCPUDescriptorHandleForHeapStart();
-    this->startGpu = heap->GetGPUDescriptorHandleForHeapStart();
+void DescriptorHeapAllocator::Alloc(D3D12_CPU_DESCRIPTOR_HANDLE* outCpu, D3D12_GPU_DESCRIPTOR_HANDLE* outGpu)
+{
+    UINT index = persistent.Allocate();
+    IM_ASSERT(index != INVALID_DESCRIPTOR_INDEX);
+    *outCpu = GetCpuHandle(index);
+    *outGpu = GetGpuHandle(index);
+}
 
-    freeIndices.clear();
-    for (int i = 0; i < SRV_HEAP_SIZE; ++i) {
-        freeIndices.push_back(i);
-    }
+void DescriptorHeapAllocator::Free(UINT index, UINT64 retireFenceValue)
+{
+    persistent.FreeDeferred(index, retireFenceValue);
 }
 
+void DescriptorHeapAllocator::Free(D3D12_CPU_DESCRIPTOR_HANDLE cpu, D3D12_GPU_DESCRIPTOR_HANDLE gpu, UINT64 retireFenceValue)
+{
+    UINT index = GetIndex(cpu);
+    IM_ASSERT(!startGpu.ptr || index == static_cast<UINT>((gpu.ptr - startGpu.ptr) / handleIncrement));
+    persistent.FreeDeferred(index, retireFenceValue);
+}
 
-void DescriptorHeapAllocator::Alloc(D3D12_CPU_DESCRIPTOR_HANDLE* out_cpu_desc_handle, D3D12_GPU_DESCRIPTOR_HANDLE* out_gpu_desc_handle) {
-    IM_ASSERT(freeIndices.Size > 0);
-    int idx = freeIndices.back();
-    freeIndices.pop_back();
-    out_cpu_desc_handle->ptr = startCpu.ptr + (idx * handleIncrement);
-    out_gpu_desc_handle->ptr = startGpu.ptr + (idx * handleIncrement);
+UINT DescriptorHeapAllocator::AllocTransient(UINT count)
+{
+    return transient.Allocate(count);
 }
 
-void DescriptorHeapAllocator::Free(D3D12_CPU_DESCRIPTOR_HANDLE cpu_desc_handle, D3D12_GPU_DESCRIPTOR_HANDLE gpu_desc_handle) {
-    int cpu_idx = static_cast<int>((cpu_desc_handle.ptr - startCpu.ptr) / handleIncrement);
-    int gpu_idx = static_cast<int>((gpu_desc_handle.ptr - startGpu.ptr) / handleIncrement);
-    IM_ASSERT(cpu_idx == gpu_idx);
-    freeIndices.push_back(cpu_idx);
-}
\ No newline at end of file
+void DescriptorHeapAllocator::BeginFrame(UINT frameSlot, UINT64 completedFenceValue)
+{
+    persistent.ProcessDeferredFrees(completedFenceValue);
+    transient.BeginFrame(frameSlot);
+}
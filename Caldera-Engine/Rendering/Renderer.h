@@ -6,35 +6,116 @@
 #include "imgui.h"
 #include "imgui_impl_win32.h"
 #include "imgui_impl_dx12.h"
+#include "CommandQueues.h"
+#include "GpuMemory.h"
+#include "DescriptorAllocator.h"
+#include "BindlessTable.h"
+#include "RenderGraph.h"
+#include "RenderGraphD3D12.h"
+#include "RHID3D12.h"
+#include "FramePasses.h"
+#include "ParallelRecorder.h"
+#include "GpuCullingD3D12.h"
+#include "DrawList.h"
+#include "PipelineCache.h"
+#include "PipelineCacheD3D12.h"
+#include "ShaderLibrary.h"
+#include "ShaderCompilerDxc.h"
+#include "FramePacer.h"
+#include "FramePacerD3D12.h"
+#include "FrameLifecycle.h"
+#include "SceneTarget.h"
+#include "RenderTargetPoolD3D12.h"
+#include "DynamicResolution.h"
+#include "GpuTimerD3D12.h"
+#include "FrustumCulling.h"
+#include "OcclusionCulling.h"
+#include "../Core/TaskPool.h"
+#include <chrono>
+#include <vector>
 
 using namespace Microsoft::WRL;
 
-// Constants
-constexpr int NUM_FRAMES_IN_FLIGHT = 2;
-constexpr int NUM_BACK_BUFFERS = 2;
-constexpr int SRV_HEAP_SIZE = 128;
+// Constants. Resources exist for this many frames; the frame pacer's latency
+// mode decides how many of them are actually in flight.
+constexpr int NUM_FRAMES_IN_FLIGHT = 3;
+constexpr int NUM_BACK_BUFFERS = 3;
 
+// The shader-visible heap has a fixed size: ImGui caches the heap pointer and GPU
+// handles, so it can never be swapped for a larger one. The first
+// SRV_HEAP_PERSISTENT_CAPACITY slots are persistent; the tail is split into
+// per-frame windows.
+constexpr UINT SRV_HEAP_PERSISTENT_CAPACITY = 16384;
+constexpr UINT SRV_HEAP_TRANSIENT_PER_FRAME = 1024;
+constexpr UINT SRV_HEAP_SIZE = SRV_HEAP_PERSISTENT_CAPACITY + SRV_HEAP_TRANSIENT_PER_FRAME * NUM_FRAMES_IN_FLIGHT;
+
+// Objects the GPU-driven scene path can cull and draw per frame.
+constexpr UINT MAX_GPU_DRIVEN_OBJECTS = 65536;
+// Instances the CPU draw list can write per frame into its upload ring.
+constexpr UINT MAX_DRAW_INSTANCES = 16384;
+
+// Bytes of movable GPU memory defragmentation may relocate per frame.
+constexpr UINT64 DEFRAG_BYTES_PER_FRAME = 4ull * 1024 * 1024;
+
+// Background of the scene and of the window around the UI.
+constexpr float SCENE_CLEAR_COLOR[4] = { 0.1f, 0.1f, 0.1f, 1.0f };
+
+// GPU frame time dynamic resolution aims for, and the lowest scene render scale it may pick.
+constexpr float DYNAMIC_RESOLUTION_TARGET_MS = 16.0f;
+constexpr float DYNAMIC_RESOLUTION_MIN_SCALE = 0.5f;
+
+// Compiled pipelines from earlier runs, and the list of pipelines to warm up at startup.
+constexpr const char* PIPELINE_LIBRARY_PATH = "pipelines.cache";
+constexpr const char* PIPELINE_LIST_PATH = "pipelines.list";
+
+// Shader sources, and the bytecode compiled from them by earlier runs.
+constexpr const char* SHADER_SOURCE_DIRECTORY = "Resources/Shaders";
+constexpr const char* SHADER_CACHE_DIRECTORY = "ShaderCache";
+// How often edited shaders are looked for on disk.
+constexpr UINT SHADER_POLL_INTERVAL_MS = 500;
+
+// Per-slot command memory; FrameLifecycle tracks when each slot retires.
 struct FrameContext {
     ComPtr<ID3D12CommandAllocator> commandAllocator;
-    UINT64 fenceValue = 0;
 };
 
+// Owns a descriptor heap and hands out persistent slots (thread-safe) and
+// per-frame transient ranges. Frees are deferred until the graphics fence shows
+// the GPU can no longer read the slot.
 class DescriptorHeapAllocator {
 public:
-    DescriptorHeapAllocator();
-    void Create(ID3D12Device* device, ID3D12DescriptorHeap* heap);
+    bool Create(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, bool shaderVisible,
+        UINT persistentCapacity, UINT transientPerFrame, UINT frameCount);
     void Destroy();
+
+    UINT Alloc();
     void Alloc(D3D12_CPU_DESCRIPTOR_HANDLE* outCpu, D3D12_GPU_DESCRIPTOR_HANDLE* outGpu);
-    void Free(D3D12_CPU_DESCRIPTOR_HANDLE cpu, D3D12_GPU_DESCRIPTOR_HANDLE gpu);
+    void Free(UINT index, UINT64 retireFenceValue);
+    void Free(D3D12_CPU_DESCRIPTOR_HANDLE cpu, D3D12_GPU_DESCRIPTOR_HANDLE gpu, UINT64 retireFenceValue);
+
+    // Contiguous range valid until this frame slot comes around again.
+    UINT AllocTransient(UINT count = 1);
+
+    // Recycles retired frees and rewinds the transient window of 'frameSlot'.
+    void BeginFrame(UINT frameSlot, UINT64 completedFenceValue);
+
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(UINT index) const { return { startCpu.ptr + SIZE_T(index) * handleIncrement }; }
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(UINT index) const { return { startGpu.ptr + UINT64(index) * handleIncrement }; }
+    UINT GetIndex(D3D12_CPU_DESCRIPTOR_HANDLE cpu) const { return static_cast<UINT>((cpu.ptr - startCpu.ptr) / handleIncrement); }
+
+    ID3D12DescriptorHeap* GetHeap() const { return heap.Get(); }
+    DescriptorIndexAllocator& GetPersistent() { return persistent; }
+    const DescriptorIndexAllocator& GetPersistent() const { return persistent; }
+    const TransientDescriptorRing& GetTransient() const { return transient; }
 
 private:
-    ID3D12DescriptorHeap* heap = nullptr;
-    D3D12_DESCRIPTOR_HEAP_TYPE heapType;
-    D3D12_CPU_DESCRIPTOR_HANDLE startCpu;
-    D3D12_GPU_DESCRIPTOR_HANDLE startGpu;
-	UINT64 descriptorSize = 0;
+    ComPtr<ID3D12DescriptorHeap> heap;
+    D3D12_CPU_DESCRIPTOR_HANDLE startCpu = {};
+    D3D12_GPU_DESCRIPTOR_HANDLE startGpu = {};
     UINT handleIncrement = 0;
-    ImVector<int> freeIndices;
+
+    DescriptorIndexAllocator persistent;
+    TransientDescriptorRing transient;
 };
 
 class Renderer {
@@ -49,9 +130,28 @@ public:
     void Shutdown();
 
     ID3D12Device* GetDevice() const { return device.Get(); }
-    ID3D12GraphicsCommandList* GetCommandList() const { return commandList.Get(); }
-    ID3D12DescriptorHeap* GetSrvHeap() const { return srvHeap.Get(); }
-    ID3D12CommandQueue* GetCommandQueue() { return commandQueue.Get(); };
+    // The list currently recording; it changes when worker lists are submitted mid-frame
+    ID3D12GraphicsCommandList* GetCommandList() const { return rhiCommandList.GetNative(); }
+    ID3D12DescriptorHeap* GetSrvHeap() const { return srvAllocator.GetHeap(); }
+    DescriptorHeapAllocator& GetSrvAllocator() { return srvAllocator; }
+    ID3D12CommandQueue* GetCommandQueue() { return gpuTimeline.GetQueue(QueueType::Graphics); };
+    ID3D12CommandQueue* GetComputeQueue() { return gpuTimeline.GetQueue(QueueType::Compute); }
+    QueueScheduler& GetQueueScheduler() { return queueScheduler; }
+    GpuMemory& GetGpuMemory() { return gpuMemory; }
+    // Shared with the editor for Background work; stopped in Shutdown
+    JobSystem& GetJobSystem() { return taskPool.GetJobSystem(); }
+
+    // Copy-queue uploads. Record into the returned COPY list, hand staging buffers
+    // to KeepUploadAlive, then submit and make the graphics queue wait on the result.
+    ID3D12GraphicsCommandList* BeginUploadBatch();
+    void KeepUploadAlive(ComPtr<ID3D12Resource> resource);
+    SyncPoint SubmitUploadBatch();
+
+    // Async compute. The list must be a COMPUTE type list.
+    SyncPoint SubmitCompute(ID3D12CommandList* list);
+
+    // Next graphics submission will not start before 'point' is reached.
+    void WaitOnGraphics(SyncPoint point);
 
 
     void WaitForGPU();
@@ -62,11 +162,69 @@ public:
 
     ComPtr<IDXGISwapChain3> swapChain;
 
-	UINT AllocateDescriptor();
-    ImTextureID GetCurrentBackBufferImGui();
+    // Returns the resource's memory once every frame that may reference it has
+    // retired. Safe to call mid-frame; 'resource' is reset immediately.
+    void ReleaseResourceDeferred(ComPtr<ID3D12Resource>& resource);
+    uint64_t GetFrameNumber() const { return frameLifecycle.GetFrameNumber(); }
+    const FrameLifecycleStats& GetFrameLifecycleStats() const { return frameLifecycle.GetStats(); }
 
+    // Persistent SRV slot; FreeDescriptor recycles it once this frame has retired.
+    UINT AllocateDescriptor();
+    void FreeDescriptor(UINT index);
+
+    // Bindless table. The handle's index is what shaders use to reach the resource
+    // and stays stable until ReleaseBindless; it doubles as an ImGui texture ID.
+    BindlessHandle RegisterBindlessTexture(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc = nullptr);
+    BindlessHandle RegisterBindlessBuffer(ID3D12Resource* resource, UINT numElements, UINT stride);
+    void ReleaseBindless(BindlessHandle handle);
+    ImTextureID GetBindlessTextureID(BindlessHandle handle) const;
+    BindlessTable& GetBindlessTable() { return bindlessTable; }
+
+    // Passes, barriers and transient memory (incl. bytes saved by aliasing) of the last frame graph
+    const RenderGraphStats& GetFrameGraphStats() const { return frameGraph.GetStats(); }
+
+    // Whether the scene's renderables are culled on the GPU and drawn with ExecuteIndirect.
+    // False if the culling pipeline failed to build; then, and for scenes of more
+    // than MAX_GPU_DRIVEN_OBJECTS, they go through CPU culling and the draw list.
+    bool IsGpuDrivenScene() const { return gpuDrivenScene; }
+    // Sorting and instancing results of the last CPU-built draw list.
+    const DrawListStats& GetDrawListStats() const { return drawList.GetStats(); }
+    // The scene's renderables and their world bounds, same indices. The scene may
+    // refill both every frame; the renderer only reads them.
+    std::vector<Renderable>& GetSceneRenderables() { return sceneRenderables; }
+    CullingBounds& GetSceneBounds() { return sceneBounds; }
+    // While nothing submits a scene and the lists are empty, a default cube is
+    // drawn in their place. A submitted scene is drawn as it is, even empty.
+    void SetSceneSubmitted(bool submitted) { sceneSubmitted = submitted; }
+    // Meshes a renderable may name; only the default cube so far.
+    uint32_t GetSceneMeshCount() const { return 1; }
+    // Renderables that passed CPU frustum and occlusion culling last frame; 0 when GPU-driven.
+    uint32_t GetVisibleRenderableCount() const { return static_cast<uint32_t>(visibleRenderables.size()); }
+    // Meshes rasterized into the software depth buffer that hides CPU-path renderables
+    // behind them. Their data must outlive the frame; an empty list skips the pass.
+    std::vector<Occluder>& GetSceneOccluders() { return sceneOccluders; }
+    const OcclusionStats& GetOcclusionStats() const { return occlusionCuller.GetStats(); }
+
+    // Applies from the next frame. Uncapped falls back to plain vsync-off without tearing support.
+    void SetLatencyMode(LatencyMode mode) { framePacer.SetMode(mode); }
+    LatencyMode GetLatencyMode() const { return framePacer.GetMode(); }
+    const FramePacingStats& GetFramePacingStats() const { return framePacer.GetStats(); }
+    // The scene as rendered for the viewport panel. Only the top-left part of the
+    // texture up to GetSceneUv holds this frame's image.
+    ImTextureID GetSceneTextureID() const;
+    ImVec2 GetSceneUv() const { return ImVec2(sceneTargetSizer.GetUvRight(), sceneTargetSizer.GetUvBottom()); }
+
+    // Call once per frame with the viewport panel's size, before GetSceneTextureID.
     void SetViewportSize(float width, float height);
-    void RenderScene();
+
+    // Scales the scene's render resolution to keep GPU frame time on target; the
+    // viewport panel upscales it. Disabling returns to full resolution.
+    void SetDynamicResolution(bool enabled);
+    bool IsDynamicResolutionEnabled() const { return dynamicResolution; }
+    float GetRenderScale() const { return sceneTargetSizer.GetRenderScale(); }
+    const DynamicResolutionStats& GetDynamicResolutionStats() const { return resolutionController.GetStats(); }
+    // GPU time of the newest retired frame.
+    float GetGpuFrameMs() const { return gpuFrameMs; }
 
 	void CreateGraphicsPipeline();
     bool multipleViewports = false;
@@ -74,57 +232,130 @@ public:
 private:
     bool CreateDevice(HWND hwnd);
     FrameContext* WaitForNextFrame();
-	void CreateDepthBuffer();
+    UINT64 GetRetireFenceValue() const;
+    void BuildFrameGraph();
+    void ReloadChangedShaders();
+    void RequestScenePipeline();
 
-    void UpdateViewport();
+    void ResizeSceneTarget();
     void CreateDefaultScene(); // THIS IS FOR TESTING COMMENT/REMOVE CODE WHEN FINISHED
 
     void CreateDefaultResources();
+    bool CreateStaticBuffer(const void* data, UINT size, ComPtr<ID3D12Resource>& outBuffer, GpuResourceMovedFn onMoved);
 
     ComPtr<ID3D12Device> device;
-    ComPtr<ID3D12CommandQueue> commandQueue;
     ComPtr<ID3D12GraphicsCommandList> commandList;
-    ComPtr<ID3D12Fence> fence;
+
+    D3D12GpuTimeline gpuTimeline;
+    QueueScheduler queueScheduler;
+    UploadQueue uploadQueue;
+    GpuMemory gpuMemory;
 
     ComPtr<ID3D12DescriptorHeap> rtvHeap;
-    ComPtr<ID3D12DescriptorHeap> srvHeap;
     DescriptorHeapAllocator srvAllocator;
+    BindlessTable bindlessTable;
 
     ComPtr<ID3D12Resource> renderTargets[NUM_BACK_BUFFERS];
     D3D12_CPU_DESCRIPTOR_HANDLE rtvHandles[NUM_BACK_BUFFERS];
 
     FrameContext frameContexts[NUM_FRAMES_IN_FLIGHT];
-    HANDLE fenceEvent = nullptr;
-    HANDLE swapChainWaitableObject = nullptr;
-    UINT64 fenceValue = 0;
-    UINT frameIndex = 0;
+    SteadyFrameClock frameClock;
+    FrameLifecycle frameLifecycle;
+    D3D12SwapChainLatencyWaiter latencyWaiter;
+    FramePacer framePacer;
+    UINT backBufferIndex = 0;
     bool tearingSupported = false;
     bool swapChainOccluded = false;
 
-    UINT currentDescriptorIndex = 0;
-    const UINT maxDescriptors = 1024;
-
+    // Scene region of the offscreen target, i.e. the panel size as of the last SetViewportSize
     float viewportWidth = 800.0f;
     float viewportHeight = 600.0f;
-    bool viewportResized = false;
+
+    // Offscreen scene target the viewport panel samples. Resizes are debounced
+    // by the sizer and recycle textures through the pool.
+    SceneTargetSizer sceneTargetSizer;
+    D3D12RenderTargetPool renderTargetPool;
+    ComPtr<ID3D12Resource> sceneColor;
+    ComPtr<ID3D12Resource> sceneDepth;
+    RGTextureDesc sceneColorDesc;
+    RGTextureDesc sceneDepthDesc;
+    BindlessHandle sceneColorHandle;
+    D3D12_CPU_DESCRIPTOR_HANDLE sceneRtv = {};
+    ComPtr<ID3D12DescriptorHeap> sceneDsvHeap;
+
+    // GPU time of each frame, fed to the render scale controller once the frame retires
+    D3D12GpuFrameTimer gpuFrameTimer;
+    DynamicResolutionController resolutionController;
+    bool dynamicResolution = false;
+    float gpuFrameMs = 0.0f;
 
 
 private:
-    ComPtr<ID3D12Resource> depthBuffer;
-    ComPtr<ID3D12DescriptorHeap> dsvHeap;
-    D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle;
+    RenderGraph frameGraph;
+    D3D12RenderGraphBackend graphBackend;
+    D3D12CommandList rhiCommandList;
+
+    // Parallel recording: scene draws are split over the task pool into per-worker
+    // lists that are submitted in order between the primary list's segments
+    TaskPool taskPool;
+    D3D12SecondaryLists secondaryLists;
+    ParallelRecorder parallelRecorder;
+    std::vector<ID3D12CommandList*> submitLists;
+
+    // GPU-driven path: the frame's renderables as culling objects
+    D3D12GpuCuller gpuCuller;
+    std::vector<GpuObjectData> sceneObjects;
+    bool gpuDrivenScene = false;
+    UINT frameSlot = 0;
 
     // Add these to the private section
 private:
-    // Pipeline objects
-    ComPtr<ID3D12RootSignature> rootSignature;
-    ComPtr<ID3D12PipelineState> pipelineState;
+    // Pipeline objects; the frame passes bind it through the RHI. Its PSO comes
+    // from the pipeline cache once the background compile finishes.
+    D3D12Pipeline scenePipeline;
+    D3D12PipelineCompiler pipelineCompiler;
+    PipelineCache pipelineCache;
+    PipelineHandle scenePipelineHandle;
+    RHIPipelineId appliedScenePipeline = RHI_NULL_PIPELINE;
+    uint64_t sceneRootSignatureId = 0;
+
+    // Shader bytecode comes from the on-disk cache; DXC only runs for shaders
+    // that changed since it was filled. Edits are picked up while running.
+    DxcShaderCompiler shaderCompiler;
+    ShaderLibrary shaderLibrary;
+    ShaderHandle sceneVertexShader;
+    ShaderHandle scenePixelShader;
+    ShaderHandle cullShader;
+    std::chrono::steady_clock::time_point lastShaderPoll;
 
     // Vertex/Index buffer objects
     ComPtr<ID3D12Resource> vertexBuffer;
     ComPtr<ID3D12Resource> indexBuffer;
     D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
     D3D12_INDEX_BUFFER_VIEW indexBufferView;
+    DrawMesh defaultMesh;
+
+    // CPU scene path: renderables are sorted and instanced, with per-instance
+    // data in a persistently mapped upload ring split per frame in flight
+    DrawListBuilder drawList;
+    // The scene's renderables and bounds, same indices; culled before the draw list sees them
+    CullingBounds sceneBounds;
+    std::vector<Renderable> sceneRenderables;
+    bool sceneSubmitted = false;
+    // The cube drawn while there is no scene
+    CullingBounds defaultBounds;
+    std::vector<Renderable> defaultRenderables;
+    FrustumCuller frustumCuller;
+    std::vector<Occluder> sceneOccluders;
+    OcclusionCuller occlusionCuller;
+    std::vector<uint32_t> visibleRenderables;
+    ComPtr<ID3D12Resource> instanceBuffer;
+    InstanceRing instanceRing;
+    std::vector<SceneDraw> sceneDraws;
+
+    // Bindless materials, indexed by the pixel shader through the SRV table
+    ComPtr<ID3D12Resource> materialBuffer;
+    BindlessHandle materialBufferHandle;
 
     // Constant buffer for MVP matrix
     ComPtr<ID3D12Resource> constantBuffer;
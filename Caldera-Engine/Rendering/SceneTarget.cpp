@@ -0,0 +1,64 @@
+#include "SceneTarget.h"
+#include <algorithm>
+#include <cassert>
+
+void SceneTargetSizer::Initialize(uint32_t granularity, uint32_t settleFrames)
+{
+    assert(granularity > 0 && "Granularity must be at least one pixel");
+    this->granularity = granularity;
+    this->settleFrames = settleFrames;
+    targetWidth = targetHeight = 0;
+    renderWidth = renderHeight = 0;
+    renderScale = 1.0f;
+    pendingWidth = pendingHeight = 0;
+    pendingFrames = 0;
+    reallocations = 0;
+}
+
+bool SceneTargetSizer::Update(uint32_t panelWidth, uint32_t panelHeight)
+{
+    const uint32_t width = std::max(panelWidth, 1u);
+    const uint32_t height = std::max(panelHeight, 1u);
+    // Keep the target while the panel fits and uses at least half of it
+    const bool fits = width <= targetWidth && height <= targetHeight;
+    const bool wasteful = uint64_t(RoundUp(width)) * RoundUp(height) * 2 < uint64_t(targetWidth) * targetHeight;
+
+    // A growing panel is likely still being dragged, so leave it room to grow into
+    const bool growing = targetWidth != 0 && !fits;
+    const uint32_t wantedWidth = RoundUp(growing ? width + width / GROWTH_HEADROOM : width);
+    const uint32_t wantedHeight = RoundUp(growing ? height + height / GROWTH_HEADROOM : height);
+    bool reallocate = false;
+    if (targetWidth == 0) {
+        reallocate = true;
+    }
+    else if (fits && !wasteful) {
+        pendingFrames = 0;
+    }
+    else {
+        if (wantedWidth == pendingWidth && wantedHeight == pendingHeight)
+            ++pendingFrames;
+        else
+            pendingFrames = 0;
+        pendingWidth = wantedWidth;
+        pendingHeight = wantedHeight;
+        reallocate = pendingFrames >= settleFrames;
+    }
+
+    if (reallocate) {
+        targetWidth = wantedWidth;
+        targetHeight = wantedHeight;
+        pendingFrames = 0;
+        ++reallocations;
+    }
+    const float scaledWidth = static_cast<float>(std::min(width, targetWidth)) * renderScale;
+    const float scaledHeight = static_cast<float>(std::min(height, targetHeight)) * renderScale;
+    renderWidth = std::max(static_cast<uint32_t>(scaledWidth + 0.5f), 1u);
+    renderHeight = std::max(static_cast<uint32_t>(scaledHeight + 0.5f), 1u);
+    return reallocate;
+}
+
+void SceneTargetSizer::SetRenderScale(float scale)
+{
+    assert(scale > 0.0f && scale <= 1.0f && "Render scale out of range");
+    renderScale = scale;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+// Sizing of the editor viewport's offscreen scene target. The target is
+// allocated in steps of 'granularity' pixels and the scene renders into its
+// top-left corner at the panel's size, so most panel drags only change the
+// viewport and UVs. A size that no longer fits (or wastes most of the target)
+// is only reallocated once the panel has held it for 'settleFrames' frames;
+// until then the current target is stretched over the panel. A render scale
+// below one shrinks the rendered region further; the panel upscales it.
+class SceneTargetSizer {
+public:
+    static constexpr uint32_t DEFAULT_GRANULARITY = 64;
+    static constexpr uint32_t DEFAULT_SETTLE_FRAMES = 8;
+    // Growth adds 1/GROWTH_HEADROOM of the panel size on top.
+    static constexpr uint32_t GROWTH_HEADROOM = 4;
+
+    void Initialize(uint32_t granularity = DEFAULT_GRANULARITY, uint32_t settleFrames = DEFAULT_SETTLE_FRAMES);
+
+    // Feeds this frame's panel size. Returns true when the target has to be
+    // reallocated at GetTargetWidth/GetTargetHeight.
+    bool Update(uint32_t panelWidth, uint32_t panelHeight);
+    // Fraction of the panel's resolution the scene renders at, from the next Update.
+    void SetRenderScale(float scale);
+    float GetRenderScale() const { return renderScale; }
+
+    uint32_t GetTargetWidth() const { return targetWidth; }
+    uint32_t GetTargetHeight() const { return targetHeight; }
+    // The region the scene renders into, starting at the target's origin.
+    uint32_t GetRenderWidth() const { return renderWidth; }
+    uint32_t GetRenderHeight() const { return renderHeight; }
+    // Bottom-right UV of the rendered region within the target.
+    float GetUvRight() const { return targetWidth ? static_cast<float>(renderWidth) / targetWidth : 1.0f; }
+    float GetUvBottom() const { return targetHeight ? static_cast<float>(renderHeight) / targetHeight : 1.0f; }
+
+    uint32_t GetReallocationCount() const { return reallocations; }
+
+private:
+    uint32_t RoundUp(uint32_t size) const { return (size + granularity - 1) / granularity * granularity; }
+
+    uint32_t granularity = DEFAULT_GRANULARITY;
+    uint32_t settleFrames = DEFAULT_SETTLE_FRAMES;
+
+    uint32_t targetWidth = 0;
+    uint32_t targetHeight = 0;
+    uint32_t renderWidth = 0;
+    uint32_t renderHeight = 0;
+    float renderScale = 1.0f;
+
+    uint32_t pendingWidth = 0;
+    uint32_t pendingHeight = 0;
+    uint32_t pendingFrames = 0;
+    uint32_t reallocations = 0;
+};
@@ -0,0 +1,78 @@
+#include "ShaderCompilerDxc.h"
+
+static std::wstring ToWide(const std::string& text)
+{
+    if (text.empty())
+        return {};
+    int length = MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0);
+    std::wstring wide(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), wide.data(), length);
+    return wide;
+}
+
+bool DxcShaderCompiler::Create()
+{
+    if (FAILED(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&utils))) ||
+        FAILED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler))) ||
+        FAILED(utils->CreateDefaultIncludeHandler(&includeHandler)))
+        return false;
+
+    // A new compiler version must not reuse bytecode cached by an older one
+    UINT32 major = 0, minor = 0;
+    ComPtr<IDxcVersionInfo> versionInfo;
+    if (SUCCEEDED(compiler.As(&versionInfo)))
+        versionInfo->GetVersion(&major, &minor);
+    id = "dxc-" + std::to_string(major) + "." + std::to_string(minor);
+    return true;
+}
+
+bool DxcShaderCompiler::Compile(const ShaderDesc& desc, const std::string& source, const std::vector<std::string>& includeDirs,
+    std::vector<uint8_t>& outBytecode, std::string& outErrors)
+{
+    // Arguments are kept as strings so the pointer array below stays valid
+    std::vector<std::wstring> arguments = {
+        ToWide(desc.path),
+        L"-E", ToWide(desc.entryPoint),
+        L"-T", ToWide(desc.profile),
+        DXC_ARG_OPTIMIZATION_LEVEL3,
+        DXC_ARG_WARNINGS_ARE_ERRORS,
+        L"-Qstrip_reflect",
+    };
+    for (const std::string& dir : includeDirs) {
+        arguments.push_back(L"-I");
+        arguments.push_back(ToWide(dir));
+    }
+    for (const ShaderDefine& define : desc.defines) {
+        arguments.push_back(L"-D");
+        arguments.push_back(ToWide(define.value.empty() ? define.name : define.name + "=" + define.value));
+    }
+    std::vector<LPCWSTR> argumentPointers;
+    for (const std::wstring& argument : arguments)
+        argumentPointers.push_back(argument.c_str());
+
+    DxcBuffer sourceBuffer = {};
+    sourceBuffer.Ptr = source.data();
+    sourceBuffer.Size = source.size();
+    sourceBuffer.Encoding = DXC_CP_UTF8;
+
+    ComPtr<IDxcResult> result;
+    if (FAILED(compiler->Compile(&sourceBuffer, argumentPointers.data(), static_cast<UINT32>(argumentPointers.size()),
+        includeHandler.Get(), IID_PPV_ARGS(&result)))) {
+        outErrors = "DXC failed to run";
+        return false;
+    }
+
+    ComPtr<IDxcBlobUtf8> errors;
+    if (SUCCEEDED(result->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&errors), nullptr)) && errors && errors->GetStringLength() > 0)
+        outErrors.assign(errors->GetStringPointer(), errors->GetStringLength());
+
+    HRESULT status = E_FAIL;
+    result->GetStatus(&status);
+    ComPtr<IDxcBlob> object;
+    if (FAILED(status) || FAILED(result->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&object), nullptr)) || !object)
+        return false;
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(object->GetBufferPointer());
+    outBytecode.assign(bytes, bytes + object->GetBufferSize());
+    return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <windows.h>
+#include <dxcapi.h>
+#include <wrl/client.h>
+#include <string>
+#include <vector>
+#include "ShaderLibrary.h"
+
+using namespace Microsoft::WRL;
+
+// Shader compiler on top of DXC (dxcompiler.dll), producing DXIL for shader model 6.
+class DxcShaderCompiler : public IShaderCompiler {
+public:
+    bool Create();
+
+    const std::string& GetId() const override { return id; }
+    bool Compile(const ShaderDesc& desc, const std::string& source, const std::vector<std::string>& includeDirs,
+        std::vector<uint8_t>& outBytecode, std::string& outErrors) override;
+
+private:
+    ComPtr<IDxcUtils> utils;
+    ComPtr<IDxcCompiler3> compiler;
+    ComPtr<IDxcIncludeHandler> includeHandler;
+    std::string id;
+};
@@ -0,0 +1,376 @@
+#include "ShaderLibrary.h"
+#include "../Core/Hash.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+static constexpr uint32_t SHADER_CACHE_MAGIC = 0x42485343; // "CSHB"
+static constexpr uint32_t SHADER_CACHE_VERSION = 1;
+// Written next to the bytecode so builds without a compiler know which compiler made it
+static const char* SHADER_CACHE_COMPILER_FILE = "compiler.id";
+
+static bool ReadFile(const fs::path& path, std::string& out)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+std::string MakeDefineString(std::vector<ShaderDefine> defines)
+{
+    std::sort(defines.begin(), defines.end(), [](const ShaderDefine& a, const ShaderDefine& b) { return a.name < b.name; });
+    std::string result;
+    for (const ShaderDefine& define : defines) {
+        if (!result.empty())
+            result += ';';
+        result += define.name;
+        result += '=';
+        result += define.value;
+    }
+    return result;
+}
+
+uint32_t ShaderPermutationSpace::AddOption(const std::string& name, uint32_t valueCount)
+{
+    assert(valueCount > 0 && "A shader option needs at least one value");
+    options.push_back({ name, valueCount });
+    return static_cast<uint32_t>(options.size() - 1);
+}
+
+uint32_t ShaderPermutationSpace::GetPermutationCount() const
+{
+    uint32_t count = 1;
+    for (const Option& option : options)
+        count *= option.valueCount;
+    return count;
+}
+
+uint32_t ShaderPermutationSpace::GetPermutationIndex(const uint32_t* optionValues) const
+{
+    uint32_t index = 0;
+    uint32_t stride = 1;
+    for (size_t i = 0; i < options.size(); ++i) {
+        assert(optionValues[i] < options[i].valueCount && "Shader option value out of range");
+        index += optionValues[i] * stride;
+        stride *= options[i].valueCount;
+    }
+    return index;
+}
+
+std::vector<ShaderDefine> ShaderPermutationSpace::GetDefines(uint32_t permutationIndex) const
+{
+    assert(permutationIndex < GetPermutationCount() && "Permutation index out of range");
+    std::vector<ShaderDefine> defines;
+    defines.reserve(options.size());
+    for (const Option& option : options) {
+        defines.push_back({ option.name, std::to_string(permutationIndex % option.valueCount) });
+        permutationIndex /= option.valueCount;
+    }
+    return defines;
+}
+
+// Include targets named on one line, or an empty string if the line has none
+static std::string ParseInclude(const std::string& line, bool& outSystem)
+{
+    size_t i = line.find_first_not_of(" \t");
+    if (i == std::string::npos || line[i] != '#')
+        return {};
+    i = line.find_first_not_of(" \t", i + 1);
+    if (i == std::string::npos || line.compare(i, 7, "include") != 0)
+        return {};
+    i = line.find_first_not_of(" \t", i + 7);
+    if (i == std::string::npos || (line[i] != '"' && line[i] != '<'))
+        return {};
+    outSystem = line[i] == '<';
+    size_t close = line.find(outSystem ? '>' : '"', i + 1);
+    if (close == std::string::npos)
+        return {};
+    return line.substr(i + 1, close - i - 1);
+}
+
+bool ScanShaderDependencies(const std::string& path, const std::vector<std::string>& includeDirs,
+    ShaderDependencies& outDependencies, std::string& outError)
+{
+    outDependencies = ShaderDependencies();
+    uint64_t hash = HASH_SEED;
+    std::unordered_set<std::string> visited;
+    std::vector<fs::path> pending = { fs::path(path).lexically_normal() };
+
+    while (!pending.empty()) {
+        fs::path file = pending.back();
+        pending.pop_back();
+        std::string name = file.generic_string();
+        if (!visited.insert(name).second)
+            continue;
+
+        std::string contents;
+        if (!ReadFile(file, contents)) {
+            outError = "Cannot read shader file " + name;
+            return false;
+        }
+        outDependencies.files.push_back(name);
+        hash = HashBytes(name.data(), name.size() + 1, hash);
+        hash = HashBytes(contents.data(), contents.size(), hash);
+
+        // Collected in source order, then pushed reversed so they are visited in that order
+        std::vector<fs::path> includes;
+        size_t lineStart = 0;
+        while (lineStart < contents.size()) {
+            size_t lineEnd = contents.find('\n', lineStart);
+            if (lineEnd == std::string::npos)
+                lineEnd = contents.size();
+            bool system = false;
+            std::string include = ParseInclude(contents.substr(lineStart, lineEnd - lineStart), system);
+            lineStart = lineEnd + 1;
+            if (include.empty())
+                continue;
+
+            fs::path resolved;
+            fs::path local = file.parent_path() / include;
+            if (!system && fs::exists(local)) {
+                resolved = local;
+            }
+            else {
+                for (const std::string& dir : includeDirs) {
+                    fs::path candidate = fs::path(dir) / include;
+                    if (fs::exists(candidate)) {
+                        resolved = candidate;
+                        break;
+                    }
+                }
+            }
+            if (resolved.empty()) {
+                outError = name + ": cannot find include " + include;
+                return false;
+            }
+            includes.push_back(resolved.lexically_normal());
+        }
+        pending.insert(pending.end(), includes.rbegin(), includes.rend());
+    }
+
+    outDependencies.contentHash = hash;
+    return true;
+}
+
+uint64_t MakeShaderCacheKey(const ShaderDesc& desc, uint64_t contentHash, const std::string& compilerId)
+{
+    std::string defines = MakeDefineString(desc.defines);
+    uint64_t hash = HashBytes(&contentHash, sizeof(contentHash));
+    hash = HashBytes(desc.entryPoint.c_str(), desc.entryPoint.size() + 1, hash);
+    hash = HashBytes(desc.profile.c_str(), desc.profile.size() + 1, hash);
+    hash = HashBytes(defines.c_str(), defines.size() + 1, hash);
+    return HashBytes(compilerId.c_str(), compilerId.size() + 1, hash);
+}
+
+bool ShaderBytecodeCache::Initialize(const std::string& directory)
+{
+    this->directory = directory;
+    std::error_code error;
+    fs::create_directories(this->directory, error);
+    return fs::is_directory(this->directory, error);
+}
+
+fs::path ShaderBytecodeCache::GetPath(uint64_t key) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return directory / name;
+}
+
+bool ShaderBytecodeCache::Load(uint64_t key, std::vector<uint8_t>& outBytecode) const
+{
+    std::string contents;
+    if (!ReadFile(GetPath(key), contents))
+        return false;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint64_t size;
+    } header;
+    if (contents.size() < sizeof(header))
+        return false;
+    memcpy(&header, contents.data(), sizeof(header));
+    if (header.magic != SHADER_CACHE_MAGIC || header.version != SHADER_CACHE_VERSION || header.key != key ||
+        header.size != contents.size() - sizeof(header))
+        return false;
+
+    outBytecode.assign(contents.begin() + sizeof(header), contents.end());
+    return true;
+}
+
+bool ShaderBytecodeCache::Store(uint64_t key, const std::vector<uint8_t>& bytecode) const
+{
+    const uint32_t magic = SHADER_CACHE_MAGIC;
+    const uint32_t version = SHADER_CACHE_VERSION;
+    const uint64_t size = bytecode.size();
+
+    // Written aside and renamed, so a reader never sees half a file
+    fs::path path = GetPath(key);
+    fs::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+        file.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        file.write(reinterpret_cast<const char*>(bytecode.data()), static_cast<std::streamsize>(bytecode.size()));
+        if (!file.good())
+            return false;
+    }
+    std::error_code error;
+    fs::rename(temporary, path, error);
+    return !error;
+}
+
+bool ShaderLibrary::Initialize(IShaderCompiler* compiler, const std::string& cacheDirectory, std::vector<std::string> includeDirs)
+{
+    this->compiler = compiler;
+    this->includeDirs = std::move(includeDirs);
+    if (!cache.Initialize(cacheDirectory)) {
+        lastError = "Cannot create shader cache directory " + cacheDirectory;
+        return false;
+    }
+
+    fs::path idFile = fs::path(cacheDirectory) / SHADER_CACHE_COMPILER_FILE;
+    if (compiler) {
+        std::ofstream file(idFile, std::ios::binary | std::ios::trunc);
+        file << compiler->GetId();
+    }
+    else if (!ReadFile(idFile, cachedCompilerId)) {
+        lastError = "Shader cache has no compiler id and no compiler is available";
+        return false;
+    }
+    return true;
+}
+
+std::string ShaderLibrary::MakeLookupKey(const ShaderDesc& desc)
+{
+    return fs::path(desc.path).lexically_normal().generic_string() + '|' + desc.entryPoint + '|' + desc.profile + '|' + MakeDefineString(desc.defines);
+}
+
+bool ShaderLibrary::Build(const ShaderDesc& desc, std::vector<uint8_t>& outBytecode, std::vector<std::string>& outFiles)
+{
+    ShaderDependencies dependencies;
+    if (!ScanShaderDependencies(desc.path, includeDirs, dependencies, lastError)) {
+        ++stats.failures;
+        return false;
+    }
+    outFiles = dependencies.files;
+
+    const std::string& compilerId = compiler ? compiler->GetId() : cachedCompilerId;
+    uint64_t key = MakeShaderCacheKey(desc, dependencies.contentHash, compilerId);
+    if (cache.Load(key, outBytecode)) {
+        ++stats.cacheHits;
+        return true;
+    }
+
+    if (!compiler) {
+        lastError = desc.path + " (" + desc.entryPoint + "): not in the shader cache";
+        ++stats.failures;
+        return false;
+    }
+
+    std::string source;
+    std::string errors;
+    ++stats.compiles;
+    if (!ReadFile(desc.path, source) || !compiler->Compile(desc, source, includeDirs, outBytecode, errors)) {
+        lastError = desc.path + " (" + desc.entryPoint + "): " + (errors.empty() ? "compilation failed" : errors);
+        ++stats.failures;
+        return false;
+    }
+
+    cache.Store(key, outBytecode);
+    return true;
+}
+
+ShaderHandle ShaderLibrary::Load(const ShaderDesc& desc)
+{
+    std::string lookupKey = MakeLookupKey(desc);
+    auto found = lookup.find(lookupKey);
+    if (found != lookup.end())
+        return { found->second };
+
+    Entry entry;
+    entry.desc = desc;
+    if (!Build(desc, entry.bytecode, entry.files))
+        return {};
+
+    std::error_code error;
+    for (const std::string& file : entry.files)
+        entry.timestamps.push_back(fs::last_write_time(file, error));
+
+    const uint32_t index = static_cast<uint32_t>(entries.size());
+    entries.push_back(std::move(entry));
+    lookup[lookupKey] = index;
+    return { index };
+}
+
+uint32_t ShaderLibrary::Precompile(const std::string& path, const std::string& entryPoint, const std::string& profile,
+    const ShaderPermutationSpace& space)
+{
+    uint32_t failed = 0;
+    for (uint32_t i = 0; i < space.GetPermutationCount(); ++i) {
+        ShaderDesc desc = { path, entryPoint, profile, space.GetDefines(i) };
+        std::vector<uint8_t> bytecode;
+        std::vector<std::string> files;
+        if (!Build(desc, bytecode, files))
+            ++failed;
+    }
+    return failed;
+}
+
+const std::vector<uint8_t>& ShaderLibrary::GetBytecode(ShaderHandle handle) const
+{
+    assert(handle.index < entries.size() && "Invalid shader handle");
+    return entries[handle.index].bytecode;
+}
+
+uint32_t ShaderLibrary::GetVersion(ShaderHandle handle) const
+{
+    assert(handle.index < entries.size() && "Invalid shader handle");
+    return entries[handle.index].version;
+}
+
+std::vector<ShaderHandle> ShaderLibrary::PollChanges()
+{
+    std::vector<ShaderHandle> reloaded;
+    std::error_code error;
+    for (uint32_t i = 0; i < entries.size(); ++i) {
+        Entry& entry = entries[i];
+        bool changed = false;
+        for (size_t f = 0; f < entry.files.size() && !changed; ++f)
+            changed = fs::last_write_time(entry.files[f], error) != entry.timestamps[f];
+        if (!changed)
+            continue;
+
+        // Timestamps move on even if the build fails, so a broken file is retried on its next save
+        std::vector<uint8_t> bytecode;
+        std::vector<std::string> files;
+        bool built = Build(entry.desc, bytecode, files);
+        if (built)
+            entry.files = std::move(files);
+        entry.timestamps.clear();
+        for (const std::string& file : entry.files)
+            entry.timestamps.push_back(fs::last_write_time(file, error));
+
+        if (built && bytecode != entry.bytecode) {
+            entry.bytecode = std::move(bytecode);
+            ++entry.version;
+            ++stats.reloads;
+            reloaded.push_back({ i });
+        }
+    }
+    return reloaded;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Shaders live in files and reach the renderer as bytecode from an on-disk
+// cache keyed by the hash of their sources, includes, defines and compiler.
+// Unchanged shaders load straight from the cache without a compiler; edited
+// ones are rebuilt by PollChanges while the editor runs.
+
+struct ShaderDefine {
+    std::string name;
+    std::string value;
+};
+
+// "NAME=VALUE" pairs sorted by name and joined with ';', so the same set of
+// defines in any order gives the same string.
+std::string MakeDefineString(std::vector<ShaderDefine> defines);
+
+// Compile-time options of a shader. Each option takes values [0, valueCount)
+// and is passed as NAME=value; every combination is one permutation.
+class ShaderPermutationSpace {
+public:
+    // Returns the option's index.
+    uint32_t AddOption(const std::string& name, uint32_t valueCount = 2);
+
+    uint32_t GetOptionCount() const { return static_cast<uint32_t>(options.size()); }
+    uint32_t GetPermutationCount() const;
+    // 'optionValues' holds one value per option; option 0 varies fastest.
+    uint32_t GetPermutationIndex(const uint32_t* optionValues) const;
+    std::vector<ShaderDefine> GetDefines(uint32_t permutationIndex) const;
+
+private:
+    struct Option {
+        std::string name;
+        uint32_t valueCount = 2;
+    };
+    std::vector<Option> options;
+};
+
+struct ShaderDesc {
+    std::string path;
+    std::string entryPoint;
+    std::string profile;  // e.g. vs_6_0
+    std::vector<ShaderDefine> defines;
+};
+
+struct ShaderDependencies {
+    std::vector<std::string> files;  // the source first, then includes in discovery order
+    uint64_t contentHash = 0;        // every file's path and contents, in that order
+};
+
+// Follows #include "..." and <...> from 'path', resolving each relative to the
+// including file and then to 'includeDirs'. Includes inside #if blocks count
+// whether or not the block is active, so dependencies are never missed.
+bool ScanShaderDependencies(const std::string& path, const std::vector<std::string>& includeDirs,
+    ShaderDependencies& outDependencies, std::string& outError);
+
+uint64_t MakeShaderCacheKey(const ShaderDesc& desc, uint64_t contentHash, const std::string& compilerId);
+
+class IShaderCompiler {
+public:
+    virtual ~IShaderCompiler() = default;
+
+    // Identifies the compiler and its version; part of every cache key.
+    virtual const std::string& GetId() const = 0;
+    virtual bool Compile(const ShaderDesc& desc, const std::string& source, const std::vector<std::string>& includeDirs,
+        std::vector<uint8_t>& outBytecode, std::string& outErrors) = 0;
+};
+
+// Bytecode on disk, one file per cache key.
+class ShaderBytecodeCache {
+public:
+    bool Initialize(const std::string& directory);
+
+    bool Load(uint64_t key, std::vector<uint8_t>& outBytecode) const;
+    bool Store(uint64_t key, const std::vector<uint8_t>& bytecode) const;
+
+private:
+    std::filesystem::path GetPath(uint64_t key) const;
+
+    std::filesystem::path directory;
+};
+
+struct ShaderHandle {
+    uint32_t index = ~0u;
+    bool IsValid() const { return index != ~0u; }
+};
+
+struct ShaderLibraryStats {
+    uint32_t cacheHits = 0;
+    uint32_t compiles = 0;
+    uint32_t failures = 0;
+    uint32_t reloads = 0;
+};
+
+class ShaderLibrary {
+public:
+    // Without a compiler only cached bytecode can load, as in a shipped build.
+    bool Initialize(IShaderCompiler* compiler, const std::string& cacheDirectory, std::vector<std::string> includeDirs);
+
+    // Loading the same desc again returns the same handle. Invalid on failure; see GetLastError.
+    ShaderHandle Load(const ShaderDesc& desc);
+    // Fills the cache with every permutation of a shader ahead of time.
+    // Returns how many permutations failed.
+    uint32_t Precompile(const std::string& path, const std::string& entryPoint, const std::string& profile,
+        const ShaderPermutationSpace& space);
+
+    const std::vector<uint8_t>& GetBytecode(ShaderHandle handle) const;
+    // Goes up every time the shader is reloaded.
+    uint32_t GetVersion(ShaderHandle handle) const;
+
+    // Rebuilds loaded shaders whose source or includes changed on disk and
+    // returns them. A shader that fails to rebuild keeps its old bytecode.
+    std::vector<ShaderHandle> PollChanges();
+
+    const std::string& GetLastError() const { return lastError; }
+    const ShaderLibraryStats& GetStats() const { return stats; }
+
+private:
+    struct Entry {
+        ShaderDesc desc;
+        std::vector<uint8_t> bytecode;
+        std::vector<std::string> files;
+        std::vector<std::filesystem::file_time_type> timestamps;
+        uint32_t version = 0;
+    };
+
+    // Scans dependencies, then takes the bytecode from the cache or the compiler.
+    bool Build(const ShaderDesc& desc, std::vector<uint8_t>& outBytecode, std::vector<std::string>& outFiles);
+    static std::string MakeLookupKey(const ShaderDesc& desc);
+
+    IShaderCompiler* compiler = nullptr;
+    std::string cachedCompilerId;  // used when there is no compiler
+    ShaderBytecodeCache cache;
+    std::vector<std::string> includeDirs;
+
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, uint32_t> lookup;
+    std::string lastError;
+    ShaderLibraryStats stats;
+};
@@ -0,0 +1,296 @@
+#include "TlsfAllocator.h"
+#include <algorithm>
+#include <cassert>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static uint32_t FindLowestBit(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, static_cast<unsigned long>(value)))
+        return index;
+    _BitScanForward(&index, static_cast<unsigned long>(value >> 32));
+    return index + 32;
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+static uint32_t FindHighestBit(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32)))
+        return index + 32;
+    _BitScanReverse(&index, static_cast<unsigned long>(value));
+    return index;
+#else
+    return 63u - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+}
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void TlsfAllocator::Initialize(uint64_t capacity)
+{
+    assert(capacity >= MIN_BLOCK_SIZE && "Capacity too small");
+    assert(capacity < (1ull << (FL_COUNT + FL_SHIFT - 1)) && "Capacity too large");
+
+    this->capacity = capacity & ~(MIN_BLOCK_SIZE - 1);
+    usedBytes = 0;
+    allocationCount = 0;
+
+    blocks.clear();
+    unusedBlocks.clear();
+    allocatedBlocks.clear();
+
+    flBitmap = 0;
+    for (uint32_t fl = 0; fl < FL_COUNT; ++fl) {
+        slBitmap[fl] = 0;
+        for (uint32_t sl = 0; sl < SL_COUNT; ++sl)
+            freeHeads[fl][sl] = NIL;
+    }
+
+    // Block 0 always starts at offset 0; merges only ever release the later block
+    uint32_t first = NewBlock();
+    blocks[first].offset = 0;
+    blocks[first].size = this->capacity;
+    blocks[first].isFree = true;
+    InsertFree(first);
+}
+
+uint64_t TlsfAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    if (size == 0)
+        return INVALID_OFFSET;
+
+    assert((alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+    size = AlignUp(size, MIN_BLOCK_SIZE);
+    alignment = std::max(alignment, MIN_BLOCK_SIZE);
+
+    // Reserve worst-case front padding so any block from the found list fits
+    const uint64_t searchSize = size + (alignment - MIN_BLOCK_SIZE);
+    uint32_t block = FindFreeBlock(searchSize);
+    if (block == NIL)
+        return INVALID_OFFSET;
+
+    RemoveFree(block);
+
+    const uint64_t padding = AlignUp(blocks[block].offset, alignment) - blocks[block].offset;
+    if (padding > 0) {
+        uint32_t aligned = SplitBack(block, padding);
+        blocks[block].isFree = true;
+        InsertFree(block);
+        block = aligned;
+    }
+
+    if (blocks[block].size - size >= MIN_BLOCK_SIZE) {
+        uint32_t rest = SplitBack(block, size);
+        blocks[rest].isFree = true;
+        InsertFree(rest);
+    }
+
+    blocks[block].isFree = false;
+    allocatedBlocks[blocks[block].offset] = block;
+    usedBytes += blocks[block].size;
+    ++allocationCount;
+    return blocks[block].offset;
+}
+
+void TlsfAllocator::Free(uint64_t offset)
+{
+    auto it = allocatedBlocks.find(offset);
+    assert(it != allocatedBlocks.end() && "Freeing an offset that was not allocated");
+    if (it == allocatedBlocks.end())
+        return;
+
+    uint32_t block = it->second;
+    allocatedBlocks.erase(it);
+    usedBytes -= blocks[block].size;
+    --allocationCount;
+    blocks[block].isFree = true;
+
+    // Coalesce with the physical neighbours so free space never splinters
+    const uint32_t prev = blocks[block].prevPhys;
+    if (prev != NIL && blocks[prev].isFree) {
+        RemoveFree(prev);
+        blocks[prev].size += blocks[block].size;
+        blocks[prev].nextPhys = blocks[block].nextPhys;
+        if (blocks[block].nextPhys != NIL)
+            blocks[blocks[block].nextPhys].prevPhys = prev;
+        ReleaseBlock(block);
+        block = prev;
+    }
+
+    const uint32_t next = blocks[block].nextPhys;
+    if (next != NIL && blocks[next].isFree) {
+        RemoveFree(next);
+        blocks[block].size += blocks[next].size;
+        blocks[block].nextPhys = blocks[next].nextPhys;
+        if (blocks[next].nextPhys != NIL)
+            blocks[blocks[next].nextPhys].prevPhys = block;
+        ReleaseBlock(next);
+    }
+
+    InsertFree(block);
+}
+
+uint64_t TlsfAllocator::GetAllocationSize(uint64_t offset) const
+{
+    auto it = allocatedBlocks.find(offset);
+    return it != allocatedBlocks.end() ? blocks[it->second].size : 0;
+}
+
+TlsfAllocator::Stats TlsfAllocator::GetStats() const
+{
+    Stats stats;
+    stats.capacity = capacity;
+    stats.usedBytes = usedBytes;
+    stats.freeBytes = capacity - usedBytes;
+    stats.allocationCount = allocationCount;
+
+    for (uint32_t block = blocks.empty() ? NIL : 0; block != NIL; block = blocks[block].nextPhys) {
+        if (!blocks[block].isFree)
+            continue;
+        ++stats.freeBlockCount;
+        stats.largestFreeBlock = std::max(stats.largestFreeBlock, blocks[block].size);
+    }
+    return stats;
+}
+
+void TlsfAllocator::GetAllocationsFromBack(std::vector<uint64_t>& outOffsets) const
+{
+    outOffsets.clear();
+    for (uint32_t block = blocks.empty() ? NIL : 0; block != NIL; block = blocks[block].nextPhys)
+        if (!blocks[block].isFree)
+            outOffsets.push_back(blocks[block].offset);
+    std::reverse(outOffsets.begin(), outOffsets.end());
+}
+
+void TlsfAllocator::Mapping(uint64_t size, uint32_t& fl, uint32_t& sl)
+{
+    if (size < (1ull << FL_SHIFT)) {
+        fl = 0;
+        sl = static_cast<uint32_t>(size >> ALIGN_LOG2);
+    }
+    else {
+        const uint32_t log2 = FindHighestBit(size);
+        sl = static_cast<uint32_t>(size >> (log2 - SL_LOG2)) ^ SL_COUNT;
+        fl = log2 - FL_SHIFT + 1;
+    }
+}
+
+uint32_t TlsfAllocator::FindFreeBlock(uint64_t size)
+{
+    // Round up to the next list so every block in it is large enough (good fit)
+    if (size >= (1ull << FL_SHIFT))
+        size += (1ull << (FindHighestBit(size) - SL_LOG2)) - 1;
+
+    uint32_t fl, sl;
+    Mapping(size, fl, sl);
+    if (fl >= FL_COUNT)
+        return NIL;
+
+    uint32_t slMap = slBitmap[fl] & (~0u << sl);
+    if (slMap == 0) {
+        const uint64_t flMap = (fl + 1 < 64) ? (flBitmap & (~0ull << (fl + 1))) : 0;
+        if (flMap == 0)
+            return NIL;
+        fl = FindLowestBit(flMap);
+        slMap = slBitmap[fl];
+    }
+
+    sl = FindLowestBit(slMap);
+    return freeHeads[fl][sl];
+}
+
+void TlsfAllocator::InsertFree(uint32_t block)
+{
+    uint32_t fl, sl;
+    Mapping(blocks[block].size, fl, sl);
+
+    const uint32_t head = freeHeads[fl][sl];
+    blocks[block].prevFree = NIL;
+    blocks[block].nextFree = head;
+    if (head != NIL)
+        blocks[head].prevFree = block;
+    freeHeads[fl][sl] = block;
+
+    flBitmap |= 1ull << fl;
+    slBitmap[fl] |= 1u << sl;
+}
+
+void TlsfAllocator::RemoveFree(uint32_t block)
+{
+    uint32_t fl, sl;
+    Mapping(blocks[block].size, fl, sl);
+
+    const uint32_t prev = blocks[block].prevFree;
+    const uint32_t next = blocks[block].nextFree;
+    if (prev != NIL)
+        blocks[prev].nextFree = next;
+    if (next != NIL)
+        blocks[next].prevFree = prev;
+
+    if (freeHeads[fl][sl] == block) {
+        freeHeads[fl][sl] = next;
+        if (next == NIL) {
+            slBitmap[fl] &= ~(1u << sl);
+            if (slBitmap[fl] == 0)
+                flBitmap &= ~(1ull << fl);
+        }
+    }
+
+    blocks[block].prevFree = NIL;
+    blocks[block].nextFree = NIL;
+}
+
+uint32_t TlsfAllocator::NewBlock()
+{
+    if (!unusedBlocks.empty()) {
+        uint32_t block = unusedBlocks.back();
+        unusedBlocks.pop_back();
+        blocks[block] = Block();
+        return block;
+    }
+    blocks.push_back(Block());
+    return static_cast<uint32_t>(blocks.size() - 1);
+}
+
+void TlsfAllocator::ReleaseBlock(uint32_t block)
+{
+    blocks[block] = Block();
+    unusedBlocks.push_back(block);
+}
+
+uint32_t TlsfAllocator::SplitBack(uint32_t block, uint64_t size)
+{
+    // 'block' keeps the first 'size' bytes; the returned block owns the rest
+    uint32_t back = NewBlock();
+    Block& front = blocks[block];
+
+    blocks[back].offset = front.offset + size;
+    blocks[back].size = front.size - size;
+    blocks[back].prevPhys = block;
+    blocks[back].nextPhys = front.nextPhys;
+    if (front.nextPhys != NIL)
+        blocks[front.nextPhys].prevPhys = back;
+
+    front.size = size;
+    front.nextPhys = back;
+    return back;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Two-level segregated fit allocator over an abstract [0, capacity) range. It only
+// does bookkeeping: offsets are handed back to the caller, who places resources
+// in a real heap. Allocate and Free are O(1).
+class TlsfAllocator {
+public:
+    static constexpr uint64_t INVALID_OFFSET = ~0ull;
+    static constexpr uint64_t MIN_BLOCK_SIZE = 256;
+
+    struct Stats {
+        uint64_t capacity = 0;
+        uint64_t usedBytes = 0;
+        uint64_t freeBytes = 0;
+        uint64_t largestFreeBlock = 0;
+        uint32_t allocationCount = 0;
+        uint32_t freeBlockCount = 0;
+
+        // 0 when all free space is one block, approaching 1 as it splinters
+        float GetFragmentation() const {
+            return freeBytes ? 1.0f - float(largestFreeBlock) / float(freeBytes) : 0.0f;
+        }
+    };
+
+    void Initialize(uint64_t capacity);
+
+    // Returns the allocation offset, or INVALID_OFFSET if no block fits.
+    // 'alignment' must be a power of two.
+    uint64_t Allocate(uint64_t size, uint64_t alignment = MIN_BLOCK_SIZE);
+    void Free(uint64_t offset);
+
+    uint64_t GetAllocationSize(uint64_t offset) const;
+    uint64_t GetCapacity() const { return capacity; }
+    uint64_t GetUsedBytes() const { return usedBytes; }
+    bool IsEmpty() const { return allocationCount == 0; }
+    Stats GetStats() const;
+
+    // Offsets of live allocations, highest offset first. Used by defragmentation
+    // to pick what to move towards the front.
+    void GetAllocationsFromBack(std::vector<uint64_t>& outOffsets) const;
+
+private:
+    static constexpr uint32_t SL_LOG2 = 5;
+    static constexpr uint32_t SL_COUNT = 1u << SL_LOG2;
+    static constexpr uint32_t ALIGN_LOG2 = 8;     // log2(MIN_BLOCK_SIZE)
+    static constexpr uint32_t FL_SHIFT = SL_LOG2 + ALIGN_LOG2;
+    static constexpr uint32_t FL_COUNT = 40;
+    static constexpr uint32_t NIL = ~0u;
+
+    struct Block {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint32_t prevPhys = NIL;
+        uint32_t nextPhys = NIL;
+        uint32_t prevFree = NIL;
+        uint32_t nextFree = NIL;
+        bool isFree = false;
+    };
+
+    static void Mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+    uint32_t FindFreeBlock(uint64_t size);
+    void InsertFree(uint32_t block);
+    void RemoveFree(uint32_t block);
+    uint32_t NewBlock();
+    void ReleaseBlock(uint32_t block);
+    uint32_t SplitBack(uint32_t block, uint64_t size);
+
+    std::vector<Block> blocks;
+    std::vector<uint32_t> unusedBlocks;
+    std::unordered_map<uint64_t, uint32_t> allocatedBlocks;  // offset -> block
+
+    uint64_t flBitmap = 0;
+    uint32_t slBitmap[FL_COUNT] = {};
+    uint32_t freeHeads[FL_COUNT][SL_COUNT];
+
+    uint64_t capacity = 0;
+    uint64_t usedBytes = 0;
+    uint32_t allocationCount = 0;
+};
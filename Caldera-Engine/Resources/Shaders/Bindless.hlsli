@@ -0,0 +1,22 @@
+// Bindless resources of the scene root signature. Textures and buffers alias
+// the same descriptor table from different register spaces; draws only pass indices.
+#ifndef BINDLESS_HLSLI
+#define BINDLESS_HLSLI
+
+#define INVALID_DESCRIPTOR_INDEX 0xFFFFFFFF
+
+struct Material {
+    uint albedoTexture;
+    float3 tint;
+};
+
+cbuffer DrawConstants : register(b0) {
+    uint materialBuffer;
+    uint materialIndex;
+};
+
+Texture2D textures[] : register(t0, space1);
+StructuredBuffer<Material> buffers[] : register(t0, space2);
+SamplerState linearSampler : register(s0);
+
+#endif
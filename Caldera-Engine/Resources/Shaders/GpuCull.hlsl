@@ -0,0 +1,92 @@
+// GPU-driven scene culling. Mirrors CullObjectsReference in GpuCulling.cpp; keep the two in sync.
+// Struct and constant layouts match GpuObjectData, IndirectDrawCommand and CullConstants.
+
+struct ObjectData {
+    float3 center;
+    float radius;
+    uint indexCount;
+    uint firstIndex;
+    int baseVertex;
+    uint materialIndex;
+};
+struct DrawCommand {
+    uint materialIndex;
+    uint indexCountPerInstance;
+    uint instanceCount;
+    uint startIndexLocation;
+    int baseVertexLocation;
+    uint startInstanceLocation;
+};
+cbuffer CullConstants : register(b0) {
+    float4 planes[6];
+    row_major float4x4 viewProjection;
+    uint objectCount;
+    uint hizIndex;
+    uint hizWidth;
+    uint hizHeight;
+    uint hizMipCount;
+};
+StructuredBuffer<ObjectData> objects : register(t0);
+RWStructuredBuffer<DrawCommand> commands : register(u0);
+RWByteAddressBuffer drawCount : register(u1);
+Texture2D<float> textures[] : register(t0, space1);
+
+bool InFrustum(float3 center, float radius) {
+    [unroll] for (uint i = 0; i < 6; ++i)
+        if (dot(planes[i].xyz, center) + planes[i].w < -radius)
+            return false;
+    return true;
+}
+
+bool VisibleHiZ(float3 center, float radius) {
+    float2 minUV = 1.0f, maxUV = 0.0f;
+    float minZ = 1.0f;
+    [unroll] for (uint corner = 0; corner < 8; ++corner) {
+        float3 offset = float3((corner & 1) ? radius : -radius, (corner & 2) ? radius : -radius, (corner & 4) ? radius : -radius);
+        float4 clip = mul(viewProjection, float4(center + offset, 1.0f));
+        if (clip.w <= 0.0f)
+            return true;
+        float2 uv = clip.xy / clip.w * float2(0.5f, -0.5f) + 0.5f;
+        minUV = min(minUV, uv);
+        maxUV = max(maxUV, uv);
+        minZ = min(minZ, clip.z / clip.w);
+    }
+    minUV = saturate(minUV);
+    maxUV = saturate(maxUV);
+
+    float extent = max((maxUV.x - minUV.x) * hizWidth, (maxUV.y - minUV.y) * hizHeight);
+    int mip = extent > 1.0f ? (int)ceil(log2(extent)) : 0;
+    mip = clamp(mip, 0, (int)hizMipCount - 1);
+
+    uint2 mipSize = max(uint2(hizWidth, hizHeight) >> mip, 1);
+    uint2 texel0 = min((uint2)(minUV * mipSize), mipSize - 1);
+    uint2 texel1 = min((uint2)(maxUV * mipSize), mipSize - 1);
+    Texture2D<float> hiz = textures[NonUniformResourceIndex(hizIndex)];
+    float farthest = max(max(hiz.Load(int3(texel0.x, texel0.y, mip)), hiz.Load(int3(texel1.x, texel0.y, mip))),
+                         max(hiz.Load(int3(texel0.x, texel1.y, mip)), hiz.Load(int3(texel1.x, texel1.y, mip))));
+    return minZ <= farthest;
+}
+
+[numthreads(64, 1, 1)]
+void CSMain(uint3 id : SV_DispatchThreadID) {
+    if (id.x >= objectCount)
+        return;
+
+    ObjectData object = objects[id.x];
+    if (!InFrustum(object.center, object.radius))
+        return;
+    if (hizIndex != 0xFFFFFFFF && !VisibleHiZ(object.center, object.radius))
+        return;
+
+    uint slot;
+    drawCount.InterlockedAdd(0, 1, slot);
+
+    DrawCommand command;
+    command.materialIndex = object.materialIndex;
+    command.indexCountPerInstance = object.indexCount;
+    command.instanceCount = 1;
+    command.startIndexLocation = object.firstIndex;
+    command.baseVertexLocation = object.baseVertex;
+    command.startInstanceLocation = 0;
+    commands[slot] = command;
+}
@@ -0,0 +1,34 @@
+// Scene geometry. Positions are still in clip space: the scene has no camera yet.
+#include "Bindless.hlsli"
+
+// Set by the ALBEDO_TEXTURE permutation; 0 skips the texture fetch entirely
+#ifndef ALBEDO_TEXTURE
+#define ALBEDO_TEXTURE 1
+#endif
+
+struct VSInput {
+    float3 position : POSITION;
+    float3 color : COLOR;
+};
+
+struct PSInput {
+    float4 position : SV_POSITION;
+    float3 color : COLOR;
+};
+
+PSInput VSMain(VSInput input) {
+    PSInput output;
+    output.position = float4(input.position, 1.0f);
+    output.color = input.color;
+    return output;
+}
+
+float4 PSMain(PSInput input) : SV_TARGET {
+    Material material = buffers[materialBuffer][materialIndex];
+    float3 albedo = input.color * material.tint;
+#if ALBEDO_TEXTURE
+    if (material.albedoTexture != INVALID_DESCRIPTOR_INDEX)
+        albedo *= textures[material.albedoTexture].Sample(linearSampler, input.color.xy).rgb;
+#endif
+    return float4(albedo, 1.0f);
+}
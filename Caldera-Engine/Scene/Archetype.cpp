@@ -0,0 +1,114 @@
+#include "Archetype.h"
+#include <cassert>
+#include <cstring>
+#include <new>
+
+static uint32_t AlignUp(uint32_t value, uint32_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Bytes the chunk layout needs for 'capacity' entities, with every column cache-line aligned
+static uint32_t GetLayoutSize(const std::vector<ComponentId>& components, uint32_t capacity)
+{
+    uint32_t size = capacity * sizeof(Entity);
+    for (ComponentId id : components)
+        size = AlignUp(size, MAX_COMPONENT_ALIGNMENT) + capacity * ComponentRegistry::Get(id).size;
+    return size;
+}
+
+Archetype::Archetype(ComponentMask mask)
+    : mask(mask)
+{
+    uint32_t rowSize = sizeof(Entity);
+    for (ComponentId id = 0; id < MAX_COMPONENT_TYPES; ++id) {
+        if (mask & GetComponentBit(id)) {
+            components.push_back(id);
+            rowSize += ComponentRegistry::Get(id).size;
+        }
+    }
+
+    // Start from the unpadded estimate and back off until the column padding fits too
+    capacity = CHUNK_SIZE / rowSize;
+    while (capacity > 1 && GetLayoutSize(components, capacity) > CHUNK_SIZE)
+        --capacity;
+    assert(GetLayoutSize(components, capacity) <= CHUNK_SIZE && "Components do not fit a single row in a chunk");
+
+    uint32_t offset = capacity * sizeof(Entity);
+    for (ComponentId id : components) {
+        offset = AlignUp(offset, MAX_COMPONENT_ALIGNMENT);
+        offsets[id] = offset;
+        offset += capacity * ComponentRegistry::Get(id).size;
+    }
+}
+
+Archetype::~Archetype()
+{
+    for (uint8_t* chunk : chunks)
+        ::operator delete(chunk, std::align_val_t(MAX_COMPONENT_ALIGNMENT));
+}
+
+uint32_t Archetype::GetChunkEntityCount(uint32_t chunk) const
+{
+    return chunk + 1 < GetChunkCount() ? capacity : entityCount - chunk * capacity;
+}
+
+void* Archetype::GetComponent(Location location, ComponentId id)
+{
+    if (!offsets[id])
+        return nullptr;
+    return chunks[location.chunk] + offsets[id] + size_t(location.row) * ComponentRegistry::Get(id).size;
+}
+
+Archetype::Location Archetype::Allocate(Entity entity)
+{
+    const Location location = { entityCount / capacity, entityCount % capacity };
+    if (location.chunk == chunks.size())
+        chunks.push_back(static_cast<uint8_t*>(::operator new(CHUNK_SIZE, std::align_val_t(MAX_COMPONENT_ALIGNMENT))));
+    ++entityCount;
+
+    GetEntities(location.chunk)[location.row] = entity;
+    for (ComponentId id : components) {
+        const ComponentInfo& info = ComponentRegistry::Get(id);
+        std::memcpy(GetComponent(location, id), info.defaultValue, info.size);
+    }
+    return location;
+}
+
+uint32_t Archetype::AllocateRows(uint32_t count)
+{
+    const uint32_t first = entityCount;
+    entityCount += count;
+    while (chunks.size() < GetChunkCount())
+        chunks.push_back(static_cast<uint8_t*>(::operator new(CHUNK_SIZE, std::align_val_t(MAX_COMPONENT_ALIGNMENT))));
+    return first;
+}
+
+Entity Archetype::Remove(Location location)
+{
+    assert(location.chunk * capacity + location.row < entityCount && "Row out of range");
+    const Location last = { (entityCount - 1) / capacity, (entityCount - 1) % capacity };
+    Entity moved = NULL_ENTITY;
+    if (location.chunk != last.chunk || location.row != last.row) {
+        moved = GetEntities(last.chunk)[last.row];
+        GetEntities(location.chunk)[location.row] = moved;
+        for (ComponentId id : components)
+            std::memcpy(GetComponent(location, id), GetComponent(last, id), ComponentRegistry::Get(id).size);
+    }
+
+    --entityCount;
+    // Keep one empty chunk around so an entity flipping in and out doesn't churn allocations
+    if (chunks.size() > 1 && entityCount <= (chunks.size() - 2) * capacity) {
+        ::operator delete(chunks.back(), std::align_val_t(MAX_COMPONENT_ALIGNMENT));
+        chunks.pop_back();
+    }
+    return moved;
+}
+
+void Archetype::CopyShared(Archetype& source, Location from, Archetype& target, Location to)
+{
+    for (ComponentId id : target.components) {
+        if (source.Has(id))
+            std::memcpy(target.GetComponent(to, id), source.GetComponent(from, id), ComponentRegistry::Get(id).size);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Component.h"
+#include "Entity.h"
+
+// Chunks are this size; every chunk of an archetype holds the same number of entities.
+constexpr uint32_t CHUNK_SIZE = 16 * 1024;
+
+// Storage for all entities with one exact set of components. Each 16 KB chunk
+// is laid out as structure-of-arrays: the entity handles first, then one
+// tightly packed array per component, each aligned for SIMD loads. Entities are
+// kept dense: removal moves the archetype's last entity into the hole, so every
+// chunk but the last is full.
+class Archetype {
+public:
+    struct Location {
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+    };
+
+    explicit Archetype(ComponentMask mask);
+    ~Archetype();
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+
+    ComponentMask GetMask() const { return mask; }
+    bool Has(ComponentId id) const { return (mask & GetComponentBit(id)) != 0; }
+    const std::vector<ComponentId>& GetComponents() const { return components; }
+
+    uint32_t GetChunkCapacity() const { return capacity; }
+    // Chunks holding at least one entity; a spare empty chunk may be kept past these.
+    uint32_t GetChunkCount() const { return (entityCount + capacity - 1) / capacity; }
+    uint32_t GetEntityCount() const { return entityCount; }
+    uint32_t GetChunkEntityCount(uint32_t chunk) const;
+
+    Entity* GetEntities(uint32_t chunk) { return reinterpret_cast<Entity*>(chunks[chunk]); }
+    const Entity* GetEntities(uint32_t chunk) const { return reinterpret_cast<const Entity*>(chunks[chunk]); }
+    // The chunk's array of component 'id', or null if the archetype lacks it.
+    void* GetColumn(uint32_t chunk, ComponentId id) { return offsets[id] ? chunks[chunk] + offsets[id] : nullptr; }
+    void* GetComponent(Location location, ComponentId id);
+
+    // Appends 'entity' with every component at its default value.
+    Location Allocate(Entity entity);
+    // Appends 'count' rows whose entity handles and components the caller fills
+    // in. Returns the first row; rows are numbered across chunks (chunk * capacity + row).
+    uint32_t AllocateRows(uint32_t count);
+    Location GetLocation(uint32_t row) const { return { row / capacity, row % capacity }; }
+    // Removes the row by moving the last entity into it. Returns the moved entity,
+    // whose location is now 'location', or NULL_ENTITY if the row was the last.
+    Entity Remove(Location location);
+    // Copies every component both archetypes have from 'source' into 'target'.
+    static void CopyShared(Archetype& source, Location from, Archetype& target, Location to);
+
+private:
+    ComponentMask mask = 0;
+    std::vector<ComponentId> components;
+    uint32_t offsets[MAX_COMPONENT_TYPES] = {};  // column byte offset per component id, 0 if absent
+    uint32_t capacity = 0;
+    std::vector<uint8_t*> chunks;
+    uint32_t entityCount = 0;
+};
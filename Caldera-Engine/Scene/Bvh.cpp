@@ -0,0 +1,293 @@
+#include "Bvh.h"
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+// SAH cost of visiting an inner node, relative to testing one primitive
+static constexpr float TRAVERSAL_COST = 1.0f;
+
+Aabb Aabb::Empty()
+{
+    Aabb box;
+    for (int axis = 0; axis < 3; ++axis) {
+        box.min[axis] = FLT_MAX;
+        box.max[axis] = -FLT_MAX;
+    }
+    return box;
+}
+
+Aabb Aabb::FromCenterExtents(const float center[3], const float extents[3])
+{
+    Aabb box;
+    for (int axis = 0; axis < 3; ++axis) {
+        box.min[axis] = center[axis] - extents[axis];
+        box.max[axis] = center[axis] + extents[axis];
+    }
+    return box;
+}
+
+void Aabb::Grow(const Aabb& other)
+{
+    for (int axis = 0; axis < 3; ++axis) {
+        min[axis] = std::min(min[axis], other.min[axis]);
+        max[axis] = std::max(max[axis], other.max[axis]);
+    }
+}
+
+void Aabb::Grow(const float point[3])
+{
+    for (int axis = 0; axis < 3; ++axis) {
+        min[axis] = std::min(min[axis], point[axis]);
+        max[axis] = std::max(max[axis], point[axis]);
+    }
+}
+
+bool Aabb::Contains(const Aabb& other) const
+{
+    for (int axis = 0; axis < 3; ++axis) {
+        if (other.min[axis] < min[axis] || other.max[axis] > max[axis])
+            return false;
+    }
+    return true;
+}
+
+bool Aabb::Overlaps(const Aabb& other) const
+{
+    for (int axis = 0; axis < 3; ++axis) {
+        if (other.min[axis] > max[axis] || other.max[axis] < min[axis])
+            return false;
+    }
+    return true;
+}
+
+float Aabb::GetSurfaceArea() const
+{
+    const float dx = max[0] - min[0];
+    const float dy = max[1] - min[1];
+    const float dz = max[2] - min[2];
+    if (dx < 0.0f || dy < 0.0f || dz < 0.0f)
+        return 0.0f;
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+Aabb Union(const Aabb& a, const Aabb& b)
+{
+    Aabb box = a;
+    box.Grow(b);
+    return box;
+}
+
+Ray::Ray(const float rayOrigin[3], const float rayDirection[3], float rayMaxT)
+    : maxT(rayMaxT)
+{
+    for (int axis = 0; axis < 3; ++axis) {
+        origin[axis] = rayOrigin[axis];
+        direction[axis] = rayDirection[axis];
+        // Zero components give an infinity, which the slab test handles
+        inverseDirection[axis] = 1.0f / rayDirection[axis];
+    }
+}
+
+Ray MakePickRay(const float inverseViewProjection[16], float ndcX, float ndcY)
+{
+    const float* m = inverseViewProjection;
+    float points[2][3];
+    for (int p = 0; p < 2; ++p) {
+        const float clip[4] = { ndcX, ndcY, static_cast<float>(p), 1.0f };
+        float world[4];
+        for (int r = 0; r < 4; ++r)
+            world[r] = m[r * 4 + 0] * clip[0] + m[r * 4 + 1] * clip[1] + m[r * 4 + 2] * clip[2] + m[r * 4 + 3] * clip[3];
+        for (int axis = 0; axis < 3; ++axis)
+            points[p][axis] = world[axis] / world[3];
+    }
+    const float direction[3] = { points[1][0] - points[0][0], points[1][1] - points[0][1], points[1][2] - points[0][2] };
+    return Ray(points[0], direction, 1.0f);
+}
+
+Aabb BvhNode::GetBounds() const
+{
+    Aabb box;
+    for (int axis = 0; axis < 3; ++axis) {
+        box.min[axis] = min[axis];
+        box.max[axis] = max[axis];
+    }
+    return box;
+}
+
+void BvhNode::SetBounds(const Aabb& box)
+{
+    for (int axis = 0; axis < 3; ++axis) {
+        min[axis] = box.min[axis];
+        max[axis] = box.max[axis];
+    }
+}
+
+namespace {
+
+// Primitives are moved around with their bounds during the build, so every
+// pass over a node's range reads memory in order
+struct BuildPrimitive {
+    Aabb box;
+    float centroid[3];
+    uint32_t index;
+};
+
+struct BvhBuilder {
+    uint32_t maxLeafSize;
+    std::vector<BvhNode>& nodes;
+    std::vector<BuildPrimitive>& primitives;
+
+    uint32_t MakeLeaf(uint32_t nodeIndex, uint32_t begin, uint32_t end)
+    {
+        nodes[nodeIndex].offset = begin;
+        nodes[nodeIndex].count = end - begin;
+        return nodeIndex;
+    }
+
+    // Builds the subtree over primitives[begin, end) and returns its node index
+    uint32_t Build(uint32_t begin, uint32_t end, uint32_t depth)
+    {
+        const uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+
+        Aabb box = Aabb::Empty();
+        Aabb centroids = Aabb::Empty();
+        for (uint32_t i = begin; i < end; ++i) {
+            box.Grow(primitives[i].box);
+            centroids.Grow(primitives[i].centroid);
+        }
+        nodes[nodeIndex].SetBounds(box);
+
+        const uint32_t count = end - begin;
+        if (count == 1)
+            return MakeLeaf(nodeIndex, begin, end);
+
+        // Best binned split over all three axes, binned in one pass over the primitives
+        int bestAxis = -1;
+        uint32_t bestBin = 0;
+        float bestCost = FLT_MAX;
+        if (depth < BVH_MAX_SAH_DEPTH) {
+            float scale[3];
+            for (int axis = 0; axis < 3; ++axis) {
+                const float extent = centroids.max[axis] - centroids.min[axis];
+                scale[axis] = extent > 0.0f ? BVH_BIN_COUNT / extent : 0.0f;
+            }
+
+            Aabb binBounds[3][BVH_BIN_COUNT];
+            uint32_t binCounts[3][BVH_BIN_COUNT] = {};
+            for (auto& axisBins : binBounds)
+                for (Aabb& bin : axisBins)
+                    bin = Aabb::Empty();
+            for (uint32_t i = begin; i < end; ++i) {
+                const BuildPrimitive& primitive = primitives[i];
+                for (int axis = 0; axis < 3; ++axis) {
+                    const uint32_t bin = std::min(BVH_BIN_COUNT - 1, static_cast<uint32_t>((primitive.centroid[axis] - centroids.min[axis]) * scale[axis]));
+                    binBounds[axis][bin].Grow(primitive.box);
+                    ++binCounts[axis][bin];
+                }
+            }
+
+            for (int axis = 0; axis < 3; ++axis) {
+                if (scale[axis] == 0.0f)
+                    continue;
+                // Sweep from the right for the suffix areas, then from the left for the costs
+                float rightArea[BVH_BIN_COUNT];
+                uint32_t rightCount[BVH_BIN_COUNT];
+                Aabb accumulated = Aabb::Empty();
+                uint32_t accumulatedCount = 0;
+                for (uint32_t bin = BVH_BIN_COUNT - 1; bin > 0; --bin) {
+                    accumulated.Grow(binBounds[axis][bin]);
+                    accumulatedCount += binCounts[axis][bin];
+                    rightArea[bin] = accumulated.GetSurfaceArea();
+                    rightCount[bin] = accumulatedCount;
+                }
+                accumulated = Aabb::Empty();
+                accumulatedCount = 0;
+                for (uint32_t bin = 0; bin + 1 < BVH_BIN_COUNT; ++bin) {
+                    accumulated.Grow(binBounds[axis][bin]);
+                    accumulatedCount += binCounts[axis][bin];
+                    if (accumulatedCount == 0 || rightCount[bin + 1] == 0)
+                        continue;
+                    const float cost = accumulated.GetSurfaceArea() * accumulatedCount + rightArea[bin + 1] * rightCount[bin + 1];
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestBin = bin;
+                    }
+                }
+            }
+        }
+
+        const float area = box.GetSurfaceArea();
+        const float leafCost = static_cast<float>(count);
+        const float splitCost = bestAxis >= 0 && area > 0.0f ? TRAVERSAL_COST + bestCost / area : FLT_MAX;
+        if (count <= maxLeafSize && leafCost <= splitCost)
+            return MakeLeaf(nodeIndex, begin, end);
+
+        uint32_t middle = begin;
+        if (bestAxis >= 0) {
+            const float low = centroids.min[bestAxis];
+            const float scale = BVH_BIN_COUNT / (centroids.max[bestAxis] - low);
+            middle = static_cast<uint32_t>(std::partition(primitives.begin() + begin, primitives.begin() + end, [&](const BuildPrimitive& primitive) {
+                return std::min(BVH_BIN_COUNT - 1, static_cast<uint32_t>((primitive.centroid[bestAxis] - low) * scale)) <= bestBin;
+            }) - primitives.begin());
+        }
+        if (middle == begin || middle == end) {
+            // Too deep, or all centroids coincide: split at the object median of the widest axis
+            int axis = 0;
+            for (int a = 1; a < 3; ++a) {
+                if (centroids.max[a] - centroids.min[a] > centroids.max[axis] - centroids.min[axis])
+                    axis = a;
+            }
+            middle = begin + count / 2;
+            std::nth_element(primitives.begin() + begin, primitives.begin() + middle, primitives.begin() + end,
+                [axis](const BuildPrimitive& a, const BuildPrimitive& b) { return a.centroid[axis] < b.centroid[axis]; });
+        }
+
+        Build(begin, middle, depth + 1);  // lands at nodeIndex + 1
+        const uint32_t right = Build(middle, end, depth + 1);
+        nodes[nodeIndex].offset = right;
+        nodes[nodeIndex].count = 0;
+        return nodeIndex;
+    }
+};
+
+} // namespace
+
+void BuildBvh(const Aabb* bounds, uint32_t count, uint32_t maxLeafSize, std::vector<BvhNode>& outNodes, std::vector<uint32_t>& outOrder)
+{
+    assert(maxLeafSize > 0 && "Leaves must hold at least one primitive");
+    outNodes.clear();
+    outOrder.resize(count);
+    if (count == 0)
+        return;
+
+    std::vector<BuildPrimitive> primitives(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        primitives[i].box = bounds[i];
+        for (int axis = 0; axis < 3; ++axis)
+            primitives[i].centroid[axis] = bounds[i].GetCenter(axis);
+        primitives[i].index = i;
+    }
+    outNodes.reserve(size_t(count) * 2 - 1);
+    BvhBuilder builder{ maxLeafSize, outNodes, primitives };
+    builder.Build(0, count, 0);
+    for (uint32_t i = 0; i < count; ++i)
+        outOrder[i] = primitives[i].index;
+}
+
+void RefitBvh(std::vector<BvhNode>& nodes, const std::vector<uint32_t>& order, const Aabb* bounds)
+{
+    // Children always follow their parent, so a reverse walk sees them first
+    for (size_t i = nodes.size(); i-- > 0;) {
+        BvhNode& node = nodes[i];
+        Aabb box = Aabb::Empty();
+        if (node.IsLeaf()) {
+            for (uint32_t p = 0; p < node.count; ++p)
+                box.Grow(bounds[order[node.offset + p]]);
+        } else {
+            box = Union(nodes[i + 1].GetBounds(), nodes[node.offset].GetBounds());
+        }
+        node.SetBounds(box);
+    }
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Shared pieces of the bounding volume hierarchies: boxes, rays and the
+// flattened node layout built by a binned SAH builder. Nodes are stored depth
+// first, so a node's left child directly follows it and only the right child
+// needs an index; a node is 32 bytes, two per cache line.
+
+struct Aabb {
+    float min[3] = { 0.0f, 0.0f, 0.0f };
+    float max[3] = { 0.0f, 0.0f, 0.0f };
+
+    // Inverted, so growing it by anything yields that thing.
+    static Aabb Empty();
+    static Aabb FromCenterExtents(const float center[3], const float extents[3]);
+
+    void Grow(const Aabb& other);
+    void Grow(const float point[3]);
+    bool Contains(const Aabb& other) const;
+    bool Overlaps(const Aabb& other) const;
+    float GetSurfaceArea() const;
+    float GetCenter(int axis) const { return (min[axis] + max[axis]) * 0.5f; }
+};
+
+Aabb Union(const Aabb& a, const Aabb& b);
+
+// Points along the ray are origin + t * direction for t in [0, maxT]. The
+// direction need not be normalized; the inverse is kept for the slab tests.
+struct Ray {
+    float origin[3] = { 0.0f, 0.0f, 0.0f };
+    float direction[3] = { 0.0f, 0.0f, 1.0f };
+    float inverseDirection[3] = { 0.0f, 0.0f, 1.0f };
+    float maxT = 1.0f;
+
+    Ray() = default;
+    Ray(const float origin[3], const float direction[3], float maxT);
+};
+
+// Ray through a viewport position in normalized device coordinates, from the
+// near plane (t = 0) to the far plane (t = 1). Row-major, clip = viewProjection * float4(p, 1).
+Ray MakePickRay(const float inverseViewProjection[16], float ndcX, float ndcY);
+
+// Entry distance of the ray into the box if it hits within [0, maxT]. Slab test;
+// inlined as it runs for every node a ray visits.
+inline bool IntersectRayAabb(const Ray& ray, const float boxMin[3], const float boxMax[3], float maxT, float& outEnter)
+{
+    float enter = 0.0f;
+    float exit = maxT;
+    for (int axis = 0; axis < 3; ++axis) {
+        float t0 = (boxMin[axis] - ray.origin[axis]) * ray.inverseDirection[axis];
+        float t1 = (boxMax[axis] - ray.origin[axis]) * ray.inverseDirection[axis];
+        if (t0 > t1)
+            std::swap(t0, t1);
+        // Written so a NaN from 0 * inf (ray in the slab's plane) leaves the range alone
+        enter = t0 > enter ? t0 : enter;
+        exit = t1 < exit ? t1 : exit;
+    }
+    outEnter = enter;
+    return enter <= exit;
+}
+
+inline bool IntersectRayAabb(const Ray& ray, const Aabb& box, float maxT, float& outEnter)
+{
+    return IntersectRayAabb(ray, box.min, box.max, maxT, outEnter);
+}
+
+struct BvhNode {
+    float min[3];
+    uint32_t offset;  // right child of an inner node, first primitive of a leaf
+    float max[3];
+    uint32_t count;   // primitives of a leaf, 0 for an inner node
+
+    bool IsLeaf() const { return count != 0; }
+    Aabb GetBounds() const;
+    void SetBounds(const Aabb& box);
+};
+static_assert(sizeof(BvhNode) == 32, "BvhNode should stay half a cache line");
+
+// SAH split candidates per axis.
+constexpr uint32_t BVH_BIN_COUNT = 12;
+// Past this depth nodes are split at the object median, which bounds the total
+// depth and so the fixed traversal stacks.
+constexpr uint32_t BVH_MAX_SAH_DEPTH = 32;
+// Ordered ray walks hold up to one entry per level plus one.
+constexpr uint32_t BVH_STACK_SIZE = 128;
+
+// Builds a hierarchy over 'count' primitive boxes. 'outOrder' lists primitive
+// indices so each leaf covers a contiguous range of it. Leaves hold at most
+// 'maxLeafSize' primitives, fewer where splitting is cheaper by the SAH.
+void BuildBvh(const Aabb* bounds, uint32_t count, uint32_t maxLeafSize, std::vector<BvhNode>& outNodes, std::vector<uint32_t>& outOrder);
+
+// Recomputes node bounds bottom-up after primitives moved, keeping the topology.
+void RefitBvh(std::vector<BvhNode>& nodes, const std::vector<uint32_t>& order, const Aabb* bounds);
+
+// Depth-first walk over the nodes whose boxes pass 'overlaps(node)'; calls
+// 'visit(primitive)' for every primitive in the leaves reached.
+template<typename OverlapFn, typename VisitFn>
+void TraverseBvh(const std::vector<BvhNode>& nodes, const std::vector<uint32_t>& order, OverlapFn&& overlaps, VisitFn&& visit)
+{
+    if (nodes.empty())
+        return;
+    uint32_t stack[BVH_STACK_SIZE];
+    uint32_t stackSize = 0;
+    uint32_t node = 0;
+    while (true) {
+        const BvhNode& current = nodes[node];
+        if (overlaps(current)) {
+            if (current.IsLeaf()) {
+                for (uint32_t i = 0; i < current.count; ++i)
+                    visit(order[current.offset + i]);
+            } else {
+                stack[stackSize++] = current.offset;
+                node = node + 1;
+                continue;
+            }
+        }
+        if (stackSize == 0)
+            break;
+        node = stack[--stackSize];
+    }
+}
+
+// Front-to-back ray walk: the nearer child is visited first and subtrees
+// entered past the current closest hit are skipped. 'hit(primitive, enter, closest)'
+// returns true after shrinking 'closest' to a hit of its own.
+template<typename HitFn>
+bool RayCastBvh(const std::vector<BvhNode>& nodes, const std::vector<uint32_t>& order, const Ray& ray, float& closest, HitFn&& hit)
+{
+    if (nodes.empty())
+        return false;
+    float enter;
+    if (!IntersectRayAabb(ray, nodes[0].min, nodes[0].max, closest, enter))
+        return false;
+
+    struct Entry { uint32_t node; float enter; };
+    Entry stack[BVH_STACK_SIZE];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = { 0, enter };
+    bool found = false;
+    while (stackSize > 0) {
+        const Entry entry = stack[--stackSize];
+        if (entry.enter > closest)
+            continue;
+        const BvhNode& current = nodes[entry.node];
+        if (current.IsLeaf()) {
+            for (uint32_t i = 0; i < current.count; ++i) {
+                const uint32_t primitive = order[current.offset + i];
+                found |= hit(primitive, entry.enter, closest);
+            }
+            continue;
+        }
+
+        const uint32_t left = entry.node + 1;
+        const uint32_t right = current.offset;
+        float leftEnter, rightEnter;
+        const bool hitLeft = IntersectRayAabb(ray, nodes[left].min, nodes[left].max, closest, leftEnter);
+        const bool hitRight = IntersectRayAabb(ray, nodes[right].min, nodes[right].max, closest, rightEnter);
+        // Push the farther one first so the nearer is popped next
+        if (hitLeft && hitRight) {
+            const bool leftFirst = leftEnter <= rightEnter;
+            stack[stackSize++] = leftFirst ? Entry{ right, rightEnter } : Entry{ left, leftEnter };
+            stack[stackSize++] = leftFirst ? Entry{ left, leftEnter } : Entry{ right, rightEnter };
+        } else if (hitLeft) {
+            stack[stackSize++] = { left, leftEnter };
+        } else if (hitRight) {
+            stack[stackSize++] = { right, rightEnter };
+        }
+    }
+    return found;
+}
@@ -0,0 +1,83 @@
+#include "CommandBuffer.h"
+#include "World.h"
+
+void EntityCommandBuffer::Append(const Header& header, const void* data, uint32_t dataSize)
+{
+    const size_t offset = stream.size();
+    stream.resize(offset + sizeof(Header) + dataSize);
+    std::memcpy(stream.data() + offset, &header, sizeof(Header));
+    if (dataSize)
+        std::memcpy(stream.data() + offset + sizeof(Header), data, dataSize);
+}
+
+void EntityCommandBuffer::Record(Op op, Entity entity, ComponentId component, const void* data, uint32_t size)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Header header;
+    header.op = op;
+    header.component = component;
+    header.entity = entity;
+    header.size = size;
+    Append(header, data, size);
+    ++commandCount;
+}
+
+void EntityCommandBuffer::Destroy(Entity entity)
+{
+    Record(Op::Destroy, entity, INVALID_COMPONENT, nullptr, 0);
+}
+
+void EntityCommandBuffer::Playback(World& world)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t offset = 0;
+    while (offset < stream.size()) {
+        // The stream is packed, so headers are copied out rather than read in place
+        Header header;
+        std::memcpy(&header, stream.data() + offset, sizeof(Header));
+        offset += sizeof(Header);
+
+        switch (header.op) {
+        case Op::Create: {
+            // Build the full component mask first so the entity lands in its archetype in one step
+            ComponentMask mask = 0;
+            size_t scan = offset;
+            for (uint32_t i = 0; i < header.size; ++i) {
+                Header component;
+                std::memcpy(&component, stream.data() + scan, sizeof(Header));
+                mask |= GetComponentBit(component.component);
+                scan += sizeof(Header) + component.size;
+            }
+            Entity entity = world.CreateWithComponents(mask);
+            for (uint32_t i = 0; i < header.size; ++i) {
+                Header component;
+                std::memcpy(&component, stream.data() + offset, sizeof(Header));
+                offset += sizeof(Header);
+                std::memcpy(world.GetComponent(entity, component.component), stream.data() + offset, component.size);
+                offset += component.size;
+            }
+            break;
+        }
+        case Op::Destroy:
+            world.Destroy(header.entity);
+            break;
+        case Op::Add:
+            if (void* component = world.AddComponent(header.entity, header.component))
+                std::memcpy(component, stream.data() + offset, header.size);
+            offset += header.size;
+            break;
+        case Op::Remove:
+            world.RemoveComponent(header.entity, header.component);
+            break;
+        }
+    }
+    stream.clear();
+    commandCount = 0;
+}
+
+void EntityCommandBuffer::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    stream.clear();
+    commandCount = 0;
+}
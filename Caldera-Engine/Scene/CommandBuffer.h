@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include "Component.h"
+#include "Entity.h"
+
+class World;
+
+// Records structural changes (create, destroy, add, remove) while a query runs
+// and applies them afterwards, in recording order. Recording is thread-safe so
+// the systems of a ParallelForEachChunk can share one buffer. Commands on
+// entities that are dead by playback time are skipped.
+class EntityCommandBuffer {
+public:
+    template<typename... Ts>
+    void Create(const Ts&... components);
+    void Destroy(Entity entity);
+    template<typename T>
+    void Add(Entity entity, const T& value = T{}) { Record(Op::Add, entity, GetComponentId<T>(), &value, sizeof(T)); }
+    template<typename T>
+    void Remove(Entity entity) { Record(Op::Remove, entity, GetComponentId<T>(), nullptr, 0); }
+
+    // Applies every command to 'world' and empties the buffer.
+    void Playback(World& world);
+    void Clear();
+
+    bool IsEmpty() const { return commandCount == 0; }
+    uint32_t GetCommandCount() const { return commandCount; }
+
+private:
+    enum class Op : uint8_t { Create, Destroy, Add, Remove };
+
+    // Add is followed by 'size' bytes of component data. For Create, 'size' is
+    // the number of Add records that follow with its initial components.
+    struct Header {
+        Op op = Op::Add;
+        ComponentId component = INVALID_COMPONENT;
+        Entity entity;
+        uint32_t size = 0;
+    };
+
+    void Record(Op op, Entity entity, ComponentId component, const void* data, uint32_t size);
+    void Append(const Header& header, const void* data, uint32_t dataSize);
+
+    std::mutex mutex;
+    std::vector<uint8_t> stream;
+    uint32_t commandCount = 0;
+};
+
+template<typename... Ts>
+void EntityCommandBuffer::Create(const Ts&... components)
+{
+    // The create and its components must land together between other threads' commands
+    std::lock_guard<std::mutex> lock(mutex);
+    Header header;
+    header.op = Op::Create;
+    header.size = sizeof...(Ts);
+    Append(header, nullptr, 0);
+    (Append({ Op::Add, GetComponentId<Ts>(), NULL_ENTITY, sizeof(Ts) }, &components, sizeof(Ts)), ...);
+    ++commandCount;
+}
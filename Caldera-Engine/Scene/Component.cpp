@@ -0,0 +1,52 @@
+#include "Component.h"
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <mutex>
+
+// Fixed storage so readers never see the table move while another thread registers
+static ComponentInfo componentInfos[MAX_COMPONENT_TYPES];
+static std::atomic<uint32_t> componentCount{ 0 };
+static std::mutex registryMutex;
+
+ComponentId ComponentRegistry::Register(const char* name, uint32_t size, uint32_t alignment, const void* defaultValue)
+{
+    assert(name && size > 0 && defaultValue && "Invalid component registration");
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    const uint32_t count = componentCount.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (std::strcmp(componentInfos[i].name, name) == 0) {
+            assert(componentInfos[i].size == size && componentInfos[i].alignment == alignment && "Component name registered with another layout");
+            return i;
+        }
+    }
+
+    assert(count < MAX_COMPONENT_TYPES && "Too many component types");
+    if (count >= MAX_COMPONENT_TYPES)
+        return INVALID_COMPONENT;
+    componentInfos[count] = { name, size, alignment, defaultValue };
+    componentCount.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+const ComponentInfo& ComponentRegistry::Get(ComponentId id)
+{
+    assert(id < componentCount.load(std::memory_order_acquire) && "Unknown component id");
+    return componentInfos[id];
+}
+
+ComponentId ComponentRegistry::Find(const char* name)
+{
+    const uint32_t count = componentCount.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (std::strcmp(componentInfos[i].name, name) == 0)
+            return i;
+    }
+    return INVALID_COMPONENT;
+}
+
+uint32_t ComponentRegistry::GetCount()
+{
+    return componentCount.load(std::memory_order_acquire);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+// Components are plain data: they are default-initialized from a registered
+// default value and moved between chunks with memcpy. Each component type names
+// itself through a COMPONENT_NAME constant and is assigned a small id on first use.
+
+using ComponentId = uint32_t;
+using ComponentMask = uint64_t;
+
+constexpr uint32_t MAX_COMPONENT_TYPES = 64;
+constexpr ComponentId INVALID_COMPONENT = 0xFFFFFFFFu;
+// Chunk columns are aligned to this, so no component may need more.
+constexpr uint32_t MAX_COMPONENT_ALIGNMENT = 64;
+
+struct ComponentInfo {
+    const char* name = nullptr;
+    uint32_t size = 0;
+    uint32_t alignment = 0;
+    const void* defaultValue = nullptr;
+};
+
+// Process-wide table of component types. Registration is thread-safe and ids are
+// never reused; lookups of registered ids need no locking.
+class ComponentRegistry {
+public:
+    // Returns the existing id if 'name' is already registered with the same layout.
+    static ComponentId Register(const char* name, uint32_t size, uint32_t alignment, const void* defaultValue);
+    static const ComponentInfo& Get(ComponentId id);
+    // INVALID_COMPONENT if no type of that name has been registered yet.
+    static ComponentId Find(const char* name);
+    static uint32_t GetCount();
+};
+
+template<typename T>
+ComponentId GetComponentId()
+{
+    using Type = std::remove_const_t<T>;
+    static_assert(std::is_trivially_copyable_v<Type>, "Components are plain data moved with memcpy");
+    static_assert(alignof(Type) <= MAX_COMPONENT_ALIGNMENT, "Component alignment exceeds the chunk column alignment");
+    static const Type defaultValue{};
+    static const ComponentId id = ComponentRegistry::Register(Type::COMPONENT_NAME, sizeof(Type), alignof(Type), &defaultValue);
+    return id;
+}
+
+inline ComponentMask GetComponentBit(ComponentId id) { return ComponentMask(1) << id; }
+
+template<typename... Ts>
+ComponentMask MakeComponentMask()
+{
+    return (ComponentMask(0) | ... | GetComponentBit(GetComponentId<Ts>()));
+}
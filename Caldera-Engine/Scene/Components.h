@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "Component.h"
+
+// Core scene components. Kept small and free of pointers so the chunk arrays
+// stay dense and a scene can be written out as raw bytes.
+
+struct TransformComponent {
+    static constexpr const char* COMPONENT_NAME = "Transform";
+    float position[3] = { 0.0f, 0.0f, 0.0f };
+    float rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };  // quaternion x, y, z, w
+    float scale[3] = { 1.0f, 1.0f, 1.0f };
+};
+
+// Rows of the transform's 3x4 matrix: rotation times scale, with the position in
+// the last column. The draw list uploads instance transforms in this layout.
+inline void GetTransformMatrix(const TransformComponent& transform, float outRows[12])
+{
+    const float x = transform.rotation[0], y = transform.rotation[1], z = transform.rotation[2], w = transform.rotation[3];
+    const float rotation[3][3] = {
+        { 1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y - z * w), 2.0f * (x * z + y * w) },
+        { 2.0f * (x * y + z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z - x * w) },
+        { 2.0f * (x * z - y * w), 2.0f * (y * z + x * w), 1.0f - 2.0f * (x * x + y * y) },
+    };
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c)
+            outRows[r * 4 + c] = rotation[r][c] * transform.scale[c];
+        outRows[r * 4 + 3] = transform.position[r];
+    }
+}
+
+// a * b for two matrices in the layout above: the transform that applies b, then a.
+inline void MultiplyTransformMatrices(const float a[12], const float b[12], float outRows[12])
+{
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 4; ++c) {
+            float value = c == 3 ? a[r * 4 + 3] : 0.0f;
+            for (int k = 0; k < 3; ++k)
+                value += a[r * 4 + k] * b[k * 4 + c];
+            outRows[r * 4 + c] = value;
+        }
+    }
+}
+
+// The entity's world matrix, in the layout above. SceneTransforms writes it from
+// the Transform, which is relative to the entity's parent when it has one.
+struct WorldTransformComponent {
+    static constexpr const char* COMPONENT_NAME = "WorldTransform";
+    float rows[12] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+};
+
+// Axis-aligned box in the entity's local space.
+struct BoundsComponent {
+    static constexpr const char* COMPONENT_NAME = "Bounds";
+    float center[3] = { 0.0f, 0.0f, 0.0f };
+    float extents[3] = { 0.5f, 0.5f, 0.5f };
+};
+
+// World-space box around the local bounds: the center is transformed and the
+// extents are projected onto each world axis through |rotation * scale|.
+inline void GetWorldBounds(const float matrix[12], const BoundsComponent& bounds, float outCenter[3], float outExtents[3])
+{
+    for (int r = 0; r < 3; ++r) {
+        outCenter[r] = matrix[r * 4 + 3];
+        outExtents[r] = 0.0f;
+        for (int c = 0; c < 3; ++c) {
+            const float m = matrix[r * 4 + c];
+            outCenter[r] += m * bounds.center[c];
+            outExtents[r] += std::fabs(m) * bounds.extents[c];
+        }
+    }
+}
+
+inline void GetWorldBounds(const TransformComponent& transform, const BoundsComponent& bounds, float outCenter[3], float outExtents[3])
+{
+    float matrix[12];
+    GetTransformMatrix(transform, matrix);
+    GetWorldBounds(matrix, bounds, outCenter, outExtents);
+}
+
+// What the renderer draws for the entity; ids match the draw list's tables.
+struct RenderableComponent {
+    static constexpr const char* COMPONENT_NAME = "Renderable";
+    uint32_t mesh = 0;
+    uint32_t material = 0;
+    uint32_t pipeline = 0;
+    uint32_t flags = 0;
+};
+
+// Components are registered on first use; loaders call this so a scene file can
+// name them before any code has touched them.
+inline void RegisterCoreComponents()
+{
+    GetComponentId<TransformComponent>();
+    GetComponentId<BoundsComponent>();
+    GetComponentId<RenderableComponent>();
+    GetComponentId<WorldTransformComponent>();
+}
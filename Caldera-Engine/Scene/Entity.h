@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+// Handle to an entity in a World. The generation changes every time the index
+// is reused, so handles to destroyed entities never alias new ones.
+struct Entity {
+    static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return index != INVALID_INDEX; }
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+constexpr Entity NULL_ENTITY = {};
@@ -0,0 +1,113 @@
+#include "MeshBvh.h"
+#include <cmath>
+
+bool MeshBvh::Build(const float* positions, uint32_t stride, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount)
+{
+    Clear();
+    const uint32_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return true;
+
+    // Checked up front in every build: the indices come from imported files
+    for (uint32_t i = 0; i < triangleCount * 3; ++i) {
+        if (indices[i] >= vertexCount)
+            return false;
+    }
+
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(positions);
+    auto vertex = [&](uint32_t index) {
+        return reinterpret_cast<const float*>(base + size_t(index) * stride);
+    };
+
+    std::vector<Aabb> triangleBounds(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        Aabb box = Aabb::Empty();
+        for (int k = 0; k < 3; ++k)
+            box.Grow(vertex(indices[t * 3 + k]));
+        triangleBounds[t] = box;
+    }
+    BuildBvh(triangleBounds.data(), triangleCount, LEAF_SIZE, nodes, order);
+    bounds = nodes[0].GetBounds();
+
+    // Store the triangles in leaf order so 'order' becomes the identity
+    triangles.resize(triangleCount);
+    for (uint32_t i = 0; i < triangleCount; ++i) {
+        const uint32_t t = order[i];
+        const float* p0 = vertex(indices[t * 3 + 0]);
+        const float* p1 = vertex(indices[t * 3 + 1]);
+        const float* p2 = vertex(indices[t * 3 + 2]);
+        Triangle& triangle = triangles[i];
+        for (int axis = 0; axis < 3; ++axis) {
+            triangle.v0[axis] = p0[axis];
+            triangle.edge1[axis] = p1[axis] - p0[axis];
+            triangle.edge2[axis] = p2[axis] - p0[axis];
+        }
+        triangle.index = t;
+        order[i] = i;
+    }
+    return true;
+}
+
+void MeshBvh::Clear()
+{
+    nodes.clear();
+    order.clear();
+    triangles.clear();
+    bounds = Aabb();
+}
+
+bool MeshBvh::RayCast(const Ray& ray, Hit& outHit) const
+{
+    float closest = ray.maxT;
+    return RayCastBvh(nodes, order, ray, closest, [&](uint32_t primitive, float, float& limit) {
+        // Moller-Trumbore
+        const Triangle& triangle = triangles[primitive];
+        const float* d = ray.direction;
+        const float* e1 = triangle.edge1;
+        const float* e2 = triangle.edge2;
+        const float p[3] = { d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0] };
+        const float determinant = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+        if (std::fabs(determinant) < 1e-12f)
+            return false;
+        const float inverse = 1.0f / determinant;
+        const float s[3] = { ray.origin[0] - triangle.v0[0], ray.origin[1] - triangle.v0[1], ray.origin[2] - triangle.v0[2] };
+        const float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverse;
+        if (u < 0.0f || u > 1.0f)
+            return false;
+        const float q[3] = { s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0] };
+        const float v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * inverse;
+        if (v < 0.0f || u + v > 1.0f)
+            return false;
+        const float t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inverse;
+        if (t < 0.0f || t > limit)
+            return false;
+
+        limit = t;
+        outHit.t = t;
+        outHit.triangle = triangle.index;
+        outHit.u = u;
+        outHit.v = v;
+        return true;
+    });
+}
+
+void MeshBvh::QueryAabb(const Aabb& box, std::vector<uint32_t>& outTriangles) const
+{
+    TraverseBvh(nodes, order,
+        [&](const BvhNode& node) {
+            return node.min[0] <= box.max[0] && node.max[0] >= box.min[0] &&
+                   node.min[1] <= box.max[1] && node.max[1] >= box.min[1] &&
+                   node.min[2] <= box.max[2] && node.max[2] >= box.min[2];
+        },
+        [&](uint32_t primitive) {
+            const Triangle& triangle = triangles[primitive];
+            Aabb triangleBox = Aabb::Empty();
+            triangleBox.Grow(triangle.v0);
+            const float p1[3] = { triangle.v0[0] + triangle.edge1[0], triangle.v0[1] + triangle.edge1[1], triangle.v0[2] + triangle.edge1[2] };
+            const float p2[3] = { triangle.v0[0] + triangle.edge2[0], triangle.v0[1] + triangle.edge2[1], triangle.v0[2] + triangle.edge2[2] };
+            triangleBox.Grow(p1);
+            triangleBox.Grow(p2);
+            if (triangleBox.Overlaps(box))
+                outTriangles.push_back(triangle.index);
+        });
+}
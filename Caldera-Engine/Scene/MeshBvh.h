@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Bvh.h"
+
+// Triangle hierarchy of one mesh in its local space, for exact picking. The
+// triangles are copied in leaf order as a vertex plus two edges, so a leaf's
+// ray tests read one contiguous block. Built once per mesh; ray casts are const
+// and may run on any number of threads.
+class MeshBvh {
+public:
+    static constexpr uint32_t LEAF_SIZE = 4;
+
+    struct Hit {
+        float t = 0.0f;
+        uint32_t triangle = 0;  // index into the mesh's triangles (first index / 3)
+        float u = 0.0f;         // barycentrics of vertices 1 and 2
+        float v = 0.0f;
+    };
+
+    // 'positions' points at the first vertex's xyz; for a Mesh pass
+    // &mesh.vertices[0].position.x with sizeof(Vertex) as the stride.
+    // Returns false, leaving the hierarchy empty, if an index is out of range.
+    bool Build(const float* positions, uint32_t stride, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+    void Clear();
+
+    // Closest hit within ray.maxT; both windings count.
+    bool RayCast(const Ray& ray, Hit& outHit) const;
+    // Triangles whose bounds overlap 'box', as mesh triangle indices.
+    void QueryAabb(const Aabb& box, std::vector<uint32_t>& outTriangles) const;
+
+    bool IsEmpty() const { return nodes.empty(); }
+    const Aabb& GetBounds() const { return bounds; }
+    uint32_t GetTriangleCount() const { return static_cast<uint32_t>(triangles.size()); }
+    uint32_t GetNodeCount() const { return static_cast<uint32_t>(nodes.size()); }
+
+private:
+    struct Triangle {
+        float v0[3];
+        float edge1[3];
+        float edge2[3];
+        uint32_t index;
+    };
+
+    std::vector<BvhNode> nodes;
+    std::vector<uint32_t> order;  // identity once the triangles are stored in leaf order
+    std::vector<Triangle> triangles;
+    Aabb bounds;
+};
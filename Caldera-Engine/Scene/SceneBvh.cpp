@@ -0,0 +1,321 @@
+#include "SceneBvh.h"
+#include <cassert>
+
+SceneBvh::ProxyId SceneBvh::CreateProxy(const Aabb& box, uint32_t userData, bool isStatic)
+{
+    ProxyId proxy;
+    if (!freeProxies.empty()) {
+        proxy = freeProxies.back();
+        freeProxies.pop_back();
+    } else {
+        proxy = static_cast<ProxyId>(proxies.size());
+        proxies.emplace_back();
+    }
+
+    Proxy& entry = proxies[proxy];
+    entry.box = box;
+    entry.userData = userData;
+    entry.isStatic = isStatic;
+    entry.alive = true;
+    entry.leaf = NULL_NODE;
+    if (isStatic) {
+        staticRebuild = true;
+        ++stats.staticProxies;
+    } else {
+        const uint32_t leaf = AllocateNode();
+        DynamicNode& node = dynamicNodes[leaf];
+        for (int axis = 0; axis < 3; ++axis) {
+            node.box.min[axis] = box.min[axis] - DYNAMIC_MARGIN;
+            node.box.max[axis] = box.max[axis] + DYNAMIC_MARGIN;
+        }
+        node.proxy = proxy;
+        node.height = 0;
+        entry.leaf = leaf;
+        InsertLeaf(leaf);
+        ++stats.dynamicProxies;
+    }
+    return proxy;
+}
+
+void SceneBvh::DestroyProxy(ProxyId proxy)
+{
+    if (!IsValid(proxy))
+        return;
+    Proxy& entry = proxies[proxy];
+    entry.alive = false;
+    if (entry.isStatic) {
+        // The static tree still lists the id until it is rebuilt, so it can't be handed out yet
+        pendingFree.push_back(proxy);
+        staticRebuild = true;
+        --stats.staticProxies;
+    } else {
+        RemoveLeaf(entry.leaf);
+        FreeNode(entry.leaf);
+        entry.leaf = NULL_NODE;
+        freeProxies.push_back(proxy);
+        --stats.dynamicProxies;
+    }
+}
+
+void SceneBvh::MoveProxy(ProxyId proxy, const Aabb& box)
+{
+    assert(IsValid(proxy) && "Moving a destroyed proxy");
+    Proxy& entry = proxies[proxy];
+    entry.box = box;
+    if (entry.isStatic) {
+        staticRefit = true;
+        return;
+    }
+
+    DynamicNode& leaf = dynamicNodes[entry.leaf];
+    if (leaf.box.Contains(box))
+        return;
+    RemoveLeaf(entry.leaf);
+    for (int axis = 0; axis < 3; ++axis) {
+        leaf.box.min[axis] = box.min[axis] - DYNAMIC_MARGIN;
+        leaf.box.max[axis] = box.max[axis] + DYNAMIC_MARGIN;
+    }
+    InsertLeaf(entry.leaf);
+    ++stats.reinserts;
+}
+
+void SceneBvh::Update()
+{
+    if (staticRebuild) {
+        RebuildStatic();
+    } else if (staticRefit) {
+        for (size_t i = 0; i < staticProxies.size(); ++i)
+            staticBounds[i] = proxies[staticProxies[i]].box;
+        RefitBvh(staticNodes, staticOrder, staticBounds.data());
+        ++stats.refits;
+    }
+    staticRefit = false;
+}
+
+void SceneBvh::Clear()
+{
+    proxies.clear();
+    freeProxies.clear();
+    pendingFree.clear();
+    staticNodes.clear();
+    staticOrder.clear();
+    staticProxies.clear();
+    staticBounds.clear();
+    staticRebuild = false;
+    staticRefit = false;
+    dynamicNodes.clear();
+    dynamicRoot = NULL_NODE;
+    freeNode = NULL_NODE;
+    stats = Stats();
+}
+
+SceneBvh::Stats SceneBvh::GetStats() const
+{
+    Stats current = stats;
+    current.staticNodes = static_cast<uint32_t>(staticNodes.size());
+    current.dynamicHeight = dynamicRoot == NULL_NODE ? 0 : static_cast<uint32_t>(dynamicNodes[dynamicRoot].height);
+    return current;
+}
+
+SceneBvh::ProxyId SceneBvh::RayCast(const Ray& ray, float& outT) const
+{
+    return RayCast(ray, outT, [&](ProxyId proxy, float& closest) {
+        float enter;
+        const Aabb& box = proxies[proxy].box;
+        if (!IntersectRayAabb(ray, box.min, box.max, closest, enter))
+            return false;
+        closest = enter;
+        return true;
+    });
+}
+
+bool SceneBvh::IsAabbInFrustum(const Frustum& frustum, const float boxMin[3], const float boxMax[3])
+{
+    for (const float* plane : frustum.planes) {
+        // The corner farthest along the plane normal
+        const float x = plane[0] >= 0.0f ? boxMax[0] : boxMin[0];
+        const float y = plane[1] >= 0.0f ? boxMax[1] : boxMin[1];
+        const float z = plane[2] >= 0.0f ? boxMax[2] : boxMin[2];
+        if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+void SceneBvh::RebuildStatic()
+{
+    staticProxies.clear();
+    staticBounds.clear();
+    for (ProxyId proxy = 0; proxy < proxies.size(); ++proxy) {
+        if (proxies[proxy].alive && proxies[proxy].isStatic) {
+            staticProxies.push_back(proxy);
+            staticBounds.push_back(proxies[proxy].box);
+        }
+    }
+    BuildBvh(staticBounds.data(), static_cast<uint32_t>(staticBounds.size()), STATIC_LEAF_SIZE, staticNodes, staticOrder);
+
+    freeProxies.insert(freeProxies.end(), pendingFree.begin(), pendingFree.end());
+    pendingFree.clear();
+    staticRebuild = false;
+    ++stats.rebuilds;
+}
+
+uint32_t SceneBvh::AllocateNode()
+{
+    uint32_t node;
+    if (freeNode != NULL_NODE) {
+        node = freeNode;
+        freeNode = dynamicNodes[node].parent;
+    } else {
+        node = static_cast<uint32_t>(dynamicNodes.size());
+        dynamicNodes.emplace_back();
+    }
+    dynamicNodes[node] = DynamicNode();
+    return node;
+}
+
+void SceneBvh::FreeNode(uint32_t node)
+{
+    dynamicNodes[node].parent = freeNode;
+    dynamicNodes[node].height = -1;
+    freeNode = node;
+}
+
+void SceneBvh::InsertLeaf(uint32_t leaf)
+{
+    if (dynamicRoot == NULL_NODE) {
+        dynamicRoot = leaf;
+        dynamicNodes[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    // Descend towards the sibling that grows the total surface area least
+    const Aabb leafBox = dynamicNodes[leaf].box;
+    uint32_t index = dynamicRoot;
+    while (!dynamicNodes[index].IsLeaf()) {
+        const DynamicNode& node = dynamicNodes[index];
+        const float area = node.box.GetSurfaceArea();
+        const float combinedArea = Union(node.box, leafBox).GetSurfaceArea();
+        // Cost of pairing with this node, and the growth every deeper pairing pays
+        const float cost = 2.0f * combinedArea;
+        const float inheritance = 2.0f * (combinedArea - area);
+
+        float childCosts[2];
+        for (int c = 0; c < 2; ++c) {
+            const DynamicNode& child = dynamicNodes[node.children[c]];
+            const float grown = Union(child.box, leafBox).GetSurfaceArea();
+            childCosts[c] = child.IsLeaf() ? grown + inheritance : grown - child.box.GetSurfaceArea() + inheritance;
+        }
+        if (cost < childCosts[0] && cost < childCosts[1])
+            break;
+        index = childCosts[0] < childCosts[1] ? node.children[0] : node.children[1];
+    }
+
+    // Pair the leaf with 'index' under a new parent
+    const uint32_t sibling = index;
+    const uint32_t oldParent = dynamicNodes[sibling].parent;
+    const uint32_t newParent = AllocateNode();
+    DynamicNode& parent = dynamicNodes[newParent];
+    parent.parent = oldParent;
+    parent.box = Union(leafBox, dynamicNodes[sibling].box);
+    parent.height = dynamicNodes[sibling].height + 1;
+    parent.children[0] = sibling;
+    parent.children[1] = leaf;
+    dynamicNodes[sibling].parent = newParent;
+    dynamicNodes[leaf].parent = newParent;
+    if (oldParent == NULL_NODE) {
+        dynamicRoot = newParent;
+    } else {
+        DynamicNode& grandParent = dynamicNodes[oldParent];
+        grandParent.children[grandParent.children[0] == sibling ? 0 : 1] = newParent;
+    }
+
+    // Refit and rebalance up to the root
+    for (index = dynamicNodes[leaf].parent; index != NULL_NODE; index = dynamicNodes[index].parent) {
+        index = Balance(index);
+        DynamicNode& node = dynamicNodes[index];
+        const DynamicNode& left = dynamicNodes[node.children[0]];
+        const DynamicNode& right = dynamicNodes[node.children[1]];
+        node.height = 1 + std::max(left.height, right.height);
+        node.box = Union(left.box, right.box);
+    }
+}
+
+void SceneBvh::RemoveLeaf(uint32_t leaf)
+{
+    if (leaf == dynamicRoot) {
+        dynamicRoot = NULL_NODE;
+        return;
+    }
+
+    // The sibling takes the parent's place
+    const uint32_t parent = dynamicNodes[leaf].parent;
+    const uint32_t grandParent = dynamicNodes[parent].parent;
+    const uint32_t sibling = dynamicNodes[parent].children[dynamicNodes[parent].children[0] == leaf ? 1 : 0];
+    FreeNode(parent);
+    dynamicNodes[sibling].parent = grandParent;
+    dynamicNodes[leaf].parent = NULL_NODE;
+    if (grandParent == NULL_NODE) {
+        dynamicRoot = sibling;
+        return;
+    }
+    DynamicNode& grand = dynamicNodes[grandParent];
+    grand.children[grand.children[0] == parent ? 0 : 1] = sibling;
+
+    for (uint32_t index = grandParent; index != NULL_NODE; index = dynamicNodes[index].parent) {
+        index = Balance(index);
+        DynamicNode& node = dynamicNodes[index];
+        const DynamicNode& left = dynamicNodes[node.children[0]];
+        const DynamicNode& right = dynamicNodes[node.children[1]];
+        node.height = 1 + std::max(left.height, right.height);
+        node.box = Union(left.box, right.box);
+    }
+}
+
+// Rotates the taller child up if the subtree is out of balance; returns the
+// subtree's new root.
+uint32_t SceneBvh::Balance(uint32_t a)
+{
+    DynamicNode& nodeA = dynamicNodes[a];
+    if (nodeA.IsLeaf() || nodeA.height < 2)
+        return a;
+
+    const uint32_t b = nodeA.children[0];
+    const uint32_t c = nodeA.children[1];
+    const int32_t balance = dynamicNodes[c].height - dynamicNodes[b].height;
+    if (balance >= -1 && balance <= 1)
+        return a;
+
+    // 'up' is the taller child, 'down' the other; 'up' replaces 'a' and 'a'
+    // adopts the shorter of up's children
+    const uint32_t up = balance > 0 ? c : b;
+    const uint32_t down = balance > 0 ? b : c;
+    const int upSlot = balance > 0 ? 1 : 0;
+    DynamicNode& nodeUp = dynamicNodes[up];
+    const uint32_t f = nodeUp.children[0];
+    const uint32_t g = nodeUp.children[1];
+
+    nodeUp.children[0] = a;
+    nodeUp.parent = nodeA.parent;
+    nodeA.parent = up;
+    if (nodeUp.parent == NULL_NODE) {
+        dynamicRoot = up;
+    } else {
+        DynamicNode& above = dynamicNodes[nodeUp.parent];
+        above.children[above.children[0] == a ? 0 : 1] = up;
+    }
+
+    const bool keepF = dynamicNodes[f].height > dynamicNodes[g].height;
+    const uint32_t kept = keepF ? f : g;
+    const uint32_t moved = keepF ? g : f;
+    nodeUp.children[1] = kept;
+    nodeA.children[upSlot] = moved;
+    nodeA.children[1 - upSlot] = down;
+    dynamicNodes[moved].parent = a;
+
+    nodeA.box = Union(dynamicNodes[nodeA.children[0]].box, dynamicNodes[nodeA.children[1]].box);
+    nodeA.height = 1 + std::max(dynamicNodes[nodeA.children[0]].height, dynamicNodes[nodeA.children[1]].height);
+    nodeUp.box = Union(nodeA.box, dynamicNodes[kept].box);
+    nodeUp.height = 1 + std::max(nodeA.height, dynamicNodes[kept].height);
+    return up;
+}
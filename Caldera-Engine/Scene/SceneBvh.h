@@ -0,0 +1,253 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Bvh.h"
+#include "../Rendering/FrustumCulling.h"
+
+// Spatial index of scene objects for picking, overlap and visibility queries.
+// Proxies are either static or dynamic:
+// - Static proxies live in a flattened tree built with the SAH. Adding or
+//   removing one rebuilds it on the next Update; moving one refits it.
+// - Dynamic proxies live in an incrementally balanced tree with enlarged boxes,
+//   so an object that moves a little doesn't touch the tree at all and one that
+//   leaves its box is reinserted on the spot.
+//
+// Queries are const and keep their state on the stack, so any number of threads
+// may query at once; creating, moving, destroying and Update need exclusive
+// access. Static changes become visible to queries at the next Update.
+class SceneBvh {
+public:
+    using ProxyId = uint32_t;
+    static constexpr ProxyId INVALID_PROXY = 0xFFFFFFFFu;
+    static constexpr uint32_t STATIC_LEAF_SIZE = 4;
+    // Dynamic boxes are enlarged by this much on every side.
+    static constexpr float DYNAMIC_MARGIN = 0.1f;
+
+    struct Stats {
+        uint32_t staticProxies = 0;
+        uint32_t dynamicProxies = 0;
+        uint32_t staticNodes = 0;
+        uint32_t dynamicHeight = 0;
+        uint32_t rebuilds = 0;
+        uint32_t refits = 0;
+        uint32_t reinserts = 0;  // dynamic moves that left their enlarged box
+    };
+
+    ProxyId CreateProxy(const Aabb& box, uint32_t userData, bool isStatic);
+    void DestroyProxy(ProxyId proxy);
+    void MoveProxy(ProxyId proxy, const Aabb& box);
+    // Rebuilds or refits the static tree as needed.
+    void Update();
+    void Clear();
+
+    bool IsValid(ProxyId proxy) const { return proxy < proxies.size() && proxies[proxy].alive; }
+    uint32_t GetUserData(ProxyId proxy) const { return proxies[proxy].userData; }
+    const Aabb& GetBounds(ProxyId proxy) const { return proxies[proxy].box; }
+    Stats GetStats() const;
+
+    // fn(proxy) for every proxy whose box overlaps 'box'.
+    template<typename Fn>
+    void QueryAabb(const Aabb& box, Fn&& fn) const;
+    // fn(proxy) for every proxy whose box is not entirely outside one of the planes.
+    template<typename Fn>
+    void QueryFrustum(const Frustum& frustum, Fn&& fn) const;
+    // Closest proxy whose box the ray hits, or INVALID_PROXY. 'outT' is the entry distance.
+    ProxyId RayCast(const Ray& ray, float& outT) const;
+    // Same, with 'exact(proxy, closest)' refining each box hit against the actual
+    // geometry: it returns true and shrinks 'closest' if it hits nearer.
+    template<typename Fn>
+    ProxyId RayCast(const Ray& ray, float& outT, Fn&& exact) const;
+
+private:
+    static constexpr uint32_t NULL_NODE = 0xFFFFFFFFu;
+
+    struct Proxy {
+        Aabb box;
+        uint32_t userData = 0;
+        uint32_t leaf = NULL_NODE;  // dynamic tree node
+        bool isStatic = false;
+        bool alive = false;
+    };
+
+    struct DynamicNode {
+        Aabb box;  // enlarged for leaves
+        uint32_t parent = NULL_NODE;
+        uint32_t children[2] = { NULL_NODE, NULL_NODE };
+        uint32_t proxy = INVALID_PROXY;
+        int32_t height = 0;  // 0 for leaves, -1 when free
+
+        bool IsLeaf() const { return children[0] == NULL_NODE; }
+    };
+
+    static bool IsAabbInFrustum(const Frustum& frustum, const float boxMin[3], const float boxMax[3]);
+
+    uint32_t AllocateNode();
+    void FreeNode(uint32_t node);
+    void InsertLeaf(uint32_t leaf);
+    void RemoveLeaf(uint32_t leaf);
+    uint32_t Balance(uint32_t node);
+    void RebuildStatic();
+
+    template<typename OverlapFn, typename VisitFn>
+    void TraverseDynamic(OverlapFn&& overlaps, VisitFn&& visit) const;
+
+    std::vector<Proxy> proxies;
+    std::vector<ProxyId> freeProxies;
+    std::vector<ProxyId> pendingFree;  // destroyed static proxies the tree still lists
+
+    // Static tree; leaves index staticProxies through staticOrder
+    std::vector<BvhNode> staticNodes;
+    std::vector<uint32_t> staticOrder;
+    std::vector<ProxyId> staticProxies;
+    std::vector<Aabb> staticBounds;
+    bool staticRebuild = false;
+    bool staticRefit = false;
+
+    // Dynamic tree
+    std::vector<DynamicNode> dynamicNodes;
+    uint32_t dynamicRoot = NULL_NODE;
+    uint32_t freeNode = NULL_NODE;  // free list through 'parent'
+
+    Stats stats;
+};
+
+template<typename OverlapFn, typename VisitFn>
+void SceneBvh::TraverseDynamic(OverlapFn&& overlaps, VisitFn&& visit) const
+{
+    if (dynamicRoot == NULL_NODE)
+        return;
+    // Balancing keeps the height logarithmic; the vector only takes over for huge trees
+    uint32_t stack[BVH_STACK_SIZE];
+    std::vector<uint32_t> overflow;
+    uint32_t stackSize = 0;
+    stack[stackSize++] = dynamicRoot;
+    while (stackSize > 0 || !overflow.empty()) {
+        uint32_t node;
+        if (!overflow.empty()) {
+            node = overflow.back();
+            overflow.pop_back();
+        } else {
+            node = stack[--stackSize];
+        }
+        const DynamicNode& current = dynamicNodes[node];
+        if (!overlaps(current.box))
+            continue;
+        if (current.IsLeaf()) {
+            visit(current.proxy);
+            continue;
+        }
+        for (uint32_t child : current.children) {
+            if (stackSize < BVH_STACK_SIZE)
+                stack[stackSize++] = child;
+            else
+                overflow.push_back(child);
+        }
+    }
+}
+
+template<typename Fn>
+void SceneBvh::QueryAabb(const Aabb& box, Fn&& fn) const
+{
+    TraverseBvh(staticNodes, staticOrder,
+        [&](const BvhNode& node) {
+            return node.min[0] <= box.max[0] && node.max[0] >= box.min[0] &&
+                   node.min[1] <= box.max[1] && node.max[1] >= box.min[1] &&
+                   node.min[2] <= box.max[2] && node.max[2] >= box.min[2];
+        },
+        [&](uint32_t primitive) {
+            const ProxyId proxy = staticProxies[primitive];
+            if (proxies[proxy].alive && proxies[proxy].box.Overlaps(box))
+                fn(proxy);
+        });
+    TraverseDynamic([&](const Aabb& nodeBox) { return nodeBox.Overlaps(box); },
+        [&](ProxyId proxy) {
+            if (proxies[proxy].box.Overlaps(box))
+                fn(proxy);
+        });
+}
+
+template<typename Fn>
+void SceneBvh::QueryFrustum(const Frustum& frustum, Fn&& fn) const
+{
+    TraverseBvh(staticNodes, staticOrder,
+        [&](const BvhNode& node) { return IsAabbInFrustum(frustum, node.min, node.max); },
+        [&](uint32_t primitive) {
+            const ProxyId proxy = staticProxies[primitive];
+            const Aabb& box = proxies[proxy].box;
+            if (proxies[proxy].alive && IsAabbInFrustum(frustum, box.min, box.max))
+                fn(proxy);
+        });
+    TraverseDynamic([&](const Aabb& nodeBox) { return IsAabbInFrustum(frustum, nodeBox.min, nodeBox.max); },
+        [&](ProxyId proxy) {
+            const Aabb& box = proxies[proxy].box;
+            if (IsAabbInFrustum(frustum, box.min, box.max))
+                fn(proxy);
+        });
+}
+
+template<typename Fn>
+SceneBvh::ProxyId SceneBvh::RayCast(const Ray& ray, float& outT, Fn&& exact) const
+{
+    ProxyId closestProxy = INVALID_PROXY;
+    float closest = ray.maxT;
+    auto test = [&](ProxyId proxy, float& limit) {
+        float enter;
+        const Aabb& box = proxies[proxy].box;
+        if (!IntersectRayAabb(ray, box.min, box.max, limit, enter))
+            return false;
+        if (!exact(proxy, limit))
+            return false;
+        closestProxy = proxy;
+        return true;
+    };
+
+    RayCastBvh(staticNodes, staticOrder, ray, closest, [&](uint32_t primitive, float, float& limit) {
+        const ProxyId proxy = staticProxies[primitive];
+        return proxies[proxy].alive && test(proxy, limit);
+    });
+
+    // The dynamic tree is walked the same way, nearer child first
+    if (dynamicRoot != NULL_NODE) {
+        struct Entry { uint32_t node; float enter; };
+        Entry stack[BVH_STACK_SIZE];
+        std::vector<Entry> overflow;
+        uint32_t stackSize = 0;
+        float enter;
+        if (IntersectRayAabb(ray, dynamicNodes[dynamicRoot].box, closest, enter))
+            stack[stackSize++] = { dynamicRoot, enter };
+        while (stackSize > 0 || !overflow.empty()) {
+            Entry entry;
+            if (!overflow.empty()) {
+                entry = overflow.back();
+                overflow.pop_back();
+            } else {
+                entry = stack[--stackSize];
+            }
+            if (entry.enter > closest)
+                continue;
+            const DynamicNode& current = dynamicNodes[entry.node];
+            if (current.IsLeaf()) {
+                test(current.proxy, closest);
+                continue;
+            }
+            Entry hits[2];
+            uint32_t hitCount = 0;
+            for (uint32_t child : current.children) {
+                if (IntersectRayAabb(ray, dynamicNodes[child].box, closest, enter))
+                    hits[hitCount++] = { child, enter };
+            }
+            if (hitCount == 2 && hits[0].enter < hits[1].enter)
+                std::swap(hits[0], hits[1]);
+            for (uint32_t i = 0; i < hitCount; ++i) {
+                if (stackSize < BVH_STACK_SIZE)
+                    stack[stackSize++] = hits[i];
+                else
+                    overflow.push_back(hits[i]);
+            }
+        }
+    }
+
+    outT = closest;
+    return closestProxy;
+}
@@ -0,0 +1,536 @@
+#include "SceneSerializer.h"
+#include "Components.h"
+#include "World.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+static constexpr uint32_t SCENE_FILE_MAGIC = 0x4e435343; // "CSCN"
+static constexpr uint32_t SCENE_FILE_VERSION = 2;
+// Chunk slots start on a page boundary so a mapped file can hand them out directly
+static constexpr uint32_t SCENE_DATA_ALIGNMENT = 4096;
+// Slots are the size of a World chunk, so one always holds a chunk's columns
+static constexpr uint32_t SCENE_SLOT_SIZE = CHUNK_SIZE;
+
+struct SceneFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entityCount;
+    uint32_t stringTableSize;
+    uint64_t fileSize;
+    uint64_t dataOffset;
+    uint32_t stringTableOffset;
+    uint32_t componentTableOffset;
+    uint32_t componentCount;
+    uint32_t archetypeTableOffset;
+    uint32_t archetypeCount;
+    uint32_t columnTableOffset;
+    uint32_t columnCount;
+    uint32_t chunkTableOffset;
+    uint32_t chunkCount;
+    uint32_t tablesHash;  // of the header, with this field zero, and every table
+};
+static_assert(sizeof(SceneFileHeader) == 72, "SceneFileHeader layout is part of the file format");
+
+struct SceneComponentRecord {
+    uint32_t nameOffset;  // into the string table
+    uint32_t size;
+};
+
+// Chunks [firstChunk, firstChunk + chunkCount) belong to the archetype, in order
+struct SceneArchetypeRecord {
+    uint32_t firstColumn;
+    uint32_t columnCount;
+    uint32_t firstChunk;
+    uint32_t chunkCount;
+    uint32_t capacity;  // rows per chunk
+    uint32_t reserved;
+};
+
+// A component's array within each of its archetype's chunk slots
+struct SceneColumnRecord {
+    uint32_t component;
+    uint32_t offset;
+};
+
+struct SceneChunkRecord {
+    uint64_t hash;        // of the slot's bytes
+    uint32_t archetype;
+    uint32_t entityCount;
+};
+
+static uint32_t AlignUp(uint32_t value, uint32_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// 64-bit word hash of a slot or the tables. Each step is invertible, so a file
+// that differs from what was written in a single word always hashes differently.
+static uint64_t HashSlot(const uint8_t* data, size_t size)
+{
+    uint64_t hash = 0x9e3779b97f4a7c15ull ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+        hash ^= hash >> 32;
+    }
+    for (; i < size; ++i)
+        hash = (hash ^ data[i]) * 0x100000001b3ull;
+    return hash;
+}
+
+// Header and tables up to the end of the chunk table; the header's own hash field counts as zero
+static uint32_t HashTables(const uint8_t* bytes, uint64_t tablesEnd)
+{
+    SceneFileHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+    header.tablesHash = 0;
+    const uint64_t hash = HashSlot(reinterpret_cast<const uint8_t*>(&header), sizeof(header)) ^
+        HashSlot(bytes + sizeof(header), tablesEnd - sizeof(header));
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+template<typename T>
+static void AppendRecords(std::vector<uint8_t>& bytes, const std::vector<T>& records)
+{
+    const size_t at = bytes.size();
+    bytes.resize(at + records.size() * sizeof(T));
+    if (!records.empty())
+        std::memcpy(bytes.data() + at, records.data(), records.size() * sizeof(T));
+}
+
+namespace {
+
+// A validated scene file in memory; the record pointers point into the file's bytes
+struct SceneFileView {
+    const uint8_t* bytes = nullptr;
+    const SceneFileHeader* header = nullptr;
+    const char* strings = nullptr;
+    const SceneComponentRecord* components = nullptr;
+    const SceneArchetypeRecord* archetypes = nullptr;
+    const SceneColumnRecord* columns = nullptr;
+    const SceneChunkRecord* chunks = nullptr;
+
+    const uint8_t* GetSlot(uint32_t chunk) const { return bytes + header->dataOffset + uint64_t(chunk) * SCENE_SLOT_SIZE; }
+    const char* GetName(uint32_t component) const { return strings + components[component].nameOffset; }
+};
+
+bool RangeFits(uint64_t offset, uint64_t size, uint64_t fileSize)
+{
+    return offset <= fileSize && size <= fileSize - offset;
+}
+
+bool ParseSceneFile(const std::vector<uint8_t>& bytes, SceneFileView& view)
+{
+    if (bytes.size() < sizeof(SceneFileHeader))
+        return false;
+    const SceneFileHeader* header = reinterpret_cast<const SceneFileHeader*>(bytes.data());
+    const uint64_t size = bytes.size();
+    if (header->magic != SCENE_FILE_MAGIC || header->version != SCENE_FILE_VERSION || header->fileSize != size)
+        return false;
+
+    // The writer aligns every table for its records; anything else is corrupt
+    const uint32_t tableOffsets[] = { header->componentTableOffset, header->archetypeTableOffset,
+                                      header->columnTableOffset };
+    for (uint32_t offset : tableOffsets) {
+        if (offset % 4 != 0)
+            return false;
+    }
+    if (header->chunkTableOffset % alignof(SceneChunkRecord) != 0)
+        return false;
+    if (!RangeFits(header->stringTableOffset, header->stringTableSize, size) ||
+        !RangeFits(header->componentTableOffset, uint64_t(header->componentCount) * sizeof(SceneComponentRecord), size) ||
+        !RangeFits(header->archetypeTableOffset, uint64_t(header->archetypeCount) * sizeof(SceneArchetypeRecord), size) ||
+        !RangeFits(header->columnTableOffset, uint64_t(header->columnCount) * sizeof(SceneColumnRecord), size) ||
+        !RangeFits(header->chunkTableOffset, uint64_t(header->chunkCount) * sizeof(SceneChunkRecord), size) ||
+        !RangeFits(header->dataOffset, uint64_t(header->chunkCount) * SCENE_SLOT_SIZE, size))
+        return false;
+    if (header->tablesHash != HashTables(bytes.data(), header->chunkTableOffset + uint64_t(header->chunkCount) * sizeof(SceneChunkRecord)))
+        return false;
+
+    view.bytes = bytes.data();
+    view.header = header;
+    view.strings = reinterpret_cast<const char*>(bytes.data() + header->stringTableOffset);
+    view.components = reinterpret_cast<const SceneComponentRecord*>(bytes.data() + header->componentTableOffset);
+    view.archetypes = reinterpret_cast<const SceneArchetypeRecord*>(bytes.data() + header->archetypeTableOffset);
+    view.columns = reinterpret_cast<const SceneColumnRecord*>(bytes.data() + header->columnTableOffset);
+    view.chunks = reinterpret_cast<const SceneChunkRecord*>(bytes.data() + header->chunkTableOffset);
+
+    for (uint32_t i = 0; i < header->componentCount; ++i) {
+        const SceneComponentRecord& component = view.components[i];
+        if (component.nameOffset >= header->stringTableSize || component.size == 0 || component.size > SCENE_SLOT_SIZE)
+            return false;
+        if (!std::memchr(view.strings + component.nameOffset, 0, header->stringTableSize - component.nameOffset))
+            return false;
+    }
+
+    uint64_t entityCount = 0;
+    uint32_t nextChunk = 0;
+    for (uint32_t a = 0; a < header->archetypeCount; ++a) {
+        const SceneArchetypeRecord& archetype = view.archetypes[a];
+        if (archetype.capacity == 0 || archetype.firstChunk != nextChunk ||
+            archetype.chunkCount > header->chunkCount - nextChunk ||
+            archetype.columnCount > header->columnCount || archetype.firstColumn > header->columnCount - archetype.columnCount)
+            return false;
+        nextChunk += archetype.chunkCount;
+
+        // The writer hashes each slot up to the end of its last column
+        uint64_t slotUsed = 0;
+        for (uint32_t c = 0; c < archetype.columnCount; ++c) {
+            const SceneColumnRecord& column = view.columns[archetype.firstColumn + c];
+            if (column.component >= header->componentCount ||
+                !RangeFits(column.offset, uint64_t(archetype.capacity) * view.components[column.component].size, SCENE_SLOT_SIZE))
+                return false;
+            slotUsed = std::max(slotUsed, column.offset + uint64_t(archetype.capacity) * view.components[column.component].size);
+        }
+        for (uint32_t k = 0; k < archetype.chunkCount; ++k) {
+            const SceneChunkRecord& chunk = view.chunks[archetype.firstChunk + k];
+            if (chunk.archetype != a || chunk.entityCount > archetype.capacity ||
+                chunk.hash != HashSlot(view.GetSlot(archetype.firstChunk + k), static_cast<size_t>(slotUsed)))
+                return false;
+            entityCount += chunk.entityCount;
+        }
+    }
+    return nextChunk == header->chunkCount && entityCount == header->entityCount;
+}
+
+bool ReadFile(const std::string& path, std::vector<uint8_t>& bytes)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+    const std::streamoff size = file.tellg();
+    if (size < 0)
+        return false;
+    bytes.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(bytes.data()), size);
+    return file.good() || file.eof();
+}
+
+} // namespace
+
+bool SceneSerializer::Save(World& world, const std::string& path)
+{
+    saveStats = SceneSaveStats();
+
+    // Components used by any saved archetype, in id order, and their names
+    std::vector<Archetype*> archetypes;
+    ComponentMask used = 0;
+    for (const std::unique_ptr<Archetype>& archetype : world.GetArchetypes()) {
+        if (archetype->GetEntityCount() == 0)
+            continue;
+        archetypes.push_back(archetype.get());
+        used |= archetype->GetMask();
+    }
+
+    std::vector<char> strings;
+    std::vector<SceneComponentRecord> components;
+    uint32_t fileComponent[MAX_COMPONENT_TYPES] = {};
+    for (ComponentId id = 0; id < MAX_COMPONENT_TYPES; ++id) {
+        if (!(used & GetComponentBit(id)))
+            continue;
+        const ComponentInfo& info = ComponentRegistry::Get(id);
+        fileComponent[id] = static_cast<uint32_t>(components.size());
+        components.push_back({ static_cast<uint32_t>(strings.size()), info.size });
+        strings.insert(strings.end(), info.name, info.name + std::strlen(info.name) + 1);
+    }
+    strings.resize(AlignUp(static_cast<uint32_t>(strings.size()), 4), '\0');
+
+    // Columns are packed from the start of each slot, cache-line aligned like the chunks
+    std::vector<SceneArchetypeRecord> archetypeRecords;
+    std::vector<SceneColumnRecord> columns;
+    std::vector<uint32_t> slotUsed;  // bytes of the slot the archetype's columns cover
+    uint32_t chunkCount = 0;
+    for (Archetype* archetype : archetypes) {
+        SceneArchetypeRecord record = {};
+        record.firstColumn = static_cast<uint32_t>(columns.size());
+        record.columnCount = static_cast<uint32_t>(archetype->GetComponents().size());
+        record.firstChunk = chunkCount;
+        record.chunkCount = archetype->GetChunkCount();
+        record.capacity = archetype->GetChunkCapacity();
+        uint32_t offset = 0;
+        for (ComponentId id : archetype->GetComponents()) {
+            offset = AlignUp(offset, MAX_COMPONENT_ALIGNMENT);
+            columns.push_back({ fileComponent[id], offset });
+            offset += record.capacity * ComponentRegistry::Get(id).size;
+        }
+        assert(offset <= SCENE_SLOT_SIZE && "Archetype columns exceed a slot");
+        slotUsed.push_back(offset);
+        archetypeRecords.push_back(record);
+        chunkCount += record.chunkCount;
+    }
+
+    // Tables, in file order after the header
+    SceneFileHeader header = {};
+    header.magic = SCENE_FILE_MAGIC;
+    header.version = SCENE_FILE_VERSION;
+    header.entityCount = world.GetEntityCount();
+    std::vector<uint8_t> layout;
+    header.stringTableOffset = sizeof(SceneFileHeader);
+    header.stringTableSize = static_cast<uint32_t>(strings.size());
+    layout.insert(layout.end(), strings.begin(), strings.end());
+    header.componentTableOffset = sizeof(SceneFileHeader) + static_cast<uint32_t>(layout.size());
+    header.componentCount = static_cast<uint32_t>(components.size());
+    AppendRecords(layout, components);
+    header.archetypeTableOffset = sizeof(SceneFileHeader) + static_cast<uint32_t>(layout.size());
+    header.archetypeCount = static_cast<uint32_t>(archetypeRecords.size());
+    AppendRecords(layout, archetypeRecords);
+    header.columnTableOffset = sizeof(SceneFileHeader) + static_cast<uint32_t>(layout.size());
+    header.columnCount = static_cast<uint32_t>(columns.size());
+    AppendRecords(layout, columns);
+    layout.resize(AlignUp(static_cast<uint32_t>(layout.size()), alignof(SceneChunkRecord)), 0);
+    header.chunkTableOffset = sizeof(SceneFileHeader) + static_cast<uint32_t>(layout.size());
+    header.chunkCount = chunkCount;
+    const uint32_t tablesEnd = header.chunkTableOffset + chunkCount * static_cast<uint32_t>(sizeof(SceneChunkRecord));
+    header.dataOffset = AlignUp(tablesEnd, SCENE_DATA_ALIGNMENT);
+    header.fileSize = header.dataOffset + uint64_t(chunkCount) * SCENE_SLOT_SIZE;
+
+    // Same tables and size as the file on disk: chunk slots sit where they did. The
+    // file must also be as this serializer left it; anything else rewrites it whole.
+    const bool incremental = path == lastPath && layout == lastLayout && header.fileSize == lastFileSize &&
+        lastChunkHashes.size() == chunkCount && IsFileUnchanged(path);
+
+    const std::string writePath = incremental ? path : path + ".tmp";
+    std::fstream file(writePath, incremental ? (std::ios::binary | std::ios::in | std::ios::out)
+                                             : (std::ios::binary | std::ios::out | std::ios::trunc));
+    if (!file)
+        return false;
+
+    // Slots first, so the chunk table can carry their hashes
+    std::vector<SceneChunkRecord> chunks(chunkCount);
+    std::vector<uint8_t> slot(SCENE_SLOT_SIZE);
+    if (!incremental)
+        file.seekp(static_cast<std::streamoff>(header.dataOffset));
+    uint32_t chunkIndex = 0;
+    for (size_t a = 0; a < archetypes.size(); ++a) {
+        Archetype* archetype = archetypes[a];
+        const SceneArchetypeRecord& record = archetypeRecords[a];
+        for (uint32_t k = 0; k < record.chunkCount; ++k, ++chunkIndex) {
+            const uint32_t count = archetype->GetChunkEntityCount(k);
+            std::fill(slot.begin(), slot.begin() + slotUsed[a], uint8_t(0));
+            for (uint32_t c = 0; c < record.columnCount; ++c) {
+                const ComponentId id = archetype->GetComponents()[c];
+                std::memcpy(slot.data() + columns[record.firstColumn + c].offset, archetype->GetColumn(k, id),
+                    size_t(count) * ComponentRegistry::Get(id).size);
+            }
+
+            SceneChunkRecord& chunk = chunks[chunkIndex];
+            chunk.hash = HashSlot(slot.data(), slotUsed[a]);
+            chunk.archetype = static_cast<uint32_t>(a);
+            chunk.entityCount = count;
+            if (incremental) {
+                if (chunk.hash == lastChunkHashes[chunkIndex])
+                    continue;
+                file.seekp(static_cast<std::streamoff>(header.dataOffset + uint64_t(chunkIndex) * SCENE_SLOT_SIZE));
+                file.write(reinterpret_cast<const char*>(slot.data()), slotUsed[a]);
+                saveStats.bytesWritten += slotUsed[a];
+            } else {
+                file.write(reinterpret_cast<const char*>(slot.data()), SCENE_SLOT_SIZE);
+                saveStats.bytesWritten += SCENE_SLOT_SIZE;
+            }
+            ++saveStats.chunksWritten;
+        }
+    }
+
+    std::vector<uint8_t> tables(sizeof(header));
+    std::memcpy(tables.data(), &header, sizeof(header));
+    tables.insert(tables.end(), layout.begin(), layout.end());
+    AppendRecords(tables, chunks);
+    tables.resize(header.dataOffset, 0);
+    header.tablesHash = HashTables(tables.data(), tablesEnd);
+    std::memcpy(tables.data(), &header, sizeof(header));
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(tables.data()), incremental ? tablesEnd : static_cast<std::streamsize>(tables.size()));
+    saveStats.bytesWritten += incremental ? tablesEnd : tables.size();
+    file.close();
+    if (!file) {
+        Reset();
+        return false;
+    }
+
+    if (!incremental) {
+        std::error_code error;
+        std::filesystem::rename(writePath, path, error);
+        if (error) {
+            std::filesystem::remove(writePath, error);
+            Reset();
+            return false;
+        }
+    }
+
+    lastPath = path;
+    lastFileSize = header.fileSize;
+    RememberWriteTime();
+    lastLayout = std::move(layout);
+    lastChunkHashes.resize(chunkCount);
+    for (uint32_t i = 0; i < chunkCount; ++i)
+        lastChunkHashes[i] = chunks[i].hash;
+
+    saveStats.entities = header.entityCount;
+    saveStats.archetypes = header.archetypeCount;
+    saveStats.chunks = chunkCount;
+    saveStats.incremental = incremental;
+    return true;
+}
+
+bool SceneSerializer::Load(World& world, const std::string& path)
+{
+    std::vector<uint8_t> bytes;
+    SceneFileView view;
+    if (!ReadFile(path, bytes) || !ParseSceneFile(bytes, view))
+        return false;
+    const SceneFileHeader& header = *view.header;
+
+    // File components to this build's, by name; unknown or resized ones are dropped
+    RegisterCoreComponents();
+    std::vector<ComponentId> componentIds(header.componentCount, INVALID_COMPONENT);
+    ComponentMask mapped = 0;
+    for (uint32_t i = 0; i < header.componentCount; ++i) {
+        const ComponentId id = ComponentRegistry::Find(view.GetName(i));
+        if (id == INVALID_COMPONENT || ComponentRegistry::Get(id).size != view.components[i].size)
+            continue;
+        if (mapped & GetComponentBit(id))
+            return false;  // the same name twice
+        mapped |= GetComponentBit(id);
+        componentIds[i] = id;
+    }
+
+    world.Clear();
+    for (uint32_t a = 0; a < header.archetypeCount; ++a) {
+        const SceneArchetypeRecord& record = view.archetypes[a];
+        ComponentMask mask = 0;
+        uint32_t entityCount = 0;
+        for (uint32_t c = 0; c < record.columnCount; ++c) {
+            const ComponentId id = componentIds[view.columns[record.firstColumn + c].component];
+            if (id != INVALID_COMPONENT)
+                mask |= GetComponentBit(id);
+        }
+        for (uint32_t k = 0; k < record.chunkCount; ++k)
+            entityCount += view.chunks[record.firstChunk + k].entityCount;
+        if (entityCount == 0)
+            continue;
+
+        uint32_t row;
+        Archetype* archetype = world.CreateBulk(mask, entityCount, row);
+        const uint32_t capacity = archetype->GetChunkCapacity();
+        for (uint32_t k = 0; k < record.chunkCount; ++k) {
+            const uint32_t count = view.chunks[record.firstChunk + k].entityCount;
+            const uint8_t* slot = view.GetSlot(record.firstChunk + k);
+            for (uint32_t c = 0; c < record.columnCount; ++c) {
+                const SceneColumnRecord& column = view.columns[record.firstColumn + c];
+                const ComponentId id = componentIds[column.component];
+                if (id == INVALID_COMPONENT)
+                    continue;
+                // Usually one copy; split where the runtime chunks are smaller than the file's
+                const uint32_t size = view.components[column.component].size;
+                const uint8_t* source = slot + column.offset;
+                for (uint32_t copied = 0; copied < count;) {
+                    const Archetype::Location location = archetype->GetLocation(row + copied);
+                    const uint32_t rows = std::min(count - copied, capacity - location.row);
+                    std::memcpy(archetype->GetComponent(location, id), source + size_t(copied) * size, size_t(rows) * size);
+                    copied += rows;
+                }
+            }
+            row += count;
+        }
+    }
+
+    // The loaded file is what a later save compares against
+    lastPath = path;
+    lastFileSize = header.fileSize;
+    RememberWriteTime();
+    lastLayout.assign(bytes.begin() + sizeof(SceneFileHeader), bytes.begin() + header.chunkTableOffset);
+    lastChunkHashes.resize(header.chunkCount);
+    for (uint32_t i = 0; i < header.chunkCount; ++i)
+        lastChunkHashes[i] = view.chunks[i].hash;
+    return true;
+}
+
+void SceneSerializer::Reset()
+{
+    lastPath.clear();
+    lastFileSize = 0;
+    lastWriteTime = std::filesystem::file_time_type();
+    lastLayout.clear();
+    lastChunkHashes.clear();
+}
+
+bool SceneSerializer::IsFileUnchanged(const std::string& path) const
+{
+    std::error_code error;
+    const uint64_t size = std::filesystem::file_size(path, error);
+    if (error || size != lastFileSize)
+        return false;
+    const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(path, error);
+    return !error && writeTime == lastWriteTime;
+}
+
+void SceneSerializer::RememberWriteTime()
+{
+    std::error_code error;
+    lastWriteTime = std::filesystem::last_write_time(lastPath, error);
+    if (error)
+        Reset();
+}
+
+bool ExportSceneText(const std::string& scenePath, const std::string& textPath)
+{
+    std::vector<uint8_t> bytes;
+    SceneFileView view;
+    if (!ReadFile(scenePath, bytes) || !ParseSceneFile(bytes, view))
+        return false;
+    const SceneFileHeader& header = *view.header;
+
+    std::string text;
+    char line[256];
+    std::snprintf(line, sizeof(line), "scene version %u: %u entities, %u archetypes, %u chunks\n",
+        header.version, header.entityCount, header.archetypeCount, header.chunkCount);
+    text += line;
+
+    uint32_t entity = 0;
+    for (uint32_t a = 0; a < header.archetypeCount; ++a) {
+        const SceneArchetypeRecord& record = view.archetypes[a];
+        text += "\narchetype";
+        for (uint32_t c = 0; c < record.columnCount; ++c) {
+            const uint32_t component = view.columns[record.firstColumn + c].component;
+            std::snprintf(line, sizeof(line), " %s(%u)", view.GetName(component), view.components[component].size);
+            text += line;
+        }
+        text += "\n";
+
+        for (uint32_t k = 0; k < record.chunkCount; ++k) {
+            const uint8_t* slot = view.GetSlot(record.firstChunk + k);
+            for (uint32_t row = 0; row < view.chunks[record.firstChunk + k].entityCount; ++row, ++entity) {
+                std::snprintf(line, sizeof(line), "entity %u\n", entity);
+                text += line;
+                for (uint32_t c = 0; c < record.columnCount; ++c) {
+                    const SceneColumnRecord& column = view.columns[record.firstColumn + c];
+                    const uint32_t size = view.components[column.component].size;
+                    const uint8_t* data = slot + column.offset + size_t(row) * size;
+                    text += "  ";
+                    text += view.GetName(column.component);
+                    text += ":";
+                    for (uint32_t i = 0; i < size; i += 4) {
+                        uint32_t word = 0;
+                        std::memcpy(&word, data + i, std::min(4u, size - i));
+                        std::snprintf(line, sizeof(line), " %08x", word);
+                        text += line;
+                    }
+                    text += "\n";
+                }
+            }
+        }
+    }
+
+    std::ofstream file(textPath, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    file.write(text.data(), static_cast<std::streamsize>(text.size()));
+    return file.good();
+}
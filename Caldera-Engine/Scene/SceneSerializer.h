@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+class World;
+
+// Binary scene files. The file mirrors the World's chunk storage: after a small
+// header come a string table of component names and the component, archetype,
+// column and chunk tables, then one fixed-size slot per chunk holding each
+// component's column contiguously. Every position is an offset from the start
+// of the file, so a file can be read or mapped anywhere and a load is a
+// validation pass plus one memcpy per column per chunk. The header carries a
+// hash of the tables and each chunk record one of its slot, and a load checks
+// both, so a damaged file is rejected rather than loaded with wrong contents.
+//
+// Components are matched by name and size. Entities get new handles on load;
+// no component stores an entity handle yet, so nothing needs remapping.
+struct SceneSaveStats {
+    uint32_t entities = 0;
+    uint32_t archetypes = 0;
+    uint32_t chunks = 0;
+    uint32_t chunksWritten = 0;  // all of them unless the save was incremental
+    uint64_t bytesWritten = 0;
+    bool incremental = false;
+};
+
+class SceneSerializer {
+public:
+    // Saving again to the file this serializer last saved or loaded, with the same
+    // archetypes and chunk counts, rewrites only the tables and the chunks whose
+    // contents changed, provided the file's size and modification time are still
+    // what this serializer left. Otherwise the file is written to a temporary and
+    // swapped in.
+    bool Save(World& world, const std::string& path);
+    // Replaces the world's entities with the file's. The world is untouched if the
+    // file is invalid. Components this build doesn't know, or knows with a
+    // different size, are dropped from the loaded entities.
+    bool Load(World& world, const std::string& path);
+    // The next Save writes the whole file.
+    void Reset();
+
+    const SceneSaveStats& GetLastSaveStats() const { return saveStats; }
+
+private:
+    bool IsFileUnchanged(const std::string& path) const;
+    // Records lastPath's modification time; forgets the file if it can't be read
+    void RememberWriteTime();
+
+    // What the file at 'lastPath' holds, to decide whether a save can be incremental
+    std::string lastPath;
+    uint64_t lastFileSize = 0;
+    std::filesystem::file_time_type lastWriteTime;
+    std::vector<uint8_t> lastLayout;  // string, component, archetype and column tables
+    std::vector<uint64_t> lastChunkHashes;
+    SceneSaveStats saveStats;
+};
+
+// Readable listing of a scene file, one line per component of each entity with
+// its bytes as 32-bit hex words, for diffing scene files in version control.
+bool ExportSceneText(const std::string& scenePath, const std::string& textPath);
@@ -0,0 +1,62 @@
+#include "SceneSpatialIndex.h"
+#include "Components.h"
+#include "World.h"
+
+static Aabb TransformBounds(const WorldTransformComponent& transform, const BoundsComponent& bounds)
+{
+    float center[3], extents[3];
+    GetWorldBounds(transform.rows, bounds, center, extents);
+    return Aabb::FromCenterExtents(center, extents);
+}
+
+void SceneSpatialIndex::Sync(World& world)
+{
+    ++syncCount;
+    world.ForEach<const WorldTransformComponent, const BoundsComponent>(
+        [&](Entity entity, const WorldTransformComponent& transform, const BoundsComponent& bounds) {
+            if (entity.index >= slots.size())
+                slots.resize(entity.index + 1);
+            Slot& slot = slots[entity.index];
+            const Aabb box = TransformBounds(transform, bounds);
+            if (slot.proxy != SceneBvh::INVALID_PROXY && slot.generation == entity.generation) {
+                bvh.MoveProxy(slot.proxy, box);
+            } else {
+                // New, or the index now belongs to another entity
+                bvh.DestroyProxy(slot.proxy);
+                slot.proxy = bvh.CreateProxy(box, entity.index, false);
+                slot.generation = entity.generation;
+            }
+            slot.lastSeen = syncCount;
+        });
+
+    for (Slot& slot : slots) {
+        if (slot.proxy != SceneBvh::INVALID_PROXY && slot.lastSeen != syncCount) {
+            bvh.DestroyProxy(slot.proxy);
+            slot.proxy = SceneBvh::INVALID_PROXY;
+        }
+    }
+    bvh.Update();
+}
+
+void SceneSpatialIndex::Clear()
+{
+    slots.clear();
+    bvh.Clear();
+}
+
+Entity SceneSpatialIndex::GetEntity(SceneBvh::ProxyId proxy) const
+{
+    if (!bvh.IsValid(proxy))
+        return NULL_ENTITY;
+    const uint32_t index = bvh.GetUserData(proxy);
+    return { index, slots[index].generation };
+}
+
+Entity SceneSpatialIndex::Pick(const Ray& ray, float* outT) const
+{
+    float t = 0.0f;
+    const SceneBvh::ProxyId proxy = bvh.RayCast(ray, t);
+    if (outT)
+        *outT = t;
+    return GetEntity(proxy);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Entity.h"
+#include "SceneBvh.h"
+
+class World;
+
+// Keeps a SceneBvh in step with the entities of a World that have a world
+// transform and bounds, for picking and spatial queries in world space. World
+// transforms come from SceneTransforms, which should be updated first. Each entity is a
+// dynamic proxy whose user data is its index; entities that lost either
+// component or were destroyed are dropped on the next Sync.
+class SceneSpatialIndex {
+public:
+    void Sync(World& world);
+    void Clear();
+
+    // Closest entity whose world box the ray hits, or NULL_ENTITY. As of the last Sync.
+    Entity Pick(const Ray& ray, float* outT = nullptr) const;
+    Entity GetEntity(SceneBvh::ProxyId proxy) const;
+    const SceneBvh& GetBvh() const { return bvh; }
+
+private:
+    struct Slot {
+        SceneBvh::ProxyId proxy = SceneBvh::INVALID_PROXY;
+        uint32_t generation = 0;
+        uint32_t lastSeen = 0;
+    };
+
+    std::vector<Slot> slots;  // indexed by entity index
+    uint32_t syncCount = 0;
+    SceneBvh bvh;
+};
@@ -0,0 +1,95 @@
+#include "SceneTransforms.h"
+#include "Components.h"
+#include "World.h"
+
+void SceneTransforms::Sync(World& world)
+{
+    ++syncCount;
+    std::vector<Entity> missingWorld;
+    world.ForEach<const TransformComponent>([&](Entity entity, const TransformComponent& transform) {
+        if (entity.index >= slots.size())
+            slots.resize(entity.index + 1);
+        Slot& slot = slots[entity.index];
+        if (slot.node == TransformHierarchy::INVALID_NODE || slot.generation != entity.generation) {
+            // New, or the index now belongs to another entity
+            if (slot.node != TransformHierarchy::INVALID_NODE)
+                hierarchy.DestroyNode(slot.node);
+            slot.node = hierarchy.CreateNode();
+            slot.generation = entity.generation;
+            if (slot.node >= nodeEntities.size())
+                nodeEntities.resize(slot.node + 1);
+            nodeEntities[slot.node] = entity;
+        }
+        hierarchy.SetLocalTransform(slot.node, transform);
+        slot.lastSeen = syncCount;
+        if (!world.Has<WorldTransformComponent>(entity))
+            missingWorld.push_back(entity);
+    });
+    // Structural changes wait until the query is done
+    for (Entity entity : missingWorld)
+        world.Add<WorldTransformComponent>(entity);
+
+    for (Slot& slot : slots) {
+        if (slot.node != TransformHierarchy::INVALID_NODE && slot.lastSeen != syncCount) {
+            hierarchy.DestroyNode(slot.node);
+            slot.node = TransformHierarchy::INVALID_NODE;
+        }
+    }
+    changed.clear();
+}
+
+void SceneTransforms::Clear()
+{
+    slots.clear();
+    nodeEntities.clear();
+    changed.clear();
+    hierarchy = TransformHierarchy();
+}
+
+bool SceneTransforms::IsTracked(Entity entity) const
+{
+    return entity.index < slots.size() && slots[entity.index].node != TransformHierarchy::INVALID_NODE &&
+        slots[entity.index].generation == entity.generation;
+}
+
+void SceneTransforms::MarkChanged(Entity entity)
+{
+    if (IsTracked(entity))
+        changed.push_back(entity);
+}
+
+bool SceneTransforms::SetParent(Entity entity, Entity parent)
+{
+    if (!IsTracked(entity) || (parent != NULL_ENTITY && !IsTracked(parent)))
+        return false;
+    const TransformHierarchy::NodeId parentNode = parent == NULL_ENTITY ? TransformHierarchy::INVALID_NODE : slots[parent.index].node;
+    return hierarchy.SetParent(slots[entity.index].node, parentNode);
+}
+
+Entity SceneTransforms::GetParent(Entity entity) const
+{
+    if (!IsTracked(entity))
+        return NULL_ENTITY;
+    const TransformHierarchy::NodeId parent = hierarchy.GetParent(slots[entity.index].node);
+    // A destroyed parent is only detached at the next Update
+    if (parent == TransformHierarchy::INVALID_NODE || !hierarchy.IsValid(parent))
+        return NULL_ENTITY;
+    return nodeEntities[parent];
+}
+
+void SceneTransforms::Update(World& world, TaskPool* pool)
+{
+    for (Entity entity : changed) {
+        // Destroyed since it was marked; the next Sync drops its node
+        const TransformComponent* transform = world.Get<TransformComponent>(entity);
+        if (transform && IsTracked(entity))
+            hierarchy.SetLocalTransform(slots[entity.index].node, *transform);
+    }
+    changed.clear();
+
+    hierarchy.Update(pool);
+    hierarchy.ForEachUpdated([&](TransformHierarchy::NodeId node) {
+        if (WorldTransformComponent* worldTransform = world.Get<WorldTransformComponent>(nodeEntities[node]))
+            *worldTransform = hierarchy.GetWorldTransform(node);
+    });
+}
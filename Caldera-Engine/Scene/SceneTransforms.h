@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Entity.h"
+#include "TransformHierarchy.h"
+
+class TaskPool;
+class World;
+
+// Keeps the WorldTransformComponent of every entity with a TransformComponent
+// up to date through a TransformHierarchy. An entity's Transform is relative to
+// its parent, or its world transform when it has none. Parents are set here
+// rather than stored in a component, since scene files hold no entity handles;
+// a loaded scene starts with every entity a root.
+//
+// Update only reads the Transforms marked changed since the last one, so a
+// static scene costs nothing beyond the call. Code that writes a Transform
+// calls MarkChanged; after bulk changes (loading, undo) call Sync instead.
+class SceneTransforms {
+public:
+    // Tracks entities that gained a Transform, adding their WorldTransform, and
+    // drops destroyed ones; children of a dropped entity become roots. Every
+    // tracked Transform is read again at the next Update.
+    void Sync(World& world);
+    void Clear();
+
+    // Call after writing the entity's Transform. Ignored for untracked entities.
+    void MarkChanged(Entity entity);
+    // NULL_ENTITY makes 'entity' a root. Fails if either entity is untracked, or
+    // 'parent' is 'entity' or one of its descendants. The child keeps its local
+    // Transform, so it moves with the parent from here on.
+    bool SetParent(Entity entity, Entity parent);
+    Entity GetParent(Entity entity) const;
+
+    // Recomputes the world matrices of changed entities and their descendants
+    // and writes them to their WorldTransformComponents.
+    void Update(World& world, TaskPool* pool = nullptr);
+
+    bool IsTracked(Entity entity) const;
+    const TransformHierarchy& GetHierarchy() const { return hierarchy; }
+
+private:
+    struct Slot {
+        TransformHierarchy::NodeId node = TransformHierarchy::INVALID_NODE;
+        uint32_t generation = 0;
+        uint32_t lastSeen = 0;
+    };
+
+    std::vector<Slot> slots;              // indexed by entity index
+    std::vector<Entity> nodeEntities;     // indexed by node id
+    std::vector<Entity> changed;
+    uint32_t syncCount = 0;
+    TransformHierarchy hierarchy;
+};
@@ -0,0 +1,251 @@
+#include "Simulation.h"
+#include "World.h"
+#include "../Core/Hash.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+// Sleeps wake up late by up to a scheduler tick, so the simulation thread
+// sleeps until this long before a step is due and yields for the rest
+static constexpr double SLEEP_MARGIN_SECONDS = 0.002;
+
+static std::chrono::steady_clock::duration ToDuration(double seconds)
+{
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+void Simulation::SetSettings(const SimulationSettings& newSettings)
+{
+    assert(!IsRunning() && "Simulation settings changed while running");
+    assert(newSettings.stepSeconds > 0.0 && newSettings.maxCatchUpSteps > 0 && "Invalid simulation settings");
+    settings = newSettings;
+}
+
+void Simulation::AddSystem(SimulationSystem system)
+{
+    assert(!IsRunning() && "Simulation system added while running");
+    systems.push_back(std::move(system));
+}
+
+void Simulation::Start(World& world)
+{
+    assert(!IsRunning() && "Simulation already running");
+    tick = 0;
+    dropped = 0.0;
+    stats = SimulationStats();
+    previousByIndex.clear();
+    quit = false;
+
+    // The first frame has something to draw before the first step is due
+    start = std::chrono::steady_clock::now();
+    Publish(world, 0.0);
+    simulationThread = std::thread(&Simulation::SimulationMain, this, &world);
+}
+
+void Simulation::Stop()
+{
+    if (!IsRunning())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_one();
+    simulationThread.join();
+}
+
+void Simulation::Enqueue(std::function<void(World&)> edit)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    edits.push_back(std::move(edit));
+}
+
+void Simulation::Step(World& world)
+{
+    assert(!IsRunning() && "Simulation::Step while the simulation thread runs");
+    RunStep(world, true);
+    Publish(world, static_cast<double>(tick) * settings.stepSeconds);
+}
+
+const SimulationSnapshot& Simulation::AcquireSnapshot(float& outAlpha)
+{
+    snapshots.Acquire();
+    const SimulationSnapshot& snapshot = snapshots.GetReadBuffer();
+    outAlpha = 1.0f;
+    if (IsRunning()) {
+        // The frame shows the world one step ago, which lies between the snapshot's
+        // two ticks until the next snapshot is due. A late one holds the newest tick.
+        const double alpha = (GetSeconds() - snapshot.dueSeconds) / settings.stepSeconds;
+        outAlpha = static_cast<float>(std::min(std::max(alpha, 0.0), 1.0));
+    }
+    return snapshot;
+}
+
+void Simulation::SimulationMain(World* world)
+{
+    const double step = settings.stepSeconds;
+    for (;;) {
+        const double due = static_cast<double>(tick + 1) * step + dropped;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait_until(lock, start + ToDuration(due - SLEEP_MARGIN_SECONDS), [&] { return quit; });
+            if (quit)
+                return;
+        }
+        while (GetSeconds() < due)
+            std::this_thread::yield();
+
+        // Catch up on every step that came due meanwhile, up to the limit
+        uint32_t count = static_cast<uint32_t>((GetSeconds() - due) / step) + 1;
+        if (count > settings.maxCatchUpSteps) {
+            const uint32_t skipped = count - settings.maxCatchUpSteps;
+            dropped += skipped * step;
+            stats.droppedSteps += skipped;
+            count = settings.maxCatchUpSteps;
+        }
+        for (uint32_t i = 0; i < count; ++i)
+            RunStep(*world, i + 1 == count);
+        Publish(*world, static_cast<double>(tick) * step + dropped);
+    }
+}
+
+void Simulation::RunStep(World& world, bool capturePrevious)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        runningEdits.swap(edits);
+    }
+    for (std::function<void(World&)>& edit : runningEdits)
+        edit(world);
+    runningEdits.clear();
+
+    // After the edits, so an entity an edit moves appears there instead of sliding over
+    if (capturePrevious)
+        CapturePrevious(world);
+
+    const auto begin = std::chrono::steady_clock::now();
+    const float dt = static_cast<float>(settings.stepSeconds);
+    for (SimulationSystem& system : systems)
+        system(world, dt);
+    stats.stepMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    stats.maxStepMs = std::max(stats.maxStepMs, stats.stepMs);
+    stats.ticks = ++tick;
+}
+
+void Simulation::CapturePrevious(World& world)
+{
+    const ComponentId transformId = GetComponentId<TransformComponent>();
+    for (Archetype* archetype : world.MatchArchetypes(MakeComponentMask<TransformComponent, RenderableComponent>())) {
+        for (uint32_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk) {
+            const uint32_t count = archetype->GetChunkEntityCount(chunk);
+            const Entity* entities = archetype->GetEntities(chunk);
+            const TransformComponent* transforms = static_cast<const TransformComponent*>(archetype->GetColumn(chunk, transformId));
+            for (uint32_t i = 0; i < count; ++i) {
+                if (entities[i].index >= previousByIndex.size())
+                    previousByIndex.resize(entities[i].index + 1);
+                PreviousTransform& previous = previousByIndex[entities[i].index];
+                previous.generation = entities[i].generation;
+                previous.tick = tick;
+                previous.transform = transforms[i];
+            }
+        }
+    }
+}
+
+void Simulation::Publish(World& world, double dueSeconds)
+{
+    SimulationSnapshot& snapshot = snapshots.GetWriteBuffer();
+    snapshot.tick = tick;
+    snapshot.dueSeconds = dueSeconds;
+    snapshot.entities.clear();
+    snapshot.previous.clear();
+    snapshot.current.clear();
+    snapshot.renderables.clear();
+    snapshot.bounds.clear();
+
+    const ComponentId transformId = GetComponentId<TransformComponent>();
+    const ComponentId renderableId = GetComponentId<RenderableComponent>();
+    const ComponentId boundsId = GetComponentId<BoundsComponent>();
+    for (Archetype* archetype : world.MatchArchetypes(MakeComponentMask<TransformComponent, RenderableComponent>())) {
+        for (uint32_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk) {
+            const uint32_t count = archetype->GetChunkEntityCount(chunk);
+            const Entity* entities = archetype->GetEntities(chunk);
+            const TransformComponent* transforms = static_cast<const TransformComponent*>(archetype->GetColumn(chunk, transformId));
+            const RenderableComponent* renderables = static_cast<const RenderableComponent*>(archetype->GetColumn(chunk, renderableId));
+            const BoundsComponent* bounds = static_cast<const BoundsComponent*>(archetype->GetColumn(chunk, boundsId));
+
+            snapshot.entities.insert(snapshot.entities.end(), entities, entities + count);
+            snapshot.current.insert(snapshot.current.end(), transforms, transforms + count);
+            snapshot.renderables.insert(snapshot.renderables.end(), renderables, renderables + count);
+            if (bounds)
+                snapshot.bounds.insert(snapshot.bounds.end(), bounds, bounds + count);
+            else
+                snapshot.bounds.resize(snapshot.bounds.size() + count);
+            for (uint32_t i = 0; i < count; ++i) {
+                // Entities new since the last tick have nothing to move from
+                const Entity entity = entities[i];
+                const bool moved = entity.index < previousByIndex.size() &&
+                    previousByIndex[entity.index].generation == entity.generation &&
+                    previousByIndex[entity.index].tick + 1 == tick;
+                snapshot.previous.push_back(moved ? previousByIndex[entity.index].transform : transforms[i]);
+            }
+        }
+    }
+    snapshot.stats = stats;
+    snapshots.Publish();
+}
+
+double Simulation::GetSeconds() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+TransformComponent InterpolateTransform(const TransformComponent& from, const TransformComponent& to, float alpha)
+{
+    TransformComponent result;
+    for (int i = 0; i < 3; ++i) {
+        result.position[i] = from.position[i] + (to.position[i] - from.position[i]) * alpha;
+        result.scale[i] = from.scale[i] + (to.scale[i] - from.scale[i]) * alpha;
+    }
+
+    // Normalized lerp along the shorter arc; a step turns far less than the half
+    // circle where it would differ visibly from a slerp
+    float dot = 0.0f;
+    for (int i = 0; i < 4; ++i)
+        dot += from.rotation[i] * to.rotation[i];
+    const float sign = dot < 0.0f ? -1.0f : 1.0f;
+    float lengthSquared = 0.0f;
+    for (int i = 0; i < 4; ++i) {
+        result.rotation[i] = from.rotation[i] + (sign * to.rotation[i] - from.rotation[i]) * alpha;
+        lengthSquared += result.rotation[i] * result.rotation[i];
+    }
+    if (lengthSquared > 0.0f) {
+        const float scale = 1.0f / std::sqrt(lengthSquared);
+        for (int i = 0; i < 4; ++i)
+            result.rotation[i] *= scale;
+    }
+    return result;
+}
+
+void InterpolateSnapshot(const SimulationSnapshot& snapshot, float alpha, std::vector<TransformComponent>& outTransforms)
+{
+    outTransforms.resize(snapshot.current.size());
+    for (size_t i = 0; i < snapshot.current.size(); ++i)
+        outTransforms[i] = InterpolateTransform(snapshot.previous[i], snapshot.current[i], alpha);
+}
+
+uint64_t HashWorldState(World& world)
+{
+    uint64_t hash = HASH_SEED;
+    for (const std::unique_ptr<Archetype>& archetype : world.GetArchetypes()) {
+        const ComponentMask mask = archetype->GetMask();
+        hash = HashBytes(&mask, sizeof(mask), hash);
+        for (uint32_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk) {
+            const uint32_t count = archetype->GetChunkEntityCount(chunk);
+            hash = HashBytes(archetype->GetEntities(chunk), count * sizeof(Entity), hash);
+            for (ComponentId id : archetype->GetComponents())
+                hash = HashBytes(archetype->GetColumn(chunk, id), size_t(count) * ComponentRegistry::Get(id).size, hash);
+        }
+    }
+    return hash;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Components.h"
+#include "Entity.h"
+#include "../Core/TripleBuffer.h"
+
+class World;
+
+// Fixed-timestep simulation on a thread of its own. Every step runs the systems
+// in the order they were added with the same dt, so the same edits and the same
+// number of steps always end in the same world, whatever the frame rate.
+//
+// The frame never waits for the simulation. After each batch of steps the
+// simulation thread publishes a snapshot of what the renderer needs (the
+// Transform of every entity with a Renderable, as of the newest tick and the
+// tick before it) through a triple buffer. The frame takes the newest snapshot
+// and draws the state one step in the past, interpolated between those two
+// ticks, so motion is smooth at any frame rate and the next step overlaps with
+// building and rendering the frame. A slow step delays the next snapshot rather
+// than the frame; the frame holds the newest tick until it arrives.
+//
+// Step runs the same steps on the calling thread, for tools and determinism
+// checks that run the simulation headless.
+struct SimulationSettings {
+    double stepSeconds = 1.0 / 60.0;
+    // Steps run back to back to catch up after a slow one; time beyond this is dropped
+    uint32_t maxCatchUpSteps = 4;
+};
+
+struct SimulationStats {
+    uint64_t ticks = 0;
+    uint64_t droppedSteps = 0;  // never run, because the simulation fell too far behind
+    float stepMs = 0.0f;        // systems' time in the newest step
+    float maxStepMs = 0.0f;
+};
+
+// Render state of one tick. The arrays share indices.
+struct SimulationSnapshot {
+    uint64_t tick = 0;
+    double dueSeconds = 0.0;    // when the tick was due, in seconds since Start
+    std::vector<Entity> entities;
+    std::vector<TransformComponent> previous;  // as of tick - 1; a copy of 'current' for new entities
+    std::vector<TransformComponent> current;
+    std::vector<RenderableComponent> renderables;
+    std::vector<BoundsComponent> bounds;       // the default box for entities without Bounds
+    SimulationStats stats;
+};
+
+using SimulationSystem = std::function<void(World&, float)>;
+
+class Simulation {
+public:
+    ~Simulation() { Stop(); }
+
+    // Not while running.
+    void SetSettings(const SimulationSettings& newSettings);
+    const SimulationSettings& GetSettings() const { return settings; }
+    // fn(world, dt) runs every step, after the systems added before it. Not while running.
+    void AddSystem(SimulationSystem system);
+
+    // Steps 'world' on the simulation thread until Stop. Until then the world
+    // belongs to that thread: change it through Enqueue only. A snapshot of the
+    // world as it is now is published before Start returns.
+    void Start(World& world);
+    void Stop();
+    bool IsRunning() const { return simulationThread.joinable(); }
+
+    // Runs 'edit' on the simulation thread before the next step, or at the next
+    // Step when headless.
+    void Enqueue(std::function<void(World&)> edit);
+
+    // Headless: runs one step on the calling thread and publishes its snapshot. Not while running.
+    void Step(World& world);
+
+    // Main thread, once per frame: the newest snapshot, and where the frame
+    // falls between its previous (0) and current (1) transforms. Always 1 when
+    // headless.
+    const SimulationSnapshot& AcquireSnapshot(float& outAlpha);
+
+private:
+    struct PreviousTransform {
+        uint32_t generation = 0;
+        uint64_t tick = 0;  // the transform is as of this tick
+        TransformComponent transform;
+    };
+
+    void SimulationMain(World* world);
+    // Runs queued edits and the systems. Only the last step before a publish
+    // needs the transforms it starts from.
+    void RunStep(World& world, bool capturePrevious);
+    void CapturePrevious(World& world);
+    void Publish(World& world, double dueSeconds);
+    double GetSeconds() const;
+
+    SimulationSettings settings;
+    std::vector<SimulationSystem> systems;
+
+    // Simulation thread, or the caller of Step
+    std::vector<PreviousTransform> previousByIndex;  // indexed by entity index
+    std::vector<std::function<void(World&)>> runningEdits;
+    uint64_t tick = 0;
+    double dropped = 0.0;  // seconds skipped after falling behind
+    SimulationStats stats;
+
+    TripleBuffer<SimulationSnapshot> snapshots;
+    std::chrono::steady_clock::time_point start;
+
+    std::thread simulationThread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::function<void(World&)>> edits;
+    bool quit = false;
+};
+
+// The snapshot's transforms at 'alpha' between previous and current.
+TransformComponent InterpolateTransform(const TransformComponent& from, const TransformComponent& to, float alpha);
+void InterpolateSnapshot(const SimulationSnapshot& snapshot, float alpha, std::vector<TransformComponent>& outTransforms);
+
+// Hash of every entity handle and component byte, in storage order. Two runs
+// that applied the same edits and steps to the same scene hash the same.
+uint64_t HashWorldState(World& world);
@@ -0,0 +1,256 @@
+#include "TransformHierarchy.h"
+#include "../Core/TaskPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+// Parent slot of roots, and the level of nodes not yet visited during a rebuild
+static constexpr uint32_t NO_SLOT = 0xFFFFFFFFu;
+
+TransformHierarchy::NodeId TransformHierarchy::CreateNode(NodeId parent)
+{
+    assert((parent == INVALID_NODE || IsValid(parent)) && "Parent node is not alive");
+    NodeId node;
+    if (!freeNodes.empty()) {
+        node = freeNodes.back();
+        freeNodes.pop_back();
+    } else {
+        node = static_cast<NodeId>(nodes.size());
+        nodes.emplace_back();
+    }
+
+    // Appended unsorted; the next Update moves it to its level
+    const uint32_t slot = static_cast<uint32_t>(slotToNode.size());
+    nodes[node] = { parent, slot, true };
+    slotToNode.push_back(node);
+    parentSlot.push_back(parent == INVALID_NODE ? NO_SLOT : nodes[parent].slot);
+    slotLevel.push_back(0);
+    local.emplace_back();
+    world.emplace_back();
+    dirty.push_back(0);
+    updated.push_back(0);
+
+    shapeChanged = true;
+    MarkDirty(slot);
+    return node;
+}
+
+void TransformHierarchy::DestroyNode(NodeId node)
+{
+    if (!IsValid(node))
+        return;
+    // The slot is dropped and children are detached at the next rebuild. The id is
+    // only recycled then, so children can't end up attached to a new node meanwhile.
+    Node& entry = nodes[node];
+    entry.alive = false;
+    if (dirty[entry.slot]) {
+        dirty[entry.slot] = 0;
+        --dirtyCount;
+    }
+    shapeChanged = true;
+}
+
+bool TransformHierarchy::SetParent(NodeId node, NodeId parent)
+{
+    assert(IsValid(node) && (parent == INVALID_NODE || IsValid(parent)) && "Node is not alive");
+    for (NodeId ancestor = parent; ancestor != INVALID_NODE && nodes[ancestor].alive; ancestor = nodes[ancestor].parent) {
+        if (ancestor == node)
+            return false;
+    }
+    nodes[node].parent = parent;
+    shapeChanged = true;
+    MarkDirty(nodes[node].slot);
+    return true;
+}
+
+void TransformHierarchy::SetLocalTransform(NodeId node, const TransformComponent& transform)
+{
+    const uint32_t slot = nodes[node].slot;
+    local[slot] = transform;
+    MarkDirty(slot);
+}
+
+void TransformHierarchy::MarkDirty(uint32_t slot)
+{
+    if (dirty[slot])
+        return;
+    dirty[slot] = 1;
+    // Levels are stale until the rebuild, which finds the first dirty one itself
+    if (!shapeChanged && (dirtyCount == 0 || slotLevel[slot] < firstDirtyLevel))
+        firstDirtyLevel = slotLevel[slot];
+    ++dirtyCount;
+}
+
+void TransformHierarchy::Rebuild()
+{
+    const uint32_t oldCount = static_cast<uint32_t>(slotToNode.size());
+
+    // Children of destroyed nodes become roots, and their ids are free from here on
+    for (NodeId node = 0; node < nodes.size(); ++node) {
+        Node& entry = nodes[node];
+        if (!entry.alive)
+            continue;
+        if (entry.parent != INVALID_NODE && !nodes[entry.parent].alive) {
+            entry.parent = INVALID_NODE;
+            dirty[entry.slot] = 1;
+        }
+    }
+    for (uint32_t slot = 0; slot < oldCount; ++slot) {
+        if (!nodes[slotToNode[slot]].alive)
+            freeNodes.push_back(slotToNode[slot]);
+    }
+
+    // Depth of every live node; parents are resolved first through a small stack
+    std::vector<uint32_t> level(oldCount, NO_SLOT);
+    std::vector<uint32_t> stack;
+    uint32_t levelCount = 0;
+    for (uint32_t slot = 0; slot < oldCount; ++slot) {
+        if (!nodes[slotToNode[slot]].alive || level[slot] != NO_SLOT)
+            continue;
+        uint32_t current = slot;
+        while (true) {
+            const NodeId parent = nodes[slotToNode[current]].parent;
+            if (parent == INVALID_NODE) {
+                level[current] = 0;
+                break;
+            }
+            const uint32_t parentSlotIndex = nodes[parent].slot;
+            if (level[parentSlotIndex] != NO_SLOT) {
+                level[current] = level[parentSlotIndex] + 1;
+                break;
+            }
+            stack.push_back(current);
+            current = parentSlotIndex;
+        }
+        while (!stack.empty()) {
+            const uint32_t child = stack.back();
+            stack.pop_back();
+            level[child] = level[nodes[nodes[slotToNode[child]].parent].slot] + 1;
+        }
+    }
+    for (uint32_t slot = 0; slot < oldCount; ++slot) {
+        if (nodes[slotToNode[slot]].alive)
+            levelCount = std::max(levelCount, level[slot] + 1);
+    }
+
+    // Counting sort by level; within a level the previous order is kept
+    levelStart.assign(levelCount + 1, 0);
+    for (uint32_t slot = 0; slot < oldCount; ++slot) {
+        if (nodes[slotToNode[slot]].alive)
+            ++levelStart[level[slot] + 1];
+    }
+    for (uint32_t l = 0; l < levelCount; ++l)
+        levelStart[l + 1] += levelStart[l];
+
+    const uint32_t newCount = levelStart[levelCount];
+    std::vector<uint32_t> cursor(levelStart.begin(), levelStart.end() - 1);
+    std::vector<uint32_t> newSlotOf(oldCount, NO_SLOT);
+    for (uint32_t slot = 0; slot < oldCount; ++slot) {
+        if (nodes[slotToNode[slot]].alive)
+            newSlotOf[slot] = cursor[level[slot]]++;
+    }
+
+    std::vector<NodeId> sortedNodes(newCount);
+    std::vector<uint32_t> sortedParents(newCount);
+    std::vector<uint32_t> sortedLevels(newCount);
+    std::vector<TransformComponent> sortedLocal(newCount);
+    std::vector<WorldTransformComponent> sortedWorld(newCount);
+    std::vector<uint8_t> sortedDirty(newCount);
+    for (uint32_t slot = 0; slot < oldCount; ++slot) {
+        const uint32_t to = newSlotOf[slot];
+        if (to == NO_SLOT)
+            continue;
+        sortedNodes[to] = slotToNode[slot];
+        sortedLevels[to] = level[slot];
+        sortedLocal[to] = local[slot];
+        sortedWorld[to] = world[slot];
+        sortedDirty[to] = dirty[slot];
+    }
+    for (uint32_t slot = 0; slot < newCount; ++slot)
+        nodes[sortedNodes[slot]].slot = slot;
+    for (uint32_t slot = 0; slot < newCount; ++slot) {
+        const NodeId parent = nodes[sortedNodes[slot]].parent;
+        sortedParents[slot] = parent == INVALID_NODE ? NO_SLOT : nodes[parent].slot;
+    }
+
+    slotToNode.swap(sortedNodes);
+    parentSlot.swap(sortedParents);
+    slotLevel.swap(sortedLevels);
+    local.swap(sortedLocal);
+    world.swap(sortedWorld);
+    dirty.swap(sortedDirty);
+    updated.assign(newCount, 0);
+    updatedBegin = newCount;
+
+    dirtyCount = 0;
+    firstDirtyLevel = levelCount;
+    for (uint32_t slot = 0; slot < newCount; ++slot) {
+        if (dirty[slot]) {
+            firstDirtyLevel = std::min(firstDirtyLevel, slotLevel[slot]);
+            ++dirtyCount;
+        }
+    }
+
+    shapeChanged = false;
+    stats.nodes = newCount;
+    stats.levels = levelCount;
+    ++stats.rebuilds;
+}
+
+uint32_t TransformHierarchy::UpdateRange(uint32_t begin, uint32_t end, uint32_t firstSlot)
+{
+    uint32_t count = 0;
+    for (uint32_t slot = begin; slot < end; ++slot) {
+        // Parents before 'firstSlot' weren't visited this update, so their flags are stale
+        const uint32_t parent = parentSlot[slot];
+        const bool parentUpdated = parent != NO_SLOT && parent >= firstSlot && updated[parent];
+        if (!dirty[slot] && !parentUpdated)
+            continue;
+
+        if (parent == NO_SLOT) {
+            GetTransformMatrix(local[slot], world[slot].rows);
+        } else {
+            float rows[12];
+            GetTransformMatrix(local[slot], rows);
+            MultiplyTransformMatrices(world[parent].rows, rows, world[slot].rows);
+        }
+        dirty[slot] = 0;
+        updated[slot] = 1;
+        ++count;
+    }
+    return count;
+}
+
+void TransformHierarchy::Update(TaskPool* pool)
+{
+    // Forget which nodes the previous update touched
+    std::fill(updated.begin() + std::min<size_t>(updatedBegin, updated.size()), updated.end(), 0);
+    updatedBegin = static_cast<uint32_t>(updated.size());
+    stats.updatedNodes = 0;
+
+    if (shapeChanged)
+        Rebuild();
+    if (dirtyCount == 0)
+        return;
+
+    const uint32_t firstSlot = levelStart[firstDirtyLevel];
+    std::atomic<uint32_t> updatedCount{ 0 };
+    for (uint32_t l = firstDirtyLevel; l + 1 < levelStart.size(); ++l) {
+        const uint32_t begin = levelStart[l];
+        const uint32_t end = levelStart[l + 1];
+        if (!pool || end - begin < PARALLEL_MIN_NODES) {
+            updatedCount += UpdateRange(begin, end, firstSlot);
+            continue;
+        }
+        // A level only reads the one above it, which is complete by now
+        const uint32_t taskCount = (end - begin + NODES_PER_TASK - 1) / NODES_PER_TASK;
+        pool->ParallelFor(taskCount, [&](uint32_t task) {
+            const uint32_t taskBegin = begin + task * NODES_PER_TASK;
+            updatedCount += UpdateRange(taskBegin, std::min(end, taskBegin + NODES_PER_TASK), firstSlot);
+        });
+    }
+
+    stats.updatedNodes = updatedCount;
+    updatedBegin = firstSlot;
+    dirtyCount = 0;
+}
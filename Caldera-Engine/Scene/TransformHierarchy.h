@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Components.h"
+
+class TaskPool;
+
+// Parent/child transforms with world matrices computed from local TRS. Nodes
+// are stored structure-of-arrays and sorted breadth-first, so the nodes of one
+// depth are contiguous and every parent precedes its children. Update walks
+// the levels in order and recomputes a world matrix only where the node or an
+// ancestor changed; each level is split across the task pool. With nothing
+// changed, Update returns immediately.
+//
+// Nodes are addressed by stable ids; slots in the sorted arrays move whenever
+// the hierarchy's shape changes. Local transforms are TransformComponents and
+// world transforms are 3x4 rows as GetTransformMatrix builds them, with column
+// vectors: world = parentWorld * local.
+class TransformHierarchy {
+public:
+    using NodeId = uint32_t;
+    static constexpr NodeId INVALID_NODE = 0xFFFFFFFFu;
+    // Levels smaller than this are updated on the calling thread.
+    static constexpr uint32_t PARALLEL_MIN_NODES = 2048;
+    static constexpr uint32_t NODES_PER_TASK = 512;
+
+    struct Stats {
+        uint32_t nodes = 0;
+        uint32_t levels = 0;
+        uint32_t updatedNodes = 0;  // world matrices recomputed by the last Update
+        uint32_t rebuilds = 0;      // breadth-first re-sorts after shape changes
+    };
+
+    // 'parent' may be INVALID_NODE for a root.
+    NodeId CreateNode(NodeId parent = INVALID_NODE);
+    // Children of a destroyed node become roots, keeping their local transforms.
+    void DestroyNode(NodeId node);
+    // Fails (returns false) if 'parent' is the node itself or one of its descendants.
+    bool SetParent(NodeId node, NodeId parent);
+    NodeId GetParent(NodeId node) const { return nodes[node].parent; }
+    bool IsValid(NodeId node) const { return node < nodes.size() && nodes[node].alive; }
+
+    void SetLocalTransform(NodeId node, const TransformComponent& transform);
+    const TransformComponent& GetLocalTransform(NodeId node) const { return local[nodes[node].slot]; }
+
+    // Recomputes the world matrices of changed nodes and their descendants.
+    void Update(TaskPool* pool = nullptr);
+    // As of the last Update.
+    const WorldTransformComponent& GetWorldTransform(NodeId node) const { return world[nodes[node].slot]; }
+    // True if the last Update recomputed the node's world matrix.
+    bool WasUpdated(NodeId node) const { return updated[nodes[node].slot] != 0; }
+    // fn(node) for every node the last Update recomputed, parents first.
+    template<typename Fn>
+    void ForEachUpdated(Fn&& fn) const;
+
+    // Position in the breadth-first order and depth below its root, as of the last Update.
+    uint32_t GetSlot(NodeId node) const { return nodes[node].slot; }
+    uint32_t GetLevel(NodeId node) const { return slotLevel[nodes[node].slot]; }
+
+    // Includes nodes destroyed since the last Update.
+    uint32_t GetNodeCount() const { return static_cast<uint32_t>(slotToNode.size()); }
+    const Stats& GetStats() const { return stats; }
+
+private:
+    struct Node {
+        NodeId parent = INVALID_NODE;
+        uint32_t slot = 0;
+        bool alive = false;
+    };
+
+    void MarkDirty(uint32_t slot);
+    void Rebuild();
+    // Returns the number of world matrices recomputed.
+    uint32_t UpdateRange(uint32_t begin, uint32_t end, uint32_t firstSlot);
+
+    // Indexed by node id
+    std::vector<Node> nodes;
+    std::vector<NodeId> freeNodes;
+
+    // Indexed by slot, breadth-first once rebuilt
+    std::vector<NodeId> slotToNode;
+    std::vector<uint32_t> parentSlot;
+    std::vector<uint32_t> slotLevel;
+    std::vector<TransformComponent> local;
+    std::vector<WorldTransformComponent> world;
+    std::vector<uint8_t> dirty;
+    std::vector<uint8_t> updated;
+
+    std::vector<uint32_t> levelStart;  // first slot of each level, plus the end
+    uint32_t updatedBegin = 0;         // 'updated' may be set from this slot on
+    bool shapeChanged = false;
+    uint32_t dirtyCount = 0;
+    uint32_t firstDirtyLevel = 0;
+    Stats stats;
+};
+
+template<typename Fn>
+void TransformHierarchy::ForEachUpdated(Fn&& fn) const
+{
+    // Nothing before 'updatedBegin' was visited by the last Update
+    for (uint32_t slot = updatedBegin; slot < updated.size(); ++slot) {
+        if (updated[slot])
+            fn(slotToNode[slot]);
+    }
+}
@@ -0,0 +1,297 @@
+#include "UndoHistory.h"
+#include "World.h"
+#include <cassert>
+#include <cstring>
+
+// Step layout, repeated per changed component:
+//   u32 entity index, u32 generation, u16 component, u16 run count,
+//   then per run: u16 offset, u16 length, 'length' bytes of old XOR new.
+static constexpr size_t ENTRY_HEADER_SIZE = 12;
+static constexpr size_t RUN_HEADER_SIZE = 4;
+// Unchanged gaps shorter than a run header are cheaper to store than to split on
+static constexpr uint32_t RUN_GAP = RUN_HEADER_SIZE;
+static_assert(CHUNK_SIZE <= 0xFFFF, "Run offsets and lengths are 16-bit");
+
+template<typename T>
+static void Put(std::vector<uint8_t>& out, T value)
+{
+    const size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+template<typename T>
+static T Get(const uint8_t*& cursor)
+{
+    T value;
+    std::memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return value;
+}
+
+UndoHistory::UndoHistory(size_t capacity)
+    : capacity(capacity)
+{
+}
+
+void UndoHistory::Begin(const char* name, uint64_t mergeKey)
+{
+    assert(!recording && "UndoHistory transaction already open");
+    ResetTransaction();
+    recording = true;
+    transactionName = name;
+    transactionMergeKey = mergeKey;
+}
+
+void UndoHistory::Record(World& world, Entity entity, ComponentId id)
+{
+    assert(recording && "UndoHistory::Record outside a transaction");
+    const void* current = world.GetComponent(entity, id);
+    if (current)
+        Touch(entity, id, current);
+}
+
+void UndoHistory::Touch(Entity entity, ComponentId id, const void* oldBytes)
+{
+    auto inserted = touchedIndex.emplace(GetTouchKey(entity, id), static_cast<uint32_t>(touched.size()));
+    if (!inserted.second)
+        return;
+    Touched entry;
+    entry.entity = entity;
+    entry.component = id;
+    entry.size = ComponentRegistry::Get(id).size;
+    entry.snapshot = snapshots.size();
+    const uint8_t* bytes = static_cast<const uint8_t*>(oldBytes);
+    snapshots.insert(snapshots.end(), bytes, bytes + entry.size);
+    touched.push_back(entry);
+}
+
+void UndoHistory::Commit(World& world)
+{
+    assert(recording && "UndoHistory::Commit outside a transaction");
+
+    // Fold into the previous step: its runs turn the current bytes back into
+    // that step's starting bytes, which become this transaction's snapshots
+    if (transactionMergeKey != 0 && cursor > 0 && cursor == steps.size() && steps.back().mergeKey == transactionMergeKey) {
+        const Step previous = steps.back();
+        const std::vector<Touched> current = std::move(touched);
+        const std::vector<uint8_t> currentSnapshots = std::move(snapshots);
+        const std::unordered_map<uint64_t, uint32_t> currentIndex = std::move(touchedIndex);
+        touched.clear();
+        snapshots.clear();
+        touchedIndex.clear();
+
+        std::vector<uint8_t> original;
+        const uint8_t* read = ring.data() + previous.offset;
+        const uint8_t* end = read + previous.size;
+        while (read < end) {
+            Entity entity;
+            entity.index = Get<uint32_t>(read);
+            entity.generation = Get<uint32_t>(read);
+            const ComponentId id = Get<uint16_t>(read);
+            const uint16_t runCount = Get<uint16_t>(read);
+
+            // The step was taken against the bytes this transaction snapshotted first, if any
+            auto found = currentIndex.find(GetTouchKey(entity, id));
+            const void* now = world.GetComponent(entity, id);
+            if (now && found != currentIndex.end())
+                now = currentSnapshots.data() + current[found->second].snapshot;
+            const uint32_t size = ComponentRegistry::Get(id).size;
+            original.assign(size, 0);
+            if (now)
+                std::memcpy(original.data(), now, size);
+            for (uint16_t r = 0; r < runCount; ++r) {
+                const uint16_t offset = Get<uint16_t>(read);
+                const uint16_t length = Get<uint16_t>(read);
+                for (uint16_t i = 0; i < length; ++i)
+                    original[offset + i] ^= read[i];
+                read += length;
+            }
+            if (now)
+                Touch(entity, id, original.data());
+        }
+        for (const Touched& entry : current)
+            Touch(entry.entity, entry.component, currentSnapshots.data() + entry.snapshot);
+
+        steps.pop_back();
+        --cursor;
+        ++merges;
+    }
+
+    encoded.clear();
+    for (const Touched& entry : touched) {
+        const uint8_t* now = static_cast<const uint8_t*>(world.GetComponent(entry.entity, entry.component));
+        if (!now)
+            continue;
+        const uint8_t* old = snapshots.data() + entry.snapshot;
+        const size_t headerAt = encoded.size();
+        Put<uint32_t>(encoded, entry.entity.index);
+        Put<uint32_t>(encoded, entry.entity.generation);
+        Put<uint16_t>(encoded, static_cast<uint16_t>(entry.component));
+        Put<uint16_t>(encoded, 0);
+
+        uint16_t runCount = 0;
+        for (uint32_t i = 0; i < entry.size;) {
+            if (old[i] == now[i]) {
+                ++i;
+                continue;
+            }
+            const uint32_t start = i;
+            uint32_t end = i + 1;
+            for (uint32_t j = end; j < entry.size && j - end < RUN_GAP; ++j) {
+                if (old[j] != now[j])
+                    end = j + 1;
+            }
+            Put<uint16_t>(encoded, static_cast<uint16_t>(start));
+            Put<uint16_t>(encoded, static_cast<uint16_t>(end - start));
+            for (uint32_t b = start; b < end; ++b)
+                encoded.push_back(old[b] ^ now[b]);
+            ++runCount;
+            i = end;
+        }
+
+        if (runCount == 0)
+            encoded.resize(headerAt);
+        else
+            std::memcpy(encoded.data() + headerAt + ENTRY_HEADER_SIZE - sizeof(uint16_t), &runCount, sizeof(runCount));
+    }
+
+    if (!encoded.empty()) {
+        // A new edit ends the redo branch
+        steps.resize(cursor);
+        size_t offset;
+        if (Reserve(encoded.size(), offset)) {
+            std::memcpy(ring.data() + offset, encoded.data(), encoded.size());
+            Step step;
+            step.name = transactionName;
+            step.mergeKey = transactionMergeKey;
+            step.offset = offset;
+            step.size = encoded.size();
+            steps.push_back(step);
+        } else {
+            // Larger than the whole ring: nothing before this edit can be undone any more
+            stepsDropped += steps.size();
+            steps.clear();
+        }
+        cursor = steps.size();
+    }
+    ResetTransaction();
+}
+
+void UndoHistory::Cancel(World& world)
+{
+    assert(recording && "UndoHistory::Cancel outside a transaction");
+    for (const Touched& entry : touched) {
+        if (void* now = world.GetComponent(entry.entity, entry.component))
+            std::memcpy(now, snapshots.data() + entry.snapshot, entry.size);
+    }
+    ResetTransaction();
+}
+
+bool UndoHistory::Undo(World& world)
+{
+    assert(!recording && "Cannot undo while a transaction is open");
+    if (!CanUndo())
+        return false;
+    ApplyStep(world, steps[--cursor]);
+    return true;
+}
+
+bool UndoHistory::Redo(World& world)
+{
+    assert(!recording && "Cannot redo while a transaction is open");
+    if (!CanRedo())
+        return false;
+    ApplyStep(world, steps[cursor++]);
+    return true;
+}
+
+void UndoHistory::Clear()
+{
+    steps.clear();
+    cursor = 0;
+    ResetTransaction();
+}
+
+UndoHistory::Stats UndoHistory::GetStats() const
+{
+    Stats stats;
+    stats.steps = static_cast<uint32_t>(steps.size());
+    stats.undoSteps = static_cast<uint32_t>(cursor);
+    for (const Step& step : steps)
+        stats.bytesUsed += step.size;
+    stats.capacity = capacity;
+    stats.bytesAllocated = ring.size();
+    stats.stepsDropped = stepsDropped;
+    stats.merges = merges;
+    return stats;
+}
+
+void UndoHistory::ApplyStep(World& world, const Step& step)
+{
+    // XOR runs flip between the old and new bytes, so undo and redo are the same walk
+    const uint8_t* read = ring.data() + step.offset;
+    const uint8_t* end = read + step.size;
+    while (read < end) {
+        Entity entity;
+        entity.index = Get<uint32_t>(read);
+        entity.generation = Get<uint32_t>(read);
+        const ComponentId id = Get<uint16_t>(read);
+        const uint16_t runCount = Get<uint16_t>(read);
+        uint8_t* bytes = static_cast<uint8_t*>(world.GetComponent(entity, id));
+        for (uint16_t r = 0; r < runCount; ++r) {
+            const uint16_t offset = Get<uint16_t>(read);
+            const uint16_t length = Get<uint16_t>(read);
+            if (bytes) {
+                for (uint16_t i = 0; i < length; ++i)
+                    bytes[offset + i] ^= read[i];
+            }
+            read += length;
+        }
+    }
+}
+
+bool UndoHistory::Reserve(size_t size, size_t& outOffset)
+{
+    if (size > capacity)
+        return false;
+    if (ring.empty())
+        ring.resize(capacity);
+    for (;;) {
+        if (steps.empty()) {
+            outOffset = 0;
+            return true;
+        }
+        const size_t tail = steps.front().offset;
+        const size_t head = steps.back().offset + steps.back().size;
+        if (steps.back().offset >= tail) {
+            // Used bytes are [tail, head); free space is after head and before tail
+            if (head + size <= ring.size()) {
+                outOffset = head;
+                return true;
+            }
+            if (size <= tail) {
+                outOffset = 0;
+                return true;
+            }
+        } else if (head + size <= tail) {
+            // Wrapped: free space is between head and tail
+            outOffset = head;
+            return true;
+        }
+        steps.pop_front();
+        ++stepsDropped;
+        if (cursor > 0)
+            --cursor;
+    }
+}
+
+void UndoHistory::ResetTransaction()
+{
+    recording = false;
+    transactionName = nullptr;
+    transactionMergeKey = 0;
+    touched.clear();
+    touchedIndex.clear();
+    snapshots.clear();
+}
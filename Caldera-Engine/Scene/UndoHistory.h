@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include "Component.h"
+#include "Entity.h"
+
+class World;
+
+// Transaction-based undo for component edits. An edit is wrapped in Begin and
+// Commit, and every component it is about to change is announced with Record
+// first, which snapshots that component's bytes. Commit compares the snapshots
+// with the world and keeps only the bytes that changed, as runs of
+// old XOR new. The same runs turn new back into old and old into new, so undo
+// and redo cost the size of the change, whatever the size of the scene.
+//
+// Transactions begun with the same non-zero merge key as the one before them
+// fold into it: a drag that commits every frame leaves one step covering the
+// whole drag.
+//
+// Steps live in one fixed-size ring of bytes, allocated when the first step is
+// stored. When a new step doesn't fit, the oldest steps are dropped, so history
+// memory never exceeds the capacity.
+// Committing after an undo discards the steps that could have been redone.
+//
+// Only component data is tracked. Structural changes (creating or destroying
+// entities, adding or removing components) are not recorded; a step whose
+// entity or component is gone by undo time skips that part of the change.
+class UndoHistory {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 32 * 1024 * 1024;
+
+    struct Stats {
+        uint32_t steps = 0;           // undoable plus redoable
+        uint32_t undoSteps = 0;
+        uint64_t bytesUsed = 0;       // of the ring
+        uint64_t capacity = 0;
+        uint64_t bytesAllocated = 0;  // 0 until the first step is stored
+        uint64_t stepsDropped = 0;    // to make room, oldest first
+        uint64_t merges = 0;
+    };
+
+    explicit UndoHistory(size_t capacity = DEFAULT_CAPACITY);
+
+    // 'name' must outlive the history; menu labels are string literals.
+    void Begin(const char* name, uint64_t mergeKey = 0);
+    template<typename T>
+    void Record(World& world, Entity entity) { Record(world, entity, GetComponentId<T>()); }
+    // Snapshots the component before it changes. Later calls for the same
+    // component in the transaction are ignored, as are missing components.
+    void Record(World& world, Entity entity, ComponentId id);
+    // Stores what changed as a new step. Nothing is stored if nothing changed.
+    void Commit(World& world);
+    // Puts every recorded component back as it was at Begin.
+    void Cancel(World& world);
+    bool IsRecording() const { return recording; }
+
+    bool CanUndo() const { return cursor > 0; }
+    bool CanRedo() const { return cursor < steps.size(); }
+    // Null if there is nothing to undo or redo.
+    const char* GetUndoName() const { return CanUndo() ? steps[cursor - 1].name : nullptr; }
+    const char* GetRedoName() const { return CanRedo() ? steps[cursor].name : nullptr; }
+    bool Undo(World& world);
+    bool Redo(World& world);
+    // Forget all steps, e.g. after loading a scene whose entities have new handles.
+    void Clear();
+
+    Stats GetStats() const;
+
+private:
+    struct Step {
+        const char* name = nullptr;
+        uint64_t mergeKey = 0;
+        size_t offset = 0;  // into the ring
+        size_t size = 0;
+    };
+
+    // A component snapshotted by the open transaction
+    struct Touched {
+        Entity entity;
+        ComponentId component = INVALID_COMPONENT;
+        uint32_t size = 0;
+        size_t snapshot = 0;  // into 'snapshots'
+    };
+
+    static uint64_t GetTouchKey(Entity entity, ComponentId id) { return (uint64_t(entity.index) << 8) | id; }
+    void Touch(Entity entity, ComponentId id, const void* oldBytes);
+    void ApplyStep(World& world, const Step& step);
+    // Room for 'size' contiguous bytes after the newest step, dropping the oldest steps
+    bool Reserve(size_t size, size_t& outOffset);
+    void ResetTransaction();
+
+    size_t capacity = 0;
+    std::vector<uint8_t> ring;
+    std::deque<Step> steps;
+    size_t cursor = 0;  // steps[0, cursor) can be undone, the rest redone
+
+    bool recording = false;
+    const char* transactionName = nullptr;
+    uint64_t transactionMergeKey = 0;
+    std::vector<Touched> touched;
+    std::unordered_map<uint64_t, uint32_t> touchedIndex;
+    std::vector<uint8_t> snapshots;
+    std::vector<uint8_t> encoded;
+
+    uint64_t stepsDropped = 0;
+    uint64_t merges = 0;
+};
@@ -0,0 +1,171 @@
+#include "World.h"
+
+World::World()
+{
+    // Entities without components live here
+    GetOrCreateArchetype(0);
+}
+
+World::~World() = default;
+
+Archetype* World::GetOrCreateArchetype(ComponentMask mask)
+{
+    auto it = archetypeByMask.find(mask);
+    if (it != archetypeByMask.end())
+        return it->second;
+
+    archetypes.push_back(std::make_unique<Archetype>(mask));
+    Archetype* archetype = archetypes.back().get();
+    archetypeByMask.emplace(mask, archetype);
+    return archetype;
+}
+
+const std::vector<Archetype*>& World::MatchArchetypes(ComponentMask required)
+{
+    // Archetypes are never removed, so a cached match only needs the ones created since
+    QueryCache& query = queries[required];
+    for (; query.checked < archetypes.size(); ++query.checked) {
+        Archetype* archetype = archetypes[query.checked].get();
+        if ((archetype->GetMask() & required) == required)
+            query.archetypes.push_back(archetype);
+    }
+    return query.archetypes;
+}
+
+const World::EntityRecord* World::FindRecord(Entity entity) const
+{
+    if (entity.index >= records.size())
+        return nullptr;
+    const EntityRecord& record = records[entity.index];
+    return record.archetype && record.generation == entity.generation ? &record : nullptr;
+}
+
+bool World::IsAlive(Entity entity) const
+{
+    return FindRecord(entity) != nullptr;
+}
+
+Entity World::Create()
+{
+    return CreateWithComponents(0);
+}
+
+Entity World::CreateWithComponents(ComponentMask mask)
+{
+    AssertNotIterating();
+    Entity entity;
+    if (!freeIndices.empty()) {
+        entity.index = freeIndices.back();
+        freeIndices.pop_back();
+    } else {
+        entity.index = static_cast<uint32_t>(records.size());
+        records.emplace_back();
+    }
+
+    EntityRecord& record = records[entity.index];
+    entity.generation = record.generation;
+    record.archetype = GetOrCreateArchetype(mask);
+    record.location = record.archetype->Allocate(entity);
+    ++aliveCount;
+    return entity;
+}
+
+Archetype* World::CreateBulk(ComponentMask mask, uint32_t count, uint32_t& outFirstRow)
+{
+    AssertNotIterating();
+    Archetype* archetype = GetOrCreateArchetype(mask);
+    outFirstRow = archetype->AllocateRows(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        Entity entity;
+        if (!freeIndices.empty()) {
+            entity.index = freeIndices.back();
+            freeIndices.pop_back();
+        } else {
+            entity.index = static_cast<uint32_t>(records.size());
+            records.emplace_back();
+        }
+
+        EntityRecord& record = records[entity.index];
+        entity.generation = record.generation;
+        record.archetype = archetype;
+        record.location = archetype->GetLocation(outFirstRow + i);
+        archetype->GetEntities(record.location.chunk)[record.location.row] = entity;
+    }
+    aliveCount += count;
+    return archetype;
+}
+
+void World::Destroy(Entity entity)
+{
+    AssertNotIterating();
+    if (!FindRecord(entity))
+        return;
+
+    EntityRecord& record = records[entity.index];
+    Entity moved = record.archetype->Remove(record.location);
+    if (moved.IsValid())
+        records[moved.index].location = record.location;
+
+    record.archetype = nullptr;
+    ++record.generation;
+    freeIndices.push_back(entity.index);
+    --aliveCount;
+}
+
+void World::Clear()
+{
+    AssertNotIterating();
+    for (uint32_t i = 0; i < records.size(); ++i) {
+        if (records[i].archetype)
+            Destroy({ i, records[i].generation });
+    }
+}
+
+void World::MoveEntity(Entity entity, EntityRecord& record, Archetype* target)
+{
+    Archetype* source = record.archetype;
+    const Archetype::Location from = record.location;
+    const Archetype::Location to = target->Allocate(entity);
+    Archetype::CopyShared(*source, from, *target, to);
+
+    Entity moved = source->Remove(from);
+    if (moved.IsValid())
+        records[moved.index].location = from;
+    record.archetype = target;
+    record.location = to;
+}
+
+void* World::AddComponent(Entity entity, ComponentId id)
+{
+    AssertNotIterating();
+    if (!FindRecord(entity))
+        return nullptr;
+
+    EntityRecord& record = records[entity.index];
+    if (!record.archetype->Has(id))
+        MoveEntity(entity, record, GetOrCreateArchetype(record.archetype->GetMask() | GetComponentBit(id)));
+    return record.archetype->GetComponent(record.location, id);
+}
+
+void World::RemoveComponent(Entity entity, ComponentId id)
+{
+    AssertNotIterating();
+    if (!FindRecord(entity))
+        return;
+
+    EntityRecord& record = records[entity.index];
+    if (record.archetype->Has(id))
+        MoveEntity(entity, record, GetOrCreateArchetype(record.archetype->GetMask() & ~GetComponentBit(id)));
+}
+
+void* World::GetComponent(Entity entity, ComponentId id)
+{
+    const EntityRecord* record = FindRecord(entity);
+    return record ? record->archetype->GetComponent(record->location, id) : nullptr;
+}
+
+bool World::HasComponent(Entity entity, ComponentId id) const
+{
+    const EntityRecord* record = FindRecord(entity);
+    return record && record->archetype->Has(id);
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Archetype.h"
+#include "Component.h"
+#include "Entity.h"
+#include "../Core/TaskPool.h"
+
+// Entity-component store. Entities with the same component set share an
+// archetype and are packed into its chunks, so a query walks contiguous arrays
+// of exactly the components it asks for. Adding or removing a component moves
+// the entity to another archetype; that is a structural change and is not
+// allowed while a query is iterating. Use an EntityCommandBuffer to defer such
+// changes from inside a system.
+//
+// Queries hand out whole chunks: fn(count, entities, arrays...) with one array
+// per requested component. Request 'const T' for read-only access.
+class World {
+public:
+    // Chunks handed to one ParallelForEachChunk task at a time.
+    static constexpr uint32_t CHUNKS_PER_TASK = 4;
+
+    World();
+    ~World();
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    Entity Create();
+    template<typename... Ts>
+    Entity Create(const Ts&... components);
+    void Destroy(Entity entity);
+    bool IsAlive(Entity entity) const;
+    // Destroys every entity; archetypes and their spare chunks are kept.
+    void Clear();
+
+    // Adds the component, or overwrites it if the entity already has it.
+    template<typename T>
+    T& Add(Entity entity, const T& value = T{});
+    template<typename T>
+    void Remove(Entity entity) { RemoveComponent(entity, GetComponentId<T>()); }
+    // Null if the entity is dead or lacks the component.
+    template<typename T>
+    T* Get(Entity entity) { return static_cast<T*>(GetComponent(entity, GetComponentId<T>())); }
+    template<typename T>
+    bool Has(Entity entity) const { return HasComponent(entity, GetComponentId<T>()); }
+
+    // Type-erased forms of the above, for command buffers and serialization.
+    Entity CreateWithComponents(ComponentMask mask);
+    // Creates 'count' entities with exactly 'mask' at consecutive rows of its
+    // archetype, leaving their components uninitialized for a loader to copy in
+    // column by column. Returns the archetype and the first row.
+    Archetype* CreateBulk(ComponentMask mask, uint32_t count, uint32_t& outFirstRow);
+    void* AddComponent(Entity entity, ComponentId id);
+    void RemoveComponent(Entity entity, ComponentId id);
+    void* GetComponent(Entity entity, ComponentId id);
+    bool HasComponent(Entity entity, ComponentId id) const;
+
+    template<typename... Ts, typename Fn>
+    void ForEachChunk(Fn&& fn);
+    // fn(entity, components...) per entity.
+    template<typename... Ts, typename Fn>
+    void ForEach(Fn&& fn);
+    // Like ForEachChunk, with chunks spread over the pool. 'fn' runs concurrently
+    // on different chunks and must only write the arrays it is given.
+    template<typename... Ts, typename Fn>
+    void ParallelForEachChunk(TaskPool& pool, Fn&& fn);
+
+    uint32_t GetEntityCount() const { return aliveCount; }
+    uint32_t GetArchetypeCount() const { return static_cast<uint32_t>(archetypes.size()); }
+    const std::vector<std::unique_ptr<Archetype>>& GetArchetypes() const { return archetypes; }
+    // Archetypes having every component in 'required', cached per mask.
+    const std::vector<Archetype*>& MatchArchetypes(ComponentMask required);
+
+private:
+    struct EntityRecord {
+        Archetype* archetype = nullptr;
+        Archetype::Location location;
+        uint32_t generation = 1;
+    };
+
+    struct QueryCache {
+        std::vector<Archetype*> archetypes;
+        size_t checked = 0;  // archetypes[0, checked) of the world have been tested
+    };
+
+    Archetype* GetOrCreateArchetype(ComponentMask mask);
+    const EntityRecord* FindRecord(Entity entity) const;
+    void MoveEntity(Entity entity, EntityRecord& record, Archetype* target);
+    void AssertNotIterating() const { assert(iterationDepth == 0 && "Structural change during a query; use an EntityCommandBuffer"); }
+
+    template<typename... Ts, typename Fn, size_t... I>
+    static void InvokeChunk(Fn& fn, Archetype& archetype, uint32_t chunk, const ComponentId* ids, std::index_sequence<I...>)
+    {
+        fn(archetype.GetChunkEntityCount(chunk), static_cast<const Entity*>(archetype.GetEntities(chunk)),
+            static_cast<Ts*>(archetype.GetColumn(chunk, ids[I]))...);
+    }
+
+    std::vector<EntityRecord> records;
+    std::vector<uint32_t> freeIndices;
+    uint32_t aliveCount = 0;
+
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::unordered_map<ComponentMask, Archetype*> archetypeByMask;
+    std::unordered_map<ComponentMask, QueryCache> queries;
+    uint32_t iterationDepth = 0;
+};
+
+template<typename... Ts>
+Entity World::Create(const Ts&... components)
+{
+    Entity entity = CreateWithComponents(MakeComponentMask<Ts...>());
+    (Add<Ts>(entity, components), ...);
+    return entity;
+}
+
+template<typename T>
+T& World::Add(Entity entity, const T& value)
+{
+    T* component = static_cast<T*>(AddComponent(entity, GetComponentId<T>()));
+    assert(component && "Adding a component to a dead entity");
+    *component = value;
+    return *component;
+}
+
+template<typename... Ts, typename Fn>
+void World::ForEachChunk(Fn&& fn)
+{
+    static_assert(sizeof...(Ts) > 0, "A query needs at least one component");
+    const ComponentId ids[] = { GetComponentId<Ts>()... };
+    const std::vector<Archetype*>& matched = MatchArchetypes(MakeComponentMask<Ts...>());
+
+    ++iterationDepth;
+    for (Archetype* archetype : matched) {
+        for (uint32_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+            InvokeChunk<Ts...>(fn, *archetype, chunk, ids, std::index_sequence_for<Ts...>{});
+    }
+    --iterationDepth;
+}
+
+template<typename... Ts, typename Fn>
+void World::ForEach(Fn&& fn)
+{
+    ForEachChunk<Ts...>([&fn](uint32_t count, const Entity* entities, Ts*... arrays) {
+        for (uint32_t i = 0; i < count; ++i)
+            fn(entities[i], arrays[i]...);
+    });
+}
+
+template<typename... Ts, typename Fn>
+void World::ParallelForEachChunk(TaskPool& pool, Fn&& fn)
+{
+    static_assert(sizeof...(Ts) > 0, "A query needs at least one component");
+    const ComponentId ids[] = { GetComponentId<Ts>()... };
+    const std::vector<Archetype*>& matched = MatchArchetypes(MakeComponentMask<Ts...>());
+
+    // Flatten to (archetype, chunk) pairs so tasks are even regardless of archetype sizes
+    std::vector<std::pair<Archetype*, uint32_t>> chunks;
+    for (Archetype* archetype : matched) {
+        for (uint32_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+            chunks.emplace_back(archetype, chunk);
+    }
+
+    const uint32_t chunkCount = static_cast<uint32_t>(chunks.size());
+    ++iterationDepth;
+    pool.ParallelFor((chunkCount + CHUNKS_PER_TASK - 1) / CHUNKS_PER_TASK, [&](uint32_t task) {
+        const uint32_t end = std::min(chunkCount, (task + 1) * CHUNKS_PER_TASK);
+        for (uint32_t i = task * CHUNKS_PER_TASK; i < end; ++i)
+            InvokeChunk<Ts...>(fn, *chunks[i].first, chunks[i].second, ids, std::index_sequence_for<Ts...>{});
+    });
+    --iterationDepth;
+}
@@ -0,0 +1,502 @@
+#include "WorldPartition.h"
+#include "Components.h"
+#include "SceneSerializer.h"
+#include "../Core/JobSystem.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <queue>
+#include <utility>
+
+static constexpr uint32_t PARTITION_LAYOUT_MAGIC = 0x4c505743; // "CWPL"
+static constexpr uint32_t PARTITION_LAYOUT_VERSION = 1;
+// Guards against allocating from a corrupt count or length field
+static constexpr uint32_t MAX_SERIALIZED_ARRAY = 16 * 1024 * 1024;
+
+// Fixed-width little-endian fields, like the pipeline list
+static void WriteU32(std::vector<uint8_t>& out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+static void WriteU64(std::vector<uint8_t>& out, uint64_t value)
+{
+    WriteU32(out, static_cast<uint32_t>(value));
+    WriteU32(out, static_cast<uint32_t>(value >> 32));
+}
+
+static void WriteString(std::vector<uint8_t>& out, const std::string& value)
+{
+    WriteU32(out, static_cast<uint32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+static bool ReadU32(const uint8_t*& cursor, const uint8_t* end, uint32_t& value)
+{
+    if (end - cursor < 4)
+        return false;
+    value = 0;
+    for (int i = 0; i < 4; ++i)
+        value |= uint32_t(cursor[i]) << (i * 8);
+    cursor += 4;
+    return true;
+}
+
+static bool ReadU64(const uint8_t*& cursor, const uint8_t* end, uint64_t& value)
+{
+    uint32_t low, high;
+    if (!ReadU32(cursor, end, low) || !ReadU32(cursor, end, high))
+        return false;
+    value = uint64_t(low) | (uint64_t(high) << 32);
+    return true;
+}
+
+static bool ReadString(const uint8_t*& cursor, const uint8_t* end, std::string& out)
+{
+    uint32_t size;
+    if (!ReadU32(cursor, end, size) || size > MAX_SERIALIZED_ARRAY || uint64_t(end - cursor) < size)
+        return false;
+    out.assign(reinterpret_cast<const char*>(cursor), size);
+    cursor += size;
+    return true;
+}
+
+bool SavePartitionLayout(const PartitionLayout& layout, const std::string& path)
+{
+    const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    std::vector<uint8_t> bytes;
+    WriteU32(bytes, PARTITION_LAYOUT_MAGIC);
+    WriteU32(bytes, PARTITION_LAYOUT_VERSION);
+    uint32_t cellSizeBits;
+    std::memcpy(&cellSizeBits, &layout.cellSize, sizeof(cellSizeBits));
+    WriteU32(bytes, cellSizeBits);
+
+    WriteU32(bytes, static_cast<uint32_t>(layout.assets.size()));
+    for (const PartitionAsset& asset : layout.assets) {
+        WriteString(bytes, asset.path);
+        WriteU64(bytes, asset.bytes);
+    }
+    WriteU32(bytes, static_cast<uint32_t>(layout.cells.size()));
+    for (const PartitionCell& cell : layout.cells) {
+        WriteU32(bytes, static_cast<uint32_t>(cell.x));
+        WriteU32(bytes, static_cast<uint32_t>(cell.z));
+        WriteString(bytes, std::filesystem::path(cell.scenePath).lexically_relative(directory).generic_string());
+        WriteU64(bytes, cell.sceneBytes);
+        WriteU32(bytes, static_cast<uint32_t>(cell.assets.size()));
+        for (uint32_t asset : cell.assets)
+            WriteU32(bytes, asset);
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return file.good();
+}
+
+bool LoadPartitionLayout(const std::string& path, PartitionLayout& outLayout)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+
+    const uint8_t* cursor = bytes.data();
+    const uint8_t* end = cursor + bytes.size();
+    uint32_t magic, version, cellSizeBits, assetCount;
+    if (!ReadU32(cursor, end, magic) || magic != PARTITION_LAYOUT_MAGIC ||
+        !ReadU32(cursor, end, version) || version != PARTITION_LAYOUT_VERSION ||
+        !ReadU32(cursor, end, cellSizeBits) ||
+        !ReadU32(cursor, end, assetCount) || assetCount > MAX_SERIALIZED_ARRAY)
+        return false;
+
+    // Nothing reaches 'outLayout' unless the whole file parses
+    PartitionLayout layout;
+    std::memcpy(&layout.cellSize, &cellSizeBits, sizeof(cellSizeBits));
+    if (!(layout.cellSize > 0.0f))
+        return false;
+    layout.assets.resize(assetCount);
+    for (PartitionAsset& asset : layout.assets) {
+        if (!ReadString(cursor, end, asset.path) || !ReadU64(cursor, end, asset.bytes))
+            return false;
+    }
+
+    uint32_t cellCount;
+    if (!ReadU32(cursor, end, cellCount) || cellCount > MAX_SERIALIZED_ARRAY)
+        return false;
+    layout.cells.resize(cellCount);
+    for (PartitionCell& cell : layout.cells) {
+        uint32_t x, z, cellAssetCount;
+        std::string scenePath;
+        if (!ReadU32(cursor, end, x) || !ReadU32(cursor, end, z) || !ReadString(cursor, end, scenePath) ||
+            !ReadU64(cursor, end, cell.sceneBytes) ||
+            !ReadU32(cursor, end, cellAssetCount) || cellAssetCount > assetCount)
+            return false;
+        cell.x = static_cast<int32_t>(x);
+        cell.z = static_cast<int32_t>(z);
+        cell.scenePath = (directory / scenePath).string();
+        cell.assets.resize(cellAssetCount);
+        for (uint32_t& asset : cell.assets) {
+            if (!ReadU32(cursor, end, asset) || asset >= assetCount)
+                return false;
+        }
+    }
+    if (cursor != end)
+        return false;
+
+    outLayout = std::move(layout);
+    return true;
+}
+
+bool PartitionWorld(World& world, float cellSize, const std::string& directory,
+    const std::vector<std::string>& meshAssets, PartitionLayout& outLayout)
+{
+    assert(cellSize > 0.0f && "Cells need a positive size");
+    const ComponentId transformId = GetComponentId<TransformComponent>();
+    const ComponentId renderableId = GetComponentId<RenderableComponent>();
+
+    // Rows of each source archetype per cell; std::map keeps the cells in a stable order
+    struct CellRows {
+        std::vector<std::vector<uint32_t>> rows;  // per source archetype
+        std::vector<uint32_t> assets;
+    };
+    std::map<std::pair<int32_t, int32_t>, CellRows> grid;
+    std::map<std::string, uint32_t> assetIndices;
+    PartitionLayout layout;
+    layout.cellSize = cellSize;
+
+    const std::vector<std::unique_ptr<Archetype>>& archetypes = world.GetArchetypes();
+    for (size_t a = 0; a < archetypes.size(); ++a) {
+        Archetype& archetype = *archetypes[a];
+        for (uint32_t k = 0; k < archetype.GetChunkCount(); ++k) {
+            const TransformComponent* transforms = static_cast<const TransformComponent*>(archetype.GetColumn(k, transformId));
+            const RenderableComponent* renderables = static_cast<const RenderableComponent*>(archetype.GetColumn(k, renderableId));
+            for (uint32_t row = 0; row < archetype.GetChunkEntityCount(k); ++row) {
+                std::pair<int32_t, int32_t> coord = { 0, 0 };
+                if (transforms) {
+                    coord.first = static_cast<int32_t>(std::floor(transforms[row].position[0] / cellSize));
+                    coord.second = static_cast<int32_t>(std::floor(transforms[row].position[2] / cellSize));
+                }
+                CellRows& cell = grid[coord];
+                cell.rows.resize(archetypes.size());
+                cell.rows[a].push_back(k * archetype.GetChunkCapacity() + row);
+
+                if (renderables && renderables[row].mesh < meshAssets.size()) {
+                    const std::string& path = meshAssets[renderables[row].mesh];
+                    auto inserted = assetIndices.emplace(path, static_cast<uint32_t>(layout.assets.size()));
+                    if (inserted.second) {
+                        std::error_code error;
+                        const uintmax_t size = std::filesystem::file_size(path, error);
+                        layout.assets.push_back({ path, error ? 0 : static_cast<uint64_t>(size) });
+                    }
+                    cell.assets.push_back(inserted.first->second);
+                }
+            }
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    SceneSerializer serializer;
+    for (auto& [coord, cellRows] : grid) {
+        World cellWorld;
+        for (size_t a = 0; a < archetypes.size(); ++a) {
+            const std::vector<uint32_t>& rows = cellRows.rows[a];
+            if (rows.empty())
+                continue;
+            Archetype& source = *archetypes[a];
+            uint32_t firstRow;
+            Archetype* target = cellWorld.CreateBulk(source.GetMask(), static_cast<uint32_t>(rows.size()), firstRow);
+            for (ComponentId id : source.GetComponents()) {
+                const uint32_t size = ComponentRegistry::Get(id).size;
+                for (size_t i = 0; i < rows.size(); ++i) {
+                    std::memcpy(target->GetComponent(target->GetLocation(firstRow + static_cast<uint32_t>(i)), id),
+                        source.GetComponent(source.GetLocation(rows[i]), id), size);
+                }
+            }
+        }
+
+        PartitionCell cell;
+        cell.x = coord.first;
+        cell.z = coord.second;
+        cell.scenePath = (std::filesystem::path(directory) /
+            ("cell_" + std::to_string(cell.x) + "_" + std::to_string(cell.z) + ".cscene")).string();
+        serializer.Reset();
+        if (!serializer.Save(cellWorld, cell.scenePath))
+            return false;
+        cell.sceneBytes = std::filesystem::file_size(cell.scenePath, error);
+        if (error)
+            return false;
+        std::sort(cellRows.assets.begin(), cellRows.assets.end());
+        cellRows.assets.erase(std::unique(cellRows.assets.begin(), cellRows.assets.end()), cellRows.assets.end());
+        cell.assets = std::move(cellRows.assets);
+        layout.cells.push_back(std::move(cell));
+    }
+
+    if (!SavePartitionLayout(layout, (std::filesystem::path(directory) / "partition.cwp").string()))
+        return false;
+    outLayout = std::move(layout);
+    return true;
+}
+
+bool WorldPartition::Initialize(PartitionLayout partitionLayout, const StreamingSettings& streamingSettings, JobSystem& streamingJobs, StreamingCallbacks streamingCallbacks)
+{
+    assert(!IsInitialized() && "WorldPartition already initialized");
+    assert(streamingSettings.unloadRadius >= streamingSettings.loadRadius && "Unload radius must not be inside the load radius");
+    assert(streamingSettings.maxLoadsInFlight > 0 && "Streaming needs at least one load in flight");
+    for (const PartitionCell& cell : partitionLayout.cells) {
+        for (uint32_t asset : cell.assets) {
+            if (asset >= partitionLayout.assets.size())
+                return false;
+        }
+    }
+
+    layout = std::move(partitionLayout);
+    settings = streamingSettings;
+    callbacks = std::move(streamingCallbacks);
+    if (!callbacks.loadCell) {
+        callbacks.loadCell = [](const PartitionCell& cell, World& world) {
+            SceneSerializer serializer;
+            return serializer.Load(world, cell.scenePath);
+        };
+    }
+
+    cells.clear();
+    cells.resize(layout.cells.size());
+    assetRefs.assign(layout.assets.size(), 0);
+    residentBytes = 0;
+    pendingReleaseBytes = 0;
+    loadsInFlight = 0;
+    jobsInFlight = 0;
+    counters = StreamingStats();
+    draining = false;
+    jobSystem = &streamingJobs;
+    return true;
+}
+
+void WorldPartition::Shutdown()
+{
+    if (!IsInitialized())
+        return;
+    // Loads still in flight finish first, so every cell can go through a normal unload
+    Flush();
+    for (uint32_t cell = 0; cell < cells.size(); ++cell) {
+        if (cells[cell].state == CellState::Loaded)
+            IssueUnload(cell);
+    }
+    Flush();
+
+    jobSystem = nullptr;
+    cells.clear();
+    assetRefs.clear();
+}
+
+float WorldPartition::GetDistance(const PartitionCell& cell, const float cameraPosition[3]) const
+{
+    // To the nearest point of the cell's rectangle; zero inside it
+    const float minX = cell.x * layout.cellSize;
+    const float minZ = cell.z * layout.cellSize;
+    const float dx = std::max({ minX - cameraPosition[0], 0.0f, cameraPosition[0] - (minX + layout.cellSize) });
+    const float dz = std::max({ minZ - cameraPosition[2], 0.0f, cameraPosition[2] - (minZ + layout.cellSize) });
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+void WorldPartition::Update(const float cameraPosition[3])
+{
+    assert(IsInitialized() && "WorldPartition not initialized");
+    ApplyCompletions();
+
+    // Nearest wanted cell first; resident cells farthest first for eviction
+    using Candidate = std::pair<float, uint32_t>;
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> loads;
+    std::priority_queue<Candidate> evictable;
+    for (uint32_t index = 0; index < cells.size(); ++index) {
+        CellRuntime& cell = cells[index];
+        cell.distance = GetDistance(layout.cells[index], cameraPosition);
+        if (cell.state == CellState::Loaded) {
+            if (cell.distance > settings.unloadRadius)
+                IssueUnload(index);
+            else
+                evictable.push({ cell.distance, index });
+        } else if (cell.state == CellState::Unloaded && cell.distance <= settings.loadRadius) {
+            loads.push({ cell.distance, index });
+        }
+    }
+
+    while (!loads.empty() && loadsInFlight < settings.maxLoadsInFlight) {
+        const Candidate next = loads.top();
+        uint64_t cost = layout.cells[next.second].sceneBytes;
+        for (uint32_t asset : layout.cells[next.second].assets) {
+            if (assetRefs[asset] == 0)
+                cost += layout.assets[asset].bytes;
+        }
+
+        if (residentBytes + cost > settings.memoryBudget) {
+            // Evicted memory comes back only when the unload finishes, so the load waits for a later update
+            while (!evictable.empty() && evictable.top().first > next.first &&
+                   residentBytes - pendingReleaseBytes + cost > settings.memoryBudget) {
+                if (evictable.top().first <= settings.loadRadius)
+                    ++counters.evictions;
+                IssueUnload(evictable.top().second);
+                evictable.pop();
+            }
+            ++counters.budgetStalls;
+            break;
+        }
+
+        loads.pop();
+        IssueLoad(next.second);
+    }
+}
+
+void WorldPartition::Flush()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [&] { return completed.size() == jobsInFlight; });
+    }
+    ApplyCompletions();
+}
+
+StreamingStats WorldPartition::GetStats() const
+{
+    StreamingStats stats = counters;
+    for (const CellRuntime& cell : cells) {
+        stats.loadedCells += cell.state == CellState::Loaded;
+        stats.loadingCells += cell.state == CellState::Loading;
+        stats.unloadingCells += cell.state == CellState::Unloading;
+        stats.failedCells += cell.state == CellState::Failed;
+    }
+    stats.residentBytes = residentBytes;
+    return stats;
+}
+
+void WorldPartition::IssueLoad(uint32_t cell)
+{
+    Job job;
+    job.load = true;
+    job.cell = cell;
+    residentBytes += layout.cells[cell].sceneBytes;
+    for (uint32_t asset : layout.cells[cell].assets) {
+        if (assetRefs[asset]++ == 0) {
+            residentBytes += layout.assets[asset].bytes;
+            job.assets.push_back(asset);
+        }
+    }
+    cells[cell].state = CellState::Loading;
+    ++loadsInFlight;
+    ++counters.loadsIssued;
+    Submit(std::move(job));
+}
+
+void WorldPartition::IssueUnload(uint32_t cell)
+{
+    Job job;
+    job.cell = cell;
+    job.world = std::move(cells[cell].world);
+    job.releaseBytes = layout.cells[cell].sceneBytes;
+    for (uint32_t asset : layout.cells[cell].assets) {
+        if (--assetRefs[asset] == 0) {
+            job.releaseBytes += layout.assets[asset].bytes;
+            job.assets.push_back(asset);
+        }
+    }
+    pendingReleaseBytes += job.releaseBytes;
+    cells[cell].state = CellState::Unloading;
+    ++counters.unloadsIssued;
+    Submit(std::move(job));
+}
+
+void WorldPartition::Submit(Job job)
+{
+    ++jobsInFlight;
+    bool startDrain = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+        startDrain = !draining;
+        draining = true;
+    }
+    // A single job drains the queue, so a cell's unload never races its reload
+    if (startDrain)
+        jobSystem->Run([this] { DrainJobs(); }, JobPriority::Background, "WorldPartition streaming");
+}
+
+void WorldPartition::ApplyCompletions()
+{
+    std::vector<Job> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.swap(completed);
+        jobsInFlight -= static_cast<uint32_t>(finished.size());
+    }
+
+    for (Job& job : finished) {
+        CellRuntime& cell = cells[job.cell];
+        if (!job.load) {
+            residentBytes -= job.releaseBytes;
+            pendingReleaseBytes -= job.releaseBytes;
+            // A failed load's release leaves the cell marked as failed
+            if (cell.state == CellState::Unloading)
+                cell.state = CellState::Unloaded;
+            continue;
+        }
+
+        --loadsInFlight;
+        if (job.succeeded) {
+            cell.world = std::move(job.world);
+            cell.state = CellState::Loaded;
+        } else {
+            // Give back the reservation; the cell isn't retried
+            IssueUnload(job.cell);
+            cell.state = CellState::Failed;
+        }
+    }
+}
+
+void WorldPartition::DrainJobs()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!jobs.empty()) {
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+
+        lock.unlock();
+        RunJob(job);
+        lock.lock();
+
+        completed.push_back(std::move(job));
+    }
+    draining = false;
+    idle.notify_all();
+}
+
+void WorldPartition::RunJob(Job& job)
+{
+    if (!job.load) {
+        for (uint32_t asset : job.assets) {
+            if (callbacks.unloadAsset)
+                callbacks.unloadAsset(layout.assets[asset]);
+        }
+        job.world.reset();
+        return;
+    }
+
+    job.succeeded = true;
+    for (uint32_t asset : job.assets) {
+        if (callbacks.loadAsset && !callbacks.loadAsset(layout.assets[asset]))
+            job.succeeded = false;
+    }
+    if (job.succeeded) {
+        job.world = std::make_unique<World>();
+        job.succeeded = callbacks.loadCell(layout.cells[job.cell], *job.world);
+    }
+    if (!job.succeeded)
+        job.world.reset();
+}
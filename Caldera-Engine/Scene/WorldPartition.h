@@ -0,0 +1,169 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "World.h"
+
+class JobSystem;
+
+// Large scenes are split into square cells on the XZ plane, each saved as its
+// own scene file with the list of assets its entities use. WorldPartition
+// keeps the cells around the camera resident: cells whose rectangle comes
+// within loadRadius of the camera are loaded, and cells that drift beyond the
+// larger unloadRadius are unloaded, so a camera sitting on a boundary doesn't
+// make a cell flicker in and out.
+//
+// All file and asset work happens in a Background job of the JobSystem, one at a
+// time so loads and unloads run in the order they were issued. Each cell loads
+// into a World of its own, so when a load finishes the main thread only takes
+// ownership of the finished World; unloading hands the World back to the
+// streaming job to be destroyed. Update never waits for streaming.
+//
+// Memory is budgeted from the sizes recorded in the layout. A load reserves its
+// scene and any assets no resident cell shares before it is issued, and an
+// unload releases them only once the streaming job has actually freed them.
+// Loads are issued nearest cell first; when the next one doesn't fit, resident
+// cells farther from the camera than it are evicted, farthest first.
+struct PartitionAsset {
+    std::string path;
+    uint64_t bytes = 0;
+};
+
+struct PartitionCell {
+    int32_t x = 0;  // grid coordinates; the cell covers [x, x + 1) * cellSize
+    int32_t z = 0;
+    std::string scenePath;
+    uint64_t sceneBytes = 0;
+    std::vector<uint32_t> assets;  // into PartitionLayout::assets
+};
+
+struct PartitionLayout {
+    float cellSize = 64.0f;
+    std::vector<PartitionAsset> assets;
+    std::vector<PartitionCell> cells;
+};
+
+// Scene paths are stored relative to the layout file and resolved against it on load.
+bool SavePartitionLayout(const PartitionLayout& layout, const std::string& path);
+bool LoadPartitionLayout(const std::string& path, PartitionLayout& outLayout);
+
+// Splits 'world' into cells by Transform position and saves each non-empty cell
+// as "cell_<x>_<z>.cscene" in 'directory', along with "partition.cwp". Entities
+// without a Transform go to cell (0, 0). A Renderable's mesh id indexes
+// 'meshAssets' to find the asset the cell depends on.
+bool PartitionWorld(World& world, float cellSize, const std::string& directory,
+    const std::vector<std::string>& meshAssets, PartitionLayout& outLayout);
+
+struct StreamingSettings {
+    float loadRadius = 128.0f;
+    float unloadRadius = 160.0f;  // must be at least loadRadius
+    uint64_t memoryBudget = 512ull * 1024 * 1024;
+    // Few loads are queued at once, so the order keeps up with the camera
+    uint32_t maxLoadsInFlight = 2;
+};
+
+// Run in the streaming job. A cell with a failed asset or scene stays unloaded.
+struct StreamingCallbacks {
+    // Defaults to loading the cell's scene file with SceneSerializer
+    std::function<bool(const PartitionCell&, World&)> loadCell;
+    std::function<bool(const PartitionAsset&)> loadAsset;
+    // Also called for the assets of a cell that failed to load
+    std::function<void(const PartitionAsset&)> unloadAsset;
+};
+
+enum class CellState : uint8_t {
+    Unloaded,
+    Loading,
+    Loaded,
+    Unloading,
+    Failed,
+};
+
+struct StreamingStats {
+    uint32_t loadedCells = 0;
+    uint32_t loadingCells = 0;
+    uint32_t unloadingCells = 0;
+    uint32_t failedCells = 0;
+    uint64_t residentBytes = 0;  // reserved by loaded cells and pending loads and unloads
+    uint64_t loadsIssued = 0;
+    uint64_t unloadsIssued = 0;
+    uint64_t evictions = 0;      // unloads of cells still within loadRadius
+    uint64_t budgetStalls = 0;   // updates that left a wanted cell unloaded for lack of memory
+};
+
+class WorldPartition {
+public:
+    ~WorldPartition() { Shutdown(); }
+
+    // 'jobSystem' runs the streaming and must outlive the partition's Shutdown.
+    bool Initialize(PartitionLayout layout, const StreamingSettings& settings, JobSystem& jobSystem, StreamingCallbacks callbacks = {});
+    // Unloads every cell and waits for the streaming to finish.
+    void Shutdown();
+    bool IsInitialized() const { return jobSystem != nullptr; }
+
+    // Once per frame on the main thread: takes finished loads and issues new ones.
+    void Update(const float cameraPosition[3]);
+    // Blocks until streaming is idle and takes what it finished. For
+    // tools and tests; the frame loop only calls Update.
+    void Flush();
+
+    uint32_t GetCellCount() const { return static_cast<uint32_t>(layout.cells.size()); }
+    const PartitionLayout& GetLayout() const { return layout; }
+    CellState GetCellState(uint32_t cell) const { return cells[cell].state; }
+    // Null unless the cell is loaded.
+    World* GetCellWorld(uint32_t cell) { return cells[cell].world.get(); }
+    StreamingStats GetStats() const;
+
+private:
+    struct CellRuntime {
+        CellState state = CellState::Unloaded;
+        std::unique_ptr<World> world;
+        float distance = 0.0f;
+    };
+
+    struct Job {
+        bool load = false;
+        uint32_t cell = 0;
+        std::vector<uint32_t> assets;  // to load or unload
+        std::unique_ptr<World> world;  // loaded into, or to destroy
+        uint64_t releaseBytes = 0;     // unloads: reservation freed once done
+        bool succeeded = false;
+    };
+
+    float GetDistance(const PartitionCell& cell, const float cameraPosition[3]) const;
+    void IssueLoad(uint32_t cell);
+    void IssueUnload(uint32_t cell);
+    void Submit(Job job);
+    void ApplyCompletions();
+    // Body of the streaming job: runs queued jobs until there are none
+    void DrainJobs();
+    void RunJob(Job& job);
+
+    PartitionLayout layout;
+    StreamingSettings settings;
+    StreamingCallbacks callbacks;
+
+    // Main thread only
+    std::vector<CellRuntime> cells;
+    std::vector<uint32_t> assetRefs;
+    uint64_t residentBytes = 0;
+    uint64_t pendingReleaseBytes = 0;  // part of residentBytes that unloads in flight will free
+    uint32_t loadsInFlight = 0;
+    uint32_t jobsInFlight = 0;
+    StreamingStats counters;
+
+    JobSystem* jobSystem = nullptr;
+
+    // Shared with the streaming job
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::deque<Job> jobs;
+    std::vector<Job> completed;
+    bool draining = false;  // a streaming job is queued or running
+};
@@ -0,0 +1,115 @@
+#include "TestSupport.h"
+#include "../Rendering/BindlessTable.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// A handle's shader index never changes while it lives, whatever happens around it
+static void TestStableIndices()
+{
+    DescriptorIndexAllocator indices;
+    indices.Initialize(64);
+    BindlessTable table;
+    table.Initialize(&indices);
+
+    std::vector<BindlessHandle> handles;
+    for (int i = 0; i < 32; ++i)
+        handles.push_back(table.Allocate(i % 2 ? BindlessResourceType::Buffer : BindlessResourceType::Texture));
+    CHECK(table.GetLiveCount(BindlessResourceType::Texture) == 16 && table.GetLiveCount(BindlessResourceType::Buffer) == 16);
+
+    std::vector<uint32_t> shaderIndices;
+    for (BindlessHandle handle : handles) {
+        CHECK(table.IsValid(handle));
+        shaderIndices.push_back(table.GetShaderIndex(handle));
+        CHECK(shaderIndices.back() == handle.index);
+    }
+
+    // Churn: release every other handle, recycle their slots, allocate more
+    for (size_t i = 0; i < handles.size(); i += 2)
+        CHECK(table.Release(handles[i], 1));
+    CHECK(indices.ProcessDeferredFrees(1) == 16);
+    for (int i = 0; i < 24; ++i)
+        CHECK(table.Allocate(BindlessResourceType::Buffer).IsValid());
+
+    for (size_t i = 1; i < handles.size(); i += 2) {
+        CHECK(table.GetShaderIndex(handles[i]) == shaderIndices[i]);
+        CHECK(table.GetType(handles[i]) == BindlessResourceType::Buffer);
+    }
+    CHECK(table.GetLiveCount(BindlessResourceType::Texture) == 0 && table.GetLiveCount(BindlessResourceType::Buffer) == 40);
+    table.Shutdown();
+}
+
+// A released slot stays out of circulation until its fence value completes
+static void TestDeferredReuse()
+{
+    DescriptorIndexAllocator indices;
+    indices.Initialize(4);
+    BindlessTable table;
+    table.Initialize(&indices);
+
+    const BindlessHandle first = table.Allocate(BindlessResourceType::Texture);
+    const BindlessHandle second = table.Allocate(BindlessResourceType::Texture);
+    CHECK(table.Release(first, 10));
+    // Invalid at once, even though the GPU may still read the slot
+    CHECK(!table.IsValid(first));
+    CHECK(table.GetShaderIndex(first) == INVALID_DESCRIPTOR_INDEX);
+    CHECK(table.GetType(first) == BindlessResourceType::None);
+
+    // Fence not there yet: new handles get untouched slots
+    CHECK(indices.ProcessDeferredFrees(9) == 0);
+    const BindlessHandle third = table.Allocate(BindlessResourceType::Buffer);
+    CHECK(third.index != first.index && third.index != second.index);
+
+    // Once it is, the slot comes back under a new generation
+    CHECK(indices.ProcessDeferredFrees(10) == 1);
+    const BindlessHandle reused = table.Allocate(BindlessResourceType::Buffer);
+    CHECK(reused.index == first.index && reused != first);
+    CHECK(table.IsValid(reused) && !table.IsValid(first));
+    CHECK(table.GetType(reused) == BindlessResourceType::Buffer);
+    table.Shutdown();
+}
+
+// Releasing twice, or releasing a handle whose slot was reused, changes nothing
+static void TestDoubleFree()
+{
+    DescriptorIndexAllocator indices;
+    indices.Initialize(8);
+    BindlessTable table;
+    table.Initialize(&indices);
+
+    CHECK(!table.Release(BindlessHandle(), 1));
+
+    const BindlessHandle handle = table.Allocate(BindlessResourceType::Texture);
+    CHECK(table.Release(handle, 1));
+    CHECK(!table.Release(handle, 2));
+    CHECK(indices.GetPendingFreeCount() == 1);
+    CHECK(table.GetLiveCount(BindlessResourceType::Texture) == 0);
+
+    indices.ProcessDeferredFrees(2);
+    const BindlessHandle reused = table.Allocate(BindlessResourceType::Texture);
+    CHECK(reused.index == handle.index);
+    CHECK(!table.Release(handle, 3));
+    CHECK(table.IsValid(reused) && indices.GetPendingFreeCount() == 0);
+    CHECK(table.GetLiveCount(BindlessResourceType::Texture) == 1);
+
+    // Threads racing to release one handle: exactly one wins
+    std::atomic<int> released{ 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t)
+        threads.emplace_back([&] { released += table.Release(reused, 4) ? 1 : 0; });
+    for (std::thread& thread : threads)
+        thread.join();
+    CHECK(released == 1);
+    CHECK(indices.GetPendingFreeCount() == 1);
+    CHECK(table.GetLiveCount(BindlessResourceType::Texture) == 0);
+    table.Shutdown();
+}
+
+int main()
+{
+    TestStableIndices();
+    TestDeferredReuse();
+    TestDoubleFree();
+    std::printf("BindlessTableTest passed\n");
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "TestSupport.h"
+#include "../Rendering/DescriptorAllocator.h"
+#include <atomic>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Threads allocate and free at random; no slot is ever handed out twice
+static void TestConcurrentAllocFree()
+{
+    const uint32_t capacity = 4096;
+    const int threadCount = 8;
+    const int iterations = 20000;
+    DescriptorIndexAllocator allocator;
+    allocator.Initialize(capacity);
+
+    std::unique_ptr<std::atomic<uint8_t>[]> owned(new std::atomic<uint8_t>[capacity]);
+    for (uint32_t i = 0; i < capacity; ++i)
+        owned[i].store(0);
+    std::atomic<int> failures{ 0 };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(t);
+            std::vector<uint32_t> held;
+            for (int i = 0; i < iterations; ++i) {
+                // Each thread holds at most capacity / threadCount, so the heap never runs out
+                if (held.empty() || (held.size() < capacity / threadCount && rng() % 2)) {
+                    const uint32_t index = allocator.Allocate();
+                    if (index >= capacity || owned[index].exchange(1) != 0)
+                        ++failures;
+                    held.push_back(index);
+                } else {
+                    const size_t pick = rng() % held.size();
+                    const uint32_t index = held[pick];
+                    held[pick] = held.back();
+                    held.pop_back();
+                    owned[index].store(0);
+                    allocator.Free(index);
+                }
+            }
+            for (uint32_t index : held) {
+                owned[index].store(0);
+                allocator.Free(index);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    CHECK(failures == 0);
+    CHECK(allocator.GetLiveCount() == 0);
+    CHECK(allocator.GetHighWater() <= capacity);
+
+    // Every slot comes back exactly once, whether freed or never touched
+    std::vector<uint8_t> seen(capacity, 0);
+    for (uint32_t i = 0; i < capacity; ++i) {
+        const uint32_t index = allocator.Allocate();
+        CHECK(index < capacity && !seen[index]);
+        seen[index] = 1;
+    }
+    CHECK(allocator.GetLiveCount() == capacity && allocator.GetHighWater() == capacity);
+}
+
+// A deferred slot stays out of circulation until its fence value completes
+static void TestDeferredFree()
+{
+    DescriptorIndexAllocator allocator;
+    allocator.Initialize(4);
+    const uint32_t a = allocator.Allocate();
+    const uint32_t b = allocator.Allocate();
+    const uint32_t c = allocator.Allocate();
+    allocator.FreeDeferred(a, 5);
+    allocator.FreeDeferred(b, 6);
+    CHECK(allocator.GetPendingFreeCount() == 2 && allocator.GetLiveCount() == 3);
+
+    // Nothing has retired: the last untouched slot is used and a, b stay pending
+    CHECK(allocator.ProcessDeferredFrees(4) == 0);
+    const uint32_t d = allocator.Allocate();
+    CHECK(d != a && d != b && d != c);
+
+    CHECK(allocator.ProcessDeferredFrees(5) == 1);
+    CHECK(allocator.GetPendingFreeCount() == 1 && allocator.GetLiveCount() == 3);
+    CHECK(allocator.Allocate() == a);
+
+    // A completed value past several retire values recycles them all at once
+    allocator.FreeDeferred(c, 7);
+    CHECK(allocator.ProcessDeferredFrees(100) == 2);
+    CHECK(allocator.GetPendingFreeCount() == 0 && allocator.GetLiveCount() == 2);
+    const uint32_t first = allocator.Allocate();
+    const uint32_t second = allocator.Allocate();
+    CHECK((first == b && second == c) || (first == c && second == b));
+    CHECK(allocator.GetHighWater() == 4);
+}
+
+// Each frame slot has its own window, and a slot's window is reused when it comes around again
+static void TestTransientRingWrap()
+{
+    const uint32_t base = 100, perFrame = 8, frames = 3;
+    TransientDescriptorRing ring;
+    ring.Initialize(base, perFrame, frames);
+
+    for (uint32_t frame = 0; frame < frames * 3; ++frame) {
+        const uint32_t slot = frame % frames;
+        ring.BeginFrame(slot);
+        CHECK(ring.GetUsedThisFrame() == 0);
+        const uint32_t window = base + slot * perFrame;
+        CHECK(ring.Allocate(3) == window);
+        CHECK(ring.Allocate() == window + 3);
+        // The window fills exactly; it does not spill into the next slot's
+        CHECK(ring.Allocate(perFrame - 4) == window + 4);
+        CHECK(ring.GetUsedThisFrame() == perFrame);
+    }
+    ring.BeginFrame(0);
+    CHECK(ring.GetPeakUsage() == perFrame);
+}
+
+// Allocations from several threads within one frame don't overlap
+static void TestTransientConcurrent()
+{
+    const uint32_t perFrame = 4 * 1000;
+    TransientDescriptorRing ring;
+    ring.Initialize(0, perFrame, 2);
+    ring.BeginFrame(1);
+
+    std::vector<uint8_t> used(perFrame * 2, 0);
+    std::vector<std::vector<uint32_t>> firsts(4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 500; ++i)
+                firsts[t].push_back(ring.Allocate(2));
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    for (const std::vector<uint32_t>& list : firsts) {
+        for (uint32_t first : list) {
+            CHECK(first >= perFrame && first + 2 <= perFrame * 2);
+            CHECK(!used[first] && !used[first + 1]);
+            used[first] = used[first + 1] = 1;
+        }
+    }
+    CHECK(ring.GetUsedThisFrame() == perFrame);
+}
+
+int main()
+{
+    TestConcurrentAllocFree();
+    TestDeferredFree();
+    TestTransientRingWrap();
+    TestTransientConcurrent();
+    std::printf("DescriptorAllocatorTest passed\n");
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "TestSupport.h"
+#include "../Core/TaskPool.h"
+#include "../Rendering/DrawList.h"
+#include <random>
+#include <vector>
+
+// Draw list build time, and how many draw calls and state changes are left of
+// the renderables, for scenes from heavily shared to barely shared materials
+// and meshes.
+int main(int argc, char** argv)
+{
+    const uint32_t count = IsQuickRun(argc, argv) ? 5000 : 200000;
+    const int repeats = IsQuickRun(argc, argv) ? 1 : 5;
+
+    TaskPool pool;
+    pool.Initialize();
+    std::vector<uint8_t> memory(uint64_t(count) * sizeof(DrawInstanceData));
+    InstanceRing ring;
+    ring.Initialize(memory.data(), memory.size(), 1);
+
+    struct Scene {
+        const char* name;
+        uint32_t pipelines, materials, meshes;
+        float transparentShare;
+    };
+    const Scene scenes[] = {
+        { "foliage", 2, 8, 4, 0.0f },
+        { "city", 4, 64, 32, 0.05f },
+        { "mixed", 8, 512, 256, 0.2f },
+        { "unique", 16, 4096, 4096, 0.0f },
+    };
+
+    std::printf("%u renderables, %u threads\n", count, pool.GetThreadCount());
+    std::printf("%-8s %9s %9s %10s %10s %10s %10s %10s\n", "scene", "draws", "saved", "pipelines", "materials", "meshes", "serial ms", "pool ms");
+    for (const Scene& scene : scenes) {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        DrawListBuilder builder;
+        builder.Reserve(count);
+        builder.Begin();
+        for (uint32_t i = 0; i < count; ++i) {
+            Renderable renderable;
+            renderable.pass = unit(rng) < scene.transparentShare ? DrawPass::Transparent : DrawPass::Opaque;
+            renderable.pipeline = rng() % scene.pipelines;
+            renderable.material = rng() % scene.materials;
+            renderable.mesh = rng() % scene.meshes;
+            renderable.depth = unit(rng);
+            builder.Add(renderable);
+        }
+
+        double ms[2] = {};
+        for (int threaded = 0; threaded < 2; ++threaded) {
+            builder.Initialize(threaded ? &pool : nullptr);
+            ms[threaded] = MeasureBestMs(repeats, [&] {
+                ring.BeginFrame(0);
+                builder.Build(ring);
+            });
+        }
+        const DrawListStats& stats = builder.GetStats();
+        CHECK(stats.droppedRenderables == 0);
+        std::printf("%-8s %9u %8.1f%% %10u %10u %10u %10.3f %10.3f\n", scene.name, stats.drawCalls, stats.GetDrawCallReduction() * 100.0f,
+            stats.pipelineChanges, stats.materialChanges, stats.meshChanges, ms[0], ms[1]);
+    }
+
+    pool.Shutdown();
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include "TestSupport.h"
+#include "../Rendering/DrawList.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+static Renderable MakeRenderable(DrawPass pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+{
+    Renderable renderable;
+    renderable.pass = pass;
+    renderable.pipeline = pipeline;
+    renderable.material = material;
+    renderable.mesh = mesh;
+    renderable.depth = depth;
+    // Tagged so the test can tell which renderable an instance came from
+    renderable.instance.world[3] = depth;
+    return renderable;
+}
+
+// Opaque sorts by state, then front to back; transparent comes after and sorts back to front
+static void TestKeyOrder()
+{
+    const uint64_t opaqueNear = MakeDrawKey(DrawPass::Opaque, 1, 1, 1, 0.1f);
+    const uint64_t opaqueFar = MakeDrawKey(DrawPass::Opaque, 1, 1, 1, 0.9f);
+    CHECK(opaqueNear < opaqueFar);
+    // State outranks depth, most significant first
+    CHECK(MakeDrawKey(DrawPass::Opaque, 1, 1, 2, 0.0f) > opaqueFar);
+    CHECK(MakeDrawKey(DrawPass::Opaque, 1, 2, 0, 0.0f) > MakeDrawKey(DrawPass::Opaque, 1, 1, 9, 1.0f));
+    CHECK(MakeDrawKey(DrawPass::Opaque, 2, 0, 0, 0.0f) > MakeDrawKey(DrawPass::Opaque, 1, 9, 9, 1.0f));
+
+    // Every transparent draw after every opaque one
+    const uint64_t transparentFar = MakeDrawKey(DrawPass::Transparent, 0, 0, 0, 1.0f);
+    CHECK(transparentFar > MakeDrawKey(DrawPass::Opaque, 4095, 65535, 65535, 1.0f));
+    // Depth outranks state: far first, whatever the state
+    const uint64_t transparentNear = MakeDrawKey(DrawPass::Transparent, 0, 0, 0, 0.1f);
+    CHECK(transparentFar < transparentNear);
+    CHECK(MakeDrawKey(DrawPass::Transparent, 4095, 65535, 65535, 0.9f) < transparentNear);
+    CHECK(MakeDrawKey(DrawPass::Transparent, 1, 0, 0, 0.5f) > MakeDrawKey(DrawPass::Transparent, 0, 0, 0, 0.5f));
+
+    // Depth is clamped and NaN treated as nearest; ids are masked to their field
+    CHECK(MakeDrawKey(DrawPass::Opaque, 1, 1, 1, -3.0f) == MakeDrawKey(DrawPass::Opaque, 1, 1, 1, 0.0f));
+    CHECK(MakeDrawKey(DrawPass::Opaque, 1, 1, 1, 7.0f) == MakeDrawKey(DrawPass::Opaque, 1, 1, 1, 1.0f));
+    CHECK(MakeDrawKey(DrawPass::Opaque, 1, 1, 1, std::nanf("")) == MakeDrawKey(DrawPass::Opaque, 1, 1, 1, 0.0f));
+    CHECK(MakeDrawKey(DrawPass::Opaque, 1, 0x10000 | 5, 1, 0.5f) == MakeDrawKey(DrawPass::Opaque, 1, 5, 1, 0.5f));
+}
+
+// Renderables sharing pipeline, material and mesh become one instanced draw
+static void TestInstancing()
+{
+    std::vector<uint8_t> memory(64 * sizeof(DrawInstanceData));
+    InstanceRing ring;
+    ring.Initialize(memory.data(), memory.size(), 1);
+    ring.BeginFrame(0);
+
+    // 3 materials x 2 meshes x 4 copies, shuffled
+    std::vector<Renderable> renderables;
+    for (uint32_t material = 0; material < 3; ++material)
+        for (uint32_t mesh = 0; mesh < 2; ++mesh)
+            for (uint32_t copy = 0; copy < 4; ++copy)
+                renderables.push_back(MakeRenderable(DrawPass::Opaque, 0, material, mesh, 0.2f * float(copy + 1)));
+    std::shuffle(renderables.begin(), renderables.end(), std::mt19937(5));
+
+    DrawListBuilder builder;
+    builder.Begin();
+    for (const Renderable& renderable : renderables)
+        builder.Add(renderable);
+    builder.Build(ring);
+
+    const DrawListStats& stats = builder.GetStats();
+    CHECK(stats.renderables == 24 && stats.drawCalls == 6 && stats.droppedRenderables == 0);
+    CHECK(stats.pipelineChanges == 1 && stats.materialChanges == 3 && stats.meshChanges == 6);
+    CHECK(stats.GetDrawCallReduction() == 0.75f);
+
+    const DrawInstanceData* instances = reinterpret_cast<const DrawInstanceData*>(memory.data());
+    uint32_t nextInstance = 0;
+    for (uint32_t d = 0; d < 6; ++d) {
+        const InstancedDraw& draw = builder.GetDraws()[d];
+        CHECK(draw.material == d / 2 && draw.mesh == d % 2 && draw.instanceCount == 4);
+        CHECK(draw.firstInstance == nextInstance);
+        // Instances of a draw front to back
+        for (uint32_t j = 0; j < 4; ++j)
+            CHECK(instances[draw.firstInstance + j].world[3] == 0.2f * float(j + 1));
+        nextInstance += draw.instanceCount;
+    }
+
+    const DrawMesh meshes[2] = { { 36, 0, 0 }, { 6, 36, 24 } };
+    std::vector<SceneDraw> sceneDraws;
+    builder.ToSceneDraws(meshes, 2, sceneDraws);
+    CHECK(sceneDraws.size() == 6);
+    CHECK(sceneDraws[1].indexCount == 6 && sceneDraws[1].firstIndex == 36 && sceneDraws[1].baseVertex == 24);
+    CHECK(sceneDraws[1].materialIndex == 0 && sceneDraws[1].instanceCount == 4 && sceneDraws[1].firstInstance == 4);
+}
+
+// Transparent draws only merge when nothing sorts between them
+static void TestTransparentOrder()
+{
+    std::vector<uint8_t> memory(16 * sizeof(DrawInstanceData));
+    InstanceRing ring;
+    ring.Initialize(memory.data(), memory.size(), 1);
+    ring.BeginFrame(0);
+
+    DrawListBuilder builder;
+    builder.Begin();
+    builder.Add(MakeRenderable(DrawPass::Transparent, 0, 0, 0, 0.1f));
+    builder.Add(MakeRenderable(DrawPass::Opaque, 0, 7, 0, 0.5f));
+    builder.Add(MakeRenderable(DrawPass::Transparent, 0, 1, 0, 0.5f));
+    builder.Add(MakeRenderable(DrawPass::Transparent, 0, 0, 0, 0.9f));
+    builder.Add(MakeRenderable(DrawPass::Transparent, 0, 0, 0, 0.8f));
+    builder.Build(ring);
+
+    // Opaque first; then 0.9 and 0.8 merge, 0.5 splits them from 0.1
+    const std::vector<InstancedDraw>& draws = builder.GetDraws();
+    CHECK(draws.size() == 4);
+    CHECK(draws[0].pass == DrawPass::Opaque && draws[0].material == 7);
+    CHECK(draws[1].pass == DrawPass::Transparent && draws[1].material == 0 && draws[1].instanceCount == 2);
+    CHECK(draws[2].material == 1 && draws[3].material == 0 && draws[3].instanceCount == 1);
+
+    const DrawInstanceData* instances = reinterpret_cast<const DrawInstanceData*>(memory.data());
+    CHECK(instances[draws[1].firstInstance].world[3] == 0.9f && instances[draws[1].firstInstance + 1].world[3] == 0.8f);
+    CHECK(instances[draws[3].firstInstance].world[3] == 0.1f);
+}
+
+// A full ring cuts the run that doesn't fit and drops the rest in sort order
+static void TestRingOverflow()
+{
+    const uint32_t perFrame = 5;
+    std::vector<uint8_t> memory(2 * perFrame * sizeof(DrawInstanceData));
+    InstanceRing ring;
+    ring.Initialize(memory.data(), perFrame * sizeof(DrawInstanceData), 2);
+
+    DrawListBuilder builder;
+    builder.Begin();
+    for (uint32_t i = 0; i < 3; ++i)
+        builder.Add(MakeRenderable(DrawPass::Opaque, 0, 0, 0, 0.1f * float(i + 1)));
+    for (uint32_t i = 0; i < 4; ++i)
+        builder.Add(MakeRenderable(DrawPass::Opaque, 0, 1, 0, 0.1f * float(i + 1)));
+    builder.Add(MakeRenderable(DrawPass::Opaque, 0, 2, 0, 0.5f));
+
+    // The second frame's window: instances are numbered from the ring's start
+    ring.BeginFrame(1);
+    builder.Build(ring);
+    const std::vector<InstancedDraw>& draws = builder.GetDraws();
+    CHECK(draws.size() == 2);
+    CHECK(draws[0].material == 0 && draws[0].instanceCount == 3 && draws[0].firstInstance == perFrame);
+    CHECK(draws[1].material == 1 && draws[1].instanceCount == 2 && draws[1].firstInstance == perFrame + 3);
+    CHECK(builder.GetStats().droppedRenderables == 3 && builder.GetStats().drawCalls == 2);
+    CHECK(ring.GetRemainingBytes() == 0);
+
+    // The nearest of the cut run are kept
+    const DrawInstanceData* instances = reinterpret_cast<const DrawInstanceData*>(memory.data());
+    CHECK(instances[perFrame + 3].world[3] == 0.1f && instances[perFrame + 4].world[3] == 0.2f);
+
+    // The next time round the window is empty again
+    ring.BeginFrame(1);
+    CHECK(ring.GetRemainingBytes() == perFrame * sizeof(DrawInstanceData));
+    builder.Begin();
+    builder.Build(ring);
+    CHECK(builder.GetDraws().empty() && builder.GetStats().drawCalls == 0);
+}
+
+int main()
+{
+    TestKeyOrder();
+    TestInstancing();
+    TestTransparentOrder();
+    TestRingOverflow();
+    std::printf("DrawListTest passed\n");
+    return 0;
+}
@@ -0,0 +1,174 @@
+#include "TestSupport.h"
+#include "../Rendering/DynamicResolution.h"
+#include <cmath>
+#include <deque>
+#include <functional>
+
+static bool Near(float value, float expected)
+{
+    return std::fabs(value - expected) < 1e-4f;
+}
+
+// A scene whose GPU cost follows the pixel count. Timings arrive two frames
+// late, as the renderer reads a frame's timestamps once its slot has retired.
+struct SceneSimulation {
+    DynamicResolutionController controller;
+    std::deque<float> inFlight;
+    float lastCostMs = 0.0f;
+
+    SceneSimulation() { controller.Initialize(DynamicResolutionSettings()); }
+
+    // 'fullScaleMs(frame)' is the cost at scale 1. Returns how many times the scale changed.
+    uint32_t Run(uint32_t frames, const std::function<float(uint32_t)>& fullScaleMs)
+    {
+        uint32_t changes = 0;
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            inFlight.push_back(controller.GetScale());
+            if (inFlight.size() > 3)
+                inFlight.pop_front();
+            const float scale = inFlight.front();
+            lastCostMs = fullScaleMs(frame) * scale * scale;
+            changes += controller.Update(lastCostMs) ? 1 : 0;
+        }
+        return changes;
+    }
+};
+
+// Costs between the thresholds never move the scale; either side does, after minSamples
+static void TestHysteresisBand()
+{
+    DynamicResolutionController controller;
+    controller.Initialize(DynamicResolutionSettings());
+    for (int i = 0; i < 200; ++i)
+        CHECK(!controller.Update(15.9f));
+    CHECK(!controller.Update(0.0f) && !controller.Update(-1.0f));
+    CHECK(controller.GetScale() == 1.0f && controller.GetStats().samples == 200);
+
+    controller.Reset();
+    for (int i = 0; i < 3; ++i)
+        CHECK(!controller.Update(16.1f));
+    CHECK(controller.Update(16.1f));
+    CHECK(Near(controller.GetScale(), 0.9f) && controller.GetStats().decreases == 1);
+
+    // Past the settle frames, 12.9ms at 0.9 sits inside the band
+    for (int i = 0; i < 8; ++i)
+        CHECK(!controller.Update(12.9f));
+    for (int i = 0; i < 200; ++i)
+        CHECK(!controller.Update(12.9f));
+    // Smoothed, so one 12ms frame only just pulls the average under it
+    CHECK(controller.Update(12.0f));
+    CHECK(Near(controller.GetScale(), 0.95f) && controller.GetStats().increases == 1);
+}
+
+// After a change, settleFrames samples are ignored however bad, then minSamples are averaged
+static void TestSettleFrames()
+{
+    DynamicResolutionController controller;
+    controller.Initialize(DynamicResolutionSettings());
+    for (int i = 0; i < 4; ++i)
+        controller.Update(17.0f);
+    CHECK(controller.GetScale() < 1.0f);
+    const float scale = controller.GetScale();
+    const float smoothed = controller.GetStats().smoothedFrameMs;
+
+    for (int i = 0; i < 8; ++i)
+        CHECK(!controller.Update(100.0f));
+    CHECK(controller.GetScale() == scale && controller.GetStats().smoothedFrameMs == smoothed);
+    for (int i = 0; i < 3; ++i)
+        CHECK(!controller.Update(100.0f));
+    CHECK(controller.Update(100.0f));
+    CHECK(controller.GetStats().decreases == 2);
+
+    // The first sample after a change doesn't decide alone: one high and three low average into the band
+    controller.Reset();
+    CHECK(controller.GetScale() == 1.0f && controller.GetStats().samples == 0);
+    for (float sample : { 20.0f, 12.9f, 12.9f, 12.9f })
+        CHECK(!controller.Update(sample));
+    CHECK(controller.GetStats().smoothedFrameMs < 16.0f);
+}
+
+// Increases take at most two steps at a time; the scale never leaves [minScale, maxScale]
+static void TestClampAndIncreaseCap()
+{
+    DynamicResolutionController controller;
+    controller.Initialize(DynamicResolutionSettings());
+    for (int i = 0; i < 100; ++i)
+        controller.Update(100.0f);
+    CHECK(controller.GetScale() == 0.5f && controller.GetStats().decreases == 1);
+
+    // However much headroom there is, no increase is bigger than two steps
+    float previous = controller.GetScale();
+    for (int i = 0; i < 200; ++i) {
+        if (controller.Update(1.0f)) {
+            CHECK(controller.GetScale() > previous && controller.GetScale() <= previous + 0.1f + 1e-4f);
+            previous = controller.GetScale();
+        }
+    }
+    CHECK(controller.GetScale() == 1.0f && controller.GetStats().increases >= 5);
+
+    DynamicResolutionSettings narrow;
+    narrow.minScale = 0.7f;
+    narrow.maxScale = 0.9f;
+    controller.Initialize(narrow);
+    CHECK(controller.GetScale() == 0.9f);
+    for (int i = 0; i < 100; ++i) {
+        controller.Update(100.0f);
+        CHECK(controller.GetScale() >= 0.7f);
+    }
+    CHECK(controller.GetScale() == 0.7f && controller.GetStats().decreases == 1);
+    for (int i = 0; i < 200; ++i) {
+        controller.Update(1.0f);
+        CHECK(controller.GetScale() <= 0.9f);
+    }
+    CHECK(controller.GetScale() == 0.9f);
+}
+
+// A heavier scene: the scale drops within a few decisions, lands under budget and stays there
+static void TestStepTrace()
+{
+    SceneSimulation scene;
+    CHECK(scene.Run(200, [](uint32_t) { return 10.0f; }) == 0);
+    CHECK(scene.controller.GetScale() == 1.0f);
+
+    CHECK(scene.Run(40, [](uint32_t) { return 30.0f; }) <= 3);
+    CHECK(scene.controller.GetScale() < 0.75f && scene.lastCostMs <= 16.0f);
+    CHECK(scene.Run(300, [](uint32_t) { return 30.0f; }) == 0);
+
+    // And back up once the load goes away
+    scene.Run(200, [](uint32_t) { return 10.0f; });
+    CHECK(scene.controller.GetScale() == 1.0f);
+}
+
+// A hitch within the band is absorbed; a single huge one costs one drop, then a full recovery
+static void TestSpikeTrace()
+{
+    SceneSimulation scene;
+    CHECK(scene.Run(100, [](uint32_t frame) { return frame == 50 || frame == 51 ? 20.0f : 12.0f; }) == 0);
+
+    CHECK(scene.Run(100, [](uint32_t frame) { return frame == 50 ? 60.0f : 12.0f; }) >= 1);
+    CHECK(scene.controller.GetStats().decreases == 1);
+    CHECK(scene.controller.GetScale() == 1.0f);
+}
+
+// Frame-to-frame noise around the budget settles on one scale instead of cycling
+static void TestOscillatingTrace()
+{
+    SceneSimulation scene;
+    CHECK(scene.Run(60, [](uint32_t frame) { return frame % 2 ? 12.0f : 20.0f; }) <= 2);
+    const float scale = scene.controller.GetScale();
+    CHECK(scene.Run(1000, [](uint32_t frame) { return frame % 2 ? 12.0f : 20.0f; }) == 0);
+    const float meanCostMs = 16.0f * scale * scale;
+    CHECK(meanCostMs >= 12.8f && meanCostMs <= 16.0f);
+}
+
+int main()
+{
+    TestHysteresisBand();
+    TestSettleFrames();
+    TestClampAndIncreaseCap();
+    TestStepTrace();
+    TestSpikeTrace();
+    TestOscillatingTrace();
+    std::printf("DynamicResolutionTest passed\n");
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "TestSupport.h"
+#include "../Rendering/FrameLifecycle.h"
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+// Records every fence the CPU blocks on; each wait takes 2ms on the manual clock
+class RecordingTimeline : public SimulatedGpuTimeline {
+public:
+    explicit RecordingTimeline(ManualFrameClock& clock) : clock(clock) {}
+
+    void CpuWait(SyncPoint point) override
+    {
+        waitedValues.push_back(point.value);
+        clock.Advance(2000);
+        SimulatedGpuTimeline::CpuWait(point);
+    }
+
+    std::vector<uint64_t> waitedValues;
+
+private:
+    ManualFrameClock& clock;
+};
+
+struct LifecycleRig {
+    ManualFrameClock clock;
+    RecordingTimeline timeline;
+    QueueScheduler scheduler;
+    FrameLifecycle lifecycle;
+
+    explicit LifecycleRig(uint32_t slotCount) : timeline(clock)
+    {
+        scheduler.Initialize(&timeline);
+        lifecycle.Initialize(&scheduler, &clock, slotCount);
+    }
+
+    // Ends the open frame with one graphics submission; the GPU doesn't run it yet
+    SyncPoint EndFrame()
+    {
+        const SyncPoint done = scheduler.Submit(QueueType::Graphics);
+        lifecycle.EndFrame(done);
+        return done;
+    }
+};
+
+// Frame N reuses the slot of frame N - slotCount and waits for that frame's fence, no later one
+static void TestSlotReuse()
+{
+    LifecycleRig rig(3);
+    for (uint64_t frame = 1; frame <= 3; ++frame) {
+        CHECK(rig.lifecycle.BeginFrame() == frame % 3);
+        CHECK(rig.lifecycle.GetFrameNumber() == frame);
+        rig.EndFrame();
+    }
+    CHECK(rig.timeline.waitedValues.empty() && rig.lifecycle.GetStats().blockedFrames == 0);
+    CHECK(rig.lifecycle.GetSlotFenceValue(1) == 1 && rig.lifecycle.GetSlotFenceValue(0) == 3);
+
+    // The GPU has run nothing: frame 4 waits for frame 1 and frame 1 only
+    CHECK(rig.lifecycle.BeginFrame() == 1);
+    CHECK(rig.timeline.waitedValues.size() == 1 && rig.timeline.waitedValues[0] == 1);
+    CHECK(rig.timeline.GetCompletedValue(QueueType::Graphics) == 1);
+    CHECK(rig.lifecycle.GetStats().lastWaitMs == 2.0f && rig.lifecycle.GetStats().blockedFrames == 1);
+    rig.EndFrame();
+    CHECK(rig.lifecycle.GetSlotFenceValue(1) == 4);
+
+    CHECK(rig.lifecycle.BeginFrame() == 2);
+    CHECK(rig.timeline.waitedValues.back() == 2 && rig.timeline.GetCompletedValue(QueueType::Graphics) == 2);
+    rig.EndFrame();
+
+    // Once the GPU has caught up nothing blocks
+    rig.timeline.RunUntilIdle();
+    CHECK(rig.lifecycle.BeginFrame() == 0);
+    CHECK(rig.timeline.waitedValues.size() == 2);
+    const FrameLifecycleStats& stats = rig.lifecycle.GetStats();
+    CHECK(stats.lastWaitMs == 0.0f && stats.maxWaitMs == 2.0f && stats.blockedFrames == 2);
+    CHECK(std::fabs(stats.averageWaitMs - 4.0f / 6.0f) < 1e-5f);
+    rig.EndFrame();
+}
+
+// A release runs at the BeginFrame that retires the frame it was queued in,
+// never earlier, even if the GPU is already done with that frame
+static void TestDeferredRelease()
+{
+    LifecycleRig rig(2);
+    std::map<std::string, uint64_t> ranAt;
+    auto release = [&](std::string name, uint64_t fence) {
+        return [&, name, fence] {
+            CHECK(rig.scheduler.IsComplete({ QueueType::Graphics, fence }));
+            CHECK(ranAt.emplace(name, rig.lifecycle.GetFrameNumber()).second);
+        };
+    };
+
+    rig.lifecycle.BeginFrame();
+    rig.lifecycle.DeferRelease(release("during1", 1));
+    rig.EndFrame();
+    // Between frames: the last ended frame may still reference it
+    rig.lifecycle.DeferRelease(release("after1", 1));
+
+    rig.timeline.RunUntilIdle();
+    rig.lifecycle.BeginFrame();
+    CHECK(ranAt.empty());
+    rig.lifecycle.DeferRelease([&] {
+        // Queued by a release: belongs to the frame that ran it
+        rig.lifecycle.DeferRelease(release("nested", 4));
+        ranAt.emplace("during2", rig.lifecycle.GetFrameNumber());
+    });
+    rig.EndFrame();
+    rig.lifecycle.DeferRelease(release("after2", 2));
+    CHECK(rig.lifecycle.GetPendingReleaseCount() == 4);
+
+    rig.lifecycle.BeginFrame();
+    CHECK(ranAt.size() == 2 && ranAt["during1"] == 3 && ranAt["after1"] == 3);
+    rig.EndFrame();
+
+    rig.lifecycle.BeginFrame();
+    CHECK(ranAt.size() == 4 && ranAt["during2"] == 4 && ranAt["after2"] == 4);
+    CHECK(rig.lifecycle.GetPendingReleaseCount() == 1);
+    rig.EndFrame();
+
+    // Queued while frame 4 reclaimed its slot, so it waits for frame 4 to retire at frame 6
+    rig.lifecycle.BeginFrame();
+    CHECK(ranAt.size() == 4);
+    rig.EndFrame();
+    rig.lifecycle.BeginFrame();
+    CHECK(ranAt.size() == 5 && ranAt["nested"] == 6);
+    CHECK(rig.lifecycle.GetPendingReleaseCount() == 0);
+    CHECK(rig.lifecycle.GetStats().releasesQueued == 5 && rig.lifecycle.GetStats().releasesRun == 5);
+    rig.EndFrame();
+}
+
+// Shutdown waits for every submitted frame and runs every release, including
+// ones queued by releases into slots it has already been through
+static void TestShutdown()
+{
+    LifecycleRig rig(3);
+    uint32_t ran = 0;
+    SyncPoint last;
+    for (int frame = 0; frame < 3; ++frame) {
+        rig.lifecycle.BeginFrame();
+        rig.lifecycle.DeferRelease([&] { ++ran; });
+        last = rig.EndFrame();
+    }
+    // Frame 3 recorded into slot 0, which Shutdown runs first
+    CHECK(rig.lifecycle.GetFrameSlot() == 0);
+    rig.lifecycle.DeferRelease([&] {
+        ++ran;
+        rig.lifecycle.DeferRelease([&] {
+            ++ran;
+            rig.lifecycle.DeferRelease([&] { ++ran; });
+        });
+    });
+    CHECK(rig.lifecycle.GetPendingReleaseCount() == 4);
+
+    rig.lifecycle.Shutdown();
+    CHECK(rig.scheduler.IsComplete(last) && rig.timeline.GetPendingCount(QueueType::Graphics) == 0);
+    CHECK(ran == 6 && rig.lifecycle.GetPendingReleaseCount() == 0);
+    CHECK(rig.lifecycle.GetStats().releasesQueued == rig.lifecycle.GetStats().releasesRun);
+}
+
+int main()
+{
+    TestSlotReuse();
+    TestDeferredRelease();
+    TestShutdown();
+    std::printf("FrameLifecycleTest passed\n");
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include "TestSupport.h"
+#include "../Rendering/FramePacer.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// A graphics queue that takes 'gpuUs' per frame on the manual clock. Frames run
+// one after another, each starting once submitted and once the previous is done.
+// CPU waits move the clock to when the awaited frame finishes.
+class PacedTimeline : public SimulatedGpuTimeline {
+public:
+    PacedTimeline(ManualFrameClock& clock, uint64_t gpuUs) : clock(clock), gpuUs(gpuUs) {}
+
+    SyncPoint Signal(QueueType queue) override
+    {
+        const SyncPoint point = SimulatedGpuTimeline::Signal(queue);
+        if (queue == QueueType::Graphics) {
+            const uint64_t start = std::max(clock.NowMicroseconds(), finishTimes.empty() ? 0 : finishTimes.back());
+            finishTimes.push_back(start + gpuUs);
+        }
+        return point;
+    }
+    void CpuWait(SyncPoint point) override
+    {
+        waitedValues.push_back(point.value);
+        const uint64_t finish = finishTimes[point.value - 1];
+        if (finish > clock.NowMicroseconds())
+            clock.Advance(finish - clock.NowMicroseconds());
+        CatchUp();
+    }
+    // Completes every frame that has finished by now
+    void CatchUp()
+    {
+        while (GetCompletedValue(QueueType::Graphics) < finishTimes.size() &&
+            finishTimes[GetCompletedValue(QueueType::Graphics)] <= clock.NowMicroseconds())
+            CHECK(Step(QueueType::Graphics));
+    }
+
+    std::vector<uint64_t> waitedValues;
+
+private:
+    ManualFrameClock& clock;
+    uint64_t gpuUs;
+    std::vector<uint64_t> finishTimes;  // by fence value - 1
+};
+
+// Stands in for the swap chain's latency waitable
+class FakeLatencyWaiter : public IPresentLatencyWaiter {
+public:
+    explicit FakeLatencyWaiter(ManualFrameClock& clock) : clock(clock) {}
+
+    void SetMaximumLatency(uint32_t frames) override { maximumLatency = frames; }
+    bool Wait(uint32_t) override
+    {
+        ++waits;
+        clock.Advance(blockUs);
+        return !timeOut;
+    }
+
+    uint32_t maximumLatency = 0;
+    uint32_t waits = 0;
+    uint64_t blockUs = 0;
+    bool timeOut = false;
+
+private:
+    ManualFrameClock& clock;
+};
+
+struct PacerRig {
+    ManualFrameClock clock;
+    PacedTimeline timeline;
+    QueueScheduler scheduler;
+    FakeLatencyWaiter waiter;
+    FramePacer pacer;
+
+    PacerRig(uint64_t gpuUs, LatencyMode mode, bool tearingSupported = false) : timeline(clock, gpuUs), waiter(clock)
+    {
+        scheduler.Initialize(&timeline);
+        pacer.Initialize(&scheduler, &clock, &waiter, 3, tearingSupported, mode);
+    }
+
+    // One frame: pace, 'cpuUs' of work, submit, present
+    void RunFrame(uint64_t cpuUs)
+    {
+        timeline.CatchUp();
+        pacer.BeginFrame();
+        clock.Advance(cpuUs);
+        pacer.EndFrame(scheduler.Submit(QueueType::Graphics));
+    }
+};
+
+static bool Near(float value, float expected)
+{
+    return std::fabs(value - expected) < 0.05f;
+}
+
+static void TestModeSettings()
+{
+    LatencyModeSettings low = GetLatencyModeSettings(LatencyMode::LowLatency, 3, true);
+    CHECK(low.maxFramesInFlight == 1 && low.syncInterval == 1 && !low.allowTearing);
+    LatencyModeSettings throughput = GetLatencyModeSettings(LatencyMode::Throughput, 3, true);
+    CHECK(throughput.maxFramesInFlight == 3 && throughput.syncInterval == 1 && !throughput.allowTearing);
+    LatencyModeSettings uncapped = GetLatencyModeSettings(LatencyMode::Uncapped, 3, true);
+    CHECK(uncapped.maxFramesInFlight == 3 && uncapped.syncInterval == 0 && uncapped.allowTearing);
+    CHECK(!GetLatencyModeSettings(LatencyMode::Uncapped, 3, false).allowTearing);
+}
+
+// GPU bound, low latency: every frame waits for the one before, so input is
+// never more than one GPU frame old when the frame completes
+static void TestLowLatency()
+{
+    PacerRig rig(10000, LatencyMode::LowLatency);
+    CHECK(rig.waiter.maximumLatency == 1);
+    for (int frame = 0; frame < 60; ++frame) {
+        rig.RunFrame(4000);
+        const FramePacingStats& stats = rig.pacer.GetStats();
+        CHECK(stats.inputToPresentMs == 4.0f);
+        if (frame == 0)
+            continue;
+        // Waited for exactly the previous frame's fence, for the whole of its GPU time
+        CHECK(rig.timeline.waitedValues.back() == uint64_t(frame));
+        CHECK(stats.waitMs == 10.0f && stats.framesInFlight == 0);
+        CHECK(stats.inputToCompleteMs == 14.0f);
+    }
+    CHECK(rig.timeline.waitedValues.size() == 59);
+    const FramePacingStats& stats = rig.pacer.GetStats();
+    CHECK(Near(stats.averageInputToPresentMs, 4.0f) && Near(stats.averageInputToCompleteMs, 14.0f));
+    CHECK(rig.waiter.waits == 60 && stats.waitTimeouts == 0);
+}
+
+// GPU bound, throughput: three frames queue up, the CPU waits only for the one
+// falling out of the cap, and latency grows to three GPU frames
+static void TestThroughput()
+{
+    PacerRig rig(10000, LatencyMode::Throughput);
+    CHECK(rig.waiter.maximumLatency == 3);
+    for (int frame = 0; frame < 100; ++frame) {
+        rig.RunFrame(4000);
+        const FramePacingStats& stats = rig.pacer.GetStats();
+        if (frame < 3) {
+            CHECK(rig.timeline.waitedValues.empty() && stats.waitMs == 0.0f);
+            continue;
+        }
+        // Frame N waits for frame N - 3; two are still in flight behind it
+        CHECK(rig.timeline.waitedValues.back() == uint64_t(frame - 2));
+        CHECK(stats.framesInFlight == 2);
+        if (frame >= 4)
+            CHECK(stats.waitMs == 6.0f);
+        if (frame >= 6)
+            CHECK(stats.inputToCompleteMs == 30.0f);
+    }
+    const FramePacingStats& stats = rig.pacer.GetStats();
+    CHECK(Near(stats.averageInputToCompleteMs, 30.0f) && Near(stats.averageInputToPresentMs, 4.0f));
+}
+
+// CPU bound: with room for more than one frame the GPU is always done in time,
+// so the fence is never waited on
+static void TestCpuBound()
+{
+    for (LatencyMode mode : { LatencyMode::Throughput, LatencyMode::Uncapped }) {
+        PacerRig rig(4000, mode);
+        for (int frame = 0; frame < 20; ++frame)
+            rig.RunFrame(10000);
+        const FramePacingStats& stats = rig.pacer.GetStats();
+        CHECK(rig.timeline.waitedValues.empty());
+        CHECK(stats.waitMs == 0.0f && stats.framesInFlight == 1);
+        // Finished 14ms in, but only seen at the start of the frame after next
+        CHECK(stats.inputToCompleteMs == 20.0f);
+    }
+}
+
+// Uncapped presents without vsync and tears only where supported; switching
+// modes takes effect at the next BeginFrame and reaches the swap chain
+static void TestUncappedAndSwitching()
+{
+    PacerRig rig(10000, LatencyMode::Uncapped, true);
+    CHECK(rig.pacer.GetPresentParams().syncInterval == 0 && rig.pacer.GetPresentParams().allowTearing);
+    for (int frame = 0; frame < 10; ++frame)
+        rig.RunFrame(4000);
+    CHECK(rig.pacer.GetStats().framesInFlight == 2);
+
+    rig.pacer.SetMode(LatencyMode::LowLatency);
+    CHECK(rig.pacer.GetMode() == LatencyMode::Uncapped && rig.waiter.maximumLatency == 3);
+    const size_t waitsBefore = rig.timeline.waitedValues.size();
+    rig.RunFrame(4000);
+    CHECK(rig.pacer.GetMode() == LatencyMode::LowLatency && rig.waiter.maximumLatency == 1);
+    CHECK(rig.pacer.GetPresentParams().syncInterval == 1 && !rig.pacer.GetPresentParams().allowTearing);
+    // The first low latency frame drains the queue down to nothing in flight
+    CHECK(rig.timeline.waitedValues.size() == waitsBefore + 1 && rig.timeline.waitedValues.back() == 10);
+    CHECK(rig.pacer.GetStats().framesInFlight == 0);
+}
+
+// Time blocked on the swap chain counts as waiting, and a timeout is counted but doesn't stall
+static void TestPresentWaits()
+{
+    PacerRig rig(4000, LatencyMode::Throughput);
+    rig.waiter.blockUs = 2000;
+    rig.RunFrame(10000);
+    CHECK(rig.pacer.GetStats().waitMs == 2.0f);
+    rig.waiter.timeOut = true;
+    rig.RunFrame(10000);
+    rig.RunFrame(10000);
+    CHECK(rig.pacer.GetStats().waitTimeouts == 2 && rig.pacer.GetStats().frameNumber == 3);
+}
+
+int main()
+{
+    TestModeSettings();
+    TestLowLatency();
+    TestThroughput();
+    TestCpuBound();
+    TestUncappedAndSwitching();
+    TestPresentWaits();
+    std::printf("FramePacerTest passed\n");
+    return 0;
+}
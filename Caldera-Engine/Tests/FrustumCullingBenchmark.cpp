@@ -0,0 +1,60 @@
+#include "TestSupport.h"
+#include "../Core/TaskPool.h"
+#include "../Rendering/FrustumCulling.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+static const char* const PATH_NAMES[] = { "scalar", "sse", "avx2" };
+
+int main(int argc, char** argv)
+{
+    const uint32_t count = IsQuickRun(argc, argv) ? 20000 : 1000000;
+    const int repeats = IsQuickRun(argc, argv) ? 2 : 10;
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.1f, 5.0f);
+    CullingBounds bounds;
+    bounds.Reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const float center[3] = { position(rng), position(rng), position(rng) };
+        const float extents[3] = { size(rng), size(rng), size(rng) };
+        bounds.Add(center, extents, std::sqrt(extents[0] * extents[0] + extents[1] * extents[1] + extents[2] * extents[2]));
+    }
+
+    // Camera at the origin looking down +z; the other views are shifted along x like shadow cascades
+    Frustum views[4];
+    for (int view = 0; view < 4; ++view) {
+        const float f = 1.0f / std::tan(0.5f + 0.1f * view);
+        const float zNear = 0.1f;
+        const float zFar = 300.0f + 100.0f * view;
+        float m[16] = {};
+        m[0] = f / 1.7f;
+        m[3] = -50.0f * view * f / 1.7f;
+        m[5] = f;
+        m[10] = zFar / (zFar - zNear);
+        m[11] = -zNear * zFar / (zFar - zNear);
+        m[14] = 1.0f;
+        views[view] = MakeFrustum(m);
+    }
+
+    TaskPool pool;
+    pool.Initialize();
+    std::vector<uint32_t> visible(count);
+    const double referenceMs = MeasureBestMs(repeats, [&] { CullFrustumReference(bounds, views[0], visible.data()); });
+    std::printf("%u objects, %u threads\nreference: %.2f ms per view\n", count, pool.GetThreadCount(), referenceMs);
+
+    for (int path = 0; path <= static_cast<int>(FrustumCuller::GetBestPath()); ++path) {
+        for (TaskPool* culling : { static_cast<TaskPool*>(nullptr), &pool }) {
+            FrustumCuller culler;
+            culler.Initialize(culling);
+            culler.SetPath(static_cast<CullPath>(path));
+            const double oneView = MeasureBestMs(repeats, [&] { culler.Cull(bounds, views, 1); });
+            const double fourViews = MeasureBestMs(repeats, [&] { culler.Cull(bounds, views, 4); });
+            std::printf("%-6s %-7s 1 view %.2f ms (%.1f Mobjects/s), 4 views %.2f ms\n", PATH_NAMES[path],
+                culling ? "pool" : "serial", oneView, count / oneView / 1000.0, fourViews);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "TestSupport.h"
+#include "../Core/TaskPool.h"
+#include "../Rendering/FrustumCulling.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Row-major perspective looking down +z from (x, 0, 0), clip = m * float4(p, 1)
+static void MakePerspective(float m[16], float fovY, float aspect, float zNear, float zFar, float x)
+{
+    const float f = 1.0f / std::tan(fovY * 0.5f);
+    for (int i = 0; i < 16; ++i)
+        m[i] = 0.0f;
+    m[0] = f / aspect;
+    m[3] = -x * f / aspect;
+    m[5] = f;
+    m[10] = zFar / (zFar - zNear);
+    m[11] = -zNear * zFar / (zFar - zNear);
+    m[14] = 1.0f;
+}
+
+// Boxes scattered around the views, with spheres that are sometimes tighter than the box
+static void FillBounds(CullingBounds& bounds, uint32_t count, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> position(-400.0f, 400.0f);
+    std::uniform_real_distribution<float> size(0.1f, 20.0f);
+    bounds.Clear();
+    bounds.Reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const float center[3] = { position(rng), position(rng), position(rng) };
+        const float extents[3] = { size(rng), size(rng), size(rng) };
+        const float radius = std::sqrt(extents[0] * extents[0] + extents[1] * extents[1] + extents[2] * extents[2]);
+        bounds.Add(center, extents, (rng() & 1) ? radius : radius * 0.6f);
+    }
+}
+
+static void CheckMatchesReference(FrustumCuller& culler, const CullingBounds& bounds, const Frustum* views, uint32_t viewCount)
+{
+    std::vector<uint32_t> expected(bounds.GetCount());
+    uint32_t total = 0;
+    for (uint32_t view = 0; view < viewCount; ++view)
+        total += CullFrustumReference(bounds, views[view], expected.data());
+    CHECK(culler.Cull(bounds, views, viewCount) == total);
+
+    for (uint32_t view = 0; view < viewCount; ++view) {
+        const uint32_t count = CullFrustumReference(bounds, views[view], expected.data());
+        CHECK(culler.GetVisibleCount(view) == count);
+        for (uint32_t i = 0; i < count; ++i)
+            CHECK(culler.GetVisible(view)[i] == expected[i]);
+    }
+}
+
+int main()
+{
+    TaskPool pool;
+    pool.Initialize(3);
+
+    Frustum views[FrustumCuller::MAX_VIEWS];
+    for (uint32_t view = 0; view < FrustumCuller::MAX_VIEWS; ++view) {
+        float viewProjection[16];
+        MakePerspective(viewProjection, 0.8f + 0.1f * view, 1.7f, 0.1f, 200.0f + 50.0f * view, 30.0f * view);
+        views[view] = MakeFrustum(viewProjection);
+    }
+
+    // Counts off the 4- and 8-wide batches and the task size, so every tail runs
+    const uint32_t counts[] = { 0, 1, 7, 13, 1000, FrustumCuller::OBJECTS_PER_TASK * 3 + 5 };
+    const CullPath best = FrustumCuller::GetBestPath();
+    CullingBounds bounds;
+    for (uint32_t count : counts) {
+        FillBounds(bounds, count, count + 1);
+        for (int path = 0; path <= static_cast<int>(best); ++path) {
+            for (TaskPool* culling : { static_cast<TaskPool*>(nullptr), &pool }) {
+                FrustumCuller culler;
+                culler.Initialize(culling);
+                culler.SetPath(static_cast<CullPath>(path));
+                CHECK(culler.GetPath() == static_cast<CullPath>(path));
+                CheckMatchesReference(culler, bounds, views, 1);
+                CheckMatchesReference(culler, bounds, views, FrustumCuller::MAX_VIEWS);
+            }
+        }
+    }
+
+    // Edits through Set and RemoveSwap keep the paths in step with the reference
+    FillBounds(bounds, 5000, 99);
+    const float center[3] = { 30.0f, 0.0f, 50.0f };
+    const float extents[3] = { 1.0f, 1.0f, 1.0f };
+    for (uint32_t i = 0; i < 5000; i += 7)
+        bounds.Set(i, center, extents, 1.7f);
+    for (uint32_t i = 0; i < 1000; ++i)
+        bounds.RemoveSwap(i * 3);
+    FrustumCuller culler;
+    culler.Initialize(&pool);
+    culler.SetPath(best);
+    CheckMatchesReference(culler, bounds, views, 4);
+
+    std::printf("FrustumCullingTest passed, paths up to %d checked\n", static_cast<int>(best));
+    return 0;
+}
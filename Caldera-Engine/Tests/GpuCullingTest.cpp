@@ -0,0 +1,213 @@
+#include "TestSupport.h"
+#include "../Core/TaskPool.h"
+#include "../Rendering/GpuCulling.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// GpuCull.hlsl line by line: one call per dispatch thread, appending through an
+// atomic counter. Kept apart from GpuCulling.cpp on purpose, so the reference
+// is checked against the shader's algorithm rather than against itself.
+struct ShaderEmulation {
+    const CullConstants& constants;
+    const HiZPyramid& hiz;
+    const GpuObjectData* objects;
+    IndirectDrawCommand* commands;
+    std::atomic<uint32_t>& drawCount;
+
+    bool InFrustum(const float center[3], float radius) const
+    {
+        for (uint32_t i = 0; i < 6; ++i) {
+            const float* plane = constants.planes[i];
+            if (plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] < -radius)
+                return false;
+        }
+        return true;
+    }
+
+    bool VisibleHiZ(const float center[3], float radius) const
+    {
+        float minUV[2] = { 1.0f, 1.0f }, maxUV[2] = { 0.0f, 0.0f };
+        float minZ = 1.0f;
+        for (uint32_t corner = 0; corner < 8; ++corner) {
+            const float p[3] = { center[0] + ((corner & 1) ? radius : -radius), center[1] + ((corner & 2) ? radius : -radius),
+                                 center[2] + ((corner & 4) ? radius : -radius) };
+            float clip[4];
+            for (int r = 0; r < 4; ++r) {
+                const float* row = constants.viewProjection + r * 4;
+                clip[r] = row[0] * p[0] + row[1] * p[1] + row[2] * p[2] + row[3];
+            }
+            if (clip[3] <= 0.0f)
+                return true;
+            const float uv[2] = { clip[0] / clip[3] * 0.5f + 0.5f, clip[1] / clip[3] * -0.5f + 0.5f };
+            for (int k = 0; k < 2; ++k) {
+                minUV[k] = std::min(minUV[k], uv[k]);
+                maxUV[k] = std::max(maxUV[k], uv[k]);
+            }
+            minZ = std::min(minZ, clip[2] / clip[3]);
+        }
+        for (int k = 0; k < 2; ++k) {
+            minUV[k] = std::clamp(minUV[k], 0.0f, 1.0f);
+            maxUV[k] = std::clamp(maxUV[k], 0.0f, 1.0f);
+        }
+
+        const float extent = std::max((maxUV[0] - minUV[0]) * constants.hizWidth, (maxUV[1] - minUV[1]) * constants.hizHeight);
+        int mip = extent > 1.0f ? static_cast<int>(std::ceil(std::log2(extent))) : 0;
+        mip = std::clamp(mip, 0, static_cast<int>(constants.hizMipCount) - 1);
+
+        const uint32_t mipSize[2] = { std::max(constants.hizWidth >> mip, 1u), std::max(constants.hizHeight >> mip, 1u) };
+        uint32_t texel0[2], texel1[2];
+        for (int k = 0; k < 2; ++k) {
+            texel0[k] = std::min(static_cast<uint32_t>(minUV[k] * mipSize[k]), mipSize[k] - 1);
+            texel1[k] = std::min(static_cast<uint32_t>(maxUV[k] * mipSize[k]), mipSize[k] - 1);
+        }
+        const float farthest = std::max(std::max(hiz.Load(texel0[0], texel0[1], mip), hiz.Load(texel1[0], texel0[1], mip)),
+                                        std::max(hiz.Load(texel0[0], texel1[1], mip), hiz.Load(texel1[0], texel1[1], mip)));
+        return minZ <= farthest;
+    }
+
+    void Run(uint32_t id) const
+    {
+        if (id >= constants.objectCount)
+            return;
+        const GpuObjectData& object = objects[id];
+        if (!InFrustum(object.center, object.radius))
+            return;
+        if (constants.hizIndex != CULL_NO_HIZ && !VisibleHiZ(object.center, object.radius))
+            return;
+
+        const uint32_t slot = drawCount.fetch_add(1);
+        IndirectDrawCommand& command = commands[slot];
+        command.materialIndex = object.materialIndex;
+        command.indexCountPerInstance = object.indexCount;
+        command.instanceCount = 1;
+        command.startIndexLocation = object.firstIndex;
+        command.baseVertexLocation = object.baseVertex;
+        command.startInstanceLocation = 0;
+    }
+};
+
+// Row-major perspective looking down +z from the origin, depth 0 at the near plane
+static void MakePerspective(float m[16], float fovY, float aspect, float zNear, float zFar)
+{
+    const float f = 1.0f / std::tan(fovY * 0.5f);
+    std::fill(m, m + 16, 0.0f);
+    m[0] = f / aspect;
+    m[5] = f;
+    m[10] = zFar / (zFar - zNear);
+    m[11] = -zNear * zFar / (zFar - zNear);
+    m[14] = 1.0f;
+}
+
+static bool CommandsEqual(const IndirectDrawCommand& a, const IndirectDrawCommand& b)
+{
+    return a.materialIndex == b.materialIndex && a.indexCountPerInstance == b.indexCountPerInstance &&
+        a.instanceCount == b.instanceCount && a.startIndexLocation == b.startIndexLocation &&
+        a.baseVertexLocation == b.baseVertexLocation && a.startInstanceLocation == b.startInstanceLocation;
+}
+
+static void RunCase(TaskPool& pool, uint32_t objectCount, bool useHiZ, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> lateral(-150.0f, 150.0f);
+    std::uniform_real_distribution<float> depth(-20.0f, 250.0f);
+    std::uniform_real_distribution<float> radius(0.05f, 12.0f);
+
+    // firstIndex is unique per object, so the compacted commands can be put back in object order
+    std::vector<GpuObjectData> objects(objectCount);
+    for (uint32_t i = 0; i < objectCount; ++i) {
+        GpuObjectData& object = objects[i];
+        object.center[0] = lateral(rng);
+        object.center[1] = lateral(rng);
+        object.center[2] = depth(rng);
+        object.radius = radius(rng);
+        object.indexCount = 3 + rng() % 3000;
+        object.firstIndex = i * 4;
+        object.baseVertex = static_cast<int32_t>(rng() % 1000) - 500;
+        object.materialIndex = rng() % 16;
+    }
+
+    float viewProjection[16];
+    MakePerspective(viewProjection, 1.0f, 16.0f / 9.0f, 0.5f, 200.0f);
+    CullConstants constants = MakeCullConstants(viewProjection, objectCount);
+
+    // Random occluders: most texels far, some blocks near
+    HiZPyramid hiz;
+    if (useHiZ) {
+        const uint32_t width = 157, height = 93;
+        std::vector<float> depthBuffer(size_t(width) * height, 1.0f);
+        std::uniform_real_distribution<float> nearDepth(0.2f, 0.99f);
+        for (int block = 0; block < 40; ++block) {
+            const uint32_t left = rng() % width, top = rng() % height;
+            const uint32_t right = std::min(width, left + 5 + static_cast<uint32_t>(rng() % 60));
+            const uint32_t bottom = std::min(height, top + 5 + static_cast<uint32_t>(rng() % 40));
+            const float z = nearDepth(rng);
+            for (uint32_t y = top; y < bottom; ++y)
+                for (uint32_t x = left; x < right; ++x)
+                    depthBuffer[size_t(y) * width + x] = std::min(depthBuffer[size_t(y) * width + x], z);
+        }
+        BuildHiZPyramid(depthBuffer.data(), width, height, hiz);
+        constants.hizIndex = 0;
+        constants.hizWidth = width;
+        constants.hizHeight = height;
+        constants.hizMipCount = hiz.GetMipCount();
+    }
+
+    std::vector<IndirectDrawCommand> expected(objectCount);
+    const uint32_t expectedCount = CullObjectsReference(objects.data(), objectCount, constants, useHiZ ? &hiz : nullptr, expected.data());
+
+    // Dispatch whole thread groups, groups spread over the pool and threads of a
+    // group in shuffled order, so the append order is anything but object order
+    const uint32_t groupCount = (objectCount + CULL_THREAD_GROUP_SIZE - 1) / CULL_THREAD_GROUP_SIZE;
+    std::vector<uint32_t> threadOrder(CULL_THREAD_GROUP_SIZE);
+    std::iota(threadOrder.begin(), threadOrder.end(), 0u);
+    std::shuffle(threadOrder.begin(), threadOrder.end(), rng);
+
+    std::vector<IndirectDrawCommand> commands(objectCount + 1);
+    std::atomic<uint32_t> drawCount{ 0 };
+    const ShaderEmulation shader{ constants, hiz, objects.data(), commands.data(), drawCount };
+    pool.ParallelFor(groupCount, [&](uint32_t group) {
+        const uint32_t reversed = groupCount - 1 - group;
+        for (uint32_t thread : threadOrder)
+            shader.Run(reversed * CULL_THREAD_GROUP_SIZE + thread);
+    });
+
+    CHECK(drawCount.load() == expectedCount);
+    commands.resize(expectedCount);
+    std::sort(commands.begin(), commands.end(), [](const IndirectDrawCommand& a, const IndirectDrawCommand& b) {
+        return a.startIndexLocation < b.startIndexLocation;
+    });
+    for (uint32_t i = 0; i < expectedCount; ++i)
+        CHECK(CommandsEqual(commands[i], expected[i]));
+
+    // The scene must exercise both outcomes of each test
+    if (objectCount >= 1000) {
+        CHECK(expectedCount > 0 && expectedCount < objectCount);
+        if (useHiZ) {
+            const uint32_t frustumOnly = CullObjectsReference(objects.data(), objectCount, constants, nullptr, expected.data());
+            CHECK(expectedCount < frustumOnly);
+        }
+    }
+}
+
+int main()
+{
+    TaskPool pool;
+    pool.Initialize(3);
+
+    // Counts around the thread group size, so partial last groups run too
+    const uint32_t counts[] = { 0, 1, CULL_THREAD_GROUP_SIZE - 1, CULL_THREAD_GROUP_SIZE, CULL_THREAD_GROUP_SIZE + 1, 1000, 50000 };
+    uint32_t seed = 1;
+    for (uint32_t count : counts) {
+        RunCase(pool, count, false, seed++);
+        RunCase(pool, count, true, seed++);
+    }
+    for (int round = 0; round < 20; ++round)
+        RunCase(pool, 2000 + round * 37, round % 2 == 0, seed++);
+
+    std::printf("GpuCullingTest passed\n");
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include "TestSupport.h"
+#include "../Rendering/GpuHeapAllocator.h"
+#include <set>
+#include <vector>
+
+// Heaps without memory behind them
+class CountingBackend : public IGpuHeapBackend {
+public:
+    bool CreateHeap(uint32_t heapId, GpuHeapType, GpuResourceClass, uint64_t) override
+    {
+        live.insert(heapId);
+        return true;
+    }
+    void DestroyHeap(uint32_t heapId) override { live.erase(heapId); }
+
+    std::set<uint32_t> live;
+};
+
+static bool Overlaps(const GpuAllocation& a, const GpuAllocation& b)
+{
+    return a.heapId == b.heapId && a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+}
+
+static const uint64_t BLOCK_SIZE = 256 * 1024;
+
+// Fills a few heaps with movable buffers, then frees most of them so all are fragmented
+static std::vector<uint32_t> Fragment(GpuHeapAllocator& allocator)
+{
+    const uint64_t perHeap = GpuHeapAllocator::DEFAULT_HEAP_SIZE / BLOCK_SIZE;
+    std::vector<uint32_t> ids;
+    for (uint64_t i = 0; i < perHeap * 2; ++i) {
+        const GpuAllocation allocation = allocator.Allocate(GpuHeapType::Default, GpuResourceClass::Buffer, BLOCK_SIZE, BLOCK_SIZE, true);
+        CHECK(allocation.IsValid());
+        ids.push_back(allocation.id);
+    }
+    std::vector<uint32_t> kept;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (i % 4 == 3)
+            kept.push_back(ids[i]);
+        else
+            allocator.Free(ids[i]);
+    }
+    return kept;
+}
+
+// The old range of a committed move is still read by frames in flight, so nothing
+// may be placed over it until ReleaseMovedRange hands it back
+static void TestMovedRangeOutlivesCommit()
+{
+    CountingBackend backend;
+    GpuHeapAllocator allocator;
+    allocator.Initialize(&backend);
+    const std::vector<uint32_t> kept = Fragment(allocator);
+    const size_t fragmentedHeaps = backend.live.size();
+    CHECK(fragmentedHeaps >= 2);
+
+    std::vector<GpuDefragMove> moves;
+    const size_t planned = allocator.PlanDefragmentation(~0ull, moves);
+    CHECK(planned > 0 && planned == moves.size());
+    for (const GpuDefragMove& move : moves) {
+        CHECK(!Overlaps(move.from, move.to));
+        allocator.CommitMove(move);
+        CHECK(allocator.GetAllocation(move.allocationId).offset == move.to.offset);
+    }
+    const uint64_t usedAfterCommit = allocator.GetStats().usedBytes;
+    CHECK(usedAfterCommit == (kept.size() + moves.size()) * BLOCK_SIZE);
+
+    // Everything free is taken, and none of it may be an old range
+    std::vector<GpuAllocation> filler;
+    for (;;) {
+        const GpuAllocation allocation = allocator.Allocate(GpuHeapType::Default, GpuResourceClass::Buffer, BLOCK_SIZE, BLOCK_SIZE);
+        CHECK(allocation.IsValid());
+        filler.push_back(allocation);
+        if (backend.live.size() > fragmentedHeaps)
+            break;
+        for (const GpuDefragMove& move : moves)
+            CHECK(!Overlaps(allocation, move.from));
+    }
+    for (const GpuAllocation& allocation : filler)
+        allocator.Free(allocation.id);
+    allocator.ReleaseEmptyHeaps();
+    CHECK(allocator.GetStats().usedBytes == usedAfterCommit);
+
+    // Released, the old ranges are free again and the drained heaps can go
+    const size_t heapsBefore = backend.live.size();
+    for (const GpuDefragMove& move : moves)
+        allocator.ReleaseMovedRange(move);
+    CHECK(allocator.GetStats().usedBytes == kept.size() * BLOCK_SIZE);
+    const uint32_t released = allocator.ReleaseEmptyHeaps();
+    CHECK(released >= 1 && backend.live.size() == heapsBefore - released);
+
+    // Every buffer survived the moves in place
+    std::vector<GpuAllocation> live;
+    for (uint32_t id : kept) {
+        const GpuAllocation allocation = allocator.GetAllocation(id);
+        CHECK(allocation.IsValid() && allocation.size >= BLOCK_SIZE);
+        for (const GpuAllocation& other : live)
+            CHECK(!Overlaps(allocation, other));
+        live.push_back(allocation);
+    }
+    allocator.Shutdown();
+}
+
+// A cancelled move gives back its destination and leaves the source where it was
+static void TestCancelledMove()
+{
+    CountingBackend backend;
+    GpuHeapAllocator allocator;
+    allocator.Initialize(&backend);
+    const std::vector<uint32_t> kept = Fragment(allocator);
+
+    std::vector<GpuDefragMove> moves;
+    CHECK(allocator.PlanDefragmentation(4 * BLOCK_SIZE, moves) == 4);
+    for (const GpuDefragMove& move : moves) {
+        allocator.CancelMove(move);
+        CHECK(allocator.GetAllocation(move.allocationId).offset == move.from.offset);
+    }
+    CHECK(allocator.GetStats().usedBytes == kept.size() * BLOCK_SIZE);
+
+    // Not moving any more, so the next plan can pick them again
+    moves.clear();
+    CHECK(allocator.PlanDefragmentation(4 * BLOCK_SIZE, moves) == 4);
+    for (const GpuDefragMove& move : moves)
+        allocator.CancelMove(move);
+    allocator.Shutdown();
+}
+
+int main()
+{
+    TestMovedRangeOutlivesCommit();
+    TestCancelledMove();
+    std::printf("GpuHeapAllocatorTest passed\n");
+    return 0;
+}
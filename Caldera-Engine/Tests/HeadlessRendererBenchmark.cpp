@@ -0,0 +1,63 @@
+#include "TestSupport.h"
+#include "../Core/TaskPool.h"
+#include "../Rendering/HeadlessRenderer.h"
+#include <random>
+#include <vector>
+
+// CPU cost of a frame on the null backend: graph build and compile, pass
+// recording and validation. The GPU side is simulated, so this is everything
+// the frame loop costs apart from the driver.
+int main(int argc, char** argv)
+{
+    const uint32_t drawCount = IsQuickRun(argc, argv) ? 2000 : 50000;
+    const int frames = IsQuickRun(argc, argv) ? 5 : 100;
+    const int repeats = IsQuickRun(argc, argv) ? 1 : 3;
+
+    TaskPool pool;
+    pool.Initialize();
+    std::printf("%u draws, %d frames, %u threads\n", drawCount, frames, pool.GetThreadCount());
+
+    auto measure = [&](HeadlessRenderer& renderer) {
+        return MeasureBestMs(repeats, [&] {
+            for (int frame = 0; frame < frames; ++frame)
+                CHECK(renderer.RenderFrame());
+        }) / frames;
+    };
+
+    // Empty frame: graph, clears and barriers only
+    {
+        HeadlessRenderer renderer;
+        CHECK(renderer.Initialize(1920, 1080));
+        renderer.SetDrawCount(0);
+        std::printf("empty frame:               %8.3f ms\n", measure(renderer));
+        renderer.Shutdown();
+    }
+
+    for (TaskPool* recording : { static_cast<TaskPool*>(nullptr), &pool }) {
+        HeadlessRenderer renderer;
+        CHECK(renderer.Initialize(1920, 1080, recording));
+        renderer.SetDrawCount(drawCount, 64);
+        std::printf("draws, %-8s recording: %8.3f ms\n", recording ? "parallel" : "serial", measure(renderer));
+        renderer.Shutdown();
+    }
+
+    // Renderables sorted and instanced every frame
+    {
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+        std::vector<Renderable> renderables(drawCount);
+        for (Renderable& renderable : renderables) {
+            renderable.material = rng() % 64;
+            renderable.depth = depth(rng);
+        }
+        HeadlessRenderer renderer;
+        CHECK(renderer.Initialize(1920, 1080, &pool));
+        renderer.SetRenderables(renderables);
+        const double ms = measure(renderer);
+        std::printf("draw list:                 %8.3f ms (%u draw calls)\n", ms, renderer.GetDrawList().GetStats().drawCalls);
+        renderer.Shutdown();
+    }
+
+    pool.Shutdown();
+    return 0;
+}
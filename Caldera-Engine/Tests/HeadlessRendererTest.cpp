@@ -0,0 +1,101 @@
+#include "TestSupport.h"
+#include "../Rendering/HeadlessRenderer.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// Golden command streams of the headless frame loop. Any change to what the
+// frame passes record shows up here as a diff of Data/HeadlessFrames.txt; when
+// the change is intended, rerun with --update and commit the new file.
+
+static const char* const GOLDEN_PATH = CALDERA_TEST_DATA_DIR "/HeadlessFrames.txt";
+
+// Renders 'frames' frames and appends each frame's stream and validation errors to 'dump'
+static void RenderFrames(HeadlessRenderer& renderer, const char* name, int frames, bool expectValid, std::string& dump)
+{
+    for (int frame = 0; frame < frames; ++frame) {
+        const bool valid = renderer.RenderFrame();
+        CHECK(valid == expectValid);
+        const NullCommandList& commands = renderer.GetCommandList();
+        dump += "== " + std::string(name) + " frame " + std::to_string(frame) + "\n";
+        dump += commands.Serialize();
+        for (const std::string& error : commands.GetErrors())
+            dump += "error: " + error + "\n";
+    }
+}
+
+static std::string RecordAll()
+{
+    std::string dump;
+
+    // The editor's default: one cube into the back buffer, then the UI
+    HeadlessRenderer renderer;
+    CHECK(renderer.Initialize(64, 48));
+    renderer.SetUiRecorder([](IRHICommandList& cmd) {
+        RHIRect rect;
+        rect.right = 64;
+        rect.bottom = 48;
+        cmd.SetScissor(rect);
+    });
+    RenderFrames(renderer, "back-buffer", 3, true, dump);
+
+    // The viewport: several draws over two materials into the offscreen target
+    renderer.SetSceneTarget(32, 24);
+    renderer.SetDrawCount(4, 2);
+    RenderFrames(renderer, "scene-target", 2, true, dump);
+
+    // Culled and drawn on the GPU
+    renderer.SetSceneTarget(0, 0);
+    renderer.SetGpuDriven(true, 256);
+    renderer.GetSceneObjects().resize(3);
+    RenderFrames(renderer, "gpu-driven", 2, true, dump);
+    renderer.Shutdown();
+
+    // A UI pass that draws with nothing bound is caught by validation
+    HeadlessRenderer broken;
+    CHECK(broken.Initialize(64, 48));
+    broken.GetScene().pipeline = RHI_NULL_PIPELINE;
+    broken.SetUiRecorder([](IRHICommandList& cmd) { cmd.DrawIndexed(3, 1, 0, 0, 0); });
+    RenderFrames(broken, "invalid-ui", 1, false, dump);
+    broken.Shutdown();
+    return dump;
+}
+
+int main(int argc, char** argv)
+{
+    const std::string dump = RecordAll();
+    // Same input, same stream
+    CHECK(RecordAll() == dump);
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--update") == 0) {
+            std::ofstream(GOLDEN_PATH, std::ios::binary) << dump;
+            std::printf("Wrote %s\n", GOLDEN_PATH);
+            return 0;
+        }
+    }
+
+    std::ifstream file(GOLDEN_PATH, std::ios::binary);
+    CHECK(file.good());
+    std::stringstream golden;
+    golden << file.rdbuf();
+    if (golden.str() != dump) {
+        std::istringstream expectedLines(golden.str()), actualLines(dump);
+        std::string expected, actual;
+        for (int line = 1;; ++line) {
+            const bool haveExpected = static_cast<bool>(std::getline(expectedLines, expected));
+            const bool haveActual = static_cast<bool>(std::getline(actualLines, actual));
+            if (!haveExpected && !haveActual)
+                break;
+            if (!haveExpected || !haveActual || expected != actual) {
+                std::fprintf(stderr, "%s:%d differs\n  expected: %s\n  actual:   %s\n", GOLDEN_PATH, line,
+                    haveExpected ? expected.c_str() : "<end>", haveActual ? actual.c_str() : "<end>");
+                break;
+            }
+        }
+        std::fprintf(stderr, "Rerun with --update if the new stream is intended\n");
+        return 1;
+    }
+    std::printf("HeadlessRendererTest passed\n");
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "TestSupport.h"
+#include "../Core/JobSystem.h"
+#include <atomic>
+#include <vector>
+
+// Cost of scheduling itself: every job body is a single atomic add, so the time
+// per task is what Create, Submit, the deques and Wait take, not the work.
+int main(int argc, char** argv)
+{
+    const uint32_t count = IsQuickRun(argc, argv) ? 4000 : 200000;
+    const int repeats = IsQuickRun(argc, argv) ? 2 : 5;
+    JobSystem jobs;
+    CHECK(jobs.Initialize());
+    std::atomic<uint64_t> sum{ 0 };
+
+    // Independent jobs submitted from the main thread, then waited on one by one
+    std::vector<JobId> ids(count);
+    auto runBatch = [&](JobPriority priority) {
+        for (uint32_t i = 0; i < count; ++i)
+            ids[i] = jobs.Run([&sum] { sum.fetch_add(1, std::memory_order_relaxed); }, priority);
+        for (JobId id : ids)
+            jobs.Wait(id);
+    };
+    sum = 0;
+    const double criticalMs = MeasureBestMs(repeats, [&] { runBatch(JobPriority::Critical); });
+    CHECK(sum == uint64_t(count) * repeats);
+    const double backgroundMs = MeasureBestMs(repeats, [&] { runBatch(JobPriority::Background); });
+
+    // Jobs spawned from inside a job, so they go to a worker's own deque
+    sum = 0;
+    const double nestedMs = MeasureBestMs(repeats, [&] {
+        const JobId root = jobs.Run([&] {
+            for (uint32_t i = 0; i < count; ++i)
+                ids[i] = jobs.Run([&sum] { sum.fetch_add(1, std::memory_order_relaxed); });
+            for (JobId id : ids)
+                jobs.Wait(id);
+        });
+        jobs.Wait(root);
+    });
+    CHECK(sum == uint64_t(count) * repeats);
+
+    // A chain of continuations: each job is released by the one before it
+    sum = 0;
+    const double chainMs = MeasureBestMs(repeats, [&] {
+        JobId last = jobs.Run([&sum] { sum.fetch_add(1, std::memory_order_relaxed); });
+        for (uint32_t i = 1; i < count; ++i)
+            last = jobs.Then(last, [&sum] { sum.fetch_add(1, std::memory_order_relaxed); });
+        jobs.Wait(last);
+    });
+    CHECK(sum == uint64_t(count) * repeats);
+
+    // ParallelFor hands out indices one at a time
+    sum = 0;
+    const double parallelForMs = MeasureBestMs(repeats, [&] {
+        jobs.ParallelFor(count, [&sum](uint32_t) { sum.fetch_add(1, std::memory_order_relaxed); });
+    });
+    CHECK(sum == uint64_t(count) * repeats);
+
+    const double toNs = 1e6 / count;
+    std::printf("%u tasks, %u threads\n", count, jobs.GetThreadCount());
+    std::printf("run + wait, critical:   %8.1f ns/task\n", criticalMs * toNs);
+    std::printf("run + wait, background: %8.1f ns/task\n", backgroundMs * toNs);
+    std::printf("run from a job:         %8.1f ns/task\n", nestedMs * toNs);
+    std::printf("continuation chain:     %8.1f ns/task\n", chainMs * toNs);
+    std::printf("parallel for:           %8.1f ns/index\n", parallelForMs * toNs);
+    jobs.Shutdown();
+    return 0;
+}
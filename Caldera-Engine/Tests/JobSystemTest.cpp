@@ -0,0 +1,172 @@
+#include "TestSupport.h"
+#include "../Core/JobSystem.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// A job runs only once every dependency has finished, and a continuation of a
+// job that already finished runs straight away
+static void TestDependencies(JobSystem& jobs)
+{
+    for (int round = 0; round < 200; ++round) {
+        std::atomic<int> finished{ 0 };
+        std::atomic<int> seenByJoin{ -1 };
+        std::vector<JobId> sources;
+        const JobId join = jobs.Create([&] { seenByJoin = finished.load(); });
+        for (int i = 0; i < 8; ++i) {
+            const JobId source = jobs.Create([&finished] {
+                std::this_thread::yield();
+                ++finished;
+            });
+            jobs.AddDependency(join, source);
+            sources.push_back(source);
+        }
+        for (JobId source : sources)
+            jobs.Submit(source);
+        jobs.Submit(join);
+        jobs.Wait(join);
+        CHECK(seenByJoin == 8);
+    }
+
+    // Each link sees the one before it
+    std::vector<int> order;
+    JobId last = jobs.Run([&order] { order.push_back(0); });
+    for (int i = 1; i < 100; ++i)
+        last = jobs.Then(last, [&order, i] { order.push_back(i); });
+    jobs.Wait(last);
+    CHECK(order.size() == 100);
+    for (int i = 0; i < 100; ++i)
+        CHECK(order[i] == i);
+
+    const JobId done = jobs.Run([] {});
+    jobs.Wait(done);
+    bool ran = false;
+    jobs.Wait(jobs.Then(done, [&ran] { ran = true; }));
+    CHECK(ran);
+}
+
+// Pinned jobs run on their thread: the main thread's while it waits
+static void TestAffinity(JobSystem& jobs)
+{
+    CHECK(jobs.GetThreadCount() >= 3);
+    const std::thread::id mainThread = std::this_thread::get_id();
+
+    std::vector<std::thread::id> ranOn(64);
+    std::vector<JobId> pinned;
+    for (uint32_t i = 0; i < ranOn.size(); ++i) {
+        const JobId job = jobs.Create([&ranOn, i] { ranOn[i] = std::this_thread::get_id(); });
+        jobs.SetAffinity(job, i % 2 == 0 ? JobSystem::MAIN_THREAD : 2);
+        jobs.Submit(job);
+        pinned.push_back(job);
+    }
+    for (JobId job : pinned)
+        jobs.Wait(job);
+    for (uint32_t i = 0; i < ranOn.size(); ++i) {
+        CHECK((ranOn[i] == mainThread) == (i % 2 == 0));
+        CHECK(ranOn[i] == ranOn[i % 2]);
+    }
+}
+
+// A handle outlives its job: once the slot is reused, the old handle still reads
+// as done and depending on it doesn't wait for the new tenant
+static void TestGenerations(JobSystem& jobs)
+{
+    const JobId old = jobs.Create([] {});
+    jobs.SetAffinity(old, JobSystem::MAIN_THREAD);
+    jobs.Submit(old);
+    jobs.Wait(old);
+
+    // Freed on the main thread, so the main thread's next job takes the same slot
+    std::atomic<bool> release{ false };
+    const JobId reused = jobs.Run([&release] {
+        while (!release.load())
+            std::this_thread::yield();
+    });
+    CHECK(reused.index == old.index && reused.generation != old.generation);
+    CHECK(jobs.IsDone(old) && !jobs.IsDone(reused));
+    jobs.Wait(old);
+
+    bool ran = false;
+    const JobId dependent = jobs.Create([&ran] { ran = true; });
+    jobs.AddDependency(dependent, old);
+    jobs.Submit(dependent);
+    jobs.Wait(dependent);
+    CHECK(ran && !jobs.IsDone(reused));
+
+    release = true;
+    jobs.Wait(reused);
+}
+
+// ParallelFor inside ParallelFor, and inside a job
+static void TestNestedParallelFor(JobSystem& jobs)
+{
+    std::atomic<uint64_t> sum{ 0 };
+    std::vector<std::atomic<int>> visits(64 * 500);
+    jobs.ParallelFor(64, [&](uint32_t outer) {
+        jobs.ParallelFor(500, [&](uint32_t inner) {
+            ++visits[outer * 500 + inner];
+            sum.fetch_add(inner, std::memory_order_relaxed);
+        });
+    });
+    CHECK(sum == 64ull * (499 * 500 / 2));
+    for (std::atomic<int>& visit : visits)
+        CHECK(visit == 1);
+
+    sum = 0;
+    const JobId job = jobs.Run([&] {
+        jobs.ParallelFor(1000, [&](uint32_t i) { sum.fetch_add(i, std::memory_order_relaxed); });
+    }, JobPriority::Critical);
+    jobs.Wait(job);
+    CHECK(sum == 999ull * 1000 / 2);
+}
+
+// A worker waiting inside Critical work doesn't pick up a Background job, even
+// one sitting in its own deque, as it did before waits were capped at the
+// waited job's priority. The job runs once the worker is idle, and never on
+// the main thread.
+static void TestPriorityRule()
+{
+    JobSystem jobs;
+    CHECK(jobs.Initialize(1));
+    const std::thread::id mainThread = std::this_thread::get_id();
+
+    std::atomic<bool> criticalFinished{ false };
+    std::atomic<bool> backgroundRanInside{ false };
+    std::atomic<bool> backgroundOnMain{ false };
+    JobId background;
+    const JobId critical = jobs.Create([&] {
+        background = jobs.Run([&] {
+            backgroundRanInside = !criticalFinished.load();
+            backgroundOnMain = std::this_thread::get_id() == mainThread;
+        }, JobPriority::Background);
+
+        // Only the main thread may run this, so the worker has to wait for it
+        const JobId onMain = jobs.Create([] { std::this_thread::sleep_for(std::chrono::milliseconds(50)); }, JobPriority::Critical);
+        jobs.SetAffinity(onMain, JobSystem::MAIN_THREAD);
+        jobs.Submit(onMain);
+        jobs.Wait(onMain);
+        criticalFinished = true;
+    }, JobPriority::Critical);
+    jobs.SetAffinity(critical, 1);
+    jobs.Submit(critical);
+    jobs.Wait(critical);
+    jobs.Wait(background);
+    CHECK(!backgroundRanInside && !backgroundOnMain);
+    jobs.Shutdown();
+}
+
+int main()
+{
+    JobSystem jobs;
+    CHECK(jobs.Initialize(3));
+    // First, while the main thread's cache of free jobs is predictable
+    TestGenerations(jobs);
+    TestDependencies(jobs);
+    TestAffinity(jobs);
+    TestNestedParallelFor(jobs);
+    jobs.Shutdown();
+    TestPriorityRule();
+    std::printf("JobSystemTest passed\n");
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "TestSupport.h"
+#include "../Core/TaskPool.h"
+#include "../Rendering/FrustumCulling.h"
+#include "../Rendering/OcclusionCulling.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Rasterization and box test times for a street of building occluders in
+// front of scattered props, serial and through the pool, with how many props
+// the buildings hide.
+int main(int argc, char** argv)
+{
+    const uint32_t boxCount = IsQuickRun(argc, argv) ? 20000 : 500000;
+    const uint32_t buildingCount = IsQuickRun(argc, argv) ? 32 : 256;
+    const int repeats = IsQuickRun(argc, argv) ? 2 : 10;
+
+    // Camera at the origin looking down +z
+    const float f = 1.0f / std::tan(0.5f);
+    const float zNear = 0.1f, zFar = 500.0f;
+    float viewProjection[16] = {};
+    viewProjection[0] = f / 2.0f;
+    viewProjection[5] = f;
+    viewProjection[10] = zFar / (zFar - zNear);
+    viewProjection[11] = -zNear * zFar / (zFar - zNear);
+    viewProjection[14] = 1.0f;
+
+    // Unit cube, placed and scaled per building
+    const float cube[24] = { -1, -1, -1, 1, -1, -1, 1, 1, -1, -1, 1, -1, -1, -1, 1, 1, -1, 1, 1, 1, 1, -1, 1, 1 };
+    const uint32_t cubeIndices[36] = { 0, 1, 2, 0, 2, 3, 4, 6, 5, 4, 7, 6, 0, 4, 5, 0, 5, 1,
+                                       3, 2, 6, 3, 6, 7, 0, 3, 7, 0, 7, 4, 1, 5, 6, 1, 6, 2 };
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<Occluder> buildings(buildingCount);
+    for (Occluder& building : buildings) {
+        building.positions = cube;
+        building.vertexCount = 8;
+        building.indices = cubeIndices;
+        building.indexCount = 36;
+        const float size[3] = { 2.0f + 6.0f * unit(rng), 5.0f + 20.0f * unit(rng), 2.0f + 6.0f * unit(rng) };
+        const float position[3] = { -120.0f + 240.0f * unit(rng), size[1] - 2.0f, 15.0f + 150.0f * unit(rng) };
+        for (int axis = 0; axis < 3; ++axis) {
+            building.world[axis * 4 + axis] = size[axis];
+            building.world[axis * 4 + 3] = position[axis];
+        }
+    }
+
+    CullingBounds bounds;
+    bounds.Reserve(boxCount);
+    std::vector<uint32_t> indices(boxCount), visible(boxCount);
+    for (uint32_t i = 0; i < boxCount; ++i) {
+        const float center[3] = { -250.0f + 500.0f * unit(rng), -2.0f + 4.0f * unit(rng), 20.0f + 400.0f * unit(rng) };
+        const float extent = 0.3f + 1.5f * unit(rng);
+        const float extents[3] = { extent, extent, extent };
+        bounds.Add(center, extents, extent * std::sqrt(3.0f));
+        indices[i] = i;
+    }
+
+    TaskPool pool;
+    pool.Initialize();
+    std::printf("%u buildings, %u boxes, %ux%u buffer, %u threads\n", buildingCount, boxCount, OcclusionCuller::DEFAULT_WIDTH,
+        OcclusionCuller::DEFAULT_HEIGHT, pool.GetThreadCount());
+    for (TaskPool* culling : { static_cast<TaskPool*>(nullptr), &pool }) {
+        OcclusionCuller culler;
+        culler.Initialize(culling);
+        const double rasterMs = MeasureBestMs(repeats, [&] {
+            culler.Begin(viewProjection);
+            for (const Occluder& building : buildings)
+                culler.AddOccluder(building);
+            culler.Rasterize();
+        });
+        uint32_t visibleCount = 0;
+        const double cullMs = MeasureBestMs(repeats, [&] {
+            visibleCount = culler.CullBoxes(bounds, indices.data(), boxCount, visible.data());
+        });
+        const OcclusionStats& stats = culler.GetStats();
+        CHECK(stats.rasterizedTriangles > 0 && visibleCount < boxCount);
+        std::printf("%-6s raster %.3f ms (%u triangles, %u binned), boxes %.3f ms (%.1f Mboxes/s), %.1f%% occluded\n",
+            culling ? "pool" : "serial", rasterMs, stats.rasterizedTriangles, stats.binnedTriangles, cullMs,
+            boxCount / cullMs / 1000.0, 100.0 * stats.occludedBoxes / boxCount);
+    }
+
+    pool.Shutdown();
+    return 0;
+}
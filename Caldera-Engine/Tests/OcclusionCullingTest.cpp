@@ -0,0 +1,213 @@
+#include "TestSupport.h"
+#include "../Core/TaskPool.h"
+#include "../Rendering/FrustumCulling.h"
+#include "../Rendering/OcclusionCulling.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+static const float Z_NEAR = 0.1f;
+static const float Z_FAR = 100.0f;
+
+// Camera at the origin looking down +z, for the default 2:1 buffer
+static void MakeViewProjection(float m[16])
+{
+    const float f = 1.0f / std::tan(0.5f);
+    std::memset(m, 0, 16 * sizeof(float));
+    m[0] = f / 2.0f;
+    m[5] = f;
+    m[10] = Z_FAR / (Z_FAR - Z_NEAR);
+    m[11] = -Z_NEAR * Z_FAR / (Z_FAR - Z_NEAR);
+    m[14] = 1.0f;
+}
+
+static float DepthAt(float z)
+{
+    return (Z_FAR / (Z_FAR - Z_NEAR) * z - Z_NEAR * Z_FAR / (Z_FAR - Z_NEAR)) / z;
+}
+
+// A quad facing the camera at depth 'z', spanning [x0, x1] x [-20, 20]. Not to be moved once built.
+struct QuadOccluder {
+    float positions[12];
+    uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+    Occluder occluder;
+
+    QuadOccluder(float x0, float x1, float z, bool reversed = false)
+    {
+        const float corners[12] = { x0, -20.0f, 0.0f, x1, -20.0f, 0.0f, x1, 20.0f, 0.0f, x0, 20.0f, 0.0f };
+        std::memcpy(positions, corners, sizeof(positions));
+        if (reversed) {
+            std::swap(indices[1], indices[2]);
+            std::swap(indices[4], indices[5]);
+        }
+        occluder.positions = positions;
+        occluder.vertexCount = 4;
+        occluder.indices = indices;
+        occluder.indexCount = 6;
+        occluder.world[11] = z;
+    }
+};
+
+static bool IsVisible(const OcclusionCuller& culler, float x, float y, float z, float extent)
+{
+    const float center[3] = { x, y, z };
+    const float extents[3] = { extent, extent, extent };
+    return culler.IsBoxVisible(center, extents);
+}
+
+// A full-screen occluder hides what is behind it and nothing in front of or through it
+static void TestFullScreenOccluder()
+{
+    float viewProjection[16];
+    MakeViewProjection(viewProjection);
+    OcclusionCuller culler;
+    culler.Initialize(nullptr);
+    culler.Begin(viewProjection);
+    culler.AddOccluder(QuadOccluder(-20.0f, 20.0f, 10.0f).occluder);
+    culler.Rasterize();
+    CHECK(culler.HasOccluders());
+
+    const uint32_t pixels = culler.GetWidth() * culler.GetHeight();
+    for (uint32_t i = 0; i < pixels; ++i)
+        CHECK(std::fabs(culler.GetDepth()[i] - DepthAt(10.0f)) < 1e-5f);
+
+    CHECK(!IsVisible(culler, 0.0f, 0.0f, 20.0f, 1.0f));
+    CHECK(!IsVisible(culler, 5.0f, 2.0f, 50.0f, 3.0f));
+    CHECK(IsVisible(culler, 0.0f, 0.0f, 5.0f, 1.0f));
+    CHECK(IsVisible(culler, 0.0f, 0.0f, 10.0f, 1.0f));   // pokes through the occluder
+    // Behind the camera or crossing its plane: left to frustum culling
+    CHECK(IsVisible(culler, 0.0f, 0.0f, -5.0f, 1.0f));
+    CHECK(IsVisible(culler, 0.0f, 0.0f, 0.0f, 1.0f));
+
+    // Through CullBoxes, in place, in order
+    CullingBounds bounds;
+    const float boxes[4][3] = { { 0.0f, 0.0f, 20.0f }, { 0.0f, 0.0f, 5.0f }, { 1.0f, 1.0f, 30.0f }, { -2.0f, 0.0f, 8.0f } };
+    const float extents[3] = { 1.0f, 1.0f, 1.0f };
+    for (const float* box : boxes)
+        bounds.Add(box, extents, std::sqrt(3.0f));
+    uint32_t indices[4] = { 0, 1, 2, 3 };
+    CHECK(culler.CullBoxes(bounds, indices, 4, indices) == 2);
+    CHECK(indices[0] == 1 && indices[1] == 3);
+    CHECK(culler.GetStats().testedBoxes == 4 && culler.GetStats().occludedBoxes == 2);
+}
+
+// Only the covered part of the screen hides anything, whichever way the occluder winds
+static void TestPartialOccluder()
+{
+    float viewProjection[16];
+    MakeViewProjection(viewProjection);
+    for (bool reversed : { false, true }) {
+        OcclusionCuller culler;
+        culler.Initialize(nullptr);
+        culler.Begin(viewProjection);
+        culler.AddOccluder(QuadOccluder(-20.0f, 0.0f, 10.0f, reversed).occluder);
+        culler.Rasterize();
+        CHECK(culler.GetStats().rasterizedTriangles == 2);
+
+        // Left half at the occluder's depth, right half clear
+        const float* row = culler.GetDepth() + (culler.GetHeight() / 2) * culler.GetWidth();
+        CHECK(std::fabs(row[0] - DepthAt(10.0f)) < 1e-5f && row[culler.GetWidth() - 1] == 1.0f);
+
+        CHECK(!IsVisible(culler, -3.0f, 0.0f, 20.0f, 0.5f));
+        CHECK(IsVisible(culler, 3.0f, 0.0f, 20.0f, 0.5f));
+        CHECK(IsVisible(culler, 0.0f, 0.0f, 20.0f, 1.0f));
+    }
+}
+
+// With nothing drawn everything is visible; occluders crossing the camera plane are dropped
+static void TestEmptyAndNearPlane()
+{
+    float viewProjection[16];
+    MakeViewProjection(viewProjection);
+    OcclusionCuller culler;
+    culler.Initialize(nullptr);
+    culler.Begin(viewProjection);
+    culler.Rasterize();
+    CHECK(!culler.HasOccluders() && IsVisible(culler, 0.0f, 0.0f, 20.0f, 1.0f));
+
+    CullingBounds bounds;
+    const float center[3] = { 0.0f, 0.0f, 20.0f }, extents[3] = { 1.0f, 1.0f, 1.0f };
+    bounds.Add(center, extents, std::sqrt(3.0f));
+    uint32_t index = 0, visible = 7;
+    CHECK(culler.CullBoxes(bounds, &index, 1, &visible) == 1 && visible == 0);
+
+    // Tilted to reach behind the camera: clipping isn't done, so it occludes nothing
+    QuadOccluder tilted(-20.0f, 20.0f, 10.0f);
+    for (int corner : { 0, 1 })
+        tilted.positions[corner * 3 + 2] = -12.0f;
+    culler.Begin(viewProjection);
+    culler.AddOccluder(tilted.occluder);
+    culler.Rasterize();
+    const OcclusionStats& stats = culler.GetStats();
+    CHECK(stats.occluderTriangles == 2 && stats.rasterizedTriangles == 0);
+    CHECK(IsVisible(culler, 0.0f, 0.0f, 20.0f, 1.0f));
+}
+
+// Tiles through the pool and boxes in several tasks give exactly the serial result
+static void TestPoolMatchesSerial()
+{
+    float viewProjection[16];
+    MakeViewProjection(viewProjection);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    // Reserved, as each occluder points into its own quad's arrays
+    std::vector<QuadOccluder> quads;
+    quads.reserve(24);
+    for (int i = 0; i < 24; ++i) {
+        const float x0 = -30.0f + 60.0f * unit(rng);
+        quads.emplace_back(x0, x0 + 2.0f + 6.0f * unit(rng), 5.0f + 40.0f * unit(rng), i % 2 == 0);
+    }
+    CullingBounds bounds;
+    const uint32_t count = 3 * OcclusionCuller::BOXES_PER_TASK + 17;
+    for (uint32_t i = 0; i < count; ++i) {
+        const float center[3] = { -40.0f + 80.0f * unit(rng), -15.0f + 30.0f * unit(rng), 2.0f + 80.0f * unit(rng) };
+        const float extent = 0.2f + 2.0f * unit(rng);
+        const float extents[3] = { extent, extent, extent };
+        bounds.Add(center, extents, extent * std::sqrt(3.0f));
+    }
+
+    TaskPool pool;
+    CHECK(pool.Initialize(3));
+    OcclusionCuller serial, parallel;
+    serial.Initialize(nullptr);
+    parallel.Initialize(&pool);
+    for (OcclusionCuller* culler : { &serial, &parallel }) {
+        culler->Begin(viewProjection);
+        for (const QuadOccluder& quad : quads)
+            culler->AddOccluder(quad.occluder);
+        culler->Rasterize();
+    }
+    const size_t pixels = size_t(serial.GetWidth()) * serial.GetHeight();
+    CHECK(std::memcmp(serial.GetDepth(), parallel.GetDepth(), pixels * sizeof(float)) == 0);
+
+    std::vector<uint32_t> indices(count), expected, culled(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        indices[i] = i;
+        const float center[3] = { bounds.GetCenterX()[i], bounds.GetCenterY()[i], bounds.GetCenterZ()[i] };
+        const float extents[3] = { bounds.GetExtentX()[i], bounds.GetExtentY()[i], bounds.GetExtentZ()[i] };
+        if (serial.IsBoxVisible(center, extents))
+            expected.push_back(i);
+    }
+    CHECK(!expected.empty() && expected.size() < count);
+
+    CHECK(serial.CullBoxes(bounds, indices.data(), count, culled.data()) == expected.size());
+    CHECK(std::equal(expected.begin(), expected.end(), culled.begin()));
+    CHECK(parallel.CullBoxes(bounds, indices.data(), count, indices.data()) == expected.size());
+    CHECK(std::equal(expected.begin(), expected.end(), indices.begin()));
+    CHECK(parallel.GetStats().occludedBoxes == count - expected.size());
+    pool.Shutdown();
+}
+
+int main()
+{
+    TestFullScreenOccluder();
+    TestPartialOccluder();
+    TestEmptyAndNearPlane();
+    TestPoolMatchesSerial();
+    std::printf("OcclusionCullingTest passed\n");
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include "TestSupport.h"
+#include "../Core/TaskPool.h"
+#include "../Rendering/NullRHI.h"
+#include "../Rendering/ParallelRecorder.h"
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+static const RHIResourceId TARGET = 1;
+static const RHIResourceId DEPTH = 2;
+static const RHIResourceId VERTICES = 3;
+static const RHIResourceId INDICES = 4;
+static const RHIPipelineId PIPELINE = 1;
+
+static void Register(NullCommandList& list)
+{
+    list.RegisterResource(TARGET, "Target", RGState::RenderTarget);
+    list.RegisterResource(DEPTH, "Depth", RGState::DepthWrite);
+    list.RegisterResource(VERTICES, "Vertices", RGState::ShaderResource);
+    list.RegisterResource(INDICES, "Indices", RGState::ShaderResource);
+    list.RegisterPipeline(PIPELINE, "Pipeline");
+}
+
+// What a pass records for draws [first, first + count): state once, then one
+// constant and one draw per index, so the stream shows the order
+static void RecordDraws(IRHICommandList& list, DrawRange range, bool secondary)
+{
+    // Secondaries inherit nothing from the primary list
+    if (secondary) {
+        list.SetRenderTargets(&TARGET, 1, DEPTH);
+        list.SetDescriptorHeap();
+    }
+    list.SetPipeline(PIPELINE);
+    list.SetVertexBuffer(VERTICES, 24, 2400);
+    list.SetIndexBuffer(INDICES, 1200, true);
+    for (uint32_t i = range.first; i < range.first + range.count; ++i) {
+        list.SetRootConstants(0, &i, 1);
+        list.DrawIndexed(36, 1, 0, 0, 0);
+    }
+}
+
+static void BeginPass(NullCommandList& list)
+{
+    list.Reset();
+    list.SetRenderTargets(&TARGET, 1, DEPTH);
+    list.SetDescriptorHeap();
+}
+
+// Only the per-draw commands, which must come out in draw order however the pass was split
+static std::vector<uint64_t> DrawOrder(const NullCommandList& list)
+{
+    std::vector<uint64_t> order;
+    for (const RHICommand& command : list.GetCommands()) {
+        if (command.type == RHICommandType::SetRootConstants)
+            order.push_back(command.args[2]);
+    }
+    return order;
+}
+
+// Ranges cover every draw in order, differ in size by at most one, and are never
+// smaller than the minimum unless there is only one
+static void CheckPartition(uint32_t drawCount, uint32_t maxChunks, uint32_t minPerChunk)
+{
+    DrawRange ranges[64];
+    const uint32_t count = PartitionDraws(drawCount, maxChunks, minPerChunk, ranges);
+    if (drawCount == 0) {
+        CHECK(count == 0);
+        return;
+    }
+    CHECK(count >= 1 && count <= maxChunks);
+    uint32_t next = 0, smallest = drawCount, largest = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        CHECK(ranges[i].first == next);
+        next += ranges[i].count;
+        smallest = std::min(smallest, ranges[i].count);
+        largest = std::max(largest, ranges[i].count);
+    }
+    CHECK(next == drawCount);
+    CHECK(largest - smallest <= 1);
+    CHECK(count == 1 || smallest >= minPerChunk);
+    // No more lists than the minimum allows, and no fewer than it and the cap allow
+    CHECK(count == std::min(maxChunks, std::max(1u, drawCount / std::max(1u, minPerChunk))));
+}
+
+static void TestPartition()
+{
+    for (uint32_t drawCount : { 0u, 1u, 7u, 127u, 128u, 129u, 255u, 256u, 1000u, 4099u })
+        for (uint32_t maxChunks : { 1u, 3u, 4u, 16u, 64u })
+            for (uint32_t minPerChunk : { 0u, 1u, 32u, 128u })
+                CheckPartition(drawCount, maxChunks, minPerChunk);
+}
+
+// K draws through the pool and secondaries give the stream a serial recording of the same ranges gives
+static void TestMatchesSerial()
+{
+    TaskPool pool;
+    CHECK(pool.Initialize(3));
+    const uint32_t minDraws = 32;
+
+    for (uint32_t drawCount : { 0u, 10u, 63u, 64u, 100u, 1000u }) {
+        NullCommandList parallel;
+        Register(parallel);
+        NullSecondaryLists secondaries;
+        secondaries.BeginFrame(&parallel);
+        ParallelRecorder recorder;
+        recorder.Initialize(&pool, &secondaries, minDraws);
+
+        std::mutex mutex;
+        std::vector<DrawRange> recorded(NullSecondaryLists::MAX_SECONDARY_LISTS);
+        std::vector<uint8_t> wasSecondary(NullSecondaryLists::MAX_SECONDARY_LISTS, 0);
+        uint32_t calls = 0;
+        BeginPass(parallel);
+        const uint32_t lists = recorder.Record(parallel, drawCount, [&](IRHICommandList& list, DrawRange range, bool secondary) {
+            RecordDraws(list, range, secondary);
+            std::lock_guard<std::mutex> lock(mutex);
+            recorded[calls] = range;
+            wasSecondary[calls] = secondary;
+            ++calls;
+        });
+        CHECK(parallel.GetErrors().empty());
+        CHECK(lists == recorder.GetLastListCount() && lists == calls);
+
+        DrawRange expected[NullSecondaryLists::MAX_SECONDARY_LISTS];
+        const uint32_t maxLists = std::min(pool.GetThreadCount(), NullSecondaryLists::MAX_SECONDARY_LISTS);
+        const uint32_t expectedLists = PartitionDraws(drawCount, maxLists, minDraws, expected);
+        CHECK(lists == expectedLists);
+        CHECK(secondaries.GetSubmittedCount() == (lists > 1 ? lists : 0));
+
+        // Every range was recorded once, into a secondary unless there was only one
+        std::sort(recorded.begin(), recorded.begin() + calls, [](const DrawRange& a, const DrawRange& b) { return a.first < b.first; });
+        for (uint32_t i = 0; i < calls; ++i) {
+            CHECK(recorded[i].first == expected[i].first && recorded[i].count == expected[i].count);
+            CHECK((wasSecondary[i] != 0) == (lists > 1));
+        }
+
+        // The serial recording of the same ranges, on one list
+        NullCommandList serial;
+        Register(serial);
+        BeginPass(serial);
+        for (uint32_t i = 0; i < expectedLists; ++i)
+            RecordDraws(serial, expected[i], expectedLists > 1);
+        CHECK(serial.GetErrors().empty());
+        CHECK(parallel.Serialize() == serial.Serialize());
+
+        // And the draws come out as they do with no pool at all
+        NullCommandList single;
+        Register(single);
+        ParallelRecorder serialRecorder;
+        serialRecorder.Initialize(nullptr, nullptr, minDraws);
+        BeginPass(single);
+        CHECK(serialRecorder.Record(single, drawCount, RecordDraws) == (drawCount > 0 ? 1u : 0u));
+        CHECK(DrawOrder(parallel) == DrawOrder(single));
+        CHECK(DrawOrder(single).size() == drawCount);
+        CHECK(parallel.Count(RHICommandType::DrawIndexed) == drawCount);
+    }
+    pool.Shutdown();
+}
+
+int main()
+{
+    TestPartition();
+    TestMatchesSerial();
+    std::printf("ParallelRecorderTest passed\n");
+    return 0;
+}
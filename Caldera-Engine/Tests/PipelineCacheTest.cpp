@@ -0,0 +1,241 @@
+#include "TestSupport.h"
+#include "../Core/JobSystem.h"
+#include "../Rendering/PipelineCache.h"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// Hands out ids and fails on request: a name in 'failOnce' fails its first compile only
+class FakeCompiler : public IPipelineCompiler {
+public:
+    RHIPipelineId Compile(const std::string& name, const PipelineStateDesc&, uint64_t) override
+    {
+        ++compiles;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (failOnce.erase(name))
+            return RHI_NULL_PIPELINE;
+        live.insert(++nextId);
+        return nextId;
+    }
+    void Release(RHIPipelineId pipeline) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        CHECK(live.erase(pipeline) == 1);
+    }
+
+    std::atomic<uint32_t> compiles{ 0 };
+    std::set<std::string> failOnce;
+    std::set<RHIPipelineId> live;
+
+private:
+    std::mutex mutex;
+    RHIPipelineId nextId = 0;
+};
+
+static std::string TempPath(const char* name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static PipelineStateDesc MakeDesc(uint32_t variant)
+{
+    PipelineStateDesc desc;
+    desc.rootSignature = 7;
+    desc.vs = { 0x44, 0x58, 0x42, 0x43, uint8_t(variant) };
+    desc.ps = { 0x44, 0x58, 0x42, 0x43, 0x01 };
+    desc.inputLayout.push_back({ "POSITION", 0, 6, 0, 0, false });
+    desc.inputLayout.push_back({ "TEXCOORD", 0, 16, 0, 12, false });
+    desc.renderTargetCount = 1;
+    desc.renderTargetFormats[0] = 28;
+    desc.depthFormat = 40;
+    desc.depthBias = -int32_t(variant);
+    return desc;
+}
+
+// Equal descriptions hash equally, any field changes the hash, and the value
+// doesn't depend on the build: recorded lists and pipeline library names use it
+static void TestHashStability()
+{
+    CHECK(HashPipelineDesc(MakeDesc(1)) == HashPipelineDesc(MakeDesc(1)));
+    CHECK(HashPipelineDesc(MakeDesc(1)) != HashPipelineDesc(MakeDesc(2)));
+    // Changing this value invalidates every recorded list; bump PIPELINE_LIST_VERSION with it
+    CHECK(HashPipelineDesc(PipelineStateDesc()) == 0x6952f33c259a754bull);
+
+    PipelineStateDesc blended = MakeDesc(1);
+    blended.blendEnable = true;
+    PipelineStateDesc unused = MakeDesc(1);
+    unused.renderTargetFormats[5] = 2;
+    PipelineStateDesc semantic = MakeDesc(1);
+    semantic.inputLayout[1].semantic = "COLOR";
+    for (const PipelineStateDesc* changed : { &blended, &unused, &semantic })
+        CHECK(HashPipelineDesc(*changed) != HashPipelineDesc(MakeDesc(1)));
+
+    // Through the byte form and back, unchanged
+    std::vector<uint8_t> bytes;
+    SerializePipelineDesc(MakeDesc(3), bytes);
+    const uint8_t* cursor = bytes.data();
+    PipelineStateDesc read;
+    CHECK(DeserializePipelineDesc(cursor, bytes.data() + bytes.size(), read));
+    CHECK(cursor == bytes.data() + bytes.size());
+    CHECK(HashPipelineDesc(read) == HashPipelineDesc(MakeDesc(3)));
+    CHECK(read.depthBias == -3 && read.inputLayout[1].offset == 12);
+}
+
+// Requests for one description share an entry and a single compile, whatever the name
+static void TestDeduplication()
+{
+    FakeCompiler compiler;
+    PipelineCache cache;
+    CHECK(cache.Initialize(&compiler));
+
+    const PipelineHandle first = cache.Request("Opaque", MakeDesc(1));
+    const PipelineHandle again = cache.Request("OpaqueCopy", MakeDesc(1));
+    const PipelineHandle other = cache.Request("Other", MakeDesc(2));
+    cache.Request("Opaque", MakeDesc(1));
+    CHECK(first.index == again.index && first.index != other.index);
+    CHECK(cache.GetStatus(first) == PipelineStatus::Ready && cache.Get(first) != RHI_NULL_PIPELINE);
+    CHECK(cache.Get(first) != cache.Get(other));
+
+    const PipelineCacheStats stats = cache.GetStats();
+    CHECK(stats.requests == 4 && stats.deduplicated == 2 && stats.compiled == 2 && stats.failed == 0);
+    CHECK(compiler.compiles == 2);
+
+    // Shutdown releases every pipeline
+    cache.Shutdown();
+    CHECK(compiler.live.empty());
+}
+
+// A failed compile is retried on the next request, and left out of the recorded list until then
+static void TestFailedRetry()
+{
+    FakeCompiler compiler;
+    compiler.failOnce = { "Flaky" };
+    PipelineCache cache;
+    CHECK(cache.Initialize(&compiler));
+
+    const PipelineHandle flaky = cache.Request("Flaky", MakeDesc(1));
+    cache.Request("Steady", MakeDesc(2));
+    CHECK(cache.GetStatus(flaky) == PipelineStatus::Failed && cache.Get(flaky) == RHI_NULL_PIPELINE);
+    CHECK(cache.GetStats().failed == 1);
+
+    const std::string path = TempPath("CalderaPipelinesFailed.bin");
+    CHECK(cache.SaveRecordedList(path));
+    std::vector<RecordedPipeline> recorded;
+    CHECK(LoadPipelineList(path, recorded));
+    CHECK(recorded.size() == 1 && recorded[0].name == "Steady");
+
+    const PipelineHandle retried = cache.Request("Flaky", MakeDesc(1));
+    CHECK(retried.index == flaky.index);
+    CHECK(cache.GetStatus(flaky) == PipelineStatus::Ready && cache.Get(flaky) != RHI_NULL_PIPELINE);
+    const PipelineCacheStats stats = cache.GetStats();
+    CHECK(stats.compiled == 2 && stats.failed == 1 && compiler.compiles == 3);
+
+    // A ready entry is not compiled again
+    cache.Request("Flaky", MakeDesc(1));
+    CHECK(compiler.compiles == 3);
+    std::filesystem::remove(path);
+}
+
+// The recorded list warms a fresh cache up, after which every request is a hit
+static void TestSaveLoadRoundTrip()
+{
+    const std::string path = TempPath("CalderaPipelines.bin");
+    {
+        FakeCompiler compiler;
+        PipelineCache cache;
+        CHECK(cache.Initialize(&compiler));
+        for (uint32_t variant = 0; variant < 5; ++variant)
+            cache.Request("Variant" + std::to_string(variant), MakeDesc(variant));
+        cache.Request("Again", MakeDesc(2));
+        CHECK(cache.SaveRecordedList(path));
+    }
+
+    std::vector<RecordedPipeline> recorded;
+    CHECK(LoadPipelineList(path, recorded));
+    CHECK(recorded.size() == 5);
+    for (uint32_t variant = 0; variant < 5; ++variant) {
+        CHECK(recorded[variant].name == "Variant" + std::to_string(variant));
+        CHECK(HashPipelineDesc(recorded[variant].desc) == HashPipelineDesc(MakeDesc(variant)));
+    }
+
+    // Warmed up in the background, as the editor does at startup
+    JobSystem jobs;
+    CHECK(jobs.Initialize(2));
+    FakeCompiler compiler;
+    PipelineCache cache;
+    CHECK(cache.Initialize(&compiler, &jobs));
+    CHECK(cache.Warmup(path) == 5);
+    CHECK(cache.Warmup(path) == 0);
+    cache.WaitIdle();
+    CHECK(cache.GetPendingCount() == 0 && compiler.compiles == 5);
+
+    for (uint32_t variant = 0; variant < 5; ++variant) {
+        const PipelineHandle handle = cache.Request("Variant" + std::to_string(variant), MakeDesc(variant));
+        CHECK(cache.GetStatus(handle) == PipelineStatus::Ready);
+        CHECK(cache.Wait(handle) == cache.Get(handle));
+    }
+    const PipelineCacheStats stats = cache.GetStats();
+    CHECK(stats.warmedUp == 5 && stats.requests == 5 && stats.deduplicated == 5 && stats.compiled == 5);
+    CHECK(compiler.compiles == 5);
+
+    // A new description still compiles in the background
+    const PipelineHandle fresh = cache.Request("Fresh", MakeDesc(9));
+    CHECK(cache.Wait(fresh) != RHI_NULL_PIPELINE);
+    cache.Shutdown();
+    jobs.Shutdown();
+    CHECK(compiler.live.empty());
+    std::filesystem::remove(path);
+}
+
+// A list cut short anywhere, or from another version, is rejected whole
+static void TestTruncatedList()
+{
+    const std::string path = TempPath("CalderaPipelinesTruncated.bin");
+    std::vector<RecordedPipeline> pipelines;
+    for (uint32_t variant = 0; variant < 3; ++variant)
+        pipelines.push_back({ "Variant" + std::to_string(variant), MakeDesc(variant) });
+    CHECK(SavePipelineList(path, pipelines));
+
+    std::ifstream file(path, std::ios::binary);
+    const std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    std::vector<RecordedPipeline> loaded;
+    for (size_t size = 0; size < bytes.size(); size += 7) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), static_cast<std::streamsize>(size));
+        loaded.assign(1, RecordedPipeline());
+        CHECK(!LoadPipelineList(path, loaded));
+        CHECK(loaded.empty());
+    }
+
+    // Version field bumped
+    std::vector<char> newer = bytes;
+    newer[4] = 2;
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(newer.data(), static_cast<std::streamsize>(newer.size()));
+    CHECK(!LoadPipelineList(path, loaded));
+
+    // Nothing is warmed up from a rejected list
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 1));
+    FakeCompiler compiler;
+    PipelineCache cache;
+    CHECK(cache.Initialize(&compiler));
+    CHECK(cache.Warmup(path) == 0);
+    CHECK(compiler.compiles == 0);
+    std::filesystem::remove(path);
+}
+
+int main()
+{
+    TestHashStability();
+    TestDeduplication();
+    TestFailedRetry();
+    TestSaveLoadRoundTrip();
+    TestTruncatedList();
+    std::printf("PipelineCacheTest passed\n");
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "TestSupport.h"
+#include "../Rendering/QueueSync.h"
+
+// Waits that can't change anything never reach the GPU
+static void TestRedundantWaits()
+{
+    SimulatedGpuTimeline timeline;
+    QueueScheduler scheduler;
+    scheduler.Initialize(&timeline);
+
+    // Three uploads feeding one frame: only the last one is waited on
+    const SyncPoint first = scheduler.Submit(QueueType::Copy);
+    const SyncPoint second = scheduler.Submit(QueueType::Copy);
+    const SyncPoint third = scheduler.Submit(QueueType::Copy);
+    scheduler.WaitOn(QueueType::Graphics, second);
+    scheduler.WaitOn(QueueType::Graphics, third);
+    scheduler.WaitOn(QueueType::Graphics, first);
+    scheduler.FlushWaits(QueueType::Graphics);
+    CHECK(scheduler.GetIssuedWaitCount() == 1);
+    CHECK(timeline.GetPendingCount(QueueType::Graphics) == 1);
+
+    // Already waited for, on the queue itself, or invalid: dropped
+    scheduler.WaitOn(QueueType::Graphics, second);
+    scheduler.WaitOn(QueueType::Graphics, scheduler.Submit(QueueType::Graphics));
+    scheduler.WaitOn(QueueType::Graphics, SyncPoint{});
+    scheduler.FlushWaits(QueueType::Graphics);
+    CHECK(scheduler.GetIssuedWaitCount() == 1);
+    CHECK(scheduler.GetSkippedWaitCount() == 2);
+
+    // Finished on the GPU before the wait was recorded: dropped
+    const SyncPoint compute = scheduler.Submit(QueueType::Compute);
+    CHECK(timeline.RunUntilIdle());
+    CHECK(scheduler.IsComplete(compute));
+    scheduler.WaitOn(QueueType::Copy, compute);
+    scheduler.FlushWaits(QueueType::Copy);
+    CHECK(scheduler.GetIssuedWaitCount() == 1 && scheduler.GetSkippedWaitCount() == 3);
+
+    // Each source queue gets its own wait
+    scheduler.WaitOn(QueueType::Graphics, scheduler.Submit(QueueType::Copy));
+    scheduler.WaitOn(QueueType::Graphics, scheduler.Submit(QueueType::Compute));
+    scheduler.FlushWaits(QueueType::Graphics);
+    CHECK(scheduler.GetIssuedWaitCount() == 3);
+    CHECK(timeline.RunUntilIdle());
+}
+
+// An upload batch on the copy queue runs alongside graphics work that doesn't
+// need it; only the frame that reads it waits
+static void TestUploadOverlap()
+{
+    SimulatedGpuTimeline timeline;
+    QueueScheduler scheduler;
+    scheduler.Initialize(&timeline);
+
+    const SyncPoint upload = scheduler.Submit(QueueType::Copy);
+    const SyncPoint unrelated = scheduler.Submit(QueueType::Graphics);
+    scheduler.WaitOn(QueueType::Graphics, upload);
+    scheduler.FlushWaits(QueueType::Graphics);
+    const SyncPoint consumer = scheduler.Submit(QueueType::Graphics);
+
+    // Graphics gets through its first frame while the copy is still in flight
+    CHECK(timeline.Step(QueueType::Graphics));
+    CHECK(scheduler.IsComplete(unrelated) && !scheduler.IsComplete(upload));
+    // ...then stalls on the upload, and only on the GPU
+    CHECK(timeline.IsBlocked(QueueType::Graphics));
+    CHECK(!timeline.Step(QueueType::Graphics));
+    CHECK(!scheduler.IsComplete(consumer));
+
+    CHECK(timeline.Step(QueueType::Copy));
+    CHECK(!timeline.IsBlocked(QueueType::Graphics));
+    CHECK(timeline.Step(QueueType::Graphics) && timeline.Step(QueueType::Graphics));
+    CHECK(scheduler.IsComplete(consumer));
+
+    // A CPU wait on the consumer runs whatever it depends on
+    const SyncPoint nextUpload = scheduler.Submit(QueueType::Copy);
+    scheduler.WaitOn(QueueType::Graphics, nextUpload);
+    scheduler.FlushWaits(QueueType::Graphics);
+    const SyncPoint nextConsumer = scheduler.Submit(QueueType::Graphics);
+    scheduler.CpuWait(nextConsumer);
+    CHECK(scheduler.IsComplete(nextUpload) && scheduler.IsComplete(nextConsumer));
+}
+
+// Two queues waiting on each other's later work never drain; the timeline reports it
+static void TestWaitCycle()
+{
+    SimulatedGpuTimeline timeline;
+    QueueScheduler scheduler;
+    scheduler.Initialize(&timeline);
+
+    const SyncPoint graphicsPoint = { QueueType::Graphics, 1 };
+    const SyncPoint computePoint = { QueueType::Compute, 1 };
+    scheduler.WaitOn(QueueType::Graphics, computePoint);
+    scheduler.FlushWaits(QueueType::Graphics);
+    CHECK(scheduler.Submit(QueueType::Graphics).value == graphicsPoint.value);
+    scheduler.WaitOn(QueueType::Compute, graphicsPoint);
+    scheduler.FlushWaits(QueueType::Compute);
+    CHECK(scheduler.Submit(QueueType::Compute).value == computePoint.value);
+
+    CHECK(!timeline.RunUntilIdle());
+    CHECK(timeline.IsBlocked(QueueType::Graphics) && timeline.IsBlocked(QueueType::Compute));
+    CHECK(!scheduler.IsComplete(graphicsPoint) && !scheduler.IsComplete(computePoint));
+
+    // The copy queue isn't part of the cycle and still drains
+    const SyncPoint copy = scheduler.Submit(QueueType::Copy);
+    CHECK(!timeline.RunUntilIdle());
+    CHECK(scheduler.IsComplete(copy) && timeline.GetPendingCount(QueueType::Copy) == 0);
+}
+
+int main()
+{
+    TestRedundantWaits();
+    TestUploadOverlap();
+    TestWaitCycle();
+    std::printf("QueueSyncTest passed\n");
+    return 0;
+}
@@ -0,0 +1,199 @@
+#include "TestSupport.h"
+#include "../Rendering/RenderGraph.h"
+#include <string>
+#include <vector>
+
+static RGTextureDesc MakeDesc(uint32_t width, uint32_t height)
+{
+    RGTextureDesc desc;
+    desc.width = width;
+    desc.height = height;
+    return desc;
+}
+
+static int CountBarriers(const std::vector<RGBarrier>& barriers, uint32_t resource, RGBarrierType type)
+{
+    int count = 0;
+    for (const RGBarrier& barrier : barriers)
+        if (barrier.resource == resource && barrier.type == type)
+            ++count;
+    return count;
+}
+
+// A pass that writes an imported resource stays, even when the transient it also
+// writes loses its only reader to culling
+static void TestCulling()
+{
+    RenderGraph graph;
+    const RGResourceHandle backBuffer = graph.ImportTexture("BackBuffer", MakeDesc(64, 64), RGState::Present, RGState::Present, nullptr);
+    const RGResourceHandle temp = graph.CreateTexture("Temp", MakeDesc(64, 64));
+    const RGResourceHandle unused = graph.CreateTexture("Unused", MakeDesc(64, 64));
+
+    const uint32_t a = graph.AddPass("A", [&](RGPassBuilder& builder) {
+        builder.Write(backBuffer);
+        builder.Write(temp);
+    }, nullptr);
+    const uint32_t b = graph.AddPass("B", [&](RGPassBuilder& builder) { builder.Read(temp); }, nullptr);
+    // Feeds only C, which feeds nothing: both go
+    const uint32_t producer = graph.AddPass("Producer", [&](RGPassBuilder& builder) { builder.Write(unused); }, nullptr);
+    const uint32_t c = graph.AddPass("C", [&](RGPassBuilder& builder) { builder.Read(unused); }, nullptr);
+    const uint32_t readback = graph.AddPass("Readback", [&](RGPassBuilder& builder) {
+        builder.Read(backBuffer, RGState::CopySource);
+        builder.SetSideEffects();
+    }, nullptr);
+
+    CHECK(graph.Compile());
+    CHECK(!graph.IsPassCulled(a));
+    CHECK(graph.IsPassCulled(b));
+    CHECK(graph.IsPassCulled(producer));
+    CHECK(graph.IsPassCulled(c));
+    CHECK(!graph.IsPassCulled(readback));
+    CHECK(graph.GetStats().culledPassCount == 3);
+    CHECK(graph.IsTransientLive(temp.index) && !graph.IsTransientLive(unused.index));
+
+    // A chain ending in a marked output survives with nothing else reading it
+    RenderGraph chain;
+    const RGResourceHandle first = chain.CreateTexture("First", MakeDesc(64, 64));
+    const RGResourceHandle second = chain.CreateTexture("Second", MakeDesc(64, 64));
+    chain.MarkOutput(second);
+    chain.AddPass("Write", [&](RGPassBuilder& builder) { builder.Write(first); }, nullptr);
+    chain.AddPass("Copy", [&](RGPassBuilder& builder) {
+        builder.Read(first);
+        builder.Write(second);
+    }, nullptr);
+    CHECK(chain.Compile());
+    CHECK(chain.GetStats().culledPassCount == 0);
+
+    // Reading a transient nobody wrote is a validation error
+    RenderGraph invalid;
+    const RGResourceHandle never = invalid.CreateTexture("Never", MakeDesc(64, 64));
+    invalid.AddPass("Read", [&](RGPassBuilder& builder) {
+        builder.Read(never);
+        builder.SetSideEffects();
+    }, nullptr);
+    CHECK(!invalid.Compile());
+    CHECK(invalid.GetErrors().size() == 1);
+}
+
+// Each pass gets its barriers in one batch, and a run of reads in different
+// read-only states costs one transition into their combined state
+static void TestBarrierBatching()
+{
+    RenderGraph graph;
+    const RGResourceHandle backBuffer = graph.ImportTexture("BackBuffer", MakeDesc(64, 64), RGState::Present, RGState::Present, nullptr);
+    const RGResourceHandle color = graph.CreateTexture("Color", MakeDesc(64, 64));
+    RGTextureDesc depthDesc = MakeDesc(64, 64);
+    depthDesc.isDepth = true;
+    const RGResourceHandle depth = graph.CreateTexture("Depth", depthDesc);
+    const RGResourceHandle lit = graph.CreateTexture("Lit", MakeDesc(64, 64));
+
+    const uint32_t gbuffer = graph.AddPass("GBuffer", [&](RGPassBuilder& builder) {
+        builder.Write(color);
+        builder.Write(depth, RGState::DepthWrite);
+    }, nullptr);
+    const uint32_t lighting = graph.AddPass("Lighting", [&](RGPassBuilder& builder) {
+        builder.Read(color);
+        builder.Read(depth, RGState::DepthRead);
+        builder.Write(lit);
+    }, nullptr);
+    const uint32_t post = graph.AddPass("Post", [&](RGPassBuilder& builder) {
+        builder.Read(lit);
+        builder.Read(depth);
+        builder.Write(backBuffer);
+    }, nullptr);
+    CHECK(graph.Compile());
+
+    const std::vector<RGBarrier>& gbufferBarriers = graph.GetPassBarriers(gbuffer);
+    CHECK(gbufferBarriers.size() == 2);
+    CHECK(gbufferBarriers[0].resource == color.index && gbufferBarriers[0].after == RGState::RenderTarget);
+    CHECK(gbufferBarriers[1].resource == depth.index && gbufferBarriers[1].after == RGState::DepthWrite);
+
+    const std::vector<RGBarrier>& lightingBarriers = graph.GetPassBarriers(lighting);
+    CHECK(lightingBarriers.size() == 3);
+    CHECK(CountBarriers(lightingBarriers, depth.index, RGBarrierType::Transition) == 1);
+    for (const RGBarrier& barrier : lightingBarriers) {
+        if (barrier.resource == depth.index) {
+            CHECK(barrier.before == RGState::DepthWrite);
+            CHECK(barrier.after == (RGState::DepthRead | RGState::ShaderResource));
+        }
+    }
+
+    // Depth is already readable as a shader resource
+    const std::vector<RGBarrier>& postBarriers = graph.GetPassBarriers(post);
+    CHECK(postBarriers.size() == 2);
+    CHECK(CountBarriers(postBarriers, depth.index, RGBarrierType::Transition) == 0);
+    CHECK(CountBarriers(postBarriers, backBuffer.index, RGBarrierType::Transition) == 1);
+
+    const std::vector<RGBarrier>& finalBarriers = graph.GetFinalBarriers();
+    CHECK(finalBarriers.size() == 1);
+    CHECK(finalBarriers[0].before == RGState::RenderTarget && finalBarriers[0].after == RGState::Present);
+
+    const RenderGraphStats& stats = graph.GetStats();
+    CHECK(stats.barrierCount == 8);
+    CHECK(stats.barrierBatchCount == 4);
+
+    // Back-to-back UAV writes need a UAV barrier, not a transition
+    RenderGraph compute;
+    const RGResourceHandle buffer = compute.CreateTexture("Buffer", MakeDesc(64, 64));
+    compute.MarkOutput(buffer);
+    compute.AddPass("First", [&](RGPassBuilder& builder) { builder.Write(buffer, RGState::UnorderedAccess); }, nullptr);
+    const uint32_t second = compute.AddPass("Second", [&](RGPassBuilder& builder) { builder.Write(buffer, RGState::UnorderedAccess); }, nullptr);
+    CHECK(compute.Compile());
+    CHECK(compute.GetPassBarriers(second).size() == 1);
+    CHECK(compute.GetPassBarriers(second)[0].type == RGBarrierType::UAV);
+}
+
+// A chain of same-sized transients where each lives for two passes: every other
+// one can share memory, so the heap holds two instead of four
+static void TestAliasing()
+{
+    RenderGraph graph;
+    const RGResourceHandle backBuffer = graph.ImportTexture("BackBuffer", MakeDesc(256, 256), RGState::Present, RGState::Present, nullptr);
+    std::vector<RGResourceHandle> chain;
+    for (int i = 0; i < 4; ++i)
+        chain.push_back(graph.CreateTexture("T" + std::to_string(i), MakeDesc(256, 256)));
+
+    std::vector<uint32_t> passes;
+    for (int i = 0; i <= 4; ++i) {
+        passes.push_back(graph.AddPass("P" + std::to_string(i), [&](RGPassBuilder& builder) {
+            if (i > 0)
+                builder.Read(chain[i - 1]);
+            builder.Write(i < 4 ? chain[i] : backBuffer);
+        }, nullptr));
+    }
+    CHECK(graph.Compile());
+
+    const uint64_t size = 256 * 256 * 4;
+    const RenderGraphStats& stats = graph.GetStats();
+    CHECK(stats.transientCount == 4);
+    CHECK(stats.transientBytes == 4 * size);
+    CHECK(stats.aliasedHeapBytes == 2 * size);
+    CHECK(stats.GetBytesSaved() == 2 * size);
+    CHECK(graph.GetTransientHeapSize() == 2 * size);
+
+    // Overlapping lifetimes never share memory
+    for (int i = 0; i < 3; ++i) {
+        const uint64_t a = graph.GetTransientOffset(chain[i].index);
+        const uint64_t b = graph.GetTransientOffset(chain[i + 1].index);
+        CHECK(a + size <= b || b + size <= a);
+    }
+
+    // T2 takes over T0's memory, T3 takes over T1's
+    CHECK(graph.GetTransientOffset(chain[2].index) == graph.GetTransientOffset(chain[0].index));
+    CHECK(graph.GetTransientOffset(chain[3].index) == graph.GetTransientOffset(chain[1].index));
+    const std::vector<RGBarrier>& barriers = graph.GetPassBarriers(passes[2]);
+    CHECK(CountBarriers(barriers, chain[2].index, RGBarrierType::Aliasing) == 1);
+    for (const RGBarrier& barrier : barriers)
+        if (barrier.type == RGBarrierType::Aliasing)
+            CHECK(barrier.aliasBefore == chain[0].index);
+    CHECK(CountBarriers(graph.GetPassBarriers(passes[0]), chain[0].index, RGBarrierType::Aliasing) == 0);
+}
+
+int main()
+{
+    TestCulling();
+    TestBarrierBatching();
+    TestAliasing();
+    std::printf("RenderGraphTest passed\n");
+    return 0;
+}
@@ -0,0 +1,212 @@
+#include "TestSupport.h"
+#include "../Scene/MeshBvh.h"
+#include "../Scene/SceneBvh.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Mirror of the proxies the tree should hold, queried by brute force
+struct ProxyMirror {
+    SceneBvh bvh;
+    std::vector<SceneBvh::ProxyId> alive;
+    std::mt19937 rng{ 21 };
+
+    float Uniform(float low, float high) { return std::uniform_real_distribution<float>(low, high)(rng); }
+
+    Aabb RandomBox(float extentMax = 3.0f)
+    {
+        const float center[3] = { Uniform(-50.0f, 50.0f), Uniform(-50.0f, 50.0f), Uniform(-50.0f, 50.0f) };
+        const float extents[3] = { Uniform(0.2f, extentMax), Uniform(0.2f, extentMax), Uniform(0.2f, extentMax) };
+        return Aabb::FromCenterExtents(center, extents);
+    }
+
+    void Create(uint32_t count, bool isStatic)
+    {
+        for (uint32_t i = 0; i < count; ++i) {
+            const SceneBvh::ProxyId proxy = bvh.CreateProxy(RandomBox(), i, isStatic);
+            CHECK(std::find(alive.begin(), alive.end(), proxy) == alive.end());
+            alive.push_back(proxy);
+        }
+    }
+
+    // Removes every 'stride'-th proxy
+    void Destroy(uint32_t stride)
+    {
+        std::vector<SceneBvh::ProxyId> kept;
+        for (size_t i = 0; i < alive.size(); ++i) {
+            if (i % stride == 0) {
+                bvh.DestroyProxy(alive[i]);
+                CHECK(!bvh.IsValid(alive[i]));
+            } else {
+                kept.push_back(alive[i]);
+            }
+        }
+        alive.swap(kept);
+    }
+};
+
+static std::vector<SceneBvh::ProxyId> Sorted(std::vector<SceneBvh::ProxyId> proxies)
+{
+    std::sort(proxies.begin(), proxies.end());
+    return proxies;
+}
+
+// Perspective camera at 'eye' looking down +z, row-major, clip = m * float4(p, 1)
+static Frustum MakeCameraFrustum(const float eye[3], float fovY)
+{
+    const float f = 1.0f / std::tan(fovY * 0.5f);
+    const float zNear = 0.5f, zFar = 60.0f;
+    const float a = zFar / (zFar - zNear);
+    const float b = -zNear * zFar / (zFar - zNear);
+    const float m[16] = { f / 1.5f, 0, 0, -f / 1.5f * eye[0], 0, f, 0, -f * eye[1], 0, 0, a, b - a * eye[2], 0, 0, 1, -eye[2] };
+    return MakeFrustum(m);
+}
+
+// The test SceneBvh documents: not entirely outside any one plane
+static bool IsBoxInFrustum(const Frustum& frustum, const Aabb& box)
+{
+    for (const float* plane : frustum.planes) {
+        const float x = plane[0] >= 0.0f ? box.max[0] : box.min[0];
+        const float y = plane[1] >= 0.0f ? box.max[1] : box.min[1];
+        const float z = plane[2] >= 0.0f ? box.max[2] : box.min[2];
+        if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+// Every query kind against a linear scan of the live proxies
+static void CheckAgainstBruteForce(ProxyMirror& mirror)
+{
+    const SceneBvh& bvh = mirror.bvh;
+    for (int query = 0; query < 50; ++query) {
+        const Aabb box = mirror.RandomBox(15.0f);
+        std::vector<SceneBvh::ProxyId> found, expected;
+        bvh.QueryAabb(box, [&](SceneBvh::ProxyId proxy) { found.push_back(proxy); });
+        for (SceneBvh::ProxyId proxy : mirror.alive)
+            if (bvh.GetBounds(proxy).Overlaps(box))
+                expected.push_back(proxy);
+        CHECK(Sorted(found) == Sorted(expected));
+    }
+
+    for (int query = 0; query < 20; ++query) {
+        const float eye[3] = { mirror.Uniform(-40.0f, 40.0f), mirror.Uniform(-20.0f, 20.0f), mirror.Uniform(-80.0f, 0.0f) };
+        const Frustum frustum = MakeCameraFrustum(eye, mirror.Uniform(0.3f, 1.5f));
+        std::vector<SceneBvh::ProxyId> found, expected;
+        bvh.QueryFrustum(frustum, [&](SceneBvh::ProxyId proxy) { found.push_back(proxy); });
+        for (SceneBvh::ProxyId proxy : mirror.alive)
+            if (IsBoxInFrustum(frustum, bvh.GetBounds(proxy)))
+                expected.push_back(proxy);
+        CHECK(Sorted(found) == Sorted(expected));
+    }
+
+    uint32_t hits = 0;
+    for (int query = 0; query < 200; ++query) {
+        const float origin[3] = { mirror.Uniform(-60.0f, 60.0f), mirror.Uniform(-60.0f, 60.0f), mirror.Uniform(-60.0f, 60.0f) };
+        const float direction[3] = { mirror.Uniform(-1.0f, 1.0f), mirror.Uniform(-1.0f, 1.0f), mirror.Uniform(-1.0f, 1.0f) };
+        const Ray ray(origin, direction, 150.0f);
+        float closest = ray.maxT;
+        bool expectedHit = false;
+        for (SceneBvh::ProxyId proxy : mirror.alive) {
+            float enter;
+            if (IntersectRayAabb(ray, bvh.GetBounds(proxy), closest, enter)) {
+                closest = enter;
+                expectedHit = true;
+            }
+        }
+
+        float t = 0.0f;
+        const SceneBvh::ProxyId hit = bvh.RayCast(ray, t);
+        CHECK((hit != SceneBvh::INVALID_PROXY) == expectedHit);
+        if (!expectedHit)
+            continue;
+        // Ties are allowed to go either way, but the distance is exact
+        float enter;
+        CHECK(t == closest && bvh.IsValid(hit));
+        CHECK(IntersectRayAabb(ray, bvh.GetBounds(hit), ray.maxT, enter) && enter == closest);
+        ++hits;
+    }
+    CHECK(mirror.alive.empty() ? hits == 0 : hits > 20);
+}
+
+// Static and dynamic proxies through build, refit, moves, inserts and removals
+static void TestMatchesBruteForce()
+{
+    ProxyMirror mirror;
+    mirror.Create(400, true);
+    mirror.Create(400, false);
+    mirror.bvh.Update();
+    CHECK(mirror.bvh.GetStats().staticProxies == 400 && mirror.bvh.GetStats().dynamicProxies == 400);
+    CHECK(mirror.bvh.GetStats().rebuilds == 1);
+    CheckAgainstBruteForce(mirror);
+
+    // Static moves refit the tree in place, some of them far from where they were
+    for (size_t i = 0; i < 400; i += 3) {
+        Aabb box = mirror.bvh.GetBounds(mirror.alive[i]);
+        const float offset = i % 2 ? 0.5f : 40.0f;
+        for (int axis = 0; axis < 3; ++axis) {
+            box.min[axis] -= offset;
+            box.max[axis] -= offset;
+        }
+        mirror.bvh.MoveProxy(mirror.alive[i], box);
+    }
+    mirror.bvh.Update();
+    CHECK(mirror.bvh.GetStats().refits == 1 && mirror.bvh.GetStats().rebuilds == 1);
+    CheckAgainstBruteForce(mirror);
+
+    // Dynamic moves inside the margin stay put; the rest are reinserted
+    for (size_t i = 400; i < 800; ++i) {
+        Aabb box = mirror.bvh.GetBounds(mirror.alive[i]);
+        const float offset = i % 4 ? SceneBvh::DYNAMIC_MARGIN * 0.5f : 25.0f;
+        box.min[0] += offset;
+        box.max[0] += offset;
+        mirror.bvh.MoveProxy(mirror.alive[i], box);
+    }
+    CHECK(mirror.bvh.GetStats().reinserts == 100);
+    CheckAgainstBruteForce(mirror);
+
+    // Inserts, then removals; destroyed ids are never reported again
+    mirror.Create(150, false);
+    mirror.Create(150, true);
+    mirror.bvh.Update();
+    CHECK(mirror.bvh.GetStats().rebuilds == 2);
+    CheckAgainstBruteForce(mirror);
+    mirror.Destroy(5);
+    mirror.bvh.Update();
+    CheckAgainstBruteForce(mirror);
+    const SceneBvh::Stats stats = mirror.bvh.GetStats();
+    CHECK(stats.staticProxies + stats.dynamicProxies == mirror.alive.size());
+    CHECK(stats.dynamicHeight < 40);
+
+    // Everything gone: queries find nothing
+    for (SceneBvh::ProxyId proxy : mirror.alive)
+        mirror.bvh.DestroyProxy(proxy);
+    mirror.alive.clear();
+    mirror.bvh.Update();
+    CheckAgainstBruteForce(mirror);
+}
+
+// Out-of-range indices are refused in every build rather than read through
+static void TestMeshIndexValidation()
+{
+    const float positions[12] = { 0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0 };
+    const uint32_t indices[6] = { 0, 1, 2, 1, 3, 2 };
+    MeshBvh bvh;
+    CHECK(bvh.Build(positions, 12, 4, indices, 6));
+    CHECK(!bvh.IsEmpty() && bvh.GetTriangleCount() == 2);
+
+    const uint32_t bad[6] = { 0, 1, 2, 1, 4, 2 };
+    CHECK(!bvh.Build(positions, 12, 4, bad, 6));
+    CHECK(bvh.IsEmpty() && bvh.GetTriangleCount() == 0);
+    // A trailing partial triangle is ignored, index and all
+    CHECK(bvh.Build(positions, 12, 4, bad, 4) && bvh.GetTriangleCount() == 1);
+}
+
+int main()
+{
+    TestMatchesBruteForce();
+    TestMeshIndexValidation();
+    std::printf("SceneBvhTest passed\n");
+    return 0;
+}
@@ -0,0 +1,214 @@
+#include "TestSupport.h"
+#include "../Core/Hash.h"
+#include "../Scene/Components.h"
+#include "../Scene/SceneSerializer.h"
+#include "../Scene/World.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+struct TagComponent {
+    static constexpr const char* COMPONENT_NAME = "Test.Tag";
+    int value = 7;
+};
+
+static std::string ScenePath(const char* name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static std::vector<char> ReadBytes(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void WriteBytes(const std::string& path, const std::vector<char>& bytes)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+// Three archetypes, several chunks each
+static void BuildScene(World& world, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        TransformComponent transform;
+        transform.position[0] = float(i);
+        transform.position[1] = float(i % 17);
+        if (i % 3 == 0) {
+            world.Create(transform);
+        } else if (i % 3 == 1) {
+            BoundsComponent bounds;
+            bounds.center[0] = float(i);
+            world.Create(transform, bounds);
+        } else {
+            RenderableComponent renderable;
+            renderable.mesh = i;
+            world.Create(transform, renderable, TagComponent{ i });
+        }
+    }
+}
+
+// Like HashWorldState without the entity handles, which a load hands out anew
+static uint64_t HashComponents(World& world)
+{
+    uint64_t hash = HASH_SEED;
+    for (const std::unique_ptr<Archetype>& archetype : world.GetArchetypes()) {
+        if (archetype->GetEntityCount() == 0)
+            continue;
+        const ComponentMask mask = archetype->GetMask();
+        hash = HashBytes(&mask, sizeof(mask), hash);
+        for (uint32_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk) {
+            const uint32_t count = archetype->GetChunkEntityCount(chunk);
+            for (ComponentId id : archetype->GetComponents())
+                hash = HashBytes(archetype->GetColumn(chunk, id), size_t(count) * ComponentRegistry::Get(id).size, hash);
+        }
+    }
+    return hash;
+}
+
+static uint64_t HashLoaded(const std::string& path)
+{
+    World world;
+    SceneSerializer serializer;
+    CHECK(serializer.Load(world, path));
+    return HashComponents(world);
+}
+
+static void TestRoundTrip()
+{
+    const std::string path = ScenePath("CalderaSceneRoundTrip.cscene");
+    World world;
+    BuildScene(world, 3000);
+    SceneSerializer serializer;
+    CHECK(serializer.Save(world, path));
+    CHECK(!serializer.GetLastSaveStats().incremental);
+
+    World loaded;
+    SceneSerializer reader;
+    CHECK(reader.Load(loaded, path));
+    CHECK(loaded.GetEntityCount() == 3000);
+    CHECK(HashComponents(loaded) == HashComponents(world));
+    int tagged = 0;
+    loaded.ForEach<const TagComponent, const RenderableComponent>([&](Entity, const TagComponent& tag, const RenderableComponent& renderable) {
+        CHECK(uint32_t(tag.value) == renderable.mesh);
+        ++tagged;
+    });
+    CHECK(tagged == 1000);
+
+    // Loading replaces what the world held
+    World occupied;
+    occupied.Create(TransformComponent{});
+    CHECK(reader.Load(occupied, path));
+    CHECK(occupied.GetEntityCount() == 3000);
+
+    World empty;
+    CHECK(serializer.Save(empty, path));
+    CHECK(reader.Load(loaded, path));
+    CHECK(loaded.GetEntityCount() == 0);
+    std::filesystem::remove(path);
+}
+
+static void TestIncrementalSave()
+{
+    const std::string path = ScenePath("CalderaSceneIncremental.cscene");
+    World world;
+    BuildScene(world, 3000);
+    SceneSerializer serializer;
+    CHECK(serializer.Save(world, path));
+
+    CHECK(serializer.Save(world, path));
+    CHECK(serializer.GetLastSaveStats().incremental);
+    CHECK(serializer.GetLastSaveStats().chunksWritten == 0);
+
+    int visited = 0;
+    world.ForEach<TransformComponent>([&](Entity, TransformComponent& transform) {
+        if (visited++ == 5)
+            transform.position[2] = 42.0f;
+    });
+    CHECK(serializer.Save(world, path));
+    CHECK(serializer.GetLastSaveStats().incremental);
+    CHECK(serializer.GetLastSaveStats().chunksWritten == 1);
+    CHECK(HashLoaded(path) == HashComponents(world));
+
+    // A serializer that loaded the file saves over it incrementally too
+    World loaded;
+    SceneSerializer reader;
+    CHECK(reader.Load(loaded, path));
+    loaded.ForEach<TransformComponent>([&](Entity, TransformComponent& transform) { transform.scale[0] = 2.0f; });
+    CHECK(reader.Save(loaded, path));
+    CHECK(reader.GetLastSaveStats().incremental);
+    CHECK(HashLoaded(path) == HashComponents(loaded));
+
+    // Someone else rewrote the file since: same size, different bytes. The next
+    // save can't trust the slots it didn't write and rewrites them all.
+    std::vector<char> bytes = ReadBytes(path);
+    WriteBytes(path, std::vector<char>(bytes.size(), 0));
+    std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::seconds(1));
+    CHECK(reader.Save(loaded, path));
+    CHECK(!reader.GetLastSaveStats().incremental);
+    CHECK(HashLoaded(path) == HashComponents(loaded));
+
+    // So does a change in the chunk layout
+    loaded.Create(TransformComponent{});
+    CHECK(reader.Save(loaded, path));
+    CHECK(HashLoaded(path) == HashComponents(loaded));
+    std::filesystem::remove(path);
+}
+
+static void TestCorruptFiles()
+{
+    const std::string path = ScenePath("CalderaSceneCorrupt.cscene");
+    const std::string corruptPath = ScenePath("CalderaSceneCorrupt.tmp.cscene");
+    World world;
+    BuildScene(world, 1000);
+    SceneSerializer serializer;
+    CHECK(serializer.Save(world, path));
+    const uint64_t expected = HashComponents(world);
+    const std::vector<char> bytes = ReadBytes(path);
+
+    // A flipped byte either fails the load, leaving the world as it was, or sits
+    // in padding and loads the same scene. It never loads something else.
+    int rejected = 0;
+    int flips = 0;
+    for (size_t offset = 0; offset < bytes.size(); offset += offset < 4096 ? 1 : 61, ++flips) {
+        std::vector<char> corrupt = bytes;
+        corrupt[offset] ^= 0x5a;
+        WriteBytes(corruptPath, corrupt);
+
+        World loaded;
+        loaded.Create(TransformComponent{});
+        SceneSerializer reader;
+        if (!reader.Load(loaded, corruptPath)) {
+            CHECK(loaded.GetEntityCount() == 1);
+            ++rejected;
+        } else {
+            CHECK(HashComponents(loaded) == expected);
+        }
+    }
+    CHECK(rejected > 0);
+
+    std::vector<char> truncated(bytes.begin(), bytes.begin() + bytes.size() / 2);
+    WriteBytes(corruptPath, truncated);
+    World loaded;
+    SceneSerializer reader;
+    CHECK(!reader.Load(loaded, corruptPath));
+    CHECK(!reader.Load(loaded, ScenePath("CalderaSceneMissing.cscene")));
+
+    std::printf("%d of %d single-byte corruptions rejected, the rest in padding\n", rejected, flips);
+    std::filesystem::remove(path);
+    std::filesystem::remove(corruptPath);
+}
+
+int main()
+{
+    RegisterCoreComponents();
+    TestRoundTrip();
+    TestIncrementalSave();
+    TestCorruptFiles();
+    std::printf("SceneSerializerTest passed\n");
+    return 0;
+}
@@ -0,0 +1,219 @@
+#include "TestSupport.h"
+#include "../Rendering/ShaderLibrary.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// "Bytecode" made of the entry point, defines and the hash of every file the
+// shader reads, so it changes exactly when a real compile's output would
+class FakeShaderCompiler : public IShaderCompiler {
+public:
+    explicit FakeShaderCompiler(std::string id) : id(std::move(id)) {}
+
+    const std::string& GetId() const override { return id; }
+    bool Compile(const ShaderDesc& desc, const std::string& source, const std::vector<std::string>& includeDirs,
+        std::vector<uint8_t>& outBytecode, std::string& outErrors) override
+    {
+        ++compiles;
+        if (source.find("syntax error") != std::string::npos) {
+            outErrors = "syntax error";
+            return false;
+        }
+        ShaderDependencies dependencies;
+        if (!ScanShaderDependencies(desc.path, includeDirs, dependencies, outErrors))
+            return false;
+        const std::string text = desc.entryPoint + "|" + MakeDefineString(desc.defines) + "|" + std::to_string(dependencies.contentHash);
+        outBytecode.assign(text.begin(), text.end());
+        return true;
+    }
+
+    uint32_t compiles = 0;
+
+private:
+    std::string id;
+};
+
+static fs::path Root()
+{
+    return fs::temp_directory_path() / "CalderaShaderLibraryTest";
+}
+
+// Writes the file and moves its timestamp on, so an edit is seen however coarse the file system clock
+static void WriteFile(const fs::path& path, const std::string& contents)
+{
+    static int edits = 0;
+    fs::create_directories(path.parent_path());
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+    fs::last_write_time(path, fs::file_time_type::clock::now() + std::chrono::seconds(++edits));
+}
+
+static void WriteSources()
+{
+    fs::remove_all(Root());
+    WriteFile(Root() / "Shaders/Mesh.hlsl", "#include \"Common.hlsli\"\nfloat4 main() : SV_Target { return Shade(); }\n");
+    WriteFile(Root() / "Shaders/Common.hlsli", "#pragma once\n  #  include <Lighting.hlsli>\n");
+    WriteFile(Root() / "Include/Lighting.hlsli", "float4 Shade() { return 1; }\n");
+    WriteFile(Root() / "Shaders/Unrelated.hlsli", "// not included\n");
+}
+
+static ShaderDesc MeshDesc(std::vector<ShaderDefine> defines = {})
+{
+    return { (Root() / "Shaders/Mesh.hlsl").string(), "main", "ps_6_0", std::move(defines) };
+}
+
+// Defines in any order, and paths spelled differently, name the same permutation
+static void TestPermutationKeys()
+{
+    CHECK(MakeDefineString({ { "B", "1" }, { "A", "0" } }) == "A=0;B=1");
+    CHECK(MakeDefineString({ { "A", "0" }, { "B", "1" } }) == "A=0;B=1");
+    CHECK(MakeDefineString({}).empty());
+
+    ShaderPermutationSpace space;
+    CHECK(space.AddOption("SKINNED") == 0);
+    CHECK(space.AddOption("QUALITY", 3) == 1);
+    CHECK(space.GetPermutationCount() == 6);
+    for (uint32_t index = 0; index < space.GetPermutationCount(); ++index) {
+        const std::vector<ShaderDefine> defines = space.GetDefines(index);
+        const uint32_t values[2] = { uint32_t(std::stoul(defines[0].value)), uint32_t(std::stoul(defines[1].value)) };
+        CHECK(space.GetPermutationIndex(values) == index);
+    }
+    const uint32_t values[2] = { 1, 2 };
+    CHECK(space.GetPermutationIndex(values) == 5);
+
+    const ShaderDesc forward = MeshDesc({ { "SKINNED", "1" }, { "QUALITY", "2" } });
+    const ShaderDesc reversed = MeshDesc({ { "QUALITY", "2" }, { "SKINNED", "1" } });
+    CHECK(MakeShaderCacheKey(forward, 42, "dxc") == MakeShaderCacheKey(reversed, 42, "dxc"));
+    CHECK(MakeShaderCacheKey(forward, 42, "dxc") != MakeShaderCacheKey(MeshDesc({ { "SKINNED", "0" }, { "QUALITY", "2" } }), 42, "dxc"));
+    CHECK(MakeShaderCacheKey(forward, 42, "dxc") != MakeShaderCacheKey(forward, 43, "dxc"));
+    CHECK(MakeShaderCacheKey(forward, 42, "dxc") != MakeShaderCacheKey(forward, 42, "dxc-1.8"));
+
+    WriteSources();
+    FakeShaderCompiler compiler("fake-1");
+    ShaderLibrary library;
+    CHECK(library.Initialize(&compiler, (Root() / "Cache").string(), { (Root() / "Include").string() }));
+    const ShaderHandle handle = library.Load(forward);
+    CHECK(handle.IsValid());
+    CHECK(library.Load(reversed).index == handle.index);
+    ShaderDesc respelled = forward;
+    respelled.path = (Root() / "Shaders/../Shaders/./Mesh.hlsl").string();
+    CHECK(library.Load(respelled).index == handle.index);
+    CHECK(compiler.compiles == 1);
+
+    // Every permutation ahead of time, then each one loads from the cache
+    CHECK(library.Precompile(MeshDesc().path, "main", "ps_6_0", space) == 0);
+    CHECK(compiler.compiles == 6);
+    for (uint32_t index = 0; index < space.GetPermutationCount(); ++index)
+        CHECK(library.Load(MeshDesc(space.GetDefines(index))).IsValid());
+    CHECK(compiler.compiles == 6);
+}
+
+// An edit anywhere in the include graph rebuilds the shader; edits elsewhere don't
+static void TestIncludeInvalidation()
+{
+    WriteSources();
+    FakeShaderCompiler compiler("fake-1");
+    ShaderLibrary library;
+    CHECK(library.Initialize(&compiler, (Root() / "Cache").string(), { (Root() / "Include").string() }));
+    const ShaderHandle handle = library.Load(MeshDesc());
+    CHECK(handle.IsValid() && library.GetVersion(handle) == 0);
+    CHECK(library.PollChanges().empty());
+
+    // Source, then include, then the include's include from the include directory
+    WriteFile(Root() / "Shaders/Unrelated.hlsli", "// still not included\n");
+    CHECK(library.PollChanges().empty());
+    WriteFile(Root() / "Include/Lighting.hlsli", "float4 Shade() { return 0.5; }\n");
+    std::vector<ShaderHandle> reloaded = library.PollChanges();
+    CHECK(reloaded.size() == 1 && reloaded[0].index == handle.index);
+    CHECK(library.GetVersion(handle) == 1);
+
+    // A new include joins the graph and is watched from then on
+    WriteFile(Root() / "Shaders/Common.hlsli", "#include <Lighting.hlsli>\n#include \"Unrelated.hlsli\"\n");
+    CHECK(library.PollChanges().size() == 1 && library.GetVersion(handle) == 2);
+    WriteFile(Root() / "Shaders/Unrelated.hlsli", "// now included\n");
+    CHECK(library.PollChanges().size() == 1 && library.GetVersion(handle) == 3);
+
+    // A broken edit keeps the old bytecode and is retried on the next save
+    const std::vector<uint8_t> working = library.GetBytecode(handle);
+    WriteFile(Root() / "Shaders/Mesh.hlsl", "#include \"Common.hlsli\"\nsyntax error\n");
+    CHECK(library.PollChanges().empty());
+    CHECK(library.GetBytecode(handle) == working && library.GetVersion(handle) == 3);
+    CHECK(library.GetLastError().find("syntax error") != std::string::npos);
+    CHECK(library.PollChanges().empty());
+    WriteFile(Root() / "Shaders/Mesh.hlsl", "#include \"Common.hlsli\"\nfloat4 main() : SV_Target { return Shade() * 2; }\n");
+    CHECK(library.PollChanges().size() == 1 && library.GetVersion(handle) == 4);
+
+    // Touched without a change: rebuilt from the cache, but nothing to reload
+    WriteFile(Root() / "Include/Lighting.hlsli", "float4 Shade() { return 0.5; }\n");
+    const uint32_t compiles = compiler.compiles;
+    CHECK(library.PollChanges().empty());
+    CHECK(compiler.compiles == compiles && library.GetVersion(handle) == 4);
+}
+
+// Hits and misses follow file contents and the compiler id, not timestamps
+static void TestCacheByContent()
+{
+    WriteSources();
+    const std::string cacheDir = (Root() / "Cache").string();
+    const std::vector<std::string> includeDirs = { (Root() / "Include").string() };
+    std::vector<uint8_t> original;
+    {
+        FakeShaderCompiler compiler("fake-1");
+        ShaderLibrary library;
+        CHECK(library.Initialize(&compiler, cacheDir, includeDirs));
+        original = library.GetBytecode(library.Load(MeshDesc()));
+        CHECK(library.GetStats().compiles == 1 && library.GetStats().cacheHits == 0);
+    }
+    {
+        // A new session: same contents, so a hit
+        FakeShaderCompiler compiler("fake-1");
+        ShaderLibrary library;
+        CHECK(library.Initialize(&compiler, cacheDir, includeDirs));
+        CHECK(library.GetBytecode(library.Load(MeshDesc())) == original);
+        CHECK(library.GetStats().cacheHits == 1 && compiler.compiles == 0);
+
+        // An include edited: a miss
+        WriteFile(Root() / "Include/Lighting.hlsli", "float4 Shade() { return 0.25; }\n");
+        CHECK(library.Load(MeshDesc({ { "VARIANT", "1" } })).IsValid());
+        CHECK(compiler.compiles == 1);
+    }
+    {
+        // Edited back, timestamp newer than ever: a hit on the original entry
+        WriteFile(Root() / "Include/Lighting.hlsli", "float4 Shade() { return 1; }\n");
+        FakeShaderCompiler compiler("fake-1");
+        ShaderLibrary library;
+        CHECK(library.Initialize(&compiler, cacheDir, includeDirs));
+        CHECK(library.GetBytecode(library.Load(MeshDesc())) == original);
+        CHECK(compiler.compiles == 0);
+    }
+    {
+        // Without a compiler, only what the cache holds loads
+        ShaderLibrary library;
+        CHECK(library.Initialize(nullptr, cacheDir, includeDirs));
+        CHECK(library.GetBytecode(library.Load(MeshDesc())) == original);
+        CHECK(!library.Load(MeshDesc({ { "NEVER_BUILT", "1" } })).IsValid());
+        CHECK(library.GetStats().failures == 1);
+    }
+    {
+        // A different compiler misses everything the old one built
+        FakeShaderCompiler compiler("fake-2");
+        ShaderLibrary library;
+        CHECK(library.Initialize(&compiler, cacheDir, includeDirs));
+        CHECK(library.Load(MeshDesc()).IsValid());
+        CHECK(compiler.compiles == 1 && library.GetStats().cacheHits == 0);
+    }
+}
+
+int main()
+{
+    TestPermutationKeys();
+    TestIncludeInvalidation();
+    TestCacheByContent();
+    fs::remove_all(Root());
+    std::printf("ShaderLibraryTest passed\n");
+    return 0;
+}
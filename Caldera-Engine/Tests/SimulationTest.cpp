@@ -0,0 +1,148 @@
+#include "TestSupport.h"
+#include "../Scene/Components.h"
+#include "../Scene/Simulation.h"
+#include "../Scene/World.h"
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+static void Populate(World& world, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        TransformComponent transform;
+        transform.position[0] = float(i);
+        if (i % 2)
+            world.Create(transform, RenderableComponent());
+        else
+            world.Create(transform, RenderableComponent(), BoundsComponent());
+    }
+    // Not drawn, so never in a snapshot
+    world.Create(TransformComponent());
+}
+
+// Moves every renderable up at one unit per second and turns it about z
+static void Move(World& world, float dt)
+{
+    world.ForEach<TransformComponent, const RenderableComponent>([&](Entity, TransformComponent& transform, const RenderableComponent&) {
+        transform.position[1] += dt;
+        transform.rotation[2] = std::sin(transform.position[1]);
+        transform.rotation[3] = std::cos(transform.position[1]);
+    });
+}
+
+// The same scene, edits and step count, headless
+static uint64_t RunHeadless(int steps)
+{
+    World world;
+    Populate(world, 3000);
+    Simulation simulation;
+    simulation.AddSystem(Move);
+    std::vector<Entity> spawned;
+    for (int i = 0; i < steps; ++i) {
+        if (i == 100)
+            simulation.Enqueue([&](World& edited) { spawned.push_back(edited.Create(TransformComponent(), RenderableComponent())); });
+        if (i == 150)
+            simulation.Enqueue([&](World& edited) { edited.Destroy(spawned.back()); });
+        if (i == 200)
+            simulation.Enqueue([](World& edited) {
+                edited.ForEach<TransformComponent>([](Entity, TransformComponent& transform) { transform.scale[0] = 2.0f; });
+            });
+        simulation.Step(world);
+    }
+
+    float alpha;
+    const SimulationSnapshot& snapshot = simulation.AcquireSnapshot(alpha);
+    CHECK(alpha == 1.0f);
+    CHECK(snapshot.tick == uint64_t(steps));
+    CHECK(snapshot.entities.size() == 3000);
+    CHECK(snapshot.previous.size() == 3000 && snapshot.current.size() == 3000);
+    CHECK(snapshot.renderables.size() == 3000 && snapshot.bounds.size() == 3000);
+    // 'previous' is one step behind 'current'
+    CHECK(std::fabs(snapshot.current[0].position[1] - snapshot.previous[0].position[1] - 1.0f / 60.0f) < 1e-4f);
+    return HashWorldState(world);
+}
+
+static void TestHeadlessDeterminism()
+{
+    const uint64_t first = RunHeadless(300);
+    CHECK(RunHeadless(300) == first);
+    CHECK(RunHeadless(299) != first);
+}
+
+static void TestInterpolation()
+{
+    TransformComponent from, to;
+    to.position[0] = 2.0f;
+    to.scale[1] = 3.0f;
+    // A turn of 1 radian about z, stored as the negated quaternion; halfway along
+    // the shorter arc is half a radian, not most of the way round
+    to.rotation[2] = -std::sin(0.5f);
+    to.rotation[3] = -std::cos(0.5f);
+    const TransformComponent half = InterpolateTransform(from, to, 0.5f);
+    CHECK(std::fabs(half.position[0] - 1.0f) < 1e-6f && std::fabs(half.scale[1] - 2.0f) < 1e-6f);
+    float length = 0.0f;
+    for (float component : half.rotation)
+        length += component * component;
+    CHECK(std::fabs(length - 1.0f) < 1e-5f);
+    CHECK(std::fabs(half.rotation[2] - std::sin(0.25f)) < 1e-3f && std::fabs(half.rotation[3] - std::cos(0.25f)) < 1e-3f);
+
+    const TransformComponent end = InterpolateTransform(from, to, 1.0f);
+    CHECK(end.position[0] == 2.0f && end.scale[1] == 3.0f);
+}
+
+// On its thread, with a step that stalls: frames keep getting snapshots, the
+// interpolated motion never runs backwards, and the stall is dropped, not replayed
+static void TestThreaded()
+{
+    World world;
+    Populate(world, 500);
+    Simulation simulation;
+    simulation.AddSystem(Move);
+    simulation.AddSystem([](World&, float) {
+        static int step = 0;
+        if (++step == 10)
+            std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    });
+    simulation.Start(world);
+
+    std::vector<TransformComponent> transforms;
+    float lastY = -1.0f;
+    uint64_t lastTick = 0;
+    const auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(600)) {
+        float alpha;
+        const SimulationSnapshot& snapshot = simulation.AcquireSnapshot(alpha);
+        CHECK(alpha >= 0.0f && alpha <= 1.0f);
+        CHECK(snapshot.tick >= lastTick);
+        lastTick = snapshot.tick;
+        InterpolateSnapshot(snapshot, alpha, transforms);
+        CHECK(transforms.size() == 500);
+        CHECK(transforms[0].position[1] >= lastY - 1e-5f);
+        lastY = transforms[0].position[1];
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    simulation.Stop();
+
+    float alpha;
+    const SimulationSnapshot& snapshot = simulation.AcquireSnapshot(alpha);
+    CHECK(snapshot.stats.droppedSteps > 0);
+    CHECK(snapshot.tick > 10);
+    CHECK(std::fabs(snapshot.current[0].position[1] - snapshot.tick / 60.0f) < 1e-2f);
+
+    // Stopped, it runs headless again, edits included
+    bool edited = false;
+    simulation.Enqueue([&](World&) { edited = true; });
+    simulation.Step(world);
+    CHECK(edited);
+}
+
+int main()
+{
+    RegisterCoreComponents();
+    TestHeadlessDeterminism();
+    TestInterpolation();
+    TestThreaded();
+    std::printf("SimulationTest passed\n");
+    return 0;
+}
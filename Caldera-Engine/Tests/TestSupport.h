@@ -0,0 +1,40 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Checks stay on in release builds. A failed one prints where and exits
+// non-zero, which is all ctest looks at.
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1); \
+        } \
+    } while (0)
+
+// ctest passes --quick so benchmarks finish in a moment; run them without it for real numbers.
+inline bool IsQuickRun(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--quick") == 0)
+            return true;
+    }
+    return false;
+}
+
+// Fastest of 'repeats' runs of fn, in milliseconds.
+template<typename Fn>
+double MeasureBestMs(int repeats, Fn&& fn)
+{
+    double best = 1e30;
+    for (int i = 0; i < repeats; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
@@ -0,0 +1,304 @@
+#include "TestSupport.h"
+#include "../Core/TaskPool.h"
+#include "../Scene/Components.h"
+#include "../Scene/SceneTransforms.h"
+#include "../Scene/TransformHierarchy.h"
+#include "../Scene/World.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+using NodeId = TransformHierarchy::NodeId;
+
+static TransformComponent RandomTransform(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> offset(-2.0f, 2.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    TransformComponent transform;
+    for (float& value : transform.position)
+        value = offset(rng);
+    float length = 0.0f;
+    for (float& value : transform.rotation) {
+        value = unit(rng);
+        length += value * value;
+    }
+    for (float& value : transform.rotation)
+        value /= std::sqrt(length);
+    for (float& value : transform.scale)
+        value = 0.5f + 0.5f * std::fabs(unit(rng));
+    return transform;
+}
+
+// The world matrix the slow way: up the parent chain, every time
+static void ReferenceWorld(const TransformHierarchy& hierarchy, NodeId node, float outRows[12])
+{
+    GetTransformMatrix(hierarchy.GetLocalTransform(node), outRows);
+    for (NodeId parent = hierarchy.GetParent(node); parent != TransformHierarchy::INVALID_NODE; parent = hierarchy.GetParent(parent)) {
+        float parentRows[12], child[12];
+        GetTransformMatrix(hierarchy.GetLocalTransform(parent), parentRows);
+        std::copy(outRows, outRows + 12, child);
+        MultiplyTransformMatrices(parentRows, child, outRows);
+    }
+}
+
+static bool NearlyEqual(const float a[12], const float b[12])
+{
+    for (int i = 0; i < 12; ++i) {
+        if (std::fabs(a[i] - b[i]) > 1e-4f * (1.0f + std::fabs(b[i])))
+            return false;
+    }
+    return true;
+}
+
+static void CheckAgainstReference(const TransformHierarchy& hierarchy, const std::vector<NodeId>& nodes)
+{
+    for (NodeId node : nodes) {
+        float expected[12];
+        ReferenceWorld(hierarchy, node, expected);
+        CHECK(NearlyEqual(hierarchy.GetWorldTransform(node).rows, expected));
+    }
+}
+
+// Every node's parent is an earlier node or none
+static std::vector<NodeId> BuildForest(TransformHierarchy& hierarchy, std::mt19937& rng, uint32_t count)
+{
+    std::vector<NodeId> nodes;
+    for (uint32_t i = 0; i < count; ++i) {
+        const NodeId parent = i == 0 || rng() % 8 == 0 ? TransformHierarchy::INVALID_NODE : nodes[rng() % i];
+        nodes.push_back(hierarchy.CreateNode(parent));
+        hierarchy.SetLocalTransform(nodes.back(), RandomTransform(rng));
+    }
+    return nodes;
+}
+
+static void CollectSubtree(const TransformHierarchy& hierarchy, const std::vector<NodeId>& nodes, NodeId root, std::vector<uint8_t>& inSubtree)
+{
+    for (NodeId node : nodes) {
+        for (NodeId ancestor = node; ancestor != TransformHierarchy::INVALID_NODE; ancestor = hierarchy.GetParent(ancestor)) {
+            if (ancestor == root) {
+                inSubtree[node] = 1;
+                break;
+            }
+        }
+    }
+}
+
+// Slots are breadth-first: levels are contiguous and every parent precedes its children
+static void TestBreadthFirstOrder()
+{
+    std::mt19937 rng(1);
+    TransformHierarchy hierarchy;
+    const std::vector<NodeId> nodes = BuildForest(hierarchy, rng, 500);
+    hierarchy.Update();
+    CHECK(hierarchy.GetStats().nodes == 500 && hierarchy.GetStats().updatedNodes == 500);
+
+    std::vector<uint32_t> levelOfSlot(nodes.size());
+    for (NodeId node : nodes) {
+        const NodeId parent = hierarchy.GetParent(node);
+        if (parent == TransformHierarchy::INVALID_NODE) {
+            CHECK(hierarchy.GetLevel(node) == 0);
+        } else {
+            CHECK(hierarchy.GetLevel(node) == hierarchy.GetLevel(parent) + 1);
+            CHECK(hierarchy.GetSlot(parent) < hierarchy.GetSlot(node));
+        }
+        levelOfSlot[hierarchy.GetSlot(node)] = hierarchy.GetLevel(node);
+    }
+    for (size_t slot = 1; slot < levelOfSlot.size(); ++slot)
+        CHECK(levelOfSlot[slot - 1] <= levelOfSlot[slot]);
+    CHECK(hierarchy.GetStats().levels == levelOfSlot.back() + 1);
+    CheckAgainstReference(hierarchy, nodes);
+}
+
+// Changing a node recomputes exactly it and its descendants
+static void TestDirtySubtree()
+{
+    std::mt19937 rng(2);
+    TransformHierarchy hierarchy;
+    const std::vector<NodeId> nodes = BuildForest(hierarchy, rng, 400);
+    hierarchy.Update();
+
+    for (int round = 0; round < 20; ++round) {
+        const NodeId changed = nodes[rng() % nodes.size()];
+        hierarchy.SetLocalTransform(changed, RandomTransform(rng));
+        hierarchy.Update();
+
+        std::vector<uint8_t> inSubtree(nodes.size(), 0);
+        CollectSubtree(hierarchy, nodes, changed, inSubtree);
+        uint32_t subtreeSize = 0;
+        for (NodeId node : nodes) {
+            CHECK(hierarchy.WasUpdated(node) == (inSubtree[node] != 0));
+            subtreeSize += inSubtree[node];
+        }
+        CHECK(hierarchy.GetStats().updatedNodes == subtreeSize);
+
+        // Reported parents first
+        uint32_t visited = 0;
+        std::vector<uint8_t> seen(nodes.size(), 0);
+        hierarchy.ForEachUpdated([&](NodeId node) {
+            const NodeId parent = hierarchy.GetParent(node);
+            CHECK(node == changed || seen[parent]);
+            seen[node] = 1;
+            ++visited;
+        });
+        CHECK(visited == subtreeSize);
+        CheckAgainstReference(hierarchy, nodes);
+    }
+}
+
+// Moving a subtree keeps its locals, rejects cycles, and a destroyed parent frees its children
+static void TestReparenting()
+{
+    TransformHierarchy hierarchy;
+    const NodeId a = hierarchy.CreateNode();
+    const NodeId b = hierarchy.CreateNode(a);
+    const NodeId c = hierarchy.CreateNode(b);
+    const NodeId d = hierarchy.CreateNode();
+    TransformComponent offset;
+    offset.position[0] = 1.0f;
+    for (NodeId node : { a, b, c, d })
+        hierarchy.SetLocalTransform(node, offset);
+    hierarchy.Update();
+    CHECK(hierarchy.GetWorldTransform(c).rows[3] == 3.0f);
+    CHECK(hierarchy.GetLevel(c) == 2);
+
+    // No node may become its own ancestor
+    CHECK(!hierarchy.SetParent(a, c));
+    CHECK(!hierarchy.SetParent(b, b));
+    CHECK(hierarchy.GetParent(a) == TransformHierarchy::INVALID_NODE);
+
+    // b and c move under d: one level deeper, one unit further along
+    CHECK(hierarchy.SetParent(b, d));
+    hierarchy.Update();
+    CHECK(hierarchy.GetLevel(b) == 1 && hierarchy.GetLevel(c) == 2);
+    CHECK(hierarchy.WasUpdated(b) && hierarchy.WasUpdated(c) && !hierarchy.WasUpdated(a));
+    CHECK(hierarchy.GetWorldTransform(c).rows[3] == 3.0f);
+    offset.position[0] = 5.0f;
+    hierarchy.SetLocalTransform(d, offset);
+    hierarchy.Update();
+    CHECK(hierarchy.GetWorldTransform(c).rows[3] == 7.0f);
+    CheckAgainstReference(hierarchy, { a, b, c, d });
+
+    // Destroying b makes c a root at its local position, and b's id is reused afterwards
+    hierarchy.DestroyNode(b);
+    hierarchy.Update();
+    CHECK(hierarchy.GetParent(c) == TransformHierarchy::INVALID_NODE && hierarchy.GetLevel(c) == 0);
+    CHECK(hierarchy.GetWorldTransform(c).rows[3] == 1.0f);
+    CHECK(hierarchy.GetStats().nodes == 3);
+    const NodeId e = hierarchy.CreateNode(c);
+    CHECK(e == b);
+    hierarchy.Update();
+    CHECK(hierarchy.GetLevel(e) == 1);
+}
+
+// A static scene does no work: no rebuild, no matrices, nothing reported
+static void TestStaticScene()
+{
+    std::mt19937 rng(3);
+    TransformHierarchy hierarchy;
+    const std::vector<NodeId> nodes = BuildForest(hierarchy, rng, 300);
+    hierarchy.Update();
+    const uint32_t rebuilds = hierarchy.GetStats().rebuilds;
+
+    for (int frame = 0; frame < 3; ++frame) {
+        hierarchy.Update();
+        CHECK(hierarchy.GetStats().updatedNodes == 0);
+        CHECK(hierarchy.GetStats().rebuilds == rebuilds);
+        uint32_t visited = 0;
+        hierarchy.ForEachUpdated([&](NodeId) { ++visited; });
+        CHECK(visited == 0);
+        for (NodeId node : nodes)
+            CHECK(!hierarchy.WasUpdated(node));
+    }
+}
+
+// Wide levels are split across the pool and come out as the serial update does
+static void TestParallelUpdate()
+{
+    TaskPool pool;
+    CHECK(pool.Initialize(3));
+    std::mt19937 serialRng(4), parallelRng(4);
+    TransformHierarchy serial, parallel;
+    // Wide enough that the first two levels go to the pool
+    const uint32_t count = TransformHierarchy::PARALLEL_MIN_NODES * 3;
+    std::vector<NodeId> serialNodes, parallelNodes;
+    for (uint32_t i = 0; i < count; ++i) {
+        const TransformComponent transform = RandomTransform(serialRng);
+        RandomTransform(parallelRng);
+        const bool root = i < count / 2;
+        serialNodes.push_back(serial.CreateNode(root ? TransformHierarchy::INVALID_NODE : serialNodes[i - count / 2]));
+        parallelNodes.push_back(parallel.CreateNode(root ? TransformHierarchy::INVALID_NODE : parallelNodes[i - count / 2]));
+        serial.SetLocalTransform(serialNodes.back(), transform);
+        parallel.SetLocalTransform(parallelNodes.back(), transform);
+    }
+    serial.Update();
+    parallel.Update(&pool);
+    CHECK(parallel.GetStats().updatedNodes == count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const float* a = serial.GetWorldTransform(serialNodes[i]).rows;
+        const float* b = parallel.GetWorldTransform(parallelNodes[i]).rows;
+        CHECK(std::equal(a, a + 12, b));
+    }
+    pool.Shutdown();
+}
+
+// Through the World: WorldTransformComponents follow Transforms and parents
+static void TestSceneTransforms()
+{
+    World world;
+    TransformComponent offset;
+    offset.position[1] = 2.0f;
+    const Entity parent = world.Create(offset);
+    const Entity child = world.Create(offset);
+    const Entity unrelated = world.Create(BoundsComponent{});
+
+    SceneTransforms transforms;
+    transforms.Sync(world);
+    CHECK(transforms.IsTracked(parent) && transforms.IsTracked(child) && !transforms.IsTracked(unrelated));
+    CHECK(world.Has<WorldTransformComponent>(child) && !world.Has<WorldTransformComponent>(unrelated));
+    CHECK(transforms.SetParent(child, parent));
+    CHECK(!transforms.SetParent(parent, child));
+    CHECK(!transforms.SetParent(child, unrelated));
+    transforms.Update(world);
+    CHECK(transforms.GetParent(child) == parent);
+    CHECK(world.Get<WorldTransformComponent>(child)->rows[7] == 4.0f);
+
+    // Nothing marked, nothing written: a poisoned value survives
+    world.Get<WorldTransformComponent>(child)->rows[7] = -1.0f;
+    transforms.Update(world);
+    CHECK(world.Get<WorldTransformComponent>(child)->rows[7] == -1.0f);
+
+    // A marked parent carries its child along
+    world.Get<TransformComponent>(parent)->position[1] = 10.0f;
+    transforms.MarkChanged(parent);
+    transforms.Update(world);
+    CHECK(world.Get<WorldTransformComponent>(parent)->rows[7] == 10.0f);
+    CHECK(world.Get<WorldTransformComponent>(child)->rows[7] == 12.0f);
+
+    // The parent is destroyed: after Sync the child is a root at its local position
+    world.Destroy(parent);
+    transforms.Sync(world);
+    CHECK(!transforms.IsTracked(parent));
+    CHECK(transforms.GetParent(child) == NULL_ENTITY);
+    transforms.Update(world);
+    CHECK(world.Get<WorldTransformComponent>(child)->rows[7] == 2.0f);
+
+    // A new entity in the old index is tracked as itself
+    const Entity reused = world.Create(offset);
+    CHECK(reused.index == parent.index);
+    transforms.Sync(world);
+    CHECK(transforms.IsTracked(reused) && transforms.GetParent(child) == NULL_ENTITY);
+    transforms.Update(world);
+    CHECK(world.Get<WorldTransformComponent>(reused)->rows[7] == 2.0f);
+}
+
+int main()
+{
+    TestBreadthFirstOrder();
+    TestDirtySubtree();
+    TestReparenting();
+    TestStaticScene();
+    TestParallelUpdate();
+    TestSceneTransforms();
+    std::printf("TransformHierarchyTest passed\n");
+    return 0;
+}
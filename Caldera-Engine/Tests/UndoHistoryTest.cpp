@@ -0,0 +1,187 @@
+#include "TestSupport.h"
+#include "../Scene/Components.h"
+#include "../Scene/UndoHistory.h"
+#include "../Scene/World.h"
+#include <cstring>
+#include <random>
+#include <vector>
+
+// The bytes of every transform and bounds, in iteration order
+static std::vector<uint8_t> Snapshot(World& world)
+{
+    std::vector<uint8_t> bytes;
+    world.ForEach<const TransformComponent, const BoundsComponent>([&](Entity, const TransformComponent& transform, const BoundsComponent& bounds) {
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(&transform);
+        bytes.insert(bytes.end(), data, data + sizeof(transform));
+        data = reinterpret_cast<const uint8_t*>(&bounds);
+        bytes.insert(bytes.end(), data, data + sizeof(bounds));
+    });
+    return bytes;
+}
+
+static std::vector<Entity> Populate(World& world, int count)
+{
+    std::vector<Entity> entities;
+    for (int i = 0; i < count; ++i) {
+        TransformComponent transform;
+        transform.position[0] = float(i);
+        entities.push_back(world.Create(transform, BoundsComponent()));
+    }
+    return entities;
+}
+
+// Random multi-entity edits, undone and redone all the way, then a new edit after an undo
+static void TestUndoRedo()
+{
+    World world;
+    const std::vector<Entity> entities = Populate(world, 20000);
+    UndoHistory history(1 << 20);
+    std::mt19937 rng(1);
+
+    std::vector<std::vector<uint8_t>> states = { Snapshot(world) };
+    for (int step = 0; step < 100; ++step) {
+        history.Begin("Edit");
+        const int edits = 1 + rng() % 20;
+        for (int k = 0; k < edits; ++k) {
+            const Entity entity = entities[rng() % entities.size()];
+            history.Record<TransformComponent>(world, entity);
+            history.Record<BoundsComponent>(world, entity);
+            world.Get<TransformComponent>(entity)->position[rng() % 3] += 1.0f;
+            if (rng() % 3 == 0)
+                world.Get<BoundsComponent>(entity)->extents[0] *= 2.0f;
+        }
+        history.Commit(world);
+        states.push_back(Snapshot(world));
+    }
+    CHECK(history.GetStats().steps == 100);
+
+    for (size_t i = states.size() - 1; i > 0; --i) {
+        CHECK(history.Undo(world));
+        CHECK(Snapshot(world) == states[i - 1]);
+    }
+    CHECK(!history.Undo(world));
+    for (size_t i = 1; i < states.size(); ++i) {
+        CHECK(history.Redo(world));
+        CHECK(Snapshot(world) == states[i]);
+    }
+    CHECK(!history.Redo(world));
+
+    // A new edit after undoing ends the redo branch
+    for (int i = 0; i < 30; ++i)
+        history.Undo(world);
+    history.Begin("Scale");
+    history.Record<TransformComponent>(world, entities[0]);
+    world.Get<TransformComponent>(entities[0])->scale[0] = 9.0f;
+    history.Commit(world);
+    CHECK(!history.CanRedo());
+    CHECK(history.GetStats().steps == 71);
+    CHECK(std::strcmp(history.GetUndoName(), "Scale") == 0);
+
+    // Nothing changed, nothing stored; cancelled edits are put back
+    const std::vector<uint8_t> before = Snapshot(world);
+    history.Begin("Nothing");
+    history.Record<TransformComponent>(world, entities[1]);
+    history.Commit(world);
+    CHECK(history.GetStats().steps == 71);
+    history.Begin("Cancelled");
+    history.Record<TransformComponent>(world, entities[2]);
+    world.Get<TransformComponent>(entities[2])->position[0] = -1.0f;
+    history.Cancel(world);
+    CHECK(Snapshot(world) == before);
+
+    // A destroyed entity's part of a step is skipped
+    history.Begin("Gone");
+    history.Record<TransformComponent>(world, entities[3]);
+    world.Get<TransformComponent>(entities[3])->position[0] = 77.0f;
+    history.Commit(world);
+    world.Destroy(entities[3]);
+    CHECK(history.Undo(world));
+    CHECK(history.Redo(world));
+}
+
+// The editor's inspector: every frame of a drag commits under the key the drag
+// got when it started, and the next drag gets a new one
+static void TestDragMerging()
+{
+    World world;
+    const std::vector<Entity> entities = Populate(world, 100);
+    UndoHistory history(1 << 20);
+    uint64_t mergeKey = 0;
+
+    auto drag = [&](Entity entity, int frames) {
+        ++mergeKey;
+        for (int frame = 0; frame < frames; ++frame) {
+            history.Begin("Move", mergeKey);
+            history.Record<TransformComponent>(world, entity);
+            world.Get<TransformComponent>(entity)->position[1] += 0.25f;
+            history.Commit(world);
+        }
+    };
+
+    const std::vector<uint8_t> start = Snapshot(world);
+    drag(entities[5], 60);
+    const std::vector<uint8_t> afterFirst = Snapshot(world);
+    drag(entities[5], 30);
+    const std::vector<uint8_t> afterSecond = Snapshot(world);
+    CHECK(history.GetStats().steps == 2);
+    CHECK(history.GetStats().merges == 59 + 29);
+
+    CHECK(history.Undo(world));
+    CHECK(Snapshot(world) == afterFirst);
+    CHECK(history.Undo(world));
+    CHECK(Snapshot(world) == start);
+    CHECK(history.Redo(world));
+    CHECK(history.Redo(world));
+    CHECK(Snapshot(world) == afterSecond);
+}
+
+// Memory is only taken by the first stored step, and never more than the capacity
+static void TestRing()
+{
+    World world;
+    const std::vector<Entity> entities = Populate(world, 2000);
+    UndoHistory history(4096);
+    CHECK(history.GetStats().bytesAllocated == 0);
+    history.Begin("Nothing");
+    history.Record<TransformComponent>(world, entities[0]);
+    history.Commit(world);
+    CHECK(history.GetStats().bytesAllocated == 0);
+
+    std::mt19937 rng(2);
+    for (int i = 0; i < 3000; ++i) {
+        history.Begin("Edit");
+        const Entity entity = entities[rng() % entities.size()];
+        history.Record<TransformComponent>(world, entity);
+        world.Get<TransformComponent>(entity)->position[2] += 1.0f;
+        history.Commit(world);
+        CHECK(history.GetStats().bytesUsed <= 4096);
+    }
+    const UndoHistory::Stats stats = history.GetStats();
+    CHECK(stats.bytesAllocated == 4096 && stats.stepsDropped > 0);
+
+    const std::vector<uint8_t> now = Snapshot(world);
+    for (uint32_t i = 0; i < stats.steps; ++i)
+        CHECK(history.Undo(world));
+    for (uint32_t i = 0; i < stats.steps; ++i)
+        CHECK(history.Redo(world));
+    CHECK(Snapshot(world) == now);
+
+    // Larger than the whole ring: nothing before it can be undone
+    history.Begin("Big");
+    for (int i = 0; i < 1000; ++i) {
+        history.Record<TransformComponent>(world, entities[i]);
+        world.Get<TransformComponent>(entities[i])->position[0] += 3.0f;
+    }
+    history.Commit(world);
+    CHECK(!history.CanUndo());
+}
+
+int main()
+{
+    RegisterCoreComponents();
+    TestUndoRedo();
+    TestDragMerging();
+    TestRing();
+    std::printf("UndoHistoryTest passed\n");
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include "TestSupport.h"
+#include "../Core/TaskPool.h"
+#include "../Scene/Components.h"
+#include "../Scene/World.h"
+
+// Creates N entities with Transform, Bounds and Renderable, then times a
+// Transform += Bounds update over all of them, serially and across the pool.
+int main(int argc, char** argv)
+{
+    const uint32_t count = IsQuickRun(argc, argv) ? 20000 : 1000000;
+    World world;
+    TaskPool pool;
+    pool.Initialize();
+
+    const double createMs = MeasureBestMs(1, [&] {
+        for (uint32_t i = 0; i < count; ++i) {
+            TransformComponent transform;
+            transform.position[0] = float(i);
+            world.Create(transform, BoundsComponent{}, RenderableComponent{});
+        }
+    });
+    CHECK(world.GetEntityCount() == count);
+
+    auto update = [](uint32_t n, const Entity*, TransformComponent* transforms, const BoundsComponent* bounds) {
+        for (uint32_t i = 0; i < n; ++i)
+            transforms[i].position[1] += bounds[i].extents[0];
+    };
+    const double serialMs = MeasureBestMs(5, [&] {
+        world.ForEachChunk<TransformComponent, const BoundsComponent>(update);
+    });
+    const double parallelMs = MeasureBestMs(5, [&] {
+        world.ParallelForEachChunk<TransformComponent, const BoundsComponent>(pool, update);
+    });
+
+    // Transforms are read and written, bounds only read
+    const double bytes = double(count) * (2 * sizeof(TransformComponent) + sizeof(BoundsComponent));
+    std::printf("%u entities, %u threads\n", count, pool.GetThreadCount());
+    std::printf("create:          %8.2f ms\n", createMs);
+    std::printf("serial update:   %8.2f ms  %6.1f GB/s\n", serialMs, bytes / serialMs / 1e6);
+    std::printf("parallel update: %8.2f ms  %6.1f GB/s\n", parallelMs, bytes / parallelMs / 1e6);
+    pool.Shutdown();
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "TestSupport.h"
+#include "../Core/JobSystem.h"
+#include "../Scene/Components.h"
+#include "../Scene/WorldPartition.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// An 8 x 8 grid whose cells share assets with their neighbours, so unloads and
+// reloads of the same asset keep following each other as the camera moves
+static PartitionLayout MakeLayout()
+{
+    PartitionLayout layout;
+    layout.cellSize = 64.0f;
+    for (int i = 0; i < 16; ++i)
+        layout.assets.push_back({ "asset" + std::to_string(i), 1024 * 1024 });
+    for (int z = 0; z < 8; ++z) {
+        for (int x = 0; x < 8; ++x) {
+            PartitionCell cell;
+            cell.x = x;
+            cell.z = z;
+            cell.sceneBytes = 256 * 1024;
+            cell.assets = { uint32_t(x / 2 + (z / 4) * 4), uint32_t(8 + (x + z) % 8) };
+            layout.cells.push_back(cell);
+        }
+    }
+    return layout;
+}
+
+// Streaming runs in Background jobs: off the main thread, one job at a time,
+// and in issue order, so an asset is never loaded twice or unloaded while not loaded
+static void TestStreaming()
+{
+    JobSystem jobs;
+    CHECK(jobs.Initialize());
+    CHECK(jobs.GetThreadCount() >= 2);
+
+    const std::thread::id mainThread = std::this_thread::get_id();
+    std::atomic<int> running{ 0 };
+    std::atomic<int> overlaps{ 0 };
+    std::atomic<int> onMainThread{ 0 };
+    std::atomic<int> misordered{ 0 };
+    std::vector<std::atomic<int>> assetLoaded(16);
+    auto enter = [&] {
+        if (running.fetch_add(1) != 0)
+            ++overlaps;
+        if (std::this_thread::get_id() == mainThread)
+            ++onMainThread;
+    };
+
+    StreamingCallbacks callbacks;
+    callbacks.loadCell = [&](const PartitionCell& cell, World& world) {
+        enter();
+        for (int i = 0; i < 100; ++i) {
+            TransformComponent transform;
+            transform.position[0] = (cell.x + 0.5f) * 64.0f;
+            transform.position[2] = (cell.z + 0.5f) * 64.0f;
+            world.Create(transform);
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        --running;
+        return true;
+    };
+    callbacks.loadAsset = [&](const PartitionAsset& asset) {
+        enter();
+        if (assetLoaded[std::stoi(asset.path.substr(5))].exchange(1) != 0)
+            ++misordered;
+        --running;
+        return true;
+    };
+    callbacks.unloadAsset = [&](const PartitionAsset& asset) {
+        enter();
+        if (assetLoaded[std::stoi(asset.path.substr(5))].exchange(0) != 1)
+            ++misordered;
+        --running;
+    };
+
+    StreamingSettings settings;
+    settings.loadRadius = 64.0f;
+    settings.unloadRadius = 96.0f;
+    settings.maxLoadsInFlight = 3;
+    WorldPartition partition;
+    CHECK(partition.Initialize(MakeLayout(), settings, jobs, callbacks));
+
+    // Back and forth across the grid, without waiting for loads to finish
+    for (int frame = 0; frame < 600; ++frame) {
+        const float t = float(frame % 200) / 200.0f;
+        const float camera[3] = { 512.0f * t, 0.0f, 256.0f + 200.0f * (t - 0.5f) };
+        partition.Update(camera);
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    partition.Flush();
+    const StreamingStats stats = partition.GetStats();
+    CHECK(stats.loadsIssued > 20 && stats.unloadsIssued > 10);
+    CHECK(stats.failedCells == 0);
+
+    uint32_t loadedCells = 0;
+    for (uint32_t cell = 0; cell < partition.GetCellCount(); ++cell) {
+        if (partition.GetCellState(cell) == CellState::Loaded) {
+            CHECK(partition.GetCellWorld(cell)->GetEntityCount() == 100);
+            ++loadedCells;
+        }
+    }
+    CHECK(loadedCells == stats.loadedCells && loadedCells > 0);
+
+    partition.Shutdown();
+    CHECK(!partition.IsInitialized());
+    for (std::atomic<int>& loaded : assetLoaded)
+        CHECK(loaded == 0);
+    CHECK(overlaps == 0 && onMainThread == 0 && misordered == 0);
+
+    const JobSystemStats jobStats = jobs.GetStats();
+    CHECK(jobStats.jobsRun[static_cast<size_t>(JobPriority::Background)] > 0);
+    jobs.Shutdown();
+}
+
+int main()
+{
+    RegisterCoreComponents();
+    TestStreaming();
+    std::printf("WorldPartitionTest passed\n");
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "TestSupport.h"
+#include "../Core/TaskPool.h"
+#include "../Scene/CommandBuffer.h"
+#include "../Scene/Components.h"
+#include "../Scene/World.h"
+#include <vector>
+
+struct TagComponent {
+    static constexpr const char* COMPONENT_NAME = "Test.Tag";
+    int value = 7;
+};
+
+static void TestComponents()
+{
+    World world;
+    Entity a = world.Create(TransformComponent{}, BoundsComponent{});
+    Entity b = world.Create();
+    CHECK(world.Has<TransformComponent>(a) && world.Has<BoundsComponent>(a));
+    CHECK(!world.Has<RenderableComponent>(a));
+
+    // Adding and removing moves the entity between archetypes and keeps the rest
+    world.Add<TagComponent>(a, TagComponent{ 3 });
+    world.Get<TransformComponent>(a)->position[0] = 5.0f;
+    world.Remove<BoundsComponent>(a);
+    CHECK(world.Get<TransformComponent>(a)->position[0] == 5.0f);
+    CHECK(!world.Has<BoundsComponent>(a));
+    CHECK(world.Get<TagComponent>(a)->value == 3);
+
+    // A reused index gets a new generation, so the old handle stays dead
+    world.Destroy(a);
+    CHECK(!world.IsAlive(a));
+    Entity c = world.Create();
+    CHECK(c.index == a.index && c.generation != a.generation);
+    CHECK(!world.IsAlive(a) && world.Get<TagComponent>(a) == nullptr);
+    world.Destroy(b);
+    world.Destroy(c);
+    CHECK(world.GetEntityCount() == 0);
+}
+
+static void TestDenseRemoval()
+{
+    World world;
+    std::vector<Entity> entities;
+    for (int i = 0; i < 1000; ++i) {
+        TransformComponent transform;
+        transform.position[0] = float(i);
+        entities.push_back(world.Create(transform));
+    }
+    for (int i = 0; i < 1000; i += 3)
+        world.Destroy(entities[i]);
+
+    for (int i = 0; i < 1000; ++i) {
+        if (i % 3)
+            CHECK(world.Get<TransformComponent>(entities[i])->position[0] == float(i));
+    }
+    int visited = 0;
+    world.ForEach<const TransformComponent>([&](Entity entity, const TransformComponent& transform) {
+        ++visited;
+        CHECK(world.Get<TransformComponent>(entity) == &transform);
+    });
+    CHECK(visited == 666);
+}
+
+static void TestCommandBuffer()
+{
+    World world;
+    for (int i = 0; i < 100; ++i) {
+        TransformComponent transform;
+        transform.position[0] = float(i);
+        world.Create(transform);
+    }
+
+    // Structural changes recorded during a query apply afterwards, in order
+    EntityCommandBuffer commands;
+    world.ForEach<TransformComponent>([&](Entity entity, TransformComponent& transform) {
+        if (int(transform.position[0]) % 2)
+            commands.Destroy(entity);
+        else
+            commands.Add<TagComponent>(entity);
+    });
+    commands.Create(TransformComponent{}, TagComponent{ 9 });
+    commands.Playback(world);
+    CHECK(commands.IsEmpty());
+
+    int tags = 0, nines = 0;
+    world.ForEach<TagComponent>([&](Entity, TagComponent& tag) {
+        ++tags;
+        nines += tag.value == 9;
+    });
+    CHECK(tags == 51 && nines == 1);
+    CHECK(world.GetEntityCount() == 51);
+    world.Clear();
+    CHECK(world.GetEntityCount() == 0);
+}
+
+static void TestParallelQuery()
+{
+    World world;
+    TaskPool pool;
+    pool.Initialize();
+    const uint32_t count = 100000;
+    for (uint32_t i = 0; i < count; ++i) {
+        TransformComponent transform;
+        transform.position[0] = float(i);
+        world.Create(transform, BoundsComponent{}, RenderableComponent{});
+    }
+
+    world.ParallelForEachChunk<TransformComponent, const BoundsComponent>(pool,
+        [](uint32_t n, const Entity*, TransformComponent* transforms, const BoundsComponent* bounds) {
+            for (uint32_t i = 0; i < n; ++i)
+                transforms[i].position[1] += bounds[i].extents[0];
+        });
+    uint32_t updated = 0;
+    world.ForEach<const TransformComponent>([&](Entity, const TransformComponent& transform) {
+        updated += transform.position[1] == 0.5f;
+    });
+    CHECK(updated == count);
+
+    // A command buffer can be shared by the chunks of a parallel query
+    EntityCommandBuffer commands;
+    world.ParallelForEachChunk<const TransformComponent>(pool,
+        [&](uint32_t n, const Entity* entities, const TransformComponent* transforms) {
+            for (uint32_t i = 0; i < n; ++i) {
+                if (int(transforms[i].position[0]) % 1000 == 0)
+                    commands.Destroy(entities[i]);
+            }
+        });
+    commands.Playback(world);
+    CHECK(world.GetEntityCount() == count - count / 1000);
+    pool.Shutdown();
+}
+
+int main()
+{
+    TestComponents();
+    TestDenseRemoval();
+    TestCommandBuffer();
+    TestParallelQuery();
+    std::printf("WorldTest passed\n");
+    return 0;
+}